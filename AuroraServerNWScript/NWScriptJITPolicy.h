@@ -118,6 +118,38 @@ public:
 	GetOptimizeActionServiceHandlers(
 		) = 0;
 
+	//
+	// Return the memory budget, in bytes, for scripts held in the script
+	// cache, else zero if the script cache is unbounded.
+	//
+
+	virtual
+	size_t
+	GetScriptCacheBudget(
+		) = 0;
+
+	//
+	// Return the number of times that a script is run in the reference VM
+	// before native code is generated for it in the background, else zero if
+	// native code should be generated before the script is first run.
+	//
+
+	virtual
+	ULONG
+	GetTierUpThreshold(
+		) = 0;
+
+	//
+	// Return whether generated code is kept in an on-disk code cache under
+	// the code generation output directory, so that scripts that have not
+	// changed since an earlier run can be loaded without generating code.
+	//
+
+	virtual
+	bool
+	GetUseCodeCache(
+		) = 0;
+
 };
 
 #endif
@@ -63,6 +63,7 @@ Environment:
 	NWN::OBJECTID            ObjectSelf;
 	int                      OldSP;
 	int                      NewSP;
+	int                      SavedStateId;
 
 #if !NWSCRIPTVM_FALLBACK
 	if (m_CurrentJITProgram.get( ) == NULL)
@@ -93,6 +94,8 @@ Environment:
 			&SaveGlobalCount,
 			&SaveLocalCount,
 			&ObjectSelf);
+
+		SavedStateId = (int) SAVED_STATE_ID;
 	}
 #if NWSCRIPTVM_FALLBACK
 	else
@@ -102,6 +105,7 @@ Environment:
 		//
 
 		NWScriptVM::VMState & SavedState( m_VM->GetSavedState( ) );
+		NWScriptStack       & SavedStack( SavedState.GetStack( ) );
 
 		//
 		// Now push it on the stack.
@@ -109,16 +113,17 @@ Environment:
 
 		OldSP = ServerVM->GetCurrentSP( );
 
-		SavedState.Stack.SaveStack(
+		SavedStack.SaveStack(
 			m_Bridge,
-			SavedState.Stack.GetCurrentBP( ),
-			SavedState.Stack.GetCurrentSP( ) - SavedState.Stack.GetCurrentBP( ));
+			SavedStack.GetCurrentBP( ),
+			SavedStack.GetCurrentSP( ) - SavedStack.GetCurrentBP( ));
 
 		ResumeMethodId  = 0;
 		ResumeMethodPC  = SavedState.ProgramCounter;
-		SaveGlobalCount = (ULONG) SavedState.Stack.GetCurrentBP( ) / SavedState.Stack.GetStackIntegerSize( );
-		SaveLocalCount  = (ULONG) (SavedState.Stack.GetCurrentSP( ) - SavedState.Stack.GetCurrentBP( )) / SavedState.Stack.GetStackIntegerSize( );
+		SaveGlobalCount = (ULONG) SavedStack.GetCurrentBP( ) / SavedStack.GetStackIntegerSize( );
+		SaveLocalCount  = (ULONG) (SavedStack.GetCurrentSP( ) - SavedStack.GetCurrentBP( )) / SavedStack.GetStackIntegerSize( );
 		ObjectSelf      = SavedState.ObjectSelf;
+		SavedStateId    = (int) SAVED_STATE_ID_VM;
 	}
 #endif
 
@@ -139,7 +144,7 @@ Environment:
 	m_Bridge->StackPushObjectId( ObjectSelf );
 	m_Bridge->StackPushInt( (int) m_CurrentScriptCodeSize );
 	m_Bridge->StackPushString( ServerVM->GetScriptName( ) );
-	m_Bridge->StackPushInt( (int) SAVED_STATE_ID );
+	m_Bridge->StackPushInt( SavedStateId );
 
 	NewSP = ServerVM->GetCurrentSP( );
 
@@ -190,9 +195,23 @@ Environment:
 	NWN::ResRef32                      PrevScriptName;
 	size_t                             PrevScriptCodeSize;
 	bool                               TraceCall;
+	bool                               UseJIT;
 	ULONG                              Time;
+	ULONGLONG                          StartTime;
+	ULONGLONG                          ExecuteTime;
 
 	TraceCall = (m_Bridge->IsDebugLevel( NWScriptVM::EDL_Calls ) );
+	StartTime = ReadPerformanceCounterMicroseconds( );
+
+	//
+	// Install native code for any scripts that finished background code
+	// generation since the last script was run.  Doing so only at invocation
+	// boundaries ensures that a script switches engines between runs, never
+	// during one; instances of a script that are already executing in the
+	// reference VM continue to run there.
+	//
+
+	CompleteTierUps( );
 
 	//
 	// If we were executing a script situation, instantiate a script situation
@@ -220,8 +239,20 @@ Environment:
 
 		ScriptData->ScriptSituationCount += 1;
 
+		//
+		// The engine is chosen by the saved state, which may have been saved
+		// by the reference VM before the script moved to the JIT engine.
+		//
+
+		UseJIT = (ResumeData.ScriptSituationJIT.get( ) != NULL);
+
 		PrevProgram             = m_CurrentJITProgram;
-		m_CurrentJITProgram     = ScriptData->JITProgram;
+
+		if (UseJIT)
+			m_CurrentJITProgram = ScriptData->JITProgram;
+		else
+			m_CurrentJITProgram = NULL;
+
 		PrevScriptName          = m_CurrentScriptName;
 		m_CurrentScriptName     = ResRef32FromStr( ScriptName );
 		PrevScriptCodeSize      = m_CurrentScriptCodeSize;
@@ -240,10 +271,11 @@ Environment:
 					EffectivePC);
 			}
 
-			Time = ReadPerformanceCounterMilliseconds( );
+			Time        = ReadPerformanceCounterMilliseconds( );
+			ExecuteTime = ReadPerformanceCounterMicroseconds( );
 
 #if NWSCRIPTVM_FALLBACK
-			if (ScriptData->JITProgram.get( ) != NULL)
+			if (UseJIT)
 #endif
 			{
 				ScriptData->JITProgram->ExecuteScriptSituation(
@@ -326,6 +358,24 @@ Environment:
 
 		ScriptData->CallCount += 1;
 
+		//
+		// If the script has now run often enough in the reference VM, queue
+		// it for native code generation in the background.  This run, and any
+		// others until code generation finishes, still use the reference VM.
+		//
+
+		if ((ScriptData->TierUpPending) &&
+		    (ScriptData->CallCount >= m_JITPolicy->GetTierUpThreshold( )))
+		{
+			QueueTierUp(
+				ScriptName,
+				*ScriptData,
+				InstructionStream,
+				CodeSize);
+		}
+
+		UseJIT = (ScriptData->JITProgram.get( ) != NULL);
+
 		PrevProgram             = m_CurrentJITProgram;
 		m_CurrentJITProgram     = ScriptData->JITProgram;
 		PrevScriptName          = m_CurrentScriptName;
@@ -348,10 +398,11 @@ Environment:
 					(unsigned long) Params.size( ));
 			}
 
-			Time = ReadPerformanceCounterMilliseconds( );
+			Time        = ReadPerformanceCounterMilliseconds( );
+			ExecuteTime = ReadPerformanceCounterMicroseconds( );
 
 #if NWSCRIPTVM_FALLBACK
-			if (ScriptData->JITProgram.get( ) != NULL)
+			if (UseJIT)
 #endif
 			{
 				ReturnCode = ScriptData->JITProgram->ExecuteScript(
@@ -413,7 +464,7 @@ Environment:
 			// problem with the script on the first run.  Track this now.
 			//
 
-			if ((ScriptData->FirstRun) && (ScriptData->JITProgram.get( ) == NULL))
+			if ((ScriptData->FirstRun) && (!UseJIT))
 				ScriptData->BrokenScript = true;
 
 			throw;
@@ -422,9 +473,35 @@ Environment:
 		ServerVM->SetScriptReturnCode( ReturnCode );
 	}
 
+	//
+	// Account for the run.  The first run of a script is charged from the
+	// start of the call, so that it includes the time taken to load the
+	// script (and to generate native code for it, if that was not deferred).
+	//
+
 	if (ScriptData->FirstRun == true)
+	{
 		ScriptData->FirstRun = false;
 
+		m_EngineStatistics.FirstRuns    += 1;
+		m_EngineStatistics.FirstRunTime += ReadPerformanceCounterMicroseconds( ) - StartTime;
+	}
+	else
+	{
+		ExecuteTime = ReadPerformanceCounterMicroseconds( ) - ExecuteTime;
+
+		if (UseJIT)
+		{
+			m_EngineStatistics.JITCalls   += 1;
+			m_EngineStatistics.JITRuntime += ExecuteTime;
+		}
+		else
+		{
+			m_EngineStatistics.VMCalls   += 1;
+			m_EngineStatistics.VMRuntime += ExecuteTime;
+		}
+	}
+
 	ServerVM->MarkCleanScriptReturn( );
 
 	m_CurrentScriptCodeSize = PrevScriptCodeSize;
@@ -469,6 +546,7 @@ Environment:
 		FILETIME KernelTime;
 		FILETIME UserTime;
 		ULONG    TotalMemoryCost;
+		size_t   Budget;
 
 		m_TextOut->WriteText(
 			"NWScriptRuntime::DumpStatistics: %lu scripts cached:\n",
@@ -496,7 +574,7 @@ Environment:
 			m_TextOut->WriteText(
 				"%s - %s (%lu calls, %lu script situations, %lu bytes VA space usage, %lums runtime).\n",
 				StrFromResRef( it->first ).c_str( ),
-				it->second.JITProgram.get( ) != NULL ? "(JIT)" : "(VM)",
+				it->second.JITProgram.get( ) != NULL ? "(JIT)" : it->second.TierUpQueued ? "(VM, generating code)" : "(VM)",
 				(unsigned long) it->second.CallCount,
 				(unsigned long) it->second.ScriptSituationCount,
 				(unsigned long) it->second.MemoryCost,
@@ -518,6 +596,61 @@ Environment:
 			ThreadTimeMs,
 			((double) m_TotalScriptRuntime / (double) ThreadTimeMs) * 100.0,
 			TotalMemoryCost);
+
+		Budget = m_JITPolicy->GetScriptCacheBudget( );
+
+		m_TextOut->WriteText(
+			"Script cache holds %lu bytes of scripts (budget %lu bytes%s).\n"
+			"Script cache lookups: %I64lu (%g%% hit rate).\n"
+			"Script cache evictions: %I64lu, invalidations of changed scripts: %I64lu, recompiles: %I64lu.\n",
+			(unsigned long) m_ScriptCacheBytes,
+			(unsigned long) Budget,
+			Budget == 0 ? ", unbounded" : "",
+			m_CacheStatistics.Lookups,
+			m_CacheStatistics.Lookups != 0
+				? ((double) m_CacheStatistics.Hits / (double) m_CacheStatistics.Lookups) * 100.0
+				: 0.0,
+			m_CacheStatistics.Evictions,
+			m_CacheStatistics.Invalidations,
+			m_CacheStatistics.Recompiles);
+
+		m_TextOut->WriteText(
+			"Scripts run in the VM before background code generation: %lu times%s.\n"
+			"First runs: %I64lu (average latency %I64luus, including load time).\n"
+			"Steady state VM runs: %I64lu (%I64luus, %g runs/s).\n"
+			"Steady state JIT runs: %I64lu (%I64luus, %g runs/s).\n"
+			"Scripts moved from the VM to the JIT: %I64lu (%I64lu failed, %I64lums code generation time, %lu pending).\n",
+			m_JITPolicy->GetTierUpThreshold( ),
+			m_JITPolicy->GetTierUpThreshold( ) == 0 ? " (disabled)" : "",
+			m_EngineStatistics.FirstRuns,
+			m_EngineStatistics.FirstRuns != 0
+				? m_EngineStatistics.FirstRunTime / m_EngineStatistics.FirstRuns
+				: 0,
+			m_EngineStatistics.VMCalls,
+			m_EngineStatistics.VMRuntime,
+			m_EngineStatistics.VMRuntime != 0
+				? ((double) m_EngineStatistics.VMCalls * 1000000.0) / (double) m_EngineStatistics.VMRuntime
+				: 0.0,
+			m_EngineStatistics.JITCalls,
+			m_EngineStatistics.JITRuntime,
+			m_EngineStatistics.JITRuntime != 0
+				? ((double) m_EngineStatistics.JITCalls * 1000000.0) / (double) m_EngineStatistics.JITRuntime
+				: 0.0,
+			m_EngineStatistics.TierUps,
+			m_EngineStatistics.TierUpFailures,
+			m_EngineStatistics.TierUpGenerateTime,
+			(unsigned long) m_TierUpJobsOutstanding);
+
+		m_TextOut->WriteText(
+			"Scripts given native code on load: %I64lu (%I64lums code generation time, average %I64lums, code cache %s).\n",
+			m_EngineStatistics.LoadGenerations,
+			m_EngineStatistics.LoadGenerateTime,
+			m_EngineStatistics.LoadGenerations != 0
+				? m_EngineStatistics.LoadGenerateTime / m_EngineStatistics.LoadGenerations
+				: 0,
+			((m_JITPolicy->GetUseCodeCache( )) && (m_JITPolicy->GetCodeGenOutputDir( ) != NULL))
+				? "enabled"
+				: "disabled");
 	}
 	catch (std::exception)
 	{
@@ -535,6 +668,9 @@ Routine Description:
 	for any scripts that were JIT'd.  Note that scripts may still have pending
 	script situations outstanding.
 
+	Scripts that are currently executing (i.e. that called the routine) are
+	retained, as their cache entries are still in use.
+
 Arguments:
 
 	None.
@@ -549,7 +685,19 @@ Environment:
 
 --*/
 {
-	m_ScriptCache.clear( );
+	ScriptCacheMap::iterator it;
+
+	for (it = m_ScriptCache.begin( ); it != m_ScriptCache.end( ); )
+	{
+		ScriptCacheMap::iterator Next = it;
+
+		++Next;
+
+		if (it->second.RecursionLevel == 0)
+			EvictScript( it );
+
+		it = Next;
+	}
 }
 
 void
@@ -745,6 +893,7 @@ Environment:
 	ULONG                        SaveLocalCount;
 	NWN::OBJECTID                ObjectSelf;
 	size_t                       SavedCodeSize;
+	int                          SavedStateId;
 
 	UNREFERENCED_PARAMETER( ServerVM );
 
@@ -752,8 +901,13 @@ Environment:
 	// Check that the saved state is valid.
 	//
 
-	if (m_Bridge->StackPopInt( ) != (int) SAVED_STATE_ID)
+	SavedStateId = m_Bridge->StackPopInt( );
+
+	if ((SavedStateId != (int) SAVED_STATE_ID) &&
+	    (SavedStateId != (int) SAVED_STATE_ID_VM))
+	{
 		throw std::runtime_error( "Saved state signature does not match." );
+	}
 
 	ScriptName = m_Bridge->StackPopString( );
 
@@ -803,7 +957,35 @@ Environment:
 	PC = ResumeMethodPC;
 
 #if NWSCRIPTVM_FALLBACK
-	if ((*ScriptData)->JITProgram.get( ) != NULL)
+	//
+	// A state saved by the JIT engine can only be resumed with native code.
+	// If the script was reloaded into the reference VM since the state was
+	// saved (e.g. because it was evicted from the script cache), generate the
+	// native code for it now rather than waiting for the tier up threshold.
+	//
+
+	if ((SavedStateId == (int) SAVED_STATE_ID) &&
+	    ((*ScriptData)->JITProgram.get( ) == NULL) &&
+	    ((*ScriptData)->TierUpPending || (*ScriptData)->TierUpQueued))
+	{
+		TierUpScriptNow(
+			ResRef32FromStr( ScriptName ),
+			**ScriptData,
+			InstructionStream,
+			CodeSize);
+	}
+
+	if (SavedStateId == (int) SAVED_STATE_ID)
+	{
+		if ((*ScriptData)->JITProgram.get( ) == NULL)
+			throw std::runtime_error( "Native code is not available to resume script situation." );
+	}
+	else if ((*ScriptData)->Reader.get( ) == NULL)
+	{
+		throw std::runtime_error( "Script situation was saved by the reference VM, but the script is not loaded for the reference VM." );
+	}
+
+	if (SavedStateId == (int) SAVED_STATE_ID)
 #endif
 	{
 		ResumeData->ScriptSituationJIT = (*ScriptData)->JITProgram->PopSavedStatePtr(
@@ -862,7 +1044,9 @@ Routine Description:
 	script instruction stream.
 
 	If the script already existed in the cache, the cached entry is returned.
-	Otherwise, the script is compiled to native code on the fly and returned.
+	Otherwise, the script is compiled to native code on the fly and returned,
+	unless the JIT policy calls for the script to first run a number of times
+	in the reference VM.
 
 Arguments:
 
@@ -893,6 +1077,7 @@ Environment:
 	NWSCRIPT_JIT_PARAMS      CodeGenParams;
 	ULONG                    StartTick;
 	ULONGLONG                StartVASpace;
+	ULONGLONG                CodeHash;
 
 	//
 	// Convert the name to a canonical resref and search for it in our cache.
@@ -906,13 +1091,65 @@ Environment:
 
 	it = m_ScriptCache.find( ResRef );
 
+	m_CacheStatistics.Lookups += 1;
+
+	//
+	// The server does not signal when it reloads a script resource, and a
+	// changed NCS of the same size may well be read back into the same heap
+	// block as the old one.  Neither the instruction buffer address nor its
+	// size thus shows whether the script is unchanged, so the content hash of
+	// the instruction stream is computed on every lookup.  (The hash consumes
+	// the stream a word at a time, which is cheap next to running the script.)
+	//
+
+	CodeHash = HashInstructionStream( InstructionStream, CodeSize );
+
 	if (it != m_ScriptCache.end( ))
 	{
-		if (it->second.BrokenScript)
-			return false;
+		ScriptCacheData & Entry = it->second;
 
-		*ScriptData = &it->second;
-		return true;
+		//
+		// If the script has changed since it was loaded, e.g. because the NCS
+		// was updated on disk and reloaded by the server, discard the cached
+		// script and load it afresh.  A script that is currently executing
+		// cannot be discarded, so its old code continues to be used until it
+		// is next invoked while idle.
+		//
+
+		if ((Entry.CodeSize != CodeSize) || (Entry.CodeHash != CodeHash))
+		{
+			if (Entry.RecursionLevel == 0)
+			{
+				m_Bridge->GetTextOut( )->WriteText(
+					"NWScriptRuntime::LoadScript: Script '%s' has changed (%lu bytes compiled script), reloading.\n",
+					StrFromResRef( ResRef ).c_str( ),
+					(unsigned long) CodeSize);
+
+				EvictScript( it );
+
+				m_CacheStatistics.Invalidations += 1;
+				m_CacheStatistics.Recompiles    += 1;
+
+				it = m_ScriptCache.end( );
+			}
+		}
+
+		if (it != m_ScriptCache.end( ))
+		{
+			m_CacheStatistics.Hits += 1;
+
+			Entry.ClockCredit = Entry.ClockWeight;
+
+			if (Entry.BrokenScript)
+				return false;
+
+			*ScriptData = &Entry;
+			return true;
+		}
+	}
+	else if (m_EvictedScripts.erase( ResRef ) != 0)
+	{
+		m_CacheStatistics.Recompiles += 1;
 	}
 
 	//
@@ -926,11 +1163,19 @@ Environment:
 
 	Data.BrokenScript         = false;
 	Data.FirstRun             = true;
+	Data.TierUpPending        = false;
+	Data.TierUpQueued         = false;
 	Data.CallCount            = 0;
 	Data.ScriptSituationCount = 0;
 	Data.MemoryCost           = 0;
 	Data.Runtime              = 0;
 	Data.RecursionLevel       = 0;
+	Data.GenerateTime         = 0;
+	Data.CodeSize             = CodeSize;
+	Data.CodeHash             = CodeHash;
+	Data.CacheCost            = 0;
+	Data.ClockWeight          = 0;
+	Data.ClockCredit          = 0;
 
 	//
 	// Construct a NWScriptReader for the in-memory instruction stream and hand
@@ -945,46 +1190,32 @@ Environment:
 	StartVASpace = GetAvailableVASpace( );
 	StartTick    = ReadPerformanceCounterMilliseconds( );
 
-	Script = new NWScriptReader(
-		ScriptNameStr.c_str( ),
-		InstructionStream,
-		CodeSize,
-		NULL,
-		0);
+	Script = CreateScriptReader( ScriptNameStr, InstructionStream, CodeSize );
 
 	//
-	// The CVirtualMachine may have already patched #loader for the return
-	// value workaround.  Check for this now and inform the VM of it so that it
-	// can compensate if we do run the script in the VM and not the JIT engine.
+	// If the policy calls for scripts to run in the VM for a while before
+	// they are JIT'd, start the script out in the VM.  Native code will be
+	// generated in the background once the script has run often enough.
 	//
 
-	if (CodeSize >= 2)
+	if ((ShouldJITScript( CodeSize )) &&
+	    (m_JITPolicy->GetTierUpThreshold( ) != 0))
 	{
-		UCHAR Opcode;
-		UCHAR TypeOpcode;
-
-		Script->SetInstructionPointer( 0 );
-		Script->ReadInstruction( Opcode, TypeOpcode );
-		Script->SetInstructionPointer( 0 );
-
-		if (Opcode == OP_NOP)
-			Script->SetPatchState( NWScriptReader::NCSPatchState_PatchReturnValue );
-	}
+		Data.Reader        = Script;
+		Data.JITProgram    = NULL;
+		Data.TierUpPending = true;
+		Data.GenerateTime  = ReadPerformanceCounterMilliseconds( ) - StartTick;
 
-	LoadSymbols( *Script, ScriptNameStr );
+		*ScriptData = InsertScript( ResRef, Data );
 
-	ZeroMemory( &CodeGenParams, sizeof( CodeGenParams ) );
-
-	CodeGenParams.Size             = sizeof( CodeGenParams );
-	CodeGenParams.CodeGenFlags     = NWCGF_ENABLE_SAVESTATE_TO_VMSTACK |
-	                                 NWCGF_ASSUME_LOADER_PATCHED;
-	CodeGenParams.CodeGenOutputDir = m_JITPolicy->GetCodeGenOutputDir( );
-
-	if (CodeGenParams.CodeGenOutputDir != NULL)
-		CodeGenParams.CodeGenFlags |= NWCGF_SAVE_OUTPUT;
+		m_Bridge->GetTextOut( )->WriteText(
+			"Using NWScript VM for script '%s' (%lu bytes compiled script) until it has run %lu times.\n",
+			ScriptNameStr.c_str( ),
+			(unsigned long) CodeSize,
+			m_JITPolicy->GetTierUpThreshold( ));
 
-	if (m_JITPolicy->GetOptimizeActionServiceHandlers( ))
-		CodeGenParams.CodeGenFlags |= NWCGF_NWN_COMPATIBLE_ACTIONS;
+		return true;
+	}
 
 	try
 	{
@@ -992,43 +1223,41 @@ Environment:
 		if (ShouldJITScript( CodeSize ))
 #endif
 		{
-			ULONG AnalysisFlags = 0;
+			ULONG AnalysisFlags;
+
+			PrepareCodeGenParams( CodeGenParams, AnalysisFlags );
 
-			if (!m_JITPolicy->GetEnableIROptimizations( ))
-				AnalysisFlags |= NWScriptAnalyzer::AF_NO_OPTIMIZATIONS;
+			EnterCriticalSection( &m_CodeGenLock );
 
-			if (m_JITManagedSupport.get( ) != NULL)
+			try
 			{
-				CodeGenParams.CodeGenFlags   |= NWCGF_MANAGED_SCRIPT_SUPPORT;
-				CodeGenParams.ManagedSupport  = m_JITManagedSupport->GetManagedSupport( );
+				Data.JITProgram = m_JITEngine->GenerateCodePtr(
+					Script.get( ),
+					NWActions_NWN2,
+					MAX_ACTION_ID_NWN2,
+					AnalysisFlags,
+					m_TextOut,
+					(ULONG) m_Bridge->GetScriptDebug( ),
+					m_Bridge,
+					NWN::INVALIDOBJID,
+					&CodeGenParams);
+			}
+			catch (std::exception)
+			{
+				LeaveCriticalSection( &m_CodeGenLock );
+				throw;
 			}
 
-			if (m_JITPolicy->GetDisableExecutionGuards( ))
-				CodeGenParams.CodeGenFlags |= NWCGF_DISABLE_EXECUTION_GUARDS;
-
-			CodeGenParams.MaxLoopIterations = m_JITPolicy->GetMaxLoopIterations( );
-			CodeGenParams.MaxCallDepth      = m_JITPolicy->GetMaxCallDepth( );
-
-			Data.JITProgram = m_JITEngine->GenerateCodePtr(
-				Script.get( ),
-				NWActions_NWN2,
-				MAX_ACTION_ID_NWN2,
-				AnalysisFlags,
-				m_TextOut,
-				(ULONG) m_Bridge->GetScriptDebug( ),
-				m_Bridge,
-				NWN::INVALIDOBJID,
-				&CodeGenParams);
+			LeaveCriticalSection( &m_CodeGenLock );
 		}
 #if NWSCRIPTVM_FALLBACK
 		else
 		{
-			Data.Reader     = Script;
-			Data.JITProgram = NULL;
-
-			it = m_ScriptCache.insert( ScriptCacheMap::value_type( ResRef, Data ) ).first;
+			Data.Reader       = Script;
+			Data.JITProgram   = NULL;
+			Data.GenerateTime = ReadPerformanceCounterMilliseconds( ) - StartTick;
 
-			*ScriptData = &it->second;
+			*ScriptData = InsertScript( ResRef, Data );
 
 			m_Bridge->GetTextOut( )->WriteText(
 				"Using NWScript VM for script '%s' (%lu bytes compiled script).\n",
@@ -1048,35 +1277,38 @@ Environment:
 			e.what( ));
 
 #if NWSCRIPTVM_FALLBACK
-		Data.Reader     = Script;
-		Data.JITProgram = NULL;
+		Data.Reader       = Script;
+		Data.JITProgram   = NULL;
+		Data.GenerateTime = ReadPerformanceCounterMilliseconds( ) - StartTick;
 
-		it = m_ScriptCache.insert( ScriptCacheMap::value_type( ResRef, Data ) ).first;
-
-		*ScriptData = &it->second;
+		*ScriptData = InsertScript( ResRef, Data );
 
 		return true;
 #else
-		ScriptData.BrokenScript = true;
-		Data.Reader             = NULL;
-		Data.JITProgram         = NULL;
+		Data.BrokenScript = true;
+		Data.Reader       = NULL;
+		Data.JITProgram   = NULL;
 
-		it = m_ScriptCache.insert( ScriptCacheMap::value_type( ResRef, Data ) ).first;
+		InsertScript( ResRef, Data );
 
 		return false;
 #endif
 	}
 
-	Data.MemoryCost = (size_t) (StartVASpace - GetAvailableVASpace( ));
+	Data.MemoryCost   = (size_t) (StartVASpace - GetAvailableVASpace( ));
+	Data.GenerateTime = ReadPerformanceCounterMilliseconds( ) - StartTick;
 
 	if ((LONG_PTR) Data.MemoryCost < 0)
 		Data.MemoryCost = 0;
 
+	m_EngineStatistics.LoadGenerations  += 1;
+	m_EngineStatistics.LoadGenerateTime += Data.GenerateTime;
+
 	m_Bridge->GetTextOut( )->WriteText(
 		"NWScriptRuntime::LoadScript: Generated code for script '%s' (%lu bytes compiled script) in %lums, approximately %I64lu bytes additional VA space used.\n",
 		ScriptNameStr.c_str( ),
 		(unsigned long) CodeSize,
-		ReadPerformanceCounterMilliseconds( ) - StartTick,
+		Data.GenerateTime,
 		(ULONGLONG) Data.MemoryCost);
 
 	//
@@ -1084,136 +1316,1172 @@ Environment:
 	// script program.
 	//
 
-	it = m_ScriptCache.insert( ScriptCacheMap::value_type( ResRef, Data ) ).first;
-
-	*ScriptData = &it->second;
+	*ScriptData = InsertScript( ResRef, Data );
 
 	return true;
 }
 
-void
-NWScriptRuntime::ConvertScriptParameters(
-	nwn2dev__out NWScriptParamVec & Params,
-	nwn2dev__in NWN2Server::CVirtualMachine * ServerVM
+NWScriptRuntime::NWScriptReaderPtr
+NWScriptRuntime::CreateScriptReader(
+	nwn2dev__in const std::string & ScriptName,
+	__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+	nwn2dev__in size_t CodeSize
 	)
 /*++
 
 Routine Description:
 
-	This routine converts from the server script VM's internal parameter
-	representation to the native representation used by the execution
-	environment.
+	This routine constructs a NWScriptReader for an in-memory instruction
+	stream.  The reader references, rather than copies, the instruction stream.
 
 Arguments:
 
-	Params - Receives the converted parameter array.
+	ScriptName - Supplies the canonical name of the script.
 
-	ServerVM - Supplies the server CVirtualMachine instance which contains the
-	           script parameters requested.
+	InstructionStream - Supplies the complete script program instruction stream.
+
+	CodeSize - Supplies the length, in bytes, of the instruction stream.
 
 Return Value:
 
-	None.  On failure, an std::exception is raised.
+	The routine returns the newly constructed reader.  On failure, an
+	std::exception is raised.
 
 Environment:
 
-	User mode.
+	User mode, script thread.
 
 --*/
 {
-	CExoArrayList< CScriptParameterWrapper > * ServerParams;
-	char                                       Str[ 256 ];
-	CScriptParameterWrapper                  * Param;
-
-	ServerParams = ServerVM->GetScriptParameters( );
+	NWScriptReaderPtr Script;
 
-	if ((ServerParams == NULL) || (ServerParams->num == 0))
-		return;
+	Script = new NWScriptReader(
+		ScriptName.c_str( ),
+		InstructionStream,
+		CodeSize,
+		NULL,
+		0);
 
-	Params.reserve( (size_t) ServerParams->num );
+	//
+	// The CVirtualMachine may have already patched #loader for the return
+	// value workaround.  Check for this now and inform the VM of it so that it
+	// can compensate if we do run the script in the VM and not the JIT engine.
+	//
 
-	for (int i = 0; i < ServerParams->num; i += 1)
+	if (CodeSize >= 2)
 	{
-		size_t CpLen;
-
-		Param = &ServerParams->element[ i ];
-
-		switch (Param->m_eType)
-		{
-
-		case CScriptParameterWrapper::PT_INT:
-			StringCbPrintfA(
-				Str,
-				sizeof( Str ),
-				"%d",
-				Param->m_iIntParameter);
-			Params.push_back( Str );
-			break;
-
-		case CScriptParameterWrapper::PT_FLOAT:
-			StringCbPrintfA(
-				Str,
-				sizeof( Str ),
-				"%g",
-				Param->m_fFloatParameter);
-			Params.push_back( Str );
-			break;
-
-		case CScriptParameterWrapper::PT_STRING:
-		case CScriptParameterWrapper::PT_OBJECTTAG:
-			CpLen = (size_t) Param->m_cStringParameter.m_nBufferLength;
-
-			//
-			// Except for the empty string, the buffer length of a CExoString
-			// includes the null terminator, which we don't want to include in the
-			// body of the internal string.
-			//
-
-			while ((CpLen > 0) && (Param->m_cStringParameter.m_sString[ CpLen - 1 ] == '\0'))
-				CpLen -= 1;
+		UCHAR Opcode;
+		UCHAR TypeOpcode;
 
-			Params.push_back(
-				std::string(
-					Param->m_cStringParameter.m_sString,
-					CpLen
-					)
-				);
-			break;
+		Script->SetInstructionPointer( 0 );
+		Script->ReadInstruction( Opcode, TypeOpcode );
+		Script->SetInstructionPointer( 0 );
 
-		case CScriptParameterWrapper::PT_OBJECT:
-			StringCbPrintfA(
-				Str,
-				sizeof( Str ),
-				"%lu",
-				Param->m_oidObjectParameter);
-			Params.push_back( Str );
-			break;
+		if (Opcode == OP_NOP)
+			Script->SetPatchState( NWScriptReader::NCSPatchState_PatchReturnValue );
+	}
 
-		default:
-			Params.push_back( "" );
-			break;
+	LoadSymbols( *Script, ScriptName );
 
-		}
-	}
+	return Script;
 }
 
 void
-NWScriptRuntime::CreateVM(
+NWScriptRuntime::PrepareCodeGenParams(
+	nwn2dev__out NWSCRIPT_JIT_PARAMS & CodeGenParams,
+	nwn2dev__out ULONG & AnalysisFlags
 	)
 /*++
 
 Routine Description:
 
-	This routine is called to create and initialize the NWScriptVM that acts as
-	a fallback if JIT cannot be completed.
+	This routine sets up the parameters passed to the JIT engine to generate
+	code for a script, as directed by the JIT policy.
 
 Arguments:
 
-	None.
+	CodeGenParams - Receives the code generation parameters.
+
+	AnalysisFlags - Receives the script analyzer flags.
 
 Return Value:
 
-	None.  On failure, an std::exception is raised and m_VM is returned to NULL.
+	None.
+
+Environment:
+
+	User mode, script thread.
+
+--*/
+{
+	ZeroMemory( &CodeGenParams, sizeof( CodeGenParams ) );
+
+	CodeGenParams.Size             = sizeof( CodeGenParams );
+	CodeGenParams.CodeGenFlags     = NWCGF_ENABLE_SAVESTATE_TO_VMSTACK |
+	                                 NWCGF_ASSUME_LOADER_PATCHED;
+	CodeGenParams.CodeGenOutputDir = m_JITPolicy->GetCodeGenOutputDir( );
+
+	//
+	// The code cache lives in the code generation output directory and holds
+	// the generated assemblies itself, so they are not saved separately when
+	// the code cache is in use.
+	//
+
+	if (CodeGenParams.CodeGenOutputDir != NULL)
+	{
+		if (m_JITPolicy->GetUseCodeCache( ))
+			CodeGenParams.CodeGenFlags |= NWCGF_USE_CODE_CACHE;
+		else
+			CodeGenParams.CodeGenFlags |= NWCGF_SAVE_OUTPUT;
+	}
+
+	if (m_JITPolicy->GetOptimizeActionServiceHandlers( ))
+		CodeGenParams.CodeGenFlags |= NWCGF_NWN_COMPATIBLE_ACTIONS;
+
+	AnalysisFlags = 0;
+
+	if (!m_JITPolicy->GetEnableIROptimizations( ))
+		AnalysisFlags |= NWScriptAnalyzer::AF_NO_OPTIMIZATIONS;
+
+	if (m_JITManagedSupport.get( ) != NULL)
+	{
+		CodeGenParams.CodeGenFlags   |= NWCGF_MANAGED_SCRIPT_SUPPORT;
+		CodeGenParams.ManagedSupport  = m_JITManagedSupport->GetManagedSupport( );
+	}
+
+	if (m_JITPolicy->GetDisableExecutionGuards( ))
+		CodeGenParams.CodeGenFlags |= NWCGF_DISABLE_EXECUTION_GUARDS;
+
+	CodeGenParams.MaxLoopIterations = m_JITPolicy->GetMaxLoopIterations( );
+	CodeGenParams.MaxCallDepth      = m_JITPolicy->GetMaxCallDepth( );
+}
+
+void
+NWScriptRuntime::QueueTierUp(
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	__inout ScriptCacheData & Entry,
+	__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+	nwn2dev__in size_t CodeSize
+	)
+/*++
+
+Routine Description:
+
+	This routine queues a script that has been running in the reference VM
+	for native code generation on the tier up thread, starting the thread if
+	it is not yet running.  The script continues to run in the reference VM
+	until the native code is installed at a later invocation boundary.
+
+	If the script cannot be queued, it is left to run in the reference VM.
+
+Arguments:
+
+	ResRef - Supplies the canonical resource name of the script.
+
+	Entry - Supplies the script cache entry for the script.
+
+	InstructionStream - Supplies the complete script program instruction stream.
+
+	CodeSize - Supplies the length, in bytes, of the instruction stream.
+
+Return Value:
+
+	None.  Failures are logged.
+
+Environment:
+
+	User mode, script thread.
+
+--*/
+{
+	TierUpJob * Job;
+
+	Entry.TierUpPending = false;
+
+	try
+	{
+		Job = CreateTierUpJob( ResRef, Entry, InstructionStream, CodeSize );
+	}
+	catch (std::exception &e)
+	{
+		m_Bridge->GetTextOut( )->WriteText(
+			"NWScriptRuntime::QueueTierUp: Failed to queue script '%s' for code generation: exception '%s'.\n",
+			StrFromResRef( ResRef ).c_str( ),
+			e.what( ));
+
+		return;
+	}
+
+	EnterCriticalSection( &m_TierUpLock );
+
+	try
+	{
+		if (m_TierUpThread == NULL)
+		{
+			m_TierUpThread = CreateThread(
+				NULL,
+				0,
+				TierUpThreadProc,
+				this,
+				0,
+				NULL);
+
+			if (m_TierUpThread == NULL)
+				throw std::runtime_error( "Failed to create tier up thread." );
+		}
+
+		m_TierUpQueue.push_back( Job );
+	}
+	catch (std::exception &e)
+	{
+		LeaveCriticalSection( &m_TierUpLock );
+
+		m_Bridge->GetTextOut( )->WriteText(
+			"NWScriptRuntime::QueueTierUp: Failed to queue script '%s' for code generation: exception '%s'.\n",
+			StrFromResRef( ResRef ).c_str( ),
+			e.what( ));
+
+		delete Job;
+		return;
+	}
+
+	LeaveCriticalSection( &m_TierUpLock );
+
+	WakeConditionVariable( &m_TierUpQueueNotEmpty );
+
+	Entry.TierUpQueued       = true;
+	m_TierUpJobsOutstanding += 1;
+
+	if (m_Bridge->IsDebugLevel( NWScriptVM::EDL_Calls ))
+	{
+		m_TextOut->WriteText(
+			"NWScriptRuntime::QueueTierUp: Queued script '%s' for code generation after %lu calls.\n",
+			StrFromResRef( ResRef ).c_str( ),
+			(unsigned long) Entry.CallCount);
+	}
+}
+
+void
+NWScriptRuntime::TierUpScriptNow(
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	__inout ScriptCacheData & Entry,
+	__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+	nwn2dev__in size_t CodeSize
+	)
+/*++
+
+Routine Description:
+
+	This routine generates native code for a script that has been running in
+	the reference VM, on the script thread, and installs it in the script
+	cache.  It is used when native code is needed immediately, such as to
+	resume a script situation that was saved by the JIT engine.
+
+	A tier up job for the script that is still waiting in the queue is removed
+	from the queue.  If the tier up thread is already generating code for the
+	script (or another script), this routine waits for it to finish, as the
+	JIT engine generates code for one script at a time.  The result of that
+	job is discarded when it completes.
+
+Arguments:
+
+	ResRef - Supplies the canonical resource name of the script.
+
+	Entry - Supplies the script cache entry for the script.
+
+	InstructionStream - Supplies the complete script program instruction stream.
+
+	CodeSize - Supplies the length, in bytes, of the instruction stream.
+
+Return Value:
+
+	None.  If code generation fails, the script is left in the reference VM.
+	On failure, an std::exception is raised.
+
+Environment:
+
+	User mode, script thread.
+
+--*/
+{
+	TierUpJob     * Job;
+	TierUpJobList   Discarded;
+
+	Entry.TierUpPending = false;
+
+	//
+	// Pull any queued job for the script off of the queue, so that code is not
+	// generated for it twice.
+	//
+	// N.B.  Splicing does not allocate, so this cannot fail.
+	//
+
+	EnterCriticalSection( &m_TierUpLock );
+
+	for (TierUpJobList::iterator it = m_TierUpQueue.begin( );
+	     it != m_TierUpQueue.end( );
+	     )
+	{
+		TierUpJobList::iterator Next = it;
+
+		++Next;
+
+		if (!memcmp( &(*it)->ResRef, &ResRef, sizeof( ResRef ) ))
+			Discarded.splice( Discarded.end( ), m_TierUpQueue, it );
+
+		it = Next;
+	}
+
+	LeaveCriticalSection( &m_TierUpLock );
+
+	for (TierUpJobList::iterator it = Discarded.begin( );
+	     it != Discarded.end( );
+	     ++it)
+	{
+		delete *it;
+
+		m_TierUpJobsOutstanding -= 1;
+	}
+
+	Job = CreateTierUpJob( ResRef, Entry, InstructionStream, CodeSize );
+
+	RunTierUpJob( *Job );
+
+	try
+	{
+		CompleteTierUpJob( *Job );
+	}
+	catch (std::exception)
+	{
+		delete Job;
+		throw;
+	}
+
+	delete Job;
+}
+
+NWScriptRuntime::TierUpJob *
+NWScriptRuntime::CreateTierUpJob(
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	nwn2dev__in const ScriptCacheData & Entry,
+	__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+	nwn2dev__in size_t CodeSize
+	)
+/*++
+
+Routine Description:
+
+	This routine builds a tier up job for a script.  The job receives its own
+	copy of the instruction stream and a reader over that copy, with symbols
+	loaded, so that code generation does not depend on the server's
+	instruction buffer or on the server's debug loader.
+
+Arguments:
+
+	ResRef - Supplies the canonical resource name of the script.
+
+	Entry - Supplies the script cache entry for the script.
+
+	InstructionStream - Supplies the complete script program instruction stream.
+
+	CodeSize - Supplies the length, in bytes, of the instruction stream.
+
+Return Value:
+
+	The routine returns the newly allocated job, which the caller must delete.
+	On failure, an std::exception is raised.
+
+Environment:
+
+	User mode, script thread.
+
+--*/
+{
+	TierUpJob * Job;
+
+	Job = new TierUpJob;
+
+	try
+	{
+		Job->ResRef       = ResRef;
+		Job->CodeHash     = Entry.CodeHash;
+		Job->CallCount    = Entry.CallCount;
+		Job->Succeeded    = false;
+		Job->GenerateTime = 0;
+		Job->MemoryCost   = 0;
+		Job->DebugLevel   = (ULONG) m_Bridge->GetScriptDebug( );
+
+		Job->Code.assign( InstructionStream, InstructionStream + CodeSize );
+
+		if (Job->Code.empty( ))
+			Job->Code.push_back( 0 );
+
+		Job->Reader = CreateScriptReader(
+			StrFromResRef( ResRef ),
+			&Job->Code[ 0 ],
+			CodeSize);
+
+		PrepareCodeGenParams( Job->CodeGenParams, Job->AnalysisFlags );
+	}
+	catch (std::exception)
+	{
+		delete Job;
+		throw;
+	}
+
+	return Job;
+}
+
+void
+NWScriptRuntime::RunTierUpJob(
+	__inout TierUpJob & Job
+	)
+/*++
+
+Routine Description:
+
+	This routine generates native code for a tier up job.  Only the job and
+	the JIT engine are referenced, so the routine may be called on either the
+	tier up thread or the script thread.  Code generation is serialized by the
+	code generation lock.  Debug text written by the JIT engine is held in the
+	job until the job is completed on the script thread.
+
+Arguments:
+
+	Job - Supplies the job, which receives the generated program (or the
+	      reason that code generation failed).
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ULONGLONG StartVASpace;
+	ULONG     StartTick;
+
+	EnterCriticalSection( &m_CodeGenLock );
+
+	StartVASpace = GetAvailableVASpace( );
+	StartTick    = ReadPerformanceCounterMilliseconds( );
+
+	try
+	{
+		Job.JITProgram = m_JITEngine->GenerateCodePtr(
+			Job.Reader.get( ),
+			NWActions_NWN2,
+			MAX_ACTION_ID_NWN2,
+			Job.AnalysisFlags,
+			&Job.TextOut,
+			Job.DebugLevel,
+			m_Bridge,
+			NWN::INVALIDOBJID,
+			&Job.CodeGenParams);
+
+		Job.Succeeded = true;
+	}
+	catch (std::exception &e)
+	{
+		Job.Succeeded = false;
+
+		try
+		{
+			Job.ErrorText = e.what( );
+		}
+		catch (std::exception)
+		{
+		}
+	}
+
+	Job.GenerateTime = ReadPerformanceCounterMilliseconds( ) - StartTick;
+	Job.MemoryCost   = (size_t) (StartVASpace - GetAvailableVASpace( ));
+
+	LeaveCriticalSection( &m_CodeGenLock );
+
+	//
+	// N.B.  The VA space measurement is approximate, as the script thread may
+	//       be allocating memory at the same time.
+	//
+
+	if ((LONG_PTR) Job.MemoryCost < 0)
+		Job.MemoryCost = 0;
+}
+
+void
+NWScriptRuntime::CompleteTierUpJob(
+	nwn2dev__in TierUpJob & Job
+	)
+/*++
+
+Routine Description:
+
+	This routine installs the native code generated by a tier up job into the
+	script cache entry for the script.  If the script has since been evicted
+	or has changed, or already has native code, the job is discarded.  If code
+	generation failed, the script remains in the reference VM.
+
+	The script's reader is retained, as script situations that were saved by
+	the reference VM may still be outstanding.
+
+Arguments:
+
+	Job - Supplies the completed job.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode, script thread.
+
+--*/
+{
+	ScriptCacheMap::iterator it;
+	ULONG                    Weight;
+
+	for (DeferredTextOut::LineVec::const_iterator Line = Job.TextOut.GetLines( ).begin( );
+	     Line != Job.TextOut.GetLines( ).end( );
+	     ++Line)
+	{
+		m_TextOut->WriteText( "%s", Line->c_str( ) );
+	}
+
+	m_EngineStatistics.TierUpGenerateTime += Job.GenerateTime;
+
+	it = m_ScriptCache.find( Job.ResRef );
+
+	if ((it == m_ScriptCache.end( ))                 ||
+	    (it->second.CodeHash != Job.CodeHash)        ||
+	    (it->second.JITProgram.get( ) != NULL)       ||
+	    (it->second.Reader.get( ) == NULL))
+	{
+		return;
+	}
+
+	ScriptCacheData & Entry = it->second;
+
+	Entry.TierUpPending = false;
+	Entry.TierUpQueued  = false;
+
+	if (!Job.Succeeded)
+	{
+		m_Bridge->GetTextOut( )->WriteText(
+			"NWScriptRuntime::CompleteTierUpJob: Failed to generate code for script '%s' (%lu bytes compiled script): exception '%s'.  The script will continue to use the NWScript VM.\n",
+			StrFromResRef( Job.ResRef ).c_str( ),
+			(unsigned long) Job.Code.size( ),
+			Job.ErrorText.c_str( ));
+
+		m_EngineStatistics.TierUpFailures += 1;
+		return;
+	}
+
+	Entry.JITProgram    = Job.JITProgram;
+	Entry.MemoryCost    = Job.MemoryCost;
+	Entry.GenerateTime += Job.GenerateTime;
+
+	//
+	// Charge the native code to the script cache, and reweight the script now
+	// that it is more expensive to regenerate.  The script cache is trimmed
+	// back within its budget when the next script is inserted.
+	//
+
+	Weight = 1 + Entry.GenerateTime / CLOCK_WEIGHT_UNIT_MS;
+
+	if (Weight > CLOCK_WEIGHT_MAX)
+		Weight = CLOCK_WEIGHT_MAX;
+
+	Entry.CacheCost    += Job.MemoryCost;
+	Entry.ClockWeight   = Weight;
+	Entry.ClockCredit   = Weight;
+	m_ScriptCacheBytes += Job.MemoryCost;
+
+	m_EngineStatistics.TierUps += 1;
+
+	m_Bridge->GetTextOut( )->WriteText(
+		"NWScriptRuntime::CompleteTierUpJob: Generated code for script '%s' (%lu bytes compiled script) after %lu calls in %lums, approximately %I64lu bytes additional VA space used.\n",
+		StrFromResRef( Job.ResRef ).c_str( ),
+		(unsigned long) Job.Code.size( ),
+		(unsigned long) Job.CallCount,
+		Job.GenerateTime,
+		(ULONGLONG) Job.MemoryCost);
+}
+
+void
+NWScriptRuntime::CompleteTierUps(
+	)
+/*++
+
+Routine Description:
+
+	This routine installs the native code for all tier up jobs that have been
+	finished by the tier up thread.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.  Failures are logged.
+
+Environment:
+
+	User mode, script thread.
+
+--*/
+{
+	TierUpJobList Completed;
+
+	if (m_TierUpJobsOutstanding == 0)
+		return;
+
+	EnterCriticalSection( &m_TierUpLock );
+	Completed.swap( m_TierUpCompleted );
+	LeaveCriticalSection( &m_TierUpLock );
+
+	for (TierUpJobList::iterator it = Completed.begin( );
+	     it != Completed.end( );
+	     ++it)
+	{
+		try
+		{
+			CompleteTierUpJob( **it );
+		}
+		catch (std::exception &e)
+		{
+			m_Bridge->GetTextOut( )->WriteText(
+				"NWScriptRuntime::CompleteTierUps: Failed to install code for script '%s': exception '%s'.\n",
+				StrFromResRef( (*it)->ResRef ).c_str( ),
+				e.what( ));
+		}
+
+		delete *it;
+
+		m_TierUpJobsOutstanding -= 1;
+	}
+}
+
+void
+NWScriptRuntime::StopTierUpThread(
+	)
+/*++
+
+Routine Description:
+
+	This routine stops the tier up thread, after any code generation that is
+	in progress finishes, and discards all outstanding tier up jobs.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode, script thread.
+
+--*/
+{
+	EnterCriticalSection( &m_TierUpLock );
+	m_TierUpShutdown = true;
+	LeaveCriticalSection( &m_TierUpLock );
+
+	WakeAllConditionVariable( &m_TierUpQueueNotEmpty );
+
+	if (m_TierUpThread != NULL)
+	{
+		WaitForSingleObject( m_TierUpThread, INFINITE );
+		CloseHandle( m_TierUpThread );
+
+		m_TierUpThread = NULL;
+	}
+
+	for (TierUpJobList::iterator it = m_TierUpQueue.begin( );
+	     it != m_TierUpQueue.end( );
+	     ++it)
+	{
+		delete *it;
+	}
+
+	for (TierUpJobList::iterator it = m_TierUpCompleted.begin( );
+	     it != m_TierUpCompleted.end( );
+	     ++it)
+	{
+		delete *it;
+	}
+
+	m_TierUpQueue.clear( );
+	m_TierUpCompleted.clear( );
+
+	m_TierUpJobsOutstanding = 0;
+}
+
+DWORD
+WINAPI
+NWScriptRuntime::TierUpThreadProc(
+	nwn2dev__in LPVOID Parameter
+	)
+/*++
+
+Routine Description:
+
+	This routine is the entry point of the tier up thread.  It generates native
+	code for queued tier up jobs, one at a time, and hands each job back to
+	the script thread, until the runtime shuts down.
+
+Arguments:
+
+	Parameter - Supplies the runtime.
+
+Return Value:
+
+	Always zero.
+
+Environment:
+
+	User mode, tier up thread.
+
+--*/
+{
+	NWScriptRuntime * This = (NWScriptRuntime *) Parameter;
+	TierUpJobList     Running;
+
+	for (;;)
+	{
+		EnterCriticalSection( &This->m_TierUpLock );
+
+		while ((This->m_TierUpQueue.empty( )) && (!This->m_TierUpShutdown))
+		{
+			SleepConditionVariableCS(
+				&This->m_TierUpQueueNotEmpty,
+				&This->m_TierUpLock,
+				INFINITE);
+		}
+
+		if (This->m_TierUpShutdown)
+		{
+			LeaveCriticalSection( &This->m_TierUpLock );
+			break;
+		}
+
+		//
+		// N.B.  Jobs are moved between lists by splicing, which does not
+		//       allocate, so handing a job back to the script thread cannot
+		//       fail.
+		//
+
+		Running.splice(
+			Running.end( ),
+			This->m_TierUpQueue,
+			This->m_TierUpQueue.begin( ));
+
+		LeaveCriticalSection( &This->m_TierUpLock );
+
+		This->RunTierUpJob( *Running.front( ) );
+
+		EnterCriticalSection( &This->m_TierUpLock );
+
+		This->m_TierUpCompleted.splice(
+			This->m_TierUpCompleted.end( ),
+			Running);
+
+		LeaveCriticalSection( &This->m_TierUpLock );
+	}
+
+	return 0;
+}
+
+NWScriptRuntime::ScriptCacheData *
+NWScriptRuntime::InsertScript(
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	nwn2dev__in const ScriptCacheData & Data
+	)
+/*++
+
+Routine Description:
+
+	This routine inserts a newly loaded script into the script cache.  If the
+	script cache would exceed its memory budget, other scripts are evicted to
+	make room first.
+
+	The script is charged its instruction stream size plus the VA space that
+	was consumed generating native code for it, and is given CLOCK credits in
+	proportion to the time that code generation took.
+
+Arguments:
+
+	ResRef - Supplies the canonical resource name of the script.
+
+	Data - Supplies the script cache data for the script.
+
+Return Value:
+
+	The routine returns a pointer to the script cache entry for the script.
+	On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ScriptCacheMap::iterator   it;
+	ScriptCacheData          * Entry;
+	ULONG                      Weight;
+	size_t                     Cost;
+
+	Cost   = Data.CodeSize + Data.MemoryCost;
+	Weight = 1 + Data.GenerateTime / CLOCK_WEIGHT_UNIT_MS;
+
+	if (Weight > CLOCK_WEIGHT_MAX)
+		Weight = CLOCK_WEIGHT_MAX;
+
+	TrimScriptCache( Cost );
+
+	it = m_ScriptCache.insert( ScriptCacheMap::value_type( ResRef, Data ) ).first;
+
+	Entry = &it->second;
+
+	//
+	// Link the script into the clock ring just behind the clock hand, so that
+	// it is the last script to be considered by the next sweep.
+	//
+
+	try
+	{
+		Entry->ClockPosition = m_ClockRing.insert( m_ClockHand, ResRef );
+	}
+	catch (std::exception)
+	{
+		m_ScriptCache.erase( it );
+		throw;
+	}
+
+	Entry->CacheCost   = Cost;
+	Entry->ClockWeight = Weight;
+	Entry->ClockCredit = Weight;
+
+	m_ScriptCacheBytes += Cost;
+
+	return Entry;
+}
+
+void
+NWScriptRuntime::EvictScript(
+	nwn2dev__in ScriptCacheMap::iterator it
+	)
+/*++
+
+Routine Description:
+
+	This routine removes a script from the script cache, releasing its native
+	code (if no other references to the script program remain).
+
+	The caller must ensure that the script is not currently executing.
+
+Arguments:
+
+	it - Supplies the script cache entry to remove.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ScriptCacheData & Entry = it->second;
+
+	if (m_ClockHand == Entry.ClockPosition)
+		++m_ClockHand;
+
+	m_ClockRing.erase( Entry.ClockPosition );
+
+	m_ScriptCacheBytes -= Entry.CacheCost;
+
+	m_ScriptCache.erase( it );
+}
+
+void
+NWScriptRuntime::TrimScriptCache(
+	nwn2dev__in size_t AdditionalCost
+	)
+/*++
+
+Routine Description:
+
+	This routine evicts scripts from the script cache until an additional
+	amount of memory fits within the script cache budget.
+
+	Scripts are selected for eviction with the CLOCK algorithm.  The clock hand
+	sweeps the ring of cached scripts; a script with CLOCK credits remaining
+	gives up a credit and is passed over, while a script with no credits left
+	is evicted.  Scripts regain their full credits whenever they are used.
+	Scripts that are currently executing are never evicted.
+
+Arguments:
+
+	AdditionalCost - Supplies the amount of memory, in bytes, that is about
+	                 to be charged to the script cache.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	size_t Budget;
+	size_t Steps;
+
+	Budget = m_JITPolicy->GetScriptCacheBudget( );
+
+	if (Budget == 0)
+		return;
+
+	//
+	// Every idle script runs out of credits after CLOCK_WEIGHT_MAX passes of
+	// the hand, so the sweep is bounded in case only executing scripts are
+	// left.
+	//
+
+	Steps = m_ClockRing.size( ) * (CLOCK_WEIGHT_MAX + 1);
+
+	while ((m_ScriptCacheBytes + AdditionalCost > Budget) && (Steps != 0))
+	{
+		ScriptCacheMap::iterator it;
+
+		Steps -= 1;
+
+		if (m_ClockHand == m_ClockRing.end( ))
+			m_ClockHand = m_ClockRing.begin( );
+
+		it = m_ScriptCache.find( *m_ClockHand );
+
+		if (it->second.RecursionLevel != 0)
+		{
+			++m_ClockHand;
+			continue;
+		}
+
+		if (it->second.ClockCredit != 0)
+		{
+			it->second.ClockCredit -= 1;
+			++m_ClockHand;
+			continue;
+		}
+
+		m_Bridge->GetTextOut( )->WriteText(
+			"NWScriptRuntime::TrimScriptCache: Evicting script '%s' (%lu calls, %lu bytes charged) from the script cache.\n",
+			StrFromResRef( it->first ).c_str( ),
+			(unsigned long) it->second.CallCount,
+			(unsigned long) it->second.CacheCost);
+
+		m_EvictedScripts.insert( it->first );
+
+		EvictScript( it );
+
+		m_CacheStatistics.Evictions += 1;
+	}
+}
+
+ULONGLONG
+NWScriptRuntime::HashInstructionStream(
+	__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+	nwn2dev__in size_t CodeSize
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the 64-bit content hash of a script instruction
+	stream, which is used to detect scripts that have changed.
+
+	As the hash is computed each time that a script is invoked, the stream is
+	consumed eight bytes at a time (multiply and xor-shift mixing), with only
+	the final partial word mixed in a byte at a time (FNV-1a).
+
+Arguments:
+
+	InstructionStream - Supplies the script instruction stream.
+
+	CodeSize - Supplies the length, in bytes, of the instruction stream.
+
+Return Value:
+
+	The routine returns the content hash of the instruction stream.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ULONGLONG Hash;
+	ULONGLONG Word;
+	size_t    i;
+
+	Hash = 14695981039346656037ULL ^ (ULONGLONG) CodeSize;
+
+	for (i = 0; i + sizeof( Word ) <= CodeSize; i += sizeof( Word ))
+	{
+		memcpy( &Word, &InstructionStream[ i ], sizeof( Word ) );
+
+		Hash ^= Word;
+		Hash *= 0x9E3779B97F4A7C15ULL;
+		Hash ^= Hash >> 29;
+	}
+
+	for (; i < CodeSize; i += 1)
+	{
+		Hash ^= InstructionStream[ i ];
+		Hash *= 1099511628211ULL;
+	}
+
+	Hash ^= Hash >> 32;
+	Hash *= 0xD6E8FEB86659FD93ULL;
+	Hash ^= Hash >> 32;
+
+	return Hash;
+}
+
+void
+NWScriptRuntime::ConvertScriptParameters(
+	nwn2dev__out NWScriptParamVec & Params,
+	nwn2dev__in NWN2Server::CVirtualMachine * ServerVM
+	)
+/*++
+
+Routine Description:
+
+	This routine converts from the server script VM's internal parameter
+	representation to the native representation used by the execution
+	environment.
+
+Arguments:
+
+	Params - Receives the converted parameter array.
+
+	ServerVM - Supplies the server CVirtualMachine instance which contains the
+	           script parameters requested.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	CExoArrayList< CScriptParameterWrapper > * ServerParams;
+	char                                       Str[ 256 ];
+	CScriptParameterWrapper                  * Param;
+
+	ServerParams = ServerVM->GetScriptParameters( );
+
+	if ((ServerParams == NULL) || (ServerParams->num == 0))
+		return;
+
+	Params.reserve( (size_t) ServerParams->num );
+
+	for (int i = 0; i < ServerParams->num; i += 1)
+	{
+		size_t CpLen;
+
+		Param = &ServerParams->element[ i ];
+
+		switch (Param->m_eType)
+		{
+
+		case CScriptParameterWrapper::PT_INT:
+			StringCbPrintfA(
+				Str,
+				sizeof( Str ),
+				"%d",
+				Param->m_iIntParameter);
+			Params.push_back( Str );
+			break;
+
+		case CScriptParameterWrapper::PT_FLOAT:
+			StringCbPrintfA(
+				Str,
+				sizeof( Str ),
+				"%g",
+				Param->m_fFloatParameter);
+			Params.push_back( Str );
+			break;
+
+		case CScriptParameterWrapper::PT_STRING:
+		case CScriptParameterWrapper::PT_OBJECTTAG:
+			CpLen = (size_t) Param->m_cStringParameter.m_nBufferLength;
+
+			//
+			// Except for the empty string, the buffer length of a CExoString
+			// includes the null terminator, which we don't want to include in the
+			// body of the internal string.
+			//
+
+			while ((CpLen > 0) && (Param->m_cStringParameter.m_sString[ CpLen - 1 ] == '\0'))
+				CpLen -= 1;
+
+			Params.push_back(
+				std::string(
+					Param->m_cStringParameter.m_sString,
+					CpLen
+					)
+				);
+			break;
+
+		case CScriptParameterWrapper::PT_OBJECT:
+			StringCbPrintfA(
+				Str,
+				sizeof( Str ),
+				"%lu",
+				Param->m_oidObjectParameter);
+			Params.push_back( Str );
+			break;
+
+		default:
+			Params.push_back( "" );
+			break;
+
+		}
+	}
+}
+
+void
+NWScriptRuntime::CreateVM(
+	)
+/*++
+
+Routine Description:
+
+	This routine is called to create and initialize the NWScriptVM that acts as
+	a fallback if JIT cannot be completed.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised and m_VM is returned to NULL.
 
 Environment:
 
@@ -1430,6 +2698,39 @@ Environment:
 	DebugLoader.ReleaseDebugInfo( );
 }
 
+ULONGLONG
+NWScriptRuntime::ReadPerformanceCounterMicroseconds(
+	) const
+/*++
+
+Routine Description:
+
+	This routine returns an approximate count of microseconds from the
+	performance counter.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	An approximate count of microseconds in performance counter intervals is
+	returned.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	LARGE_INTEGER PerfCounter;
+
+	if (!QueryPerformanceCounter( &PerfCounter ))
+		return 0;
+
+	return (ULONGLONG) ((PerfCounter.QuadPart * 1000) / m_PerfFrequency.QuadPart);
+}
+
 ULONG
 NWScriptRuntime::ReadPerformanceCounterMilliseconds(
 	) const
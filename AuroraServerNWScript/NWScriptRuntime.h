@@ -56,9 +56,21 @@ public:
 	  m_VM( NULL ),
 	  m_JITPolicy( JITPolicy ),
 	  m_RecursionLevel( 0 ),
-	  m_TotalScriptRuntime( 0 )
+	  m_TotalScriptRuntime( 0 ),
+	  m_ScriptCacheBytes( 0 ),
+	  m_TierUpThread( NULL ),
+	  m_TierUpShutdown( false ),
+	  m_TierUpJobsOutstanding( 0 )
 	{
 		ZeroMemory( &m_CurrentScriptName, sizeof( m_CurrentScriptName ) );
+		ZeroMemory( &m_CacheStatistics, sizeof( m_CacheStatistics ) );
+		ZeroMemory( &m_EngineStatistics, sizeof( m_EngineStatistics ) );
+
+		InitializeCriticalSection( &m_TierUpLock );
+		InitializeCriticalSection( &m_CodeGenLock );
+		InitializeConditionVariable( &m_TierUpQueueNotEmpty );
+
+		m_ClockHand = m_ClockRing.end( );
 
 		//
 		// Read the performance counter frequency and map it to a count of
@@ -82,7 +94,13 @@ public:
 	~NWScriptRuntime(
 		)
 	{
+		StopTierUpThread( );
+
+		DeleteCriticalSection( &m_CodeGenLock );
+		DeleteCriticalSection( &m_TierUpLock );
+
 		m_ScriptCache.clear( );
+		m_ClockRing.clear( );
 
 		if (m_VM != NULL)
 		{
@@ -122,7 +140,8 @@ public:
 
 	//
 	// Clear the script cache out, deleting any JIT'd scripts that had been
-	// previously converted to native code.
+	// previously converted to native code.  Scripts that are currently
+	// executing are retained.
 	//
 
 	void
@@ -140,9 +159,30 @@ public:
 
 private:
 
+	//
+	// Define the signatures of saved states placed on the VM stack.  Saved
+	// states are tagged with the engine that created them, as a script that
+	// has been moved from the reference VM to the JIT engine may still have
+	// script situations outstanding that were saved by the reference VM.
+	//
+
 	enum
 	{
-		SAVED_STATE_ID = 'NSSJ'
+		SAVED_STATE_ID    = 'NSSJ',
+		SAVED_STATE_ID_VM = 'NSSV'
+	};
+
+	//
+	// Define the script cache eviction weighting.  Each script cache entry is
+	// given a number of CLOCK credits that scales with the time it took to
+	// generate code for the script, so that scripts that are expensive to
+	// regenerate survive more sweeps of the clock hand.
+	//
+
+	enum
+	{
+		CLOCK_WEIGHT_MAX     = 8,
+		CLOCK_WEIGHT_UNIT_MS = 10
 	};
 
 	typedef swutil::SharedPtr< NWScriptReader > NWScriptReaderPtr;
@@ -151,10 +191,14 @@ private:
 	typedef swutil::SharedPtr< NWScriptJITLib > NWScriptJITLibPtr;
 	typedef swutil::SharedPtr< NWScriptJITManagedSupport > NWScriptJITManagedSupportPtr;
 
+	typedef std::list< NWN::ResRef32 > ScriptClockRing;
+
 	struct ScriptCacheData
 	{
 		bool                         BrokenScript;
 		bool                         FirstRun;
+		bool                         TierUpPending;
+		bool                         TierUpQueued;
 		NWScriptReaderPtr            Reader;
 		NWScriptJITLib::Program::Ptr JITProgram;
 		size_t                       CallCount;
@@ -162,8 +206,177 @@ private:
 		size_t                       MemoryCost;
 		ULONG                        Runtime;
 		size_t                       RecursionLevel;
+		ULONG                        GenerateTime;
+		size_t                       CodeSize;
+		ULONGLONG                    CodeHash;
+		size_t                       CacheCost;
+		ULONG                        ClockWeight;
+		ULONG                        ClockCredit;
+		ScriptClockRing::iterator    ClockPosition;
 	};
 
+	//
+	// Define the script cache counters reported by DumpStatistics.
+	//
+
+	struct ScriptCacheStatistics
+	{
+		ULONGLONG                    Lookups;
+		ULONGLONG                    Hits;
+		ULONGLONG                    Evictions;
+		ULONGLONG                    Invalidations;
+		ULONGLONG                    Recompiles;
+	};
+
+	//
+	// Define the execution engine counters reported by DumpStatistics.  Times
+	// are in microseconds, except for background code generation time, which
+	// is in milliseconds.  Steady state calls exclude the first run of each
+	// script, which is instead counted in the first run latency (including
+	// the time taken to load the script).
+	//
+
+	struct EngineStatistics
+	{
+		ULONGLONG                    FirstRuns;
+		ULONGLONG                    FirstRunTime;
+		ULONGLONG                    VMCalls;
+		ULONGLONG                    VMRuntime;
+		ULONGLONG                    JITCalls;
+		ULONGLONG                    JITRuntime;
+		ULONGLONG                    TierUps;
+		ULONGLONG                    TierUpFailures;
+		ULONGLONG                    TierUpGenerateTime;
+		ULONGLONG                    LoadGenerations;
+		ULONGLONG                    LoadGenerateTime;
+	};
+
+	//
+	// Define a debug text output sink that holds text written during code
+	// generation on the tier up thread, so that the text can be written to
+	// the log by the script thread once code generation has finished.
+	//
+
+	class DeferredTextOut : public IDebugTextOut
+	{
+
+	public:
+
+		typedef std::vector< std::string > LineVec;
+
+		inline
+		virtual
+		void
+		WriteText(
+			nwn2dev__in nwn2dev__format_string const char* fmt,
+			...
+			)
+		{
+			va_list ap;
+
+			va_start( ap, fmt );
+			WriteTextV( 0, fmt, ap );
+			va_end( ap );
+		}
+
+		inline
+		virtual
+		void
+		WriteText(
+			nwn2dev__in WORD Attributes,
+			nwn2dev__in nwn2dev__format_string const char* fmt,
+			...
+			)
+		{
+			va_list ap;
+
+			va_start( ap, fmt );
+			WriteTextV( Attributes, fmt, ap );
+			va_end( ap );
+		}
+
+		inline
+		virtual
+		void
+		WriteTextV(
+			nwn2dev__in nwn2dev__format_string const char* fmt,
+			nwn2dev__in va_list ap
+			)
+		{
+			WriteTextV( 0, fmt, ap );
+		}
+
+		inline
+		virtual
+		void
+		WriteTextV(
+			nwn2dev__in WORD Attributes,
+			nwn2dev__in nwn2dev__format_string const char* fmt,
+			nwn2dev__in va_list ap
+			)
+		{
+			char buf[ 8193 ];
+
+			UNREFERENCED_PARAMETER( Attributes );
+
+			StringCbVPrintfA( buf, sizeof( buf ), fmt, ap );
+
+			try
+			{
+				m_Lines.push_back( buf );
+			}
+			catch (std::exception)
+			{
+			}
+		}
+
+		inline
+		const LineVec &
+		GetLines(
+			) const
+		{
+			return m_Lines;
+		}
+
+	private:
+
+		LineVec m_Lines;
+
+	};
+
+	//
+	// Define a request to generate native code for a script that has been
+	// running in the reference VM.  The job owns a copy of the script's
+	// instruction stream, as the server's instruction buffer is only valid
+	// while the script is being executed.  All fields other than the results
+	// are set up by the script thread before the job is queued.
+	//
+
+	struct TierUpJob
+	{
+		NWN::ResRef32                ResRef;
+		ULONGLONG                    CodeHash;
+		std::vector< unsigned char > Code;
+		NWScriptReaderPtr            Reader;
+		ULONG                        AnalysisFlags;
+		ULONG                        DebugLevel;
+		NWSCRIPT_JIT_PARAMS          CodeGenParams;
+		size_t                       CallCount;
+
+		//
+		// Results, set by the tier up thread.
+		//
+
+		NWScriptJITLib::Program::Ptr JITProgram;
+		bool                         Succeeded;
+		std::string                  ErrorText;
+		ULONG                        GenerateTime;
+		size_t                       MemoryCost;
+		DeferredTextOut              TextOut;
+	};
+
+	typedef std::list< TierUpJob * > TierUpJobList;
+
 	struct ScriptResumeData
 	{
 		NWScriptVM::VMState::Ptr        ScriptSituation;
@@ -189,7 +402,51 @@ private:
 
 	};
 
-	typedef std::map< NWN::ResRef32, ScriptCacheData, ResRefLess > ScriptCacheMap;
+	//
+	// Hash and equality predicates for ScriptCacheMap.
+	//
+
+	struct ResRefHash : public std::unary_function< const NWN::ResRef32 &, size_t >
+	{
+
+		inline
+		size_t
+		operator()(
+			nwn2dev__in const NWN::ResRef32 & ResRef
+			) const
+		{
+			ULONG Hash = 2166136261UL;
+
+			for (size_t i = 0; i < sizeof( ResRef.RefStr ); i += 1)
+			{
+				if (ResRef.RefStr[ i ] == '\0')
+					break;
+
+				Hash = (Hash ^ (unsigned char) ResRef.RefStr[ i ]) * 16777619UL;
+			}
+
+			return (size_t) Hash;
+		}
+
+	};
+
+	struct ResRefEqual : public std::binary_function< const NWN::ResRef32 &, const NWN::ResRef32 &, bool >
+	{
+
+		inline
+		bool
+		operator()(
+			nwn2dev__in const NWN::ResRef32 & left,
+			nwn2dev__in const NWN::ResRef32 & right
+			) const
+		{
+			return memcmp( &left, &right, sizeof( left ) ) == 0;
+		}
+
+	};
+
+	typedef std::unordered_map< NWN::ResRef32, ScriptCacheData, ResRefHash, ResRefEqual > ScriptCacheMap;
+	typedef std::set< NWN::ResRef32, ResRefLess > ScriptNameSet;
 
 	class DllDirectoryHolder
 	{
@@ -250,6 +507,156 @@ private:
 		__deref_out ScriptCacheData * * ScriptData
 		);
 
+	//
+	// Construct a reader for a script instruction stream, informing it of any
+	// patches that the server has made and loading symbols for it.
+	//
+
+	NWScriptReaderPtr
+	CreateScriptReader(
+		nwn2dev__in const std::string & ScriptName,
+		__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+		nwn2dev__in size_t CodeSize
+		);
+
+	//
+	// Set up the JIT engine code generation parameters from the JIT policy.
+	//
+
+	void
+	PrepareCodeGenParams(
+		nwn2dev__out NWSCRIPT_JIT_PARAMS & CodeGenParams,
+		nwn2dev__out ULONG & AnalysisFlags
+		);
+
+	//
+	// Queue a script that has been running in the reference VM for native code
+	// generation on the tier up thread.
+	//
+
+	void
+	QueueTierUp(
+		nwn2dev__in const NWN::ResRef32 & ResRef,
+		__inout ScriptCacheData & Entry,
+		__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+		nwn2dev__in size_t CodeSize
+		);
+
+	//
+	// Generate native code for a script that has been running in the reference
+	// VM on the script thread, without waiting for the tier up thread.
+	//
+
+	void
+	TierUpScriptNow(
+		nwn2dev__in const NWN::ResRef32 & ResRef,
+		__inout ScriptCacheData & Entry,
+		__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+		nwn2dev__in size_t CodeSize
+		);
+
+	//
+	// Build a tier up job for a script.
+	//
+
+	TierUpJob *
+	CreateTierUpJob(
+		nwn2dev__in const NWN::ResRef32 & ResRef,
+		nwn2dev__in const ScriptCacheData & Entry,
+		__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+		nwn2dev__in size_t CodeSize
+		);
+
+	//
+	// Generate native code for a tier up job.  This routine may be called on
+	// any thread.
+	//
+
+	void
+	RunTierUpJob(
+		__inout TierUpJob & Job
+		);
+
+	//
+	// Install the native code generated by a tier up job into the script
+	// cache.
+	//
+
+	void
+	CompleteTierUpJob(
+		nwn2dev__in TierUpJob & Job
+		);
+
+	//
+	// Install the native code for all tier up jobs that have finished.  This
+	// routine is called at each script invocation boundary.
+	//
+
+	void
+	CompleteTierUps(
+		);
+
+	//
+	// Stop the tier up thread, discarding any jobs that have not run.
+	//
+
+	void
+	StopTierUpThread(
+		);
+
+	//
+	// Tier up thread entry point.
+	//
+
+	static
+	DWORD
+	WINAPI
+	TierUpThreadProc(
+		nwn2dev__in LPVOID Parameter
+		);
+
+	//
+	// Insert a newly loaded script into the script cache, evicting other
+	// scripts first as necessary to stay within the script cache budget.
+	//
+
+	ScriptCacheData *
+	InsertScript(
+		nwn2dev__in const NWN::ResRef32 & ResRef,
+		nwn2dev__in const ScriptCacheData & Data
+		);
+
+	//
+	// Remove a script from the script cache.
+	//
+
+	void
+	EvictScript(
+		nwn2dev__in ScriptCacheMap::iterator it
+		);
+
+	//
+	// Evict scripts from the script cache until an additional amount of memory
+	// fits within the script cache budget, or until only executing scripts
+	// remain.
+	//
+
+	void
+	TrimScriptCache(
+		nwn2dev__in size_t AdditionalCost
+		);
+
+	//
+	// Compute the content hash of a script instruction stream.
+	//
+
+	static
+	ULONGLONG
+	HashInstructionStream(
+		__in_ecount( CodeSize ) const unsigned char * InstructionStream,
+		nwn2dev__in size_t CodeSize
+		);
+
 	//
 	// Convert script parameters from the server's internal representation to
 	// the native representation used by the execution environment.
@@ -317,6 +724,14 @@ private:
 	ReadPerformanceCounterMilliseconds(
 		) const;
 
+	//
+	// Sample the performance counter and return a count of microseconds.
+	//
+
+	ULONGLONG
+	ReadPerformanceCounterMicroseconds(
+		) const;
+
 	//
 	// Convert a resref into a textural string.
 	//
@@ -413,11 +828,75 @@ private:
 
 	//
 	// Define the script cache.  All script entries executed are placed into
-	// the cache.
+	// the cache, which is bounded by the memory budget supplied by the JIT
+	// policy.  Scripts are evicted in CLOCK order.
 	//
 
 	ScriptCacheMap                              m_ScriptCache;
 
+	//
+	// Define the CLOCK ring of cached scripts, and the current position of the
+	// clock hand in the ring.
+	//
+
+	ScriptClockRing                             m_ClockRing;
+	ScriptClockRing::iterator                   m_ClockHand;
+
+	//
+	// Define the memory charged to the scripts in the script cache.
+	//
+
+	size_t                                      m_ScriptCacheBytes;
+
+	//
+	// Define the names of scripts that have been evicted from the script
+	// cache, used to count scripts that are compiled more than once.
+	//
+
+	ScriptNameSet                               m_EvictedScripts;
+
+	//
+	// Define the script cache statistics.
+	//
+
+	ScriptCacheStatistics                       m_CacheStatistics;
+
+	//
+	// Define the execution engine statistics.
+	//
+
+	EngineStatistics                            m_EngineStatistics;
+
+	//
+	// Define the tier up thread, which generates native code in the background
+	// for scripts that have been running in the reference VM, and the queues
+	// of jobs waiting for and finished with code generation.  The queues and
+	// the shutdown flag are protected by the tier up lock.
+	//
+
+	HANDLE                                      m_TierUpThread;
+	CRITICAL_SECTION                            m_TierUpLock;
+	CONDITION_VARIABLE                          m_TierUpQueueNotEmpty;
+	TierUpJobList                               m_TierUpQueue;
+	TierUpJobList                               m_TierUpCompleted;
+	bool                                        m_TierUpShutdown;
+
+	//
+	// Define the code generation lock, which is held around every call into
+	// the JIT engine to generate code.  The JIT engine may only generate code
+	// for one script at a time, and code is generated on both the tier up
+	// thread and the script thread.
+	//
+
+	CRITICAL_SECTION                            m_CodeGenLock;
+
+	//
+	// Define the count of tier up jobs that have been queued but not yet
+	// completed.  This is only accessed by the script thread.
+	//
+
+	size_t                                      m_TierUpJobsOutstanding;
+
 	//
 	// Define the currently executing script JIT program, referenced from action
 	// handlers.
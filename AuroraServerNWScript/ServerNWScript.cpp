@@ -624,6 +624,24 @@ Environment:
 			(INT) m_OptimizeActionServiceHandlers ? 1 : 0,
 			m_IniPath.c_str( ) ) ? true : false;
 
+		m_ScriptCacheBudget = (ULONG) GetPrivateProfileInt(
+			L"Settings",
+			L"ScriptCacheBudget",
+			(INT) m_ScriptCacheBudget,
+			m_IniPath.c_str( ) );
+
+		m_TierUpThreshold = (ULONG) GetPrivateProfileInt(
+			L"Settings",
+			L"TierUpThreshold",
+			(INT) m_TierUpThreshold,
+			m_IniPath.c_str( ) );
+
+		m_UseCodeCache = GetPrivateProfileInt(
+			L"Settings",
+			L"UseCodeCache",
+			(INT) m_UseCodeCache ? 1 : 0,
+			m_IniPath.c_str( ) ) ? true : false;
+
 		GetPrivateProfileString(
 			L"Settings",
 			L"CodeGenOutputDirectory",
@@ -673,11 +691,26 @@ Environment:
 		m_TextOut->WriteText(
 			"OptimizeActionServiceHandlers set to %lu.\n",
 			m_OptimizeActionServiceHandlers ? 1 : 0 );
+		m_TextOut->WriteText(
+			"ScriptCacheBudget set to %lu.\n",
+			(unsigned long) m_ScriptCacheBudget );
+		m_TextOut->WriteText(
+			"TierUpThreshold set to %lu.\n",
+			(unsigned long) m_TierUpThreshold );
+		m_TextOut->WriteText(
+			"UseCodeCache set to %lu.\n",
+			m_UseCodeCache ? 1 : 0 );
 
 		if (m_CodeGenOutputDirectory.empty( ))
 		{
 			m_TextOut->WriteText(
 				"Code generation output will not be saved.\n" );
+
+			if (m_UseCodeCache)
+			{
+				m_TextOut->WriteText(
+					"WARNING: UseCodeCache requires CodeGenOutputDirectory to be set; the code cache is disabled.\n" );
+			}
 		}
 		else
 		{
@@ -1262,6 +1295,87 @@ Environment:
 	return m_OptimizeActionServiceHandlers;
 }
 
+size_t
+ServerNWScriptPlugin::GetScriptCacheBudget(
+	)
+/*++
+
+Routine Description:
+
+	This routine determines the memory budget for the script cache.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the memory budget, in bytes, for scripts held in the
+	script cache, else zero if the script cache is unbounded.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	return (size_t) m_ScriptCacheBudget;
+}
+
+ULONG
+ServerNWScriptPlugin::GetTierUpThreshold(
+	)
+/*++
+
+Routine Description:
+
+	This routine determines how many times a script is run in the reference VM
+	before native code is generated for it.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the count of runs in the reference VM after which
+	native code is generated for a script on a background thread, else zero
+	if native code is generated before a script is first run.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	return m_TierUpThreshold;
+}
+
+bool
+ServerNWScriptPlugin::GetUseCodeCache(
+	)
+/*++
+
+Routine Description:
 
+	This routine determines whether generated code is kept in an on-disk code
+	cache, so that unchanged scripts can be loaded on a later run of the
+	server without generating code for them again.
 
+Arguments:
 
+	None.
+
+Return Value:
+
+	The routine returns true if the code cache is to be used.  The code cache
+	is only used if a code generation output directory is configured.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	return m_UseCodeCache;
+}
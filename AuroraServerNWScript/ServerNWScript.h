@@ -63,7 +63,10 @@ public:
 	  m_LoadDebugSymbols( true ),
 	  m_AllowManagedScripts( false ),
 	  m_DisableExecutionGuards( false ),
-	  m_OptimizeActionServiceHandlers( true )
+	  m_OptimizeActionServiceHandlers( true ),
+	  m_ScriptCacheBudget( 0 ),
+	  m_TierUpThreshold( 0 ),
+	  m_UseCodeCache( false )
 	{
 		m_sPlugin = this;
 	}
@@ -245,6 +248,38 @@ public:
 	GetOptimizeActionServiceHandlers(
 		);
 
+	//
+	// Return the memory budget, in bytes, for scripts held in the script
+	// cache, else zero if the script cache is unbounded.
+	//
+
+	virtual
+	size_t
+	GetScriptCacheBudget(
+		);
+
+	//
+	// Return the number of times that a script is run in the reference VM
+	// before native code is generated for it in the background, else zero if
+	// native code should be generated before the script is first run.
+	//
+
+	virtual
+	ULONG
+	GetTierUpThreshold(
+		);
+
+	//
+	// Return whether generated code is kept in an on-disk code cache under
+	// the code generation output directory, so that scripts that have not
+	// changed since an earlier run can be loaded without generating code.
+	//
+
+	virtual
+	bool
+	GetUseCodeCache(
+		);
+
 private:
 
 	bool
@@ -298,6 +333,9 @@ private:
 	bool                          m_AllowManagedScripts;
 	bool                          m_DisableExecutionGuards;
 	bool                          m_OptimizeActionServiceHandlers;
+	ULONG                         m_ScriptCacheBudget;
+	ULONG                         m_TierUpThreshold;
+	bool                          m_UseCodeCache;
 
 };
 
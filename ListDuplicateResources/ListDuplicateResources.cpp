@@ -0,0 +1,726 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ListDuplicateResources.cpp
+
+Abstract:
+
+	This module houses a sample program that reports resources with identical
+	contents that are supplied by more than one resource provider (such as a
+	module, its HAKs, and optionally the game data), and demonstrates the
+	memory saved by sharing identical resource payloads.
+
+--*/
+
+#include "Precomp.h"
+#include "../NWN2DataLib/TextOut.h"
+#include "../NWN2DataLib/ResourceManager.h"
+
+//
+// Define the debug text output interface, used to write debug or log messages
+// to the user.
+//
+
+class PrintfTextOut : public IDebugTextOut
+{
+
+public:
+
+	inline
+	PrintfTextOut(
+		)
+	{
+		AllocConsole( );
+	}
+
+	inline
+	~PrintfTextOut(
+		)
+	{
+		FreeConsole( );
+	}
+
+	enum { STD_COLOR = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE };
+
+	inline
+	virtual
+	void
+	WriteText(
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		...
+		)
+	{
+		va_list ap;
+
+		va_start( ap, fmt );
+		WriteTextV( STD_COLOR, fmt, ap );
+		va_end( ap );
+	}
+
+	inline
+	virtual
+	void
+	WriteText(
+		nwn2dev__in WORD Attributes,
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		...
+		)
+	{
+		va_list ap;
+
+		va_start( ap, fmt );
+		WriteTextV( Attributes, fmt, ap );
+		va_end( ap );
+
+		UNREFERENCED_PARAMETER( Attributes );
+	}
+
+	inline
+	virtual
+	void
+	WriteTextV(
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		nwn2dev__in va_list ap
+		)
+	{
+		WriteTextV( STD_COLOR, fmt, ap );
+	}
+
+	inline
+	virtual
+	void
+	WriteTextV(
+		nwn2dev__in WORD Attributes,
+		nwn2dev__in const char *fmt,
+		nwn2dev__in va_list argptr
+		)
+	/*++
+
+	Routine Description:
+
+		This routine displays text to the log file and the debug console.
+
+		The console output may have color attributes supplied, as per the standard
+		SetConsoleTextAttribute API.
+
+	Arguments:
+
+		Attributes - Supplies color attributes for the text as per the standard
+					 SetConsoleTextAttribute API (e.g. FOREGROUND_RED).
+
+		fmt - Supplies the printf-style format string to use to display text.
+
+		argptr - Supplies format inserts.
+
+	Return Value:
+
+		None.
+
+	Environment:
+
+		User mode.
+
+	--*/
+	{
+		HANDLE console = GetStdHandle( STD_OUTPUT_HANDLE );
+		char buf[8193];
+		StringCbVPrintfA(buf, sizeof( buf ), fmt, argptr);
+		DWORD n = (DWORD)strlen(buf);
+		SetConsoleTextAttribute( console, Attributes );
+		WriteConsoleA(console, buf, n, &n, 0);
+	}
+
+};
+
+static
+const char *
+GetProviderTypeName(
+	nwn2dev__in AccessorType ProviderType
+	)
+/*++
+
+Routine Description:
+
+	This routine returns a display name for a resource provider type.
+
+Arguments:
+
+	ProviderType - Supplies the resource accessor type of the provider.
+
+Return Value:
+
+	The routine returns a pointer to a constant string naming the type.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	switch (ProviderType)
+	{
+
+	case AccessorTypeBif:
+		return "bif";
+	case AccessorTypeErf:
+		return "erf";
+	case AccessorTypeDirectory:
+		return "dir";
+	case AccessorTypeKey:
+		return "key";
+	case AccessorTypeZip:
+		return "zip";
+	default:
+		return "other";
+
+	}
+}
+
+static
+unsigned long
+Percent(
+	nwn2dev__in ULONGLONG Part,
+	nwn2dev__in ULONGLONG Whole
+	)
+/*++
+
+Routine Description:
+
+	This routine computes an integral percentage.
+
+Arguments:
+
+	Part - Supplies the numerator.
+
+	Whole - Supplies the denominator.
+
+Return Value:
+
+	The routine returns Part as a percentage of Whole, or zero if Whole is
+	zero.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if (Whole == 0)
+		return 0;
+
+	return (unsigned long) ((Part * 100) / Whole);
+}
+
+void
+PrintDuplicateReport(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in IDebugTextOut * TextOut,
+	nwn2dev__in bool IncludeInbox
+	)
+/*++
+
+Routine Description:
+
+	This routine hashes every resource of every loaded resource provider and
+	prints, for each provider in search order, the count and size of the
+	resources whose contents were already supplied by an earlier provider.
+
+Arguments:
+
+	ResMan - Supplies the resource manager that has loaded the module.
+
+	TextOut - Supplies the text output interface.
+
+	IncludeInbox - Supplies a Boolean value indicating true if the game data
+	               (zip archives and BIFs) are to be included in the report.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ResourceManager::DuplicateReportVec Report;
+	ULONGLONG                           Resources;
+	ULONGLONG                           Bytes;
+	ULONGLONG                           DuplicateResources;
+	ULONGLONG                           DuplicateBytes;
+
+	TextOut->WriteText( "Hashing resources...\n" );
+
+	ResMan.BuildDuplicateReport( Report, IncludeInbox );
+
+	Resources          = 0;
+	Bytes              = 0;
+	DuplicateResources = 0;
+	DuplicateBytes     = 0;
+
+	TextOut->WriteText(
+		"\n%-32s %-5s %10s %14s %10s %14s %4s\n",
+		"Provider",
+		"Type",
+		"Resources",
+		"Bytes",
+		"Dup.Res",
+		"Dup.Bytes",
+		"Dup%");
+
+	for (ResourceManager::DuplicateReportVec::const_iterator it = Report.begin( );
+	     it != Report.end( );
+	     ++it)
+	{
+		TextOut->WriteText(
+			"%-32s %-5s %10I64u %14I64u %10I64u %14I64u %3lu%%\n",
+			it->ProviderName.c_str( ),
+			GetProviderTypeName( it->ProviderType ),
+			it->Resources,
+			it->Bytes,
+			it->DuplicateResources,
+			it->DuplicateBytes,
+			Percent( it->DuplicateBytes, it->Bytes ));
+
+		Resources          += it->Resources;
+		Bytes              += it->Bytes;
+		DuplicateResources += it->DuplicateResources;
+		DuplicateBytes     += it->DuplicateBytes;
+	}
+
+	TextOut->WriteText(
+		"%-32s %-5s %10I64u %14I64u %10I64u %14I64u %3lu%%\n\n",
+		"Total",
+		"",
+		Resources,
+		Bytes,
+		DuplicateResources,
+		DuplicateBytes,
+		Percent( DuplicateBytes, Bytes ));
+}
+
+void
+DemonstrateSharedBuffers(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in IDebugTextOut * TextOut,
+	nwn2dev__in bool IncludeInbox
+	)
+/*++
+
+Routine Description:
+
+	This routine loads every resource that is visible through the resource
+	manager into memory with DemandBuffer, holding all of the buffers at once,
+	and then reports how much memory the loaded resources would have taken
+	without deduplication versus the memory that the shared buffers take.
+
+Arguments:
+
+	ResMan - Supplies the resource manager that has loaded the module, with
+	         resource deduplication enabled.
+
+	TextOut - Supplies the text output interface.
+
+	IncludeInbox - Supplies a Boolean value indicating true if resources that
+	               are supplied by the game data are to be loaded too.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typedef ResourceManager::ResourceBufferPtr ResourceBufferPtr;
+
+	std::vector< ResourceBufferPtr >     Buffers;
+	ResourceDedupStore::DedupStatistics  Statistics;
+	FileId                               Count;
+	ULONGLONG                            Saved;
+
+	Count = ResMan.GetEncapsulatedFileCount( );
+
+	TextOut->WriteText( "Loading resources into shared buffers...\n" );
+
+	for (FileId i = 0; i < Count; i += 1)
+	{
+		NWN::ResRef32               ResRef;
+		NWN::ResType                Type;
+		FileHandle                  Handle;
+		AccessorType                ProviderType;
+		std::string                 ProviderName;
+
+		if (!ResMan.GetEncapsulatedFileEntry( i, ResRef, Type ))
+			continue;
+
+		//
+		// Skip resources that come from loose files, and (unless requested)
+		// resources that come from the game data.
+		//
+
+		Handle = ResMan.OpenFileByIndex( i );
+
+		if (Handle == INVALID_FILE)
+			continue;
+
+		ProviderType = ResMan.GetResourceAccessorName( Handle, ProviderName );
+
+		ResMan.CloseFile( Handle );
+
+		if (ProviderType != AccessorTypeErf)
+		{
+			if ((!IncludeInbox) ||
+			    ((ProviderType != AccessorTypeZip) &&
+			     (ProviderType != AccessorTypeKey)))
+			{
+				continue;
+			}
+		}
+
+		try
+		{
+			Buffers.push_back(
+				ResMan.DemandBuffer( ResMan.StrFromResRef( ResRef ), Type ) );
+		}
+		catch (std::exception &e)
+		{
+			TextOut->WriteText(
+				"WARNING: Failed to load %s.%s: '%s'.\n",
+				ResMan.StrFromResRef( ResRef ).c_str( ),
+				ResMan.ResTypeToExt( Type ),
+				e.what( ));
+		}
+	}
+
+	ResMan.GetDedupStore( ).GetStatistics( Statistics );
+
+	Saved = Statistics.BufferRequestBytes - Statistics.UniqueBufferBytes;
+
+	TextOut->WriteText(
+		"Loaded %I64u resources (%I64u bytes) into %I64u unique buffers (%I64u bytes).\n"
+		"Sharing identical payloads saved %I64u bytes (%lu%%).\n",
+		Statistics.BufferRequests,
+		Statistics.BufferRequestBytes,
+		Statistics.UniqueBuffers,
+		Statistics.UniqueBufferBytes,
+		Saved,
+		Percent( Saved, Statistics.BufferRequestBytes ));
+}
+
+void
+PrintUsage(
+	)
+/*++
+
+Routine Description:
+
+	This routine prints usage information for the program to the console.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	printf(
+		"ListDuplicateResources\n"
+		"\n"
+		"This program lists, for the module and each of its HAKs, the resources\n"
+		"whose contents are identical to a resource supplied earlier in the\n"
+		"resource search order, and then shows the memory that is saved when\n"
+		"identical resources share a single buffer.\n"
+		"\n"
+		"Usage: ListDuplicateResources -home <homedir> -installdir <installdir>\n"
+		"                              -module <module resource name> [-nwn1]\n"
+		"                              [-inbox]\n"
+		"\n"
+		"The -inbox option includes the game data in the report.  Note that this\n"
+		"reads all of the game data, and so may take a while.\n"
+		);
+}
+
+void
+LoadModule(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in const char * ModuleName,
+	nwn2dev__in const char * NWN2Home,
+	nwn2dev__in const char * InstallDir,
+	nwn2dev__in bool Erf16
+	)
+/*++
+
+Routine Description:
+
+	This routine performs a full load of a module, including the TLK file and
+	any dependent HAKs.
+
+Arguments:
+
+	ResMan - Supplies the ResourceManager instance that is to load the module.
+
+	ModuleName - Supplies the resource name of the module to load.
+
+	NWN2Home - Supplies the users NWN2 home directory (i.e. NWN2 Documents dir).
+
+	InstallDir - Supplies the game installation directory.
+
+	Erf16 - Supplies a Boolean value indicating true if 16-byte ERFs are to be
+	        used (i.e. for NWN1-style modules), else false if 32-byte ERFs are
+	        to be used (i.e. for NWN2-style modules).
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< NWN::ResRef32 >        HAKList;
+	std::string                         CustomTlk;
+	ResourceManager::ModuleLoadParams   LoadParams;
+
+	ZeroMemory( &LoadParams, sizeof( LoadParams ) );
+
+	//
+	// Load up the module.  First, we load just the core module resources, then
+	// we determine the HAK list and load all of the HAKs up too.
+	//
+	// Turn off granny2 loading as it's unnecessary for this program, and prefer
+	// to load directory modules.
+	//
+
+	LoadParams.SearchOrder = ResourceManager::ModSearch_PrefDirectory;
+	LoadParams.ResManFlags = ResourceManager::ResManFlagNoGranny2          |
+	                         ResourceManager::ResManFlagLoadCoreModuleOnly |
+	                         ResourceManager::ResManFlagRequireModuleIfo;
+
+	if (Erf16)
+		LoadParams.ResManFlags |= ResourceManager::ResManFlagErf16;
+
+	ResMan.LoadModuleResources(
+		ModuleName,
+		"",
+		NWN2Home,
+		InstallDir,
+		HAKList,
+		&LoadParams);
+
+	{
+		DemandResourceStr                ModuleIfoFile( ResMan, "module", NWN::ResIFO );
+		GffFileReader                    ModuleIfo( ModuleIfoFile, ResMan );
+		const GffFileReader::GffStruct * RootStruct = ModuleIfo.GetRootStruct( );
+		GffFileReader::GffStruct         Struct;
+		size_t                           Offset;
+
+		RootStruct->GetCExoString( "Mod_CustomTlk", CustomTlk );
+
+		//
+		// Chop off the .tlk extension in the CustomTlk field if we had one.
+		//
+
+		if ((Offset = CustomTlk.rfind( '.' )) != std::string::npos)
+			CustomTlk.erase( Offset );
+
+		for (size_t i = 0; i <= UCHAR_MAX; i += 1)
+		{
+			GffFileReader::GffStruct Hak;
+			NWN::ResRef32            HakRef;
+
+			if (!RootStruct->GetListElement( "Mod_HakList", i, Hak ))
+				break;
+
+			if (!Hak.GetCExoStringAsResRef( "Mod_Hak", HakRef ))
+				throw std::runtime_error( "Failed to read Mod_HakList.Mod_Hak" );
+
+			HAKList.push_back( HakRef );
+		}
+
+		//
+		// If there were no haks, then try the legacy field.
+		//
+
+		if (HAKList.empty( ))
+		{
+			NWN::ResRef32 HakRef;
+
+			if ((RootStruct->GetCExoStringAsResRef( "Mod_Hak", HakRef )) &&
+				 (HakRef.RefStr[ 0 ] != '\0'))
+			{
+				HAKList.push_back( HakRef );
+			}
+		}
+	}
+
+	//
+	// Now perform a full load with the HAK list and CustomTlk available.
+	//
+	// N.B.  The DemandResourceStr above must go out of scope before we issue a
+	//       new load, as it references a temporary file that will be cleaned up
+	//       by the new load request.
+	//
+
+	ZeroMemory( &LoadParams, sizeof( LoadParams ) );
+
+	//
+	// Enable resource deduplication for the full load, so that resources that
+	// are loaded by the memory demonstration share their payloads.
+	//
+
+	LoadParams.SearchOrder = ResourceManager::ModSearch_PrefDirectory;
+	LoadParams.ResManFlags = ResourceManager::ResManFlagNoGranny2            |
+	                         ResourceManager::ResManFlagRequireModuleIfo     |
+	                         ResourceManager::ResManFlagDeduplicateResources;
+
+	if (Erf16)
+		LoadParams.ResManFlags |= ResourceManager::ResManFlagErf16;
+
+	ResMan.LoadModuleResources(
+		ModuleName,
+		CustomTlk,
+		NWN2Home,
+		InstallDir,
+		HAKList,
+		&LoadParams
+		);
+}
+
+int
+__cdecl
+main(
+	nwn2dev__in int argc,
+	__in_ecount( argc ) const char * * argv
+	)
+/*++
+
+Routine Description:
+
+	This routine is the entry point symbol for the duplicate resource lister
+	program.
+
+Arguments:
+
+	argc - Supplies the count of command line arguments.
+
+	argv - Supplies the command line argument vector.
+
+Return Value:
+
+	The routine returns the process exit code.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const char    * ModuleName;
+	const char    * NWN2Home;
+	const char    * InstallDir;
+	bool            Erf16;
+	bool            IncludeInbox;
+
+	ModuleName   = NULL;
+	NWN2Home     = NULL;
+	InstallDir   = NULL;
+	Erf16        = false;
+	IncludeInbox = false;
+
+	//
+	// Parse out the command line arguments.
+	//
+
+	for (int i = 1; i < argc; i += 1)
+	{
+		if ((!_stricmp( argv[ i ], "-module" )) && (i + 1 < argc))
+			ModuleName = argv[ ++i ];
+		else if ((!_stricmp( argv[ i ], "-home" )) && (i + 1 < argc))
+			NWN2Home = argv[ ++i ];
+		else if ((!_stricmp( argv[ i ], "-installdir" )) && (i + 1 < argc))
+			InstallDir = argv[ ++i ];
+		else if ((!_stricmp( argv[ i ], "-nwn1")))
+			Erf16 = true;
+		else if ((!_stricmp( argv[ i ], "-inbox")))
+			IncludeInbox = true;
+		else
+		{
+			PrintUsage( );
+			printf( "\nUnrecognized command line argument.\n" );
+			return -1;
+		}
+	}
+
+	//
+	// First, check that we've got the necessary arguments.
+	//
+
+	if (ModuleName == NULL)
+	{
+		PrintUsage( );
+		printf( "\nYou must specify the module resource name of the module to load with -module <module resource name>.  The module resource name must be enclosed in quotes if it contains spaces.\n" );
+		return -1;
+	}
+
+	if (NWN2Home == NULL)
+	{
+		PrintUsage( );
+		printf( "\nYou must specify the NWN2 home directory location with -home <homedir>.  The home directory is typically the path to your \"Documents\\Neverwinter Nights 2\" directory.  The directory name must be enclosed in quotes if it contains spaces.\n" );
+		return -1;
+	}
+
+	if (InstallDir == NULL)
+	{
+		PrintUsage( );
+		printf( "\nYou must specify the NWN2 game installation directory location with -installdir <installdir>.  The installation directory is typically the path to the Neverwinter Nights 2 directory under Program Files.  The directory name must be enclosed in quotes if it contains spaces.\n" );
+		return -1;
+	}
+
+	//
+	// Now spin up a resource manager instance.
+	//
+
+	PrintfTextOut   TextOut;
+	ResourceManager ResMan( &TextOut );
+
+	try
+	{
+		TextOut.WriteText( "Loading module...\n" );
+		LoadModule( ResMan, ModuleName, NWN2Home, InstallDir, Erf16 );
+
+		PrintDuplicateReport( ResMan, &TextOut, IncludeInbox );
+		DemonstrateSharedBuffers( ResMan, &TextOut, IncludeInbox );
+	}
+	catch (std::exception &e)
+	{
+		//
+		// Simple print an error message and abort if we went wrong, such as if
+		// we couldn't load the module.
+		//
+
+		TextOut.WriteText( "ERROR: Exception '%s'.\n", e.what( ) );
+		return -1;
+	}
+
+	//
+	// All done.
+	//
+
+	return 0;
+}
@@ -277,6 +277,854 @@ Environment:
 	}
 }
 
+ULONGLONG
+QueryElapsedMicroseconds(
+	nwn2dev__in const LARGE_INTEGER & Start
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the time elapsed since a performance counter sample
+	was taken.
+
+Arguments:
+
+	Start - Supplies the starting performance counter sample.
+
+Return Value:
+
+	The routine returns the elapsed time, in microseconds.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	LARGE_INTEGER Now;
+	LARGE_INTEGER Frequency;
+
+	QueryPerformanceCounter( &Now );
+	QueryPerformanceFrequency( &Frequency );
+
+	if (Frequency.QuadPart == 0)
+		return 0;
+
+	return (ULONGLONG) (Now.QuadPart - Start.QuadPart) * 1000000 /
+		(ULONGLONG) Frequency.QuadPart;
+}
+
+void
+PurgeWalkmeshCache(
+	nwn2dev__in const std::string & CacheDirectory
+	)
+/*++
+
+Routine Description:
+
+	This routine deletes all walkmesh cache files from a cache directory.
+
+Arguments:
+
+	CacheDirectory - Supplies the walkmesh cache directory.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	WIN32_FIND_DATAA FindData;
+	HANDLE           Find;
+	std::string      Mask;
+
+	Mask  = CacheDirectory;
+	Mask += "\\*.aswc";
+
+	Find = FindFirstFileA( Mask.c_str( ), &FindData );
+
+	if (Find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		std::string FileName;
+
+		FileName  = CacheDirectory;
+		FileName += "\\";
+		FileName += FindData.cFileName;
+
+		DeleteFileA( FileName.c_str( ) );
+	} while (FindNextFileA( Find, &FindData ));
+
+	FindClose( Find );
+}
+
+void
+BenchmarkAreaLoading(
+	nwn2dev__in const std::vector< NWN::ResRef32 > & AreaResRefs,
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in IDebugTextOut * TextOut,
+	__in_opt const char * CacheDirectory
+	)
+/*++
+
+Routine Description:
+
+	This routine loads the walkmesh, terrain and water data of every area in
+	the module and reports the time taken for a fully serial load, for a load
+	that decodes the resources of each area in parallel, and for a batch load
+	of all areas in parallel.
+
+	If a walkmesh cache directory is supplied, the batch load is also timed
+	with a cold (empty) walkmesh cache, a warm cache, and a warm trusted
+	cache.
+
+Arguments:
+
+	AreaResRefs - Supplies the resource names of the areas to load.
+
+	ResMan - Supplies a reference to the resource manager instance to use in
+	         order to load any associated resource data.
+
+	TextOut - Supplies the text output interface.
+
+	CacheDirectory - Optionally supplies the walkmesh cache directory.  Any
+	                 cache files in the directory are deleted.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::list< DemandResource32 > TrxFiles;
+	TrxFileReader::FileNameVec    FileNames;
+	LARGE_INTEGER                 Start;
+	ULONGLONG                     SerialTime;
+	ULONGLONG                     PerAreaTime;
+	ULONGLONG                     BatchTime;
+
+	//
+	// Demand all of the area files up front so that resource extraction is
+	// not included in the load times.
+	//
+
+	for (std::vector< NWN::ResRef32 >::const_iterator it = AreaResRefs.begin( );
+	     it != AreaResRefs.end( );
+	     ++it)
+	{
+		TrxFiles.push_back( DemandResource32( ResMan, *it, NWN::ResTRX ) );
+		FileNames.push_back( TrxFiles.back( ).GetDemandedFileName( ) );
+	}
+
+	TextOut->WriteText(
+		"Loading %lu areas (%lu processors)...\n",
+		(unsigned long) FileNames.size( ),
+		ParallelWorkQueue::GetProcessorCount( ));
+
+	//
+	// Serial load, one area and one resource at a time.
+	//
+
+	{
+		MeshManager            MeshMgr;
+		TrxFileReader::PtrVec  Areas;
+
+		QueryPerformanceCounter( &Start );
+
+		for (TrxFileReader::FileNameVec::const_iterator it = FileNames.begin( );
+		     it != FileNames.end( );
+		     ++it)
+		{
+			Areas.push_back(
+				new TrxFileReader(
+					MeshMgr,
+					*it,
+					false,
+					TrxFileReader::ModeTRX,
+					TextOut,
+					false,
+					TrxFileReader::LoadFlagSerialDecode));
+		}
+
+		SerialTime = QueryElapsedMicroseconds( Start );
+	}
+
+	//
+	// One area at a time, with the resources of each area decoded in
+	// parallel.
+	//
+
+	{
+		MeshManager            MeshMgr;
+		TrxFileReader::PtrVec  Areas;
+
+		QueryPerformanceCounter( &Start );
+
+		for (TrxFileReader::FileNameVec::const_iterator it = FileNames.begin( );
+		     it != FileNames.end( );
+		     ++it)
+		{
+			Areas.push_back(
+				new TrxFileReader(
+					MeshMgr,
+					*it,
+					false,
+					TrxFileReader::ModeTRX,
+					TextOut));
+		}
+
+		PerAreaTime = QueryElapsedMicroseconds( Start );
+	}
+
+	//
+	// All areas loaded as a parallel batch.
+	//
+
+	{
+		MeshManager            MeshMgr;
+		TrxFileReader::PtrVec  Areas;
+
+		QueryPerformanceCounter( &Start );
+
+		TrxFileReader::LoadAreas( MeshMgr, FileNames, false, Areas, TextOut );
+
+		BatchTime = QueryElapsedMicroseconds( Start );
+	}
+
+	TextOut->WriteText(
+		"Area load times: serial %I64u us, per-area parallel %I64u us, batch parallel %I64u us.\n",
+		SerialTime,
+		PerAreaTime,
+		BatchTime);
+
+	if (CacheDirectory == NULL)
+		return;
+
+	//
+	// Now time batch loads through the walkmesh cache:  first with an empty
+	// cache (which populates it), and then with the populated cache.
+	//
+
+	CreateDirectoryA( CacheDirectory, NULL );
+	PurgeWalkmeshCache( CacheDirectory );
+
+	static const struct
+	{
+		const char * Description;
+		ULONG        LoadFlags;
+	} CachePasses[ ] =
+	{
+		{ "cold",         0                                         },
+		{ "warm",         0                                         },
+		{ "warm trusted", TrxFileReader::LoadFlagTrustWalkmeshCache }
+	};
+
+	for (size_t i = 0; i < sizeof( CachePasses ) / sizeof( CachePasses[ 0 ] ); i += 1)
+	{
+		MeshManager            MeshMgr;
+		TrxFileReader::PtrVec  Areas;
+
+		QueryPerformanceCounter( &Start );
+
+		TrxFileReader::LoadAreas(
+			MeshMgr,
+			FileNames,
+			false,
+			Areas,
+			TextOut,
+			false,
+			CachePasses[ i ].LoadFlags,
+			CacheDirectory);
+
+		TextOut->WriteText(
+			"Area load time with %s walkmesh cache: %I64u us.\n",
+			CachePasses[ i ].Description,
+			QueryElapsedMicroseconds( Start ));
+	}
+}
+
+void
+CollectGitResources(
+	nwn2dev__in const GffFileReader::GffStruct & Struct,
+	nwn2dev__in ResType TemplateType,
+	nwn2dev__in ResourceManager & ResMan,
+	__inout std::set< std::string > & Seen,
+	__inout ResourcePrefetcher::ResourceKeyVec & Keys
+	)
+/*++
+
+Routine Description:
+
+	This routine collects the resources referenced by a structure within an
+	area's .git file (recursively, through nested structures and lists).
+
+	Blueprint template references are typed by the instance list that they
+	appear in, event handler fields (On*) reference compiled scripts, and
+	Conversation fields reference dialogs.  Other resource references are
+	not collected.
+
+Arguments:
+
+	Struct - Supplies the structure to scan.
+
+	TemplateType - Supplies the blueprint resource type of instances within
+	               the list that contains the structure, else ResINVALID.
+
+	ResMan - Supplies a reference to the resource manager instance.
+
+	Seen - Supplies the set of resources already collected, which is used to
+	       skip duplicate references.
+
+	Keys - Receives the referenced resources.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	static const struct
+	{
+		const char * ListName;
+		ResType      Type;
+	} ListTypes[ ] =
+	{
+		{ "Creature List",   NWN::ResUTC },
+		{ "Door List",       NWN::ResUTD },
+		{ "Encounter List",  NWN::ResUTE },
+		{ "Placeable List",  NWN::ResUTP },
+		{ "SoundList",       NWN::ResUTS },
+		{ "StoreList",       NWN::ResUTM },
+		{ "TriggerList",     NWN::ResUTT },
+		{ "WaypointList",    NWN::ResUTW },
+		{ "List",            NWN::ResUTI }  // Placeable and creature inventory
+	};
+
+	for (GffFileReader::FIELD_INDEX i = 0; i < Struct.GetFieldCount( ); i += 1)
+	{
+		GffFileReader::GFF_FIELD_TYPE FieldType;
+		std::string                   FieldName;
+
+		if ((!Struct.GetFieldType( i, FieldType )) ||
+		    (!Struct.GetFieldName( i, FieldName )))
+		{
+			throw std::runtime_error( "Failed to read .git field." );
+		}
+
+		switch (FieldType)
+		{
+
+		case GffFileReader::GFF_RESREF:
+			{
+				ResourcePrefetcher::ResourceKey Key;
+				char                            KeyName[ 64 ];
+
+				if (!_strnicmp( FieldName.c_str( ), "On", 2 ))
+					Key.Type = NWN::ResNCS;
+				else if (!_stricmp( FieldName.c_str( ), "Conversation" ))
+					Key.Type = NWN::ResDLG;
+				else if (!_stricmp( FieldName.c_str( ), "TemplateResRef" ))
+					Key.Type = TemplateType;
+				else
+					break;
+
+				if ((Key.Type == NWN::ResINVALID) ||
+				    (!Struct.GetResRef( FieldName.c_str( ), Key.ResRef )) ||
+				    (Key.ResRef.RefStr[ 0 ] == '\0'))
+				{
+					break;
+				}
+
+				StringCbPrintfA(
+					KeyName,
+					sizeof( KeyName ),
+					"%s.%lu",
+					ResMan.StrFromResRef( Key.ResRef ).c_str( ),
+					(unsigned long) Key.Type);
+
+				if (!Seen.insert( KeyName ).second)
+					break;
+
+				Keys.push_back( Key );
+			}
+			break;
+
+		case GffFileReader::GFF_STRUCT:
+			{
+				GffFileReader::GffStruct Child;
+
+				if (Struct.GetStruct( FieldName.c_str( ), Child ))
+					CollectGitResources( Child, TemplateType, ResMan, Seen, Keys );
+			}
+			break;
+
+		case GffFileReader::GFF_LIST:
+			{
+				ResType ListType = NWN::ResINVALID;
+
+				for (size_t j = 0; j < sizeof( ListTypes ) / sizeof( ListTypes[ 0 ] ); j += 1)
+				{
+					if (!_stricmp( FieldName.c_str( ), ListTypes[ j ].ListName ))
+					{
+						ListType = ListTypes[ j ].Type;
+						break;
+					}
+				}
+
+				for (size_t j = 0; j <= ULONG_MAX; j += 1)
+				{
+					GffFileReader::GffStruct Element;
+
+					if (!Struct.GetListElement( FieldName.c_str( ), j, Element ))
+						break;
+
+					CollectGitResources( Element, ListType, ResMan, Seen, Keys );
+				}
+			}
+			break;
+
+		default:
+			break;
+
+		}
+	}
+}
+
+bool
+ReadResourceContents(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in const ResourcePrefetcher::ResourceKey & Key,
+	nwn2dev__out std::vector< unsigned char > & Contents
+	)
+/*++
+
+Routine Description:
+
+	This routine synchronously reads the full contents of a resource.
+
+Arguments:
+
+	ResMan - Supplies a reference to the resource manager instance.
+
+	Key - Supplies the resource to read.
+
+	Contents - Receives the contents of the resource.
+
+Return Value:
+
+	The routine returns true if the resource was read, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FileHandle Handle;
+	size_t     FileSize;
+	size_t     Read;
+	bool       Status;
+
+	Handle = ResMan.OpenFile( Key.ResRef, Key.Type );
+
+	if (Handle == INVALID_FILE)
+		return false;
+
+	FileSize = ResMan.GetEncapsulatedFileSize( Handle );
+
+	Contents.resize( FileSize );
+
+	Status = (FileSize == 0) ||
+	         ((ResMan.ReadEncapsulatedFile(
+	            Handle,
+	            0,
+	            FileSize,
+	            &Read,
+	            &Contents[ 0 ])) &&
+	          (Read == FileSize));
+
+	ResMan.CloseFile( Handle );
+
+	return Status;
+}
+
+void
+BenchmarkGitPrefetch(
+	nwn2dev__in const std::vector< NWN::ResRef32 > & AreaResRefs,
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in IDebugTextOut * TextOut
+	)
+/*++
+
+Routine Description:
+
+	This routine reads every resource referenced by the .git files of the
+	module's areas (blueprints, scripts and dialogs), and reports the time
+	taken to read them synchronously versus through the asynchronous
+	resource prefetcher.
+
+	The prefetch batch is submitted at speculative priority, and one area's
+	.are file is then requested at critical priority, to measure how long a
+	critical request waits behind queued speculative prefetch.
+
+Arguments:
+
+	AreaResRefs - Supplies the resource names of the areas to scan.
+
+	ResMan - Supplies a reference to the resource manager instance to use in
+	         order to load any associated resource data.
+
+	TextOut - Supplies the text output interface.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ResourcePrefetcher::ResourceKeyVec Keys;
+	ResourcePrefetcher::RequestVec     Requests;
+	std::set< std::string >            Seen;
+	std::vector< unsigned char >       Contents;
+	LARGE_INTEGER                      Start;
+	ULONGLONG                          SyncTime;
+	ULONGLONG                          AsyncTime;
+	ULONGLONG                          CriticalTime;
+	unsigned long                      Missing;
+
+	for (std::vector< NWN::ResRef32 >::const_iterator it = AreaResRefs.begin( );
+	     it != AreaResRefs.end( );
+	     ++it)
+	{
+		DemandResource32 GitFile( ResMan, *it, NWN::ResGIT );
+		GffFileReader    Git( GitFile, ResMan );
+
+		CollectGitResources(
+			*Git.GetRootStruct( ),
+			NWN::ResINVALID,
+			ResMan,
+			Seen,
+			Keys);
+	}
+
+	if (Keys.empty( ))
+	{
+		TextOut->WriteText( "No resources are referenced by the area .git files.\n" );
+		return;
+	}
+
+	//
+	// Read everything once, untimed, so that both timed passes run against
+	// a warm file cache.
+	//
+
+	Missing = 0;
+
+	for (ResourcePrefetcher::ResourceKeyVec::const_iterator it = Keys.begin( );
+	     it != Keys.end( );
+	     ++it)
+	{
+		if (!ReadResourceContents( ResMan, *it, Contents ))
+			Missing += 1;
+	}
+
+	TextOut->WriteText(
+		"Prefetching %lu resources referenced by %lu area .git files (%lu not found)...\n",
+		(unsigned long) Keys.size( ),
+		(unsigned long) AreaResRefs.size( ),
+		Missing);
+
+	//
+	// Synchronous reads, one resource at a time.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (ResourcePrefetcher::ResourceKeyVec::const_iterator it = Keys.begin( );
+	     it != Keys.end( );
+	     ++it)
+	{
+		ReadResourceContents( ResMan, *it, Contents );
+	}
+
+	SyncTime = QueryElapsedMicroseconds( Start );
+
+	//
+	// Asynchronous prefetch of the whole batch, with a critical request
+	// issued behind it.
+	//
+
+	{
+		ResourcePrefetcher Prefetcher( ResMan );
+		PrefetchRequestPtr Critical;
+
+		QueryPerformanceCounter( &Start );
+
+		Prefetcher.PrefetchBatch(
+			Keys,
+			ResourcePrefetcher::PrioritySpeculative,
+			NULL,
+			NULL,
+			Requests);
+
+		Critical = Prefetcher.Prefetch(
+			AreaResRefs.front( ),
+			NWN::ResARE,
+			ResourcePrefetcher::PriorityCritical);
+
+		Prefetcher.Wait( Critical );
+
+		CriticalTime = QueryElapsedMicroseconds( Start );
+
+		for (ResourcePrefetcher::RequestVec::const_iterator it = Requests.begin( );
+		     it != Requests.end( );
+		     ++it)
+		{
+			Prefetcher.Wait( *it );
+		}
+
+		AsyncTime = QueryElapsedMicroseconds( Start );
+	}
+
+	TextOut->WriteText(
+		"Resource read times: synchronous %I64u us, prefetched %I64u us (critical request served after %I64u us).\n",
+		SyncTime,
+		AsyncTime,
+		CriticalTime);
+}
+
+void
+WriteProbeFile(
+	nwn2dev__in const std::string & FileName,
+	nwn2dev__in const char * Contents
+	)
+/*++
+
+Routine Description:
+
+	This routine replaces the contents of a file.
+
+Arguments:
+
+	FileName - Supplies the path of the file to write.
+
+	Contents - Supplies the new contents of the file.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	HANDLE File;
+	DWORD  Length;
+	DWORD  Written;
+	bool   Status;
+
+	File = CreateFileA(
+		FileName.c_str( ),
+		GENERIC_WRITE,
+		0,
+		NULL,
+		CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL);
+
+	if (File == INVALID_HANDLE_VALUE)
+		throw std::runtime_error( "Failed to create probe file." );
+
+	Length = (DWORD) strlen( Contents );
+	Status = (WriteFile( File, Contents, Length, &Written, NULL )) &&
+	         (Written == Length);
+
+	CloseHandle( File );
+
+	if (!Status)
+		throw std::runtime_error( "Failed to write probe file." );
+}
+
+ULONGLONG
+WaitForProbeRowCount(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in const std::vector< HANDLE > & Events,
+	nwn2dev__in const std::string & ProbeName,
+	nwn2dev__in size_t RowCount,
+	nwn2dev__in const LARGE_INTEGER & Start
+	)
+/*++
+
+Routine Description:
+
+	This routine waits for the resource manager to observe a given row count
+	in the probe 2DA, applying directory changes as they are signaled.
+
+Arguments:
+
+	ResMan - Supplies a reference to the resource manager instance.
+
+	Events - Supplies the directory change notification events.
+
+	ProbeName - Supplies the name of the probe 2DA.
+
+	RowCount - Supplies the row count to wait for (zero if the probe 2DA is
+	           to be removed).
+
+	Start - Supplies the performance counter sample taken when the probe
+	        file was changed.
+
+Return Value:
+
+	The routine returns the time taken for the change to become visible, in
+	microseconds.  An std::exception is raised on failure or timeout.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	DWORD WaitStatus;
+
+	for (;;)
+	{
+		ResMan.ProcessDirectoryChanges( );
+
+		if (ResMan.Get2DARowCount( ProbeName ) == RowCount)
+			return QueryElapsedMicroseconds( Start );
+
+		WaitStatus = WaitForMultipleObjects(
+			(DWORD) Events.size( ),
+			&Events[ 0 ],
+			FALSE,
+			5000);
+
+		if (WaitStatus == WAIT_TIMEOUT)
+			throw std::runtime_error( "Timed out waiting for directory change." );
+		else if (WaitStatus == WAIT_FAILED)
+			throw std::runtime_error( "Failed to wait for directory change." );
+	}
+}
+
+void
+BenchmarkDirectoryWatch(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in const char * NWN2Home,
+	nwn2dev__in IDebugTextOut * TextOut
+	)
+/*++
+
+Routine Description:
+
+	This routine measures how long a change to a file in the override
+	directory takes to become visible through the resource manager, when the
+	resource manager watches its directories instead of being reloaded.
+
+	A probe 2DA is created, rewritten with an extra row, and then deleted;
+	the time from each file system change until the resource manager returns
+	the new contents is reported.
+
+Arguments:
+
+	ResMan - Supplies a reference to the resource manager instance, which
+	         must have been loaded with ResManFlagWatchDirectories.
+
+	NWN2Home - Supplies the NWN2 home directory.
+
+	TextOut - Supplies the text output interface.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< HANDLE > Events;
+	std::string           ProbeName;
+	std::string           ProbeFile;
+	LARGE_INTEGER         Start;
+	ULONGLONG             AddTime;
+	ULONGLONG             ModifyTime;
+	ULONGLONG             RemoveTime;
+
+	ResMan.GetDirectoryChangeEvents( Events );
+
+	if (Events.empty( ))
+	{
+		TextOut->WriteText( "No resource directories are being watched.\n" );
+		return;
+	}
+
+	ProbeName  = "nwn2dl_watch_probe";
+	ProbeFile  = NWN2Home;
+	ProbeFile += "/override/";
+	ProbeFile += ProbeName;
+	ProbeFile += ".2da";
+
+	try
+	{
+		QueryPerformanceCounter( &Start );
+
+		WriteProbeFile(
+			ProbeFile,
+			"2DA V2.0\r\n\r\n   Value\r\n0  a\r\n");
+
+		AddTime = WaitForProbeRowCount( ResMan, Events, ProbeName, 1, Start );
+
+		QueryPerformanceCounter( &Start );
+
+		WriteProbeFile(
+			ProbeFile,
+			"2DA V2.0\r\n\r\n   Value\r\n0  a\r\n1  b\r\n");
+
+		ModifyTime = WaitForProbeRowCount( ResMan, Events, ProbeName, 2, Start );
+
+		QueryPerformanceCounter( &Start );
+
+		if (!DeleteFileA( ProbeFile.c_str( ) ))
+			throw std::runtime_error( "Failed to delete probe file." );
+
+		RemoveTime = WaitForProbeRowCount( ResMan, Events, ProbeName, 0, Start );
+	}
+	catch (...)
+	{
+		DeleteFileA( ProbeFile.c_str( ) );
+		throw;
+	}
+
+	TextOut->WriteText(
+		"Override change time-to-visible: add %I64u us, modify %I64u us, remove %I64u us.\n",
+		AddTime,
+		ModifyTime,
+		RemoveTime);
+}
+
 int
 __cdecl
 main(
@@ -306,9 +1154,16 @@ Environment:
 
 --*/
 {
-	const char * ModuleName;
-	const char * NWN2Home;
-	const char * InstallDir;
+	const char                   * ModuleName;
+	const char                   * NWN2Home;
+	const char                   * InstallDir;
+	bool                           BenchmarkLoad;
+	bool                           BenchmarkPrefetch;
+	bool                           BenchmarkWatch;
+	bool                           IoStats;
+	const char                   * CacheDirectory;
+	const char                   * IoTraceFile;
+	std::vector< NWN::ResRef32 >   AreaResRefs;
 
 	//
 	// First, check that we've got the necessary arguments.
@@ -317,7 +1172,7 @@ Environment:
 	if (argc < 4)
 	{
 		wprintf(
-			L"Usage: %S <module> <nwn2 home directory> <nwn2 install directory>\n",
+			L"Usage: %S <module> <nwn2 home directory> <nwn2 install directory> [-loadtrx [walkmesh cache directory]] [-prefetchgit] [-watchdir] [-iostats] [-iotrace <trace file>]\n",
 			argv[ 0 ] );
 
 		return 0;
@@ -327,12 +1182,68 @@ Environment:
 	NWN2Home   = argv[ 2 ];
 	InstallDir = argv[ 3 ];
 
+	BenchmarkLoad     = false;
+	BenchmarkPrefetch = false;
+	BenchmarkWatch    = false;
+	IoStats           = false;
+	CacheDirectory    = NULL;
+	IoTraceFile       = NULL;
+
+	for (int i = 4; i < argc; i += 1)
+	{
+		if (!_stricmp( argv[ i ], "-loadtrx" ))
+		{
+			BenchmarkLoad = true;
+
+			if ((i + 1 < argc) && (argv[ i + 1 ][ 0 ] != '-'))
+				CacheDirectory = argv[ ++i ];
+		}
+		else if (!_stricmp( argv[ i ], "-prefetchgit" ))
+		{
+			BenchmarkPrefetch = true;
+		}
+		else if (!_stricmp( argv[ i ], "-watchdir" ))
+		{
+			BenchmarkWatch = true;
+		}
+		else if (!_stricmp( argv[ i ], "-iostats" ))
+		{
+			IoStats = true;
+		}
+		else if ((!_stricmp( argv[ i ], "-iotrace" )) && (i + 1 < argc))
+		{
+			IoTraceFile = argv[ ++i ];
+		}
+	}
+
 	//
 	// Now spin up a resource manager instance.
 	//
 
-	PrintfTextOut   TextOut;
-	ResourceManager ResMan( &TextOut );
+	PrintfTextOut                     TextOut;
+	ResourceManager                   ResMan( &TextOut );
+	ResourceManager::ModuleLoadParams LoadParams;
+
+	ZeroMemory( &LoadParams, sizeof( LoadParams ) );
+
+	//
+	// The directory watch benchmark needs the resource directories to be
+	// watched for changes.
+	//
+
+	if (BenchmarkWatch)
+		LoadParams.ResManFlags = ResourceManager::ResManFlagWatchDirectories;
+
+	//
+	// Collect resource I/O statistics (and trace events) from the start of
+	// the module load if we were asked to.
+	//
+
+	if ((IoStats) || (IoTraceFile != NULL))
+	{
+		ResMan.GetStatistics( ).SetEnabled( true );
+		ResMan.GetStatistics( ).SetTraceEnabled( IoTraceFile != NULL );
+	}
 
 	try
 	{
@@ -351,7 +1262,8 @@ Environment:
 			"",
 			NWN2Home,
 			InstallDir,
-			std::vector< NWN::ResRef32 >( )
+			std::vector< NWN::ResRef32 >( ),
+			&LoadParams
 			);
 
 		//
@@ -387,7 +1299,32 @@ Environment:
 			//
 
 			ShowAreaInformation( AreaResRef, ResMan, &TextOut );
+
+			AreaResRefs.push_back( AreaResRef );
 		}
+
+		//
+		// If requested, time the loading of the area walkmesh data.
+		//
+
+		if (BenchmarkLoad)
+			BenchmarkAreaLoading( AreaResRefs, ResMan, &TextOut, CacheDirectory );
+
+		//
+		// If requested, time the prefetching of the resources referenced by
+		// the area instance data.
+		//
+
+		if ((BenchmarkPrefetch) && (!AreaResRefs.empty( )))
+			BenchmarkGitPrefetch( AreaResRefs, ResMan, &TextOut );
+
+		//
+		// If requested, time how long override directory changes take to
+		// become visible.
+		//
+
+		if (BenchmarkWatch)
+			BenchmarkDirectoryWatch( ResMan, NWN2Home, &TextOut );
 	}
 	catch (std::exception &e)
 	{
@@ -399,6 +1336,34 @@ Environment:
 		TextOut.WriteText( "ERROR: Exception '%s'.\n", e.what( ) );
 	}
 
+	//
+	// Report resource I/O statistics if they were collected.
+	//
+
+	if (IoStats)
+	{
+		TextOut.WriteText( "Resource I/O statistics:\n" );
+		ResMan.GetStatistics( ).WriteReport( &TextOut );
+	}
+
+	if (IoTraceFile != NULL)
+	{
+		try
+		{
+			ResMan.GetStatistics( ).WriteChromeTrace( IoTraceFile );
+
+			TextOut.WriteText(
+				"Wrote resource I/O trace to %s.\n",
+				IoTraceFile);
+		}
+		catch (std::exception &e)
+		{
+			TextOut.WriteText(
+				"ERROR: Failed to write resource I/O trace: '%s'.\n",
+				e.what( ));
+		}
+	}
+
 	//
 	// All done.
 	//
@@ -16,6 +16,12 @@ Abstract:
 #include "Precomp.h"
 #include "../NWN2DataLib/TextOut.h"
 #include "../NWN2DataLib/ResourceManager.h"
+#include "../NWN2DataLib/TrxFileReader.h"
+
+#define STRICTZIPUNZIP
+#include "../zlib/zlib.h"
+#define _ZLIB_H // unzip.h mistakenly assumes _ZLIB_H instead of ZLIB_H
+#include "../zlib/contrib/minizip/unzip.h"
 
 //
 // Define the debug text output interface, used to write debug or log messages
@@ -244,28 +250,87 @@ Environment:
 		);
 }
 
-int
-__cdecl
-main(
-	nwn2dev__in int argc,
-	__in_ecount( argc ) const char * * argv
+ULONGLONG
+QueryElapsedMicroseconds(
+	nwn2dev__in const LARGE_INTEGER & Start
 	)
 /*++
 
 Routine Description:
 
-	This routine is the entry point symbol for the module model lister
-	program.
+	This routine returns the time elapsed since a performance counter sample
+	was taken.
 
 Arguments:
 
-	argc - Supplies the count of command line arguments.
+	Start - Supplies the starting performance counter sample.
 
-	argv - Supplies the command line argument vector.
+Return Value:
+
+	The routine returns the elapsed time, in microseconds.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	LARGE_INTEGER Now;
+	LARGE_INTEGER Frequency;
+
+	QueryPerformanceCounter( &Now );
+	QueryPerformanceFrequency( &Frequency );
+
+	if (Frequency.QuadPart == 0)
+		return 0;
+
+	return (ULONGLONG) (Now.QuadPart - Start.QuadPart) * 1000000 /
+		(ULONGLONG) Frequency.QuadPart;
+}
+
+//
+// Define a random member read used by the zip benchmark.  The read offset and
+// length are expressed as fractions of the member size (out of 65536), so the
+// same read list may be replayed against either reader.
+//
+
+struct ZIP_BENCHMARK_READ
+{
+	size_t        MemberIndex;
+	unsigned long OffsetFraction;
+	unsigned long LengthFraction;
+};
+
+typedef std::vector< ZIP_BENCHMARK_READ > ZipBenchmarkReadVec;
+
+void
+ComputeBenchmarkRange(
+	nwn2dev__in const ZIP_BENCHMARK_READ & Read,
+	nwn2dev__in size_t MemberSize,
+	nwn2dev__out size_t & Offset,
+	nwn2dev__out size_t & Length
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the byte range of a member that a benchmark read
+	covers.
+
+Arguments:
+
+	Read - Supplies the benchmark read.
+
+	MemberSize - Supplies the size of the member.
+
+	Offset - Receives the offset of the read.
+
+	Length - Receives the length of the read, which is at least one byte for a
+	         non-empty member.
 
 Return Value:
 
-	The routine returns the process exit code.
+	None.
 
 Environment:
 
@@ -273,89 +338,1337 @@ Environment:
 
 --*/
 {
-	const char               * ModuleName;
-	const char               * NWN2Home;
-	const char               * InstallDir;
-	std::set< std::string >    ModuleModels;
+	Offset = (size_t) (((ULONGLONG) MemberSize * Read.OffsetFraction) >> 16);
+	Length = (size_t) (((ULONGLONG) (MemberSize - Offset) * Read.LengthFraction) >> 16);
 
-	//
-	// First, check that we've got the necessary arguments.
-	//
+	if ((Length == 0) && (Offset < MemberSize))
+		Length = 1;
+}
 
-	if (argc < 4)
+ULONGLONG
+BenchmarkZipFileReader(
+	nwn2dev__in ZipFileReader32 & Reader,
+	nwn2dev__in const ZipBenchmarkReadVec & Reads
+	)
+/*++
+
+Routine Description:
+
+	This routine replays a list of random member reads against the zip file
+	reader.
+
+Arguments:
+
+	Reader - Supplies the zip file reader to read from.
+
+	Reads - Supplies the reads to issue.
+
+Return Value:
+
+	The routine returns the elapsed time, in microseconds.  An std::exception
+	is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< unsigned char > Buffer;
+	LARGE_INTEGER                Start;
+
+	QueryPerformanceCounter( &Start );
+
+	for (ZipBenchmarkReadVec::const_iterator it = Reads.begin( );
+	     it != Reads.end( );
+	     ++it)
 	{
-		wprintf(
-			L"Usage: %S <module> <nwn2 home directory> <nwn2 install directory>\n",
-			argv[ 0 ] );
+		FileHandle Handle;
+		size_t     Offset;
+		size_t     Length;
+		size_t     Read;
 
-		return 0;
+		Handle = Reader.OpenFileByIndex( it->MemberIndex );
+
+		if (Handle == INVALID_FILE)
+			throw std::runtime_error( "OpenFileByIndex failed." );
+
+		ComputeBenchmarkRange(
+			*it,
+			Reader.GetEncapsulatedFileSize( Handle ),
+			Offset,
+			Length);
+
+		if (Length != 0)
+		{
+			if (Buffer.size( ) < Length)
+				Buffer.resize( Length );
+
+			if ((!Reader.ReadEncapsulatedFile(
+				Handle,
+				Offset,
+				Length,
+				&Read,
+				&Buffer[ 0 ] )) || (Read != Length))
+			{
+				Reader.CloseFile( Handle );
+				throw std::runtime_error( "ReadEncapsulatedFile failed." );
+			}
+		}
+
+		Reader.CloseFile( Handle );
 	}
 
-	ModuleName = argv[ 1 ];
-	NWN2Home   = argv[ 2 ];
-	InstallDir = argv[ 3 ];
+	return QueryElapsedMicroseconds( Start );
+}
 
-	//
-	// Now spin up a resource manager instance.
-	//
+ULONGLONG
+BenchmarkMinizipReader(
+	nwn2dev__in const char * ArchiveName,
+	nwn2dev__in const ZipBenchmarkReadVec & Reads
+	)
+/*++
 
-	PrintfTextOut   TextOut;
-	ResourceManager ResMan( &TextOut );
+Routine Description:
+
+	This routine replays a list of random member reads with the minizip
+	sequential reader, in the way that the zip file reader formerly serviced
+	them:  seek to the member, open it, and inflate (and discard) data up to
+	the read offset before reading the requested range.
+
+	Members are enumerated in central directory order, skipping directories,
+	which matches the directory indicies of the zip file reader.
+
+Arguments:
+
+	ArchiveName - Supplies the name of the .zip archive to read from.
+
+	Reads - Supplies the reads to issue.
+
+Return Value:
+
+	The routine returns the elapsed time, in microseconds.  An std::exception
+	is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< unz_file_pos >  Members;
+	std::vector< unsigned char > Buffer;
+	unzFile                      Archive;
+	LARGE_INTEGER                Start;
+	char                         FileName[ 260 ];
+	int                          Error;
+
+	Archive = unzOpen( ArchiveName );
+
+	if (Archive == NULL)
+		throw std::runtime_error( "unzOpen failed." );
 
 	try
 	{
-		//
-		// Load the module up all the way, including HAKs.
-		//
+		Error = unzGoToFirstFile2( Archive, FileName, sizeof( FileName ) );
 
-		LoadModule(
-			ResMan,
-			ModuleName,
-			NWN2Home,
-			InstallDir);
+		while (Error == UNZ_OK)
+		{
+			unz_file_pos Pos;
+			size_t       Len;
 
-		//
-		// Now look at each MDB.
-		//
+			FileName[ sizeof( FileName ) - 1 ] = '\0';
+			Len                                = strlen( FileName );
 
-		for (ResourceManager::FileId Id = ResMan.GetEncapsulatedFileCount( );
-		     Id != 0;
-		     Id -= 1)
+			if ((Len != 0) && (FileName[ Len - 1 ] != '/'))
+			{
+				if (unzGetFilePos( Archive, &Pos ) != UNZ_OK)
+					throw std::runtime_error( "unzGetFilePos failed." );
+
+				Members.push_back( Pos );
+			}
+
+			Error = unzGoToNextFile2( Archive, FileName, sizeof( FileName ) );
+		}
+
+		QueryPerformanceCounter( &Start );
+
+		for (ZipBenchmarkReadVec::const_iterator it = Reads.begin( );
+		     it != Reads.end( );
+		     ++it)
 		{
-			NWN::ResRef32 ResRef;
-			NWN::ResType  ResType;
+			unz_file_info FileInfo;
+			size_t        Offset;
+			size_t        Length;
 
-			if (!ResMan.GetEncapsulatedFileEntry( (Id - 1), ResRef, ResType ))
-				continue;
+			if (it->MemberIndex >= Members.size( ))
+				throw std::runtime_error( "Member index out of range." );
 
-			//
-			// Record this MDB uniquely.  We may have multiple references for the
-			// same RESREF if the model is overridden at some level of the
-			// resource hierarchy, i.e. if the model was patched in a later game
-			// patch zip file.
-			//
-			// The first reference we see is the most precedent one, but looking
-			// up by the ResRef and ResType instead of the FileId will always
-			// retrieve the most precedent file.
-			//
-			// N.B.  The resref we receive is guaranteed to be lowercased if a
-			//       well-formed data file set is provided, thus it's not
-			//       necessary to separately lowercase it here.
-			//
+			if ((unzGoToFilePos( Archive, &Members[ it->MemberIndex ] ) != UNZ_OK) ||
+			    (unzGetCurrentFileInfo( Archive, &FileInfo, NULL, 0, NULL, 0, NULL, 0 ) != UNZ_OK) ||
+			    (unzOpenCurrentFile( Archive ) != UNZ_OK))
+			{
+				throw std::runtime_error( "Failed to open member." );
+			}
 
-			ModuleModels.insert( ResMan.StrFromResRef( ResRef ) );
+			ComputeBenchmarkRange(
+				*it,
+				FileInfo.uncompressed_size,
+				Offset,
+				Length);
+
+			Length += Offset;
+
+			if (Buffer.size( ) < Length)
+				Buffer.resize( Length );
+
+			if ((Length != 0) &&
+			    (unzReadCurrentFile( Archive, &Buffer[ 0 ], (unsigned) Length ) != (int) Length))
+			{
+				unzCloseCurrentFile( Archive );
+				throw std::runtime_error( "unzReadCurrentFile failed." );
+			}
+
+			unzCloseCurrentFile( Archive );
 		}
+	}
+	catch (...)
+	{
+		unzClose( Archive );
+		throw;
+	}
 
-		//
-		// Now print out a list of all unique model RESREFS.  Each of these listed
-		// models has a ResType of NWN::ResMDB.
-		//
+	unzClose( Archive );
 
-		for (std::set< std::string >::const_iterator it = ModuleModels.begin( );
-		    it != ModuleModels.end( );
-		    ++it)
-		{
-			TextOut.WriteText( "%s\n", it->c_str( ) );
+	return QueryElapsedMicroseconds( Start );
+}
+
+void
+BenchmarkZipArchive(
+	nwn2dev__in IDebugTextOut & TextOut,
+	nwn2dev__in const char * ArchiveName,
+	__in_opt const char * ExtractDirectory
+	)
+/*++
+
+Routine Description:
+
+	This routine benchmarks random member reads against a .zip archive (such
+	as one of the stock Data/*.zip archives), comparing the zip file reader
+	with the minizip sequential reader.  Optionally, whole-archive extraction
+	is timed both serially and in parallel.
+
+Arguments:
+
+	TextOut - Supplies the text output interface used to report results.
+
+	ArchiveName - Supplies the name of the .zip archive to benchmark.
+
+	ExtractDirectory - Optionally supplies an existing directory to extract
+	                   the archive into.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	enum { NUM_READS = 4096 };
+
+	ZipBenchmarkReadVec Reads;
+	ZipFileReader32     Reader( ArchiveName );
+	ULONG               Seed;
+	LARGE_INTEGER       Start;
+	ULONGLONG           MinizipTime;
+	ULONGLONG           ColdTime;
+	ULONGLONG           WarmTime;
+	ULONGLONG           SerialTime;
+	ULONGLONG           ParallelTime;
+
+	if (Reader.GetEncapsulatedFileCount( ) == 0)
+	{
+		TextOut.WriteText( "Archive %s has no members.\n", ArchiveName );
+		return;
+	}
+
+	//
+	// Generate a reproducible random read list.
+	//
+
+	Seed = 0x4E574E32;
+
+	Reads.resize( NUM_READS );
+
+	for (size_t i = 0; i < Reads.size( ); i += 1)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		Reads[ i ].MemberIndex = (size_t) ((Seed >> 8) % Reader.GetEncapsulatedFileCount( ));
+		Seed = Seed * 1103515245 + 12345;
+		Reads[ i ].OffsetFraction = (Seed >> 8) & 0xFFFF;
+		Seed = Seed * 1103515245 + 12345;
+		Reads[ i ].LengthFraction = (Seed >> 8) & 0xFFFF;
+	}
+
+	MinizipTime = BenchmarkMinizipReader( ArchiveName, Reads );
+	ColdTime    = BenchmarkZipFileReader( Reader, Reads );
+	WarmTime    = BenchmarkZipFileReader( Reader, Reads );
+
+	TextOut.WriteText(
+		"%lu random member reads from %s (%I64u members):\n"
+		"  minizip sequential reader:    %I64u us\n"
+		"  ZipFileReader (cold cache):   %I64u us\n"
+		"  ZipFileReader (warm cache):   %I64u us\n",
+		(unsigned long) Reads.size( ),
+		ArchiveName,
+		(ULONGLONG) Reader.GetEncapsulatedFileCount( ),
+		MinizipTime,
+		ColdTime,
+		WarmTime);
+
+	if (ExtractDirectory == NULL)
+		return;
+
+	QueryPerformanceCounter( &Start );
+	Reader.ExtractAllFiles( ExtractDirectory, false );
+	SerialTime = QueryElapsedMicroseconds( Start );
+
+	QueryPerformanceCounter( &Start );
+	Reader.ExtractAllFiles( ExtractDirectory, true );
+	ParallelTime = QueryElapsedMicroseconds( Start );
+
+	TextOut.WriteText(
+		"Whole-archive extraction to %s:\n"
+		"  serial:                       %I64u us\n"
+		"  parallel:                     %I64u us\n",
+		ExtractDirectory,
+		SerialTime,
+		ParallelTime);
+}
+
+ULONG
+ChecksumBuffer(
+	__in_bcount( Length ) const unsigned char * Data,
+	nwn2dev__in size_t Length
+	)
+/*++
+
+Routine Description:
+
+	This routine computes a trivial checksum over a buffer, so that benchmark
+	runs touch every byte of the data that they read.
+
+Arguments:
+
+	Data - Supplies the data to checksum.
+
+	Length - Supplies the length of the data, in bytes.
+
+Return Value:
+
+	The routine returns the checksum.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ULONG Sum;
+
+	Sum = 0;
+
+	for (size_t i = 0; i < Length; i += 1)
+		Sum = (Sum << 1 | Sum >> 31) ^ Data[ i ];
+
+	return Sum;
+}
+
+void
+BenchmarkKeyFile(
+	nwn2dev__in IDebugTextOut & TextOut,
+	nwn2dev__in const char * KeyFileName,
+	nwn2dev__in const char * InstallDir
+	)
+/*++
+
+Routine Description:
+
+	This routine benchmarks reading every resource attached to a KEY file
+	(such as the stock data/*.key files), comparing the copying read path
+	(ReadEncapsulatedFile) with the zero-copy mapped view path.
+
+Arguments:
+
+	TextOut - Supplies the text output interface used to report results.
+
+	KeyFileName - Supplies the name of the .key file to benchmark.
+
+	InstallDir - Supplies the installation directory that BIF paths within
+	             the KEY file are relative to.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	KeyFileReader16              Reader( KeyFileName, InstallDir );
+	std::vector< unsigned char > Buffer;
+	LARGE_INTEGER                Start;
+	ULONGLONG                    TotalBytes;
+	ULONGLONG                    CopyTime;
+	ULONGLONG                    ViewTime;
+	ULONG                        CopySum;
+	ULONG                        ViewSum;
+	bool                         Mapped;
+
+	//
+	// Time the copying read path first.  This also faults in the BIF data, so
+	// that both paths are timed against a warm file cache.
+	//
+
+	TotalBytes = 0;
+	CopySum    = 0;
+
+	QueryPerformanceCounter( &Start );
+
+	for (FileId i = 0;
+	     i < Reader.GetEncapsulatedFileCount( );
+	     i += 1)
+	{
+		FileHandle Handle;
+		size_t     Size;
+		size_t     Read;
+
+		Handle = Reader.OpenFileByIndex( i );
+
+		if (Handle == INVALID_FILE)
+			continue;
+
+		Size = Reader.GetEncapsulatedFileSize( Handle );
+
+		if (Buffer.size( ) < Size)
+			Buffer.resize( Size );
+
+		if ((Size != 0) &&
+		    (!Reader.ReadEncapsulatedFile( Handle, 0, Size, &Read, &Buffer[ 0 ] ) ||
+		     (Read != Size)))
+		{
+			Reader.CloseFile( Handle );
+			throw std::runtime_error( "ReadEncapsulatedFile failed." );
+		}
+
+		if (Size != 0)
+			CopySum ^= ChecksumBuffer( &Buffer[ 0 ], Size );
+
+		TotalBytes += Size;
+
+		Reader.CloseFile( Handle );
+	}
+
+	CopyTime = QueryElapsedMicroseconds( Start );
+
+	//
+	// Now time the zero-copy path, consuming each resource through a file
+	// wrapper over its view, as the resource loaders do.
+	//
+
+	ViewSum = 0;
+	Mapped  = true;
+
+	QueryPerformanceCounter( &Start );
+
+	for (FileId i = 0;
+	     i < Reader.GetEncapsulatedFileCount( );
+	     i += 1)
+	{
+		FileHandle            Handle;
+		const unsigned char * View;
+		size_t                ViewSize;
+		FileWrapper           Wrapper;
+
+		Handle = Reader.OpenFileByIndex( i );
+
+		if (Handle == INVALID_FILE)
+			continue;
+
+		Reader.PrefetchEncapsulatedFile( Handle );
+
+		if (!Reader.GetEncapsulatedFileView( Handle, &View, &ViewSize ))
+		{
+			Reader.CloseFile( Handle );
+			Mapped = false;
+			break;
+		}
+
+		Wrapper.SetExternalView( View, ViewSize );
+
+		if (ViewSize != 0)
+			ViewSum ^= ChecksumBuffer( Wrapper.ReadFileView( ViewSize, "Resource" ), ViewSize );
+
+		Reader.CloseFile( Handle );
+	}
+
+	ViewTime = QueryElapsedMicroseconds( Start );
+
+	if (!Mapped)
+	{
+		TextOut.WriteText(
+			"BIF files for %s are not mapped; zero-copy views are unavailable.\n",
+			KeyFileName);
+		return;
+	}
+
+	if (CopySum != ViewSum)
+		throw std::runtime_error( "Copied and viewed resource contents differ." );
+
+	TextOut.WriteText(
+		"Read %I64u bytes in %lu resources from %s:\n"
+		"  ReadEncapsulatedFile (copy):  %I64u us (%I64u MB/s)\n"
+		"  GetEncapsulatedFileView:      %I64u us (%I64u MB/s)\n",
+		TotalBytes,
+		(unsigned long) Reader.GetEncapsulatedFileCount( ),
+		KeyFileName,
+		CopyTime,
+		CopyTime ? TotalBytes / CopyTime : 0,
+		ViewTime,
+		ViewTime ? TotalBytes / ViewTime : 0);
+}
+
+//
+// Define the shared state of the resource manager stress test.  Each thread
+// replays the same workload against the resource manager and checks every
+// result against reference values computed by a single thread beforehand.
+//
+
+struct RESMAN_STRESS_CONTEXT
+{
+	ResourceManager                  * ResMan;
+	std::vector< NWN::ResRef32 >       Models;
+	std::vector< ULONG >               ModelChecksums;
+	std::vector< std::string >         TwoDAValues;
+	std::vector< std::string >         TalkStrings;
+	ULONG                              Iterations;
+	volatile LONG                      Failures;
+};
+
+enum
+{
+	RESMAN_STRESS_ROWS = 64
+};
+
+ULONG
+ReadResourceChecksum(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	nwn2dev__in NWN::ResType Type,
+	__inout std::vector< unsigned char > & Buffer
+	)
+/*++
+
+Routine Description:
+
+	This routine reads a resource in full via the resource manager's file
+	handle interface and returns a checksum of its contents.
+
+Arguments:
+
+	ResMan - Supplies the resource manager to read from.
+
+	ResRef - Supplies the name of the resource.
+
+	Type - Supplies the type of the resource.
+
+	Buffer - Supplies a scratch buffer for the resource contents.
+
+Return Value:
+
+	The routine returns the checksum.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FileHandle Handle;
+	size_t     Size;
+	size_t     Read;
+	ULONG      Sum;
+
+	Handle = ResMan.OpenFile( ResRef, Type );
+
+	if (Handle == INVALID_FILE)
+		throw std::runtime_error( "OpenFile failed." );
+
+	Size = ResMan.GetEncapsulatedFileSize( Handle );
+
+	if (Buffer.size( ) < Size)
+		Buffer.resize( Size );
+
+	if ((Size != 0) &&
+	    (!ResMan.ReadEncapsulatedFile( Handle, 0, Size, &Read, &Buffer[ 0 ] ) ||
+	     (Read != Size)))
+	{
+		ResMan.CloseFile( Handle );
+		throw std::runtime_error( "ReadEncapsulatedFile failed." );
+	}
+
+	Sum = (Size != 0) ? ChecksumBuffer( &Buffer[ 0 ], Size ) : 0;
+
+	ResMan.CloseFile( Handle );
+
+	return Sum;
+}
+
+DWORD
+WINAPI
+ResManStressThreadProc(
+	nwn2dev__in LPVOID Parameter
+	)
+/*++
+
+Routine Description:
+
+	This routine is the thread procedure of the resource manager stress test.
+	It reads every model through a file handle, demands and releases each
+	model, and queries 2DA and talk table strings, checking each result.
+
+Arguments:
+
+	Parameter - Supplies the RESMAN_STRESS_CONTEXT.
+
+Return Value:
+
+	The routine always returns zero.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	RESMAN_STRESS_CONTEXT        * Context = (RESMAN_STRESS_CONTEXT *) Parameter;
+	ResourceManager              & ResMan  = *Context->ResMan;
+	std::vector< unsigned char >   Buffer;
+	std::string                    Value;
+
+	for (ULONG Iteration = 0; Iteration < Context->Iterations; Iteration += 1)
+	{
+		for (size_t i = 0; i < Context->Models.size( ); i += 1)
+		{
+			try
+			{
+				if (ReadResourceChecksum(
+					ResMan,
+					Context->Models[ i ],
+					NWN::ResMDB,
+					Buffer) != Context->ModelChecksums[ i ])
+				{
+					InterlockedIncrement( &Context->Failures );
+				}
+
+				DemandResource32 Demanded( ResMan, Context->Models[ i ], NWN::ResMDB );
+
+				if (Demanded.GetDemandedFileName( ).empty( ))
+					InterlockedIncrement( &Context->Failures );
+			}
+			catch (std::exception)
+			{
+				InterlockedIncrement( &Context->Failures );
+			}
+		}
+
+		for (size_t i = 0; i < RESMAN_STRESS_ROWS; i += 1)
+		{
+			if (!ResMan.Get2DAString( "appearance", "LABEL", i, Value ))
+				Value.clear( );
+
+			if (Value != Context->TwoDAValues[ i ])
+				InterlockedIncrement( &Context->Failures );
+
+			if (!ResMan.GetTalkString( (ULONG) i, Value ))
+				Value.clear( );
+
+			if (Value != Context->TalkStrings[ i ])
+				InterlockedIncrement( &Context->Failures );
+		}
+	}
+
+	return 0;
+}
+
+void
+BenchmarkResourceManager(
+	nwn2dev__in IDebugTextOut & TextOut,
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in const std::set< std::string > & Models,
+	nwn2dev__in ULONG MaxThreads
+	)
+/*++
+
+Routine Description:
+
+	This routine stress tests concurrent use of the resource manager, and
+	reports how throughput scales from one thread up to MaxThreads threads.
+
+Arguments:
+
+	TextOut - Supplies the text output interface used to report results.
+
+	ResMan - Supplies the resource manager, with a module loaded.
+
+	Models - Supplies the names of the models in the module.
+
+	MaxThreads - Supplies the maximum count of threads to run.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	RESMAN_STRESS_CONTEXT          Context;
+	std::vector< unsigned char >   Buffer;
+	std::vector< HANDLE >          Threads;
+	std::string                    Value;
+	LARGE_INTEGER                  Start;
+	ULONGLONG                      Elapsed;
+	ULONGLONG                      BaseElapsed;
+
+	if (MaxThreads < 1)
+		MaxThreads = 1;
+
+	if (MaxThreads > MAXIMUM_WAIT_OBJECTS)
+		MaxThreads = MAXIMUM_WAIT_OBJECTS;
+
+	//
+	// Compute the reference results single-threaded.
+	//
+
+	Context.ResMan     = &ResMan;
+	Context.Iterations = 4;
+	Context.Failures   = 0;
+
+	for (std::set< std::string >::const_iterator it = Models.begin( );
+	     it != Models.end( );
+	     ++it)
+	{
+		NWN::ResRef32 ResRef = ResMan.ResRef32FromStr( *it );
+
+		Context.Models.push_back( ResRef );
+		Context.ModelChecksums.push_back(
+			ReadResourceChecksum( ResMan, ResRef, NWN::ResMDB, Buffer ) );
+	}
+
+	for (size_t i = 0; i < RESMAN_STRESS_ROWS; i += 1)
+	{
+		if (!ResMan.Get2DAString( "appearance", "LABEL", i, Value ))
+			Value.clear( );
+
+		Context.TwoDAValues.push_back( Value );
+
+		if (!ResMan.GetTalkString( (ULONG) i, Value ))
+			Value.clear( );
+
+		Context.TalkStrings.push_back( Value );
+	}
+
+	//
+	// Now run the workload with doubling thread counts.  Each thread runs the
+	// whole workload, so perfect scaling keeps the elapsed time constant.
+	//
+
+	BaseElapsed = 0;
+
+	for (ULONG ThreadCount = 1; ThreadCount <= MaxThreads; ThreadCount *= 2)
+	{
+		Threads.clear( );
+
+		QueryPerformanceCounter( &Start );
+
+		for (ULONG i = 0; i < ThreadCount; i += 1)
+		{
+			HANDLE Thread;
+
+			Thread = CreateThread(
+				NULL,
+				0,
+				ResManStressThreadProc,
+				&Context,
+				0,
+				NULL);
+
+			if (Thread == NULL)
+				break;
+
+			Threads.push_back( Thread );
+		}
+
+		if (!Threads.empty( ))
+		{
+			WaitForMultipleObjects(
+				(DWORD) Threads.size( ),
+				&Threads[ 0 ],
+				TRUE,
+				INFINITE);
+		}
+
+		Elapsed = QueryElapsedMicroseconds( Start );
+
+		for (size_t i = 0; i < Threads.size( ); i += 1)
+			CloseHandle( Threads[ i ] );
+
+		if (Threads.size( ) != ThreadCount)
+			throw std::runtime_error( "Failed to create stress test thread." );
+
+		if (ThreadCount == 1)
+			BaseElapsed = Elapsed;
+
+		TextOut.WriteText(
+			"ResourceManager stress test, %lu threads: %I64u us (%I64u%% scaling efficiency)\n",
+			ThreadCount,
+			Elapsed,
+			Elapsed ? (BaseElapsed * 100) / Elapsed : 0);
+	}
+
+	if (Context.Failures != 0)
+	{
+		TextOut.WriteText(
+			"ResourceManager stress test FAILED: %ld mismatched results.\n",
+			Context.Failures);
+
+		throw std::runtime_error( "ResourceManager stress test failed." );
+	}
+
+	TextOut.WriteText( "ResourceManager stress test passed.\n" );
+}
+
+//
+// Define the per-policy results of the mesh storage benchmark.
+//
+
+struct MESH_STORAGE_BENCHMARK
+{
+	ULONGLONG    Bytes;
+	ULONGLONG    LoadTime;
+	ULONGLONG    TransformTime;
+	ULONGLONG    BoundsTime;
+	NWN::Vector3 MinBound;
+	NWN::Vector3 MaxBound;
+};
+
+template< typename StorageT >
+void
+BenchmarkMeshStoragePolicy(
+	nwn2dev__in const std::vector< const CollisionMesh * > & Meshes,
+	nwn2dev__in const NWN::Matrix44 & Transform,
+	nwn2dev__in ULONG Iterations,
+	nwn2dev__out MESH_STORAGE_BENCHMARK & Results
+	)
+/*++
+
+Routine Description:
+
+	This routine copies the vertices of a set of collision meshes into a given
+	vertex storage policy, and then measures a world transformation pass and a
+	bounding box pass over the copies.  Interleaved storage is processed with
+	the strided batch math routines, stream storage with the packed (aligned)
+	routines.
+
+Arguments:
+
+	Meshes - Supplies the meshes whose vertices are to be copied.
+
+	Transform - Supplies the world transformation to apply.
+
+	Iterations - Supplies the count of times to run each pass.
+
+	Results - Receives the allocation size, the timings and the bounds.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typedef std::vector< StorageT > StorageVec;
+
+	StorageVec    Storage;
+	LARGE_INTEGER Start;
+
+	Results.Bytes      = 0;
+	Results.MinBound.x = +FLT_MAX;
+	Results.MinBound.y = +FLT_MAX;
+	Results.MinBound.z = +FLT_MAX;
+	Results.MaxBound.x = -FLT_MAX;
+	Results.MaxBound.y = -FLT_MAX;
+	Results.MaxBound.z = -FLT_MAX;
+
+	//
+	// Load the vertices into the storage policy.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	Storage.resize( Meshes.size( ) );
+
+	for (size_t i = 0; i < Meshes.size( ); i += 1)
+	{
+		const CollisionMesh::VertexVec & Points = Meshes[ i ]->GetPoints( );
+
+		Storage[ i ].reserve( Points.size( ) );
+
+		for (size_t j = 0; j < Points.size( ); j += 1)
+			Storage[ i ].push_back( Points[ j ] );
+	}
+
+	Results.LoadTime = QueryElapsedMicroseconds( Start );
+
+	for (size_t i = 0; i < Storage.size( ); i += 1)
+		Results.Bytes += Storage[ i ].GetAllocatedBytes( );
+
+	//
+	// Transform each mesh from local to world space.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (ULONG Iteration = 0; Iteration < Iterations; Iteration += 1)
+	{
+		for (size_t i = 0; i < Storage.size( ); i += 1)
+		{
+			const NWN::Vector3 * LocalPos;
+			NWN::Vector3       * Pos;
+			size_t               LocalStride;
+			size_t               Stride;
+
+			LocalPos = Storage[ i ].GetVectorStream( offsetof( CMVertex, LocalPos ), LocalStride );
+			Pos      = Storage[ i ].GetMutableVectorStream( offsetof( CMVertex, Pos ), Stride );
+
+			if ((LocalStride == sizeof( NWN::Vector3 )) && (Stride == sizeof( NWN::Vector3 )))
+			{
+				Math::MultiplyPointsPacked(
+					Transform,
+					LocalPos,
+					Pos,
+					Storage[ i ].size( ));
+			}
+			else
+			{
+				Math::MultiplyPoints(
+					Transform,
+					LocalPos,
+					LocalStride,
+					Pos,
+					Stride,
+					Storage[ i ].size( ));
+			}
+		}
+	}
+
+	Results.TransformTime = QueryElapsedMicroseconds( Start );
+
+	//
+	// Compute the bounds of the world space vertices of all meshes.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (ULONG Iteration = 0; Iteration < Iterations; Iteration += 1)
+	{
+		for (size_t i = 0; i < Storage.size( ); i += 1)
+		{
+			const NWN::Vector3 * Pos;
+			size_t               Stride;
+
+			Pos = Storage[ i ].GetVectorStream( offsetof( CMVertex, Pos ), Stride );
+
+			if (Stride == sizeof( NWN::Vector3 ))
+			{
+				Math::ExtendBoundsPointsPacked(
+					Pos,
+					Storage[ i ].size( ),
+					Results.MinBound,
+					Results.MaxBound);
+			}
+			else
+			{
+				Math::ExtendBoundsPoints(
+					Pos,
+					Stride,
+					Storage[ i ].size( ),
+					Results.MinBound,
+					Results.MaxBound);
+			}
+		}
+	}
+
+	Results.BoundsTime = QueryElapsedMicroseconds( Start );
+}
+
+void
+BenchmarkMeshStorage(
+	nwn2dev__in IDebugTextOut & TextOut,
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in const std::set< std::string > & Models
+	)
+/*++
+
+Routine Description:
+
+	This routine loads the collision meshes of every model in the module and
+	compares the interleaved and stream vertex storage policies: the bytes
+	allocated for the vertices, the time to load the vertices, and the time
+	of a world transformation pass and a bounding box pass.
+
+Arguments:
+
+	TextOut - Supplies the text output interface used to report results.
+
+	ResMan - Supplies the resource manager, with a module loaded.
+
+	Models - Supplies the names of the models in the module.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typedef std::vector< TrxFileReader::Ptr > ModelVec;
+
+	enum { ITERATIONS = 16 };
+
+	ModelVec                             LoadedModels;
+	std::vector< const CollisionMesh * > Meshes;
+	ULONGLONG                            VertexCount;
+	NWN::Matrix44                        Transform;
+	NWN::Vector3                         v;
+	MESH_STORAGE_BENCHMARK               Interleaved;
+	MESH_STORAGE_BENCHMARK               Streams;
+
+	//
+	// Load every model that can be loaded as an MDB.
+	//
+
+	for (std::set< std::string >::const_iterator it = Models.begin( );
+	     it != Models.end( );
+	     ++it)
+	{
+		try
+		{
+			DemandResource32   Res( ResMan, ResMan.ResRef32FromStr( *it ), NWN::ResMDB );
+			TrxFileReader::Ptr MdbObject;
+
+			MdbObject = new TrxFileReader(
+				ResMan.GetMeshManager( ),
+				Res,
+				false,
+				TrxFileReader::ModeMDB,
+				&TextOut);
+
+			LoadedModels.push_back( MdbObject );
+		}
+		catch (std::exception)
+		{
+			continue;
+		}
+	}
+
+	VertexCount = 0;
+
+	for (ModelVec::const_iterator it = LoadedModels.begin( );
+	     it != LoadedModels.end( );
+	     ++it)
+	{
+		const ModelCollider & Collider = (*it)->GetCollider( );
+
+		Meshes.push_back( &Collider.GetC2Mesh( ) );
+		Meshes.push_back( &Collider.GetC3Mesh( ) );
+
+		VertexCount += Collider.GetC2Mesh( ).GetPoints( ).size( );
+		VertexCount += Collider.GetC3Mesh( ).GetPoints( ).size( );
+	}
+
+	//
+	// Use a transformation with a rotation about an oblique axis and a
+	// translation, so that every matrix term takes part.
+	//
+
+	v.x = 1.0f;
+	v.y = 2.0f;
+	v.z = 3.0f;
+
+	Math::CreateRotationAxisMatrix( Transform, v, 0.5f );
+
+	v.x = 10.0f;
+	v.y = 20.0f;
+	v.z = 30.0f;
+
+	Math::SetTranslation( Transform, v );
+
+	BenchmarkMeshStoragePolicy< SimpleMeshInterleavedStorage< CMVertex > >(
+		Meshes,
+		Transform,
+		ITERATIONS,
+		Interleaved);
+
+	BenchmarkMeshStoragePolicy< SimpleMeshStreamStorage< CMVertex > >(
+		Meshes,
+		Transform,
+		ITERATIONS,
+		Streams);
+
+	TextOut.WriteText(
+		"Mesh storage benchmark: %lu models, %lu collision meshes, %I64u vertices, %lu passes.\n",
+		(ULONG) LoadedModels.size( ),
+		(ULONG) Meshes.size( ),
+		VertexCount,
+		(ULONG) ITERATIONS);
+
+	TextOut.WriteText(
+		"Interleaved: %I64u bytes, load %I64u us, transform %I64u us, bounds %I64u us\n",
+		Interleaved.Bytes,
+		Interleaved.LoadTime,
+		Interleaved.TransformTime,
+		Interleaved.BoundsTime);
+
+	TextOut.WriteText(
+		"Streams:     %I64u bytes, load %I64u us, transform %I64u us, bounds %I64u us\n",
+		Streams.Bytes,
+		Streams.LoadTime,
+		Streams.TransformTime,
+		Streams.BoundsTime);
+
+	if ((Interleaved.MinBound.x != Streams.MinBound.x) ||
+	    (Interleaved.MinBound.y != Streams.MinBound.y) ||
+	    (Interleaved.MinBound.z != Streams.MinBound.z) ||
+	    (Interleaved.MaxBound.x != Streams.MaxBound.x) ||
+	    (Interleaved.MaxBound.y != Streams.MaxBound.y) ||
+	    (Interleaved.MaxBound.z != Streams.MaxBound.z))
+	{
+		TextOut.WriteText(
+			"Mesh storage benchmark FAILED: the storage policies computed different bounds.\n");
+	}
+}
+
+int
+__cdecl
+main(
+	nwn2dev__in int argc,
+	__in_ecount( argc ) const char * * argv
+	)
+/*++
+
+Routine Description:
+
+	This routine is the entry point symbol for the module model lister
+	program.
+
+Arguments:
+
+	argc - Supplies the count of command line arguments.
+
+	argv - Supplies the command line argument vector.
+
+Return Value:
+
+	The routine returns the process exit code.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const char               * ModuleName;
+	const char               * NWN2Home;
+	const char               * InstallDir;
+	const char               * BenchmarkArchive;
+	const char               * ExtractDirectory;
+	const char               * BenchmarkKey;
+	ULONG                      StressThreads;
+	bool                       BenchmarkMeshes;
+	std::set< std::string >    ModuleModels;
+
+	//
+	// First, check that we've got the necessary arguments.
+	//
+
+	if (argc < 4)
+	{
+		wprintf(
+			L"Usage: %S <module> <nwn2 home directory> <nwn2 install directory> [-benchzip <archive> [extract directory]] [-benchkey <key file>] [-stressresman <max threads>] [-benchmeshes]\n",
+			argv[ 0 ] );
+
+		return 0;
+	}
+
+	ModuleName = argv[ 1 ];
+	NWN2Home   = argv[ 2 ];
+	InstallDir = argv[ 3 ];
+
+	BenchmarkArchive = NULL;
+	ExtractDirectory = NULL;
+	BenchmarkKey     = NULL;
+	StressThreads    = 0;
+	BenchmarkMeshes  = false;
+
+	for (int i = 4; i < argc; i += 1)
+	{
+		if ((!_stricmp( argv[ i ], "-benchzip" )) && (i + 1 < argc))
+		{
+			BenchmarkArchive = argv[ ++i ];
+
+			if ((i + 1 < argc) && (argv[ i + 1 ][ 0 ] != '-'))
+				ExtractDirectory = argv[ ++i ];
+		}
+		else if ((!_stricmp( argv[ i ], "-benchkey" )) && (i + 1 < argc))
+		{
+			BenchmarkKey = argv[ ++i ];
+		}
+		else if ((!_stricmp( argv[ i ], "-stressresman" )) && (i + 1 < argc))
+		{
+			StressThreads = (ULONG) strtoul( argv[ ++i ], NULL, 10 );
+		}
+		else if (!_stricmp( argv[ i ], "-benchmeshes" ))
+		{
+			BenchmarkMeshes = true;
+		}
+	}
+
+	//
+	// Now spin up a resource manager instance.
+	//
+
+	PrintfTextOut   TextOut;
+	ResourceManager ResMan( &TextOut );
+
+	try
+	{
+		//
+		// Load the module up all the way, including HAKs.
+		//
+
+		LoadModule(
+			ResMan,
+			ModuleName,
+			NWN2Home,
+			InstallDir);
+
+		//
+		// Now look at each MDB.
+		//
+
+		for (ResourceManager::FileId Id = ResMan.GetEncapsulatedFileCount( );
+		     Id != 0;
+		     Id -= 1)
+		{
+			NWN::ResRef32 ResRef;
+			NWN::ResType  ResType;
+
+			if (!ResMan.GetEncapsulatedFileEntry( (Id - 1), ResRef, ResType ))
+				continue;
+
+			//
+			// Record this MDB uniquely.  We may have multiple references for the
+			// same RESREF if the model is overridden at some level of the
+			// resource hierarchy, i.e. if the model was patched in a later game
+			// patch zip file.
+			//
+			// The first reference we see is the most precedent one, but looking
+			// up by the ResRef and ResType instead of the FileId will always
+			// retrieve the most precedent file.
+			//
+			// N.B.  The resref we receive is guaranteed to be lowercased if a
+			//       well-formed data file set is provided, thus it's not
+			//       necessary to separately lowercase it here.
+			//
+
+			ModuleModels.insert( ResMan.StrFromResRef( ResRef ) );
+		}
+
+		//
+		// Now print out a list of all unique model RESREFS.  Each of these listed
+		// models has a ResType of NWN::ResMDB.
+		//
+
+		for (std::set< std::string >::const_iterator it = ModuleModels.begin( );
+		    it != ModuleModels.end( );
+		    ++it)
+		{
+			TextOut.WriteText( "%s\n", it->c_str( ) );
+		}
+
+		//
+		// Benchmark the zip file reader if we were asked to.
+		//
+
+		if (BenchmarkArchive != NULL)
+		{
+			BenchmarkZipArchive(
+				TextOut,
+				BenchmarkArchive,
+				ExtractDirectory);
+		}
+
+		//
+		// Benchmark the BIF file reader if we were asked to.
+		//
+
+		if (BenchmarkKey != NULL)
+		{
+			BenchmarkKeyFile(
+				TextOut,
+				BenchmarkKey,
+				InstallDir);
+		}
+
+		//
+		// Stress test concurrent use of the resource manager if we were asked
+		// to.
+		//
+
+		if (StressThreads != 0)
+		{
+			BenchmarkResourceManager(
+				TextOut,
+				ResMan,
+				ModuleModels,
+				StressThreads);
+		}
+
+		//
+		// Compare the mesh vertex storage policies if we were asked to.
+		//
+
+		if (BenchmarkMeshes)
+		{
+			BenchmarkMeshStorage(
+				TextOut,
+				ResMan,
+				ModuleModels);
 		}
 	}
 	catch (std::exception &e)
@@ -191,6 +191,62 @@ Environment:
 	WorldObj->SetScale( v );
 }
 
+void
+RunLineOfSightBenchmark(
+	nwn2dev__in WorldView & View,
+	nwn2dev__in unsigned long ObjectCount
+	)
+/*++
+
+Routine Description:
+
+	This routine fills the world with a grid of objects and measures the cost
+	of line of sight, box and view frustum queries against them.  The results
+	are written to the debug console.
+
+Arguments:
+
+	View - Supplies the world view instance.
+
+	ObjectCount - Supplies the count of objects to place.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< std::string > MDBResRefs;
+	unsigned long              GridSize;
+	float                      Spacing;
+
+	MDBResRefs.push_back( "P_HHF_NK_Body01" );
+
+	GridSize = (unsigned long) ceil( sqrt( (double) ObjectCount ) );
+	Spacing  = 100.0f / (float) (GridSize + 1);
+
+	for (unsigned long i = 0; i < ObjectCount; i += 1)
+	{
+		WorldObject::Ptr WorldObj;
+		NWN::Vector3     v;
+
+		WorldObj = View.CreateWorldObject( MDBResRefs, "P_HHF_skel" );
+
+		v.x = Spacing * (float) ((i % GridSize) + 1);
+		v.y = Spacing * (float) ((i / GridSize) + 1);
+		v.z = 0.0f;
+
+		WorldObj->SetPosition( v );
+	}
+
+	View.BenchmarkLineOfSight( 10000 );
+	View.BenchmarkSceneQueries( 10000 );
+}
+
 int
 CALLBACK
 WinMain(
@@ -265,8 +321,31 @@ Environment:
 			std::vector< NWN::ResRef32 >( )
 			);
 
+		//
+		// If requested, load the terrain of an area of the module, so that the
+		// ground takes part in line of sight.
+		//
+
+		if (getenv( "NWN2AREA" ) != NULL)
+			View.LoadAreaTerrain( getenv( "NWN2AREA" ) );
+
 		InitObjects( View );
 
+		//
+		// If requested, measure line of sight performance with the given count
+		// of additional objects placed in the world.
+		//
+
+		if (getenv( "NWN2LOSBENCH" ) != NULL)
+			RunLineOfSightBenchmark( View, strtoul( getenv( "NWN2LOSBENCH" ), NULL, 0 ) );
+
+		//
+		// If requested, report collision mesh transform work for each frame.
+		//
+
+		if (getenv( "NWN2XFORMSTATS" ) != NULL)
+			View.SetReportTransformStatistics( true );
+
 		//
 		// Enter into the standard dispatch loop.
 		//
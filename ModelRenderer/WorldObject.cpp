@@ -56,7 +56,9 @@ Environment:
 --*/
 : m_ResMan( ResMan ),
   m_TextWriter( TextWriter ),
-  m_Facing( PI / 2) // Straight north
+  m_Facing( PI / 2), // Straight north
+  m_Scene( NULL ),
+  m_SceneObject( AreaSceneBVH::INVALID_OBJECT_ID )
 {
 	memcpy(
 		&m_WorldTrans,
@@ -89,6 +91,12 @@ Environment:
 
 		m_ModelParts.push_back( Model );
 	}
+
+	//
+	// Place the colliders at the initial world transformation.
+	//
+
+	OnUpdateWorldTransform( );
 }
 
 WorldObject::~WorldObject(
@@ -402,6 +410,20 @@ Environment:
 
 --*/
 {
+	for (ModelPartVec::iterator it = m_ModelParts.begin( );
+	     it != m_ModelParts.end( );
+	     ++it)
+	{
+		(*it)->Update( m_WorldTrans );
+	}
+
+	//
+	// Only the path from the object's leaf to the root of the scene hierarchy
+	// needs to be refit for the move.
+	//
+
+	if (m_Scene != NULL)
+		m_Scene->UpdateObject( m_SceneObject );
 }
 
 WorldObject::ModelColliderPtr
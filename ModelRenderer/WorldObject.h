@@ -248,6 +248,30 @@ public:
 		return m_Up;
 	}
 
+	//
+	// Scene registration.  Once registered, the object refits its bounds in
+	// the scene hierarchy whenever its world transformation changes.
+	//
+
+	inline
+	void
+	SetSceneObject(
+		__in_opt AreaSceneBVH * Scene,
+		nwn2dev__in AreaSceneBVH::ObjectId SceneObject
+		)
+	{
+		m_Scene       = Scene;
+		m_SceneObject = SceneObject;
+	}
+
+	inline
+	AreaSceneBVH::ObjectId
+	GetSceneObject(
+		) const
+	{
+		return m_SceneObject;
+	}
+
 private:
 
 	typedef swutil::SharedPtr< ModelCollider > ModelColliderPtr;
@@ -343,6 +367,8 @@ private:
 	NWN::Vector3       m_Up;
 	NWN::Vector3       m_Position;
 	NWN::Vector3       m_Scale;
+	AreaSceneBVH     * m_Scene;
+	AreaSceneBVH::ObjectId m_SceneObject;
 };
 
 #endif
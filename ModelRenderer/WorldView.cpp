@@ -82,7 +82,8 @@ Environment:
   m_PaddingX( 0.0f ),
   m_PaddingY( 0.0f ),
   m_CursorX( -1 ),
-  m_CursorY( -1 )
+  m_CursorY( -1 ),
+  m_ReportTransformStatistics( false )
 {
 	POINT pt;
 
@@ -176,11 +177,119 @@ Environment:
 
 	m_WorldObjects.push_back( WorldObj );
 
+	//
+	// The first model part always holds the collision mesh data.
+	//
+
+	if (WorldObj->GetModel( ) != NULL)
+	{
+		WorldObj->SetSceneObject(
+			&m_SceneBVH,
+			m_SceneBVH.AddCollider( WorldObj->GetModel( ), WorldObj.get( ) ));
+	}
+
 	RedrawWorldWindowOnly( false );
 
 	return WorldObj;
 }
 
+void
+WorldView::LoadAreaTerrain(
+	nwn2dev__in const std::string & AreaResRef
+	)
+/*++
+
+Routine Description:
+
+	This routine loads the terrain patches of an area from the area's Trx
+	file and adds each patch to the scene hierarchy, so that line of sight
+	rays and scene queries stop at the ground.
+
+	The area dimensions (and the default camera) are then reset to cover the
+	extents of the terrain.
+
+	The routine implicitly queues a redraw for the next draw cycle.
+
+Arguments:
+
+	AreaResRef - Supplies the resource name of the area whose terrain is to
+	             be loaded.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	TrxFileReader::Ptr TrxObject;
+	DemandResource32   Res( m_ResMan, m_ResMan.ResRef32FromStr( AreaResRef ), NWN::ResTRX );
+	NWN::Vector3       MinBound;
+	NWN::Vector3       MaxBound;
+	float              AreaWidth;
+	float              AreaHeight;
+
+	TrxObject = new TrxFileReader(
+		m_ResMan.GetMeshManager( ),
+		Res,
+		false,
+		TrxFileReader::ModeTRX,
+		m_TextWriter);
+
+	//
+	// Replace the terrain of any previously loaded area.
+	//
+
+	for (AreaSceneBVH::ObjectIdVec::const_iterator it = m_TerrainObjects.begin( );
+	     it != m_TerrainObjects.end( );
+	     ++it)
+	{
+		m_SceneBVH.RemoveObject( *it );
+	}
+
+	m_TerrainObjects.clear( );
+
+	m_AreaTerrain = TrxObject->GetTerrainMesh( );
+
+	AreaWidth  = 0.0f;
+	AreaHeight = 0.0f;
+
+	for (AreaTerrainMeshVec::const_iterator it = m_AreaTerrain.begin( );
+	     it != m_AreaTerrain.end( );
+	     ++it)
+	{
+		AreaSceneBVH::ObjectId Object;
+
+		Object = m_SceneBVH.AddTerrain( *it, NULL );
+
+		if (Object == AreaSceneBVH::INVALID_OBJECT_ID)
+			continue;
+
+		m_TerrainObjects.push_back( Object );
+
+		m_SceneBVH.GetObjectBounds( Object, MinBound, MaxBound );
+
+		AreaWidth  = max( AreaWidth, MaxBound.x );
+		AreaHeight = max( AreaHeight, MaxBound.y );
+	}
+
+	if ((AreaWidth > 0.0f) && (AreaHeight > 0.0f))
+	{
+		m_AreaWidth  = AreaWidth;
+		m_AreaHeight = AreaHeight;
+
+		RecalculateMapRect( &m_ClientRect );
+
+		if (m_Camera.get( ) != NULL)
+			SetDefaultCameraParameters( m_Camera.get( ) );
+	}
+
+	RedrawWorldWindowOnly( false );
+}
+
 WorldView::~WorldView(
 	)
 /*++
@@ -204,6 +313,18 @@ Environment:
 
 --*/
 {
+	//
+	// Objects may be kept alive by the caller past the lifetime of the view,
+	// so detach them from the scene hierarchy that is about to be deleted.
+	//
+
+	for (WorldObjectVec::iterator it = m_WorldObjects.begin( );
+	     it != m_WorldObjects.end( );
+	     ++it)
+	{
+		(*it)->SetSceneObject( NULL, AreaSceneBVH::INVALID_OBJECT_ID );
+	}
+
 	if (m_WorldWindow != NULL)
 		DestroyWindow( m_WorldWindow );
 }
@@ -1545,11 +1666,7 @@ Environment:
 
 --*/
 {
-	bool           Intersected;
-	NWN::Vector3   IntersectNormal;
-	float          IntersectDistance;
-
-	Intersected = false;
+	AreaSceneBVH::RAY_HIT Hit;
 
 	PathDebug(
 		"Check collider LOS from %f, %f, %f\n",
@@ -1558,26 +1675,125 @@ Environment:
 		Origin.z);
 
 	//
-	// Draw a ray starting from the first point, towards the second, and check
-	// for any intersections along the way for all objects in the area.
+	// Objects refit their own leaves in the scene hierarchy as they move, so
+	// the hierarchy is always current here.
+	//
+
+	//
+	// Draw a ray starting from the first point, towards the second, and find
+	// the closest intersection with any object in the area.
 	//
 
+	if (!m_SceneBVH.IntersectRay(
+		Origin,
+		NormDir,
+		FLT_MAX,
+		&Hit))
+	{
+		return false;
+	}
+
+	Distance = Hit.Distance;
+
+	PathDebug(
+		"Intersection found at distance %f (normal %f, %f, %f) with object <%p>\n",
+		Hit.Distance,
+		Hit.Normal.x,
+		Hit.Normal.y,
+		Hit.Normal.z,
+		Hit.Context);
+
+	return true;
+}
+
+void
+WorldView::ReportTransformStatistics(
+	nwn2dev__in const char * Activity
+	)
+/*++
+
+Routine Description:
+
+	This routine writes the collision mesh transform work done since the
+	counters were last reset to the debug text output interface, and then
+	resets the counters.
+
+Arguments:
+
+	Activity - Supplies a description of the work that was measured.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	CollisionMesh::TRANSFORM_STATISTICS Statistics;
+
+	CollisionMesh::GetTransformStatistics( Statistics, true );
+
+	if (m_TextWriter == NULL)
+		return;
+
+	m_TextWriter->WriteText(
+		"%s: %lu collision mesh vertices transformed, %lu deferred transforms resolved, %lu transforms skipped.\n",
+		Activity,
+		Statistics.VerticesTransformed,
+		Statistics.TransformsResolved,
+		Statistics.TransformsSkipped);
+}
+
+bool
+WorldView::CalcLineOfSightRayLinear(
+	nwn2dev__in const NWN::Vector3 & Origin,
+	nwn2dev__in const NWN::Vector3 & NormDir,
+	nwn2dev__out float & Distance
+	)
+/*++
+
+Routine Description:
+
+	This routine calculates whether there exists a clear line of sight from a
+	ray to the edge of the map by testing every object in the area in turn,
+	without the use of the scene hierarchy.  It is retained as a reference
+	for BenchmarkLineOfSight.
+
+Arguments:
+
+	Origin - Supplies the origin point of the ray.
+
+	NormDir - Supplies the normalized direction of the ray.
+
+	Distance - Receives the distance to the intersection point, should the ray
+	           ray intersect with a collider.  The intersection point closest
+	           to the origin of the ray is returned.
+
+Return Value:
+
+	Returns a Boolean value indicating true if a clear line of sight existed,
+	else false if a clear line of sight did not exist.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	bool           Intersected;
+	NWN::Vector3   IntersectNormal;
+	float          IntersectDistance;
+
+	Intersected = false;
+
 	for (WorldObjectVec::const_iterator it = m_WorldObjects.begin( );
 	     it != m_WorldObjects.end( );
 	     ++it)
 	{
-		WorldObject * Object = it->get( );
-
-#if PATH_DEBUG
-		PathDebug(
-			"Check intersect with object <%p> @ %f, %f, %f\n",
-			Object,
-			Object->GetPosition( ).x,
-			Object->GetPosition( ).y,
-			Object->GetPosition( ).z);
-#endif
-
-		if (!Object->IntersectRay(
+		if (!(*it)->IntersectRay(
 			Origin,
 			NormDir,
 			IntersectNormal,
@@ -1586,28 +1802,575 @@ Environment:
 			continue;
 		}
 
-		if (!Intersected)
+		if ((!Intersected) || (IntersectDistance < Distance))
 		{
 			Distance    = IntersectDistance;
 			Intersected = true;
 		}
-		else
+	}
+
+	//
+	// Test the ground as well.  Terrain patches are already in world space.
+	//
+
+	for (AreaTerrainMeshVec::const_iterator it = m_AreaTerrain.begin( );
+	     it != m_AreaTerrain.end( );
+	     ++it)
+	{
+		const AreaTerrainMesh::TerrainVertexVec & Verticies = it->GetTerrainVerticies( );
+		const AreaTerrainMesh::TerrainFaceVec   & Faces     = it->GetTerrainFaces( );
+
+		for (AreaTerrainMesh::TerrainFaceVec::const_iterator fit = Faces.begin( );
+		     fit != Faces.end( );
+		     ++fit)
 		{
-			if (IntersectDistance < Distance)
-				Distance = IntersectDistance;
-		}
+			NWN::Vector3 Tri[ 3 ];
 
-		PathDebug(
-			"Intersection found at distance %f (normal %f, %f, %f)\n",
-			IntersectDistance,
-			IntersectNormal.x,
-			IntersectNormal.y,
-			IntersectNormal.z);
+			Tri[ 0 ] = Verticies[ fit->Vertex[ 0 ] ].p;
+			Tri[ 1 ] = Verticies[ fit->Vertex[ 1 ] ].p;
+			Tri[ 2 ] = Verticies[ fit->Vertex[ 2 ] ].p;
+
+			if (!Math::IntersectRayTri( Origin, NormDir, Tri, IntersectDistance ))
+				continue;
+
+			if ((!Intersected) || (IntersectDistance < Distance))
+			{
+				Distance    = IntersectDistance;
+				Intersected = true;
+			}
+		}
 	}
 
 	return Intersected;
 }
 
+void
+WorldView::BenchmarkLineOfSight(
+	nwn2dev__in unsigned long RayCount
+	)
+/*++
+
+Routine Description:
+
+	This routine measures the cost of line of sight queries against the
+	objects in the area, with and without the scene hierarchy, and the cost of
+	refitting the hierarchy as objects move.  The rays are cast horizontally
+	from pseudo-random points in the area, in pseudo-random directions, with a
+	fixed seed so that runs are comparable.
+
+	Results are written to the debug text output interface.
+
+Arguments:
+
+	RayCount - Supplies the count of rays to cast.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typedef std::vector< NWN::Vector3 > Vector3Vec;
+	typedef std::vector< bool > BoolVec;
+	typedef std::vector< float > FloatVec;
+
+	Vector3Vec                          Origins;
+	Vector3Vec                          Directions;
+	BoolVec                             LinearHits;
+	FloatVec                            LinearDistances;
+	LARGE_INTEGER                       Frequency;
+	LARGE_INTEGER                       Start;
+	LARGE_INTEGER                       End;
+	ULONGLONG                           MoveTime;
+	ULONGLONG                           LinearTime;
+	ULONGLONG                           SceneTime;
+	unsigned long                       Seed;
+	unsigned long                       Hits;
+	unsigned long                       Mismatches;
+	CollisionMesh::TRANSFORM_STATISTICS Statistics;
+
+	if ((RayCount == 0) || (m_TextWriter == NULL))
+		return;
+
+	Origins.resize( RayCount );
+	Directions.resize( RayCount );
+	LinearHits.resize( RayCount );
+	LinearDistances.resize( RayCount );
+
+	Seed = 0x4C4F5321;
+
+	for (unsigned long i = 0; i < RayCount; i += 1)
+	{
+		float Angle;
+
+		Seed = Seed * 1103515245 + 12345;
+		Origins[ i ].x = m_AreaWidth * (float) ((Seed >> 8) & 0xFFFF) / 65536.0f;
+		Seed = Seed * 1103515245 + 12345;
+		Origins[ i ].y = m_AreaHeight * (float) ((Seed >> 8) & 0xFFFF) / 65536.0f;
+		Origins[ i ].z = 1.0f;
+		Seed = Seed * 1103515245 + 12345;
+		Angle = 2.0f * PI * (float) ((Seed >> 8) & 0xFFFF) / 65536.0f;
+
+		Directions[ i ].x = cos( Angle );
+		Directions[ i ].y = sin( Angle );
+		Directions[ i ].z = 0.0f;
+	}
+
+	QueryPerformanceFrequency( &Frequency );
+
+	CollisionMesh::GetTransformStatistics( Statistics, true );
+
+	//
+	// Move every object in place once, which refits each leaf to root path of
+	// the scene hierarchy in turn.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (WorldObjectVec::iterator it = m_WorldObjects.begin( );
+	     it != m_WorldObjects.end( );
+	     ++it)
+	{
+		NWN::Vector3 Position = (*it)->GetPosition( );
+
+		(*it)->SetPosition( Position );
+	}
+
+	QueryPerformanceCounter( &End );
+
+	MoveTime = (ULONGLONG) (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+
+	ReportTransformStatistics( "Moving every object" );
+
+	//
+	// Cast the rays against each object in turn, as line of sight queries did
+	// before the scene hierarchy was introduced.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (unsigned long i = 0; i < RayCount; i += 1)
+	{
+		LinearHits[ i ] = CalcLineOfSightRayLinear(
+			Origins[ i ],
+			Directions[ i ],
+			LinearDistances[ i ]);
+	}
+
+	QueryPerformanceCounter( &End );
+
+	LinearTime = (ULONGLONG) (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+
+	//
+	// Cast the same rays against the scene hierarchy and check that the same
+	// intersections are found.
+	//
+
+	Hits       = 0;
+	Mismatches = 0;
+
+	QueryPerformanceCounter( &Start );
+
+	for (unsigned long i = 0; i < RayCount; i += 1)
+	{
+		float Distance;
+		bool  Hit;
+
+		Hit = CalcLineOfSightRay( Origins[ i ], Directions[ i ], Distance );
+
+		if (Hit)
+			Hits += 1;
+
+		if (Hit != LinearHits[ i ])
+			Mismatches += 1;
+		else if ((Hit) && (fabs( Distance - LinearDistances[ i ] ) > 0.001f * max( 1.0f, Distance )))
+			Mismatches += 1;
+	}
+
+	QueryPerformanceCounter( &End );
+
+	SceneTime = (ULONGLONG) (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+
+	ReportTransformStatistics( "Casting rays" );
+
+	m_TextWriter->WriteText(
+		"Line of sight benchmark: %lu objects, %lu terrain patches, %lu rays, %lu hits.\n",
+		(unsigned long) m_WorldObjects.size( ),
+		(unsigned long) m_TerrainObjects.size( ),
+		RayCount,
+		Hits);
+
+	m_TextWriter->WriteText(
+		"Linear scan: %I64uus (%.3fus per ray).\n",
+		LinearTime,
+		(double) LinearTime / RayCount);
+
+	m_TextWriter->WriteText(
+		"Scene hierarchy: %I64uus (%.3fus per ray, %.2fx linear scan speed).\n",
+		SceneTime,
+		(double) SceneTime / RayCount,
+		(SceneTime != 0) ? (double) LinearTime / SceneTime : 0.0);
+
+	m_TextWriter->WriteText(
+		"Scene hierarchy refit for moving every object: %I64uus.\n",
+		MoveTime);
+
+	if (Mismatches != 0)
+	{
+		m_TextWriter->WriteText(
+			"WorldView::BenchmarkLineOfSight: %lu rays had different results with the scene hierarchy!\n",
+			Mismatches);
+	}
+}
+
+void
+WorldView::BenchmarkSceneQueries(
+	nwn2dev__in unsigned long QueryCount
+	)
+/*++
+
+Routine Description:
+
+	This routine measures the cost of box and view frustum queries against the
+	objects and terrain patches in the area, with the scene hierarchy and with
+	a linear scan over the bounds of every scene object.  The boxes and the
+	frustums (horizontal views from just above the ground) are placed at
+	pseudo-random points in the area, with a fixed seed so that runs are
+	comparable.
+
+	Results are written to the debug text output interface.
+
+Arguments:
+
+	QueryCount - Supplies the count of box queries and of frustum queries to
+	             issue.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typedef std::vector< NWN::Vector3 > Vector3Vec;
+	typedef std::vector< AreaSceneBVH::FRUSTUM_PLANE > FrustumPlaneVec;
+	typedef std::vector< AreaSceneBVH::ObjectIdVec > ObjectIdVecVec;
+
+	enum { FRUSTUM_PLANES = 6 };
+
+	AreaSceneBVH::ObjectIdVec SceneObjects;
+	Vector3Vec                ObjectMinBounds;
+	Vector3Vec                ObjectMaxBounds;
+	Vector3Vec                BoxMinBounds;
+	Vector3Vec                BoxMaxBounds;
+	FrustumPlaneVec           Planes;
+	ObjectIdVecVec            LinearResults;
+	ObjectIdVecVec            SceneResults;
+	LARGE_INTEGER             Frequency;
+	LARGE_INTEGER             Start;
+	LARGE_INTEGER             End;
+	ULONGLONG                 BoxLinearTime;
+	ULONGLONG                 BoxSceneTime;
+	ULONGLONG                 FrustumLinearTime;
+	ULONGLONG                 FrustumSceneTime;
+	unsigned long             Seed;
+	unsigned long             BoxFound;
+	unsigned long             FrustumFound;
+	unsigned long             BoxMismatches;
+	unsigned long             FrustumMismatches;
+	float                     HalfHorizontalFOV;
+	float                     HalfVerticalFOV;
+	float                     ViewDistance;
+
+	if ((QueryCount == 0) || (m_TextWriter == NULL))
+		return;
+
+	//
+	// Snapshot the bounds of every scene object for the linear scan.
+	//
+
+	for (WorldObjectVec::const_iterator it = m_WorldObjects.begin( );
+	     it != m_WorldObjects.end( );
+	     ++it)
+	{
+		if ((*it)->GetSceneObject( ) != AreaSceneBVH::INVALID_OBJECT_ID)
+			SceneObjects.push_back( (*it)->GetSceneObject( ) );
+	}
+
+	SceneObjects.insert(
+		SceneObjects.end( ),
+		m_TerrainObjects.begin( ),
+		m_TerrainObjects.end( ));
+
+	ObjectMinBounds.resize( SceneObjects.size( ) );
+	ObjectMaxBounds.resize( SceneObjects.size( ) );
+
+	for (size_t i = 0; i < SceneObjects.size( ); i += 1)
+	{
+		m_SceneBVH.GetObjectBounds(
+			SceneObjects[ i ],
+			ObjectMinBounds[ i ],
+			ObjectMaxBounds[ i ]);
+	}
+
+	//
+	// Generate the query volumes.  Boxes span the full height of the area and
+	// up to a tenth of its width and height.  Frustums look horizontally with
+	// a 90 degree by 60 degree field of view, out to a quarter of the area.
+	//
+
+	BoxMinBounds.resize( QueryCount );
+	BoxMaxBounds.resize( QueryCount );
+	Planes.resize( QueryCount * FRUSTUM_PLANES );
+
+	HalfHorizontalFOV = PI / 4.0f;
+	HalfVerticalFOV   = PI / 6.0f;
+	ViewDistance      = max( m_AreaWidth, m_AreaHeight ) / 4.0f;
+
+	Seed = 0x51425821;
+
+	for (unsigned long i = 0; i < QueryCount; i += 1)
+	{
+		NWN::Vector3                 Center;
+		NWN::Vector3                 Forward;
+		NWN::Vector3                 Right;
+		float                        Extent;
+		float                        Angle;
+		AreaSceneBVH::PFRUSTUM_PLANE Frustum;
+
+		Seed = Seed * 1103515245 + 12345;
+		Center.x = m_AreaWidth * (float) ((Seed >> 8) & 0xFFFF) / 65536.0f;
+		Seed = Seed * 1103515245 + 12345;
+		Center.y = m_AreaHeight * (float) ((Seed >> 8) & 0xFFFF) / 65536.0f;
+		Seed = Seed * 1103515245 + 12345;
+		Extent = (float) ((Seed >> 8) & 0xFFFF) / 65536.0f / 20.0f;
+		Seed = Seed * 1103515245 + 12345;
+		Angle = 2.0f * PI * (float) ((Seed >> 8) & 0xFFFF) / 65536.0f;
+
+		BoxMinBounds[ i ].x = Center.x - Extent * m_AreaWidth;
+		BoxMinBounds[ i ].y = Center.y - Extent * m_AreaHeight;
+		BoxMinBounds[ i ].z = -FLT_MAX;
+		BoxMaxBounds[ i ].x = Center.x + Extent * m_AreaWidth;
+		BoxMaxBounds[ i ].y = Center.y + Extent * m_AreaHeight;
+		BoxMaxBounds[ i ].z = FLT_MAX;
+
+		Center.z = 2.0f;
+
+		Forward.x = cos( Angle );
+		Forward.y = sin( Angle );
+		Forward.z = 0.0f;
+
+		Right.x = Forward.y;
+		Right.y = -Forward.x;
+		Right.z = 0.0f;
+
+		//
+		// Build the left, right, bottom, top, near and far planes, with the
+		// normals pointing into the frustum.
+		//
+
+		Frustum = &Planes[ i * FRUSTUM_PLANES ];
+
+		Frustum[ 0 ].Normal.x = Right.x * cos( HalfHorizontalFOV ) + Forward.x * sin( HalfHorizontalFOV );
+		Frustum[ 0 ].Normal.y = Right.y * cos( HalfHorizontalFOV ) + Forward.y * sin( HalfHorizontalFOV );
+		Frustum[ 0 ].Normal.z = 0.0f;
+
+		Frustum[ 1 ].Normal.x = -Right.x * cos( HalfHorizontalFOV ) + Forward.x * sin( HalfHorizontalFOV );
+		Frustum[ 1 ].Normal.y = -Right.y * cos( HalfHorizontalFOV ) + Forward.y * sin( HalfHorizontalFOV );
+		Frustum[ 1 ].Normal.z = 0.0f;
+
+		Frustum[ 2 ].Normal.x = Forward.x * sin( HalfVerticalFOV );
+		Frustum[ 2 ].Normal.y = Forward.y * sin( HalfVerticalFOV );
+		Frustum[ 2 ].Normal.z = cos( HalfVerticalFOV );
+
+		Frustum[ 3 ].Normal.x = Forward.x * sin( HalfVerticalFOV );
+		Frustum[ 3 ].Normal.y = Forward.y * sin( HalfVerticalFOV );
+		Frustum[ 3 ].Normal.z = -cos( HalfVerticalFOV );
+
+		Frustum[ 4 ].Normal = Forward;
+
+		Frustum[ 5 ].Normal.x = -Forward.x;
+		Frustum[ 5 ].Normal.y = -Forward.y;
+		Frustum[ 5 ].Normal.z = 0.0f;
+
+		for (size_t j = 0; j < FRUSTUM_PLANES; j += 1)
+			Frustum[ j ].D = -Math::DotProduct( Frustum[ j ].Normal, Center );
+
+		Frustum[ 4 ].D -= 0.1f;
+		Frustum[ 5 ].D += ViewDistance;
+	}
+
+	QueryPerformanceFrequency( &Frequency );
+
+	//
+	// Issue the box queries by testing the bounds of every object in turn.
+	//
+
+	LinearResults.resize( QueryCount );
+	SceneResults.resize( QueryCount );
+
+	QueryPerformanceCounter( &Start );
+
+	for (unsigned long i = 0; i < QueryCount; i += 1)
+	{
+		for (size_t j = 0; j < SceneObjects.size( ); j += 1)
+		{
+			if ((BoxMinBounds[ i ].x <= ObjectMaxBounds[ j ].x) && (BoxMaxBounds[ i ].x >= ObjectMinBounds[ j ].x) &&
+			    (BoxMinBounds[ i ].y <= ObjectMaxBounds[ j ].y) && (BoxMaxBounds[ i ].y >= ObjectMinBounds[ j ].y) &&
+			    (BoxMinBounds[ i ].z <= ObjectMaxBounds[ j ].z) && (BoxMaxBounds[ i ].z >= ObjectMinBounds[ j ].z))
+			{
+				LinearResults[ i ].push_back( SceneObjects[ j ] );
+			}
+		}
+	}
+
+	QueryPerformanceCounter( &End );
+
+	BoxLinearTime = (ULONGLONG) (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+
+	//
+	// Issue the same box queries against the scene hierarchy and check that
+	// the same objects are returned.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (unsigned long i = 0; i < QueryCount; i += 1)
+		m_SceneBVH.QueryBox( BoxMinBounds[ i ], BoxMaxBounds[ i ], SceneResults[ i ] );
+
+	QueryPerformanceCounter( &End );
+
+	BoxSceneTime = (ULONGLONG) (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+
+	BoxFound      = 0;
+	BoxMismatches = 0;
+
+	for (unsigned long i = 0; i < QueryCount; i += 1)
+	{
+		BoxFound += (unsigned long) SceneResults[ i ].size( );
+
+		std::sort( SceneResults[ i ].begin( ), SceneResults[ i ].end( ) );
+		std::sort( LinearResults[ i ].begin( ), LinearResults[ i ].end( ) );
+
+		if (SceneResults[ i ] != LinearResults[ i ])
+			BoxMismatches += 1;
+
+		SceneResults[ i ].clear( );
+		LinearResults[ i ].clear( );
+	}
+
+	//
+	// Issue the frustum queries by testing the bounds of every object in turn
+	// against each plane.  A box is outside of a plane if the corner furthest
+	// along the plane normal is.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (unsigned long i = 0; i < QueryCount; i += 1)
+	{
+		AreaSceneBVH::PCFRUSTUM_PLANE Frustum = &Planes[ i * FRUSTUM_PLANES ];
+
+		for (size_t j = 0; j < SceneObjects.size( ); j += 1)
+		{
+			bool Outside;
+
+			Outside = false;
+
+			for (size_t k = 0; k < FRUSTUM_PLANES; k += 1)
+			{
+				NWN::Vector3 PVertex;
+
+				PVertex.x = (Frustum[ k ].Normal.x >= 0.0f) ? ObjectMaxBounds[ j ].x : ObjectMinBounds[ j ].x;
+				PVertex.y = (Frustum[ k ].Normal.y >= 0.0f) ? ObjectMaxBounds[ j ].y : ObjectMinBounds[ j ].y;
+				PVertex.z = (Frustum[ k ].Normal.z >= 0.0f) ? ObjectMaxBounds[ j ].z : ObjectMinBounds[ j ].z;
+
+				if (Math::DotProduct( Frustum[ k ].Normal, PVertex ) + Frustum[ k ].D < 0.0f)
+				{
+					Outside = true;
+					break;
+				}
+			}
+
+			if (!Outside)
+				LinearResults[ i ].push_back( SceneObjects[ j ] );
+		}
+	}
+
+	QueryPerformanceCounter( &End );
+
+	FrustumLinearTime = (ULONGLONG) (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+
+	//
+	// Issue the same frustum queries against the scene hierarchy.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (unsigned long i = 0; i < QueryCount; i += 1)
+	{
+		m_SceneBVH.QueryFrustum(
+			&Planes[ i * FRUSTUM_PLANES ],
+			FRUSTUM_PLANES,
+			SceneResults[ i ]);
+	}
+
+	QueryPerformanceCounter( &End );
+
+	FrustumSceneTime = (ULONGLONG) (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+
+	FrustumFound      = 0;
+	FrustumMismatches = 0;
+
+	for (unsigned long i = 0; i < QueryCount; i += 1)
+	{
+		FrustumFound += (unsigned long) SceneResults[ i ].size( );
+
+		std::sort( SceneResults[ i ].begin( ), SceneResults[ i ].end( ) );
+		std::sort( LinearResults[ i ].begin( ), LinearResults[ i ].end( ) );
+
+		if (SceneResults[ i ] != LinearResults[ i ])
+			FrustumMismatches += 1;
+	}
+
+	m_TextWriter->WriteText(
+		"Scene query benchmark: %lu scene objects, %lu box queries (%lu objects found), %lu frustum queries (%lu objects found).\n",
+		(unsigned long) SceneObjects.size( ),
+		QueryCount,
+		BoxFound,
+		QueryCount,
+		FrustumFound);
+
+	m_TextWriter->WriteText(
+		"Box queries: linear scan %I64uus, scene hierarchy %I64uus (%.3fus per query, %.2fx linear scan speed).\n",
+		BoxLinearTime,
+		BoxSceneTime,
+		(double) BoxSceneTime / QueryCount,
+		(BoxSceneTime != 0) ? (double) BoxLinearTime / BoxSceneTime : 0.0);
+
+	m_TextWriter->WriteText(
+		"Frustum queries: linear scan %I64uus, scene hierarchy %I64uus (%.3fus per query, %.2fx linear scan speed).\n",
+		FrustumLinearTime,
+		FrustumSceneTime,
+		(double) FrustumSceneTime / QueryCount,
+		(FrustumSceneTime != 0) ? (double) FrustumLinearTime / FrustumSceneTime : 0.0);
+
+	if ((BoxMismatches != 0) || (FrustumMismatches != 0))
+	{
+		m_TextWriter->WriteText(
+			"WorldView::BenchmarkSceneQueries: %lu box and %lu frustum queries had different results with the scene hierarchy!\n",
+			BoxMismatches,
+			FrustumMismatches);
+	}
+}
+
 void
 WorldView::RecalculateMapRect(
 	nwn2dev__in const RECT * ClientRect
@@ -1880,6 +2643,9 @@ Environment:
 	Bitmap = (HBITMAP) SelectObject( DrawDC, (HGDIOBJ) Bitmap );
 	(VOID) DeleteObject( Bitmap );
 	DeleteDC( DrawDC );
+
+	if (m_ReportTransformStatistics)
+		ReportTransformStatistics( "Frame" );
 }
 
 //
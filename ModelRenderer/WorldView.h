@@ -58,6 +58,18 @@ public:
 		nwn2dev__in const std::vector< std::string > & MDBResRefs,
 		nwn2dev__in const std::string & GR2ResRef
 		);
+
+	//
+	// Load the terrain of an area (from its Trx file) into the scene, so that
+	// line of sight and scene queries consider the ground.  The displayed area
+	// dimensions are set from the extents of the terrain.
+	//
+
+	void
+	LoadAreaTerrain(
+		nwn2dev__in const std::string & AreaResRef
+		);
+
 	//
 	// Show or hide the window.
 	//
@@ -84,6 +96,41 @@ public:
 		nwn2dev__in bool Register
 		);
 
+	//
+	// Enable or disable reporting of collision mesh transform work to the
+	// debug text output interface after each frame is drawn.
+	//
+
+	inline
+	void
+	SetReportTransformStatistics(
+		nwn2dev__in bool Report
+		)
+	{
+		m_ReportTransformStatistics = Report;
+	}
+
+	//
+	// Measure line of sight query performance with and without the scene
+	// hierarchy, and report the results to the debug text output interface.
+	//
+
+	void
+	BenchmarkLineOfSight(
+		nwn2dev__in unsigned long RayCount
+		);
+
+	//
+	// Measure box and view frustum query performance with and without the
+	// scene hierarchy, and report the results to the debug text output
+	// interface.
+	//
+
+	void
+	BenchmarkSceneQueries(
+		nwn2dev__in unsigned long QueryCount
+		);
+
 private:
 
 	//
@@ -255,6 +302,28 @@ private:
 		nwn2dev__out float & Distance
 		);
 
+	//
+	// Calculate line of sight by testing every object and terrain triangle in
+	// turn (the reference for line of sight benchmarks).
+	//
+
+	//
+	// Write the collision mesh transform work counters to the debug text
+	// output interface and reset them.
+	//
+
+	void
+	ReportTransformStatistics(
+		nwn2dev__in const char * Activity
+		);
+
+	bool
+	CalcLineOfSightRayLinear(
+		nwn2dev__in const NWN::Vector3 & Origin,
+		nwn2dev__in const NWN::Vector3 & NormDir,
+		nwn2dev__out float & Distance
+		);
+
 	//
 	// Recalculate the map drawing region rectangle.
 	//
@@ -467,6 +536,7 @@ private:
 	int               m_CursorX;
 	int               m_CursorY;
 	POINT             m_CameraRotateDelta;
+	bool              m_ReportTransformStatistics;
 
 	//
 	// Active objects being drawn.
@@ -474,6 +544,22 @@ private:
 
 	WorldObjectVec    m_WorldObjects;
 
+	//
+	// Scene hierarchy over the colliders of all active objects, used for
+	// picking and line of sight.
+	//
+
+	AreaSceneBVH      m_SceneBVH;
+
+	//
+	// Terrain of the loaded area, if any, and the scene objects of its
+	// patches.  The terrain is retained for the linear reference line of sight
+	// test.
+	//
+
+	AreaTerrainMeshVec        m_AreaTerrain;
+	AreaSceneBVH::ObjectIdVec m_TerrainObjects;
+
 };
 
 #endif
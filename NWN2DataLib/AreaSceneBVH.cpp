@@ -0,0 +1,1411 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	AreaSceneBVH.cpp
+
+Abstract:
+
+	This module houses the AreaSceneBVH class implementation, which supports
+	ray, box and frustum queries against the static geometry of an area.
+
+--*/
+
+#include "Precomp.h"
+#include "../NWNBaseLib/NWNBaseLib.h"
+#include "../NWN2MathLib/NWN2MathLib.h"
+#include "AreaSceneBVH.h"
+#include "ModelCollider.h"
+
+#include <algorithm>
+
+namespace
+{
+
+	inline
+	void
+	ExtendBounds(
+		__inout NWN::Vector3 & MinBound,
+		__inout NWN::Vector3 & MaxBound,
+		nwn2dev__in const NWN::Vector3 & v
+		)
+	{
+		if (v.x < MinBound.x)
+			MinBound.x = v.x;
+		if (v.y < MinBound.y)
+			MinBound.y = v.y;
+		if (v.z < MinBound.z)
+			MinBound.z = v.z;
+		if (v.x > MaxBound.x)
+			MaxBound.x = v.x;
+		if (v.y > MaxBound.y)
+			MaxBound.y = v.y;
+		if (v.z > MaxBound.z)
+			MaxBound.z = v.z;
+	}
+
+	inline
+	bool
+	BoxesOverlap(
+		nwn2dev__in const NWN::Vector3 & MinBound1,
+		nwn2dev__in const NWN::Vector3 & MaxBound1,
+		nwn2dev__in const NWN::Vector3 & MinBound2,
+		nwn2dev__in const NWN::Vector3 & MaxBound2
+		)
+	{
+		return (MinBound1.x <= MaxBound2.x) && (MaxBound1.x >= MinBound2.x) &&
+		       (MinBound1.y <= MaxBound2.y) && (MaxBound1.y >= MinBound2.y) &&
+		       (MinBound1.z <= MaxBound2.z) && (MaxBound1.z >= MinBound2.z);
+	}
+
+	//
+	// Slab test a ray against a box, returning the entry distance.
+	//
+
+	inline
+	bool
+	IntersectRayBox(
+		nwn2dev__in const NWN::Vector3 & Origin,
+		nwn2dev__in const NWN::Vector3 & InvDir,
+		nwn2dev__in const NWN::Vector3 & MinBound,
+		nwn2dev__in const NWN::Vector3 & MaxBound,
+		nwn2dev__in float MaxT,
+		nwn2dev__out float & TEnter
+		)
+	{
+		float t0;
+		float t1;
+		float tmin;
+		float tmax;
+
+		t0   = (MinBound.x - Origin.x) * InvDir.x;
+		t1   = (MaxBound.x - Origin.x) * InvDir.x;
+		tmin = min( t0, t1 );
+		tmax = max( t0, t1 );
+
+		t0   = (MinBound.y - Origin.y) * InvDir.y;
+		t1   = (MaxBound.y - Origin.y) * InvDir.y;
+		tmin = max( tmin, min( t0, t1 ) );
+		tmax = min( tmax, max( t0, t1 ) );
+
+		t0   = (MinBound.z - Origin.z) * InvDir.z;
+		t1   = (MaxBound.z - Origin.z) * InvDir.z;
+		tmin = max( tmin, min( t0, t1 ) );
+		tmax = min( tmax, max( t0, t1 ) );
+
+		if ((tmax < 0.0f) || (tmin > tmax) || (tmin > MaxT))
+			return false;
+
+		TEnter = tmin;
+
+		return true;
+	}
+
+	//
+	// Order objects along one axis by bounding box center.
+	//
+
+	template< typename ObjectVecT >
+	struct ObjectCenterLess
+	{
+		inline
+		ObjectCenterLess(
+			nwn2dev__in const ObjectVecT & Objects,
+			nwn2dev__in int Axis
+			)
+		: m_Objects( Objects ),
+		  m_Axis( Axis )
+		{
+		}
+
+		inline
+		bool
+		operator()(
+			nwn2dev__in unsigned long o1,
+			nwn2dev__in unsigned long o2
+			) const
+		{
+			return ((&m_Objects[ o1 ].MinBound.x)[ m_Axis ] + (&m_Objects[ o1 ].MaxBound.x)[ m_Axis ]) <
+			       ((&m_Objects[ o2 ].MinBound.x)[ m_Axis ] + (&m_Objects[ o2 ].MaxBound.x)[ m_Axis ]);
+		}
+
+		const ObjectVecT & m_Objects;
+		int                m_Axis;
+
+	private:
+
+		ObjectCenterLess & operator=( const ObjectCenterLess & );
+	};
+}
+
+AreaSceneBVH::AreaSceneBVH(
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new, empty AreaSceneBVH.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+: m_ObjectCount( 0 ),
+  m_TopLevelDirty( false )
+{
+}
+
+AreaSceneBVH::~AreaSceneBVH(
+	)
+/*++
+
+Routine Description:
+
+	This routine cleans up an AreaSceneBVH.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+}
+
+void
+AreaSceneBVH::Clear(
+	)
+/*++
+
+Routine Description:
+
+	This routine removes all objects from the scene.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	m_Objects.clear( );
+	m_FreeObjects.clear( );
+	m_Nodes.clear( );
+
+	m_ObjectCount   = 0;
+	m_TopLevelDirty = false;
+}
+
+AreaSceneBVH::ObjectId
+AreaSceneBVH::AddCollider(
+	nwn2dev__in const ModelCollider * Collider,
+	__in_opt void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine adds a model collider to the scene.  The local space collision
+	hierarchy of the collider's model is built if it does not yet exist.
+
+Arguments:
+
+	Collider - Supplies the collider to add.  The collider must remain valid
+	           until it is removed from the scene.
+
+	Context - Optionally supplies a context value returned in query results.
+
+Return Value:
+
+	The routine returns the object id of the new scene object.  On failure, an
+	std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ObjectId Object;
+
+	//
+	// Build (or fetch the shared) bottom level hierarchy up front so that the
+	// first query against the object does not pay for it.
+	//
+
+	(VOID) Collider->GetCollisionBVH( );
+
+	Object = AllocateObject( );
+
+	SCENE_OBJECT & SceneObject = m_Objects[ Object ];
+
+	SceneObject.Type     = SceneObjectCollider;
+	SceneObject.Collider = Collider;
+	SceneObject.Context  = Context;
+
+	UpdateObjectBounds( SceneObject );
+
+	return Object;
+}
+
+AreaSceneBVH::ObjectId
+AreaSceneBVH::AddTerrain(
+	nwn2dev__in const AreaTerrainMesh & Terrain,
+	__in_opt void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine adds a terrain patch to the scene.  A world space hierarchy is
+	built over the terrain triangles.
+
+Arguments:
+
+	Terrain - Supplies the terrain patch to add.
+
+	Context - Optionally supplies a context value returned in query results.
+
+Return Value:
+
+	The routine returns the object id of the new scene object, else
+	INVALID_OBJECT_ID if the terrain patch contained no triangles.  On
+	failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const AreaTerrainMesh::TerrainVertexVec & Verticies = Terrain.GetTerrainVerticies( );
+	const AreaTerrainMesh::TerrainFaceVec   & Faces     = Terrain.GetTerrainFaces( );
+	MeshBVH::Ptr                              TerrainBVH;
+	ObjectId                                  Object;
+
+	if (Faces.empty( ))
+		return INVALID_OBJECT_ID;
+
+	TerrainBVH = new MeshBVH( );
+
+	TerrainBVH->Reserve( Verticies.size( ), Faces.size( ) );
+
+	for (AreaTerrainMesh::TerrainVertexVec::const_iterator it = Verticies.begin( );
+	     it != Verticies.end( );
+	     ++it)
+	{
+		TerrainBVH->AddPoint( it->p );
+	}
+
+	for (AreaTerrainMesh::TerrainFaceVec::const_iterator it = Faces.begin( );
+	     it != Faces.end( );
+	     ++it)
+	{
+		TerrainBVH->AddTriangle( it->Vertex[ 0 ], it->Vertex[ 1 ], it->Vertex[ 2 ] );
+	}
+
+	TerrainBVH->Build( );
+
+	Object = AllocateObject( );
+
+	SCENE_OBJECT & SceneObject = m_Objects[ Object ];
+
+	SceneObject.Type    = SceneObjectTerrain;
+	SceneObject.Terrain = TerrainBVH;
+	SceneObject.Context = Context;
+
+	UpdateObjectBounds( SceneObject );
+
+	return Object;
+}
+
+void
+AreaSceneBVH::AddAreaTerrain(
+	nwn2dev__in const AreaTerrainMeshVec & Terrain,
+	__in_opt void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine adds every terrain patch of an area to the scene.
+
+Arguments:
+
+	Terrain - Supplies the terrain patches to add.
+
+	Context - Optionally supplies a context value returned in query results.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	for (AreaTerrainMeshVec::const_iterator it = Terrain.begin( );
+	     it != Terrain.end( );
+	     ++it)
+	{
+		(VOID) AddTerrain( *it, Context );
+	}
+}
+
+void
+AreaSceneBVH::RemoveObject(
+	nwn2dev__in ObjectId Object
+	)
+/*++
+
+Routine Description:
+
+	This routine removes an object from the scene.
+
+Arguments:
+
+	Object - Supplies the object id to remove.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if ((Object >= m_Objects.size( )) || (!m_Objects[ Object ].InUse))
+		throw std::exception( "Illegal AreaSceneBVH object id" );
+
+	m_Objects[ Object ].InUse    = false;
+	m_Objects[ Object ].Collider = NULL;
+	m_Objects[ Object ].Context  = NULL;
+	m_Objects[ Object ].Terrain  = NULL;
+
+	m_FreeObjects.push_back( Object );
+
+	m_ObjectCount  -= 1;
+	m_TopLevelDirty = true;
+}
+
+void
+AreaSceneBVH::UpdateObject(
+	nwn2dev__in ObjectId Object
+	)
+/*++
+
+Routine Description:
+
+	This routine refits the hierarchy for an object that has moved.  Only the
+	nodes on the path from the object's leaf to the root are touched.
+
+Arguments:
+
+	Object - Supplies the object id that moved.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned long Node;
+
+	if ((Object >= m_Objects.size( )) || (!m_Objects[ Object ].InUse))
+		throw std::exception( "Illegal AreaSceneBVH object id" );
+
+	SCENE_OBJECT & SceneObject = m_Objects[ Object ];
+
+	UpdateObjectBounds( SceneObject );
+
+	//
+	// If the top level is to be rebuilt anyway, there is nothing to refit.
+	//
+
+	if (m_TopLevelDirty)
+		return;
+
+	//
+	// An object that had no bounds when the top level was last built has no
+	// leaf, and must be brought in by a rebuild.
+	//
+
+	if (SceneObject.Leaf == INVALID_NODE)
+	{
+		m_TopLevelDirty = true;
+		return;
+	}
+
+	Node = SceneObject.Leaf;
+
+	m_Nodes[ Node ].MinBound = SceneObject.MinBound;
+	m_Nodes[ Node ].MaxBound = SceneObject.MaxBound;
+
+	for (Node = m_Nodes[ Node ].Parent;
+	     Node != INVALID_NODE;
+	     Node = m_Nodes[ Node ].Parent)
+	{
+		SCENE_NODE       & Parent = m_Nodes[ Node ];
+		const SCENE_NODE & Left   = m_Nodes[ Node + 1 ];
+		const SCENE_NODE & Right  = m_Nodes[ Parent.Right ];
+
+		Parent.MinBound = Left.MinBound;
+		Parent.MaxBound = Left.MaxBound;
+
+		ExtendBounds( Parent.MinBound, Parent.MaxBound, Right.MinBound );
+		ExtendBounds( Parent.MinBound, Parent.MaxBound, Right.MaxBound );
+	}
+}
+
+void
+AreaSceneBVH::RefitAll(
+	)
+/*++
+
+Routine Description:
+
+	This routine refits the bounds of every object and every node of the
+	hierarchy, building the top level first if required.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	for (SceneObjectVec::iterator it = m_Objects.begin( );
+	     it != m_Objects.end( );
+	     ++it)
+	{
+		if (it->InUse)
+			UpdateObjectBounds( *it );
+	}
+
+	if (m_TopLevelDirty)
+	{
+		EnsureTopLevel( );
+		return;
+	}
+
+	//
+	// Children always follow their parents, so a reverse scan visits every
+	// child before its parent.
+	//
+
+	for (size_t i = m_Nodes.size( ); i != 0; i -= 1)
+	{
+		SCENE_NODE & Node = m_Nodes[ i - 1 ];
+
+		if (Node.Object != INVALID_OBJECT_ID)
+		{
+			Node.MinBound = m_Objects[ Node.Object ].MinBound;
+			Node.MaxBound = m_Objects[ Node.Object ].MaxBound;
+		}
+		else
+		{
+			Node.MinBound = m_Nodes[ i ].MinBound;
+			Node.MaxBound = m_Nodes[ i ].MaxBound;
+
+			ExtendBounds( Node.MinBound, Node.MaxBound, m_Nodes[ Node.Right ].MinBound );
+			ExtendBounds( Node.MinBound, Node.MaxBound, m_Nodes[ Node.Right ].MaxBound );
+		}
+	}
+}
+
+bool
+AreaSceneBVH::IntersectRay(
+	nwn2dev__in const NWN::Vector3 & Origin,
+	nwn2dev__in const NWN::Vector3 & NormDir,
+	nwn2dev__in float MaxDistance,
+	__out_opt PRAY_HIT Hit
+	) const
+/*++
+
+Routine Description:
+
+	This routine performs a hit-test between a ray and all objects in the
+	scene.  Top level nodes are visited front to back, and the closest hit
+	found so far is used to prune both levels of the hierarchy.
+
+Arguments:
+
+	Origin - Supplies the origin of the hit test ray.
+
+	NormDir - Supplies the normalized direction of the hit test ray.
+
+	MaxDistance - Supplies the maximum distance at which an intersection is
+	              considered.
+
+	Hit - Optionally receives the closest intersection.  If not supplied, the
+	      routine returns on the first intersection found.
+
+Return Value:
+
+	The routine returns a Boolean value indicating whether an intersection was
+	detected or not.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned long Stack[ MAX_DEPTH + 1 ];
+	size_t        StackDepth;
+	NWN::Vector3  InvDir;
+	float         BestT;
+	float         TEnter;
+	bool          Intersected;
+
+	EnsureTopLevel( );
+
+	if (m_Nodes.empty( ))
+		return false;
+
+	InvDir.x = 1.0f / NormDir.x;
+	InvDir.y = 1.0f / NormDir.y;
+	InvDir.z = 1.0f / NormDir.z;
+
+	if (!IntersectRayBox(
+		Origin,
+		InvDir,
+		m_Nodes[ 0 ].MinBound,
+		m_Nodes[ 0 ].MaxBound,
+		MaxDistance,
+		TEnter))
+	{
+		return false;
+	}
+
+	BestT       = MaxDistance;
+	Intersected = false;
+	StackDepth  = 0;
+
+	Stack[ StackDepth++ ] = 0;
+
+	while (StackDepth != 0)
+	{
+		unsigned long      NodeIndex = Stack[ --StackDepth ];
+		const SCENE_NODE & Node      = m_Nodes[ NodeIndex ];
+
+		if (Node.Object != INVALID_OBJECT_ID)
+		{
+			const SCENE_OBJECT     & SceneObject = m_Objects[ Node.Object ];
+			float                    T;
+			NWN::Vector3             Normal;
+			MeshBVH::TriangleIndex   Triangle;
+
+			if (!IntersectObject(
+				SceneObject,
+				Origin,
+				NormDir,
+				BestT,
+				T,
+				ARGUMENT_PRESENT( Hit ) ? &Normal : NULL,
+				ARGUMENT_PRESENT( Hit ) ? &Triangle : NULL))
+			{
+				continue;
+			}
+
+			if (!ARGUMENT_PRESENT( Hit ))
+				return true;
+
+			BestT       = T;
+			Intersected = true;
+
+			Hit->Distance = T;
+			Hit->Normal   = Normal;
+			Hit->Object   = Node.Object;
+			Hit->Type     = SceneObject.Type;
+			Hit->Context  = SceneObject.Context;
+			Hit->Triangle = Triangle;
+
+			continue;
+		}
+
+		//
+		// Push the farther child first so that the nearer child is visited
+		// next.
+		//
+
+		{
+			unsigned long Left  = NodeIndex + 1;
+			unsigned long Right = Node.Right;
+			float         TLeft;
+			float         TRight;
+			bool          HitLeft;
+			bool          HitRight;
+
+			HitLeft  = IntersectRayBox(
+				Origin,
+				InvDir,
+				m_Nodes[ Left ].MinBound,
+				m_Nodes[ Left ].MaxBound,
+				BestT,
+				TLeft);
+			HitRight = IntersectRayBox(
+				Origin,
+				InvDir,
+				m_Nodes[ Right ].MinBound,
+				m_Nodes[ Right ].MaxBound,
+				BestT,
+				TRight);
+
+			if ((HitLeft) && (HitRight))
+			{
+				if (TLeft <= TRight)
+				{
+					Stack[ StackDepth++ ] = Right;
+					Stack[ StackDepth++ ] = Left;
+				}
+				else
+				{
+					Stack[ StackDepth++ ] = Left;
+					Stack[ StackDepth++ ] = Right;
+				}
+			}
+			else if (HitLeft)
+			{
+				Stack[ StackDepth++ ] = Left;
+			}
+			else if (HitRight)
+			{
+				Stack[ StackDepth++ ] = Right;
+			}
+		}
+	}
+
+	return Intersected;
+}
+
+void
+AreaSceneBVH::QueryBox(
+	nwn2dev__in const NWN::Vector3 & MinBound,
+	nwn2dev__in const NWN::Vector3 & MaxBound,
+	__inout ObjectIdVec & Objects
+	) const
+/*++
+
+Routine Description:
+
+	This routine appends every object whose world bounds overlap an axis
+	aligned box to a caller supplied list.
+
+Arguments:
+
+	MinBound - Supplies the minimum corner of the query box.
+
+	MaxBound - Supplies the maximum corner of the query box.
+
+	Objects - Receives the object ids of the overlapping objects.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned long Stack[ MAX_DEPTH + 1 ];
+	size_t        StackDepth;
+
+	EnsureTopLevel( );
+
+	if (m_Nodes.empty( ))
+		return;
+
+	StackDepth = 0;
+
+	Stack[ StackDepth++ ] = 0;
+
+	while (StackDepth != 0)
+	{
+		unsigned long      NodeIndex = Stack[ --StackDepth ];
+		const SCENE_NODE & Node      = m_Nodes[ NodeIndex ];
+
+		if (!BoxesOverlap( MinBound, MaxBound, Node.MinBound, Node.MaxBound ))
+			continue;
+
+		if (Node.Object != INVALID_OBJECT_ID)
+		{
+			Objects.push_back( Node.Object );
+			continue;
+		}
+
+		Stack[ StackDepth++ ] = Node.Right;
+		Stack[ StackDepth++ ] = NodeIndex + 1;
+	}
+}
+
+void
+AreaSceneBVH::QueryFrustum(
+	__in_ecount( NumPlanes ) PCFRUSTUM_PLANE Planes,
+	nwn2dev__in size_t NumPlanes,
+	__inout ObjectIdVec & Objects
+	) const
+/*++
+
+Routine Description:
+
+	This routine appends every object whose world bounds are not entirely
+	outside of a convex volume to a caller supplied list.  Subtrees that are
+	entirely inside all planes are accepted without further plane tests.
+
+Arguments:
+
+	Planes - Supplies the planes bounding the convex volume.
+
+	NumPlanes - Supplies the count of planes (at most 32).
+
+	Objects - Receives the object ids of the potentially visible objects.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	struct FRUSTUM_STACK_ENTRY
+	{
+		unsigned long Node;
+		unsigned long ActivePlanes;
+	};
+
+	FRUSTUM_STACK_ENTRY Stack[ MAX_DEPTH + 1 ];
+	size_t              StackDepth;
+
+	if (NumPlanes > 32)
+		throw std::exception( "Too many frustum planes" );
+
+	EnsureTopLevel( );
+
+	if (m_Nodes.empty( ))
+		return;
+
+	StackDepth = 0;
+
+	Stack[ StackDepth ].Node         = 0;
+	Stack[ StackDepth ].ActivePlanes = (NumPlanes == 32) ? ULONG_MAX : ((1UL << NumPlanes) - 1);
+	StackDepth += 1;
+
+	while (StackDepth != 0)
+	{
+		FRUSTUM_STACK_ENTRY   Entry = Stack[ --StackDepth ];
+		const SCENE_NODE    & Node  = m_Nodes[ Entry.Node ];
+		bool                  Outside;
+
+		Outside = false;
+
+		for (size_t i = 0; i < NumPlanes; i += 1)
+		{
+			NWN::Vector3 PVertex;
+			NWN::Vector3 NVertex;
+
+			if (!(Entry.ActivePlanes & (1UL << i)))
+				continue;
+
+			//
+			// Test the box corner furthest along the plane normal (the P
+			// vertex).  If it is outside, the whole box is; if the nearest
+			// corner (the N vertex) is inside, the whole box is inside this
+			// plane and descendants need not test it again.
+			//
+
+			PVertex.x = (Planes[ i ].Normal.x >= 0.0f) ? Node.MaxBound.x : Node.MinBound.x;
+			PVertex.y = (Planes[ i ].Normal.y >= 0.0f) ? Node.MaxBound.y : Node.MinBound.y;
+			PVertex.z = (Planes[ i ].Normal.z >= 0.0f) ? Node.MaxBound.z : Node.MinBound.z;
+			NVertex.x = (Planes[ i ].Normal.x >= 0.0f) ? Node.MinBound.x : Node.MaxBound.x;
+			NVertex.y = (Planes[ i ].Normal.y >= 0.0f) ? Node.MinBound.y : Node.MaxBound.y;
+			NVertex.z = (Planes[ i ].Normal.z >= 0.0f) ? Node.MinBound.z : Node.MaxBound.z;
+
+			if (Math::DotProduct( Planes[ i ].Normal, PVertex ) + Planes[ i ].D < 0.0f)
+			{
+				Outside = true;
+				break;
+			}
+
+			if (Math::DotProduct( Planes[ i ].Normal, NVertex ) + Planes[ i ].D >= 0.0f)
+				Entry.ActivePlanes &= ~(1UL << i);
+		}
+
+		if (Outside)
+			continue;
+
+		if (Node.Object != INVALID_OBJECT_ID)
+		{
+			Objects.push_back( Node.Object );
+			continue;
+		}
+
+		Stack[ StackDepth ].Node         = Node.Right;
+		Stack[ StackDepth ].ActivePlanes = Entry.ActivePlanes;
+		StackDepth += 1;
+		Stack[ StackDepth ].Node         = Entry.Node + 1;
+		Stack[ StackDepth ].ActivePlanes = Entry.ActivePlanes;
+		StackDepth += 1;
+	}
+}
+
+void *
+AreaSceneBVH::GetObjectContext(
+	nwn2dev__in ObjectId Object
+	) const
+/*++
+
+Routine Description:
+
+	This routine returns the context value associated with a scene object.
+
+Arguments:
+
+	Object - Supplies the object id to query.
+
+Return Value:
+
+	The routine returns the context value of the object.  On failure, an
+	std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if ((Object >= m_Objects.size( )) || (!m_Objects[ Object ].InUse))
+		throw std::exception( "Illegal AreaSceneBVH object id" );
+
+	return m_Objects[ Object ].Context;
+}
+
+AreaSceneBVH::SCENE_OBJECT_TYPE
+AreaSceneBVH::GetObjectType(
+	nwn2dev__in ObjectId Object
+	) const
+/*++
+
+Routine Description:
+
+	This routine returns the type of a scene object.
+
+Arguments:
+
+	Object - Supplies the object id to query.
+
+Return Value:
+
+	The routine returns the type of the object.  On failure, an
+	std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if ((Object >= m_Objects.size( )) || (!m_Objects[ Object ].InUse))
+		throw std::exception( "Illegal AreaSceneBVH object id" );
+
+	return m_Objects[ Object ].Type;
+}
+
+void
+AreaSceneBVH::GetObjectBounds(
+	nwn2dev__in ObjectId Object,
+	nwn2dev__out NWN::Vector3 & MinBound,
+	nwn2dev__out NWN::Vector3 & MaxBound
+	) const
+/*++
+
+Routine Description:
+
+	This routine returns the world bounds of a scene object, as of the last
+	time that the object was added or updated.
+
+Arguments:
+
+	Object - Supplies the object id to query.
+
+	MinBound - Receives the minimum corner of the world bounds.
+
+	MaxBound - Receives the maximum corner of the world bounds.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if ((Object >= m_Objects.size( )) || (!m_Objects[ Object ].InUse))
+		throw std::exception( "Illegal AreaSceneBVH object id" );
+
+	MinBound = m_Objects[ Object ].MinBound;
+	MaxBound = m_Objects[ Object ].MaxBound;
+}
+
+AreaSceneBVH::ObjectId
+AreaSceneBVH::AllocateObject(
+	)
+/*++
+
+Routine Description:
+
+	This routine allocates a scene object slot, reusing a free slot if one is
+	available.  The top level is marked for rebuild.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the object id of the new (cleared) slot.  On failure,
+	an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ObjectId Object;
+
+	if (!m_FreeObjects.empty( ))
+	{
+		Object = m_FreeObjects.back( );
+		m_FreeObjects.pop_back( );
+	}
+	else
+	{
+		if (m_Objects.size( ) >= INVALID_OBJECT_ID)
+			throw std::exception( "Too many AreaSceneBVH objects" );
+
+		Object = (ObjectId) m_Objects.size( );
+		m_Objects.push_back( SCENE_OBJECT( ) );
+	}
+
+	SCENE_OBJECT & SceneObject = m_Objects[ Object ];
+
+	SceneObject.Type     = SceneObjectCollider;
+	SceneObject.InUse    = true;
+	SceneObject.Collider = NULL;
+	SceneObject.Terrain  = NULL;
+	SceneObject.Context  = NULL;
+	SceneObject.Leaf     = INVALID_NODE;
+
+	m_ObjectCount  += 1;
+	m_TopLevelDirty = true;
+
+	return Object;
+}
+
+void
+AreaSceneBVH::UpdateObjectBounds(
+	__inout SCENE_OBJECT & SceneObject
+	) const
+/*++
+
+Routine Description:
+
+	This routine refreshes the cached world space bounds of a scene object.
+
+Arguments:
+
+	SceneObject - Supplies the object to update.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	switch (SceneObject.Type)
+	{
+
+	case SceneObjectCollider:
+		SceneObject.MinBound = SceneObject.Collider->GetMinBound( );
+		SceneObject.MaxBound = SceneObject.Collider->GetMaxBound( );
+		break;
+
+	case SceneObjectTerrain:
+		SceneObject.MinBound = SceneObject.Terrain->GetMinBound( );
+		SceneObject.MaxBound = SceneObject.Terrain->GetMaxBound( );
+		break;
+
+	}
+}
+
+void
+AreaSceneBVH::EnsureTopLevel(
+	) const
+/*++
+
+Routine Description:
+
+	This routine rebuilds the top level hierarchy if a structural change has
+	occurred since it was last built.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ObjectIdVec Objects;
+
+	if (!m_TopLevelDirty)
+		return;
+
+	m_Nodes.clear( );
+
+	Objects.reserve( m_ObjectCount );
+
+	for (size_t i = 0; i < m_Objects.size( ); i += 1)
+	{
+		const SCENE_OBJECT & SceneObject = m_Objects[ i ];
+
+		SceneObject.Leaf = INVALID_NODE;
+
+		//
+		// Objects without collision data (empty bounds) can never be hit, so
+		// they are left out of the hierarchy entirely.
+		//
+
+		if ((!SceneObject.InUse) ||
+		    (SceneObject.MinBound.x > SceneObject.MaxBound.x))
+		{
+			continue;
+		}
+
+		Objects.push_back( (ObjectId) i );
+	}
+
+	if (!Objects.empty( ))
+	{
+		m_Nodes.reserve( 2 * Objects.size( ) );
+		m_Nodes.push_back( SCENE_NODE( ) );
+
+		BuildNode( 0, INVALID_NODE, Objects, 0, Objects.size( ), 0 );
+	}
+
+	m_TopLevelDirty = false;
+}
+
+void
+AreaSceneBVH::BuildNode(
+	nwn2dev__in unsigned long NodeIndex,
+	nwn2dev__in unsigned long Parent,
+	__inout ObjectIdVec & Objects,
+	nwn2dev__in size_t First,
+	nwn2dev__in size_t Count,
+	nwn2dev__in size_t Depth
+	) const
+/*++
+
+Routine Description:
+
+	This routine builds a top level node over a range of objects, splitting
+	at the median object center along the longest axis until each leaf holds
+	a single object.
+
+Arguments:
+
+	NodeIndex - Supplies the index of the (already allocated) node to build.
+
+	Parent - Supplies the index of the parent node, else INVALID_NODE.
+
+	Objects - Supplies the object ids being partitioned.
+
+	First - Supplies the first object covered by the node.
+
+	Count - Supplies the count of objects covered by the node.
+
+	Depth - Supplies the depth of the node.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	NWN::Vector3 MinBound;
+	NWN::Vector3 MaxBound;
+	NWN::Vector3 Extent;
+	int          Axis;
+	size_t       Half;
+
+	UNREFERENCED_PARAMETER( Depth );
+
+	MinBound.x = MinBound.y = MinBound.z = +FLT_MAX;
+	MaxBound.x = MaxBound.y = MaxBound.z = -FLT_MAX;
+
+	for (size_t i = First; i < First + Count; i += 1)
+	{
+		ExtendBounds( MinBound, MaxBound, m_Objects[ Objects[ i ] ].MinBound );
+		ExtendBounds( MinBound, MaxBound, m_Objects[ Objects[ i ] ].MaxBound );
+	}
+
+	m_Nodes[ NodeIndex ].MinBound = MinBound;
+	m_Nodes[ NodeIndex ].MaxBound = MaxBound;
+	m_Nodes[ NodeIndex ].Parent   = Parent;
+
+	if (Count == 1)
+	{
+		m_Nodes[ NodeIndex ].Right  = INVALID_NODE;
+		m_Nodes[ NodeIndex ].Object = Objects[ First ];
+
+		m_Objects[ Objects[ First ] ].Leaf = NodeIndex;
+		return;
+	}
+
+	//
+	// A median split keeps the tree balanced, so the depth never exceeds
+	// log2 of the object count and the traversal stacks cannot overflow.
+	//
+
+	NWN_ASSERT( Depth < MAX_DEPTH );
+
+	Extent = Math::Subtract( MaxBound, MinBound );
+	Axis   = 0;
+
+	if (Extent.y > Extent.x)
+		Axis = 1;
+	if (Extent.z > (&Extent.x)[ Axis ])
+		Axis = 2;
+
+	Half = Count / 2;
+
+	std::nth_element(
+		Objects.begin( ) + First,
+		Objects.begin( ) + First + Half,
+		Objects.begin( ) + First + Count,
+		ObjectCenterLess< SceneObjectVec >( m_Objects, Axis ) );
+
+	m_Nodes[ NodeIndex ].Object = INVALID_OBJECT_ID;
+
+	m_Nodes.push_back( SCENE_NODE( ) );
+
+	BuildNode( NodeIndex + 1, NodeIndex, Objects, First, Half, Depth + 1 );
+
+	m_Nodes[ NodeIndex ].Right = (unsigned long) m_Nodes.size( );
+
+	m_Nodes.push_back( SCENE_NODE( ) );
+
+	BuildNode(
+		m_Nodes[ NodeIndex ].Right,
+		NodeIndex,
+		Objects,
+		First + Half,
+		Count - Half,
+		Depth + 1);
+}
+
+bool
+AreaSceneBVH::IntersectObject(
+	nwn2dev__in const SCENE_OBJECT & SceneObject,
+	nwn2dev__in const NWN::Vector3 & Origin,
+	nwn2dev__in const NWN::Vector3 & NormDir,
+	nwn2dev__in float MaxDistance,
+	nwn2dev__out float & T,
+	__out_opt NWN::Vector3 * Normal,
+	__out_opt MeshBVH::TriangleIndex * Triangle
+	) const
+/*++
+
+Routine Description:
+
+	This routine intersects a ray with the bottom level hierarchy of a single
+	scene object.
+
+Arguments:
+
+	SceneObject - Supplies the object to test.
+
+	Origin - Supplies the world space ray origin.
+
+	NormDir - Supplies the normalized world space ray direction.
+
+	MaxDistance - Supplies the maximum distance at which an intersection is
+	              considered.
+
+	T - Receives the world space distance of the intersection on success.
+
+	Normal - Optionally receives the world space normal of the intersected
+	         face.  If neither Normal nor Triangle is supplied, the first
+	         intersection found satisfies the query.
+
+	Triangle - Optionally receives the intersected triangle index.
+
+Return Value:
+
+	The routine returns a Boolean value indicating whether an intersection was
+	detected or not.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const MeshBVH          * Mesh;
+	const NWN::Matrix44    * WorldTransform;
+	NWN::Vector3             LocalOrigin;
+	NWN::Vector3             LocalDir;
+	MeshBVH::TriangleIndex   HitTriangle;
+	NWN::Vector3             Tri[ 3 ];
+
+	switch (SceneObject.Type)
+	{
+
+	case SceneObjectCollider:
+		Mesh = SceneObject.Collider->GetCollisionBVH( );
+
+		//
+		// Colliders without a model instance have no shared hierarchy, so
+		// fall back to a direct world space test against the collider.
+		//
+
+		if (Mesh == NULL)
+		{
+			NWN::Vector3 IntersectNormal;
+
+			if (!SceneObject.Collider->IntersectRay(
+				Origin,
+				NormDir,
+				IntersectNormal,
+				&T))
+			{
+				return false;
+			}
+
+			if (T > MaxDistance)
+				return false;
+
+			if (ARGUMENT_PRESENT( Normal ))
+				*Normal = IntersectNormal;
+			if (ARGUMENT_PRESENT( Triangle ))
+				*Triangle = MeshBVH::INVALID_TRIANGLE;
+
+			return true;
+		}
+
+		//
+		// Map the ray into model local space.  The direction is not
+		// renormalized, so the local distance parameter equals the world
+		// space distance along the (normalized) world ray.
+		//
+
+		WorldTransform = &SceneObject.Collider->GetWorldTransform( );
+		LocalOrigin    = Math::Multiply( SceneObject.Collider->GetInverseWorldTransform( ), Origin );
+		LocalDir       = Math::MultiplyNormal( SceneObject.Collider->GetInverseWorldTransform( ), NormDir );
+		break;
+
+	case SceneObjectTerrain:
+		Mesh           = SceneObject.Terrain.get( );
+		WorldTransform = NULL;
+		LocalOrigin    = Origin;
+		LocalDir       = NormDir;
+		break;
+
+	default:
+		return false;
+
+	}
+
+	if ((!ARGUMENT_PRESENT( Normal )) && (!ARGUMENT_PRESENT( Triangle )))
+		return Mesh->IntersectRay( LocalOrigin, LocalDir, MaxDistance, T, NULL );
+
+	if (!Mesh->IntersectRay( LocalOrigin, LocalDir, MaxDistance, T, &HitTriangle ))
+		return false;
+
+	if (ARGUMENT_PRESENT( Triangle ))
+		*Triangle = HitTriangle;
+
+	if (ARGUMENT_PRESENT( Normal ))
+	{
+		//
+		// Compute the normal from the world space triangle, which matches
+		// the face normals computed by CollisionMesh, without forcing the
+		// collision mesh itself into world space.
+		//
+
+		Mesh->GetTriangle( HitTriangle, Tri );
+
+		if (WorldTransform != NULL)
+		{
+			for (size_t i = 0; i < 3; i += 1)
+				Tri[ i ] = Math::Multiply( *WorldTransform, Tri[ i ] );
+		}
+
+		*Normal = Math::ComputeNormalTriangle( Tri );
+	}
+
+	return true;
+}
@@ -0,0 +1,339 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	AreaSceneBVH.h
+
+Abstract:
+
+	This module defines the AreaSceneBVH class, which represents a two-level
+	bounding volume hierarchy over the static geometry of an area.
+
+	The top level of the hierarchy is built over the world space bounds of
+	each scene object (model colliders and terrain patches).  Moving an object
+	only refits the bounds along the path from its leaf to the root; the top
+	level is rebuilt only when objects are added or removed.
+
+	The bottom level of the hierarchy is a MeshBVH per object.  For model
+	colliders, the MeshBVH is built once in model local space and is shared by
+	all colliders of the same model instance; world space queries are mapped
+	into local space through the inverse world transform of the collider.
+	Terrain patches are already stored in world space.
+
+--*/
+
+#ifndef _PROGRAMS_NWN2DATALIB_AREASCENEBVH_H
+#define _PROGRAMS_NWN2DATALIB_AREASCENEBVH_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include "MeshBVH.h"
+#include "AreaTerrainMesh.h"
+
+class ModelCollider;
+
+//
+// Define the area scene hierarchy.
+//
+
+class AreaSceneBVH
+{
+
+public:
+
+	typedef unsigned long ObjectId;
+
+	enum { INVALID_OBJECT_ID = ULONG_MAX };
+
+	typedef enum _SCENE_OBJECT_TYPE
+	{
+		SceneObjectCollider,
+		SceneObjectTerrain,
+
+		LastSceneObjectType
+	} SCENE_OBJECT_TYPE, * PSCENE_OBJECT_TYPE;
+
+	typedef const enum _SCENE_OBJECT_TYPE * PCSCENE_OBJECT_TYPE;
+
+	//
+	// Define the result of a ray query.
+	//
+
+	typedef struct _RAY_HIT
+	{
+		float                   Distance;
+		NWN::Vector3            Normal;
+		ObjectId                Object;
+		SCENE_OBJECT_TYPE       Type;
+		void                  * Context;
+		MeshBVH::TriangleIndex  Triangle;
+	} RAY_HIT, * PRAY_HIT;
+
+	typedef const struct _RAY_HIT * PCRAY_HIT;
+
+	//
+	// Define a frustum plane.  A point p lies within the halfspace of the
+	// plane if DotProduct( Normal, p ) + D >= 0.
+	//
+
+	typedef struct _FRUSTUM_PLANE
+	{
+		NWN::Vector3 Normal;
+		float        D;
+	} FRUSTUM_PLANE, * PFRUSTUM_PLANE;
+
+	typedef const struct _FRUSTUM_PLANE * PCFRUSTUM_PLANE;
+
+	typedef std::vector< ObjectId > ObjectIdVec;
+
+	AreaSceneBVH(
+		);
+
+	~AreaSceneBVH(
+		);
+
+	//
+	// Remove all objects from the scene.
+	//
+
+	void
+	Clear(
+		);
+
+	//
+	// Add a model collider to the scene.  The collider must outlive its
+	// presence in the scene, and its world transform must have been applied
+	// via ModelCollider::Update.  The context value is returned in query
+	// results.
+	//
+
+	ObjectId
+	AddCollider(
+		nwn2dev__in const ModelCollider * Collider,
+		__in_opt void * Context
+		);
+
+	//
+	// Add a terrain patch to the scene.  The terrain patch triangles are
+	// copied into the scene and need not outlive it.
+	//
+
+	ObjectId
+	AddTerrain(
+		nwn2dev__in const AreaTerrainMesh & Terrain,
+		__in_opt void * Context
+		);
+
+	//
+	// Add every terrain patch of an area (see TrxFileReader::GetTerrainMesh)
+	// to the scene.
+	//
+
+	void
+	AddAreaTerrain(
+		nwn2dev__in const AreaTerrainMeshVec & Terrain,
+		__in_opt void * Context
+		);
+
+	//
+	// Remove an object from the scene.
+	//
+
+	void
+	RemoveObject(
+		nwn2dev__in ObjectId Object
+		);
+
+	//
+	// Refit the hierarchy after an object has moved (i.e. after the collider
+	// was updated with a new world transform).
+	//
+
+	void
+	UpdateObject(
+		nwn2dev__in ObjectId Object
+		);
+
+	//
+	// Refit the hierarchy for all objects at once.  This is cheaper than
+	// updating objects individually when most objects have moved.
+	//
+
+	void
+	RefitAll(
+		);
+
+	//
+	// Intersect a ray with the scene.  If Hit is not supplied, the routine
+	// returns on the first intersection found (suitable for line of sight
+	// tests) rather than searching for the closest intersection.
+	//
+
+	bool
+	IntersectRay(
+		nwn2dev__in const NWN::Vector3 & Origin,
+		nwn2dev__in const NWN::Vector3 & NormDir,
+		nwn2dev__in float MaxDistance,
+		__out_opt PRAY_HIT Hit
+		) const;
+
+	//
+	// Return all objects whose world bounds overlap an axis aligned box.
+	//
+
+	void
+	QueryBox(
+		nwn2dev__in const NWN::Vector3 & MinBound,
+		nwn2dev__in const NWN::Vector3 & MaxBound,
+		__inout ObjectIdVec & Objects
+		) const;
+
+	//
+	// Return all objects whose world bounds are not entirely outside of a
+	// convex volume described by a set of planes (typically the six planes of
+	// a view frustum).
+	//
+
+	void
+	QueryFrustum(
+		__in_ecount( NumPlanes ) PCFRUSTUM_PLANE Planes,
+		nwn2dev__in size_t NumPlanes,
+		__inout ObjectIdVec & Objects
+		) const;
+
+	//
+	// Object data access.
+	//
+
+	void *
+	GetObjectContext(
+		nwn2dev__in ObjectId Object
+		) const;
+
+	SCENE_OBJECT_TYPE
+	GetObjectType(
+		nwn2dev__in ObjectId Object
+		) const;
+
+	void
+	GetObjectBounds(
+		nwn2dev__in ObjectId Object,
+		nwn2dev__out NWN::Vector3 & MinBound,
+		nwn2dev__out NWN::Vector3 & MaxBound
+		) const;
+
+	inline
+	size_t
+	GetObjectCount(
+		) const
+	{
+		return m_ObjectCount;
+	}
+
+private:
+
+	//
+	// Define the maximum depth of the top level hierarchy.
+	//
+
+	enum { MAX_DEPTH = 64 };
+
+	enum { INVALID_NODE = ULONG_MAX };
+
+	//
+	// Define a scene object (a top level leaf).
+	//
+
+	struct SCENE_OBJECT
+	{
+		SCENE_OBJECT_TYPE     Type;
+		bool                  InUse;
+		const ModelCollider * Collider;
+		MeshBVH::Ptr          Terrain;
+		void                * Context;
+		NWN::Vector3          MinBound;
+		NWN::Vector3          MaxBound;
+		mutable unsigned long Leaf;
+	};
+
+	//
+	// Define a top level node.  Interior nodes have their left child directly
+	// following them and their right child at Right; leaf nodes reference a
+	// single scene object.  Children always follow their parent in the node
+	// array, which allows a reverse scan to refit the whole hierarchy.
+	//
+
+	struct SCENE_NODE
+	{
+		NWN::Vector3  MinBound;
+		NWN::Vector3  MaxBound;
+		unsigned long Parent;
+		unsigned long Right;
+		ObjectId      Object;
+	};
+
+	typedef std::vector< SCENE_OBJECT > SceneObjectVec;
+	typedef std::vector< SCENE_NODE > SceneNodeVec;
+
+	ObjectId
+	AllocateObject(
+		);
+
+	void
+	UpdateObjectBounds(
+		__inout SCENE_OBJECT & SceneObject
+		) const;
+
+	//
+	// Rebuild the top level hierarchy if objects have been added or removed
+	// since it was last built.
+	//
+
+	void
+	EnsureTopLevel(
+		) const;
+
+	void
+	BuildNode(
+		nwn2dev__in unsigned long NodeIndex,
+		nwn2dev__in unsigned long Parent,
+		__inout ObjectIdVec & Objects,
+		nwn2dev__in size_t First,
+		nwn2dev__in size_t Count,
+		nwn2dev__in size_t Depth
+		) const;
+
+	bool
+	IntersectObject(
+		nwn2dev__in const SCENE_OBJECT & SceneObject,
+		nwn2dev__in const NWN::Vector3 & Origin,
+		nwn2dev__in const NWN::Vector3 & NormDir,
+		nwn2dev__in float MaxDistance,
+		nwn2dev__out float & T,
+		__out_opt NWN::Vector3 * Normal,
+		__out_opt MeshBVH::TriangleIndex * Triangle
+		) const;
+
+	SceneObjectVec       m_Objects;
+	ObjectIdVec          m_FreeObjects;
+	size_t               m_ObjectCount;
+
+	//
+	// The top level is rebuilt lazily on the next query after a structural
+	// change, so that bulk insertion at area load is O(n log n) overall.
+	//
+	// N.B.  Queries are thus not safe to issue concurrently with each other
+	//       unless the hierarchy has been built (by a prior query or by a call
+	//       to RefitAll) since the last structural change.
+	//
+
+	mutable SceneNodeVec m_Nodes;
+	mutable bool         m_TopLevelDirty;
+
+};
+
+#endif
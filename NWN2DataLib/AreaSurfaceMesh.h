@@ -572,6 +572,15 @@ public:
 		m_TileSize       = 1.0f;
 	}
 
+	inline
+	void
+	ReserveTileSurfaceMeshes(
+		nwn2dev__in size_t NumTiles
+		)
+	{
+		m_TileSurfaceMeshes.reserve( NumTiles );
+	}
+
 	inline
 	void
 	AddTileSurfaceMesh(
@@ -782,6 +791,14 @@ public:
 		return m_Islands;
 	}
 
+	inline
+	IslandVec &
+	GetIslands(
+		)
+	{
+		return m_Islands;
+	}
+
 	//
 	// Return the tile surface mesh for a particular region based on the grid
 	// coordinates.
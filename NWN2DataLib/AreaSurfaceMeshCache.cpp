@@ -0,0 +1,730 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	AreaSurfaceMeshCache.cpp
+
+Abstract:
+
+	This module houses the AreaSurfaceMeshCache class implementation, which
+	reads and writes compact binary cache files of decoded area walkmeshes.
+
+--*/
+
+#include "Precomp.h"
+#include "FileWrapper.h"
+#include "AreaSurfaceMeshCache.h"
+
+ULONGLONG
+AreaSurfaceMeshCache::ComputeContentHash(
+	__in_bcount( Length ) const void * Data,
+	nwn2dev__in size_t Length
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the 64-bit FNV-1a hash of a block of data, which is
+	used to key walkmesh cache files by the resource data they represent.
+
+Arguments:
+
+	Data - Supplies the data to hash.
+
+	Length - Supplies the length, in bytes, of the data to hash.
+
+Return Value:
+
+	The routine returns the content hash.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const unsigned char * p    = (const unsigned char *) Data;
+	ULONGLONG             Hash = 0xCBF29CE484222325ULL;
+
+	while (Length--)
+	{
+		Hash ^= *p++;
+		Hash *= 0x00000100000001B3ULL;
+	}
+
+	return Hash;
+}
+
+std::string
+AreaSurfaceMeshCache::GetCacheFileName(
+	nwn2dev__in const std::string & CacheDirectory,
+	nwn2dev__in ULONGLONG ContentHash
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs the name of the cache file for a walkmesh with a
+	given content hash.
+
+Arguments:
+
+	CacheDirectory - Supplies the directory that holds cache files.
+
+	ContentHash - Supplies the content hash of the walkmesh resource data.
+
+Return Value:
+
+	The routine returns the cache file name.  An std::exception is raised on
+	failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	char        Name[ 32 ];
+	std::string FileName;
+
+	StringCbPrintfA(
+		Name,
+		sizeof( Name ),
+		"%016I64X.aswc",
+		ContentHash);
+
+	FileName = CacheDirectory;
+
+	if ((!FileName.empty( )) &&
+	    (FileName[ FileName.size( ) - 1 ] != '\\') &&
+	    (FileName[ FileName.size( ) - 1 ] != '/'))
+	{
+		FileName.push_back( '\\' );
+	}
+
+	FileName += Name;
+
+	return FileName;
+}
+
+bool
+AreaSurfaceMeshCache::Load(
+	nwn2dev__in const std::string & CacheFileName,
+	nwn2dev__in ULONGLONG ContentHash,
+	nwn2dev__out AreaSurfaceMesh & Mesh
+	)
+/*++
+
+Routine Description:
+
+	This routine loads a walkmesh from a cache file.  The cache file is mapped
+	and each flat array is copied into the walkmesh with a single assignment.
+
+	The tile face pointers (TileSurfaceMesh::m_Faces) are left NULL, and the
+	bounding boxes are not calculated; the caller performs these steps after
+	optionally validating the walkmesh, as for a walkmesh read from a TRX.
+
+Arguments:
+
+	CacheFileName - Supplies the name of the cache file.
+
+	ContentHash - Supplies the content hash that the cache file must have been
+	              written for.
+
+	Mesh - Receives the walkmesh data.  On failure, the walkmesh contents are
+	       undefined.
+
+Return Value:
+
+	The routine returns true if the walkmesh was loaded from the cache file,
+	else false if the cache file was missing, stale, or malformed.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	HANDLE File;
+
+	File = CreateFileA(
+		CacheFileName.c_str( ),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_DELETE,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		NULL);
+
+	if (File == INVALID_HANDLE_VALUE)
+		return false;
+
+	try
+	{
+		typedef SurfaceMeshBase::SurfaceMeshEdge SurfaceMeshEdge;
+		typedef SurfaceMeshBase::SurfaceMeshTriangle SurfaceMeshTriangle;
+		typedef AreaSurfaceMesh::IslandPathNode IslandPathNode;
+
+		FileWrapper                 Wrapper;
+		const unsigned char       * View;
+		size_t                      Size;
+		CACHE_HEADER                Header;
+		const CACHE_TILE          * Tiles;
+		const NWN::Vector3        * TilePoints;
+		const SurfaceMeshEdge     * TileEdges;
+		const SurfaceMeshTriangle * TileTriangles;
+		const unsigned char       * LocalToNodeIndex;
+		const unsigned long       * NodeToLocalIndex;
+		const unsigned char       * PathNodes;
+		const CACHE_ISLAND        * Islands;
+		const unsigned long       * IslandAdjacent;
+		const float               * IslandAdjacentDist;
+		const unsigned long       * IslandExitFace;
+		const IslandPathNode      * IslandPathTable;
+
+		Wrapper.SetFileHandle( File );
+
+		if ((!Wrapper.IsMapped( )) ||
+		    (Wrapper.GetFileSize( ) < sizeof( Header )) ||
+		    (Wrapper.GetFileSize( ) > 0xFFFFFFFF))
+		{
+			CloseHandle( File );
+			return false;
+		}
+
+		View = Wrapper.GetView( );
+		Size = (size_t) Wrapper.GetFileSize( );
+
+		memcpy( &Header, View, sizeof( Header ) );
+
+		if ((Header.Signature != CACHE_SIGNATURE) ||
+		    (Header.Version != CACHE_VERSION) ||
+		    (Header.ContentHash != ContentHash) ||
+		    (Header.FileSize != Size))
+		{
+			CloseHandle( File );
+			return false;
+		}
+
+		//
+		// Locate and bounds check each flat array.
+		//
+
+		Tiles              = GetArray< CACHE_TILE >( View, Size, Header.Tiles );
+		TilePoints         = GetArray< NWN::Vector3 >( View, Size, Header.TilePoints );
+		TileEdges          = GetArray< SurfaceMeshEdge >( View, Size, Header.TileEdges );
+		TileTriangles      = GetArray< SurfaceMeshTriangle >( View, Size, Header.TileTriangles );
+		LocalToNodeIndex   = GetArray< unsigned char >( View, Size, Header.LocalToNodeIndex );
+		NodeToLocalIndex   = GetArray< unsigned long >( View, Size, Header.NodeToLocalIndex );
+		PathNodes          = GetArray< unsigned char >( View, Size, Header.PathNodes );
+		Islands            = GetArray< CACHE_ISLAND >( View, Size, Header.Islands );
+		IslandAdjacent     = GetArray< unsigned long >( View, Size, Header.IslandAdjacent );
+		IslandAdjacentDist = GetArray< float >( View, Size, Header.IslandAdjacentDist );
+		IslandExitFace     = GetArray< unsigned long >( View, Size, Header.IslandExitFace );
+		IslandPathTable    = GetArray< IslandPathNode >( View, Size, Header.IslandPathTable );
+
+		//
+		// Copy the top level walkmesh data.
+		//
+
+		Mesh.Clear( );
+
+		Mesh.Assign(
+			GetArray< NWN::Vector3 >( View, Size, Header.Points ),
+			Header.Points.Count,
+			GetArray< SurfaceMeshEdge >( View, Size, Header.Edges ),
+			Header.Edges.Count,
+			GetArray< SurfaceMeshTriangle >( View, Size, Header.Triangles ),
+			Header.Triangles.Count);
+
+		Mesh.SetFlags( Header.Flags );
+		Mesh.SetTileSize( Header.TileSize );
+		Mesh.SetTileGridHeight( Header.TileGridHeight );
+		Mesh.SetTileGridWidth( Header.TileGridWidth );
+		Mesh.SetTileBorderSize( Header.TileBorderSize );
+
+		//
+		// Copy the tile surface meshes and their path tables.
+		//
+
+		AreaSurfaceMesh::TileSurfaceMeshVec & TileMeshes = Mesh.GetTileSurfaceMeshes( );
+
+		TileMeshes.resize( Header.Tiles.Count );
+
+		for (unsigned long i = 0; i < Header.Tiles.Count; i += 1)
+		{
+			const CACHE_TILE                 & Tile     = Tiles[ i ];
+			AreaSurfaceMesh::TileSurfaceMesh & TileMesh = TileMeshes[ i ];
+			const unsigned char              * Data;
+			const unsigned long              * Indicies;
+
+			TileMesh.m_Header             = Tile.Header;
+			TileMesh.m_PathTable.m_Header = Tile.PathTableHeader;
+			TileMesh.m_Faces              = NULL;
+			TileMesh.m_FaceOffset         = Tile.FaceOffset;
+			TileMesh.m_NumFaces           = Tile.NumFaces;
+			TileMesh.m_Flags              = Tile.Flags;
+
+			TileMesh.Assign(
+				GetRange( TilePoints, Header.TilePoints, Tile.Points ),
+				Tile.Points.Count,
+				GetRange( TileEdges, Header.TileEdges, Tile.Edges ),
+				Tile.Edges.Count,
+				GetRange( TileTriangles, Header.TileTriangles, Tile.Triangles ),
+				Tile.Triangles.Count);
+
+			Data = GetRange( LocalToNodeIndex, Header.LocalToNodeIndex, Tile.LocalToNodeIndex );
+
+			TileMesh.m_PathTable.m_LocalToNodeIndex.assign(
+				Data,
+				Data + Tile.LocalToNodeIndex.Count);
+
+			Indicies = GetRange( NodeToLocalIndex, Header.NodeToLocalIndex, Tile.NodeToLocalIndex );
+
+			TileMesh.m_PathTable.m_NodeToLocalIndex.assign(
+				Indicies,
+				Indicies + Tile.NodeToLocalIndex.Count);
+
+			Data = GetRange( PathNodes, Header.PathNodes, Tile.PathNodes );
+
+			TileMesh.m_PathTable.m_PathNodes.assign(
+				Data,
+				Data + Tile.PathNodes.Count);
+		}
+
+		//
+		// Copy the islands and the island path table.
+		//
+
+		AreaSurfaceMesh::IslandVec & IslandList = Mesh.GetIslands( );
+
+		IslandList.resize( Header.Islands.Count );
+
+		for (unsigned long i = 0; i < Header.Islands.Count; i += 1)
+		{
+			const CACHE_ISLAND      & CacheIsland = Islands[ i ];
+			AreaSurfaceMesh::Island & Island      = IslandList[ i ];
+			const unsigned long     * Indicies;
+			const float             * Distances;
+
+			Island.m_Header = CacheIsland.Header;
+
+			Indicies = GetRange( IslandAdjacent, Header.IslandAdjacent, CacheIsland.Adjacent );
+
+			Island.m_Adjacent.assign(
+				Indicies,
+				Indicies + CacheIsland.Adjacent.Count);
+
+			Distances = GetRange( IslandAdjacentDist, Header.IslandAdjacentDist, CacheIsland.AdjacentDist );
+
+			Island.m_AdjacentDist.assign(
+				Distances,
+				Distances + CacheIsland.AdjacentDist.Count);
+
+			Indicies = GetRange( IslandExitFace, Header.IslandExitFace, CacheIsland.ExitFace );
+
+			Island.m_ExitFace.assign(
+				Indicies,
+				Indicies + CacheIsland.ExitFace.Count);
+		}
+
+		Mesh.GetIslandPathTable( ).assign(
+			IslandPathTable,
+			IslandPathTable + Header.IslandPathTable.Count);
+	}
+	catch (std::exception)
+	{
+		CloseHandle( File );
+		return false;
+	}
+
+	CloseHandle( File );
+
+	return true;
+}
+
+bool
+AreaSurfaceMeshCache::Save(
+	nwn2dev__in const std::string & CacheFileName,
+	nwn2dev__in ULONGLONG ContentHash,
+	nwn2dev__in const AreaSurfaceMesh & Mesh
+	)
+/*++
+
+Routine Description:
+
+	This routine writes a walkmesh to a cache file.  The variable length data
+	of every tile and island is gathered into shared flat arrays, the cache
+	image is assembled in memory, and the image is then written out with a
+	single write to a temporary file that is renamed over the cache file.
+
+Arguments:
+
+	CacheFileName - Supplies the name of the cache file.
+
+	ContentHash - Supplies the content hash of the resource data from which
+	              the walkmesh was decoded.
+
+	Mesh - Supplies the (validated) walkmesh to write.
+
+Return Value:
+
+	The routine returns true if the cache file was written, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	HANDLE      File;
+	std::string TempFileName;
+
+	File = INVALID_HANDLE_VALUE;
+
+	try
+	{
+		typedef AreaSurfaceMesh::TileSurfaceMeshVec TileSurfaceMeshVec;
+		typedef AreaSurfaceMesh::IslandVec IslandVec;
+
+		std::vector< CACHE_TILE >            Tiles;
+		SurfaceMeshBase::PointVec            TilePoints;
+		SurfaceMeshBase::EdgeVec             TileEdges;
+		SurfaceMeshBase::TriangleVec         TileTriangles;
+		AreaSurfaceMesh::LocalToNodeIndexVec LocalToNodeIndex;
+		AreaSurfaceMesh::NodeToLocalIndexVec NodeToLocalIndex;
+		AreaSurfaceMesh::PathNodeVec         PathNodes;
+		std::vector< CACHE_ISLAND >          Islands;
+		AreaSurfaceMesh::AdjacentVec         IslandAdjacent;
+		AreaSurfaceMesh::AdjacentDistVec     IslandAdjacentDist;
+		AreaSurfaceMesh::FaceIndexVec        IslandExitFace;
+		std::vector< unsigned char >         Image;
+		CACHE_HEADER                         Header;
+		char                                 Suffix[ 64 ];
+		DWORD                                Written;
+
+		//
+		// Gather the tile and island data into flat arrays.
+		//
+
+		Tiles.reserve( Mesh.GetTileSurfaceMeshes( ).size( ) );
+
+		for (TileSurfaceMeshVec::const_iterator it = Mesh.GetTileSurfaceMeshes( ).begin( );
+		     it != Mesh.GetTileSurfaceMeshes( ).end( );
+		     ++it)
+		{
+			CACHE_TILE Tile;
+
+			ZeroMemory( &Tile, sizeof( Tile ) );
+
+			Tile.Header           = it->m_Header;
+			Tile.PathTableHeader  = it->m_PathTable.m_Header;
+			Tile.Flags            = it->m_Flags;
+			Tile.FaceOffset       = it->m_FaceOffset;
+			Tile.NumFaces         = it->m_NumFaces;
+			Tile.Points           = AppendRange( TilePoints, it->GetPoints( ) );
+			Tile.Edges            = AppendRange( TileEdges, it->GetEdges( ) );
+			Tile.Triangles        = AppendRange( TileTriangles, it->GetTriangles( ) );
+			Tile.LocalToNodeIndex = AppendRange( LocalToNodeIndex, it->m_PathTable.m_LocalToNodeIndex );
+			Tile.NodeToLocalIndex = AppendRange( NodeToLocalIndex, it->m_PathTable.m_NodeToLocalIndex );
+			Tile.PathNodes        = AppendRange( PathNodes, it->m_PathTable.m_PathNodes );
+
+			Tiles.push_back( Tile );
+		}
+
+		Islands.reserve( Mesh.GetIslands( ).size( ) );
+
+		for (IslandVec::const_iterator it = Mesh.GetIslands( ).begin( );
+		     it != Mesh.GetIslands( ).end( );
+		     ++it)
+		{
+			CACHE_ISLAND Island;
+
+			Island.Header       = it->m_Header;
+			Island.Adjacent     = AppendRange( IslandAdjacent, it->m_Adjacent );
+			Island.AdjacentDist = AppendRange( IslandAdjacentDist, it->m_AdjacentDist );
+			Island.ExitFace     = AppendRange( IslandExitFace, it->m_ExitFace );
+
+			Islands.push_back( Island );
+		}
+
+		//
+		// Assemble the cache image.
+		//
+
+		ZeroMemory( &Header, sizeof( Header ) );
+
+		Image.resize( sizeof( Header ) );
+
+		Header.Signature          = CACHE_SIGNATURE;
+		Header.Version            = CACHE_VERSION;
+		Header.ContentHash        = ContentHash;
+		Header.Flags              = Mesh.GetFlags( );
+		Header.TileGridHeight     = Mesh.GetTileGridHeight( );
+		Header.TileGridWidth      = Mesh.GetTileGridWidth( );
+		Header.TileBorderSize     = Mesh.GetTileBorderSize( );
+		Header.TileSize           = Mesh.GetTileSize( );
+
+		Header.Points             = AppendArray( Image, Mesh.GetPoints( ).empty( ) ? NULL : &Mesh.GetPoints( )[ 0 ], Mesh.GetPoints( ).size( ) );
+		Header.Edges              = AppendArray( Image, Mesh.GetEdges( ).empty( ) ? NULL : &Mesh.GetEdges( )[ 0 ], Mesh.GetEdges( ).size( ) );
+		Header.Triangles          = AppendArray( Image, Mesh.GetTriangles( ).empty( ) ? NULL : &Mesh.GetTriangles( )[ 0 ], Mesh.GetTriangles( ).size( ) );
+		Header.Tiles              = AppendArray( Image, Tiles.empty( ) ? NULL : &Tiles[ 0 ], Tiles.size( ) );
+		Header.TilePoints         = AppendArray( Image, TilePoints.empty( ) ? NULL : &TilePoints[ 0 ], TilePoints.size( ) );
+		Header.TileEdges          = AppendArray( Image, TileEdges.empty( ) ? NULL : &TileEdges[ 0 ], TileEdges.size( ) );
+		Header.TileTriangles      = AppendArray( Image, TileTriangles.empty( ) ? NULL : &TileTriangles[ 0 ], TileTriangles.size( ) );
+		Header.LocalToNodeIndex   = AppendArray( Image, LocalToNodeIndex.empty( ) ? NULL : &LocalToNodeIndex[ 0 ], LocalToNodeIndex.size( ) );
+		Header.NodeToLocalIndex   = AppendArray( Image, NodeToLocalIndex.empty( ) ? NULL : &NodeToLocalIndex[ 0 ], NodeToLocalIndex.size( ) );
+		Header.PathNodes          = AppendArray( Image, PathNodes.empty( ) ? NULL : &PathNodes[ 0 ], PathNodes.size( ) );
+		Header.Islands            = AppendArray( Image, Islands.empty( ) ? NULL : &Islands[ 0 ], Islands.size( ) );
+		Header.IslandAdjacent     = AppendArray( Image, IslandAdjacent.empty( ) ? NULL : &IslandAdjacent[ 0 ], IslandAdjacent.size( ) );
+		Header.IslandAdjacentDist = AppendArray( Image, IslandAdjacentDist.empty( ) ? NULL : &IslandAdjacentDist[ 0 ], IslandAdjacentDist.size( ) );
+		Header.IslandExitFace     = AppendArray( Image, IslandExitFace.empty( ) ? NULL : &IslandExitFace[ 0 ], IslandExitFace.size( ) );
+		Header.IslandPathTable    = AppendArray( Image, Mesh.GetIslandPathTable( ).empty( ) ? NULL : &Mesh.GetIslandPathTable( )[ 0 ], Mesh.GetIslandPathTable( ).size( ) );
+
+		Header.FileSize           = (unsigned long) Image.size( );
+
+		memcpy( &Image[ 0 ], &Header, sizeof( Header ) );
+
+		//
+		// Write the image to a temporary file that is unique to this thread,
+		// and then move it into place.
+		//
+
+		StringCbPrintfA(
+			Suffix,
+			sizeof( Suffix ),
+			".%lu.%lu.tmp",
+			GetCurrentProcessId( ),
+			GetCurrentThreadId( ));
+
+		TempFileName  = CacheFileName;
+		TempFileName += Suffix;
+
+		File = CreateFileA(
+			TempFileName.c_str( ),
+			GENERIC_WRITE,
+			0,
+			NULL,
+			CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL,
+			NULL);
+
+		if (File == INVALID_HANDLE_VALUE)
+			return false;
+
+		if ((!WriteFile( File, &Image[ 0 ], (DWORD) Image.size( ), &Written, NULL )) ||
+		    (Written != Image.size( )))
+		{
+			throw std::runtime_error( "Failed to write walkmesh cache file." );
+		}
+
+		CloseHandle( File );
+		File = INVALID_HANDLE_VALUE;
+
+		if (!MoveFileExA(
+			TempFileName.c_str( ),
+			CacheFileName.c_str( ),
+			MOVEFILE_REPLACE_EXISTING))
+		{
+			throw std::runtime_error( "Failed to rename walkmesh cache file." );
+		}
+	}
+	catch (std::exception)
+	{
+		if (File != INVALID_HANDLE_VALUE)
+			CloseHandle( File );
+
+		if (!TempFileName.empty( ))
+			DeleteFileA( TempFileName.c_str( ) );
+
+		return false;
+	}
+
+	return true;
+}
+
+template< typename T >
+const T *
+AreaSurfaceMeshCache::GetArray(
+	__in_bcount( FileSize ) const unsigned char * File,
+	nwn2dev__in size_t FileSize,
+	nwn2dev__in const CACHE_ARRAY & Array
+	)
+/*++
+
+Routine Description:
+
+	This routine locates an array within a mapped cache file.
+
+Arguments:
+
+	File - Supplies the base of the mapped cache file.
+
+	FileSize - Supplies the size of the mapped cache file.
+
+	Array - Supplies the location of the array.
+
+Return Value:
+
+	The routine returns a pointer to the first element of the array.  An
+	std::exception is raised if the array does not lie within the file or is
+	misaligned.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if ((Array.Offset % CACHE_ALIGNMENT) != 0)
+		throw std::runtime_error( "Misaligned walkmesh cache array." );
+
+	if ((Array.Offset > FileSize) ||
+	    (Array.Count > (FileSize - Array.Offset) / sizeof( T )))
+	{
+		throw std::runtime_error( "Walkmesh cache array out of bounds." );
+	}
+
+	return (const T *) (File + Array.Offset);
+}
+
+template< typename T >
+const T *
+AreaSurfaceMeshCache::GetRange(
+	nwn2dev__in const T * Base,
+	nwn2dev__in const CACHE_ARRAY & Array,
+	nwn2dev__in const CACHE_ARRAY & Range
+	)
+/*++
+
+Routine Description:
+
+	This routine locates a range of elements within an array of a mapped
+	cache file.
+
+Arguments:
+
+	Base - Supplies the first element of the array.
+
+	Array - Supplies the location of the array.
+
+	Range - Supplies the element index and count of the range.
+
+Return Value:
+
+	The routine returns a pointer to the first element of the range.  An
+	std::exception is raised if the range does not lie within the array.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if ((Range.Offset > Array.Count) ||
+	    (Range.Count > Array.Count - Range.Offset))
+	{
+		throw std::runtime_error( "Walkmesh cache range out of bounds." );
+	}
+
+	return Base + Range.Offset;
+}
+
+template< typename T >
+AreaSurfaceMeshCache::CACHE_ARRAY
+AreaSurfaceMeshCache::AppendArray(
+	__inout std::vector< unsigned char > & Image,
+	__in_ecount_opt( Count ) const T * Elements,
+	nwn2dev__in size_t Count
+	)
+/*++
+
+Routine Description:
+
+	This routine appends an array to a cache image, aligning the start of the
+	array to CACHE_ALIGNMENT bytes.
+
+Arguments:
+
+	Image - Supplies the cache image being built.
+
+	Elements - Supplies the array elements.
+
+	Count - Supplies the count of array elements.
+
+Return Value:
+
+	The routine returns the location of the array.  An std::exception is
+	raised if the cache image would exceed 4GB.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	CACHE_ARRAY Array;
+	size_t      Length;
+
+	Image.resize( (Image.size( ) + CACHE_ALIGNMENT - 1) & ~((size_t) CACHE_ALIGNMENT - 1) );
+
+	if ((Count > 0xFFFFFFFF / sizeof( T )) ||
+	    (Image.size( ) + Count * sizeof( T ) > 0xFFFFFFFF))
+	{
+		throw std::runtime_error( "Walkmesh cache image too large." );
+	}
+
+	Array.Offset = (unsigned long) Image.size( );
+	Array.Count  = (unsigned long) Count;
+	Length       = Count * sizeof( T );
+
+	if (Length != 0)
+	{
+		Image.resize( Image.size( ) + Length );
+
+		memcpy( &Image[ Array.Offset ], Elements, Length );
+	}
+
+	return Array;
+}
+
+template< typename T >
+AreaSurfaceMeshCache::CACHE_ARRAY
+AreaSurfaceMeshCache::AppendRange(
+	__inout std::vector< T > & Staging,
+	nwn2dev__in const std::vector< T > & Elements
+	)
+/*++
+
+Routine Description:
+
+	This routine appends the elements of a per-tile or per-island array to a
+	shared staging array.
+
+Arguments:
+
+	Staging - Supplies the shared staging array.
+
+	Elements - Supplies the elements to append.
+
+Return Value:
+
+	The routine returns the element index and count of the appended range.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	CACHE_ARRAY Range;
+
+	Range.Offset = (unsigned long) Staging.size( );
+	Range.Count  = (unsigned long) Elements.size( );
+
+	Staging.insert( Staging.end( ), Elements.begin( ), Elements.end( ) );
+
+	return Range;
+}
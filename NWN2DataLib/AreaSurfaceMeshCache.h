@@ -0,0 +1,244 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	AreaSurfaceMeshCache.h
+
+Abstract:
+
+	This module defines the AreaSurfaceMeshCache class, which stores a fully
+	decoded AreaSurfaceMesh (walkmesh, tile pathing tables and islands) in a
+	compact binary cache file.
+
+	The cache file is a flat image:  a fixed header, followed by arrays of
+	points, edges, triangles, tile records, tile path table data, island
+	records and island path nodes.  Every array is located by an offset that
+	is relative to the start of the file, so the file is loaded by mapping it
+	and copying each array out in a single operation, with no decompression
+	or per-element parsing.
+
+	Cache files are keyed by a hash of the raw ASWM resource data from which
+	the walkmesh was decoded, so a cache file never needs to be invalidated
+	explicitly; a changed area simply hashes to a different cache file.
+
+--*/
+
+#ifndef _PROGRAMS_NWN2DATALIB_AREASURFACEMESHCACHE_H
+#define _PROGRAMS_NWN2DATALIB_AREASURFACEMESHCACHE_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include "AreaSurfaceMesh.h"
+
+class AreaSurfaceMeshCache
+{
+
+public:
+
+	//
+	// Compute the content hash of the raw resource data that a walkmesh is
+	// decoded from (64-bit FNV-1a).
+	//
+
+	static
+	ULONGLONG
+	ComputeContentHash(
+		__in_bcount( Length ) const void * Data,
+		nwn2dev__in size_t Length
+		);
+
+	//
+	// Build the cache file name for a content hash within a cache directory.
+	//
+
+	static
+	std::string
+	GetCacheFileName(
+		nwn2dev__in const std::string & CacheDirectory,
+		nwn2dev__in ULONGLONG ContentHash
+		);
+
+	//
+	// Load a walkmesh from a cache file.  The routine returns false if the
+	// cache file does not exist, or was not written for the given content
+	// hash, or is not a well-formed cache file.
+	//
+	// The structure of the cache file (all array extents) is always checked.
+	// The caller is responsible for calling AreaSurfaceMesh::Validate to check
+	// the index data within the walkmesh, unless the cache is trusted.
+	//
+
+	static
+	bool
+	Load(
+		nwn2dev__in const std::string & CacheFileName,
+		nwn2dev__in ULONGLONG ContentHash,
+		nwn2dev__out AreaSurfaceMesh & Mesh
+		);
+
+	//
+	// Write a walkmesh to a cache file.  The file is written under a
+	// temporary name and then renamed into place, so that a concurrent or
+	// interrupted save never leaves a partial cache file behind.  The routine
+	// returns true if the cache file was written.
+	//
+
+	static
+	bool
+	Save(
+		nwn2dev__in const std::string & CacheFileName,
+		nwn2dev__in ULONGLONG ContentHash,
+		nwn2dev__in const AreaSurfaceMesh & Mesh
+		);
+
+private:
+
+	enum
+	{
+		CACHE_SIGNATURE = 'CWSA',
+		CACHE_VERSION   = 1,
+		CACHE_ALIGNMENT = 8
+	};
+
+	//
+	// Define the on-disk cache structures.
+	//
+
+	typedef struct _CACHE_ARRAY
+	{
+		unsigned long Offset;
+		unsigned long Count;
+	} CACHE_ARRAY, * PCACHE_ARRAY;
+
+	typedef const struct _CACHE_ARRAY * PCCACHE_ARRAY;
+
+	typedef struct _CACHE_HEADER
+	{
+		unsigned long Signature;
+		unsigned long Version;
+		ULONGLONG     ContentHash;
+		unsigned long FileSize;
+		unsigned long Flags;
+		unsigned long TileGridHeight;
+		unsigned long TileGridWidth;
+		unsigned long TileBorderSize;
+		float         TileSize;
+		CACHE_ARRAY   Points;
+		CACHE_ARRAY   Edges;
+		CACHE_ARRAY   Triangles;
+		CACHE_ARRAY   Tiles;
+		CACHE_ARRAY   TilePoints;
+		CACHE_ARRAY   TileEdges;
+		CACHE_ARRAY   TileTriangles;
+		CACHE_ARRAY   LocalToNodeIndex;
+		CACHE_ARRAY   NodeToLocalIndex;
+		CACHE_ARRAY   PathNodes;
+		CACHE_ARRAY   Islands;
+		CACHE_ARRAY   IslandAdjacent;
+		CACHE_ARRAY   IslandAdjacentDist;
+		CACHE_ARRAY   IslandExitFace;
+		CACHE_ARRAY   IslandPathTable;
+	} CACHE_HEADER, * PCACHE_HEADER;
+
+	static_assert( sizeof( CACHE_HEADER ) == 40 + 15 * 8 , "compile time assert failed" );
+
+	typedef const struct _CACHE_HEADER * PCCACHE_HEADER;
+
+	//
+	// Each tile and island record locates its variable length data by a
+	// range (CACHE_ARRAY of element index and count) within the shared
+	// arrays described by the file header.
+	//
+
+	typedef struct _CACHE_TILE
+	{
+		AreaSurfaceMesh::TileSurfaceMeshHeader Header;
+		AreaSurfaceMesh::PathTableHeader       PathTableHeader;
+		unsigned char                          Reserved[ 2 ];
+		unsigned long                          Flags;
+		unsigned long                          FaceOffset;
+		unsigned long                          NumFaces;
+		CACHE_ARRAY                            Points;
+		CACHE_ARRAY                            Edges;
+		CACHE_ARRAY                            Triangles;
+		CACHE_ARRAY                            LocalToNodeIndex;
+		CACHE_ARRAY                            NodeToLocalIndex;
+		CACHE_ARRAY                            PathNodes;
+	} CACHE_TILE, * PCACHE_TILE;
+
+	static_assert( sizeof( CACHE_TILE ) == 57 + 13 + 2 + 3 * 4 + 6 * 8 , "compile time assert failed" );
+
+	typedef const struct _CACHE_TILE * PCCACHE_TILE;
+
+	typedef struct _CACHE_ISLAND
+	{
+		AreaSurfaceMesh::IslandHeader Header;
+		CACHE_ARRAY                   Adjacent;
+		CACHE_ARRAY                   AdjacentDist;
+		CACHE_ARRAY                   ExitFace;
+	} CACHE_ISLAND, * PCACHE_ISLAND;
+
+	static_assert( sizeof( CACHE_ISLAND ) == 24 + 3 * 8 , "compile time assert failed" );
+
+	typedef const struct _CACHE_ISLAND * PCCACHE_ISLAND;
+
+	//
+	// Return a pointer to the elements of a file array, after checking that
+	// the array lies within the file.
+	//
+
+	template< typename T >
+	static
+	const T *
+	GetArray(
+		__in_bcount( FileSize ) const unsigned char * File,
+		nwn2dev__in size_t FileSize,
+		nwn2dev__in const CACHE_ARRAY & Array
+		);
+
+	//
+	// Return a pointer to a range of elements of a file array, after checking
+	// that the range lies within the array.
+	//
+
+	template< typename T >
+	static
+	const T *
+	GetRange(
+		nwn2dev__in const T * Base,
+		nwn2dev__in const CACHE_ARRAY & Array,
+		nwn2dev__in const CACHE_ARRAY & Range
+		);
+
+	//
+	// Append an array to a cache image being built, returning its location.
+	//
+
+	template< typename T >
+	static
+	CACHE_ARRAY
+	AppendArray(
+		__inout std::vector< unsigned char > & Image,
+		__in_ecount_opt( Count ) const T * Elements,
+		nwn2dev__in size_t Count
+		);
+
+	//
+	// Append a range of elements to a staging array, returning the range.
+	//
+
+	template< typename T >
+	static
+	CACHE_ARRAY
+	AppendRange(
+		__inout std::vector< T > & Staging,
+		nwn2dev__in const std::vector< T > & Elements
+		);
+
+};
+
+#endif
@@ -149,6 +149,22 @@ public:
 		return m_TerrainGrass;
 	}
 
+	//
+	// Preallocate storage for a mesh of known size, in advance of adding its
+	// verticies and faces.
+	//
+
+	inline
+	void
+	Reserve(
+		nwn2dev__in size_t NumVerticies,
+		nwn2dev__in size_t NumFaces
+		)
+	{
+		m_TerrainVerticies.reserve( NumVerticies );
+		m_TerrainFaces.reserve( NumFaces );
+	}
+
 	inline
 	void
 	AddTerrainVertex(
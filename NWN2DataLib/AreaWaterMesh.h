@@ -118,6 +118,22 @@ public:
 		m_Image.Clear( );
 	}
 
+	//
+	// Preallocate storage for a mesh of known size, in advance of adding its
+	// verticies and faces.
+	//
+
+	inline
+	void
+	Reserve(
+		nwn2dev__in size_t NumVerticies,
+		nwn2dev__in size_t NumFaces
+		)
+	{
+		m_WaterVerticies.reserve( NumVerticies );
+		m_WaterFaces.reserve( NumFaces );
+	}
+
 	inline
 	void
 	AddWaterVertex(
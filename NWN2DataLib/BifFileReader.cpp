@@ -44,8 +44,9 @@ Environment:
 --*/
 : m_File( INVALID_HANDLE_VALUE ),
   m_FileSize( 0 ),
-  m_NextOffset( 0 ),
-  m_BifFileName( FileName )
+  m_BifFileName( FileName ),
+  m_View( NULL ),
+  m_PrefetchVirtualMemory( NULL )
 {
 	HANDLE File;
 
@@ -89,6 +90,20 @@ Environment:
 	m_FileWrapper.SetFileHandle( File, true );
 #endif
 
+	//
+	// If the BIF is mapped, reads are serviced directly from the view, and
+	// views of resources may be handed out to callers.
+	//
+
+	m_View = m_FileWrapper.GetView( );
+
+	if (m_View != NULL)
+	{
+		m_PrefetchVirtualMemory = (PrefetchVirtualMemoryProc) GetProcAddress(
+			GetModuleHandleA( "kernel32.dll" ),
+			"PrefetchVirtualMemory");
+	}
+
 	try
 	{
 		m_FileSize = GetFileSize( File, NULL );
@@ -280,7 +295,9 @@ Routine Description:
 
 	This routine logically reads an encapsulated sub-file within the BIF file.
 
-	File reading is optimized for sequential scan.
+	Reads are issued at explicit file offsets (or copied directly from the
+	view if the BIF is mapped), so the routine may be called concurrently
+	from multiple threads.
 
 Arguments:
 
@@ -308,7 +325,6 @@ Environment:
 --*/
 {
 	PCBIF_RESOURCE          ResElem;
-	ULONGLONG               NextOffset;
 
 	ResElem = LookupResourceKey( ((ResID) File) - 1 );
 
@@ -324,20 +340,11 @@ Environment:
 
 	try
 	{
-		NextOffset = (ULONGLONG) ResElem->Offset + Offset;
-
-		if (NextOffset != m_NextOffset)
-		{
-			m_FileWrapper.SeekOffset(
-				NextOffset,
-				"OffsetToResource + Offset");
-
-			m_NextOffset = NextOffset;
-		}
-
-		m_FileWrapper.ReadFile( Buffer, BytesToRead, "File Contents" );
-
-		m_NextOffset += BytesToRead;
+		m_FileWrapper.ReadFileAtOffset(
+			Buffer,
+			BytesToRead,
+			(ULONGLONG) ResElem->Offset + Offset,
+			"File Contents");
 
 		*BytesRead = BytesToRead;
 
@@ -544,6 +551,107 @@ Environment:
 }
 
 
+template< typename ResRefT >
+bool
+BifFileReader< ResRefT >::GetEncapsulatedFileView(
+	nwn2dev__in FileHandle File,
+	nwn2dev__out const unsigned char * * View,
+	nwn2dev__out size_t * ViewSize
+	)
+/*++
+
+Routine Description:
+
+	This routine returns a read-only view of the contents of an encapsulated
+	file, directly within the mapped view of the BIF.  No data is copied.
+
+Arguments:
+
+	File - Supplies a file handle to the desired sub-file.
+
+	View - Receives the address of the first byte of the sub-file.
+
+	ViewSize - Receives the size of the sub-file, in bytes.
+
+Return Value:
+
+	The routine returns a Boolean value indicating true on success, else false
+	if the file handle is invalid or the BIF is not mapped.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	PCBIF_RESOURCE ResElem;
+
+	*View     = NULL;
+	*ViewSize = 0;
+
+	if (m_View == NULL)
+		return false;
+
+	ResElem = LookupResourceKey( ((ResID) File) - 1 );
+
+	if (ResElem == NULL)
+		return false;
+
+	//
+	// N.B.  Resource extents were checked against the file size when the BIF
+	//       was parsed.
+	//
+
+	*View     = &m_View[ ResElem->Offset ];
+	*ViewSize = ResElem->FileSize;
+
+	return true;
+}
+
+template< typename ResRefT >
+void
+BifFileReader< ResRefT >::PrefetchEncapsulatedFile(
+	nwn2dev__in FileHandle File
+	)
+/*++
+
+Routine Description:
+
+	This routine requests that the pages backing an encapsulated file be read
+	in ahead of a sequential scan of the file.  The request is asynchronous
+	and advisory only.
+
+Arguments:
+
+	File - Supplies a file handle to the desired sub-file.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	PCBIF_RESOURCE         ResElem;
+	BIF_MEMORY_RANGE_ENTRY Range;
+
+	if (m_PrefetchVirtualMemory == NULL)
+		return;
+
+	ResElem = LookupResourceKey( ((ResID) File) - 1 );
+
+	if ((ResElem == NULL) || (ResElem->FileSize == 0))
+		return;
+
+	Range.VirtualAddress = (PVOID) &m_View[ ResElem->Offset ];
+	Range.NumberOfBytes  = ResElem->FileSize;
+
+	m_PrefetchVirtualMemory( GetCurrentProcess( ), 1, &Range, 0 );
+}
+
 
 template< typename ResRefT >
 void
@@ -86,8 +86,8 @@ public:
 		);
 
 	//
-	// Read an encapsulated file by file handle.  The routine is optimized to
-	// operate for sequential file reads.
+	// Read an encapsulated file by file handle.  Reads are positional, so
+	// they may be issued concurrently from multiple threads.
 	//
 
 	virtual
@@ -153,6 +153,33 @@ public:
 		nwn2dev__out std::string & AccessorName
 		);
 
+	//
+	// Return a read-only view of the contents of an encapsulated file, which
+	// remains valid for the lifetime of the reader.  The view may be handed to
+	// FileWrapper::SetExternalView.  The routine returns false if the BIF is
+	// not mapped (32-bit builds), in which case the caller should fall back
+	// to ReadEncapsulatedFile.
+	//
+
+	bool
+	GetEncapsulatedFileView(
+		nwn2dev__in FileHandle File,
+		nwn2dev__out const unsigned char * * View,
+		nwn2dev__out size_t * ViewSize
+		);
+
+	//
+	// Hint that an encapsulated file is about to be scanned sequentially, so
+	// that its pages are read in ahead of use (the equivalent of madvise with
+	// MADV_WILLNEED).  The hint is ignored if the BIF is not mapped, or if the
+	// operating system does not support PrefetchVirtualMemory.
+	//
+
+	void
+	PrefetchEncapsulatedFile(
+		nwn2dev__in FileHandle File
+		);
+
 private:
 
 	//
@@ -197,6 +224,26 @@ private:
 
 	typedef std::vector< BIF_RESOURCE > BifResourceVec;
 
+	//
+	// Define the PrefetchVirtualMemory API, which is resolved dynamically as
+	// it is only present on Windows 8 and later.
+	//
+
+	typedef struct _BIF_MEMORY_RANGE_ENTRY
+	{
+		PVOID  VirtualAddress;
+		SIZE_T NumberOfBytes;
+	} BIF_MEMORY_RANGE_ENTRY, * PBIF_MEMORY_RANGE_ENTRY;
+
+	typedef
+	BOOL
+	(WINAPI * PrefetchVirtualMemoryProc)(
+		nwn2dev__in HANDLE hProcess,
+		nwn2dev__in ULONG_PTR NumberOfEntries,
+		__in_ecount( NumberOfEntries ) PBIF_MEMORY_RANGE_ENTRY VirtualAddresses,
+		nwn2dev__in ULONG Flags
+		);
+
 	//
 	// Define helper routines for looking up resource data.
 	//
@@ -224,9 +271,16 @@ private:
 	HANDLE             m_File;
 	unsigned long      m_FileSize;
 	FileWrapper        m_FileWrapper;
-	ULONGLONG          m_NextOffset;
 	std::string        m_BifFileName;
 
+	//
+	// Base of the mapped view of the BIF, or NULL if the BIF is accessed with
+	// conventional file I/O.
+	//
+
+	const unsigned char      * m_View;
+	PrefetchVirtualMemoryProc  m_PrefetchVirtualMemory;
+
 	//
 	// Resource list data.
 	//
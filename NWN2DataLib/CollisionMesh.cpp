@@ -29,19 +29,26 @@ const SimpleMeshTypeDescriptor SMTD_CollisionMesh =
 	/* LinkageTraits = */ &MLT_CollisionMesh
 };
 
+volatile LONG CollisionMesh::s_VerticesTransformed;
+volatile LONG CollisionMesh::s_TransformsResolved;
+volatile LONG CollisionMesh::s_TransformsSkipped;
+
 void
-CollisionMesh::Update(
-	nwn2dev__in const NWN::Matrix44 & M
+CollisionMesh::Precalculate(
 	)
 /*++
 
 Routine Description:
 
-	This routine applies a new world transformation to the collision mesh.
+	This routine precomputes useful data about the mesh in advance of any
+	queries that might reference it.
+
+	The world space vertices and face normals are marked as requiring an
+	update so that they are computed on first use.
 
 Arguments:
 
-	M - Supplies the transformation to apply.
+	None.
 
 Return Value:
 
@@ -53,29 +60,139 @@ Environment:
 
 --*/
 {
-	for (VertexVec::iterator it = GetPoints( ).begin( );
-	     it != GetPoints( ).end( );
-	     ++it)
-	{
-		it->Pos = Math::Multiply( M, it->LocalPos );
-	}
+	const NWN::Vector3 * LocalPos;
+	size_t               Stride;
 
 	//
-	// Refresh normals.
+	// Calculate the local space bounds of the mesh.  The local positions are
+	// held in their own (packed, aligned) stream, so they are scanned directly
+	// in one batch.
 	//
+	// N.B.  The bounds are extended by every vertex of the mesh, not only by
+	//       the vertices referenced as face corners.  A vertex that no face
+	//       uses thus still enlarges the bounds (and so the ModelCollider
+	//       bounds derived from them), which is conservative for intersection
+	//       culling.
+	//
+
+	m_LocalMinBound.x = +FLT_MAX;
+	m_LocalMinBound.y = +FLT_MAX;
+	m_LocalMinBound.z = +FLT_MAX;
+	m_LocalMaxBound.x = -FLT_MAX;
+	m_LocalMaxBound.y = -FLT_MAX;
+	m_LocalMaxBound.z = -FLT_MAX;
 
-	Precalculate( );
+	LocalPos = GetPoints( ).GetVectorStream( offsetof( Vertex, LocalPos ), Stride );
+
+	Math::ExtendBoundsPointsPacked(
+		LocalPos,
+		GetPoints( ).size( ),
+		m_LocalMinBound,
+		m_LocalMaxBound);
+
+	m_TransformPending = true;
 }
 
 void
-CollisionMesh::Precalculate(
-	)
+CollisionMesh::UpdateBoundingBox(
+	__inout NWN::Vector3 & MinBound,
+	__inout NWN::Vector3 & MaxBound
+	) const
 /*++
 
 Routine Description:
 
-	This routine precomputes useful data about the mesh in advance of any
-	queries that might reference it.
+	This routine extends a bounding box so that it contains the mesh, as it
+	would appear once transformed by the current world transformation.
+
+	Rather than transforming each vertex, the routine transforms the local
+	space bounding box of the mesh (after J. Arvo, "Transforming Axis-Aligned
+	Bounding Boxes", Graphics Gems, 1990).  The resulting box may be somewhat
+	larger than the tightest box around the world space mesh when the world
+	transformation includes a rotation.
+
+Arguments:
+
+	MinBound - Supplies the minimum bound to extend.
+
+	MaxBound - Supplies the maximum bound to extend.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const NWN::Matrix44 & M = m_WorldTransform;
+	const float         * LocalMin = &m_LocalMinBound.x;
+	const float         * LocalMax = &m_LocalMaxBound.x;
+	float                 WorldMin[ 3 ];
+	float                 WorldMax[ 3 ];
+	const float           Rows[ 4 ][ 3 ] =
+	{
+		{ M._00, M._01, M._02 },
+		{ M._10, M._11, M._12 },
+		{ M._20, M._21, M._22 },
+		{ M._30, M._31, M._32 }
+	};
+
+	if (GetFaces( ).empty( ))
+		return;
+
+	for (size_t j = 0; j < 3; j += 1)
+	{
+		WorldMin[ j ] = Rows[ 3 ][ j ];
+		WorldMax[ j ] = Rows[ 3 ][ j ];
+
+		for (size_t i = 0; i < 3; i += 1)
+		{
+			float e = Rows[ i ][ j ] * LocalMin[ i ];
+			float f = Rows[ i ][ j ] * LocalMax[ i ];
+
+			if (e < f)
+			{
+				WorldMin[ j ] += e;
+				WorldMax[ j ] += f;
+			}
+			else
+			{
+				WorldMin[ j ] += f;
+				WorldMax[ j ] += e;
+			}
+		}
+	}
+
+	if (WorldMin[ 0 ] < MinBound.x)
+		MinBound.x = WorldMin[ 0 ];
+	if (WorldMin[ 1 ] < MinBound.y)
+		MinBound.y = WorldMin[ 1 ];
+	if (WorldMin[ 2 ] < MinBound.z)
+		MinBound.z = WorldMin[ 2 ];
+	if (WorldMax[ 0 ] > MaxBound.x)
+		MaxBound.x = WorldMax[ 0 ];
+	if (WorldMax[ 1 ] > MaxBound.y)
+		MaxBound.y = WorldMax[ 1 ];
+	if (WorldMax[ 2 ] > MaxBound.z)
+		MaxBound.z = WorldMax[ 2 ];
+}
+
+void
+CollisionMesh::ApplyTransform(
+	) const
+/*++
+
+Routine Description:
+
+	This routine applies the world transformation last supplied to Update to
+	the collision mesh, refreshing the world space vertices and face normals.
+
+	All vertices are transformed in a single batch, directly from the local
+	position stream into the world position stream.  Both streams are packed
+	and aligned, so the packed batch routine is used.
 
 Arguments:
 
@@ -91,19 +208,85 @@ Environment:
 
 --*/
 {
+	const VertexVec    & Points = GetPoints( );
+	const NWN::Vector3 * LocalPos;
+	NWN::Vector3       * Pos;
+	size_t               Stride;
+
+	LocalPos = Points.GetVectorStream( offsetof( Vertex, LocalPos ), Stride );
+	Pos      = Points.GetMutableVectorStream( offsetof( Vertex, Pos ), Stride );
+
+	Math::MultiplyPointsPacked(
+		m_WorldTransform,
+		LocalPos,
+		Pos,
+		Points.size( ));
+
 	//
-	// Calculate the normal of each face.
+	// Refresh normals.
 	//
 
-	for (FaceVec::iterator it = GetFaces( ).begin( ); it != GetFaces( ).end( ); ++it)
+	for (FaceVec::const_iterator it = GetFaces( ).begin( ); it != GetFaces( ).end( ); ++it)
 	{
 		NWN::Vector3 Tri[ 3 ];
 
 		for (size_t i = 0; i < 3; i += 1)
-			Tri[ i ] = GetPoint( it->Corners[ i ] ).Pos;
+			Tri[ i ] = Points.GetVector( offsetof( Vertex, Pos ), it->Corners[ i ] );
 
 		it->Normal = Math::ComputeNormalTriangle( Tri );
 	}
+
+	m_TransformPending = false;
+
+	InterlockedExchangeAdd( &s_VerticesTransformed, (LONG) Points.size( ) );
+	InterlockedIncrement( &s_TransformsResolved );
+}
+
+void
+CollisionMesh::GetTransformStatistics(
+	nwn2dev__out TRANSFORM_STATISTICS & Statistics,
+	nwn2dev__in bool Reset
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the count of vertices transformed, deferred
+	transformations applied, and transformations replaced by a newer one
+	before ever being applied, across all collision meshes.
+
+	The counters are optionally reset, so that a caller may report the
+	transform work done per frame.
+
+Arguments:
+
+	Statistics - Receives the counter values.
+
+	Reset - Supplies a Boolean value indicating true if the counters are to be
+	        reset to zero.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if (Reset)
+	{
+		Statistics.VerticesTransformed = (ULONG) InterlockedExchange( &s_VerticesTransformed, 0 );
+		Statistics.TransformsResolved  = (ULONG) InterlockedExchange( &s_TransformsResolved, 0 );
+		Statistics.TransformsSkipped   = (ULONG) InterlockedExchange( &s_TransformsSkipped, 0 );
+	}
+	else
+	{
+		Statistics.VerticesTransformed = (ULONG) s_VerticesTransformed;
+		Statistics.TransformsResolved  = (ULONG) s_TransformsResolved;
+		Statistics.TransformsSkipped   = (ULONG) s_TransformsSkipped;
+	}
 }
 
 template CollisionMesh::BaseMesh;
@@ -12,6 +12,12 @@ Abstract:
 	typed mesh that is stored in world coordinate form.  The collision mesh is
 	used for ray intersections with a model.
 
+	The world coordinate form of the mesh is evaluated lazily.  Applying a new
+	world transformation only records the transformation; the vertices and face
+	normals are brought up to date in a single batch the next time that world
+	space data is requested.  Objects that move every frame but are never hit
+	tested thus do not pay for transforming their collision meshes.
+
 	A model may have a COL2 (C2) and COL3 (C3) mesh, or any combination thereof
 	though a single model only supports one of each type of mesh.  Both C2 and
 	C3 meshes have identical on-disk and in-memory layouts supported by the
@@ -69,13 +75,13 @@ struct CMVertex
 	NWN::Vector3 LocalPos;
 	NWN::Vector3 Normal;
 	NWN::Vector3 uvw; // Texture vertex
-	NWN::Vector3 Pos; // Current position, calculated (not in file)
+	mutable NWN::Vector3 Pos; // Current position, calculated on demand (not in file)
 };
 
 struct CMFace
 {
-	unsigned long  Corners[ 3 ];
-	NWN::Vector3   Normal;
+	unsigned long          Corners[ 3 ];
+	mutable NWN::Vector3   Normal; // World space, calculated on demand
 };
 
 extern const SimpleMeshTypeDescriptor SMTD_CollisionMesh;
@@ -84,7 +90,7 @@ extern const SimpleMeshTypeDescriptor SMTD_CollisionMesh;
 // Define the collision mesh core itself.
 //
 
-class CollisionMesh : public SimpleMesh< CMVertex, CMFace, &SMTD_CollisionMesh, CoordTransModeWorld >
+class CollisionMesh : public SimpleMesh< CMVertex, CMFace, &SMTD_CollisionMesh, CoordTransModeWorld, 1, unsigned long, unsigned long, SimpleMeshStreamStorage< CMVertex > >
 {
 
 public:
@@ -94,7 +100,7 @@ public:
 	typedef ::CMFace Face;
 	typedef ::CMFaceFile FaceFile;
 
-	typedef SimpleMesh< Vertex, Face, &SMTD_CollisionMesh, CoordTransModeWorld > BaseMesh;
+	typedef SimpleMesh< Vertex, Face, &SMTD_CollisionMesh, CoordTransModeWorld, 1, unsigned long, unsigned long, SimpleMeshStreamStorage< Vertex > > BaseMesh;
 
 #include <pshpack1.h>
 
@@ -112,12 +118,33 @@ public:
 
 	typedef CollisionHeader Header;
 
+	//
+	// Define the transform work counters, accumulated across all collision
+	// meshes.
+	//
+
+	typedef struct _TRANSFORM_STATISTICS
+	{
+		ULONG VerticesTransformed; // Vertices brought into world space.
+		ULONG TransformsResolved;  // Deferred transformations applied.
+		ULONG TransformsSkipped;   // Transformations replaced before use.
+	} TRANSFORM_STATISTICS, * PTRANSFORM_STATISTICS;
+
 	inline
 	CollisionMesh(
 		)
-	: SimpleMesh< CMVertex, CMFace, &SMTD_CollisionMesh, CoordTransModeWorld >( )
+	: SimpleMesh< CMVertex, CMFace, &SMTD_CollisionMesh, CoordTransModeWorld, 1, unsigned long, unsigned long, SimpleMeshStreamStorage< CMVertex > >( ),
+	  m_WorldTransform( NWN::Matrix44::IDENTITY ),
+	  m_TransformPending( false )
 	{
 		ZeroMemory( &m_Header, sizeof( m_Header ) );
+
+		m_LocalMinBound.x = +FLT_MAX;
+		m_LocalMinBound.y = +FLT_MAX;
+		m_LocalMinBound.z = +FLT_MAX;
+		m_LocalMaxBound.x = -FLT_MAX;
+		m_LocalMaxBound.y = -FLT_MAX;
+		m_LocalMaxBound.z = -FLT_MAX;
 	}
 
 	inline
@@ -143,6 +170,11 @@ public:
 
 		other.CopyMeshDataTo( *this );
 
+		m_WorldTransform   = other.m_WorldTransform;
+		m_TransformPending = other.m_TransformPending;
+		m_LocalMinBound    = other.m_LocalMinBound;
+		m_LocalMaxBound    = other.m_LocalMaxBound;
+
 		SetAssociatedMesh( NULL );
 	}
 
@@ -156,18 +188,80 @@ public:
 
 		other.CopyMeshDataTo( *this );
 
+		m_WorldTransform   = other.m_WorldTransform;
+		m_TransformPending = other.m_TransformPending;
+		m_LocalMinBound    = other.m_LocalMinBound;
+		m_LocalMaxBound    = other.m_LocalMaxBound;
+
 		SetAssociatedMesh( NULL );
 
 		return *this;
 	}
 
 	//
-	// Transform the mesh against a 4x4 matrix.
+	// Transform the mesh against a 4x4 matrix.  The transformation is only
+	// recorded here; it is applied on the next access to world space data.
 	//
 
+	inline
 	void
 	Update(
 		nwn2dev__in const NWN::Matrix44 & M
+		)
+	{
+		if (m_TransformPending)
+			InterlockedIncrement( &s_TransformsSkipped );
+
+		m_WorldTransform   = M;
+		m_TransformPending = true;
+	}
+
+	//
+	// Bring the world space vertices and face normals up to date with the
+	// last transformation supplied to Update.  Callers that access the Pos or
+	// Normal members of the mesh directly must call this routine first;
+	// GetPoint3 does so implicitly.
+	//
+	// N.B.  As this routine updates the mesh on behalf of const accessors, a
+	//       mesh with a pending transformation must not be queried from more
+	//       than one thread at a time.
+	//
+
+	inline
+	void
+	ResolveTransform(
+		) const
+	{
+		if (m_TransformPending)
+			ApplyTransform( );
+	}
+
+	inline
+	bool
+	IsTransformPending(
+		) const
+	{
+		return m_TransformPending;
+	}
+
+	inline
+	const NWN::Matrix44 &
+	GetWorldTransform(
+		) const
+	{
+		return m_WorldTransform;
+	}
+
+	//
+	// Return the transform work counters, accumulated since they were last
+	// reset (e.g. once per frame).
+	//
+
+	static
+	void
+	GetTransformStatistics(
+		nwn2dev__out TRANSFORM_STATISTICS & Statistics,
+		nwn2dev__in bool Reset
 		);
 
 	//
@@ -206,14 +300,9 @@ public:
 		nwn2dev__in PointIndex PointId
 		) const
 	{
-		const Vertex  & Point( GetPoint( PointId ) );
-		NWN::Vector3    v;
-
-		v.x = Point.Pos.x;
-		v.y = Point.Pos.y;
-		v.z = Point.Pos.z;
+		ResolveTransform( );
 
-		return v;
+		return GetPoints( ).GetVector( offsetof( Vertex, Pos ), PointId );
 	}
 
 	static
@@ -242,43 +331,71 @@ public:
 	}
 
 	//
-	// Update bounding parameters.
+	// Update bounding parameters.  The bounds of the local space mesh are
+	// transformed by the current world transformation, which yields a box
+	// that contains the world space mesh without transforming each vertex.
 	//
 
-	inline
 	void
 	UpdateBoundingBox(
 		__inout NWN::Vector3 & MinBound,
 		__inout NWN::Vector3 & MaxBound
-		)
+		) const;
+
+	//
+	// Return the local space bounds of the mesh, as computed by Precalculate.
+	//
+
+	inline
+	const NWN::Vector3 &
+	GetLocalMinBound(
+		) const
+	{
+		return m_LocalMinBound;
+	}
+
+	inline
+	const NWN::Vector3 &
+	GetLocalMaxBound(
+		) const
 	{
-		for (FaceVec::const_iterator it = GetFaces( ).begin( );
-		     it != GetFaces( ).end( );
-		     ++it)
-		{
-			for (size_t i = 0; i < 3; i += 1)
-			{
-				NWN::Vector3 Point3 = GetPoint3( it->Corners[ i ] );
-
-				if (Point3.x < MinBound.x)
-					MinBound.x = Point3.x;
-				if (Point3.y < MinBound.y)
-					MinBound.y = Point3.y;
-				if (Point3.z < MinBound.z)
-					MinBound.z = Point3.z;
-				if (Point3.x > MaxBound.x)
-					MaxBound.x = Point3.x;
-				if (Point3.y > MaxBound.y)
-					MaxBound.y = Point3.y;
-				if (Point3.z > MaxBound.z)
-					MaxBound.z = Point3.z;
-			}
-		}
+		return m_LocalMaxBound;
 	}
 
 private:
 
-	Header    m_Header;
+	//
+	// Transform all vertices and recompute face normals.
+	//
+
+	void
+	ApplyTransform(
+		) const;
+
+	Header                m_Header;
+
+	//
+	// World transformation last supplied to Update, and whether it has yet to
+	// be applied to the world space vertices.
+	//
+
+	NWN::Matrix44         m_WorldTransform;
+	mutable bool          m_TransformPending;
+
+	//
+	// Local space bounds of the mesh.
+	//
+
+	NWN::Vector3          m_LocalMinBound;
+	NWN::Vector3          m_LocalMaxBound;
+
+	//
+	// Transform work counters (see GetTransformStatistics).
+	//
+
+	static volatile LONG  s_VerticesTransformed;
+	static volatile LONG  s_TransformsResolved;
+	static volatile LONG  s_TransformsSkipped;
 
 };
 
@@ -43,15 +43,20 @@ Environment:
 	User mode.
 
 --*/
-: m_DirectoryName( DirectoryName )
+: m_DirectoryName( DirectoryName ),
+  m_WatchHandle( INVALID_HANDLE_VALUE ),
+  m_WatchEvent( NULL ),
+  m_WatchPending( false )
 {
 	m_DirectoryName += "//";
 
+	ZeroMemory( &m_WatchOverlapped, sizeof( m_WatchOverlapped ) );
+
 	//
 	// Create directory file entries as necessary.
 	//
 
-	ScanDirectory( m_DirectoryName, 0 );
+	ScanDirectory( m_DirectoryName, "", 0, NULL, NULL );
 }
 
 template< typename ResRefT >
@@ -77,6 +82,30 @@ Environment:
 
 --*/
 {
+	if (m_WatchHandle != INVALID_HANDLE_VALUE)
+	{
+		DWORD Transferred;
+
+		//
+		// The change notification buffer must not be released while a read
+		// is outstanding against it.
+		//
+
+		if (m_WatchPending)
+		{
+			CancelIo( m_WatchHandle );
+			GetOverlappedResult(
+				m_WatchHandle,
+				&m_WatchOverlapped,
+				&Transferred,
+				TRUE);
+		}
+
+		CloseHandle( m_WatchHandle );
+	}
+
+	if (m_WatchEvent != NULL)
+		CloseHandle( m_WatchEvent );
 }
 
 template< typename ResRefT >
@@ -111,36 +140,19 @@ Environment:
 
 --*/
 {
-	std::string    FileNameStr( m_DirectoryName );
-	const char   * p;
-	HANDLE         h;
+	typename EntryIndexMap::const_iterator it;
 
-	p = (const char *)memchr(
-		FileName.RefStr,
-		'\0',
-		sizeof( FileName.RefStr ) );
-
-	if (p == NULL)
-		FileNameStr.append( FileName.RefStr, sizeof( FileName.RefStr ) );
-	else
-		FileNameStr.append( FileName.RefStr, p - FileName.RefStr );
+	//
+	// Resolve the name through the name index, which covers subdirectories
+	// as well as the directory itself.
+	//
 
-	FileNameStr += ".";
-    FileNameStr += this->ResTypeToExt( Type );
+	it = m_NameIndex.find( GetNameKey( FileName, Type ) );
 
-	h = CreateFileA(
-		FileNameStr.c_str( ),
-		GENERIC_READ,
-		FILE_SHARE_READ,
-		NULL,
-		OPEN_EXISTING,
-		FILE_ATTRIBUTE_NORMAL,
-		NULL);
-
-	if (h == INVALID_HANDLE_VALUE)
+	if (it == m_NameIndex.end( ))
 		return INVALID_FILE;
 
-	return (FileHandle) h;
+	return OpenFileByIndex( it->second );
 }
 
 template< typename ResRefT >
@@ -177,6 +189,9 @@ Environment:
 	if ((size_t) FileIndex >= m_DirectoryEntries.size( ))
 		return INVALID_FILE;
 
+	if (!m_DirectoryEntries[ (size_t) FileIndex ].Present)
+		return INVALID_FILE;
+
 	h = CreateFileA(
 		m_DirectoryEntries[ (size_t) FileIndex ].RealFileName.c_str( ),
 		GENERIC_READ,
@@ -274,11 +289,21 @@ Environment:
 	if (BytesToRead > ULONG_MAX)
 		BytesToRead = ULONG_MAX;
 
+	ResourceStatistics::ScopedOperation StatOp(
+		m_Statistics,
+		m_StatSource,
+		ResourceStatistics::OpRead);
+
 	if (!ReadFile( (HANDLE) File, Buffer, (DWORD) BytesToRead, &Read, NULL ))
+	{
+		StatOp.Cancel( );
 		return false;
+	}
 
 	*BytesRead = (size_t) Read;
 
+	StatOp.SetBytes( Read );
+
 	return true;
 }
 
@@ -379,7 +404,8 @@ Arguments:
 Return Value:
 
 	The routine returns a Boolean value indicating success or failure.  The
-	routine always succeeds as long as the caller provides a legal file index.
+	routine succeeds as long as the caller provides a legal file index whose
+	file has not been removed from the directory.
 
 Environment:
 
@@ -390,6 +416,9 @@ Environment:
 	if ((size_t) FileIndex >= m_DirectoryEntries.size( ))
 		return false;
 
+	if (!m_DirectoryEntries[ (size_t) FileIndex ].Present)
+		return false;
+
 	memcpy(
 		&ResRef,
 		&m_DirectoryEntries[ (size_t) FileIndex ].Name,
@@ -464,11 +493,234 @@ Environment:
 	return AccessorTypeDirectory;
 }
 
+template< typename ResRefT >
+bool
+DirectoryFileReader< ResRefT >::EnableChangeNotification(
+	)
+/*++
+
+Routine Description:
+
+	This routine begins watching the directory tree for changes.  Once the
+	watch is established, the directory is rescanned, so that any change made
+	between the initial scan and the start of the watch is reported by the
+	first call to PollChanges.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns true if the directory is being watched, else false if
+	the watch could not be established.  An std::exception is raised on
+	catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::string Path;
+
+	if (m_WatchHandle != INVALID_HANDLE_VALUE)
+		return true;
+
+	Path = m_DirectoryName;
+
+	while ((Path.size( ) > 1) &&
+	       ((Path[ Path.size( ) - 1 ] == '/') ||
+	        (Path[ Path.size( ) - 1 ] == '\\')))
+	{
+		Path.erase( Path.size( ) - 1 );
+	}
+
+	m_WatchBuffer.resize( WATCH_BUFFER_SIZE );
+
+	m_WatchEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+	if (m_WatchEvent == NULL)
+		return false;
+
+	m_WatchHandle = CreateFileA(
+		Path.c_str( ),
+		FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL,
+		OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+		NULL);
+
+	if ((m_WatchHandle == INVALID_HANDLE_VALUE) ||
+	    (!IssueWatchRead( )))
+	{
+		if (m_WatchHandle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle( m_WatchHandle );
+			m_WatchHandle = INVALID_HANDLE_VALUE;
+		}
+
+		CloseHandle( m_WatchEvent );
+		m_WatchEvent = NULL;
+
+		return false;
+	}
+
+	RescanDirectory( m_InitialChanges );
+
+	return true;
+}
+
+template< typename ResRefT >
+bool
+DirectoryFileReader< ResRefT >::PollChanges(
+	__inout DirectoryChangeVec & Changes
+	)
+/*++
+
+Routine Description:
+
+	This routine collects any completed change notifications for the
+	directory, applies them to the directory entries, and re-arms the watch.
+
+	Should the change notification buffer have overflowed, or the watch have
+	failed, the directory is rescanned instead and the differences against
+	the directory entries are applied.
+
+Arguments:
+
+	Changes - Receives a record of each change applied, appended to any
+	          existing contents.
+
+Return Value:
+
+	The routine returns true if any change was applied.  An std::exception is
+	raised on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	size_t OldCount;
+	DWORD  Transferred;
+
+	OldCount = Changes.size( );
+
+	if (!m_InitialChanges.empty( ))
+	{
+		Changes.insert(
+			Changes.end( ),
+			m_InitialChanges.begin( ),
+			m_InitialChanges.end( ));
+
+		m_InitialChanges.clear( );
+	}
+
+	//
+	// Drain completed notifications.  The watch is re-armed after each batch
+	// (the system continues to accumulate changes for the directory handle in
+	// the interim), and a bounded number of batches is processed per poll so
+	// that a directory under constant modification cannot stall the caller.
+	//
+
+	for (ULONG Batch = 0; (Batch < 16) && (m_WatchPending); Batch += 1)
+	{
+		if (!GetOverlappedResult(
+			m_WatchHandle,
+			&m_WatchOverlapped,
+			&Transferred,
+			FALSE))
+		{
+			if (GetLastError( ) == ERROR_IO_INCOMPLETE)
+				break;
+
+			Transferred = 0;
+		}
+
+		m_WatchPending = false;
+
+		if (Transferred == 0)
+		{
+			//
+			// The notification buffer overflowed (or the read failed), so the
+			// individual changes are unknown.  Fall back to a full rescan.
+			//
+
+			RescanDirectory( Changes );
+		}
+		else
+		{
+			const unsigned char * Record;
+
+			Record = (const unsigned char *) &m_WatchBuffer[ 0 ];
+
+			for (;;)
+			{
+				PFILE_NOTIFY_INFORMATION Info;
+				std::string              RelativePath;
+				int                      Length;
+
+				Info = (PFILE_NOTIFY_INFORMATION) Record;
+
+				Length = WideCharToMultiByte(
+					CP_ACP,
+					0,
+					Info->FileName,
+					(int) (Info->FileNameLength / sizeof( WCHAR )),
+					NULL,
+					0,
+					NULL,
+					NULL);
+
+				if (Length > 0)
+				{
+					RelativePath.resize( (size_t) Length );
+
+					WideCharToMultiByte(
+						CP_ACP,
+						0,
+						Info->FileName,
+						(int) (Info->FileNameLength / sizeof( WCHAR )),
+						&RelativePath[ 0 ],
+						Length,
+						NULL,
+						NULL);
+
+					ProcessFileNotification( Info->Action, RelativePath, Changes );
+				}
+
+				if (Info->NextEntryOffset == 0)
+					break;
+
+				Record += Info->NextEntryOffset;
+			}
+		}
+
+		if (!IssueWatchRead( ))
+		{
+			//
+			// The directory can no longer be watched (for example, it was
+			// deleted).  Stop watching; the entries remain as last seen.
+			//
+
+			break;
+		}
+	}
+
+	return Changes.size( ) != OldCount;
+}
+
 template< typename ResRefT >
 void
 DirectoryFileReader< ResRefT >::ScanDirectory(
 	nwn2dev__in const std::string & Directory,
-	nwn2dev__in size_t RecursionLevel
+	nwn2dev__in const std::string & RelativeDirectory,
+	nwn2dev__in size_t RecursionLevel,
+	__inout_opt DirectoryChangeVec * Changes,
+	__inout_opt std::vector< bool > * Seen
 	)
 /*++
 
@@ -482,11 +734,21 @@ Arguments:
 	Directory - Supplies the name of the directory to scan.  The name must have
 	            a path separator at the end.
 
+	RelativeDirectory - Supplies the path of the directory relative to the
+	                    root directory of the reader.  The path is empty for
+	                    the root directory, else it must have a path separator
+	                    at the end.
+
 	RecursionLevel - Supplies the recursion level.
 
+	Changes - Optionally receives a record of each change made to the
+	          directory entries, for a rescan.
+
+	Seen - Optionally receives a mark for each directory entry found.
+
 Return Value:
 
-	The routine returns the count of files present.
+	None.  An std::exception is raised on catastrophic failure.
 
 Environment:
 
@@ -497,10 +759,7 @@ Environment:
 	WIN32_FIND_DATAA FindData;
 	HANDLE           Find;
 	std::string      Name;
-	ResType          Type;
-	char             Ext[ 32 ];
-	char             ResName[ MAX_PATH ];
-	size_t           Len;
+	FileId           FileIndex;
 
 	if (RecursionLevel >= 256)
 		return;
@@ -523,71 +782,666 @@ Environment:
 
 			if (FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 			{
+				std::string RelativeName;
+
 				Name  = Directory;
 				Name += FindData.cFileName;
 				Name += "//";
 
-				ScanDirectory( Name, RecursionLevel + 1 );
+				RelativeName  = RelativeDirectory;
+				RelativeName += FindData.cFileName;
+				RelativeName += "\\";
+
+				ScanDirectory( Name, RelativeName, RecursionLevel + 1, Changes, Seen );
 				continue;
 			}
 
 			//
-			// Check if this is a known resource type, and add it to our list
-			// if it is.
+			// Create or update the directory entry for the file if it is a
+			// known resource type.
 			//
 
-			if (_splitpath_s(
-				FindData.cFileName,
-				NULL,
-				0,
-				NULL,
-				0,
-				ResName,
-				sizeof( ResName ),
-				Ext,
-				sizeof( Ext )) || (Ext[ 0 ] == '\0'))
+			FileIndex = UpdateFileEntry(
+				RelativeDirectory + FindData.cFileName,
+				((ULONGLONG) FindData.ftLastWriteTime.dwHighDateTime << 32) |
+				 (ULONGLONG) FindData.ftLastWriteTime.dwLowDateTime,
+				((ULONGLONG) FindData.nFileSizeHigh << 32) |
+				 (ULONGLONG) FindData.nFileSizeLow,
+				Changes);
+
+			if ((Seen != NULL) &&
+			    ((size_t) FileIndex < m_DirectoryEntries.size( )))
 			{
-				continue;
+				if ((size_t) FileIndex >= Seen->size( ))
+					Seen->resize( (size_t) FileIndex + 1, false );
+
+				(*Seen)[ (size_t) FileIndex ] = true;
 			}
 
-            Type = this->ExtToResType( Ext + 1 );
+		} while (FindNextFileA( Find, &FindData ) );
+	}
+	catch (...)
+	{
+		FindClose( Find );
+		throw;
+	}
+
+	FindClose( Find );
+}
+
+template< typename ResRefT >
+void
+DirectoryFileReader< ResRefT >::RescanDirectory(
+	__inout DirectoryChangeVec & Changes
+	)
+/*++
+
+Routine Description:
+
+	This routine rescans the entire directory tree and applies the differences
+	against the current directory entries:  new files are added, files whose
+	size or last write time differ are reported as modified, and entries
+	whose files were not found are vacated.
+
+Arguments:
+
+	Changes - Receives a record of each change applied.
+
+Return Value:
+
+	None.  An std::exception is raised on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< bool > Seen;
+	size_t              Count;
+
+	Count = m_DirectoryEntries.size( );
 
+	Seen.resize( Count, false );
+
+	ScanDirectory( m_DirectoryName, "", 0, &Changes, &Seen );
+
+	for (size_t i = 0; i < Count; i += 1)
+	{
+		if ((m_DirectoryEntries[ i ].Present) && (!Seen[ i ]))
+			VacateEntry( (FileId) i, Changes );
+	}
+}
+
+template< typename ResRefT >
+FileId
+DirectoryFileReader< ResRefT >::UpdateFileEntry(
+	nwn2dev__in const std::string & RelativePath,
+	nwn2dev__in ULONGLONG LastWriteTime,
+	nwn2dev__in ULONGLONG FileSize,
+	__inout_opt DirectoryChangeVec * Changes
+	)
+/*++
+
+Routine Description:
+
+	This routine creates the directory entry for a file, revives the vacant
+	directory entry of a file that has been re-created, or records that an
+	existing file has been modified.
+
+Arguments:
+
+	RelativePath - Supplies the path of the file relative to the directory.
+
+	LastWriteTime - Supplies the last write time of the file.
+
+	FileSize - Supplies the size of the file.
+
+	Changes - Optionally receives a record of the change made, if any.  If no
+	          change list is supplied, the file is assumed to be new (i.e.
+	          this is the initial scan).
+
+Return Value:
+
+	The routine returns the file index of the directory entry for the file.
+	If the file is not of a recognized resource type, the count of directory
+	entries is returned instead.  An std::exception is raised on catastrophic
+	failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typename EntryIndexMap::iterator it;
+	DirectoryEntry                   Entry;
+	DirectoryChange                  Change;
+	std::string                      NameKey;
+	const char                     * FileName;
+	size_t                           Separator;
+	char                             Ext[ 32 ];
+	char                             ResName[ MAX_PATH ];
+	size_t                           Len;
+	FileId                           FileIndex;
+
+	//
+	// Check if this is a known resource type.
+	//
+
+	Separator = RelativePath.find_last_of( "\\/" );
+	FileName  = RelativePath.c_str( );
+
+	if (Separator != std::string::npos)
+		FileName += Separator + 1;
+
+	if (_splitpath_s(
+		FileName,
+		NULL,
+		0,
+		NULL,
+		0,
+		ResName,
+		sizeof( ResName ),
+		Ext,
+		sizeof( Ext )) || (Ext[ 0 ] == '\0'))
+	{
+		return (FileId) m_DirectoryEntries.size( );
+	}
+
+	Entry.Type = this->ExtToResType( Ext + 1 );
+
+	//
+	// Ignore unrecognized types.
+	//
+
+	if (Entry.Type == NWN::ResINVALID)
+		return (FileId) m_DirectoryEntries.size( );
+
+	Entry.PathKey = GetPathKey( RelativePath );
+
+	it = m_PathIndex.find( Entry.PathKey );
+
+	if (it != m_PathIndex.end( ))
+	{
+		DirectoryEntry & Existing = m_DirectoryEntries[ (size_t) it->second ];
+
+		FileIndex = it->second;
+
+		if (Existing.Present)
+		{
 			//
-			// Ignore unrecognized types.
+			// The file is already known; check whether it was modified.
 			//
 
-			if (Type == NWN::ResINVALID)
-				continue;
+			if ((Existing.LastWriteTime == LastWriteTime) &&
+			    (Existing.FileSize == FileSize))
+			{
+				return FileIndex;
+			}
 
+			Change.Action = DirectoryChangeModified;
+		}
+		else
+		{
 			//
-			// Create and append a directory entry for it.
+			// The file was re-created, so revive its vacant directory entry.
+			// The revived entry takes over the name from any other entry with
+			// a lower file index.
 			//
 
-			DirectoryEntry Entry;
+			NameKey = GetNameKey( Existing.Name, Existing.Type );
 
-			Entry.RealFileName  = Directory;
-			Entry.RealFileName += FindData.cFileName;
-			Entry.Type          = Type;
+			typename EntryIndexMap::iterator nit = m_NameIndex.find( NameKey );
 
-			Len = strlen( ResName );
+			if (nit == m_NameIndex.end( ))
+				m_NameIndex.insert( typename EntryIndexMap::value_type( NameKey, FileIndex ) );
+			else if (nit->second < FileIndex)
+				nit->second = FileIndex;
 
-			_strlwr( ResName );
+			Existing.Present = true;
+			Change.Action    = DirectoryChangeAdded;
+		}
 
-			ZeroMemory( &Entry.Name, sizeof( Entry.Name ) );
+		Existing.LastWriteTime = LastWriteTime;
+		Existing.FileSize      = FileSize;
 
-            memcpy( &Entry.Name, ResName, std::min( Len, sizeof( Entry.Name ) ) );
+		if (Changes != NULL)
+		{
+			Change.FileIndex = FileIndex;
+			Change.Name      = Existing.Name;
+			Change.Type      = Existing.Type;
 
-			m_DirectoryEntries.push_back( Entry );
+			Changes->push_back( Change );
+		}
 
-		} while (FindNextFileA( Find, &FindData ) );
+		return FileIndex;
+	}
+
+	//
+	// Create and append a directory entry for it.
+	//
+
+	Entry.RealFileName  = m_DirectoryName;
+	Entry.RealFileName += RelativePath;
+	Entry.Present       = true;
+	Entry.LastWriteTime = LastWriteTime;
+	Entry.FileSize      = FileSize;
+
+	Len = strlen( ResName );
+
+	_strlwr( ResName );
+
+	ZeroMemory( &Entry.Name, sizeof( Entry.Name ) );
+
+	memcpy( &Entry.Name, ResName, std::min( Len, sizeof( Entry.Name ) ) );
+
+	NameKey   = GetNameKey( Entry.Name, Entry.Type );
+	FileIndex = (FileId) m_DirectoryEntries.size( );
+
+	m_DirectoryEntries.push_back( Entry );
+
+	try
+	{
+		m_PathIndex.insert( typename EntryIndexMap::value_type( Entry.PathKey, FileIndex ) );
+
+		//
+		// The new entry has the highest file index, so it takes over the
+		// name from any other entry.
+		//
+
+		m_NameIndex[ NameKey ] = FileIndex;
+
+		if (Changes != NULL)
+		{
+			Change.Action    = DirectoryChangeAdded;
+			Change.FileIndex = FileIndex;
+			Change.Name      = Entry.Name;
+			Change.Type      = Entry.Type;
+
+			Changes->push_back( Change );
+		}
 	}
 	catch (...)
 	{
-		FindClose( Find );
+		m_PathIndex.erase( Entry.PathKey );
+		m_DirectoryEntries.pop_back( );
+
+		if (((it = m_NameIndex.find( NameKey )) != m_NameIndex.end( )) &&
+		    (it->second == FileIndex))
+		{
+			m_NameIndex.erase( it );
+		}
+
 		throw;
 	}
 
-	FindClose( Find );
+	return FileIndex;
+}
+
+template< typename ResRefT >
+void
+DirectoryFileReader< ResRefT >::RemoveFileEntry(
+	nwn2dev__in const std::string & RelativePath,
+	__inout DirectoryChangeVec & Changes
+	)
+/*++
+
+Routine Description:
+
+	This routine vacates the directory entry of a removed file.  If the path
+	does not name a known file, it is taken to name a removed subdirectory,
+	and every entry beneath it is vacated.
+
+Arguments:
+
+	RelativePath - Supplies the path of the removed file or directory relative
+	               to the directory.
+
+	Changes - Receives a record of each change made.
+
+Return Value:
+
+	None.  An std::exception is raised on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typename EntryIndexMap::const_iterator it;
+	std::string                            Prefix;
+
+	Prefix = GetPathKey( RelativePath );
+	it     = m_PathIndex.find( Prefix );
+
+	if (it != m_PathIndex.end( ))
+	{
+		if (m_DirectoryEntries[ (size_t) it->second ].Present)
+			VacateEntry( it->second, Changes );
+
+		return;
+	}
+
+	Prefix.push_back( '\\' );
+
+	for (size_t i = 0; i < m_DirectoryEntries.size( ); i += 1)
+	{
+		const DirectoryEntry & Entry = m_DirectoryEntries[ i ];
+
+		if ((Entry.Present) &&
+		    (!Entry.PathKey.compare( 0, Prefix.size( ), Prefix )))
+		{
+			VacateEntry( (FileId) i, Changes );
+		}
+	}
+}
+
+template< typename ResRefT >
+void
+DirectoryFileReader< ResRefT >::VacateEntry(
+	nwn2dev__in FileId FileIndex,
+	__inout DirectoryChangeVec & Changes
+	)
+/*++
+
+Routine Description:
+
+	This routine marks a directory entry as vacant (its file having been
+	removed), and hands its name over to the present entry with the same name
+	and the highest file index, if there is one.
+
+Arguments:
+
+	FileIndex - Supplies the file index of the entry to vacate.
+
+	Changes - Receives a record of the change.
+
+Return Value:
+
+	None.  An std::exception is raised on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typename EntryIndexMap::iterator   it;
+	DirectoryEntry                   & Entry = m_DirectoryEntries[ (size_t) FileIndex ];
+	DirectoryChange                    Change;
+
+	Change.Action    = DirectoryChangeRemoved;
+	Change.FileIndex = FileIndex;
+	Change.Name      = Entry.Name;
+	Change.Type      = Entry.Type;
+
+	Changes.push_back( Change );
+
+	Entry.Present = false;
+
+	it = m_NameIndex.find( GetNameKey( Entry.Name, Entry.Type ) );
+
+	if ((it == m_NameIndex.end( )) || (it->second != FileIndex))
+		return;
+
+	m_NameIndex.erase( it );
+
+	for (size_t i = m_DirectoryEntries.size( ); i != 0; i -= 1)
+	{
+		const DirectoryEntry & Other = m_DirectoryEntries[ i - 1 ];
+
+		if ((!Other.Present) ||
+		    (Other.Type != Entry.Type) ||
+		    (memcmp( &Other.Name, &Entry.Name, sizeof( Entry.Name ) )))
+		{
+			continue;
+		}
+
+		m_NameIndex.insert(
+			typename EntryIndexMap::value_type(
+				GetNameKey( Other.Name, Other.Type ),
+				(FileId) (i - 1) ) );
+
+		break;
+	}
+}
+
+template< typename ResRefT >
+void
+DirectoryFileReader< ResRefT >::ProcessFileNotification(
+	nwn2dev__in DWORD Action,
+	nwn2dev__in const std::string & RelativePath,
+	__inout DirectoryChangeVec & Changes
+	)
+/*++
+
+Routine Description:
+
+	This routine applies a single change notification to the directory
+	entries.  The current state of the file is re-examined rather than
+	trusted from the notification, as a notification may describe a file that
+	has since changed again.
+
+Arguments:
+
+	Action - Supplies the FILE_ACTION_* code of the notification.
+
+	RelativePath - Supplies the path of the changed file or directory,
+	               relative to the directory.
+
+	Changes - Receives a record of each change made.
+
+Return Value:
+
+	None.  An std::exception is raised on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	WIN32_FILE_ATTRIBUTE_DATA FileData;
+	std::string               Path;
+
+	switch (Action)
+	{
+
+	case FILE_ACTION_REMOVED:
+	case FILE_ACTION_RENAMED_OLD_NAME:
+		RemoveFileEntry( RelativePath, Changes );
+		break;
+
+	case FILE_ACTION_ADDED:
+	case FILE_ACTION_RENAMED_NEW_NAME:
+	case FILE_ACTION_MODIFIED:
+		Path  = m_DirectoryName;
+		Path += RelativePath;
+
+		//
+		// If the file is already gone again, a removal notification follows.
+		//
+
+		if (!GetFileAttributesExA( Path.c_str( ), GetFileExInfoStandard, &FileData ))
+			break;
+
+		if (FileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			//
+			// A directory that appears (e.g. by being moved into the tree)
+			// brings its contents with it without further notifications.
+			//
+
+			if (Action != FILE_ACTION_MODIFIED)
+			{
+				Path += "//";
+
+				ScanDirectory( Path, RelativePath + "\\", 1, &Changes, NULL );
+			}
+
+			break;
+		}
+
+		UpdateFileEntry(
+			RelativePath,
+			((ULONGLONG) FileData.ftLastWriteTime.dwHighDateTime << 32) |
+			 (ULONGLONG) FileData.ftLastWriteTime.dwLowDateTime,
+			((ULONGLONG) FileData.nFileSizeHigh << 32) |
+			 (ULONGLONG) FileData.nFileSizeLow,
+			&Changes);
+		break;
+
+	default:
+		break;
+
+	}
+}
+
+template< typename ResRefT >
+bool
+DirectoryFileReader< ResRefT >::IssueWatchRead(
+	)
+/*++
+
+Routine Description:
+
+	This routine issues an asynchronous change notification read against the
+	directory tree.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns true if the read was issued, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ZeroMemory( &m_WatchOverlapped, sizeof( m_WatchOverlapped ) );
+
+	m_WatchOverlapped.hEvent = m_WatchEvent;
+
+	m_WatchPending = ReadDirectoryChangesW(
+		m_WatchHandle,
+		&m_WatchBuffer[ 0 ],
+		(DWORD) (m_WatchBuffer.size( ) * sizeof( DWORD )),
+		TRUE,
+		FILE_NOTIFY_CHANGE_FILE_NAME |
+		FILE_NOTIFY_CHANGE_DIR_NAME |
+		FILE_NOTIFY_CHANGE_SIZE |
+		FILE_NOTIFY_CHANGE_LAST_WRITE,
+		NULL,
+		&m_WatchOverlapped,
+		NULL) ? true : false;
+
+	return m_WatchPending;
+}
+
+template< typename ResRefT >
+std::string
+DirectoryFileReader< ResRefT >::GetNameKey(
+	nwn2dev__in const ResRefT & Name,
+	nwn2dev__in ResType Type
+	)
+/*++
+
+Routine Description:
+
+	This routine forms the name index key of a resource.
+
+Arguments:
+
+	Name - Supplies the resource name.
+
+	Type - Supplies the resource type.
+
+Return Value:
+
+	The name index key.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::string   Key;
+	char          TypeStr[ 32 ];
+	const char  * p;
+
+	Key = _itoa( (int) Type, TypeStr, 10 );
+	Key.push_back( 'T' );
+
+	p = (const char *) memchr(
+		Name.RefStr,
+		'\0',
+		sizeof( Name.RefStr ) );
+
+	if (p == NULL)
+		Key.append( Name.RefStr, sizeof( Name.RefStr ) );
+	else
+		Key.append( Name.RefStr, p - Name.RefStr );
+
+	for (size_t i = 0; i < Key.size( ); i += 1)
+		Key[ i ] = (char) tolower( (int) (unsigned char) Key[ i ] );
+
+	return Key;
+}
+
+template< typename ResRefT >
+std::string
+DirectoryFileReader< ResRefT >::GetPathKey(
+	nwn2dev__in const std::string & RelativePath
+	)
+/*++
+
+Routine Description:
+
+	This routine forms the path index key of a relative path:  the path is
+	converted to lowercase, with a single '\\' between path components.
+
+Arguments:
+
+	RelativePath - Supplies the path relative to the directory.
+
+Return Value:
+
+	The path index key.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::string Key;
+
+	Key.reserve( RelativePath.size( ) );
+
+	for (size_t i = 0; i < RelativePath.size( ); i += 1)
+	{
+		char c = RelativePath[ i ];
+
+		if ((c == '/') || (c == '\\'))
+		{
+			if ((Key.empty( )) || (Key[ Key.size( ) - 1 ] == '\\'))
+				continue;
+
+			c = '\\';
+		}
+
+		Key.push_back( (char) tolower( (int) (unsigned char) c ) );
+	}
+
+	return Key;
 }
 
-// template DirectoryFileReader< NWN::ResRef32 >;
+template class DirectoryFileReader< NWN::ResRef32 >;
+template class DirectoryFileReader< NWN::ResRef16 >;
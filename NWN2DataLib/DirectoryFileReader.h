@@ -12,6 +12,12 @@ Abstract:
 	allows resource load requests to be serviced against a directory instead of
 	an ERF file.
 
+	The directory is scanned once when the reader is created.  Thereafter, the
+	reader may optionally watch the directory for changes, and apply them to
+	its directory entries incrementally as they are polled (see PollChanges).
+	File indicies are stable:  a removed file leaves a vacant directory entry
+	behind, which is reused should the file be re-created.
+
 --*/
 
 #ifndef _PROGRAMS_NWN2DATALIB_DIRECTORYFILEREADER_H
@@ -22,17 +28,42 @@ Abstract:
 #endif
 
 #include "ResourceAccessor.h"
+#include "ResourceStatistics.h"
 
 //
 // Define the directory file reader object, used to access directory files.
 //
 
 template< typename ResRefT >
-class DirectoryFileReader : public IResourceAccessor< ResRefT >
+class DirectoryFileReader : public IResourceAccessor< ResRefT >,
+                            public ResourceStatisticsClient
 {
 
 public:
 
+	//
+	// Define the types of directory change reported by PollChanges.
+	//
+
+	typedef enum _DIRECTORY_CHANGE_TYPE
+	{
+		DirectoryChangeAdded,
+		DirectoryChangeRemoved,
+		DirectoryChangeModified,
+
+		LastDirectoryChangeType
+	} DIRECTORY_CHANGE_TYPE, * PDIRECTORY_CHANGE_TYPE;
+
+	struct DirectoryChange
+	{
+		DIRECTORY_CHANGE_TYPE Action;
+		FileId                FileIndex;
+		ResRefT               Name;
+		ResType               Type;
+	};
+
+	typedef std::vector< DirectoryChange > DirectoryChangeVec;
+
 	//
 	// Constructor.  Raises an std::exception on catastrophic failure.
 	//
@@ -176,29 +207,199 @@ public:
 		return m_DirectoryEntries[ (size_t) FileIndex ].RealFileName;
 	}
 
+	//
+	// Begin watching the directory (and its subdirectories) for changes.
+	// Once enabled, changes are reported by PollChanges.  Any change made
+	// since the directory was first scanned is reported by the first poll.
+	//
+	// The routine returns false if the directory could not be watched.
+	//
+
+	bool
+	EnableChangeNotification(
+		);
+
+	//
+	// Return an event that is signaled when changes are available to be
+	// polled, or NULL if change notification is not enabled.
+	//
+
+	inline
+	HANDLE
+	GetChangeNotificationEvent(
+		) const
+	{
+		return m_WatchEvent;
+	}
+
+	//
+	// Apply any changes made to the directory since the last poll to the
+	// directory entries, appending a record of each change to Changes.  The
+	// routine does not wait for changes, and returns true if any change was
+	// applied.  An std::exception is raised on catastrophic failure.
+	//
+	// The routine updates the directory entries, so it must not be called
+	// concurrently with any other call on the reader.
+	//
+
+	bool
+	PollChanges(
+		__inout DirectoryChangeVec & Changes
+		);
+
 private:
 
 	//
-	// Scan directories to create directory file entries.
+	// Define the size of the change notification buffer, in DWORDs.
+	//
+
+	enum
+	{
+		WATCH_BUFFER_SIZE = 16384
+	};
+
+	//
+	// Scan directories to create directory file entries.  If a change list
+	// is supplied, the scan is a rescan of an already-scanned directory:
+	// changes are recorded against the existing directory entries, and each
+	// directory entry that is found is marked in Seen.
 	//
 
 	void
 	ScanDirectory(
 		nwn2dev__in const std::string & Directory,
-		nwn2dev__in size_t RecursionLevel
+		nwn2dev__in const std::string & RelativeDirectory,
+		nwn2dev__in size_t RecursionLevel,
+		__inout_opt DirectoryChangeVec * Changes,
+		__inout_opt std::vector< bool > * Seen
+		);
+
+	//
+	// Rescan the entire directory, recording the differences against the
+	// current directory entries as changes.  This is used when the change
+	// notification buffer overflows.
+	//
+
+	void
+	RescanDirectory(
+		__inout DirectoryChangeVec & Changes
+		);
+
+	//
+	// Create or update the directory entry for a file, given its path
+	// relative to the directory.  A change is recorded if a change list is
+	// supplied.  The routine returns the file index of the directory entry,
+	// or the count of directory entries if the file is not a resource.
+	//
+
+	FileId
+	UpdateFileEntry(
+		nwn2dev__in const std::string & RelativePath,
+		nwn2dev__in ULONGLONG LastWriteTime,
+		nwn2dev__in ULONGLONG FileSize,
+		__inout_opt DirectoryChangeVec * Changes
+		);
+
+	//
+	// Vacate the directory entry for a file (or for every file under a
+	// directory), given its path relative to the directory.
+	//
+
+	void
+	RemoveFileEntry(
+		nwn2dev__in const std::string & RelativePath,
+		__inout DirectoryChangeVec & Changes
+		);
+
+	//
+	// Vacate a single directory entry and record the change.
+	//
+
+	void
+	VacateEntry(
+		nwn2dev__in FileId FileIndex,
+		__inout DirectoryChangeVec & Changes
+		);
+
+	//
+	// Process a file change notification for a path relative to the
+	// directory.
+	//
+
+	void
+	ProcessFileNotification(
+		nwn2dev__in DWORD Action,
+		nwn2dev__in const std::string & RelativePath,
+		__inout DirectoryChangeVec & Changes
+		);
+
+	//
+	// Issue a change notification read against the directory.  The routine
+	// returns false on failure.
+	//
+
+	bool
+	IssueWatchRead(
+		);
+
+	//
+	// Form the lookup key for a resource name and type (in the same
+	// '<type>T<resref>' form as the resource manager index), or for a
+	// relative path (lowercase, with '\' separators).
+	//
+
+	static
+	std::string
+	GetNameKey(
+		nwn2dev__in const ResRefT & Name,
+		nwn2dev__in ResType Type
+		);
+
+	static
+	std::string
+	GetPathKey(
+		nwn2dev__in const std::string & RelativePath
 		);
 
 	struct DirectoryEntry
 	{
 		std::string RealFileName;
+		std::string PathKey;
 		ResRefT     Name;
 		ResType     Type;
+		bool        Present;
+		ULONGLONG   LastWriteTime;
+		ULONGLONG   FileSize;
 	};
 
 	typedef std::vector< DirectoryEntry > DirectoryEntryVec;
+	typedef std::unordered_map< std::string, FileId > EntryIndexMap;
+
+	DirectoryEntryVec    m_DirectoryEntries;
+	std::string          m_DirectoryName;
+
+	//
+	// Hashed indicies of the directory entries, by resource name and type
+	// (present entries only, for OpenFile) and by relative path (all
+	// entries, for change processing).  When a resource name appears in
+	// more than one subdirectory, the name index refers to the entry with
+	// the highest file index, which is the entry that the resource manager
+	// index selects.
+	//
+
+	EntryIndexMap        m_NameIndex;
+	EntryIndexMap        m_PathIndex;
+
+	//
+	// Change notification state.
+	//
 
-	DirectoryEntryVec m_DirectoryEntries;
-	std::string       m_DirectoryName;
+	HANDLE               m_WatchHandle;
+	HANDLE               m_WatchEvent;
+	OVERLAPPED           m_WatchOverlapped;
+	bool                 m_WatchPending;
+	std::vector< DWORD > m_WatchBuffer;
+	DirectoryChangeVec   m_InitialChanges;
 
 };
 
@@ -44,7 +44,6 @@ Environment:
 --*/
 : m_File( INVALID_HANDLE_VALUE ),
   m_FileSize( 0 ),
-  m_NextOffset( 0 ),
   m_FileName( FileName )
 {
 	HANDLE File;
@@ -283,7 +282,9 @@ Routine Description:
 
 	This routine logically reads an encapsulated sub-file within the ERF file.
 
-	File reading is optimized for sequential scan.
+	Reads are issued at explicit file offsets (or copied directly from the
+	view if the ERF is mapped), so the routine may be called concurrently
+	from multiple threads.
 
 Arguments:
 
@@ -311,7 +312,6 @@ Environment:
 --*/
 {
 	PCRESOURCE_LIST_ELEMENT ResElem;
-	ULONGLONG               NextOffset;
 
 	ResElem = LookupResourceDirectory( ((ResID) File) - 1 );
 
@@ -325,29 +325,28 @@ Environment:
 
     BytesToRead = std::min( BytesToRead, ResElem->ResourceSize - Offset);
 
+	ResourceStatistics::ScopedOperation StatOp(
+		m_Statistics,
+		m_StatSource,
+		ResourceStatistics::OpRead);
+
 	try
 	{
-		NextOffset = (ULONGLONG) ResElem->OffsetToResource + Offset;
-
-		if (NextOffset != m_NextOffset)
-		{
-			m_FileWrapper.SeekOffset(
-				NextOffset,
-				"OffsetToResource + Offset");
-
-			m_NextOffset = NextOffset;
-		}
-
-		m_FileWrapper.ReadFile( Buffer, BytesToRead, "File Contents" );
-
-		m_NextOffset += BytesToRead;
+		m_FileWrapper.ReadFileAtOffset(
+			Buffer,
+			BytesToRead,
+			(ULONGLONG) ResElem->OffsetToResource + Offset,
+			"File Contents");
 
 		*BytesRead = BytesToRead;
 
+		StatOp.SetBytes( BytesToRead );
+
 		return true;
 	}
 	catch (std::exception)
 	{
+		StatOp.Cancel( );
 		return false;
 	}
 }
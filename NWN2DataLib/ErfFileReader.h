@@ -22,6 +22,7 @@ Abstract:
 #endif
 
 #include "ResourceAccessor.h"
+#include "ResourceStatistics.h"
 #include "FileWrapper.h"
 
 template< typename ResRefT >
@@ -32,7 +33,8 @@ class ErfFileWriter;
 //
 
 template< typename ResRefT >
-class ErfFileReader : public IResourceAccessor< NWN::ResRef32 >
+class ErfFileReader : public IResourceAccessor< NWN::ResRef32 >,
+                      public ResourceStatisticsClient
 {
 
 public:
@@ -94,8 +96,8 @@ public:
 		);
 
 	//
-	// Read an encapsulated file by file handle.  The routine is optimized to
-	// operate for sequential file reads.
+	// Read an encapsulated file by file handle.  Reads are positional, so
+	// they may be issued concurrently from multiple threads.
 	//
 
 	virtual
@@ -291,7 +293,6 @@ private:
 	HANDLE             m_File;
 	unsigned long      m_FileSize;
 	FileWrapper        m_FileWrapper;
-	ULONGLONG          m_NextOffset;
 	std::string        m_FileName;
 
 	//
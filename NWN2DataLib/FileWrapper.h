@@ -179,6 +179,125 @@ public:
 		throw std::runtime_error( ExMsg );
 	}
 
+	//
+	// Return a pointer to the next Length bytes of a file that is mapped as a
+	// section (or supplied as an external view), and advance the current
+	// offset past them.  The caller must first check IsMapped.
+	//
+
+	inline
+	const unsigned char *
+	ReadFileView(
+		nwn2dev__in size_t Length,
+		nwn2dev__in const char * Description
+		)
+	{
+		const unsigned char * Data;
+		char                  ExMsg[ 64 ];
+
+		if ((m_View == NULL) ||
+		    (m_Offset + Length < m_Offset) ||
+		    (m_Offset + Length > m_Size))
+		{
+			StringCbPrintfA(
+				ExMsg,
+				sizeof( ExMsg ),
+				"ReadFileView( %s ) failed.",
+				Description);
+
+			throw std::runtime_error( ExMsg );
+		}
+
+		Data      = &m_View[ m_Offset ];
+		m_Offset += Length;
+
+		return Data;
+	}
+
+	//
+	// Read data from an explicit file offset, without using or updating the
+	// current offset.  Reads may thus be issued concurrently from multiple
+	// threads against the same file wrapper.
+	//
+
+	inline
+	void
+	ReadFileAtOffset(
+		__out_bcount( Length ) void * Buffer,
+		nwn2dev__in size_t Length,
+		nwn2dev__in ULONGLONG Offset,
+		nwn2dev__in const char * Description
+		) const
+	{
+		OVERLAPPED Overlapped;
+		DWORD      Transferred;
+		char       ExMsg[ 64 ];
+
+		if (m_View != NULL)
+		{
+			if ((Offset + Length < Offset) ||
+			    (Offset + Length > m_Size))
+			{
+				StringCbPrintfA(
+					ExMsg,
+					sizeof( ExMsg ),
+					"ReadFileAtOffset( %s ) failed.",
+					Description);
+
+				throw std::runtime_error( ExMsg );
+			}
+
+			memcpy( Buffer, &m_View[ Offset ], Length );
+			return;
+		}
+
+		ZeroMemory( &Overlapped, sizeof( Overlapped ) );
+
+		Overlapped.Offset     = (DWORD) ((Offset >>  0) & 0xFFFFFFFF);
+		Overlapped.OffsetHigh = (DWORD) ((Offset >> 32) & 0xFFFFFFFF);
+
+		if ((Length <= 0xFFFFFFFF) &&
+		    (::ReadFile(
+				m_File,
+				Buffer,
+				(DWORD) Length,
+				&Transferred,
+				&Overlapped)) &&
+		    (Transferred == (DWORD) Length))
+		{
+			return;
+		}
+
+		StringCbPrintfA(
+			ExMsg,
+			sizeof( ExMsg ),
+			"ReadFileAtOffset( %s ) failed.",
+			Description);
+
+		throw std::runtime_error( ExMsg );
+	}
+
+	//
+	// Return the base of the mapped view of the file, or NULL if the file is
+	// not mapped.  The view spans GetFileSize bytes.
+	//
+
+	inline
+	const unsigned char *
+	GetView(
+		) const
+	{
+		return m_View;
+	}
+
+	inline
+	bool
+	IsMapped(
+		) const
+	{
+		return m_View != NULL;
+	}
+
 	//
 	// Seek to a particular file offset.
 	//
@@ -326,6 +326,16 @@ Environment:
 	if (FileHandle == INVALID_FILE)
 		return false;
 
+	//
+	// BIF reads are attributed to the KEY file, as the BIF files are not
+	// themselves visible to the resource manager.
+	//
+
+	ResourceStatistics::ScopedOperation StatOp(
+		m_Statistics,
+		m_StatSource,
+		ResourceStatistics::OpRead);
+
 	Status = ResKey->BifFile->ReadEncapsulatedFile(
 		FileHandle,
 		Offset,
@@ -333,6 +343,11 @@ Environment:
 		BytesRead,
 		Buffer);
 
+	if (Status)
+		StatOp.SetBytes( *BytesRead );
+	else
+		StatOp.Cancel( );
+
 	ResKey->BifFile->CloseFile( FileHandle );
 	FileHandle = INVALID_FILE;
 
@@ -609,6 +624,121 @@ Environment:
 	return Type;
 }
 
+template< typename ResRefT >
+bool
+KeyFileReader< ResRefT >::GetEncapsulatedFileView(
+	nwn2dev__in FileHandle File,
+	nwn2dev__out const unsigned char * * View,
+	nwn2dev__out size_t * ViewSize
+	)
+/*++
+
+Routine Description:
+
+	This routine returns a read-only view of the contents of an encapsulated
+	sub-file within a BIF file that is attached to the KEY file.  No data is
+	copied.
+
+Arguments:
+
+	File - Supplies a file handle to the desired sub-file.
+
+	View - Receives the address of the first byte of the sub-file.
+
+	ViewSize - Receives the size of the sub-file, in bytes.
+
+Return Value:
+
+	The routine returns a Boolean value indicating true on success, else false
+	if the file handle is invalid or the containing BIF is not mapped.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	PCKEY_RESOURCE_DESCRIPTOR  ResKey;
+	BifFileReaderT::FileHandle FileHandle;
+	bool                       Status;
+
+	*View     = NULL;
+	*ViewSize = 0;
+
+	ResKey = LookupResourceKey( ((ResID) File) - 1 );
+
+	if (ResKey == NULL)
+		return false;
+
+	//
+	// Delegate the request to the containing BIF file.  As with reads, BIF
+	// file open and close calls are essentially no-ops.
+	//
+
+	FileHandle = ResKey->BifFile->OpenFileByIndex(
+		ResKey->Res.ResID & 0xFFFFF );
+
+	if (FileHandle == INVALID_FILE)
+		return false;
+
+	Status = ResKey->BifFile->GetEncapsulatedFileView(
+		FileHandle,
+		View,
+		ViewSize);
+
+	ResKey->BifFile->CloseFile( FileHandle );
+	FileHandle = INVALID_FILE;
+
+	return Status;
+}
+
+template< typename ResRefT >
+void
+KeyFileReader< ResRefT >::PrefetchEncapsulatedFile(
+	nwn2dev__in FileHandle File
+	)
+/*++
+
+Routine Description:
+
+	This routine requests that the pages backing an encapsulated sub-file
+	within a BIF file that is attached to the KEY file be read in ahead of a
+	sequential scan of the sub-file.  The request is advisory only.
+
+Arguments:
+
+	File - Supplies a file handle to the desired sub-file.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	PCKEY_RESOURCE_DESCRIPTOR  ResKey;
+	BifFileReaderT::FileHandle FileHandle;
+
+	ResKey = LookupResourceKey( ((ResID) File) - 1 );
+
+	if (ResKey == NULL)
+		return;
+
+	FileHandle = ResKey->BifFile->OpenFileByIndex(
+		ResKey->Res.ResID & 0xFFFFF );
+
+	if (FileHandle == INVALID_FILE)
+		return;
+
+	ResKey->BifFile->PrefetchEncapsulatedFile( FileHandle );
+
+	ResKey->BifFile->CloseFile( FileHandle );
+	FileHandle = INVALID_FILE;
+}
+
 template< typename ResRefT >
 void
 KeyFileReader< ResRefT >::ParseKeyFile(
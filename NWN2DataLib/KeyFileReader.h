@@ -21,6 +21,7 @@ Abstract:
 #endif
 
 #include "ResourceAccessor.h"
+#include "ResourceStatistics.h"
 #include "FileWrapper.h"
 
 template< typename ResRefT > class BifFileReader;
@@ -30,7 +31,8 @@ template< typename ResRefT > class BifFileReader;
 //
 
 template< typename ResRefT >
-class KeyFileReader : public IResourceAccessor< NWN::ResRef32 >
+class KeyFileReader : public IResourceAccessor< NWN::ResRef32 >,
+                      public ResourceStatisticsClient
 {
 
 public:
@@ -160,6 +162,29 @@ public:
 		nwn2dev__out std::string & AccessorName
 		);
 
+	//
+	// Return a read-only view of the contents of an encapsulated file, which
+	// remains valid for the lifetime of the reader.  The routine returns false
+	// if the containing BIF is not mapped, in which case the caller should
+	// fall back to ReadEncapsulatedFile.
+	//
+
+	bool
+	GetEncapsulatedFileView(
+		nwn2dev__in FileHandle File,
+		nwn2dev__out const unsigned char * * View,
+		nwn2dev__out size_t * ViewSize
+		);
+
+	//
+	// Hint that an encapsulated file is about to be scanned sequentially.
+	//
+
+	void
+	PrefetchEncapsulatedFile(
+		nwn2dev__in FileHandle File
+		);
+
 private:
 
 	//
@@ -0,0 +1,654 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	MeshBVH.cpp
+
+Abstract:
+
+	This module houses the MeshBVH class implementation, which supports the
+	construction of a triangle bounding volume hierarchy and ray and box
+	queries against it.
+
+--*/
+
+#include "Precomp.h"
+#include "../NWNBaseLib/NWNBaseLib.h"
+#include "../NWN2MathLib/NWN2MathLib.h"
+#include "MeshBVH.h"
+
+#include <algorithm>
+
+namespace
+{
+
+	//
+	// Order triangles along one axis by centroid.
+	//
+
+	template< typename TriangleT >
+	struct CentroidLess
+	{
+		inline
+		CentroidLess(
+			nwn2dev__in const std::vector< NWN::Vector3 > & Centroids,
+			nwn2dev__in int Axis
+			)
+		: m_Centroids( Centroids ),
+		  m_Axis( Axis )
+		{
+		}
+
+		inline
+		bool
+		operator()(
+			nwn2dev__in const TriangleT & t1,
+			nwn2dev__in const TriangleT & t2
+			) const
+		{
+			return (&m_Centroids[ t1.Id ].x)[ m_Axis ] <
+			       (&m_Centroids[ t2.Id ].x)[ m_Axis ];
+		}
+
+		const std::vector< NWN::Vector3 > & m_Centroids;
+		int                                 m_Axis;
+
+	private:
+
+		CentroidLess & operator=( const CentroidLess & );
+	};
+
+	inline
+	void
+	ExtendBounds(
+		__inout NWN::Vector3 & MinBound,
+		__inout NWN::Vector3 & MaxBound,
+		nwn2dev__in const NWN::Vector3 & v
+		)
+	{
+		if (v.x < MinBound.x)
+			MinBound.x = v.x;
+		if (v.y < MinBound.y)
+			MinBound.y = v.y;
+		if (v.z < MinBound.z)
+			MinBound.z = v.z;
+		if (v.x > MaxBound.x)
+			MaxBound.x = v.x;
+		if (v.y > MaxBound.y)
+			MaxBound.y = v.y;
+		if (v.z > MaxBound.z)
+			MaxBound.z = v.z;
+	}
+
+	//
+	// Slab test a ray against a box, returning the entry distance.  Unlike
+	// Math::QuickBox, the entry distance is needed to order traversal.
+	//
+
+	inline
+	bool
+	IntersectRayBox(
+		nwn2dev__in const NWN::Vector3 & Origin,
+		nwn2dev__in const NWN::Vector3 & InvDir,
+		nwn2dev__in const NWN::Vector3 & MinBound,
+		nwn2dev__in const NWN::Vector3 & MaxBound,
+		nwn2dev__in float MaxT,
+		nwn2dev__out float & TEnter
+		)
+	{
+		float t0;
+		float t1;
+		float tmin;
+		float tmax;
+
+		t0   = (MinBound.x - Origin.x) * InvDir.x;
+		t1   = (MaxBound.x - Origin.x) * InvDir.x;
+		tmin = min( t0, t1 );
+		tmax = max( t0, t1 );
+
+		t0   = (MinBound.y - Origin.y) * InvDir.y;
+		t1   = (MaxBound.y - Origin.y) * InvDir.y;
+		tmin = max( tmin, min( t0, t1 ) );
+		tmax = min( tmax, max( t0, t1 ) );
+
+		t0   = (MinBound.z - Origin.z) * InvDir.z;
+		t1   = (MaxBound.z - Origin.z) * InvDir.z;
+		tmin = max( tmin, min( t0, t1 ) );
+		tmax = min( tmax, max( t0, t1 ) );
+
+		if ((tmax < 0.0f) || (tmin > tmax) || (tmin > MaxT))
+			return false;
+
+		TEnter = tmin;
+
+		return true;
+	}
+
+	inline
+	bool
+	BoxesOverlap(
+		nwn2dev__in const NWN::Vector3 & MinBound1,
+		nwn2dev__in const NWN::Vector3 & MaxBound1,
+		nwn2dev__in const NWN::Vector3 & MinBound2,
+		nwn2dev__in const NWN::Vector3 & MaxBound2
+		)
+	{
+		return (MinBound1.x <= MaxBound2.x) && (MaxBound1.x >= MinBound2.x) &&
+		       (MinBound1.y <= MaxBound2.y) && (MaxBound1.y >= MinBound2.y) &&
+		       (MinBound1.z <= MaxBound2.z) && (MaxBound1.z >= MinBound2.z);
+	}
+}
+
+void
+MeshBVH::Build(
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs the hierarchy over the triangles that have been
+	added to the MeshBVH.  Triangles are split at the centroid median of the
+	longest axis of each node until a node holds no more than
+	MAX_LEAF_TRIANGLES triangles.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	PointVec Centroids;
+
+	m_Nodes.clear( );
+	m_TriangleSlots.clear( );
+
+	if (m_Triangles.empty( ))
+		return;
+
+	if (m_Triangles.size( ) >= ULONG_MAX)
+		throw std::exception( "Too many triangles for MeshBVH" );
+
+	Centroids.resize( m_Triangles.size( ) );
+
+	for (TriangleVec::const_iterator it = m_Triangles.begin( );
+	     it != m_Triangles.end( );
+	     ++it)
+	{
+		NWN::Vector3 Centroid;
+
+		for (size_t i = 0; i < 3; i += 1)
+		{
+			if (it->Corners[ i ] >= m_Points.size( ))
+				throw std::exception( "Illegal MeshBVH triangle corner" );
+		}
+
+		Centroid = Math::Add(
+			Math::Add( m_Points[ it->Corners[ 0 ] ], m_Points[ it->Corners[ 1 ] ] ),
+			m_Points[ it->Corners[ 2 ] ] );
+
+		Centroids[ it->Id ] = Math::Multiply( Centroid, 1.0f / 3.0f );
+	}
+
+	//
+	// A binary hierarchy with leaves of at least one triangle has fewer than
+	// twice as many nodes as there are triangles.
+	//
+
+	m_Nodes.reserve( 2 * m_Triangles.size( ) );
+	m_Nodes.push_back( BVH_NODE( ) );
+
+	BuildNode( 0, 0, m_Triangles.size( ), 0, Centroids );
+
+	m_MinBound = m_Nodes[ 0 ].MinBound;
+	m_MaxBound = m_Nodes[ 0 ].MaxBound;
+
+	m_TriangleSlots.resize( m_Triangles.size( ) );
+
+	for (size_t i = 0; i < m_Triangles.size( ); i += 1)
+		m_TriangleSlots[ m_Triangles[ i ].Id ] = (unsigned long) i;
+}
+
+void
+MeshBVH::BuildNode(
+	nwn2dev__in size_t NodeIndex,
+	nwn2dev__in size_t First,
+	nwn2dev__in size_t Count,
+	nwn2dev__in size_t Depth,
+	nwn2dev__in const PointVec & Centroids
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the bounds of a node and, if the node holds more than
+	a leaf's worth of triangles, splits it into two child nodes.
+
+Arguments:
+
+	NodeIndex - Supplies the index of the (already allocated) node to build.
+
+	First - Supplies the first triangle covered by the node.
+
+	Count - Supplies the count of triangles covered by the node.
+
+	Depth - Supplies the depth of the node in the hierarchy.
+
+	Centroids - Supplies the triangle centroids, indexed by triangle id.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	NWN::Vector3 MinBound;
+	NWN::Vector3 MaxBound;
+	NWN::Vector3 CMinBound;
+	NWN::Vector3 CMaxBound;
+	NWN::Vector3 Extent;
+	int          Axis;
+	size_t       Half;
+	size_t       Left;
+
+	MinBound.x = MinBound.y = MinBound.z = +FLT_MAX;
+	MaxBound.x = MaxBound.y = MaxBound.z = -FLT_MAX;
+	CMinBound  = MinBound;
+	CMaxBound  = MaxBound;
+
+	for (size_t i = First; i < First + Count; i += 1)
+	{
+		const BVH_TRIANGLE & Triangle = m_Triangles[ i ];
+
+		for (size_t j = 0; j < 3; j += 1)
+			ExtendBounds( MinBound, MaxBound, m_Points[ Triangle.Corners[ j ] ] );
+
+		ExtendBounds( CMinBound, CMaxBound, Centroids[ Triangle.Id ] );
+	}
+
+	m_Nodes[ NodeIndex ].MinBound = MinBound;
+	m_Nodes[ NodeIndex ].MaxBound = MaxBound;
+
+	if ((Count <= MAX_LEAF_TRIANGLES) || (Depth + 1 >= MAX_DEPTH))
+	{
+		m_Nodes[ NodeIndex ].Offset = (unsigned long) First;
+		m_Nodes[ NodeIndex ].Count  = (unsigned long) Count;
+		return;
+	}
+
+	//
+	// Split along the longest axis of the centroid bounds.
+	//
+
+	Extent = Math::Subtract( CMaxBound, CMinBound );
+	Axis   = 0;
+
+	if (Extent.y > Extent.x)
+		Axis = 1;
+	if (Extent.z > (&Extent.x)[ Axis ])
+		Axis = 2;
+
+	Half = Count / 2;
+
+	std::nth_element(
+		m_Triangles.begin( ) + First,
+		m_Triangles.begin( ) + First + Half,
+		m_Triangles.begin( ) + First + Count,
+		CentroidLess< BVH_TRIANGLE >( Centroids, Axis ) );
+
+	//
+	// Allocate the left child directly after this node, and the right child
+	// after the entire left subtree.
+	//
+
+	Left = m_Nodes.size( );
+	m_Nodes.push_back( BVH_NODE( ) );
+
+	BuildNode( Left, First, Half, Depth + 1, Centroids );
+
+	m_Nodes[ NodeIndex ].Offset = (unsigned long) m_Nodes.size( );
+	m_Nodes[ NodeIndex ].Count  = 0;
+
+	m_Nodes.push_back( BVH_NODE( ) );
+
+	BuildNode(
+		m_Nodes[ NodeIndex ].Offset,
+		First + Half,
+		Count - Half,
+		Depth + 1,
+		Centroids);
+}
+
+bool
+MeshBVH::IntersectTriangle(
+	nwn2dev__in const BVH_TRIANGLE & Triangle,
+	nwn2dev__in const NWN::Vector3 & Origin,
+	nwn2dev__in const NWN::Vector3 & Dir,
+	nwn2dev__out float & T
+	) const
+/*++
+
+Routine Description:
+
+	This routine intersects a ray with a single triangle of the hierarchy,
+	honoring the backface rejection policy of the hierarchy.
+
+Arguments:
+
+	Triangle - Supplies the triangle to test.
+
+	Origin - Supplies the ray origin.
+
+	Dir - Supplies the ray direction.
+
+	T - Receives the intersection distance on success.
+
+Return Value:
+
+	The routine returns a Boolean value indicating whether an intersection was
+	detected or not.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	NWN::Vector3 Tri[ 3 ];
+
+	Tri[ 0 ] = m_Points[ Triangle.Corners[ 0 ] ];
+	Tri[ 1 ] = m_Points[ Triangle.Corners[ 1 ] ];
+	Tri[ 2 ] = m_Points[ Triangle.Corners[ 2 ] ];
+
+	if (m_RejectBackfaces)
+		return Math::IntersectRayTriRejectBackface( Origin, Dir, Tri, T );
+	else
+		return Math::IntersectRayTri( Origin, Dir, Tri, T );
+}
+
+bool
+MeshBVH::IntersectRay(
+	nwn2dev__in const NWN::Vector3 & Origin,
+	nwn2dev__in const NWN::Vector3 & Dir,
+	nwn2dev__in float MaxT,
+	nwn2dev__out float & T,
+	__out_opt TriangleIndex * HitTriangle
+	) const
+/*++
+
+Routine Description:
+
+	This routine performs a hit-test between a ray and the triangles of the
+	hierarchy.  Nodes are visited front to back so that the closest hit can be
+	used to prune the remainder of the traversal.
+
+Arguments:
+
+	Origin - Supplies the origin of the hit test ray.
+
+	Dir - Supplies the direction of the hit test ray, which need not be
+	      normalized.
+
+	MaxT - Supplies the maximum distance (in multiples of Dir) at which an
+	       intersection is considered.
+
+	T - Receives the distance of the intersection, on successful intersection.
+
+	HitTriangle - Optionally receives the insertion index of the intersected
+	              triangle.  If not supplied, the routine returns on the first
+	              intersection found rather than the closest.
+
+Return Value:
+
+	The routine returns a Boolean value indicating whether an intersection was
+	detected or not.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned long Stack[ MAX_DEPTH + 1 ];
+	size_t        StackDepth;
+	NWN::Vector3  InvDir;
+	float         BestT;
+	float         TEnter;
+	bool          Intersected;
+
+	if (m_Nodes.empty( ))
+		return false;
+
+	InvDir.x = 1.0f / Dir.x;
+	InvDir.y = 1.0f / Dir.y;
+	InvDir.z = 1.0f / Dir.z;
+
+	if (!IntersectRayBox(
+		Origin,
+		InvDir,
+		m_Nodes[ 0 ].MinBound,
+		m_Nodes[ 0 ].MaxBound,
+		MaxT,
+		TEnter))
+	{
+		return false;
+	}
+
+	BestT       = MaxT;
+	Intersected = false;
+	StackDepth  = 0;
+
+	Stack[ StackDepth++ ] = 0;
+
+	while (StackDepth != 0)
+	{
+		const BVH_NODE & Node = m_Nodes[ Stack[ --StackDepth ] ];
+
+		if (Node.Count != 0)
+		{
+			for (unsigned long i = Node.Offset; i < Node.Offset + Node.Count; i += 1)
+			{
+				float TriT;
+
+				if (!IntersectTriangle( m_Triangles[ i ], Origin, Dir, TriT ))
+					continue;
+
+				if (TriT > BestT)
+					continue;
+
+				BestT       = TriT;
+				Intersected = true;
+
+				if (!ARGUMENT_PRESENT( HitTriangle ))
+				{
+					T = BestT;
+					return true;
+				}
+
+				*HitTriangle = m_Triangles[ i ].Id;
+			}
+
+			continue;
+		}
+
+		//
+		// Push the farther child first so that the nearer child is visited
+		// next.
+		//
+
+		{
+			unsigned long Left    = (unsigned long) (&Node - &m_Nodes[ 0 ]) + 1;
+			unsigned long Right   = Node.Offset;
+			float         TLeft;
+			float         TRight;
+			bool          HitLeft;
+			bool          HitRight;
+
+			HitLeft  = IntersectRayBox(
+				Origin,
+				InvDir,
+				m_Nodes[ Left ].MinBound,
+				m_Nodes[ Left ].MaxBound,
+				BestT,
+				TLeft);
+			HitRight = IntersectRayBox(
+				Origin,
+				InvDir,
+				m_Nodes[ Right ].MinBound,
+				m_Nodes[ Right ].MaxBound,
+				BestT,
+				TRight);
+
+			if ((HitLeft) && (HitRight))
+			{
+				if (TLeft <= TRight)
+				{
+					Stack[ StackDepth++ ] = Right;
+					Stack[ StackDepth++ ] = Left;
+				}
+				else
+				{
+					Stack[ StackDepth++ ] = Left;
+					Stack[ StackDepth++ ] = Right;
+				}
+			}
+			else if (HitLeft)
+			{
+				Stack[ StackDepth++ ] = Left;
+			}
+			else if (HitRight)
+			{
+				Stack[ StackDepth++ ] = Right;
+			}
+		}
+	}
+
+	if (Intersected)
+		T = BestT;
+
+	return Intersected;
+}
+
+void
+MeshBVH::QueryBox(
+	nwn2dev__in const NWN::Vector3 & MinBound,
+	nwn2dev__in const NWN::Vector3 & MaxBound,
+	__inout std::vector< TriangleIndex > & Triangles
+	) const
+/*++
+
+Routine Description:
+
+	This routine appends every triangle whose bounds overlap an axis aligned
+	box to a caller supplied list.
+
+Arguments:
+
+	MinBound - Supplies the minimum corner of the query box.
+
+	MaxBound - Supplies the maximum corner of the query box.
+
+	Triangles - Receives the insertion indicies of the overlapping triangles.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned long Stack[ MAX_DEPTH + 1 ];
+	size_t        StackDepth;
+
+	if (m_Nodes.empty( ))
+		return;
+
+	StackDepth = 0;
+
+	Stack[ StackDepth++ ] = 0;
+
+	while (StackDepth != 0)
+	{
+		unsigned long    NodeIndex = Stack[ --StackDepth ];
+		const BVH_NODE & Node      = m_Nodes[ NodeIndex ];
+
+		if (!BoxesOverlap( MinBound, MaxBound, Node.MinBound, Node.MaxBound ))
+			continue;
+
+		if (Node.Count == 0)
+		{
+			Stack[ StackDepth++ ] = Node.Offset;
+			Stack[ StackDepth++ ] = NodeIndex + 1;
+			continue;
+		}
+
+		for (unsigned long i = Node.Offset; i < Node.Offset + Node.Count; i += 1)
+		{
+			const BVH_TRIANGLE & Triangle = m_Triangles[ i ];
+			NWN::Vector3         TMinBound;
+			NWN::Vector3         TMaxBound;
+
+			TMinBound = m_Points[ Triangle.Corners[ 0 ] ];
+			TMaxBound = TMinBound;
+
+			ExtendBounds( TMinBound, TMaxBound, m_Points[ Triangle.Corners[ 1 ] ] );
+			ExtendBounds( TMinBound, TMaxBound, m_Points[ Triangle.Corners[ 2 ] ] );
+
+			if (BoxesOverlap( MinBound, MaxBound, TMinBound, TMaxBound ))
+				Triangles.push_back( Triangle.Id );
+		}
+	}
+}
+
+void
+MeshBVH::GetTriangle(
+	nwn2dev__in TriangleIndex Triangle,
+	__out_ecount( 3 ) NWN::Vector3 * Tri
+	) const
+/*++
+
+Routine Description:
+
+	This routine retrieves the corner points of a triangle, in the coordinate
+	space of the hierarchy.
+
+Arguments:
+
+	Triangle - Supplies the insertion index of the triangle.
+
+	Tri - Receives the three corner points of the triangle.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if (Triangle >= m_TriangleSlots.size( ))
+		throw std::exception( "Illegal MeshBVH triangle index" );
+
+	const BVH_TRIANGLE & BvhTriangle = m_Triangles[ m_TriangleSlots[ Triangle ] ];
+
+	for (size_t i = 0; i < 3; i += 1)
+		Tri[ i ] = m_Points[ BvhTriangle.Corners[ i ] ];
+}
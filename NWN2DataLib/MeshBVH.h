@@ -0,0 +1,344 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	MeshBVH.h
+
+Abstract:
+
+	This module defines the MeshBVH class, which represents a bounding volume
+	hierarchy built over the triangles of a single mesh.
+
+	The MeshBVH forms the bottom level of the area scene hierarchy (see
+	AreaSceneBVH.h).  The hierarchy is built once, in the coordinate space of
+	the points that are supplied to it (typically model local space), and is
+	never rebuilt when the owning object moves; instead, queries are mapped
+	into the coordinate space of the hierarchy by the caller.
+
+--*/
+
+#ifndef _PROGRAMS_NWN2DATALIB_MESHBVH_H
+#define _PROGRAMS_NWN2DATALIB_MESHBVH_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+//
+// Define the triangle mesh bounding volume hierarchy.
+//
+
+class MeshBVH
+{
+
+public:
+
+	typedef swutil::SharedPtr< MeshBVH > Ptr;
+
+	typedef unsigned long TriangleIndex;
+
+	enum { INVALID_TRIANGLE = ULONG_MAX };
+
+	inline
+	MeshBVH(
+		)
+	: m_RejectBackfaces( false )
+	{
+		Clear( );
+	}
+
+	inline
+	~MeshBVH(
+		)
+	{
+	}
+
+	inline
+	void
+	Clear(
+		)
+	{
+		m_Nodes.clear( );
+		m_Points.clear( );
+		m_Triangles.clear( );
+		m_TriangleSlots.clear( );
+
+		m_MinBound.x = +FLT_MAX;
+		m_MinBound.y = +FLT_MAX;
+		m_MinBound.z = +FLT_MAX;
+		m_MaxBound.x = -FLT_MAX;
+		m_MaxBound.y = -FLT_MAX;
+		m_MaxBound.z = -FLT_MAX;
+	}
+
+	inline
+	bool
+	Empty(
+		) const
+	{
+		return m_Triangles.empty( );
+	}
+
+	//
+	// Begin building a new hierarchy.  Points and triangles are then appended
+	// with AddPoint and AddTriangle, and the hierarchy is constructed by a
+	// subsequent call to Build.
+	//
+	// Triangles are identified in query results by their insertion order.
+	//
+
+	inline
+	void
+	Reserve(
+		nwn2dev__in size_t NumPoints,
+		nwn2dev__in size_t NumTriangles
+		)
+	{
+		m_Points.reserve( NumPoints );
+		m_Triangles.reserve( NumTriangles );
+	}
+
+	inline
+	void
+	AddPoint(
+		nwn2dev__in const NWN::Vector3 & Point
+		)
+	{
+		m_Points.push_back( Point );
+	}
+
+	inline
+	void
+	AddTriangle(
+		nwn2dev__in unsigned long Corner0,
+		nwn2dev__in unsigned long Corner1,
+		nwn2dev__in unsigned long Corner2
+		)
+	{
+		BVH_TRIANGLE Triangle;
+
+		Triangle.Corners[ 0 ] = Corner0;
+		Triangle.Corners[ 1 ] = Corner1;
+		Triangle.Corners[ 2 ] = Corner2;
+		Triangle.Id           = (TriangleIndex) m_Triangles.size( );
+
+		m_Triangles.push_back( Triangle );
+	}
+
+	//
+	// Construct the hierarchy from the points and triangles that have been
+	// added.  An std::exception is raised if a triangle references a point
+	// that does not exist.
+	//
+
+	void
+	Build(
+		);
+
+	//
+	// Build a hierarchy over the local space points of a SimpleMesh-derived
+	// mesh (such as a CollisionMesh).
+	//
+
+	template< typename T >
+	inline
+	void
+	BuildFromSimpleMesh(
+		nwn2dev__in const T & Mesh,
+		nwn2dev__in bool RejectBackfaces
+		)
+	{
+		Clear( );
+		Reserve( Mesh.GetPoints( ).size( ), Mesh.GetFaces( ).size( ) );
+
+		for (typename T::PointIndex i = 0; i < Mesh.GetPoints( ).size( ); i += 1)
+			AddPoint( Mesh.GetLocalPoint3( i ) );
+
+		for (typename T::FaceVec::const_iterator it = Mesh.GetFaces( ).begin( );
+		     it != Mesh.GetFaces( ).end( );
+		     ++it)
+		{
+			AddTriangle( it->Corners[ 0 ], it->Corners[ 1 ], it->Corners[ 2 ] );
+		}
+
+		m_RejectBackfaces = RejectBackfaces;
+
+		Build( );
+	}
+
+	//
+	// Intersect a ray with the hierarchy.  The direction need not be of unit
+	// length; distances are returned in multiples of the direction vector so
+	// that a ray mapped through an affine transform retains its world space
+	// parameterization.
+	//
+	// If HitTriangle is not supplied, the first intersection found (rather
+	// than the closest) satisfies the query.
+	//
+
+	bool
+	IntersectRay(
+		nwn2dev__in const NWN::Vector3 & Origin,
+		nwn2dev__in const NWN::Vector3 & Dir,
+		nwn2dev__in float MaxT,
+		nwn2dev__out float & T,
+		__out_opt TriangleIndex * HitTriangle
+		) const;
+
+	//
+	// Return all triangles whose bounds overlap an axis aligned box.
+	//
+
+	void
+	QueryBox(
+		nwn2dev__in const NWN::Vector3 & MinBound,
+		nwn2dev__in const NWN::Vector3 & MaxBound,
+		__inout std::vector< TriangleIndex > & Triangles
+		) const;
+
+	//
+	// Retrieve the corners of a triangle by its insertion index.
+	//
+
+	void
+	GetTriangle(
+		nwn2dev__in TriangleIndex Triangle,
+		__out_ecount( 3 ) NWN::Vector3 * Tri
+		) const;
+
+	inline
+	size_t
+	GetTriangleCount(
+		) const
+	{
+		return m_Triangles.size( );
+	}
+
+	inline
+	size_t
+	GetNodeCount(
+		) const
+	{
+		return m_Nodes.size( );
+	}
+
+	inline
+	const NWN::Vector3 &
+	GetMinBound(
+		) const
+	{
+		return m_MinBound;
+	}
+
+	inline
+	const NWN::Vector3 &
+	GetMaxBound(
+		) const
+	{
+		return m_MaxBound;
+	}
+
+	inline
+	bool
+	GetRejectBackfaces(
+		) const
+	{
+		return m_RejectBackfaces;
+	}
+
+	inline
+	void
+	SetRejectBackfaces(
+		nwn2dev__in bool RejectBackfaces
+		)
+	{
+		m_RejectBackfaces = RejectBackfaces;
+	}
+
+private:
+
+	//
+	// Define the maximum number of triangles stored in a leaf node.
+	//
+
+	enum { MAX_LEAF_TRIANGLES = 4 };
+
+	//
+	// Define the maximum depth of the hierarchy, which bounds the traversal
+	// stack.  Build stops subdividing at this depth.
+	//
+
+	enum { MAX_DEPTH = 48 };
+
+	struct BVH_TRIANGLE
+	{
+		unsigned long Corners[ 3 ];
+		TriangleIndex Id;
+	};
+
+	//
+	// Define a hierarchy node.  Interior nodes store the index of their right
+	// child in Offset (the left child immediately follows the parent); leaf
+	// nodes store the first triangle in Offset and a non-zero Count.
+	//
+
+	struct BVH_NODE
+	{
+		NWN::Vector3  MinBound;
+		NWN::Vector3  MaxBound;
+		unsigned long Offset;
+		unsigned long Count;
+	};
+
+	typedef std::vector< BVH_NODE > NodeVec;
+	typedef std::vector< NWN::Vector3 > PointVec;
+	typedef std::vector< BVH_TRIANGLE > TriangleVec;
+	typedef std::vector< unsigned long > TriangleSlotVec;
+
+	//
+	// Recursively subdivide a triangle range into the node array.
+	//
+
+	void
+	BuildNode(
+		nwn2dev__in size_t NodeIndex,
+		nwn2dev__in size_t First,
+		nwn2dev__in size_t Count,
+		nwn2dev__in size_t Depth,
+		nwn2dev__in const PointVec & Centroids
+		);
+
+	bool
+	IntersectTriangle(
+		nwn2dev__in const BVH_TRIANGLE & Triangle,
+		nwn2dev__in const NWN::Vector3 & Origin,
+		nwn2dev__in const NWN::Vector3 & Dir,
+		nwn2dev__out float & T
+		) const;
+
+	NodeVec      m_Nodes;
+	PointVec     m_Points;
+	TriangleVec  m_Triangles;
+
+	//
+	// Map a triangle insertion index to its position in m_Triangles, which is
+	// reordered by Build.
+	//
+
+	TriangleSlotVec m_TriangleSlots;
+
+	NWN::Vector3 m_MinBound;
+	NWN::Vector3 m_MaxBound;
+
+	//
+	// Define whether backfaces are ignored for ray intersection purposes, as
+	// is the case for the coarse-grained C2 collision mesh.
+	//
+
+	bool         m_RejectBackfaces;
+
+};
+
+#endif
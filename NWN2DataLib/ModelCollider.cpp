@@ -80,6 +80,14 @@ Environment:
 			return false;
 	}
 
+	//
+	// Bring the world space meshes up to date with the last transformation
+	// applied, if this is the first query since the collider moved.
+	//
+
+	m_C2Mesh.ResolveTransform( );
+	m_C3Mesh.ResolveTransform( );
+
 	Intersected = false;
 
 	//
@@ -256,6 +264,14 @@ Environment:
 			return false;
 	}
 
+	//
+	// Bring the world space meshes up to date with the last transformation
+	// applied, if this is the first query since the collider moved.
+	//
+
+	m_C2Mesh.ResolveTransform( );
+	m_C3Mesh.ResolveTransform( );
+
 	Intersected = false;
 
 	//
@@ -374,3 +390,112 @@ Environment:
 
 	return Intersected;
 }
+
+void
+ModelCollider::Update(
+	nwn2dev__in const NWN::Matrix44 & M
+	)
+/*++
+
+Routine Description:
+
+	This routine applies a new world transformation to the collider meshes and
+	recalculates the world space bounding box of the collider.
+
+	The collision mesh vertices are not transformed here; see
+	CollisionMesh::ResolveTransform.
+
+Arguments:
+
+	M - Supplies the transformation to apply.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	m_C3Mesh.Update( M );
+	m_C2Mesh.Update( M );
+
+	m_WorldTransform        = M;
+	m_InverseWorldTransform = Math::InverseAffine( M );
+
+	//
+	// Recalculate the bounding box.  The collision meshes defer transforming
+	// their vertices until they are first hit tested, so the box is derived
+	// from the local space bounds of each mesh.
+	//
+
+	m_MaxBound.x = -FLT_MAX;
+	m_MaxBound.y = -FLT_MAX;
+	m_MaxBound.z = -FLT_MAX;
+	m_MinBound.x = +FLT_MAX;
+	m_MinBound.y = +FLT_MAX;
+	m_MinBound.z = +FLT_MAX;
+
+	m_C3Mesh.UpdateBoundingBox( m_MinBound, m_MaxBound );
+	m_C2Mesh.UpdateBoundingBox( m_MinBound, m_MaxBound );
+}
+
+const MeshBVH *
+ModelCollider::GetCollisionBVH(
+	) const
+/*++
+
+Routine Description:
+
+	This routine returns the local space collision hierarchy of the model,
+	building the hierarchy if it has not yet been built for the underlying
+	model instance.
+
+	The fine-grained C3 mesh is used if present, as it is the final authority
+	on collisions; otherwise, the C2 mesh is used (with backfaces rejected, as
+	is the case for direct C2 hit-testing).
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the collision hierarchy, else NULL if the collider has
+	no collision mesh data or no model instance.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	MeshBVH::Ptr CollisionBVH;
+
+	if (m_ModelInstance.get( ) == NULL)
+		return NULL;
+
+	if (m_ModelInstance->GetCollisionBVH( ) != NULL)
+		return m_ModelInstance->GetCollisionBVH( );
+
+	if (!m_C3Mesh.GetFaces( ).empty( ))
+	{
+		CollisionBVH = new MeshBVH( );
+		CollisionBVH->BuildFromSimpleMesh( m_C3Mesh, false );
+	}
+	else if (!m_C2Mesh.GetFaces( ).empty( ))
+	{
+		CollisionBVH = new MeshBVH( );
+		CollisionBVH->BuildFromSimpleMesh( m_C2Mesh, true );
+	}
+	else
+	{
+		return NULL;
+	}
+
+	m_ModelInstance->SetCollisionBVH( CollisionBVH );
+
+	return m_ModelInstance->GetCollisionBVH( );
+}
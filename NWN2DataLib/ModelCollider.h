@@ -52,7 +52,15 @@ public:
 	inline
 	ModelCollider(
 		)
+	: m_WorldTransform( NWN::Matrix44::IDENTITY ),
+	  m_InverseWorldTransform( NWN::Matrix44::IDENTITY )
 	{
+		m_MinBound.x = +FLT_MAX;
+		m_MinBound.y = +FLT_MAX;
+		m_MinBound.z = +FLT_MAX;
+		m_MaxBound.x = -FLT_MAX;
+		m_MaxBound.y = -FLT_MAX;
+		m_MaxBound.z = -FLT_MAX;
 	}
 
 	inline
@@ -285,36 +293,62 @@ public:
 	void
 	Update(
 		nwn2dev__in const NWN::Matrix44 & M
-		)
+		);
+
+	//
+	// World transform access.  The inverse transform maps world space queries
+	// into the local space of the collision hierarchy.
+	//
+
+	inline
+	const NWN::Matrix44 &
+	GetWorldTransform(
+		) const
 	{
-		m_C3Mesh.Update( M );
-		m_C2Mesh.Update( M );
+		return m_WorldTransform;
+	}
 
-		//
-		// Recalculate the bounding box.
-		//
+	inline
+	const NWN::Matrix44 &
+	GetInverseWorldTransform(
+		) const
+	{
+		return m_InverseWorldTransform;
+	}
 
-		m_MaxBound.x = -FLT_MAX;
-		m_MaxBound.y = -FLT_MAX;
-		m_MaxBound.z = -FLT_MAX;
-		m_MinBound.x = +FLT_MAX;
-		m_MinBound.y = +FLT_MAX;
-		m_MinBound.z = +FLT_MAX;
+	//
+	// Return the world space bounding box of the collision meshes, as of the
+	// last call to Update.  The box is derived from the transformed local
+	// space bounds of the meshes and so may not be the tightest fit.
+	//
 
-		m_C3Mesh.UpdateBoundingBox( m_MinBound, m_MaxBound );
-		m_C2Mesh.UpdateBoundingBox( m_MinBound, m_MaxBound );
+	inline
+	const NWN::Vector3 &
+	GetMinBound(
+		) const
+	{
+		return m_MinBound;
+	}
 
-//		for (RigidMeshVec::iterator it = m_RigidMeshes.begin( );
-//		     it != m_RigidMeshes.end( );
-//		     ++it)
-//		{
-//			it->Update( M );
-//		}
-//
-//		m_SkinMesh.Update( M );
-//		m_WalkMesh.Update( M );
+	inline
+	const NWN::Vector3 &
+	GetMaxBound(
+		) const
+	{
+		return m_MaxBound;
 	}
 
+	//
+	// Return the local space collision hierarchy for the model, building it
+	// on first use.  The hierarchy is stored with (and shared through) the
+	// model instance.  NULL is returned if there is no collision data or no
+	// model instance.
+	//
+
+	const MeshBVH *
+	GetCollisionBVH(
+		) const;
+
 	//
 	// Return the radius of a 3D sphere that would encapsulate the entire model
 	// collision structure, else false if there was no collision data loaded.
@@ -381,6 +415,13 @@ private:
 	NWN::Vector3        m_MinBound;
 	NWN::Vector3        m_MaxBound;
 
+	//
+	// World transformation last applied via Update, and its inverse.
+	//
+
+	NWN::Matrix44       m_WorldTransform;
+	NWN::Matrix44       m_InverseWorldTransform;
+
 };
 
 typedef swutil::SharedPtr< ModelCollider > ModelColliderPtr;
@@ -34,6 +34,7 @@ Abstract:
 #include "HookPoint.h"
 #include "HairPoint.h"
 #include "HelmPoint.h"
+#include "MeshBVH.h"
 
 //
 // Define shared model mesh that is kept for display purposes.
@@ -189,6 +190,29 @@ public:
 		return (NWN::MDB_HELM_HAIR_HIDING_BEHAVIOR) (GetHelmPoint( ).GetHeader( ).HelmFlag);
 	}
 
+	//
+	// Local space collision hierarchy access.  The hierarchy is built on
+	// demand by the first ModelCollider that requires it and is then shared
+	// by all colliders that refer to this instance.
+	//
+
+	inline
+	const MeshBVH *
+	GetCollisionBVH(
+		) const
+	{
+		return m_CollisionBVH.get( );
+	}
+
+	inline
+	void
+	SetCollisionBVH(
+		nwn2dev__in const MeshBVH::Ptr & CollisionBVH
+		)
+	{
+		m_CollisionBVH = CollisionBVH;
+	}
+
 private:
 
 	//
@@ -230,6 +254,13 @@ private:
 
 	HelmPoint        m_HelmPoint;
 
+	//
+	// Local space collision hierarchy, built over the C3 mesh (or the C2 mesh
+	// if there is no C3 mesh).
+	//
+
+	MeshBVH::Ptr     m_CollisionBVH;
+
 };
 
 #endif
@@ -23,5 +23,7 @@ Abstract:
 #include "TextOut.h"
 #include "TrxFileReader.h"
 #include "ResourceManager.h"
+#include "ResourcePrefetcher.h"
+#include "AreaSceneBVH.h"
 
 #endif
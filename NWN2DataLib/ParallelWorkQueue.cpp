@@ -0,0 +1,385 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ParallelWorkQueue.cpp
+
+Abstract:
+
+	This module houses the ParallelWorkQueue class implementation, which runs
+	batches of independent work items on the system thread pool.
+
+--*/
+
+#include "Precomp.h"
+#include "ParallelWorkQueue.h"
+
+ParallelWorkQueue::ParallelWorkQueue(
+	nwn2dev__in bool Parallel /* = true */
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new ParallelWorkQueue object.
+
+Arguments:
+
+	Parallel - Supplies a Boolean value indicating whether work items are to
+	           be run on the system thread pool (true), or inline by
+	           QueueWork (false).
+
+Return Value:
+
+	The newly constructed object.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+: m_Outstanding( 1 ),
+  m_IdleEvent( NULL ),
+  m_Parallel( Parallel ),
+  m_Failed( false )
+{
+	m_IdleEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+
+	if (m_IdleEvent == NULL)
+		throw std::runtime_error( "Failed to create work queue idle event." );
+
+	InitializeCriticalSection( &m_ErrorLock );
+}
+
+ParallelWorkQueue::~ParallelWorkQueue(
+	)
+/*++
+
+Routine Description:
+
+	This routine waits for any outstanding work items and then cleans up an
+	already-existing ParallelWorkQueue object.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	WaitForOutstandingWork( );
+
+	DeleteCriticalSection( &m_ErrorLock );
+	CloseHandle( m_IdleEvent );
+}
+
+void
+ParallelWorkQueue::QueueWork(
+	nwn2dev__in WorkRoutine Routine,
+	__in_opt void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine queues a work item to the system thread pool.  Should the
+	work item fail to be queued, it is run inline instead.
+
+Arguments:
+
+	Routine - Supplies the work routine.
+
+	Context - Supplies the context argument for the work routine.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode, owning thread only.
+
+--*/
+{
+	WORK_ITEM * Item;
+
+	if (!m_Parallel)
+	{
+		RunWorkItem( Routine, Context );
+		return;
+	}
+
+	try
+	{
+		Item = new WORK_ITEM;
+	}
+	catch (std::bad_alloc)
+	{
+		RunWorkItem( Routine, Context );
+		return;
+	}
+
+	Item->Queue   = this;
+	Item->Routine = Routine;
+	Item->Context = Context;
+
+	InterlockedIncrement( &m_Outstanding );
+
+	if (!QueueUserWorkItem( WorkItemThreadProc, Item, WT_EXECUTEDEFAULT ))
+	{
+		InterlockedDecrement( &m_Outstanding );
+
+		delete Item;
+
+		RunWorkItem( Routine, Context );
+	}
+}
+
+void
+ParallelWorkQueue::WaitForAll(
+	)
+/*++
+
+Routine Description:
+
+	This routine waits for all queued work items to complete, and then
+	raises an exception if any work item failed.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.  An std::exception is raised if a work item failed.
+
+Environment:
+
+	User mode, owning thread only.
+
+--*/
+{
+	std::string ErrorText;
+	bool        Failed;
+
+	WaitForOutstandingWork( );
+
+	EnterCriticalSection( &m_ErrorLock );
+
+	Failed = m_Failed;
+
+	if (Failed)
+		ErrorText.swap( m_ErrorText );
+
+	m_Failed = false;
+
+	LeaveCriticalSection( &m_ErrorLock );
+
+	if (Failed)
+		throw std::runtime_error( ErrorText );
+}
+
+ULONG
+ParallelWorkQueue::GetProcessorCount(
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the count of processors in the system.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the processor count, which is at least one.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	SYSTEM_INFO SystemInfo;
+
+	GetSystemInfo( &SystemInfo );
+
+	if (SystemInfo.dwNumberOfProcessors < 1)
+		return 1;
+
+	return SystemInfo.dwNumberOfProcessors;
+}
+
+DWORD
+WINAPI
+ParallelWorkQueue::WorkItemThreadProc(
+	nwn2dev__in LPVOID Parameter
+	)
+/*++
+
+Routine Description:
+
+	This routine is the thread pool callback for a queued work item.  It runs
+	the work item and signals the owning thread if the work item was the last
+	outstanding item of the batch being waited for.
+
+Arguments:
+
+	Parameter - Supplies the WORK_ITEM describing the work to run.
+
+Return Value:
+
+	The routine always returns zero.
+
+Environment:
+
+	User mode, thread pool thread.
+
+--*/
+{
+	WORK_ITEM         * Item  = (WORK_ITEM *) Parameter;
+	ParallelWorkQueue * Queue = Item->Queue;
+
+	Queue->RunWorkItem( Item->Routine, Item->Context );
+
+	delete Item;
+
+	if (InterlockedDecrement( &Queue->m_Outstanding ) == 0)
+		SetEvent( Queue->m_IdleEvent );
+
+	return 0;
+}
+
+void
+ParallelWorkQueue::RunWorkItem(
+	nwn2dev__in WorkRoutine Routine,
+	__in_opt void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine runs a work item, recording the first failure raised by any
+	work item of the batch.
+
+Arguments:
+
+	Routine - Supplies the work routine.
+
+	Context - Supplies the context argument for the work routine.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	//
+	// The failure is recorded from within the handler, as the text returned
+	// by what( ) is owned by the exception object and does not outlive it.
+	//
+
+	try
+	{
+		Routine( Context );
+	}
+	catch (std::exception & e)
+	{
+		RecordFailure( e.what( ) );
+	}
+	catch (...)
+	{
+		RecordFailure( "Unrecognized exception raised by work item." );
+	}
+}
+
+void
+ParallelWorkQueue::RecordFailure(
+	nwn2dev__in const char * ErrorText
+	)
+/*++
+
+Routine Description:
+
+	This routine records the failure of a work item.  Only the first failure
+	of a batch is retained.
+
+Arguments:
+
+	ErrorText - Supplies the error text for the failure.  The text is copied
+	            before the routine returns.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	EnterCriticalSection( &m_ErrorLock );
+
+	if (!m_Failed)
+	{
+		m_Failed = true;
+
+		try
+		{
+			m_ErrorText = ErrorText;
+		}
+		catch (std::exception)
+		{
+			m_ErrorText.clear( );
+		}
+	}
+
+	LeaveCriticalSection( &m_ErrorLock );
+}
+
+void
+ParallelWorkQueue::WaitForOutstandingWork(
+	)
+/*++
+
+Routine Description:
+
+	This routine drops the owning thread's bias reference on the outstanding
+	work count and waits for any remaining work items to finish.  The bias
+	reference is then restored so that the work queue may be reused.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode, owning thread only.
+
+--*/
+{
+	if (InterlockedDecrement( &m_Outstanding ) != 0)
+		WaitForSingleObject( m_IdleEvent, INFINITE );
+
+	m_Outstanding = 1;
+}
@@ -0,0 +1,154 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ParallelWorkQueue.h
+
+Abstract:
+
+	This module defines the ParallelWorkQueue class, which runs a batch of
+	independent work items on the system thread pool and waits for the batch
+	to complete.
+
+	The work queue is intended for fork/join style parallelism during data
+	loading (for example, decoding the resources of an area file).  Work items
+	are queued by the owning thread only, and are then joined by a call to
+	WaitForAll; any std::exception raised by a work item is captured and
+	re-raised (as an std::runtime_error) from WaitForAll.
+
+--*/
+
+#ifndef _PROGRAMS_NWN2DATALIB_PARALLELWORKQUEUE_H
+#define _PROGRAMS_NWN2DATALIB_PARALLELWORKQUEUE_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+//
+// Define the fork/join work queue.
+//
+
+class ParallelWorkQueue
+{
+
+public:
+
+	typedef
+	void
+	(__stdcall * WorkRoutine)(
+		nwn2dev__in void * Context
+		);
+
+	//
+	// Create a work queue.  If Parallel is false, work items are run inline
+	// by QueueWork, which allows callers to share a single code path between
+	// serial and parallel operation.
+	//
+
+	ParallelWorkQueue(
+		nwn2dev__in bool Parallel = true
+		);
+
+	//
+	// Wait for any outstanding work and release the work queue.  Errors from
+	// outstanding work items are discarded.
+	//
+
+	~ParallelWorkQueue(
+		);
+
+	//
+	// Queue a work item.  The routine must only be called from the thread
+	// that owns the work queue, and not concurrently with WaitForAll.
+	//
+
+	void
+	QueueWork(
+		nwn2dev__in WorkRoutine Routine,
+		__in_opt void * Context
+		);
+
+	//
+	// Wait for all queued work items to complete.  If any work item raised
+	// an exception, an std::exception is raised describing the first such
+	// failure.  The work queue may be reused after the routine returns.
+	//
+
+	void
+	WaitForAll(
+		);
+
+	//
+	// Return the count of processors in the system, which is a reasonable
+	// upper bound on useful CPU-bound parallelism.
+	//
+
+	static
+	ULONG
+	GetProcessorCount(
+		);
+
+private:
+
+	struct WORK_ITEM
+	{
+		ParallelWorkQueue * Queue;
+		WorkRoutine         Routine;
+		void              * Context;
+	};
+
+	static
+	DWORD
+	WINAPI
+	WorkItemThreadProc(
+		nwn2dev__in LPVOID Parameter
+		);
+
+	//
+	// Run a work item and capture any failure.
+	//
+
+	void
+	RunWorkItem(
+		nwn2dev__in WorkRoutine Routine,
+		__in_opt void * Context
+		);
+
+	//
+	// Record the failure of a work item.  The error text is copied before
+	// the routine returns, so it may point into a live exception object.
+	//
+
+	void
+	RecordFailure(
+		nwn2dev__in const char * ErrorText
+		);
+
+	void
+	WaitForOutstandingWork(
+		);
+
+	//
+	// Count of outstanding work items, plus one bias reference held by the
+	// owning thread outside of WaitForAll.  The idle event is signaled when
+	// the count reaches zero, which can only happen inside WaitForAll.
+	//
+
+	volatile LONG    m_Outstanding;
+	HANDLE           m_IdleEvent;
+	bool             m_Parallel;
+
+	//
+	// First failure recorded by a work item.
+	//
+
+	CRITICAL_SECTION m_ErrorLock;
+	bool             m_Failed;
+	std::string      m_ErrorText;
+
+};
+
+#endif
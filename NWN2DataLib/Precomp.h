@@ -34,6 +34,7 @@ Abstract:
 #include <list>
 #include <vector>
 #include <map>
+#include <queue>
 #include <unordered_map>
 #include <sstream>
 
@@ -0,0 +1,622 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ResourceDedupStore.cpp
+
+Abstract:
+
+	This module houses the ResourceDedupStore class, which shares identical
+	resource payloads between resources.
+
+--*/
+
+#include "Precomp.h"
+#include "ResourceDedupStore.h"
+
+ResourceDedupStore::ResourceDedupStore(
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new, empty ResourceDedupStore object.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The newly constructed object.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	InitializeSRWLock( &m_StoreLock );
+
+	ZeroMemory( &m_Statistics, sizeof( m_Statistics ) );
+}
+
+ResourceDedupStore::~ResourceDedupStore(
+	)
+/*++
+
+Routine Description:
+
+	This routine cleans up an already-existing ResourceDedupStore object.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+}
+
+ResourceDedupStore::ContentKey
+ResourceDedupStore::HashContents(
+	__in_bcount( Length ) const void * Contents,
+	nwn2dev__in size_t Length
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the content key of a payload.  The payload is
+	hashed a 64-bit word at a time with a multiply and rotate mix, which is
+	fast enough to hash every resource that is read without a measurable
+	cost next to the read itself.
+
+Arguments:
+
+	Contents - Supplies the payload to hash.
+
+	Length - Supplies the length of the payload, in bytes.
+
+Return Value:
+
+	The routine returns the content key of the payload.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const unsigned char * p;
+	ULONGLONG             Hash;
+	ULONGLONG             Word;
+	ContentKey            Key;
+	size_t                i;
+
+	const ULONGLONG Prime = 0x9E3779B97F4A7C15ULL;
+
+	p    = (const unsigned char *) Contents;
+	Hash = 0xCBF29CE484222325ULL ^ ((ULONGLONG) Length * Prime);
+
+	for (i = 0; i + sizeof( Word ) <= Length; i += sizeof( Word ))
+	{
+		memcpy( &Word, &p[ i ], sizeof( Word ) );
+
+		Hash ^= Word * Prime;
+		Hash  = (Hash << 31) | (Hash >> 33);
+		Hash *= 0xC2B2AE3D27D4EB4FULL;
+	}
+
+	Word = 0;
+
+	for (size_t j = 0; i < Length; i += 1, j += 1)
+		Word |= (ULONGLONG) p[ i ] << (j * 8);
+
+	Hash ^= Word * Prime;
+
+	//
+	// Finalize the hash so that all input bits affect all output bits.
+	//
+
+	Hash ^= Hash >> 33;
+	Hash *= 0xFF51AFD7ED558CCDULL;
+	Hash ^= Hash >> 33;
+	Hash *= 0xC4CEB9FE1A85EC53ULL;
+	Hash ^= Hash >> 33;
+
+	Key.Hash = Hash;
+	Key.Size = (ULONGLONG) Length;
+
+	return Key;
+}
+
+bool
+ResourceDedupStore::LookupCachedKey(
+	nwn2dev__in const void * Accessor,
+	nwn2dev__in ULONG64 FileIndex,
+	nwn2dev__out ContentKey & Key
+	)
+/*++
+
+Routine Description:
+
+	This routine looks up the cached content key of a file of a resource
+	accessor.
+
+Arguments:
+
+	Accessor - Supplies the resource accessor that contains the file.
+
+	FileIndex - Supplies the accessor's index of the file.
+
+	Key - Receives the content key of the file, on success.
+
+Return Value:
+
+	The routine returns true if the content key of the file was cached, else
+	false if the file has not yet been hashed.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	KeyCacheMap::const_iterator it;
+	FileKey                     File;
+	bool                        Found;
+
+	File.Accessor  = Accessor;
+	File.FileIndex = FileIndex;
+
+	AcquireSRWLockShared( &m_StoreLock );
+
+	it    = m_KeyCache.find( File );
+	Found = (it != m_KeyCache.end( ));
+
+	if (Found)
+		Key = it->second;
+
+	ReleaseSRWLockShared( &m_StoreLock );
+
+	if (Found)
+		InterlockedIncrement64( &m_Statistics.KeyCacheHits );
+	else
+		InterlockedIncrement64( &m_Statistics.KeyCacheMisses );
+
+	return Found;
+}
+
+void
+ResourceDedupStore::CacheKey(
+	nwn2dev__in const void * Accessor,
+	nwn2dev__in ULONG64 FileIndex,
+	nwn2dev__in const ContentKey & Key
+	)
+/*++
+
+Routine Description:
+
+	This routine records the content key of a file of a resource accessor.
+
+Arguments:
+
+	Accessor - Supplies the resource accessor that contains the file.
+
+	FileIndex - Supplies the accessor's index of the file.
+
+	Key - Supplies the content key of the file.
+
+Return Value:
+
+	None.  The key is simply not cached if memory could not be allocated.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FileKey File;
+
+	File.Accessor  = Accessor;
+	File.FileIndex = FileIndex;
+
+	AcquireSRWLockExclusive( &m_StoreLock );
+
+	try
+	{
+		m_KeyCache[ File ] = Key;
+	}
+	catch (std::exception)
+	{
+	}
+
+	ReleaseSRWLockExclusive( &m_StoreLock );
+}
+
+ResourceDedupStore::ByteVecPtr
+ResourceDedupStore::InternBuffer(
+	nwn2dev__in const ContentKey & Key,
+	nwn2dev__in const ByteVecPtr & Contents
+	)
+/*++
+
+Routine Description:
+
+	This routine submits a payload to the store and returns the shared
+	buffer for its contents.
+
+	The comparison against an existing buffer is made without the store lock
+	held.  Should two threads submit the same new payload concurrently, the
+	payload of the second thread is not shared.
+
+Arguments:
+
+	Key - Supplies the content key of the payload.
+
+	Contents - Supplies the payload.  The payload must not be modified once
+	           it has been submitted.
+
+Return Value:
+
+	The routine returns the shared buffer for the contents, which is either
+	an identical buffer that was already in the store, or Contents itself.
+
+	An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	BufferMap::const_iterator it;
+	ByteVecPtr                Existing;
+
+	AcquireSRWLockShared( &m_StoreLock );
+
+	it = m_Buffers.find( Key );
+
+	if (it != m_Buffers.end( ))
+		Existing = it->second;
+
+	ReleaseSRWLockShared( &m_StoreLock );
+
+	if ((Existing.get( ) != NULL) &&
+	    (Existing->size( ) == Contents->size( )) &&
+	    ((Contents->empty( )) ||
+	     (!memcmp( &(*Existing)[ 0 ], &(*Contents)[ 0 ], Contents->size( ) ))))
+	{
+		InterlockedIncrement64( &m_Statistics.BufferRequests );
+		InterlockedExchangeAdd64( &m_Statistics.BufferRequestBytes, (LONGLONG) Contents->size( ) );
+
+		return Existing;
+	}
+
+	//
+	// The payload is new (or its key collided with a different payload, in
+	// which case the first payload keeps the key).
+	//
+
+	AcquireSRWLockExclusive( &m_StoreLock );
+
+	try
+	{
+		if (Existing.get( ) == NULL)
+			m_Buffers.insert( BufferMap::value_type( Key, Contents ) );
+	}
+	catch (...)
+	{
+		ReleaseSRWLockExclusive( &m_StoreLock );
+		throw;
+	}
+
+	ReleaseSRWLockExclusive( &m_StoreLock );
+
+	InterlockedIncrement64( &m_Statistics.BufferRequests );
+	InterlockedExchangeAdd64( &m_Statistics.BufferRequestBytes, (LONGLONG) Contents->size( ) );
+	InterlockedIncrement64( &m_Statistics.UniqueBuffers );
+	InterlockedExchangeAdd64( &m_Statistics.UniqueBufferBytes, (LONGLONG) Contents->size( ) );
+
+	return Contents;
+}
+
+bool
+ResourceDedupStore::LinkSpill(
+	nwn2dev__in const ContentKey & Key,
+	nwn2dev__in const ByteVec & Contents,
+	nwn2dev__in const std::string & FileName
+	)
+/*++
+
+Routine Description:
+
+	This routine attempts to create a temporary file for a payload by hard
+	linking it to a previously registered temporary file with identical
+	contents, so that the contents are only stored (and cached by the file
+	system) once.
+
+	A registered temporary file may since have been deleted (when its last
+	reference was released), in which case no link is made.
+
+Arguments:
+
+	Key - Supplies the content key of the payload.
+
+	Contents - Supplies the payload.
+
+	FileName - Supplies the name of the temporary file to create.  Any
+	           existing file of that name is replaced.
+
+Return Value:
+
+	The routine returns true if the temporary file was created as a link,
+	else false if the caller must write the temporary file itself.
+
+	An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	SpillMap::const_iterator it;
+	std::string              Existing;
+
+	AcquireSRWLockShared( &m_StoreLock );
+
+	try
+	{
+		it = m_Spills.find( Key );
+
+		if (it != m_Spills.end( ))
+			Existing = it->second;
+	}
+	catch (...)
+	{
+		ReleaseSRWLockShared( &m_StoreLock );
+		throw;
+	}
+
+	ReleaseSRWLockShared( &m_StoreLock );
+
+	if ((Existing.empty( )) || (!_stricmp( Existing.c_str( ), FileName.c_str( ) )))
+		return false;
+
+	if (!CompareFileContents( Existing, Contents ))
+		return false;
+
+	DeleteFileA( FileName.c_str( ) );
+
+	if (!CreateHardLinkA( FileName.c_str( ), Existing.c_str( ), NULL ))
+		return false;
+
+	InterlockedIncrement64( &m_Statistics.SpillRequests );
+	InterlockedExchangeAdd64( &m_Statistics.SpillRequestBytes, (LONGLONG) Contents.size( ) );
+	InterlockedIncrement64( &m_Statistics.LinkedSpills );
+	InterlockedExchangeAdd64( &m_Statistics.LinkedSpillBytes, (LONGLONG) Contents.size( ) );
+
+	return true;
+}
+
+void
+ResourceDedupStore::RegisterSpill(
+	nwn2dev__in const ContentKey & Key,
+	nwn2dev__in const std::string & FileName
+	)
+/*++
+
+Routine Description:
+
+	This routine registers a temporary file that was written for a payload,
+	so that later identical payloads may be linked to it.  The most recently
+	written file for a payload replaces any earlier one, as the earlier one
+	is the more likely to have been deleted.
+
+Arguments:
+
+	Key - Supplies the content key of the payload.
+
+	FileName - Supplies the name of the temporary file.
+
+Return Value:
+
+	None.  The file is simply not registered if memory could not be
+	allocated.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	AcquireSRWLockExclusive( &m_StoreLock );
+
+	try
+	{
+		m_Spills[ Key ] = FileName;
+	}
+	catch (std::exception)
+	{
+	}
+
+	ReleaseSRWLockExclusive( &m_StoreLock );
+
+	InterlockedIncrement64( &m_Statistics.SpillRequests );
+	InterlockedExchangeAdd64( &m_Statistics.SpillRequestBytes, (LONGLONG) Key.Size );
+}
+
+void
+ResourceDedupStore::GetStatistics(
+	nwn2dev__out DedupStatistics & Statistics
+	) const
+/*++
+
+Routine Description:
+
+	This routine returns a snapshot of the store counters.  The counters are
+	read individually, so a snapshot taken while payloads are being submitted
+	may not be consistent across counters.
+
+Arguments:
+
+	Statistics - Receives the store counters.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	Statistics.BufferRequests     = (ULONGLONG) m_Statistics.BufferRequests;
+	Statistics.BufferRequestBytes = (ULONGLONG) m_Statistics.BufferRequestBytes;
+	Statistics.UniqueBuffers      = (ULONGLONG) m_Statistics.UniqueBuffers;
+	Statistics.UniqueBufferBytes  = (ULONGLONG) m_Statistics.UniqueBufferBytes;
+	Statistics.SpillRequests      = (ULONGLONG) m_Statistics.SpillRequests;
+	Statistics.SpillRequestBytes  = (ULONGLONG) m_Statistics.SpillRequestBytes;
+	Statistics.LinkedSpills       = (ULONGLONG) m_Statistics.LinkedSpills;
+	Statistics.LinkedSpillBytes   = (ULONGLONG) m_Statistics.LinkedSpillBytes;
+	Statistics.KeyCacheHits       = (ULONGLONG) m_Statistics.KeyCacheHits;
+	Statistics.KeyCacheMisses     = (ULONGLONG) m_Statistics.KeyCacheMisses;
+}
+
+void
+ResourceDedupStore::Clear(
+	)
+/*++
+
+Routine Description:
+
+	This routine releases the store's references to all shared buffers, and
+	forgets all registered temporary files and cached content keys.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	AcquireSRWLockExclusive( &m_StoreLock );
+
+	m_Buffers.clear( );
+	m_Spills.clear( );
+	m_KeyCache.clear( );
+
+	ReleaseSRWLockExclusive( &m_StoreLock );
+
+	//
+	// Counters updated concurrently with the reset may survive it.
+	//
+
+	InterlockedExchange64( &m_Statistics.BufferRequests, 0 );
+	InterlockedExchange64( &m_Statistics.BufferRequestBytes, 0 );
+	InterlockedExchange64( &m_Statistics.UniqueBuffers, 0 );
+	InterlockedExchange64( &m_Statistics.UniqueBufferBytes, 0 );
+	InterlockedExchange64( &m_Statistics.SpillRequests, 0 );
+	InterlockedExchange64( &m_Statistics.SpillRequestBytes, 0 );
+	InterlockedExchange64( &m_Statistics.LinkedSpills, 0 );
+	InterlockedExchange64( &m_Statistics.LinkedSpillBytes, 0 );
+	InterlockedExchange64( &m_Statistics.KeyCacheHits, 0 );
+	InterlockedExchange64( &m_Statistics.KeyCacheMisses, 0 );
+}
+
+bool
+ResourceDedupStore::CompareFileContents(
+	nwn2dev__in const std::string & FileName,
+	nwn2dev__in const ByteVec & Contents
+	)
+/*++
+
+Routine Description:
+
+	This routine compares a payload against the contents of a file.
+
+Arguments:
+
+	FileName - Supplies the name of the file to compare against.
+
+	Contents - Supplies the payload to compare.
+
+Return Value:
+
+	The routine returns true if the file exists and its contents match the
+	payload exactly, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	HANDLE        File;
+	LARGE_INTEGER FileSize;
+	size_t        Offset;
+	bool          Match;
+
+	File = CreateFileA(
+		FileName.c_str( ),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL,
+		OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN,
+		NULL);
+
+	if (File == INVALID_HANDLE_VALUE)
+		return false;
+
+	Match = ((GetFileSizeEx( File, &FileSize )) &&
+	         ((ULONGLONG) FileSize.QuadPart == (ULONGLONG) Contents.size( )));
+
+	for (Offset = 0; (Match) && (Offset < Contents.size( )); )
+	{
+		enum { CHUNK_SIZE = 16384 };
+
+		unsigned char Buffer[ CHUNK_SIZE ];
+		DWORD         Read;
+
+		if ((!ReadFile(
+			File,
+			Buffer,
+			(DWORD) std::min( Contents.size( ) - Offset, static_cast< size_t >( CHUNK_SIZE ) ),
+			&Read,
+			NULL)) || (Read == 0))
+		{
+			Match = false;
+			break;
+		}
+
+		if (memcmp( Buffer, &Contents[ Offset ], Read ))
+			Match = false;
+
+		Offset += Read;
+	}
+
+	CloseHandle( File );
+
+	return Match;
+}
@@ -0,0 +1,271 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ResourceDedupStore.h
+
+Abstract:
+
+	This module defines the ResourceDedupStore class, which provides
+	content-addressed sharing of resource payloads for the resource manager.
+
+	Resource contents are identified by a content key (a 64-bit hash of the
+	contents together with their length).  Content keys are computed lazily,
+	the first time that a resource is read, and are cached per resource
+	accessor file so that a resource is only hashed once per load.
+
+	Identical payloads share a single immutable in-memory buffer, and a single
+	temporary file (via hard links), regardless of which ERF, zip archive or
+	BIF supplied them.  Because a 64-bit hash is not collision free, a payload
+	is only shared after a byte-for-byte comparison succeeds.
+
+	As hard linked temporary files share their contents, temporary files are
+	immutable once written:  a temporary file is always deleted and created
+	anew, never rewritten in place.
+
+--*/
+
+#ifndef _PROGRAMS_NWN2DATALIB_RESOURCEDEDUPSTORE_H
+#define _PROGRAMS_NWN2DATALIB_RESOURCEDEDUPSTORE_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+class ResourceDedupStore
+{
+
+public:
+
+	typedef std::vector< unsigned char > ByteVec;
+
+	//
+	// Define the shared buffer type.  Buffers handed out by the store are
+	// immutable, as they may be shared by several resources.
+	//
+
+	typedef swutil::SharedPtr< const ByteVec > ByteVecPtr;
+
+	//
+	// Define the content key of a resource payload.
+	//
+
+	struct ContentKey
+	{
+		ULONGLONG Hash;
+		ULONGLONG Size;
+
+		inline
+		bool
+		operator == (
+			nwn2dev__in const ContentKey & Other
+			) const
+		{
+			return (Hash == Other.Hash) && (Size == Other.Size);
+		}
+	};
+
+	//
+	// Define the store counters.  Request counts include every payload that
+	// was submitted to the store; the unique counts include only those that
+	// were not shared with an identical payload already in the store.
+	//
+
+	struct DedupStatistics
+	{
+		ULONGLONG BufferRequests;
+		ULONGLONG BufferRequestBytes;
+		ULONGLONG UniqueBuffers;
+		ULONGLONG UniqueBufferBytes;
+		ULONGLONG SpillRequests;
+		ULONGLONG SpillRequestBytes;
+		ULONGLONG LinkedSpills;
+		ULONGLONG LinkedSpillBytes;
+		ULONGLONG KeyCacheHits;
+		ULONGLONG KeyCacheMisses;
+	};
+
+	ResourceDedupStore(
+		);
+
+	~ResourceDedupStore(
+		);
+
+	//
+	// Compute the content key of a payload.
+	//
+
+	static
+	ContentKey
+	HashContents(
+		__in_bcount( Length ) const void * Contents,
+		nwn2dev__in size_t Length
+		);
+
+	//
+	// Look up, or record, the cached content key of a file of a resource
+	// accessor.
+	//
+
+	bool
+	LookupCachedKey(
+		nwn2dev__in const void * Accessor,
+		nwn2dev__in ULONG64 FileIndex,
+		nwn2dev__out ContentKey & Key
+		);
+
+	void
+	CacheKey(
+		nwn2dev__in const void * Accessor,
+		nwn2dev__in ULONG64 FileIndex,
+		nwn2dev__in const ContentKey & Key
+		);
+
+	//
+	// Submit a payload to the store, returning the shared buffer for its
+	// contents.  If an identical payload is already present, its buffer is
+	// returned (and the supplied buffer is released), else the supplied
+	// buffer becomes the shared buffer for the contents.
+	//
+
+	ByteVecPtr
+	InternBuffer(
+		nwn2dev__in const ContentKey & Key,
+		nwn2dev__in const ByteVecPtr & Contents
+		);
+
+	//
+	// Create a temporary file for a payload by hard linking it to an
+	// existing temporary file with identical contents.  Returns false if no
+	// such file exists (or the link could not be made), in which case the
+	// caller writes the file itself and then registers it with RegisterSpill.
+	//
+	// N.B.  The caller must delete, rather than overwrite, an existing file
+	//       of the same name before writing it, as the file may be a link
+	//       sharing its contents with other temporary files.
+	//
+
+	bool
+	LinkSpill(
+		nwn2dev__in const ContentKey & Key,
+		nwn2dev__in const ByteVec & Contents,
+		nwn2dev__in const std::string & FileName
+		);
+
+	void
+	RegisterSpill(
+		nwn2dev__in const ContentKey & Key,
+		nwn2dev__in const std::string & FileName
+		);
+
+	//
+	// Return a snapshot of the store counters.
+	//
+
+	void
+	GetStatistics(
+		nwn2dev__out DedupStatistics & Statistics
+		) const;
+
+	//
+	// Release all shared buffers, forget all temporary files and cached
+	// content keys, and reset the counters.  Buffers that are still
+	// referenced by callers remain valid.
+	//
+
+	void
+	Clear(
+		);
+
+private:
+
+	struct ContentKeyHash
+	{
+		inline
+		size_t
+		operator()(
+			nwn2dev__in const ContentKey & Key
+			) const
+		{
+			return (size_t) (Key.Hash ^ (Key.Hash >> 32));
+		}
+	};
+
+	struct FileKey
+	{
+		const void * Accessor;
+		ULONG64      FileIndex;
+
+		inline
+		bool
+		operator == (
+			nwn2dev__in const FileKey & Other
+			) const
+		{
+			return (Accessor == Other.Accessor) &&
+			       (FileIndex == Other.FileIndex);
+		}
+	};
+
+	struct FileKeyHash
+	{
+		inline
+		size_t
+		operator()(
+			nwn2dev__in const FileKey & Key
+			) const
+		{
+			return (size_t) Key.Accessor ^ (size_t) (Key.FileIndex * 0x9E3779B97F4A7C15ULL);
+		}
+	};
+
+	typedef std::unordered_map< ContentKey, ByteVecPtr, ContentKeyHash > BufferMap;
+	typedef std::unordered_map< ContentKey, std::string, ContentKeyHash > SpillMap;
+	typedef std::unordered_map< FileKey, ContentKey, FileKeyHash > KeyCacheMap;
+
+	//
+	// Define the store counters as maintained internally.  The counters are
+	// updated with interlocked operations, so that lookups that find an
+	// existing entry need only hold the store lock shared.
+	//
+
+	struct DedupCounters
+	{
+		volatile LONGLONG BufferRequests;
+		volatile LONGLONG BufferRequestBytes;
+		volatile LONGLONG UniqueBuffers;
+		volatile LONGLONG UniqueBufferBytes;
+		volatile LONGLONG SpillRequests;
+		volatile LONGLONG SpillRequestBytes;
+		volatile LONGLONG LinkedSpills;
+		volatile LONGLONG LinkedSpillBytes;
+		volatile LONGLONG KeyCacheHits;
+		volatile LONGLONG KeyCacheMisses;
+	};
+
+	//
+	// Compare a payload against the contents of a file.
+	//
+
+	static
+	bool
+	CompareFileContents(
+		nwn2dev__in const std::string & FileName,
+		nwn2dev__in const ByteVec & Contents
+		);
+
+	//
+	// The store lock guards all of the maps.
+	//
+
+	mutable SRWLOCK          m_StoreLock;
+	BufferMap                m_Buffers;
+	SpillMap                 m_Spills;
+	KeyCacheMap              m_KeyCache;
+	DedupCounters            m_Statistics;
+
+};
+
+#endif
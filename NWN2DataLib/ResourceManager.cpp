@@ -18,6 +18,7 @@ Abstract:
 #include "ResourceManager.h"
 #include "TextOut.h"
 
+#include <set>
 
 
 //
@@ -90,6 +91,13 @@ Environment:
 	CHAR TempPath[ MAX_PATH + 1 ];
 	CHAR TempUnique[ 32 ];
 
+	InitializeSRWLock( &m_FileHandleLock );
+	InitializeSRWLock( &m_NameMapLock );
+	InitializeSRWLock( &m_2DALock );
+
+	for (size_t i = 0; i < DEMAND_LOCK_COUNT; i += 1)
+		InitializeSRWLock( &m_DemandLocks[ i ] );
+
 	if (CreateFlags & ResManCreateFlagNoInstanceSetup)
 		return;
 
@@ -305,6 +313,139 @@ Environment:
 	return ForceCloseOpenFileHandles( );
 }
 
+ULONG
+ResourceManager::ProcessDirectoryChanges(
+	)
+/*++
+
+Routine Description:
+
+	This routine applies the changes made to watched directory resource
+	providers since the last call to the resource index.  Added files become
+	visible if they are the most precedent copy of their resource, removed
+	files fall back to the next most precedent copy (if any), and cached 2DAs
+	that were changed are dropped so that they are reloaded on their next
+	reference.
+
+	Like a load, the routine alters the resource index, so the caller must
+	ensure that it does not overlap any other resource manager call.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the count of changes that altered a visible resource.
+	An std::exception is raised on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	DirectoryFileReader::DirectoryChangeVec Changes;
+	std::string                             ResourceName;
+	ULONG                                   Applied;
+
+	Applied = 0;
+
+	for (size_t i = 0; i < m_DirFiles.size( ); i += 1)
+	{
+		Changes.clear( );
+
+		if (!m_DirFiles[ i ]->PollChanges( Changes ))
+			continue;
+
+		for (DirectoryFileReader::DirectoryChangeVec::const_iterator it = Changes.begin( );
+		     it != Changes.end( );
+		     ++it)
+		{
+#if USE_INDEX
+			//
+			// Directory providers are indexed from the end of the directory
+			// tier, matching DiscoverResources.
+			//
+
+			if (!ApplyDirectoryChange(
+				m_DirFiles.size( ) - i,
+				m_DirFiles[ i ].get( ),
+				*it))
+			{
+				continue;
+			}
+#endif
+
+			Applied += 1;
+
+			if (it->Type != NWN::Res2DA)
+				continue;
+
+			//
+			// Drop the cached copy of the 2DA (including a negatively cached
+			// entry), as the 2DA cache is keyed by canonical name.
+			//
+
+			ResourceName = StrFromResRef( it->Name );
+
+			for (std::string::iterator c = ResourceName.begin( );
+			     c != ResourceName.end( );
+			     ++c)
+			{
+				*c = (char) tolower( (unsigned char) *c );
+			}
+
+			AcquireSRWLockExclusive( &m_2DALock );
+			m_2DAs.erase( ResourceName );
+			ReleaseSRWLockExclusive( &m_2DALock );
+		}
+	}
+
+	return Applied;
+}
+
+void
+ResourceManager::GetDirectoryChangeEvents(
+	nwn2dev__out std::vector< HANDLE > & Events
+	)
+/*++
+
+Routine Description:
+
+	This routine retrieves the change notification events of all watched
+	directory resource providers.  An event is signaled when its directory
+	has changes for ProcessDirectoryChanges to apply.
+
+Arguments:
+
+	Events - Receives the change notification events.
+
+Return Value:
+
+	None.  Raises an std::exception on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	HANDLE Event;
+
+	Events.clear( );
+
+	for (DirFileVec::const_iterator it = m_DirFiles.begin( );
+	     it != m_DirFiles.end( );
+	     ++it)
+	{
+		Event = (*it)->GetChangeNotificationEvent( );
+
+		if (Event != NULL)
+			Events.push_back( Event );
+	}
+}
+
 void
 ResourceManager::ChangeTemporaryDirectory(
 	nwn2dev__in const std::string & TempDirectory
@@ -410,40 +551,102 @@ Environment:
 
 --*/
 {
-#if USE_INDEX
-	NWN::ResRef32                    ResRef32;
-	std::string                      ResPath;
-	HANDLE                           ResFile;
-	char                             Msg[ 512 ];
-	ResRefNameMap::iterator          nit;
-	ResourceEntryMap::const_iterator eit;
-	std::string                      LookupName;
+	std::string   LookupName;
+	std::string   ResPath;
+	char          TypeStr[ 32 ];
+	SRWLOCK     * DemandLock;
 
-	LookupName  = _itoa( (int) Type, Msg, 10 );
+	LookupName  = _itoa( (int) Type, TypeStr, 10 );
 	LookupName.push_back( 'T' );
 	LookupName += ResRef;
 
-	ResFile = INVALID_HANDLE_VALUE;
-
 	//
 	// First, check the cache to see if we've already located this one.
 	//
 
-	if ((nit = m_NameMap.find( LookupName )) != m_NameMap.end( ))
+	if (ReferenceDemandedFile( LookupName, ResPath ))
 	{
-		nit->second.Refs++;
+		m_Statistics.RecordOperation(
+			ResourceStatistics::SourceResourceManager,
+			ResourceStatistics::OpDemandCacheHit,
+			0,
+			0);
 
-		try
-		{
-			return nit->second.ResourceFileName;
-		}
-		catch (...)
-		{
-			nit->second.Refs--;
-			throw;
-		}
+		return ResPath;
+	}
+
+	//
+	// Otherwise, load the resource under its demand lock, so that concurrent
+	// demands for the same resource only extract it once.  The cache must be
+	// checked again once the lock is held.
+	//
+
+	DemandLock = &m_DemandLocks[ std::hash< std::string >( )( LookupName ) % DEMAND_LOCK_COUNT ];
+
+	AcquireSRWLockExclusive( DemandLock );
+
+	try
+	{
+		if (!ReferenceDemandedFile( LookupName, ResPath ))
+			ResPath = DemandLocked( ResRef, Type, LookupName );
+	}
+	catch (...)
+	{
+		ReleaseSRWLockExclusive( DemandLock );
+		throw;
 	}
 
+	ReleaseSRWLockExclusive( DemandLock );
+
+	return ResPath;
+}
+
+std::string
+ResourceManager::DemandLocked(
+	nwn2dev__in const std::string & ResRef,
+	nwn2dev__in ResType Type,
+	nwn2dev__in const std::string & LookupName
+	)
+/*++
+
+Routine Description:
+
+	This routine demand-loads a resource that was not already present in the
+	demand-loaded file table, and links it into the table with a single
+	reference.
+
+Arguments:
+
+	ResRef - Supplies the resource reference identifying the name of the
+	         resource to load.
+
+	Type - Supplies the type of the resource to load.
+
+	LookupName - Supplies the demand-loaded file table lookup name of the
+	             resource.
+
+Return Value:
+
+	A fully qualified file name that may be used to access the demanded file is
+	returned on success.
+
+	The routine raises an std::exception on failure.
+
+Environment:
+
+	User mode, demand lock for LookupName held.
+
+--*/
+{
+#if USE_INDEX
+	NWN::ResRef32                    ResRef32;
+	std::string                      ResPath;
+	HANDLE                           ResFile;
+	char                             Msg[ 512 ];
+	ResourceEntryMap::const_iterator eit;
+
+	ResFile = INVALID_HANDLE_VALUE;
+
 	CheckResFileName( ResRef );
 
 	ZeroMemory( ResRef32.RefStr, sizeof( ResRef32.RefStr ) );
@@ -466,6 +669,12 @@ Environment:
 
 		Entry = &m_ResourceEntries[ eit->second ];
 
+		ResourceStatistics::ScopedOperation StatOp(
+			&m_Statistics,
+			(ResourceStatistics::STAT_SOURCE) Entry->Tier,
+			ResourceStatistics::OpDemand,
+			LookupName.c_str( ));
+
 		//
 		// Pull the file and return it to the caller.
 		//
@@ -497,8 +706,62 @@ Environment:
 			Ref.Refs             = 1;
 			Ref.Delete           = false;
 
-			m_NameMap.insert(
-				ResRefNameMap::value_type( LookupName, Ref ) );
+			InsertDemandedFile( LookupName, Ref );
+
+			return ResPath;
+		}
+
+		//
+		// If resource deduplication is enabled, extract the file through the
+		// deduplication store, so that identical resources share a single
+		// temporary file.
+		//
+
+		if (m_ResManFlags & ResManFlagDeduplicateResources)
+		{
+			ULONGLONG SpillStart;
+			size_t    FileSize;
+
+			SpillStart = m_Statistics.IsEnabled( ) ? ResourceStatistics::GetTimestamp( ) : 0;
+
+			ResPath  = m_TempPath;
+			ResPath += ResRef;
+			ResPath += ".";
+			ResPath += ResTypeToExt( Type );
+
+			try
+			{
+				FileSize = SpillDeduplicatedResource( Entry, ResPath );
+
+				Ref.ResourceFileName = ResPath;
+				Ref.Refs             = 1;
+				Ref.Delete           = true;
+
+				InsertDemandedFile( LookupName, Ref );
+			}
+			catch (std::exception &e)
+			{
+				StatOp.Cancel( );
+
+				DeleteFileA( ResPath.c_str( ) );
+
+				m_TextWriter->WriteText(
+					"WARNING: Exception '%s' loading resource '%s' (type %04X).\n",
+					e.what( ),
+					ResRef.c_str( ),
+					(unsigned short) Type);
+
+				throw;
+			}
+
+			m_Statistics.RecordOperation(
+				(ResourceStatistics::STAT_SOURCE) Entry->Tier,
+				ResourceStatistics::OpTempFileSpill,
+				SpillStart,
+				FileSize,
+				LookupName.c_str( ));
+
+			StatOp.SetBytes( FileSize );
 
 			return ResPath;
 		}
@@ -511,10 +774,13 @@ Environment:
 
 		try
 		{
-			size_t FileSize;
-			size_t BytesLeft;
-			size_t Offset;
-			LONG   DistHigh;
+			size_t    FileSize;
+			size_t    BytesLeft;
+			size_t    Offset;
+			LONG      DistHigh;
+			ULONGLONG SpillStart;
+
+			SpillStart = m_Statistics.IsEnabled( ) ? ResourceStatistics::GetTimestamp( ) : 0;
 
 			//
 			// Open a handle to the file.
@@ -542,15 +808,20 @@ Environment:
 			ResPath += ResTypeToExt( Type );
 
 			//
-			// Open the temp file.
+			// Open the temp file.  A stale file of the same name may be a
+			// hard link that shares its contents with other temp files (see
+			// ResourceDedupStore::LinkSpill), so it is replaced rather than
+			// rewritten in place.
 			//
 
+			DeleteFileA( ResPath.c_str( ) );
+
 			ResFile = CreateFileA(
 				ResPath.c_str( ),
 				GENERIC_WRITE,
 				FILE_SHARE_WRITE,
 				NULL,
-				CREATE_ALWAYS,
+				CREATE_NEW,
 				FILE_ATTRIBUTE_TEMPORARY,
 				NULL);
 
@@ -631,15 +902,33 @@ Environment:
 				BytesLeft -= Read;
 			}
 
+			//
+			// Close the temp file before publishing it, as other threads may
+			// pick it up from the demand-loaded file table immediately.
+			//
+
+			CloseHandle( ResFile );
+			ResFile = INVALID_HANDLE_VALUE;
+
+			m_Statistics.RecordOperation(
+				(ResourceStatistics::STAT_SOURCE) Entry->Tier,
+				ResourceStatistics::OpTempFileSpill,
+				SpillStart,
+				FileSize,
+				LookupName.c_str( ));
+
+			StatOp.SetBytes( FileSize );
+
 			Ref.ResourceFileName = ResPath;
 			Ref.Refs             = 1;
 			Ref.Delete           = true;
 
-			m_NameMap.insert(
-				ResRefNameMap::value_type( LookupName, Ref ) );
+			InsertDemandedFile( LookupName, Ref );
 		}
 		catch (std::exception &e)
 		{
+			StatOp.Cancel( );
+
 			if (Handle != INVALID_FILE)
 				Entry->Accessor->CloseFile( Handle );
 
@@ -659,6 +948,8 @@ Environment:
 		}
 		catch (...)
 		{
+			StatOp.Cancel( );
+
 			if (Handle != INVALID_FILE)
 				Entry->Accessor->CloseFile( Handle );
 
@@ -672,10 +963,9 @@ Environment:
 		}
 
 		//
-		// Close out both files and call it done.
+		// Close out the source file and call it done.
 		//
 
-		CloseHandle( ResFile );
 		Entry->Accessor->CloseFile( Handle );
 
 		//
@@ -691,34 +981,9 @@ Environment:
 	std::string             ResPath;
 	HANDLE                  ResFile;
 	char                    Msg[ 512 ];
-	ResRefNameMap::iterator nit;
-	std::string             LookupName;
-
-	LookupName  = _itoa( (int) Type, Msg, 10 );
-	LookupName.push_back( 'T' );
-	LookupName += ResRef;
 
 	ResFile = INVALID_HANDLE_VALUE;
 
-	//
-	// First, check the cache to see if we've already located this one.
-	//
-
-	if ((nit = m_NameMap.find( LookupName )) != m_NameMap.end( ))
-	{
-		try
-		{
-			nit->second.Refs++;
-
-			return nit->second.ResourceFileName;
-		}
-		catch (...)
-		{
-			nit->second.Refs--;
-			throw;
-		}
-	}
-
 	CheckResFileName( ResRef );
 
 	ZeroMemory( ResRef32.RefStr, sizeof( ResRef32.RefStr ) );
@@ -806,8 +1071,7 @@ Environment:
 					Ref.Refs             = 1;
 					Ref.Delete           = false;
 
-					m_NameMap.insert(
-						ResRefNameMap::value_type( LookupName, Ref ) );
+					InsertDemandedFile( LookupName, Ref );
 				}
 				catch (std::exception)
 				{
@@ -837,15 +1101,20 @@ Environment:
 				ResPath += ResTypeToExt( Type );
 
 				//
-				// Open the temp file.
+				// Open the temp file.  A stale file of the same name may be a
+				// hard link that shares its contents with other temp files (see
+				// ResourceDedupStore::LinkSpill), so it is replaced rather than
+				// rewritten in place.
 				//
 
+				DeleteFileA( ResPath.c_str( ) );
+
 				ResFile = CreateFileA(
 					ResPath.c_str( ),
 					GENERIC_WRITE,
 					FILE_SHARE_WRITE,
 					NULL,
-					CREATE_ALWAYS,
+					CREATE_NEW,
 					FILE_ATTRIBUTE_TEMPORARY,
 					NULL);
 
@@ -926,14 +1195,16 @@ Environment:
 					BytesLeft -= Read;
 				}
 
+				CloseHandle( ResFile );
+				ResFile = INVALID_HANDLE_VALUE;
+
 				DemandResourceRef Ref;
 
 				Ref.ResourceFileName = ResPath;
 				Ref.Refs             = 1;
 				Ref.Delete           = true;
 
-				m_NameMap.insert(
-					ResRefNameMap::value_type( LookupName, Ref ) );
+				InsertDemandedFile( LookupName, Ref );
 			}
 			catch (std::exception &e)
 			{
@@ -966,10 +1237,9 @@ Environment:
 			}
 
 			//
-			// Close out both files and call it done.
+			// Close out the source file and call it done.
 			//
 
-			CloseHandle( ResFile );
 			(*it)->CloseFile( Handle );
 
 			//
@@ -990,31 +1260,36 @@ Environment:
 	throw std::runtime_error( Msg );
 }
 
-bool
-ResourceManager::ResourceExists(
-	nwn2dev__in const NWN::ResRef32 & ResRef,
-	nwn2dev__in NWN::ResType Type
+ResourceManager::ResourceBufferPtr
+ResourceManager::DemandBuffer(
+	nwn2dev__in const std::string & ResRef,
+	nwn2dev__in ResType Type
 	)
 /*++
 
 Routine Description:
 
-	This routine determines whether a resource exists in the resource index,
-	without attempting to open it.  It can be used to avoid the penalty of an
-	exception in cases where resources are likely to not exist in non-error
-	cases.
+	This routine loads the entire contents of a resource into an immutable
+	in-memory buffer.
+
+	If resource deduplication is enabled, the buffer is submitted to the
+	deduplication store, and a buffer that was previously loaded for an
+	identical payload (from any resource provider) is returned in its place.
+
+	Unlike Demand, no temporary file is created and no reference needs to be
+	released; the buffer is freed once the last reference to it is dropped.
 
 Arguments:
 
 	ResRef - Supplies the resource reference identifying the name of the
-	         resource to check.
+	         resource to load.
 
-	Type - Supplies the resource type.
+	Type - Supplies the type of the resource to load.
 
 Return Value:
 
-	The routine returns a Boolean value indicating true if the resource could
-	be located, else false.
+	The routine returns a buffer holding the resource contents.  The routine
+	raises an std::exception on failure.
 
 Environment:
 
@@ -1022,17 +1297,358 @@ Environment:
 
 --*/
 {
-#if USE_INDEX
-	char        TypeStr[ 32 ];
-	std::string LookupName;
+	ResourceEntryMap::const_iterator   eit;
+	const ResourceEntry              * Entry;
+	std::vector< unsigned char >     * Contents;
+	ResourceBufferPtr                  Buffer;
+	char                               TypeStr[ 32 ];
+	std::string                        LookupName;
+	char                               Msg[ 512 ];
 
-	try
+	CheckResFileName( ResRef );
+
+	LookupName  = _itoa( (int) Type, TypeStr, 10 );
+	LookupName.push_back( 'T' );
+	LookupName += ResRef;
+
+	if ((eit = m_NameIdMap.find( LookupName )) == m_NameIdMap.end( ))
 	{
-		LookupName  = _itoa( (int) Type, TypeStr, 10 );
-		LookupName.push_back( 'T' );
-		LookupName += StrFromResRef( ResRef );
+		StringCbPrintfA(
+			Msg,
+			sizeof( Msg ),
+			"Failed to open RESREF '%s'",
+			ResRef.c_str( ) );
+		throw std::runtime_error( Msg );
 	}
-	catch (std::exception)
+
+	Entry    = &m_ResourceEntries[ eit->second ];
+	Contents = new std::vector< unsigned char >;
+	Buffer   = Contents;
+
+	LoadEncapsulatedFile( Entry->Accessor, Entry->FileIndex, *Contents );
+
+	if (!(m_ResManFlags & ResManFlagDeduplicateResources))
+		return Buffer;
+
+	return m_DedupStore.InternBuffer(
+		GetResourceContentKey( Entry, *Contents ),
+		Buffer);
+}
+
+ResourceDedupStore::ContentKey
+ResourceManager::GetResourceContentKey(
+	nwn2dev__in const ResourceEntry * Entry,
+	nwn2dev__in const std::vector< unsigned char > & Contents
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the content key of a resource whose contents have
+	been loaded.
+
+	Content keys are cached for the encapsulated and in-box tiers, whose
+	contents cannot change while they are loaded.  Directory and custom
+	provider contents may change at any time and are always rehashed.
+
+Arguments:
+
+	Entry - Supplies the resource index entry of the resource.
+
+	Contents - Supplies the contents of the resource.
+
+Return Value:
+
+	The routine returns the content key of the resource.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ResourceDedupStore::ContentKey Key;
+	bool                           Cacheable;
+
+	Cacheable = (Entry->Tier == TIER_ENCAPSULATED) ||
+	            (Entry->Tier == TIER_ENCAPSULAT16) ||
+	            (Entry->Tier == TIER_INBOX)        ||
+	            (Entry->Tier == TIER_INBOX_KEY);
+
+	if ((Cacheable) &&
+	    (m_DedupStore.LookupCachedKey( Entry->Accessor, Entry->FileIndex, Key )))
+	{
+		return Key;
+	}
+
+	Key = ResourceDedupStore::HashContents(
+		Contents.empty( ) ? NULL : &Contents[ 0 ],
+		Contents.size( ));
+
+	if (Cacheable)
+		m_DedupStore.CacheKey( Entry->Accessor, Entry->FileIndex, Key );
+
+	return Key;
+}
+
+size_t
+ResourceManager::SpillDeduplicatedResource(
+	nwn2dev__in const ResourceEntry * Entry,
+	nwn2dev__in const std::string & ResPath
+	)
+/*++
+
+Routine Description:
+
+	This routine extracts a resource to a temporary file.  If a temporary
+	file with identical contents was already extracted, the new file is
+	created as a hard link to it, else the file is written out and then
+	registered with the deduplication store.
+
+Arguments:
+
+	Entry - Supplies the resource index entry of the resource.
+
+	ResPath - Supplies the name of the temporary file to create.
+
+Return Value:
+
+	The routine returns the size of the resource.  The routine raises an
+	std::exception on failure, in which case the caller deletes the
+	temporary file.
+
+Environment:
+
+	User mode, demand lock for the resource held.
+
+--*/
+{
+	std::vector< unsigned char >   Contents;
+	ResourceDedupStore::ContentKey Key;
+	HANDLE                         ResFile;
+	size_t                         Offset;
+	char                           Msg[ 512 ];
+
+	LoadEncapsulatedFile( Entry->Accessor, Entry->FileIndex, Contents );
+
+	Key = GetResourceContentKey( Entry, Contents );
+
+	if (m_DedupStore.LinkSpill( Key, Contents, ResPath ))
+		return Contents.size( );
+
+	//
+	// Never write through an existing file, which may be a link that shares
+	// its contents with other temporary files.
+	//
+
+	DeleteFileA( ResPath.c_str( ) );
+
+	ResFile = CreateFileA(
+		ResPath.c_str( ),
+		GENERIC_WRITE,
+		FILE_SHARE_WRITE,
+		NULL,
+		CREATE_NEW,
+		FILE_ATTRIBUTE_TEMPORARY,
+		NULL);
+
+	if (ResFile == INVALID_HANDLE_VALUE)
+	{
+		StringCbPrintfA(
+			Msg,
+			sizeof( Msg ),
+			"CreateFile( %s ) failed",
+			ResPath.c_str( ) );
+
+		throw std::runtime_error( Msg );
+	}
+
+	for (Offset = 0; Offset < Contents.size( ); )
+	{
+		DWORD Written;
+
+		if ((!WriteFile(
+			ResFile,
+			&Contents[ Offset ],
+			(DWORD) std::min( Contents.size( ) - Offset, static_cast< size_t >( 0x10000000 ) ),
+			&Written,
+			NULL)) || (Written == 0))
+		{
+			CloseHandle( ResFile );
+			throw std::runtime_error( "WriteFile failed" );
+		}
+
+		Offset += Written;
+	}
+
+	CloseHandle( ResFile );
+
+	m_DedupStore.RegisterSpill( Key, ResPath );
+
+	return Contents.size( );
+}
+
+void
+ResourceManager::BuildDuplicateReport(
+	nwn2dev__out DuplicateReportVec & Report,
+	nwn2dev__in bool IncludeInbox
+	)
+/*++
+
+Routine Description:
+
+	This routine builds a report of duplicate resource payloads across all
+	loaded resource providers.
+
+	Every resource of every provider is loaded and hashed (through the
+	content key cache, so that later deduplicated loads need not hash the
+	resource again).  Providers are visited in canonical search order, and
+	a resource is counted as a duplicate if its content key was already seen
+	in an earlier provider, or earlier in the same provider.
+
+Arguments:
+
+	Report - Receives one entry per resource provider, in search order.
+
+	IncludeInbox - Supplies a Boolean value indicating true if the in-box
+	               (zip and KEY/BIF) providers are to be included.
+
+Return Value:
+
+	None.  The routine raises an std::exception on failure.  Resources that
+	cannot be read are skipped with a warning.
+
+Environment:
+
+	User mode.  No other resource manager calls may be in progress.
+
+--*/
+{
+	typedef std::set< std::pair< ULONGLONG, ULONGLONG > > ContentKeySet;
+
+	ContentKeySet                Seen;
+	std::vector< unsigned char > Contents;
+
+	Report.clear( );
+
+	for (size_t i = 0; i < MAX_TIERS; i += 1)
+	{
+		if ((!IncludeInbox) && ((i == TIER_INBOX) || (i == TIER_INBOX_KEY)))
+			continue;
+
+		for (ResourceAccessorVec::reverse_iterator it = m_ResourceFiles[ i ].rbegin( );
+		     it != m_ResourceFiles[ i ].rend( );
+		     ++it)
+		{
+			DuplicateReportEntry Item;
+			ResourceEntry        Entry;
+			FileId               Count;
+
+			try
+			{
+				Item.ProviderType = (*it)->GetResourceAccessorName(
+					INVALID_FILE,
+					Item.ProviderName);
+			}
+			catch (std::exception)
+			{
+				Item.ProviderType = AccessorTypeCustom;
+				Item.ProviderName = "<custom>";
+			}
+
+			Item.Tier               = i;
+			Item.Resources          = 0;
+			Item.Bytes              = 0;
+			Item.DuplicateResources = 0;
+			Item.DuplicateBytes     = 0;
+
+			Entry.Accessor  = (*it);
+			Entry.Tier      = i;
+			Entry.TierIndex = 0;
+
+			Count = (*it)->GetEncapsulatedFileCount( );
+
+			for (FileId FileIndex = 0; FileIndex < Count; FileIndex += 1)
+			{
+				ResourceDedupStore::ContentKey Key;
+
+				Entry.FileIndex = FileIndex;
+
+				try
+				{
+					LoadEncapsulatedFile( *it, FileIndex, Contents );
+				}
+				catch (std::exception &e)
+				{
+					m_TextWriter->WriteText(
+						"WARNING: Failed to read resource %I64u of '%s': exception '%s'.\n",
+						(ULONGLONG) FileIndex,
+						Item.ProviderName.c_str( ),
+						e.what( ));
+
+					continue;
+				}
+
+				Key = GetResourceContentKey( &Entry, Contents );
+
+				Item.Resources += 1;
+				Item.Bytes     += Contents.size( );
+
+				if (!Seen.insert( std::make_pair( Key.Hash, Key.Size ) ).second)
+				{
+					Item.DuplicateResources += 1;
+					Item.DuplicateBytes     += Contents.size( );
+				}
+			}
+
+			Report.push_back( Item );
+		}
+	}
+}
+
+bool
+ResourceManager::ResourceExists(
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	nwn2dev__in NWN::ResType Type
+	)
+/*++
+
+Routine Description:
+
+	This routine determines whether a resource exists in the resource index,
+	without attempting to open it.  It can be used to avoid the penalty of an
+	exception in cases where resources are likely to not exist in non-error
+	cases.
+
+Arguments:
+
+	ResRef - Supplies the resource reference identifying the name of the
+	         resource to check.
+
+	Type - Supplies the resource type.
+
+Return Value:
+
+	The routine returns a Boolean value indicating true if the resource could
+	be located, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+#if USE_INDEX
+	char        TypeStr[ 32 ];
+	std::string LookupName;
+
+	try
+	{
+		LookupName  = _itoa( (int) Type, TypeStr, 10 );
+		LookupName.push_back( 'T' );
+		LookupName += StrFromResRef( ResRef );
+	}
+	catch (std::exception)
 	{
 		return false;
 	}
@@ -1083,6 +1699,9 @@ Environment:
 	char                    Name[ MAX_PATH ];
 	NWN::ResType            ResType;
 	ResRefNameMap::iterator nit;
+	std::string             RefName;
+	LONG                    Refs;
+	bool                    Found;
 
 	if (_splitpath_s(
 		ResourceFileName.c_str( ),
@@ -1119,8 +1738,6 @@ Environment:
 
 	try
 	{
-		std::string RefName;
-
 		_strlwr( Name );
 
 		_itoa( (int) ResType, Ext, 10 );
@@ -1128,15 +1745,29 @@ Environment:
 		RefName  = Ext;
 		RefName.push_back( 'T' );
 		RefName += Name;
-
-		nit = m_NameMap.find( RefName );
 	}
 	catch (std::exception)
 	{
 		return;
 	}
 
-	if (nit == m_NameMap.end( ))
+	//
+	// Drop the reference to us.  The table is only locked shared for this, as
+	// the reference count is updated atomically.
+	//
+
+	AcquireSRWLockShared( &m_NameMapLock );
+
+	nit   = m_NameMap.find( RefName );
+	Found = (nit != m_NameMap.end( ));
+	Refs  = 0;
+
+	if (Found)
+		Refs = InterlockedDecrement( &nit->second.Refs );
+
+	ReleaseSRWLockShared( &m_NameMapLock );
+
+	if (!Found)
 	{
 		if (m_TextWriter != NULL)
 		{
@@ -1150,17 +1781,31 @@ Environment:
 	}
 
 	//
-	// Drop the reference to us and perform the appropriate action once the
-	// reference count goes to zero.
+	// Perform the appropriate action once the reference count goes to zero.
+	// A concurrent Demand may have revived the entry by the time that the
+	// table is locked exclusively, in which case it is left alone.
+	//
+	// N.B.  The file is deleted before the exclusive lock is dropped, so a
+	//       later Demand that extracts the resource again cannot collide
+	//       with the delete.
 	//
 
-	if (--nit->second.Refs == 0)
+	if (Refs != 0)
+		return;
+
+	AcquireSRWLockExclusive( &m_NameMapLock );
+
+	nit = m_NameMap.find( RefName );
+
+	if ((nit != m_NameMap.end( )) && (nit->second.Refs == 0))
 	{
 		if (nit->second.Delete)
 			DeleteFileA( nit->second.ResourceFileName.c_str( ) );
 
 		m_NameMap.erase( nit );
 	}
+
+	ReleaseSRWLockExclusive( &m_NameMapLock );
 }
 
 FileHandle
@@ -1217,10 +1862,20 @@ Environment:
 		//
 
 		Entry          = &m_ResourceEntries[ eit->second ];
+
+		ResourceStatistics::ScopedOperation StatOp(
+			&m_Statistics,
+			(ResourceStatistics::STAT_SOURCE) Entry->Tier,
+			ResourceStatistics::OpOpen,
+			LookupName.c_str( ));
+
 		AccessorHandle = Entry->Accessor->OpenFileByIndex( Entry->FileIndex );
 
 		if (AccessorHandle == INVALID_FILE)
+		{
+			StatOp.Cancel( );
 			return INVALID_FILE;
+		}
 
 		//
 		// We've found a match, build a resource manager handle and return
@@ -1236,21 +1891,14 @@ Environment:
 			// Allocate a resource manager handle table entry.
 			//
 
-			ResManHandle = AllocateFileHandle( );
-
-			if (ResManHandle == INVALID_FILE)
-				throw std::runtime_error( "Failed to build FileHandle" );
-
 			HandleEntry.Accessor = Entry->Accessor;
 			HandleEntry.Handle   = AccessorHandle;
 			HandleEntry.Type     = Type;
 
-			//
-			// Link the handle table entry up.
-			//
+			ResManHandle = InsertFileHandle( HandleEntry );
 
-			m_ResFileHandles.insert(
-				ResHandleMap::value_type( ResManHandle, HandleEntry ) );
+			if (ResManHandle == INVALID_FILE)
+				throw std::runtime_error( "Failed to build FileHandle" );
 
 			//
 			// All done.
@@ -1260,6 +1908,8 @@ Environment:
 		}
 		catch (std::exception &e)
 		{
+			StatOp.Cancel( );
+
 			Entry->Accessor->CloseFile( AccessorHandle );
 
 			m_TextWriter->WriteText(
@@ -1272,6 +1922,8 @@ Environment:
 		}
 		catch (...)
 		{
+			StatOp.Cancel( );
+
 			Entry->Accessor->CloseFile( AccessorHandle );
 
 			throw;
@@ -1314,21 +1966,14 @@ Environment:
 				// Allocate a resource manager handle table entry.
 				//
 
-				ResManHandle = AllocateFileHandle( );
-
-				if (ResManHandle == INVALID_FILE)
-					throw std::runtime_error( "Failed to build FileHandle" );
-
 				HandleEntry.Accessor = (*it);
 				HandleEntry.Handle   = AccessorHandle;
 				HandleEntry.Type     = Type;
 
-				//
-				// Link the handle table entry up.
-				//
+				ResManHandle = InsertFileHandle( HandleEntry );
 
-				m_ResFileHandles.insert(
-					ResHandleMap::value_type( ResManHandle, HandleEntry ) );
+				if (ResManHandle == INVALID_FILE)
+					throw std::runtime_error( "Failed to build FileHandle" );
 
 				//
 				// All done.
@@ -1428,21 +2073,14 @@ Environment:
 		// Allocate a resource manager handle table entry.
 		//
 
-		ResManHandle = AllocateFileHandle( );
-
-		if (ResManHandle == INVALID_FILE)
-			throw std::runtime_error( "Failed to build FileHandle" );
-
 		HandleEntry.Accessor = Entry->Accessor;
 		HandleEntry.Handle   = AccessorHandle;
 		HandleEntry.Type     = Type;
 
-		//
-		// Link the handle table entry up.
-		//
+		ResManHandle = InsertFileHandle( HandleEntry );
 
-		m_ResFileHandles.insert(
-			ResHandleMap::value_type( ResManHandle, HandleEntry ) );
+		if (ResManHandle == INVALID_FILE)
+			throw std::runtime_error( "Failed to build FileHandle" );
 
 		//
 		// All done.
@@ -1496,25 +2134,34 @@ Environment:
 
 --*/
 {
-	ResHandleMap::iterator it = m_ResFileHandles.find( File );
-	bool                   Res;
+	ResHandleMap::iterator it;
+	ResHandle              HandleEntry;
+
+	//
+	// Invalidate the resource manager handle.
+	//
+
+	AcquireSRWLockExclusive( &m_FileHandleLock );
+
+	it = m_ResFileHandles.find( File );
 
 	if (it == m_ResFileHandles.end( ))
+	{
+		ReleaseSRWLockExclusive( &m_FileHandleLock );
 		return false;
+	}
 
-	//
-	// Delegate the request to the underlying accessor's implementation.
-	//
+	HandleEntry = it->second;
+
+	m_ResFileHandles.erase( it );
 
-	Res = it->second.Accessor->CloseFile( it->second.Handle );
+	ReleaseSRWLockExclusive( &m_FileHandleLock );
 
 	//
-	// Invalidate the resource manager handle.
+	// Delegate the request to the underlying accessor's implementation.
 	//
 
-	m_ResFileHandles.erase( it );
-
-	return Res;
+	return HandleEntry.Accessor->CloseFile( HandleEntry.Handle );
 }
 
 bool
@@ -1531,7 +2178,7 @@ Routine Description:
 
 	This routine logically reads an encapsulated sub-file.
 
-	File reading is optimized for sequential scan.
+	Reads may be issued concurrently from multiple threads.
 
 Arguments:
 
@@ -1558,17 +2205,17 @@ Environment:
 
 --*/
 {
-	ResHandleMap::const_iterator it = m_ResFileHandles.find( File );
+	ResHandle HandleEntry;
 
-	if (it == m_ResFileHandles.end( ))
+	if (!LookupFileHandle( File, HandleEntry ))
 		return 0;
 
 	//
 	// Delegate the request to the underlying accessor's implementation.
 	//
 
-	return it->second.Accessor->ReadEncapsulatedFile(
-		it->second.Handle,
+	return HandleEntry.Accessor->ReadEncapsulatedFile(
+		HandleEntry.Handle,
 		Offset,
 		BytesToRead,
 		BytesRead,
@@ -1605,16 +2252,16 @@ Environment:
 
 --*/
 {
-	ResHandleMap::const_iterator it = m_ResFileHandles.find( File );
+	ResHandle HandleEntry;
 
-	if (it == m_ResFileHandles.end( ))
+	if (!LookupFileHandle( File, HandleEntry ))
 		return 0;
 
 	//
 	// Delegate the request to the underlying accessor's implementation.
 	//
 
-	return it->second.Accessor->GetEncapsulatedFileSize( it->second.Handle );
+	return HandleEntry.Accessor->GetEncapsulatedFileSize( HandleEntry.Handle );
 }
 
 ResType
@@ -1647,12 +2294,12 @@ Environment:
 
 --*/
 {
-	ResHandleMap::const_iterator it = m_ResFileHandles.find( File );
+	ResHandle HandleEntry;
 
-	if (it == m_ResFileHandles.end( ))
+	if (!LookupFileHandle( File, HandleEntry ))
 		return NWN::ResINVALID;
 
-	return it->second.Type;
+	return HandleEntry.Type;
 }
 
 bool
@@ -1756,7 +2403,7 @@ Environment:
 
 --*/
 {
-	ResHandleMap::const_iterator it;
+	ResHandle HandleEntry;
 
 	if (File == INVALID_FILE)
 	{
@@ -1764,17 +2411,15 @@ Environment:
 		return AccessorTypeResourceManager;
 	}
 
-	it = m_ResFileHandles.find( File );
-
-	if (it == m_ResFileHandles.end( ))
+	if (!LookupFileHandle( File, HandleEntry ))
 		throw std::runtime_error( "invalid file handle passed to ResourceManager::GetResourceAccessorName" );
 
 	//
 	// Delegate the request to the underlying accessor's implementation.
 	//
 
-	return it->second.Accessor->GetResourceAccessorName(
-			it->second.Handle,
+	return HandleEntry.Accessor->GetResourceAccessorName(
+			HandleEntry.Handle,
 			AccessorName);
 }
 
@@ -1909,11 +2554,57 @@ Environment:
 
 --*/
 {
-	unsigned long RefId;
+	TlkFileReader::TalkStringView View;
+
+	if (!GetTalkStringView( StringId, View ))
+	{
+		String.clear( );
+		return false;
+	}
+
+	String.assign( View.first, View.second );
+
+	return true;
+}
+
+bool
+ResourceManager::GetTalkStringView(
+	nwn2dev__in unsigned long StringId,
+	nwn2dev__out TlkFileReader16::TalkStringView & View
+	) const
+/*++
+
+Routine Description:
+
+	This routine retrieves a view of a localized string from the string
+	tables, without copying the string.
+
+Arguments:
+
+	StringId - Supplies the STRREF to look up.
+
+	View - Receives a view of the localized string, on success.  The view
+	       remains valid until the talk tables are unloaded.
+
+Return Value:
+
+	The routine returns a Boolean value indicating whether the string could be
+	successfully located or not.
+	
+	On catastrophic failure, the routine raises an std::exception.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned long RefId;
 
 	if (StringId == STRREF_INVALID)
 	{
-		String = "";
+		View.first  = "";
+		View.second = 0;
 		return true;
 	}
 
@@ -1926,7 +2617,7 @@ Environment:
 	if (StringId & STRREF_TABLEMASK)
 	{
 		if ((m_AlternateTlk.get( ) != NULL) &&
-		    (m_AlternateTlk->GetTalkString( RefId, String )))
+		    (m_AlternateTlk->GetTalkStringView( RefId, View )))
 		{
 			return true;
 		}
@@ -1937,7 +2628,7 @@ Environment:
 	//
 
 	if ((m_BaseTlk.get( ) != NULL) &&
-	    (m_BaseTlk->GetTalkString( RefId, String )))
+	    (m_BaseTlk->GetTalkStringView( RefId, View )))
 	{
 		return true;
 	}
@@ -1981,60 +2672,16 @@ Environment:
 
 --*/
 {
-	TwoDANameMap::const_iterator it;
-
-	it = m_2DAs.find( ResourceName );
-
-	if (it == m_2DAs.end( ))
-	{
-		//
-		// Try and load the .2DA on demand using the resource manager's search
-		// hierarchy for locating the .2DA file.
-		//
-		// If successful, cache the 2DA object in-memory, drop the demanded
-		// resource reference (as the TwoDAFileReader does not require
-		// continual file access), and delegate the Get2DAString requets to the
-		// newly-instantiated TwoDAReader object.
-		//
-
-		try
-		{
-			TwoDAFileReaderPtr Reader;
-			DemandResourceStr  Res( *this, ResourceName, NWN::Res2DA );
-
-			Reader = new TwoDAFileReader( Res );
-
-			m_2DAs.insert( TwoDANameMap::value_type( ResourceName, Reader ) );
-
-			return Reader->Get2DAString( Column, Row, Value );
-		}
-		catch (std::exception &e)
-		{
-			m_TextWriter->WriteText(
-				"WARNING: Failed to access 2DA '%s' ('%s'/%lu): exception '%s'.\n",
-				ResourceName.c_str( ),
-				Column.c_str( ),
-				Row,
-				e.what( ));
-
-			//
-			// Cache a NULL reader pointer so that we don't try and hit the
-			// resource list each time from now on.  Failures to load a 2DA are
-			// not temporary failures and are typically symptomatic of a critical
-			// condition such as a missing or malformed .2DA on-disk.
-			//
-
-			m_2DAs.insert( TwoDANameMap::value_type( ResourceName, (TwoDAFileReader *) NULL ) );
-		}
-
-		return false;
-	}
+	const TwoDAFileReader * Reader;
 
 	//
-	// If we cached this .2DA as not present, fail all attempts to access it.
+	// Look up the .2DA, loading and caching it on first use.  If we cached
+	// this .2DA as not present, fail all attempts to access it.
 	//
 
-	if (it->second.get( ) == NULL)
+	Reader = Get2DA( ResourceName );
+
+	if (Reader == NULL)
 		return false;
 
 	//
@@ -2043,7 +2690,7 @@ Environment:
 
 	try
 	{
-		return it->second->Get2DAString( Column, Row, Value );
+		return Reader->Get2DAString( Column, Row, Value );
 	}
 	catch (std::exception &e)
 	{
@@ -2209,6 +2856,13 @@ Environment:
 				false);
 		}
 
+		//
+		// Attach the resource statistics to the resource accessors that we
+		// have loaded.
+		//
+
+		AttachStatistics( );
+
 #if USE_INDEX
 		//
 		// Now, discover and index all resources.
@@ -2217,6 +2871,29 @@ Environment:
 		DiscoverResources( );
 #endif
 
+		//
+		// Start watching directory providers for changes if we were asked to.
+		// Any changes made while the directories were being scanned are then
+		// applied straight away.
+		//
+
+		if (m_ResManFlags & ResManFlagWatchDirectories)
+		{
+			for (DirFileVec::iterator it = m_DirFiles.begin( );
+			     it != m_DirFiles.end( );
+			     ++it)
+			{
+				if (!(*it)->EnableChangeNotification( ))
+				{
+					m_TextWriter->WriteText(
+						"WARNING: Failed to watch directory '%s' for changes.\n",
+						(*it)->GetDirectoryName( ).c_str( ));
+				}
+			}
+
+			ProcessDirectoryChanges( );
+		}
+
 		//
 		// Now load talk tables after we've initialized all resources.
 		//
@@ -3254,6 +3931,9 @@ Environment:
 				TlkFile.c_str( ));
 
 			m_AlternateTlk = new TlkFileReader( TlkFile );
+
+			if (m_ResManFlags & ResManFlagDecodeTalkTables)
+				m_AlternateTlk->DecodeAllStrings( true );
 		}
 		catch (std::exception &e)
 		{
@@ -3276,6 +3956,9 @@ Environment:
 			TlkFile.c_str( ));
 
 		m_BaseTlk = new TlkFileReader( TlkFile );
+
+		if (m_ResManFlags & ResManFlagDecodeTalkTables)
+			m_BaseTlk->DecodeAllStrings( true );
 	}
 	catch (std::exception &e)
 	{
@@ -3481,7 +4164,7 @@ Environment:
 	// Unload 2DA files.
 	//
 
-	m_2DAs.clear( );
+	Clear2DACache( );
 
 	//
 	// Unload TLK files.
@@ -3493,6 +4176,11 @@ Environment:
 	//
 	// Close any still-open file handles.
 	//
+	// N.B.  Unloading never runs concurrently with other resource manager
+	//       calls, but the tables are locked regardless for consistency.
+	//
+
+	AcquireSRWLockExclusive( &m_FileHandleLock );
 
 	FilesForceClosed += m_ResFileHandles.size( );
 
@@ -3508,6 +4196,10 @@ Environment:
 
 	m_ResFileHandles.clear( );
 
+	ReleaseSRWLockExclusive( &m_FileHandleLock );
+
+	AcquireSRWLockExclusive( &m_NameMapLock );
+
 	FilesForceClosed += m_NameMap.size( );
 
 	//
@@ -3530,6 +4222,8 @@ Environment:
 
 	m_NameMap.clear( );
 
+	ReleaseSRWLockExclusive( &m_NameMapLock );
+
 	return FilesForceClosed;
 }
 
@@ -3568,8 +4262,16 @@ Environment:
 	//
 
 	m_NameIdMap.clear( );
+	m_VacantNameIdMap.clear( );
 	m_ResourceEntries.clear( );
 
+	//
+	// Forget all deduplicated payloads, as the cached content keys refer to
+	// the resource providers that are about to be unloaded.
+	//
+
+	m_DedupStore.Clear( );
+
 	//
 	// Unload all resource providers.  First, sever the canonical search order
 	// links.
@@ -3753,6 +4455,80 @@ Environment:
 	FindClose( Find );
 }
 
+void
+ResourceManager::AttachStatistics(
+	)
+/*++
+
+Routine Description:
+
+	This routine attaches the resource manager's statistics to each resource
+	accessor that it has created, so that the accessors report their reads
+	against the tier that they were loaded into.
+
+	Custom resource providers supplied by the caller do not report their own
+	statistics; their operations are only counted by the resource manager.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	for (HakFileVec::iterator it = m_HakFiles.begin( );
+	     it != m_HakFiles.end( );
+	     ++it)
+	{
+		(*it)->SetStatistics(
+			&m_Statistics,
+			ResourceStatistics::SourceEncapsulated);
+	}
+
+	for (HakFile16Vec::iterator it = m_HakFiles16.begin( );
+	     it != m_HakFiles16.end( );
+	     ++it)
+	{
+		(*it)->SetStatistics(
+			&m_Statistics,
+			ResourceStatistics::SourceEncapsulated16);
+	}
+
+	for (DirFileVec::iterator it = m_DirFiles.begin( );
+	     it != m_DirFiles.end( );
+	     ++it)
+	{
+		(*it)->SetStatistics(
+			&m_Statistics,
+			ResourceStatistics::SourceDirectory);
+	}
+
+	for (ZipFileVec::iterator it = m_ZipFiles.begin( );
+	     it != m_ZipFiles.end( );
+	     ++it)
+	{
+		(*it)->SetStatistics(
+			&m_Statistics,
+			ResourceStatistics::SourceInbox);
+	}
+
+	for (KeyFileVec::iterator it = m_KeyFiles.begin( );
+	     it != m_KeyFiles.end( );
+	     ++it)
+	{
+		(*it)->SetStatistics(
+			&m_Statistics,
+			ResourceStatistics::SourceInboxKey);
+	}
+}
+
 void
 ResourceManager::DiscoverResources(
 	)
@@ -3921,6 +4697,292 @@ Environment:
 #endif
 }
 
+bool
+ResourceManager::ApplyDirectoryChange(
+	nwn2dev__in size_t TierIndex,
+	nwn2dev__in IResourceAccessor * Accessor,
+	nwn2dev__in const DirectoryFileReader::DirectoryChange & Change
+	)
+/*++
+
+Routine Description:
+
+	This routine applies a single change reported by a watched directory
+	resource provider to the resource index.
+
+	Resource entry indicies (resource manager FileIds) remain stable:  an
+	entry is updated in place when a different copy of its resource becomes
+	the most precedent one.  An entry whose resource no longer exists is
+	dropped from the name map, and is reused should the resource reappear.
+
+Arguments:
+
+	TierIndex - Supplies the index of the directory provider within the
+	            directory tier, counted from the end (see ResourceEntry).
+
+	Accessor - Supplies the directory provider that reported the change.
+
+	Change - Supplies the change to apply.
+
+Return Value:
+
+	The routine returns true if the change altered a visible resource, else
+	false if the change was shadowed by a more precedent copy of the resource.
+	An std::exception is raised on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ResourceEntry                Entry;
+	ResourceEntry              * Current;
+	ResourceEntryMap::iterator   eit;
+	ResourceEntryMap::iterator   vit;
+	char                         TypeStr[ 32 ];
+	std::string                  LookupName;
+	const char                 * p;
+
+	p = (const char *) memchr(
+		Change.Name.RefStr,
+		'\0',
+		sizeof( Change.Name.RefStr ) );
+
+	LookupName = _itoa( (int) Change.Type, TypeStr, 10 );
+	LookupName.push_back( 'T' );
+
+	if (p == NULL)
+		LookupName.append( Change.Name.RefStr, sizeof( Change.Name.RefStr ) );
+	else
+		LookupName.append( Change.Name.RefStr, p - Change.Name.RefStr );
+
+	Entry.Accessor  = Accessor;
+	Entry.FileIndex = Change.FileIndex;
+	Entry.Tier      = TIER_DIRECTORY;
+	Entry.TierIndex = TierIndex;
+
+	eit     = m_NameIdMap.find( LookupName );
+	Current = (eit != m_NameIdMap.end( )) ? &m_ResourceEntries[ eit->second ] : NULL;
+
+	switch (Change.Action)
+	{
+
+	case DirectoryFileReader::DirectoryChangeAdded:
+		if (Current != NULL)
+		{
+			//
+			// The resource is already provided.  The new copy only becomes
+			// visible if it is more precedent than the current one.
+			//
+
+			if (!IsResourceEntryPrecedent( Entry, *Current ))
+				return false;
+
+			*Current = Entry;
+			return true;
+		}
+
+		//
+		// A new resource.  Reuse its previous entry if it existed before,
+		// else create a new one.
+		//
+
+		vit = m_VacantNameIdMap.find( LookupName );
+
+		if (vit != m_VacantNameIdMap.end( ))
+		{
+			m_NameIdMap.insert(
+				ResourceEntryMap::value_type(
+					LookupName,
+					vit->second
+					)
+				);
+
+			m_ResourceEntries[ vit->second ] = Entry;
+			m_VacantNameIdMap.erase( vit );
+			return true;
+		}
+
+		m_ResourceEntries.push_back( Entry );
+
+		try
+		{
+			m_NameIdMap.insert(
+				ResourceEntryMap::value_type(
+					LookupName,
+					m_ResourceEntries.size( ) - 1
+					)
+				);
+		}
+		catch (...)
+		{
+			m_ResourceEntries.pop_back( );
+			throw;
+		}
+
+		return true;
+
+	case DirectoryFileReader::DirectoryChangeRemoved:
+		if ((Current == NULL) ||
+		    (Current->Accessor != Accessor) ||
+		    (Current->FileIndex != Change.FileIndex))
+		{
+			//
+			// The removed copy was shadowed, so nothing visible changed.
+			//
+
+			return false;
+		}
+
+		//
+		// Fall back to the next most precedent copy of the resource.  The
+		// removed copy is no longer offered by its directory provider, so it
+		// will not be found again.
+		//
+
+		if (LocateResourceEntry( Change.Name, Change.Type, LookupName, Entry ))
+		{
+			*Current = Entry;
+			return true;
+		}
+
+		m_VacantNameIdMap.insert(
+			ResourceEntryMap::value_type(
+				LookupName,
+				eit->second
+				)
+			);
+
+		m_NameIdMap.erase( eit );
+		return true;
+
+	case DirectoryFileReader::DirectoryChangeModified:
+		return ((Current != NULL) &&
+		        (Current->Accessor == Accessor) &&
+		        (Current->FileIndex == Change.FileIndex));
+
+	default:
+		return false;
+
+	}
+}
+
+bool
+ResourceManager::LocateResourceEntry(
+	nwn2dev__in const ResRefT & ResRef,
+	nwn2dev__in ResType Type,
+	nwn2dev__in const std::string & LookupName,
+	nwn2dev__out ResourceEntry & Entry
+	)
+/*++
+
+Routine Description:
+
+	This routine searches all resource accessors for the most precedent copy
+	of a resource, in the same canonical order that DiscoverResources uses.
+
+	Each accessor is first probed by name (a hashed lookup for the built-in
+	accessors), so only the accessor that provides the resource has its file
+	entries walked to recover the file index.
+
+Arguments:
+
+	ResRef - Supplies the resource name.
+
+	Type - Supplies the resource type.
+
+	LookupName - Supplies the index lookup name of the resource.
+
+	Entry - Receives the resource entry for the most precedent copy of the
+	        resource.
+
+Return Value:
+
+	The routine returns true if the resource was found, else false.  An
+	std::exception is raised on catastrophic failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FileHandle   File;
+	FileId       MaxId;
+	ResRefT      EntryResRef;
+	ResType      EntryType;
+	char         TypeStr[ 32 ];
+	std::string  EntryName;
+	const char * p;
+
+	for (size_t i = 0; i < MAX_TIERS; i += 1)
+	{
+		size_t j;
+
+		j = 0;
+
+		for (ResourceAccessorVec::reverse_iterator it = m_ResourceFiles[ i ].rbegin( );
+		     it != m_ResourceFiles[ i ].rend( );
+		     ++it)
+		{
+			j += 1;
+
+			File = (*it)->OpenFile( ResRef, Type );
+
+			if (File == INVALID_FILE)
+				continue;
+
+			(*it)->CloseFile( File );
+
+			//
+			// Take the last matching entry, as DiscoverResources does.
+			//
+
+			MaxId = (*it)->GetEncapsulatedFileCount( );
+
+			for (FileId CurId = MaxId; CurId != 0; CurId -= 1)
+			{
+				if (!(*it)->GetEncapsulatedFileEntry(
+					CurId - 1,
+					EntryResRef,
+					EntryType))
+				{
+					continue;
+				}
+
+				if (EntryType != Type)
+					continue;
+
+				p = (const char *) memchr(
+					EntryResRef.RefStr,
+					'\0',
+					sizeof( EntryResRef.RefStr ) );
+
+				EntryName = _itoa( (int) EntryType, TypeStr, 10 );
+				EntryName.push_back( 'T' );
+
+				if (p == NULL)
+					EntryName.append( EntryResRef.RefStr, sizeof( EntryResRef.RefStr ) );
+				else
+					EntryName.append( EntryResRef.RefStr, p - EntryResRef.RefStr );
+
+				if (EntryName != LookupName)
+					continue;
+
+				Entry.Accessor  = (*it);
+				Entry.FileIndex = CurId - 1;
+				Entry.Tier      = i;
+				Entry.TierIndex = j;
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 FileHandle
 ResourceManager::AllocateFileHandle(
 	)
@@ -3932,7 +4994,9 @@ Routine Description:
 	of accessing resource data.
 
 	The returned handle value is only unique if the caller inserts it into the
-	handle table before another call to AllocateFileHandle.
+	handle table before another call to AllocateFileHandle.  The caller must
+	hold the file handle lock exclusively across both operations (see
+	InsertFileHandle).
 
 Arguments:
 
@@ -3977,6 +5041,208 @@ Environment:
 	return Handle;
 }
 
+FileHandle
+ResourceManager::InsertFileHandle(
+	nwn2dev__in const ResHandle & HandleEntry
+	)
+/*++
+
+Routine Description:
+
+	This routine allocates a new file handle and links it to a handle table
+	entry, atomically with respect to other threads.
+
+Arguments:
+
+	HandleEntry - Supplies the handle table entry to link to the new handle.
+
+Return Value:
+
+	The routine returns a legal FileHandle value on success, else it returns
+	INVALID_FILE if there were no more file handles available to return.  An
+	std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FileHandle Handle;
+
+	AcquireSRWLockExclusive( &m_FileHandleLock );
+
+	try
+	{
+		Handle = AllocateFileHandle( );
+
+		if (Handle != INVALID_FILE)
+		{
+			m_ResFileHandles.insert(
+				ResHandleMap::value_type( Handle, HandleEntry ) );
+		}
+	}
+	catch (...)
+	{
+		ReleaseSRWLockExclusive( &m_FileHandleLock );
+		throw;
+	}
+
+	ReleaseSRWLockExclusive( &m_FileHandleLock );
+
+	return Handle;
+}
+
+bool
+ResourceManager::LookupFileHandle(
+	nwn2dev__in FileHandle File,
+	nwn2dev__out ResHandle & HandleEntry
+	)
+/*++
+
+Routine Description:
+
+	This routine retrieves a copy of the handle table entry for a file handle.
+	The handle table is only locked for the duration of the lookup, so that
+	I/O against the underlying accessor proceeds without holding any lock.
+
+Arguments:
+
+	File - Supplies the file handle to look up.
+
+	HandleEntry - Receives the handle table entry.
+
+Return Value:
+
+	The routine returns true if the file handle was found, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ResHandleMap::const_iterator it;
+	bool                         Found;
+
+	AcquireSRWLockShared( &m_FileHandleLock );
+
+	it    = m_ResFileHandles.find( File );
+	Found = (it != m_ResFileHandles.end( ));
+
+	if (Found)
+		HandleEntry = it->second;
+
+	ReleaseSRWLockShared( &m_FileHandleLock );
+
+	return Found;
+}
+
+bool
+ResourceManager::ReferenceDemandedFile(
+	nwn2dev__in const std::string & LookupName,
+	nwn2dev__out std::string & ResourceFileName
+	)
+/*++
+
+Routine Description:
+
+	This routine looks up a demand-loaded file by lookup name, and takes a
+	reference to the file if it is present.
+
+	The table is only locked shared, as the reference count of an entry is
+	updated atomically.  An entry whose reference count has dropped to zero
+	may be revived here; Release checks for this before removing an entry.
+
+Arguments:
+
+	LookupName - Supplies the demand-loaded file table lookup name.
+
+	ResourceFileName - Receives the file name of the demand-loaded file.
+
+Return Value:
+
+	The routine returns true if a reference was taken, else false.  An
+	std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ResRefNameMap::iterator nit;
+	bool                    Found;
+
+	AcquireSRWLockShared( &m_NameMapLock );
+
+	nit   = m_NameMap.find( LookupName );
+	Found = (nit != m_NameMap.end( ));
+
+	if (Found)
+	{
+		try
+		{
+			ResourceFileName = nit->second.ResourceFileName;
+		}
+		catch (...)
+		{
+			ReleaseSRWLockShared( &m_NameMapLock );
+			throw;
+		}
+
+		InterlockedIncrement( &nit->second.Refs );
+	}
+
+	ReleaseSRWLockShared( &m_NameMapLock );
+
+	return Found;
+}
+
+void
+ResourceManager::InsertDemandedFile(
+	nwn2dev__in const std::string & LookupName,
+	nwn2dev__in const DemandResourceRef & Ref
+	)
+/*++
+
+Routine Description:
+
+	This routine links a newly demand-loaded file into the demand-loaded file
+	table.
+
+Arguments:
+
+	LookupName - Supplies the demand-loaded file table lookup name.
+
+	Ref - Supplies the demand-loaded file table entry.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode, demand lock for LookupName held.
+
+--*/
+{
+	AcquireSRWLockExclusive( &m_NameMapLock );
+
+	try
+	{
+		m_NameMap.insert(
+			ResRefNameMap::value_type( LookupName, Ref ) );
+	}
+	catch (...)
+	{
+		ReleaseSRWLockExclusive( &m_NameMapLock );
+		throw;
+	}
+
+	ReleaseSRWLockExclusive( &m_NameMapLock );
+}
+
 const TwoDAFileReader *
 ResourceManager::Get2DA(
 	nwn2dev__in const std::string & ResourceName
@@ -3998,7 +5264,8 @@ Return Value:
 
 	The routine returns a pointer to a TwoDAFileReader object on success, else
 	it returns NULL on failure.  The returned pointer may be used until the
-	module resources are unloaded.
+	module resources are unloaded, or until ProcessDirectoryChanges applies a
+	change to the 2DA.
 
 Environment:
 
@@ -4006,58 +5273,91 @@ Environment:
 
 --*/
 {
-	TwoDANameMap::const_iterator it;
+	TwoDANameMap::const_iterator   it;
+	TwoDAFileReaderPtr             Reader;
+	const TwoDAFileReader        * CachedReader;
+
+	AcquireSRWLockShared( &m_2DALock );
 
 	it = m_2DAs.find( ResourceName );
 
-	if (it == m_2DAs.end( ))
+	if (it != m_2DAs.end( ))
 	{
+		CachedReader = it->second.get( );
+
+		ReleaseSRWLockShared( &m_2DALock );
+
 		//
-		// Try and load the .2DA on demand using the resource manager's search
-		// hierarchy for locating the .2DA file.
-		//
-		// If successful, cache the 2DA object in-memory, drop the demanded
-		// resource reference (as the TwoDAFileReader does not require
-		// continual file access), and delegate the Get2DAString requets to the
-		// newly-instantiated TwoDAReader object.
+		// Use the cached 2DA reader.
 		//
 
-		try
-		{
-			TwoDAFileReaderPtr Reader;
-			DemandResourceStr  Res( *this, ResourceName, NWN::Res2DA );
+		m_Statistics.RecordOperation(
+			ResourceStatistics::SourceResourceManager,
+			ResourceStatistics::Op2DACacheHit,
+			0,
+			0);
 
-			Reader = new TwoDAFileReader( Res );
+		return CachedReader;
+	}
 
-			m_2DAs.insert( TwoDANameMap::value_type( ResourceName, Reader ) );
+	ReleaseSRWLockShared( &m_2DALock );
 
-			return Reader.get( );
-		}
-		catch (std::exception &e)
-		{
-			m_TextWriter->WriteText(
-				"WARNING: Failed to access 2DA '%s': exception '%s'.\n",
-				ResourceName.c_str( ),
-				e.what( ));
+	ResourceStatistics::ScopedOperation StatOp(
+		&m_Statistics,
+		ResourceStatistics::SourceResourceManager,
+		ResourceStatistics::Op2DALoad,
+		ResourceName.c_str( ));
 
-			//
-			// Cache a NULL reader pointer so that we don't try and hit the
-			// resource list each time from now on.  Failures to load a 2DA are
-			// not temporary failures and are typically symptomatic of a critical
-			// condition such as a missing or malformed .2DA on-disk.
-			//
+	//
+	// Try and load the .2DA on demand using the resource manager's search
+	// hierarchy for locating the .2DA file.
+	//
+	// If successful, cache the 2DA object in-memory, and drop the demanded
+	// resource reference (as the TwoDAFileReader does not require continual
+	// file access).
+	//
+	// N.B.  The .2DA is parsed without the cache lock held.  Should another
+	//       thread cache the same .2DA first, its reader is used instead.
+	//
 
-			m_2DAs.insert( TwoDANameMap::value_type( ResourceName, (TwoDAFileReader *) NULL ) );
-		}
+	try
+	{
+		DemandResourceStr Res( *this, ResourceName, NWN::Res2DA );
 
-		return NULL;
+		Reader = new TwoDAFileReader( Res );
 	}
+	catch (std::exception &e)
+	{
+		m_TextWriter->WriteText(
+			"WARNING: Failed to access 2DA '%s': exception '%s'.\n",
+			ResourceName.c_str( ),
+			e.what( ));
 
-	//
-	// Use the cached 2DA reader.
-	//
+		//
+		// Cache a NULL reader pointer so that we don't try and hit the
+		// resource list each time from now on.  Failures to load a 2DA are
+		// not temporary failures and are typically symptomatic of a critical
+		// condition such as a missing or malformed .2DA on-disk.
+		//
+
+		Reader = NULL;
+	}
+
+	AcquireSRWLockExclusive( &m_2DALock );
+
+	try
+	{
+		it           = m_2DAs.insert( TwoDANameMap::value_type( ResourceName, Reader ) ).first;
+		CachedReader = it->second.get( );
+	}
+	catch (std::exception)
+	{
+		CachedReader = NULL;
+	}
+
+	ReleaseSRWLockExclusive( &m_2DALock );
 
-	return it->second.get( );
+	return CachedReader;
 }
 
 //template DemandResource< std::string >;
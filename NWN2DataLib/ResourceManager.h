@@ -27,6 +27,8 @@ Abstract:
 #include "DirectoryFileReader.h"
 #include "ZipFileReader.h"
 #include "KeyFileReader.h"
+#include "ResourceStatistics.h"
+#include "ResourceDedupStore.h"
 
 #include "TlkFileReader.h"
 #include "2DAFileReader.h"
@@ -36,6 +38,27 @@ Abstract:
 
 struct IDebugTextOut;
 
+//
+// Define the resource manager.
+//
+// Concurrency model:  Loading and unloading resources (LoadModuleResources,
+// LoadModuleResourcesLite, UnloadAllResources and the like), as well as
+// applying directory changes (ProcessDirectoryChanges), must not overlap any
+// other call.  Once a load has completed, the resource index (the name to
+// resource entry map and the resource entry array) is immutable until the
+// next load or unload, and is read without any locking.
+//
+// All other operations, such as Demand, Release, OpenFile, ReadEncapsulatedFile,
+// CloseFile, Get2DAString, GetTalkString and GetTalkStringView, may be called
+// concurrently from multiple threads.  The handle table, the demand-loaded file
+// table and the 2DA cache are each guarded by their own reader/writer lock,
+// which is held only for the duration of a table lookup or update, and never
+// across I/O.  The talk table string caches are filled without a lock.
+// The built-in resource accessors issue positional reads, so they share no
+// seek state between threads.  Custom resource accessors must be safe for
+// concurrent use if the resource manager is used from multiple threads.
+//
+
 class ResourceManager : public IResourceAccessor< NWN::ResRef32 >
 {
 
@@ -129,6 +152,31 @@ public:
 
 		ResManFlagRequireModuleIfo   = 0x00000040,
 
+		//
+		// Watch the directory resource providers (such as the override
+		// directory, or a directory-mode module) for changes, so that they
+		// may be applied with ProcessDirectoryChanges instead of a reload.
+		//
+
+		ResManFlagWatchDirectories   = 0x00000080,
+
+		//
+		// Copy every string of the talk tables into the talk table string
+		// caches while loading, in parallel, so that later STRREF lookups
+		// never touch the TLK files.
+		//
+
+		ResManFlagDecodeTalkTables   = 0x00000100,
+
+		//
+		// Share identical resource payloads, regardless of which provider
+		// supplied them.  Resources loaded with DemandBuffer share a single
+		// buffer per payload, and resources demanded to temporary files share
+		// a single temporary file per payload (via hard links).
+		//
+
+		ResManFlagDeduplicateResources = 0x00000200,
+
 		LastResManFlag
 	} ResManFlags;
 
@@ -310,6 +358,36 @@ public:
 	CloseOpenResourceFileHandles(
 		);
 
+	//
+	// Apply the changes made to watched directory resource providers (see
+	// ResManFlagWatchDirectories) to the resource index:  added files become
+	// visible (shadowing any lower precedence copy of the resource), removed
+	// files fall back to the next most precedent copy, and cached 2DAs that
+	// were changed are reloaded on their next reference.  The routine does
+	// not wait for changes.
+	//
+	// Resources that are currently demand-loaded from a temporary copy keep
+	// that copy until they are released.
+	//
+	// The count of changes that altered a visible resource is returned.  An
+	// std::exception is raised on catastrophic failure.
+	//
+
+	ULONG
+	ProcessDirectoryChanges(
+		);
+
+	//
+	// Retrieve the events that are signaled when a watched directory resource
+	// provider has changes for ProcessDirectoryChanges to apply.  The events
+	// remain valid until the next load or unload.
+	//
+
+	void
+	GetDirectoryChangeEvents(
+		nwn2dev__out std::vector< HANDLE > & Events
+		);
+
 	//
 	// Change the temporary directory for the resource manager.  This routine
 	// should only be called before the resource manager has loaded any data
@@ -332,6 +410,103 @@ public:
 		nwn2dev__out std::string & String
 		) const;
 
+	//
+	// Look up a string based on STRREF, returning a view of the string text
+	// that remains valid until the talk tables are unloaded.  Returns false
+	// on failure, i.e. if the string could not be found.  No memory is
+	// allocated once a string has been cached by its talk table.
+	//
+
+	bool
+	GetTalkStringView(
+		nwn2dev__in unsigned long StringId,
+		nwn2dev__out TlkFileReader16::TalkStringView & View
+		) const;
+
+	//
+	// Return the resource I/O statistics of the resource manager.  Statistics
+	// collection is disabled by default; it should be enabled before module
+	// resources are loaded, and persists across loads until reset.
+	//
+
+	inline
+	ResourceStatistics &
+	GetStatistics(
+		)
+	{
+		return m_Statistics;
+	}
+
+	inline
+	const ResourceStatistics &
+	GetStatistics(
+		) const
+	{
+		return m_Statistics;
+	}
+
+	typedef ResourceDedupStore::ByteVecPtr ResourceBufferPtr;
+
+	//
+	// Load the entire contents of a resource into an immutable buffer.  If
+	// resource deduplication is enabled, identical resources share the same
+	// buffer.  The buffer remains valid for as long as it is referenced, even
+	// across module loads.  Raises an std::exception on failure.
+	//
+
+	ResourceBufferPtr
+	DemandBuffer(
+		nwn2dev__in const std::string & ResRef,
+		nwn2dev__in ResType Type
+		);
+
+	//
+	// Define a per-provider entry of the duplicate resource report.
+	// Duplicate counts cover the resources of the provider whose payloads
+	// were already supplied by a provider earlier in the search order (or
+	// earlier in the same provider).
+	//
+
+	struct DuplicateReportEntry
+	{
+		std::string  ProviderName;
+		AccessorType ProviderType;
+		size_t       Tier;
+		ULONGLONG    Resources;
+		ULONGLONG    Bytes;
+		ULONGLONG    DuplicateResources;
+		ULONGLONG    DuplicateBytes;
+	};
+
+	typedef std::vector< DuplicateReportEntry > DuplicateReportVec;
+
+	//
+	// Hash every resource of every loaded resource provider, including
+	// copies that are shadowed by a more precedent provider, and report the
+	// duplicate payloads of each provider in search order.  In-box resources
+	// are only included if requested, as hashing them reads all of the game
+	// data.  The routine must not be called concurrently with any other
+	// resource manager call.  Raises an std::exception on failure.
+	//
+
+	void
+	BuildDuplicateReport(
+		nwn2dev__out DuplicateReportVec & Report,
+		nwn2dev__in bool IncludeInbox
+		);
+
+	//
+	// Return the resource deduplication store, e.g. for its statistics.
+	//
+
+	inline
+	const ResourceDedupStore &
+	GetDedupStore(
+		) const
+	{
+		return m_DedupStore;
+	}
+
 	//
 	// Look up the value of a particular column at a given row index in a given
 	// .2DA file.
@@ -535,7 +710,9 @@ public:
 	Clear2DACache(
 		)
 	{
+		AcquireSRWLockExclusive( &m_2DALock );
 		m_2DAs.clear( );
+		ReleaseSRWLockExclusive( &m_2DALock );
 	}
 
 	//
@@ -1235,6 +1412,14 @@ private:
 		nwn2dev__in const char * DirPath
 		);
 
+	//
+	// Attach the resource statistics to all loaded resource accessors.
+	//
+
+	void
+	AttachStatistics(
+		);
+
 	//
 	// Scan all resource accessors and create the master resource id list.
 	//
@@ -1249,6 +1434,8 @@ private:
 	// implementation of IResourceAccessor that is provided by the resource
 	// manager itself.
 	//
+	// The caller must hold the file handle lock exclusively.
+	//
 	// The routine returns INVALID_FILE should there be no available file
 	// handles.
 	//
@@ -1362,9 +1549,9 @@ private:
 
 	struct DemandResourceRef
 	{
-		std::string ResourceFileName;
-		size_t      Refs;
-		bool        Delete;
+		std::string   ResourceFileName;
+		volatile LONG Refs;
+		bool          Delete;
 	};
 
         // typedef const enum _PROVIDER_TYPE * PCPROVIDER_TYPE;
@@ -1399,6 +1586,17 @@ private:
 		MAX_TIERS
 	};
 
+	//
+	// Define the count of demand locks.  A demand lock serializes the loading
+	// of a resource that is not yet demand-loaded, so that a resource is only
+	// extracted once; resources are hashed across the locks by lookup name.
+	//
+
+	enum
+	{
+		DEMAND_LOCK_COUNT  = 16
+	};
+
 	enum
 	{
 		STRREF_INVALID     = 0xFFFFFFFF,
@@ -1478,6 +1676,130 @@ private:
 
 	typedef swutil::SharedPtr< Gr2Accessor > Gr2AccessorPtr;
 
+	//
+	// Perform the body of a demand load for a resource that was not found in
+	// the demand-loaded file table.  The caller holds the demand lock for the
+	// resource's lookup name.
+	//
+
+	std::string
+	DemandLocked(
+		nwn2dev__in const std::string & ResRef,
+		nwn2dev__in ResType Type,
+		nwn2dev__in const std::string & LookupName
+		);
+
+	//
+	// Return the content key of a resource, computing it (and caching it for
+	// immutable providers) if it has not yet been computed.
+	//
+
+	ResourceDedupStore::ContentKey
+	GetResourceContentKey(
+		nwn2dev__in const ResourceEntry * Entry,
+		nwn2dev__in const std::vector< unsigned char > & Contents
+		);
+
+	//
+	// Demand a resource to a temporary file through the deduplication store.
+	// Returns the size of the resource.
+	//
+
+	size_t
+	SpillDeduplicatedResource(
+		nwn2dev__in const ResourceEntry * Entry,
+		nwn2dev__in const std::string & ResPath
+		);
+
+	//
+	// Apply a single directory change to the resource index.  The routine
+	// returns true if the change altered a visible resource.
+	//
+
+	bool
+	ApplyDirectoryChange(
+		nwn2dev__in size_t TierIndex,
+		nwn2dev__in IResourceAccessor * Accessor,
+		nwn2dev__in const DirectoryFileReader::DirectoryChange & Change
+		);
+
+	//
+	// Find the most precedent copy of a resource across all resource
+	// accessors, in the same canonical order that DiscoverResources uses.
+	// The routine returns false if no accessor provides the resource.
+	//
+
+	bool
+	LocateResourceEntry(
+		nwn2dev__in const ResRefT & ResRef,
+		nwn2dev__in ResType Type,
+		nwn2dev__in const std::string & LookupName,
+		nwn2dev__out ResourceEntry & Entry
+		);
+
+	//
+	// Return true if resource entry Entry1 takes precedence over Entry2.
+	//
+
+	inline
+	static
+	bool
+	IsResourceEntryPrecedent(
+		nwn2dev__in const ResourceEntry & Entry1,
+		nwn2dev__in const ResourceEntry & Entry2
+		)
+	{
+		if (Entry1.Tier != Entry2.Tier)
+			return Entry1.Tier < Entry2.Tier;
+
+		if (Entry1.TierIndex != Entry2.TierIndex)
+			return Entry1.TierIndex < Entry2.TierIndex;
+
+		return Entry1.FileIndex > Entry2.FileIndex;
+	}
+
+	//
+	// Look up a demand-loaded file by lookup name, and take a reference to it
+	// if it is present.  The routine returns true if a reference was taken.
+	//
+
+	bool
+	ReferenceDemandedFile(
+		nwn2dev__in const std::string & LookupName,
+		nwn2dev__out std::string & ResourceFileName
+		);
+
+	//
+	// Insert a newly demand-loaded file into the demand-loaded file table.
+	//
+
+	void
+	InsertDemandedFile(
+		nwn2dev__in const std::string & LookupName,
+		nwn2dev__in const DemandResourceRef & Ref
+		);
+
+	//
+	// Allocate a file handle and link it to a handle table entry.  The routine
+	// returns INVALID_FILE should there be no available file handles.
+	//
+
+	FileHandle
+	InsertFileHandle(
+		nwn2dev__in const ResHandle & HandleEntry
+		);
+
+	//
+	// Retrieve a copy of the handle table entry for a file handle.  The routine
+	// returns false if the file handle is not open.
+	//
+
+	bool
+	LookupFileHandle(
+		nwn2dev__in FileHandle File,
+		nwn2dev__out ResHandle & HandleEntry
+		);
+
 	//
 	// Text output writer, used to display debug warnings to the user, or to a
 	// log file.
@@ -1491,6 +1813,29 @@ private:
 
 	FileHandle                m_NextFileHandle;
 
+	//
+	// Locks guarding the handle table (and next free file handle), the
+	// demand-loaded file table and the 2DA cache, and the demand locks that
+	// serialize the loading of individual resources.
+	//
+
+	SRWLOCK                   m_FileHandleLock;
+	SRWLOCK                   m_NameMapLock;
+	SRWLOCK                   m_2DALock;
+	SRWLOCK                   m_DemandLocks[ DEMAND_LOCK_COUNT ];
+
+	//
+	// Resource I/O statistics.
+	//
+
+	ResourceStatistics        m_Statistics;
+
+	//
+	// Deduplication store for identical resource payloads.
+	//
+
+	ResourceDedupStore        m_DedupStore;
+
 	//
 	// Base resource data.
 	//
@@ -1569,6 +1914,14 @@ private:
 
 	ResourceEntryMap          m_NameIdMap;
 
+	//
+	// Mapping of resource names (+types) whose last copy was removed from a
+	// watched directory to their now unreferenced resource entry indicies, so
+	// that the entry is reused should the resource reappear.
+	//
+
+	ResourceEntryMap          m_VacantNameIdMap;
+
 	//
 	// Array of all loaded resource identifiers with their associated accessor
 	// objects.  Indicies into this array form ResourceManager FileIds.
@@ -0,0 +1,981 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ResourcePrefetcher.cpp
+
+Abstract:
+
+	This module houses the ResourcePrefetcher class implementation, which
+	reads batches of resources ahead of use on a pool of I/O threads.
+
+--*/
+
+#include "Precomp.h"
+#include "ResourcePrefetcher.h"
+#include "ParallelWorkQueue.h"
+
+ResourcePrefetcher::Request::Request(
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new, pending prefetch request.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The newly constructed object.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+: Type( NWN::ResINVALID ),
+  m_State( RequestPending ),
+  m_Priority( PriorityNormal ),
+  m_CancelRequested( false ),
+  m_CompletionEvent( NULL ),
+  m_Callback( NULL ),
+  m_CallbackContext( NULL )
+{
+	m_CompletionEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+	if (m_CompletionEvent == NULL)
+		throw std::runtime_error( "Failed to create prefetch completion event." );
+}
+
+ResourcePrefetcher::Request::~Request(
+	)
+/*++
+
+Routine Description:
+
+	This routine cleans up an already-existing prefetch request.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	CloseHandle( m_CompletionEvent );
+}
+
+ResourcePrefetcher::ResourcePrefetcher(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in ULONG ThreadCount /* = 0 */
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new ResourcePrefetcher object and starts its
+	I/O threads.
+
+Arguments:
+
+	ResMan - Supplies the resource manager that resources are read from.
+	         The resource manager must remain loaded for the lifetime of the
+	         prefetcher.
+
+	ThreadCount - Supplies the count of I/O threads to create, or zero to
+	              select a default.  Reads are largely I/O bound (or bound
+	              by decompression), so the default uses a small multiple of
+	              threads without tying up every processor.
+
+Return Value:
+
+	The newly constructed object.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+: m_ResourceManager( ResMan ),
+  m_PendingCount( 0 ),
+  m_NextSequence( 0 ),
+  m_Shutdown( false )
+{
+	if (ThreadCount == 0)
+	{
+		ThreadCount = ParallelWorkQueue::GetProcessorCount( );
+
+		if (ThreadCount < 2)
+			ThreadCount = 2;
+		else if (ThreadCount > 4)
+			ThreadCount = 4;
+	}
+
+	InitializeCriticalSection( &m_QueueLock );
+	InitializeConditionVariable( &m_QueueNotEmpty );
+
+	try
+	{
+		m_Threads.reserve( ThreadCount );
+
+		for (ULONG i = 0; i < ThreadCount; i += 1)
+		{
+			HANDLE Thread;
+
+			Thread = CreateThread(
+				NULL,
+				0,
+				IoThreadProc,
+				this,
+				0,
+				NULL);
+
+			if (Thread == NULL)
+				throw std::runtime_error( "Failed to create prefetch I/O thread." );
+
+			m_Threads.push_back( Thread );
+		}
+	}
+	catch (...)
+	{
+		EnterCriticalSection( &m_QueueLock );
+		m_Shutdown = true;
+		LeaveCriticalSection( &m_QueueLock );
+
+		WakeAllConditionVariable( &m_QueueNotEmpty );
+
+		for (HandleVec::iterator it = m_Threads.begin( );
+		     it != m_Threads.end( );
+		     ++it)
+		{
+			WaitForSingleObject( *it, INFINITE );
+			CloseHandle( *it );
+		}
+
+		DeleteCriticalSection( &m_QueueLock );
+		throw;
+	}
+}
+
+ResourcePrefetcher::~ResourcePrefetcher(
+	)
+/*++
+
+Routine Description:
+
+	This routine cancels all pending requests, stops the I/O threads (after
+	any in-progress reads complete) and then cleans up an already-existing
+	ResourcePrefetcher object.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	CancelAll( PriorityCritical );
+
+	EnterCriticalSection( &m_QueueLock );
+	m_Shutdown = true;
+	LeaveCriticalSection( &m_QueueLock );
+
+	WakeAllConditionVariable( &m_QueueNotEmpty );
+
+	for (HandleVec::iterator it = m_Threads.begin( );
+	     it != m_Threads.end( );
+	     ++it)
+	{
+		WaitForSingleObject( *it, INFINITE );
+		CloseHandle( *it );
+	}
+
+	DeleteCriticalSection( &m_QueueLock );
+}
+
+void
+ResourcePrefetcher::PrefetchBatch(
+	nwn2dev__in const ResourceKeyVec & Keys,
+	nwn2dev__in PREFETCH_PRIORITY Priority,
+	__in_opt CompletionRoutine Callback,
+	__in_opt void * CallbackContext,
+	nwn2dev__out RequestVec & Requests
+	)
+/*++
+
+Routine Description:
+
+	This routine submits a batch of resources for prefetch.  The requests are
+	all created before any is queued, so that a failure to create a request
+	leaves no part of the batch queued.
+
+Arguments:
+
+	Keys - Supplies the resources to prefetch.
+
+	Priority - Supplies the priority of the requests.
+
+	Callback - Optionally supplies a completion routine that is invoked on an
+	           I/O thread as each request's contents are read.
+
+	CallbackContext - Supplies the context argument for the callback.
+
+	Requests - Receives one request per resource key, appended in order.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	RequestVec Batch;
+	size_t     Queued;
+
+	if ((Priority < PriorityCritical) || (Priority >= LastPriority))
+		throw std::runtime_error( "Invalid prefetch priority." );
+
+	Batch.reserve( Keys.size( ) );
+	Requests.reserve( Requests.size( ) + Keys.size( ) );
+
+	for (ResourceKeyVec::const_iterator it = Keys.begin( );
+	     it != Keys.end( );
+	     ++it)
+	{
+		RequestPtr Req = new Request;
+
+		Req->ResRef            = it->ResRef;
+		Req->Type              = it->Type;
+		Req->m_Priority        = Priority;
+		Req->m_Callback        = Callback;
+		Req->m_CallbackContext = CallbackContext;
+
+		Batch.push_back( Req );
+	}
+
+	EnterCriticalSection( &m_QueueLock );
+
+	Queued = 0;
+
+	try
+	{
+		for (Queued = 0; Queued < Batch.size( ); Queued += 1)
+			EnqueueLocked( Batch[ Queued ] );
+	}
+	catch (...)
+	{
+		//
+		// Cancel whatever portion of the batch made it into the queue; the
+		// stale queue entries are discarded as they are dequeued.
+		//
+
+		for (size_t i = 0; i < Queued; i += 1)
+			FinishRequestLocked( *Batch[ i ], RequestCancelled );
+
+		LeaveCriticalSection( &m_QueueLock );
+		throw;
+	}
+
+	LeaveCriticalSection( &m_QueueLock );
+
+	if (Batch.size( ) > 1)
+		WakeAllConditionVariable( &m_QueueNotEmpty );
+	else
+		WakeConditionVariable( &m_QueueNotEmpty );
+
+	Requests.insert( Requests.end( ), Batch.begin( ), Batch.end( ) );
+}
+
+ResourcePrefetcher::RequestPtr
+ResourcePrefetcher::Prefetch(
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	nwn2dev__in ResType Type,
+	nwn2dev__in PREFETCH_PRIORITY Priority,
+	__in_opt CompletionRoutine Callback /* = NULL */,
+	__in_opt void * CallbackContext /* = NULL */
+	)
+/*++
+
+Routine Description:
+
+	This routine submits a single resource for prefetch.
+
+Arguments:
+
+	ResRef - Supplies the resource name.
+
+	Type - Supplies the resource type.
+
+	Priority - Supplies the priority of the request.
+
+	Callback - Optionally supplies a completion routine that is invoked on an
+	           I/O thread once the request's contents are read.
+
+	CallbackContext - Supplies the context argument for the callback.
+
+Return Value:
+
+	The request.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ResourceKeyVec Keys;
+	RequestVec     Requests;
+	ResourceKey    Key;
+
+	Key.ResRef = ResRef;
+	Key.Type   = Type;
+
+	Keys.push_back( Key );
+
+	PrefetchBatch( Keys, Priority, Callback, CallbackContext, Requests );
+
+	return Requests.front( );
+}
+
+bool
+ResourcePrefetcher::Cancel(
+	nwn2dev__in const RequestPtr & Req
+	)
+/*++
+
+Routine Description:
+
+	This routine cancels a request.  A pending request is finished as
+	cancelled immediately.  A request whose read is in progress is marked so
+	that its contents are discarded (and its callback skipped) when the read
+	completes.
+
+Arguments:
+
+	Req - Supplies the request to cancel.
+
+Return Value:
+
+	The routine returns true if the request will not complete successfully,
+	else false if the request had already finished.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	bool Cancelled;
+
+	EnterCriticalSection( &m_QueueLock );
+
+	switch (Req->m_State)
+	{
+
+	case RequestPending:
+		FinishRequestLocked( *Req, RequestCancelled );
+		Cancelled = true;
+		break;
+
+	case RequestRunning:
+		Req->m_CancelRequested = true;
+		Cancelled              = true;
+		break;
+
+	default:
+		Cancelled = false;
+		break;
+
+	}
+
+	LeaveCriticalSection( &m_QueueLock );
+
+	return Cancelled;
+}
+
+void
+ResourcePrefetcher::CancelAll(
+	nwn2dev__in PREFETCH_PRIORITY Priority /* = PrioritySpeculative */
+	)
+/*++
+
+Routine Description:
+
+	This routine cancels all pending requests whose priority is at or below
+	a given priority.  Requests whose reads are in progress are unaffected.
+
+	The queue is rebuilt without the cancelled requests (and without any
+	stale entries), which keeps a long-lived prefetcher from accumulating
+	dead queue entries.
+
+Arguments:
+
+	Priority - Supplies the most urgent priority to cancel.  Requests with
+	           this priority or a less urgent priority are cancelled.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	RequestQueue Survivors;
+
+	EnterCriticalSection( &m_QueueLock );
+
+	while (!m_Queue.empty( ))
+	{
+		QueueEntry Entry = m_Queue.top( );
+
+		m_Queue.pop( );
+
+		if ((Entry.Req->m_State != RequestPending) ||
+		    (Entry.Priority != Entry.Req->m_Priority))
+		{
+			continue;
+		}
+
+		if (Entry.Priority >= Priority)
+		{
+			FinishRequestLocked( *Entry.Req, RequestCancelled );
+			continue;
+		}
+
+		//
+		// Should the surviving entry not be able to be carried over, cancel
+		// its request rather than stranding any waiter.
+		//
+
+		try
+		{
+			Survivors.push( Entry );
+		}
+		catch (std::bad_alloc)
+		{
+			FinishRequestLocked( *Entry.Req, RequestCancelled );
+		}
+	}
+
+	m_Queue.swap( Survivors );
+
+	LeaveCriticalSection( &m_QueueLock );
+}
+
+void
+ResourcePrefetcher::Boost(
+	nwn2dev__in const RequestPtr & Req,
+	nwn2dev__in PREFETCH_PRIORITY Priority /* = PriorityCritical */
+	)
+/*++
+
+Routine Description:
+
+	This routine raises the priority of a pending request.  A new queue entry
+	is inserted at the new priority; the old entry is discarded when it is
+	eventually dequeued.
+
+Arguments:
+
+	Req - Supplies the request to boost.
+
+	Priority - Supplies the new priority of the request.
+
+Return Value:
+
+	None.  An std::exception is raised on failure, in which case the request
+	retains its original priority.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	PREFETCH_PRIORITY OldPriority;
+	bool              Boosted;
+
+	Boosted = false;
+
+	EnterCriticalSection( &m_QueueLock );
+
+	if ((Req->m_State == RequestPending) &&
+	    (Priority < Req->m_Priority))
+	{
+		OldPriority      = Req->m_Priority;
+		Req->m_Priority  = Priority;
+
+		try
+		{
+			EnqueueLocked( Req );
+		}
+		catch (...)
+		{
+			Req->m_Priority = OldPriority;
+
+			LeaveCriticalSection( &m_QueueLock );
+			throw;
+		}
+
+		//
+		// The request was already counted as pending when first queued.
+		//
+
+		m_PendingCount -= 1;
+		Boosted         = true;
+	}
+
+	LeaveCriticalSection( &m_QueueLock );
+
+	if (Boosted)
+		WakeConditionVariable( &m_QueueNotEmpty );
+}
+
+bool
+ResourcePrefetcher::Wait(
+	nwn2dev__in const RequestPtr & Req,
+	nwn2dev__in ULONG Timeout /* = INFINITE */
+	)
+/*++
+
+Routine Description:
+
+	This routine waits for a request to finish.
+
+Arguments:
+
+	Req - Supplies the request to wait for.
+
+	Timeout - Supplies the maximum time to wait, in milliseconds.
+
+Return Value:
+
+	The routine returns true if the request has finished, else false if the
+	timeout elapsed first.
+
+Environment:
+
+	User mode.  The routine must not be called from a completion callback,
+	as the I/O thread running the callback may be needed to service the
+	request being waited on.
+
+--*/
+{
+	return WaitForSingleObject( Req->m_CompletionEvent, Timeout ) == WAIT_OBJECT_0;
+}
+
+const std::vector< unsigned char > &
+ResourcePrefetcher::GetContents(
+	nwn2dev__in const RequestPtr & Req
+	)
+/*++
+
+Routine Description:
+
+	This routine waits for a request to finish, after boosting it to critical
+	priority (as the caller is now blocked on it), and returns its contents.
+
+Arguments:
+
+	Req - Supplies the request whose contents are to be returned.
+
+Return Value:
+
+	The contents of the resource.  An std::exception is raised if the request
+	failed or was cancelled.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	Boost( Req, PriorityCritical );
+	Wait( Req, INFINITE );
+
+	switch (Req->m_State)
+	{
+
+	case RequestCompleted:
+		return Req->Contents;
+
+	case RequestCancelled:
+		throw std::runtime_error( "Prefetch request was cancelled." );
+
+	default:
+		throw std::runtime_error( Req->ErrorText );
+
+	}
+}
+
+size_t
+ResourcePrefetcher::GetPendingCount(
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the count of requests that have not yet been
+	dequeued by an I/O thread.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The count of pending requests.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	size_t PendingCount;
+
+	EnterCriticalSection( &m_QueueLock );
+	PendingCount = m_PendingCount;
+	LeaveCriticalSection( &m_QueueLock );
+
+	return PendingCount;
+}
+
+DWORD
+WINAPI
+ResourcePrefetcher::IoThreadProc(
+	nwn2dev__in LPVOID Parameter
+	)
+/*++
+
+Routine Description:
+
+	This routine is the entry point of a prefetch I/O thread.  It services
+	requests in priority order until the prefetcher shuts down.
+
+Arguments:
+
+	Parameter - Supplies the prefetcher.
+
+Return Value:
+
+	Always zero.
+
+Environment:
+
+	User mode, I/O thread.
+
+--*/
+{
+	ResourcePrefetcher * This = (ResourcePrefetcher *) Parameter;
+	RequestPtr           Req;
+
+	while (This->DequeueRequest( Req ))
+	{
+		This->ServiceRequest( Req );
+
+		Req = RequestPtr( );
+	}
+
+	return 0;
+}
+
+void
+ResourcePrefetcher::EnqueueLocked(
+	nwn2dev__in const RequestPtr & Req
+	)
+/*++
+
+Routine Description:
+
+	This routine inserts a queue entry for a request at its current priority.
+
+Arguments:
+
+	Req - Supplies the request to queue.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode, queue lock held.
+
+--*/
+{
+	QueueEntry Entry;
+
+	Entry.Priority = Req->m_Priority;
+	Entry.Sequence = m_NextSequence++;
+	Entry.Req      = Req;
+
+	m_Queue.push( Entry );
+
+	m_PendingCount += 1;
+}
+
+bool
+ResourcePrefetcher::DequeueRequest(
+	nwn2dev__out RequestPtr & Req
+	)
+/*++
+
+Routine Description:
+
+	This routine dequeues the most urgent pending request, waiting for one to
+	be submitted if the queue is empty.  Stale queue entries (for requests
+	that were cancelled, or that were boosted and so have a newer entry) are
+	discarded.
+
+Arguments:
+
+	Req - Receives the dequeued request, which is marked as running.
+
+Return Value:
+
+	The routine returns true if a request was dequeued, else false if the
+	prefetcher is shutting down.
+
+Environment:
+
+	User mode, I/O thread.
+
+--*/
+{
+	EnterCriticalSection( &m_QueueLock );
+
+	for (;;)
+	{
+		if (m_Shutdown)
+		{
+			LeaveCriticalSection( &m_QueueLock );
+			return false;
+		}
+
+		if (m_Queue.empty( ))
+		{
+			SleepConditionVariableCS( &m_QueueNotEmpty, &m_QueueLock, INFINITE );
+			continue;
+		}
+
+		Req = m_Queue.top( ).Req;
+
+		if ((Req->m_State != RequestPending) ||
+		    (m_Queue.top( ).Priority != Req->m_Priority))
+		{
+			m_Queue.pop( );
+			continue;
+		}
+
+		m_Queue.pop( );
+
+		Req->m_State    = RequestRunning;
+		m_PendingCount -= 1;
+
+		LeaveCriticalSection( &m_QueueLock );
+		return true;
+	}
+}
+
+void
+ResourcePrefetcher::ServiceRequest(
+	nwn2dev__in const RequestPtr & Req
+	)
+/*++
+
+Routine Description:
+
+	This routine reads a dequeued request, invokes its completion callback,
+	and finishes the request.
+
+Arguments:
+
+	Req - Supplies the running request to service.
+
+Return Value:
+
+	None.  Failures are recorded in the request.
+
+Environment:
+
+	User mode, I/O thread.
+
+--*/
+{
+	REQUEST_STATE State;
+
+	try
+	{
+		ReadResource( *Req );
+
+		if ((Req->m_Callback != NULL) && (!Req->m_CancelRequested))
+			Req->m_Callback( Req->m_CallbackContext, *Req );
+
+		State = RequestCompleted;
+	}
+	catch (std::exception &e)
+	{
+		try
+		{
+			Req->ErrorText = e.what( );
+		}
+		catch (std::bad_alloc)
+		{
+		}
+
+		State = RequestFailed;
+	}
+
+	EnterCriticalSection( &m_QueueLock );
+
+	if (Req->m_CancelRequested)
+	{
+		std::vector< unsigned char >( ).swap( Req->Contents );
+
+		State = RequestCancelled;
+	}
+
+	FinishRequestLocked( *Req, State );
+
+	LeaveCriticalSection( &m_QueueLock );
+}
+
+void
+ResourcePrefetcher::ReadResource(
+	nwn2dev__in Request & Req
+	)
+/*++
+
+Routine Description:
+
+	This routine reads the full contents of a resource into a request.  The
+	resource accessor that serves the resource performs any decompression.
+
+Arguments:
+
+	Req - Supplies the request to read.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode, I/O thread.
+
+--*/
+{
+	FileHandle Handle;
+	size_t     FileSize;
+	size_t     Read;
+	char       ExMsg[ 96 ];
+
+	Handle = m_ResourceManager.OpenFile( Req.ResRef, Req.Type );
+
+	if (Handle == INVALID_FILE)
+	{
+		StringCbPrintfA(
+			ExMsg,
+			sizeof( ExMsg ),
+			"Failed to open resource %.32s (type %lu).",
+			Req.ResRef.RefStr,
+			(unsigned long) Req.Type);
+
+		throw std::runtime_error( ExMsg );
+	}
+
+	try
+	{
+		FileSize = m_ResourceManager.GetEncapsulatedFileSize( Handle );
+
+		Req.Contents.resize( FileSize );
+
+		if ((FileSize != 0) &&
+		    ((!m_ResourceManager.ReadEncapsulatedFile(
+				Handle,
+				0,
+				FileSize,
+				&Read,
+				&Req.Contents[ 0 ])) ||
+		     (Read != FileSize)))
+		{
+			StringCbPrintfA(
+				ExMsg,
+				sizeof( ExMsg ),
+				"Failed to read resource %.32s (type %lu).",
+				Req.ResRef.RefStr,
+				(unsigned long) Req.Type);
+
+			throw std::runtime_error( ExMsg );
+		}
+	}
+	catch (...)
+	{
+		m_ResourceManager.CloseFile( Handle );
+		throw;
+	}
+
+	m_ResourceManager.CloseFile( Handle );
+}
+
+void
+ResourcePrefetcher::FinishRequestLocked(
+	nwn2dev__in Request & Req,
+	nwn2dev__in REQUEST_STATE State
+	)
+/*++
+
+Routine Description:
+
+	This routine moves a request to a final state and releases any threads
+	waiting on it.
+
+Arguments:
+
+	Req - Supplies the request to finish.
+
+	State - Supplies the final state of the request.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode, queue lock held.
+
+--*/
+{
+	if (Req.m_State == RequestPending)
+		m_PendingCount -= 1;
+
+	Req.m_State = State;
+
+	SetEvent( Req.m_CompletionEvent );
+}
@@ -0,0 +1,371 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ResourcePrefetcher.h
+
+Abstract:
+
+	This module defines the ResourcePrefetcher class, which reads batches of
+	resources from a ResourceManager ahead of use on a pool of dedicated I/O
+	threads.
+
+	A batch of (ResRef, ResType) pairs is submitted at a priority, yielding
+	one request object per resource.  The caller may wait on a request (as a
+	future), or supply a completion callback that is invoked on the I/O
+	thread once the resource contents have been read (and, for compressed
+	archives, decompressed); the callback may parse the contents there.
+
+	Requests are dequeued in priority order, so critical resources that are
+	needed immediately overtake speculative prefetch that is already queued.
+	Pending requests may be cancelled or raised in priority at any time.  A
+	read that is already in progress is not interrupted; cancelling such a
+	request discards its contents once the read completes.
+
+	The prefetcher relies on the concurrency guarantees of the resource
+	manager, so the resource manager must not be loaded or unloaded while
+	the prefetcher exists.
+
+--*/
+
+#ifndef _PROGRAMS_NWN2DATALIB_RESOURCEPREFETCHER_H
+#define _PROGRAMS_NWN2DATALIB_RESOURCEPREFETCHER_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include "ResourceManager.h"
+
+class ResourcePrefetcher
+{
+
+public:
+
+	//
+	// Define request priorities, from most to least urgent.
+	//
+
+	typedef enum _PREFETCH_PRIORITY
+	{
+		PriorityCritical,
+		PriorityNormal,
+		PrioritySpeculative,
+
+		LastPriority
+	} PREFETCH_PRIORITY, * PPREFETCH_PRIORITY;
+
+	typedef enum _REQUEST_STATE
+	{
+		RequestPending,
+		RequestRunning,
+		RequestCompleted,
+		RequestFailed,
+		RequestCancelled,
+
+		LastRequestState
+	} REQUEST_STATE, * PREQUEST_STATE;
+
+	struct Request;
+
+	typedef swutil::SharedPtr< Request > RequestPtr;
+	typedef std::vector< RequestPtr > RequestVec;
+
+	//
+	// Define the completion callback, which is invoked on an I/O thread once
+	// the contents of a request have been read.  The callback may parse or
+	// otherwise consume Req->Contents; an std::exception raised by the
+	// callback fails the request.  The callback is not invoked for requests
+	// that fail to be read or that are cancelled.
+	//
+
+	typedef
+	void
+	(__stdcall * CompletionRoutine)(
+		__in_opt void * Context,
+		nwn2dev__in Request & Req
+		);
+
+	//
+	// Define a resource to prefetch.
+	//
+
+	struct ResourceKey
+	{
+		NWN::ResRef32 ResRef;
+		ResType       Type;
+	};
+
+	typedef std::vector< ResourceKey > ResourceKeyVec;
+
+	//
+	// Define a prefetch request.  The members other than the state are
+	// immutable while the request is pending or running; the contents and
+	// error text may be examined once the request has finished (that is,
+	// once Wait has returned true).
+	//
+
+	struct Request
+	{
+		Request(
+			);
+
+		~Request(
+			);
+
+		NWN::ResRef32                ResRef;
+		ResType                      Type;
+		std::vector< unsigned char > Contents;
+		std::string                  ErrorText;
+
+	private:
+
+		friend class ResourcePrefetcher;
+
+		volatile REQUEST_STATE       m_State;
+		PREFETCH_PRIORITY            m_Priority;
+		bool                         m_CancelRequested;
+		HANDLE                       m_CompletionEvent;
+		CompletionRoutine            m_Callback;
+		void                       * m_CallbackContext;
+
+	};
+
+	//
+	// Create a prefetcher with a given count of I/O threads.  A thread count
+	// of zero selects a default based on the processor count.
+	//
+
+	ResourcePrefetcher(
+		nwn2dev__in ResourceManager & ResMan,
+		nwn2dev__in ULONG ThreadCount = 0
+		);
+
+	//
+	// Cancel all pending requests, wait for in-progress reads to finish, and
+	// stop the I/O threads.
+	//
+
+	~ResourcePrefetcher(
+		);
+
+	//
+	// Submit a batch of resources for prefetch.  One request is returned
+	// (appended to Requests) per resource key, in order.
+	//
+
+	void
+	PrefetchBatch(
+		nwn2dev__in const ResourceKeyVec & Keys,
+		nwn2dev__in PREFETCH_PRIORITY Priority,
+		__in_opt CompletionRoutine Callback,
+		__in_opt void * CallbackContext,
+		nwn2dev__out RequestVec & Requests
+		);
+
+	//
+	// Submit a single resource for prefetch.
+	//
+
+	RequestPtr
+	Prefetch(
+		nwn2dev__in const NWN::ResRef32 & ResRef,
+		nwn2dev__in ResType Type,
+		nwn2dev__in PREFETCH_PRIORITY Priority,
+		__in_opt CompletionRoutine Callback = NULL,
+		__in_opt void * CallbackContext = NULL
+		);
+
+	//
+	// Cancel a request.  The routine returns true if the request will not
+	// complete successfully (it was pending or in progress), else false if
+	// the request had already finished.
+	//
+
+	bool
+	Cancel(
+		nwn2dev__in const RequestPtr & Req
+		);
+
+	//
+	// Cancel all pending requests at or below (less urgent than) a priority.
+	// This is used to drop stale speculative prefetch, for example when the
+	// player changes destination.
+	//
+
+	void
+	CancelAll(
+		nwn2dev__in PREFETCH_PRIORITY Priority = PrioritySpeculative
+		);
+
+	//
+	// Raise the priority of a pending request, typically because a
+	// speculatively prefetched resource has now become critical.  The
+	// routine has no effect if the request is not pending or already has an
+	// equal or higher priority.
+	//
+
+	void
+	Boost(
+		nwn2dev__in const RequestPtr & Req,
+		nwn2dev__in PREFETCH_PRIORITY Priority = PriorityCritical
+		);
+
+	//
+	// Wait for a request to finish.  The routine returns true if the request
+	// has finished (in any state), else false if the timeout elapsed.
+	//
+
+	bool
+	Wait(
+		nwn2dev__in const RequestPtr & Req,
+		nwn2dev__in ULONG Timeout = INFINITE
+		);
+
+	//
+	// Wait for a request to finish, raising its priority to critical first,
+	// and return its contents.  An std::exception is raised if the request
+	// failed or was cancelled.
+	//
+
+	const std::vector< unsigned char > &
+	GetContents(
+		nwn2dev__in const RequestPtr & Req
+		);
+
+	//
+	// Return the state of a request.
+	//
+
+	inline
+	static
+	REQUEST_STATE
+	GetState(
+		nwn2dev__in const RequestPtr & Req
+		)
+	{
+		return Req->m_State;
+	}
+
+	//
+	// Return the count of requests that have not yet been dequeued.
+	//
+
+	size_t
+	GetPendingCount(
+		);
+
+private:
+
+	//
+	// Define a queue entry.  A request may have several queue entries if it
+	// has been boosted; only the first entry to be dequeued while the request
+	// is pending is acted upon, and the remainder are discarded.
+	//
+
+	struct QueueEntry
+	{
+		PREFETCH_PRIORITY Priority;
+		ULONGLONG         Sequence;
+		RequestPtr        Req;
+
+		//
+		// The priority queue dequeues the greatest element first, so order
+		// less urgent priorities and later submissions as lesser.
+		//
+
+		inline
+		bool
+		operator < (
+			nwn2dev__in const QueueEntry & other
+			) const
+		{
+			if (Priority != other.Priority)
+				return Priority > other.Priority;
+
+			return Sequence > other.Sequence;
+		}
+	};
+
+	typedef std::priority_queue< QueueEntry > RequestQueue;
+	typedef std::vector< HANDLE > HandleVec;
+
+	static
+	DWORD
+	WINAPI
+	IoThreadProc(
+		nwn2dev__in LPVOID Parameter
+		);
+
+	//
+	// Queue an entry for a request.  The queue lock must be held.
+	//
+
+	void
+	EnqueueLocked(
+		nwn2dev__in const RequestPtr & Req
+		);
+
+	//
+	// Dequeue the next pending request, waiting for one to be submitted.
+	// The routine returns false if the prefetcher is shutting down.
+	//
+
+	bool
+	DequeueRequest(
+		nwn2dev__out RequestPtr & Req
+		);
+
+	//
+	// Read (and complete) a dequeued request.
+	//
+
+	void
+	ServiceRequest(
+		nwn2dev__in const RequestPtr & Req
+		);
+
+	//
+	// Read the contents of a resource.  An std::exception is raised on
+	// failure.
+	//
+
+	void
+	ReadResource(
+		nwn2dev__in Request & Req
+		);
+
+	//
+	// Move a request to a final state and release its waiters.  The queue
+	// lock must be held.
+	//
+
+	void
+	FinishRequestLocked(
+		nwn2dev__in Request & Req,
+		nwn2dev__in REQUEST_STATE State
+		);
+
+	ResourceManager    & m_ResourceManager;
+
+	//
+	// The queue lock guards the queue, the request states and the shutdown
+	// flag.  I/O threads wait on the queue condition for new requests.
+	//
+
+	CRITICAL_SECTION     m_QueueLock;
+	CONDITION_VARIABLE   m_QueueNotEmpty;
+	RequestQueue         m_Queue;
+	size_t               m_PendingCount;
+	ULONGLONG            m_NextSequence;
+	bool                 m_Shutdown;
+
+	HandleVec            m_Threads;
+
+};
+
+typedef ResourcePrefetcher::RequestPtr PrefetchRequestPtr;
+
+#endif
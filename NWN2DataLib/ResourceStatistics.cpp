@@ -0,0 +1,639 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ResourceStatistics.cpp
+
+Abstract:
+
+	This module houses the ResourceStatistics class, which collects resource
+	I/O counters, latency histograms and trace events.
+
+--*/
+
+#include "Precomp.h"
+#include "ResourceStatistics.h"
+#include "TextOut.h"
+
+ResourceStatistics::ResourceStatistics(
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new ResourceStatistics object.  Collection is
+	initially disabled.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The newly constructed object.
+
+Environment:
+
+	User mode.
+
+--*/
+: m_Enabled( false ),
+  m_TraceEnabled( false ),
+  m_Frequency( 1 ),
+  m_BaseTime( 0 ),
+  m_DroppedEvents( 0 )
+{
+	LARGE_INTEGER Frequency;
+
+	if ((QueryPerformanceFrequency( &Frequency )) && (Frequency.QuadPart != 0))
+		m_Frequency = (ULONGLONG) Frequency.QuadPart;
+
+	ZeroMemory( (void *) m_Counters, sizeof( m_Counters ) );
+
+	m_BaseTime = GetTimestamp( );
+
+	InitializeCriticalSection( &m_TraceLock );
+}
+
+ResourceStatistics::~ResourceStatistics(
+	)
+/*++
+
+Routine Description:
+
+	This routine cleans up an already-existing ResourceStatistics object.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	DeleteCriticalSection( &m_TraceLock );
+}
+
+void
+ResourceStatistics::RecordOperation(
+	nwn2dev__in STAT_SOURCE Source,
+	nwn2dev__in STAT_OPERATION Operation,
+	nwn2dev__in ULONGLONG StartTime,
+	nwn2dev__in ULONGLONG Bytes,
+	__in_opt const char * Detail /* = NULL */
+	)
+/*++
+
+Routine Description:
+
+	This routine records a completed operation against the counters of its
+	source, and appends a trace event for it if tracing is enabled.
+
+Arguments:
+
+	Source - Supplies the source that the operation is attributed to.
+
+	Operation - Supplies the operation type.
+
+	StartTime - Supplies the time at which the operation started, as returned
+	            by GetTimestamp, or zero if the operation is not timed.
+
+	Bytes - Supplies the count of bytes that the operation transferred.
+
+	Detail - Optionally supplies a description of the operation (typically
+	         the resource name) for the trace event log.
+
+Return Value:
+
+	None.  A trace event that cannot be recorded is counted as dropped, so
+	that instrumented callers need not handle failures.
+
+Environment:
+
+	User mode, any thread.
+
+--*/
+{
+	Counters  * Stats;
+	ULONGLONG   Now;
+	ULONGLONG   Duration;
+	LONGLONG    Max;
+	ULONG       Bucket;
+
+	if ((!m_Enabled) ||
+	    ((ULONG) Source >= LastStatSource) ||
+	    ((ULONG) Operation >= LastStatOperation))
+	{
+		return;
+	}
+
+	Stats = &m_Counters[ Source ][ Operation ];
+
+	InterlockedIncrement64( &Stats->Count );
+
+	if (Bytes != 0)
+		InterlockedExchangeAdd64( &Stats->Bytes, (LONGLONG) Bytes );
+
+	if (StartTime == 0)
+		return;
+
+	Now      = GetTimestamp( );
+	Duration = TicksToMicroseconds( Now - StartTime );
+
+	InterlockedExchangeAdd64( &Stats->TotalTime, (LONGLONG) Duration );
+
+	Max = Stats->MaxTime;
+
+	while ((LONGLONG) Duration > Max)
+	{
+		LONGLONG Prev;
+
+		Prev = InterlockedCompareExchange64(
+			&Stats->MaxTime,
+			(LONGLONG) Duration,
+			Max);
+
+		if (Prev == Max)
+			break;
+
+		Max = Prev;
+	}
+
+	Bucket = 0;
+
+	while ((Bucket < HISTOGRAM_BUCKETS - 1) && (Duration >= (1ULL << Bucket)))
+		Bucket += 1;
+
+	InterlockedIncrement64( &Stats->Histogram[ Bucket ] );
+
+	if (!m_TraceEnabled)
+		return;
+
+	//
+	// Append a trace event.  The event is built outside of the trace lock.
+	//
+
+	TraceEvent Event;
+
+	try
+	{
+		if (Detail != NULL)
+			Event.Detail = Detail;
+	}
+	catch (std::exception)
+	{
+	}
+
+	Event.Source    = Source;
+	Event.Operation = Operation;
+	Event.ThreadId  = GetCurrentThreadId( );
+	Event.StartTime = (StartTime > m_BaseTime) ? TicksToMicroseconds( StartTime - m_BaseTime ) : 0;
+	Event.Duration  = Duration;
+	Event.Bytes     = Bytes;
+
+	EnterCriticalSection( &m_TraceLock );
+
+	try
+	{
+		if (m_TraceEvents.size( ) < MAX_TRACE_EVENTS)
+			m_TraceEvents.push_back( Event );
+		else
+			m_DroppedEvents += 1;
+	}
+	catch (std::exception)
+	{
+		m_DroppedEvents += 1;
+	}
+
+	LeaveCriticalSection( &m_TraceLock );
+}
+
+void
+ResourceStatistics::GetCounters(
+	nwn2dev__in STAT_SOURCE Source,
+	nwn2dev__in STAT_OPERATION Operation,
+	nwn2dev__out OperationCounters & Counters
+	) const
+/*++
+
+Routine Description:
+
+	This routine returns a snapshot of the counters of a source and
+	operation.  The counters are read individually, so a snapshot taken
+	while operations are being recorded may be slightly inconsistent.
+
+Arguments:
+
+	Source - Supplies the source to query.
+
+	Operation - Supplies the operation type to query.
+
+	Counters - Receives the counters.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode, any thread.
+
+--*/
+{
+	const ResourceStatistics::Counters * Stats;
+
+	ZeroMemory( &Counters, sizeof( Counters ) );
+
+	if (((ULONG) Source >= LastStatSource) ||
+	    ((ULONG) Operation >= LastStatOperation))
+	{
+		return;
+	}
+
+	Stats = &m_Counters[ Source ][ Operation ];
+
+	Counters.Count     = (ULONGLONG) Stats->Count;
+	Counters.Bytes     = (ULONGLONG) Stats->Bytes;
+	Counters.TotalTime = (ULONGLONG) Stats->TotalTime;
+	Counters.MaxTime   = (ULONGLONG) Stats->MaxTime;
+
+	for (ULONG i = 0; i < HISTOGRAM_BUCKETS; i += 1)
+		Counters.Histogram[ i ] = (ULONGLONG) Stats->Histogram[ i ];
+}
+
+void
+ResourceStatistics::GetTraceEvents(
+	nwn2dev__out TraceEventVec & Events,
+	nwn2dev__out ULONGLONG & DroppedEvents
+	) const
+/*++
+
+Routine Description:
+
+	This routine returns a copy of the trace event log.
+
+Arguments:
+
+	Events - Receives the trace events, in the order that they were
+	         recorded (which is the order in which the operations completed).
+
+	DroppedEvents - Receives the count of trace events that were not
+	                recorded because the trace event log was full.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode, any thread.
+
+--*/
+{
+	EnterCriticalSection( &m_TraceLock );
+
+	try
+	{
+		Events        = m_TraceEvents;
+		DroppedEvents = m_DroppedEvents;
+	}
+	catch (...)
+	{
+		LeaveCriticalSection( &m_TraceLock );
+		throw;
+	}
+
+	LeaveCriticalSection( &m_TraceLock );
+}
+
+void
+ResourceStatistics::Reset(
+	)
+/*++
+
+Routine Description:
+
+	This routine resets all counters and discards the trace event log.
+	Trace event times are subsequently measured from the time of the reset.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.  No operations may be recorded concurrently.
+
+--*/
+{
+	ZeroMemory( (void *) m_Counters, sizeof( m_Counters ) );
+
+	EnterCriticalSection( &m_TraceLock );
+
+	m_TraceEvents.clear( );
+	m_DroppedEvents = 0;
+	m_BaseTime      = GetTimestamp( );
+
+	LeaveCriticalSection( &m_TraceLock );
+}
+
+void
+ResourceStatistics::WriteReport(
+	nwn2dev__in IDebugTextOut * TextOut
+	) const
+/*++
+
+Routine Description:
+
+	This routine writes a summary of all non-zero counters to a text output
+	interface.  Latency percentiles are reported as the upper bound of the
+	histogram bucket that contains them.
+
+Arguments:
+
+	TextOut - Supplies the text output interface to write to.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode, any thread.
+
+--*/
+{
+	OperationCounters Counters;
+
+	TextOut->WriteText(
+		"%-18s %-16s %10s %14s %10s %10s %10s %10s\n",
+		"Source",
+		"Operation",
+		"Count",
+		"Bytes",
+		"Avg(us)",
+		"p50(us)",
+		"p99(us)",
+		"Max(us)");
+
+	for (ULONG Source = 0; Source < LastStatSource; Source += 1)
+	{
+		for (ULONG Operation = 0; Operation < LastStatOperation; Operation += 1)
+		{
+			ULONGLONG Timed;
+			ULONGLONG Seen;
+			ULONGLONG P50;
+			ULONGLONG P99;
+
+			GetCounters(
+				(STAT_SOURCE) Source,
+				(STAT_OPERATION) Operation,
+				Counters);
+
+			if (Counters.Count == 0)
+				continue;
+
+			//
+			// Derive the percentiles from the histogram.  Untimed operations
+			// have no histogram entries.
+			//
+
+			Timed = 0;
+
+			for (ULONG i = 0; i < HISTOGRAM_BUCKETS; i += 1)
+				Timed += Counters.Histogram[ i ];
+
+			Seen = 0;
+			P50  = 0;
+			P99  = 0;
+
+			for (ULONG i = 0; i < HISTOGRAM_BUCKETS; i += 1)
+			{
+				Seen += Counters.Histogram[ i ];
+
+				if ((P50 == 0) && (Seen * 100 >= Timed * 50) && (Seen != 0))
+					P50 = 1ULL << i;
+
+				if ((P99 == 0) && (Seen * 100 >= Timed * 99) && (Seen != 0))
+					P99 = 1ULL << i;
+			}
+
+			TextOut->WriteText(
+				"%-18s %-16s %10I64u %14I64u %10I64u %10I64u %10I64u %10I64u\n",
+				GetSourceName( (STAT_SOURCE) Source ),
+				GetOperationName( (STAT_OPERATION) Operation ),
+				Counters.Count,
+				Counters.Bytes,
+				(Timed != 0) ? Counters.TotalTime / Timed : 0,
+				P50,
+				P99,
+				Counters.MaxTime);
+		}
+	}
+}
+
+void
+ResourceStatistics::WriteChromeTrace(
+	nwn2dev__in const std::string & FileName
+	) const
+/*++
+
+Routine Description:
+
+	This routine writes the trace event log to a file, in the JSON object
+	form of the Chrome trace event format.  Each operation is written as a
+	complete ("X") event named for the operation, categorized by its source,
+	and carrying the byte count and resource name as arguments.
+
+Arguments:
+
+	FileName - Supplies the name of the file to create.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode, any thread.
+
+--*/
+{
+	TraceEventVec Events;
+	ULONGLONG     DroppedEvents;
+	FILE        * f;
+	DWORD         ProcessId;
+
+	GetTraceEvents( Events, DroppedEvents );
+
+	f = fopen( FileName.c_str( ), "wt" );
+
+	if (f == NULL)
+		throw std::runtime_error( "Failed to create trace file." );
+
+	ProcessId = GetCurrentProcessId( );
+
+	fprintf( f, "{\"traceEvents\":[\n" );
+
+	for (TraceEventVec::const_iterator it = Events.begin( );
+	     it != Events.end( );
+	     ++it)
+	{
+		std::string Detail;
+
+		//
+		// Escape the resource name as a JSON string.
+		//
+
+		for (std::string::const_iterator c = it->Detail.begin( );
+		     c != it->Detail.end( );
+		     ++c)
+		{
+			if ((*c == '"') || (*c == '\\'))
+			{
+				Detail.push_back( '\\' );
+				Detail.push_back( *c );
+			}
+			else if ((unsigned char) *c < 0x20)
+			{
+				char Escape[ 8 ];
+
+				StringCbPrintfA(
+					Escape,
+					sizeof( Escape ),
+					"\\u%04x",
+					(unsigned char) *c);
+
+				Detail += Escape;
+			}
+			else
+			{
+				Detail.push_back( *c );
+			}
+		}
+
+		fprintf(
+			f,
+			"%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%I64u,"
+			"\"dur\":%I64u,\"pid\":%lu,\"tid\":%lu,"
+			"\"args\":{\"bytes\":%I64u,\"resource\":\"%s\"}}\n",
+			(it == Events.begin( )) ? "" : ",",
+			GetOperationName( it->Operation ),
+			GetSourceName( it->Source ),
+			it->StartTime,
+			it->Duration,
+			ProcessId,
+			it->ThreadId,
+			it->Bytes,
+			Detail.c_str( ));
+	}
+
+	fprintf(
+		f,
+		"],\n\"otherData\":{\"droppedEvents\":%I64u}}\n",
+		DroppedEvents);
+
+	if (ferror( f ))
+	{
+		fclose( f );
+		throw std::runtime_error( "Failed to write trace file." );
+	}
+
+	fclose( f );
+}
+
+const char *
+ResourceStatistics::GetSourceName(
+	nwn2dev__in STAT_SOURCE Source
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the display name of a statistics source.
+
+Arguments:
+
+	Source - Supplies the source.
+
+Return Value:
+
+	The routine returns the name of the source.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	static const char * SourceNames[ LastStatSource ] =
+	{
+		"CustomFirst",
+		"Encapsulated",
+		"Encapsulated16",
+		"Directory",
+		"InboxZip",
+		"InboxKey",
+		"CustomLast",
+		"ResourceManager"
+	};
+
+	if ((ULONG) Source >= LastStatSource)
+		return "Unknown";
+
+	return SourceNames[ Source ];
+}
+
+const char *
+ResourceStatistics::GetOperationName(
+	nwn2dev__in STAT_OPERATION Operation
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the display name of a statistics operation.
+
+Arguments:
+
+	Operation - Supplies the operation type.
+
+Return Value:
+
+	The routine returns the name of the operation.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	static const char * OperationNames[ LastStatOperation ] =
+	{
+		"Open",
+		"Read",
+		"Demand",
+		"DemandCacheHit",
+		"TempFileSpill",
+		"Inflate",
+		"2DACacheHit",
+		"2DALoad"
+	};
+
+	if ((ULONG) Operation >= LastStatOperation)
+		return "Unknown";
+
+	return OperationNames[ Operation ];
+}
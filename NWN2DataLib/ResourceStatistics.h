@@ -0,0 +1,443 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	ResourceStatistics.h
+
+Abstract:
+
+	This module defines the ResourceStatistics class, which collects resource
+	I/O statistics on behalf of the resource manager and its resource
+	accessors.
+
+	Operations (opens, reads, demand loads, temporary file spills, inflates,
+	2DA cache lookups) are counted per source, where a source is a resource
+	manager tier.  For each source and operation, the count of operations,
+	the count of bytes transferred, the total and maximum latency, and a
+	latency histogram with power of two microsecond buckets are maintained.
+	Counters are updated with interlocked operations, so collection takes no
+	lock, and costs only a flag test when disabled.
+
+	Optionally, each operation may also be recorded as an individual trace
+	event.  The trace event log may be queried, or written out in the Chrome
+	trace event format (for chrome://tracing or compatible viewers).
+
+--*/
+
+#ifndef _PROGRAMS_NWN2DATALIB_RESOURCESTATISTICS_H
+#define _PROGRAMS_NWN2DATALIB_RESOURCESTATISTICS_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+struct IDebugTextOut;
+
+class ResourceStatistics
+{
+
+public:
+
+	//
+	// Define the sources that statistics are attributed to.  The tier
+	// sources match the resource manager's tier ordinals.
+	//
+
+	typedef enum _STAT_SOURCE
+	{
+		SourceCustomFirst     = 0,
+		SourceEncapsulated    = 1,
+		SourceEncapsulated16  = 2,
+		SourceDirectory       = 3,
+		SourceInbox           = 4,
+		SourceInboxKey        = 5,
+		SourceCustomLast      = 6,
+
+		//
+		// Operations that are not attributed to a tier, such as 2DA cache
+		// lookups.
+		//
+
+		SourceResourceManager = 7,
+
+		LastStatSource
+	} STAT_SOURCE, * PSTAT_SOURCE;
+
+	typedef enum _STAT_OPERATION
+	{
+		OpOpen,                // Open of a resource by name
+		OpRead,                // Read from an encapsulated file
+		OpDemand,              // Demand load that located a resource
+		OpDemandCacheHit,      // Demand satisfied by the demanded file table
+		OpTempFileSpill,       // Copy of a resource to a temporary file
+		OpInflate,             // Decompression of a zip archive member
+		Op2DACacheHit,         // 2DA served from the 2DA cache
+		Op2DALoad,             // 2DA loaded and parsed on a cache miss
+
+		LastStatOperation
+	} STAT_OPERATION, * PSTAT_OPERATION;
+
+	enum
+	{
+		//
+		// Latency histogram bucket N counts operations that took less than
+		// 2^N microseconds (and at least 2^(N-1) microseconds).  The last
+		// bucket also counts all longer operations.
+		//
+
+		HISTOGRAM_BUCKETS = 24,
+
+		//
+		// Maximum count of trace events retained.  Events past the limit are
+		// counted as dropped.
+		//
+
+		MAX_TRACE_EVENTS  = 1024 * 1024
+	};
+
+	//
+	// Define a snapshot of the counters of one source and operation.  Times
+	// are in microseconds.
+	//
+
+	struct OperationCounters
+	{
+		ULONGLONG Count;
+		ULONGLONG Bytes;
+		ULONGLONG TotalTime;
+		ULONGLONG MaxTime;
+		ULONGLONG Histogram[ HISTOGRAM_BUCKETS ];
+	};
+
+	//
+	// Define a trace event.  Times are in microseconds since the statistics
+	// were created (or last reset).
+	//
+
+	struct TraceEvent
+	{
+		STAT_SOURCE    Source;
+		STAT_OPERATION Operation;
+		ULONG          ThreadId;
+		ULONGLONG      StartTime;
+		ULONGLONG      Duration;
+		ULONGLONG      Bytes;
+		std::string    Detail;
+	};
+
+	typedef std::vector< TraceEvent > TraceEventVec;
+
+	ResourceStatistics(
+		);
+
+	~ResourceStatistics(
+		);
+
+	//
+	// Enable or disable statistics collection.  Collection is disabled by
+	// default.
+	//
+
+	inline
+	void
+	SetEnabled(
+		nwn2dev__in bool Enabled
+		)
+	{
+		m_Enabled = Enabled;
+	}
+
+	inline
+	bool
+	IsEnabled(
+		) const
+	{
+		return m_Enabled;
+	}
+
+	//
+	// Enable or disable trace event recording.  Trace events are only
+	// recorded while statistics collection is also enabled.
+	//
+
+	inline
+	void
+	SetTraceEnabled(
+		nwn2dev__in bool Enabled
+		)
+	{
+		m_TraceEnabled = Enabled;
+	}
+
+	inline
+	bool
+	IsTraceEnabled(
+		) const
+	{
+		return m_TraceEnabled;
+	}
+
+	//
+	// Return the current time, for use as an operation start time with
+	// RecordOperation.
+	//
+
+	inline
+	static
+	ULONGLONG
+	GetTimestamp(
+		)
+	{
+		LARGE_INTEGER Now;
+
+		QueryPerformanceCounter( &Now );
+
+		return (ULONGLONG) Now.QuadPart;
+	}
+
+	//
+	// Record a completed operation.  StartTime is a value returned by
+	// GetTimestamp when the operation began, or zero for operations that are
+	// counted without timing.  Detail optionally names the resource for the
+	// trace event log.  The routine does not raise exceptions.
+	//
+
+	void
+	RecordOperation(
+		nwn2dev__in STAT_SOURCE Source,
+		nwn2dev__in STAT_OPERATION Operation,
+		nwn2dev__in ULONGLONG StartTime,
+		nwn2dev__in ULONGLONG Bytes,
+		__in_opt const char * Detail = NULL
+		);
+
+	//
+	// Return a snapshot of the counters of a source and operation.
+	//
+
+	void
+	GetCounters(
+		nwn2dev__in STAT_SOURCE Source,
+		nwn2dev__in STAT_OPERATION Operation,
+		nwn2dev__out OperationCounters & Counters
+		) const;
+
+	//
+	// Return a copy of the trace event log, and the count of events that
+	// were dropped because the log was full.
+	//
+
+	void
+	GetTraceEvents(
+		nwn2dev__out TraceEventVec & Events,
+		nwn2dev__out ULONGLONG & DroppedEvents
+		) const;
+
+	//
+	// Reset all counters and discard the trace event log.  The routine must
+	// not be called concurrently with operations being recorded.
+	//
+
+	void
+	Reset(
+		);
+
+	//
+	// Write a summary of all non-zero counters, including latency
+	// percentiles, to a text output interface.
+	//
+
+	void
+	WriteReport(
+		nwn2dev__in IDebugTextOut * TextOut
+		) const;
+
+	//
+	// Write the trace event log to a file in the Chrome trace event format.
+	// An std::exception is raised on failure.
+	//
+
+	void
+	WriteChromeTrace(
+		nwn2dev__in const std::string & FileName
+		) const;
+
+	static
+	const char *
+	GetSourceName(
+		nwn2dev__in STAT_SOURCE Source
+		);
+
+	static
+	const char *
+	GetOperationName(
+		nwn2dev__in STAT_OPERATION Operation
+		);
+
+	//
+	// Define a scoped operation, which times itself from construction to
+	// destruction and is then recorded.  No time is taken if statistics
+	// collection is disabled (or no statistics object is supplied).
+	//
+
+	class ScopedOperation
+	{
+
+	public:
+
+		inline
+		ScopedOperation(
+			__in_opt ResourceStatistics * Statistics,
+			nwn2dev__in STAT_SOURCE Source,
+			nwn2dev__in STAT_OPERATION Operation,
+			__in_opt const char * Detail = NULL
+			)
+		: m_Statistics( NULL ),
+		  m_Source( Source ),
+		  m_Operation( Operation ),
+		  m_Detail( Detail ),
+		  m_StartTime( 0 ),
+		  m_Bytes( 0 )
+		{
+			if ((Statistics != NULL) && (Statistics->IsEnabled( )))
+			{
+				m_Statistics = Statistics;
+				m_StartTime  = GetTimestamp( );
+			}
+		}
+
+		inline
+		~ScopedOperation(
+			)
+		{
+			if (m_Statistics == NULL)
+				return;
+
+			m_Statistics->RecordOperation(
+				m_Source,
+				m_Operation,
+				m_StartTime,
+				m_Bytes,
+				m_Detail);
+		}
+
+		inline
+		void
+		SetBytes(
+			nwn2dev__in ULONGLONG Bytes
+			)
+		{
+			m_Bytes = Bytes;
+		}
+
+		//
+		// Abandon the operation, for example because it failed, so that it
+		// is not recorded.
+		//
+
+		inline
+		void
+		Cancel(
+			)
+		{
+			m_Statistics = NULL;
+		}
+
+	private:
+
+		ResourceStatistics * m_Statistics;
+		STAT_SOURCE          m_Source;
+		STAT_OPERATION       m_Operation;
+		const char         * m_Detail;
+		ULONGLONG            m_StartTime;
+		ULONGLONG            m_Bytes;
+
+	};
+
+private:
+
+	struct Counters
+	{
+		volatile LONGLONG Count;
+		volatile LONGLONG Bytes;
+		volatile LONGLONG TotalTime;
+		volatile LONGLONG MaxTime;
+		volatile LONGLONG Histogram[ HISTOGRAM_BUCKETS ];
+	};
+
+	//
+	// Convert a performance counter interval to microseconds.
+	//
+
+	inline
+	ULONGLONG
+	TicksToMicroseconds(
+		nwn2dev__in ULONGLONG Ticks
+		) const
+	{
+		return (Ticks / m_Frequency) * 1000000 +
+		       ((Ticks % m_Frequency) * 1000000) / m_Frequency;
+	}
+
+	volatile bool            m_Enabled;
+	volatile bool            m_TraceEnabled;
+	ULONGLONG                m_Frequency;
+	ULONGLONG                m_BaseTime;
+
+	Counters                 m_Counters[ LastStatSource ][ LastStatOperation ];
+
+	//
+	// The trace lock guards the trace event log.
+	//
+
+	mutable CRITICAL_SECTION m_TraceLock;
+	TraceEventVec            m_TraceEvents;
+	ULONGLONG                m_DroppedEvents;
+
+};
+
+//
+// Define the mixin through which resource accessors report statistics.  The
+// resource manager attaches its statistics to each accessor that it creates,
+// along with the tier that the accessor was loaded into.
+//
+
+class ResourceStatisticsClient
+{
+
+public:
+
+	inline
+	ResourceStatisticsClient(
+		)
+	: m_Statistics( NULL ),
+	  m_StatSource( ResourceStatistics::SourceResourceManager )
+	{
+	}
+
+	//
+	// Attach a statistics object (or NULL to detach), and the source that
+	// this accessor's operations are attributed to.
+	//
+
+	inline
+	void
+	SetStatistics(
+		__in_opt ResourceStatistics * Statistics,
+		nwn2dev__in ResourceStatistics::STAT_SOURCE Source
+		)
+	{
+		m_Statistics = Statistics;
+		m_StatSource = Source;
+	}
+
+protected:
+
+	ResourceStatistics              * m_Statistics;
+	ResourceStatistics::STAT_SOURCE   m_StatSource;
+
+};
+
+#endif
@@ -77,7 +77,7 @@ extern const SimpleMeshTypeDescriptor SMTD_RigidMesh;
 // Define the rigid mesh core itself.
 //
 
-class RigidMesh : public SimpleMesh< RMVertex, RMFace, &SMTD_RigidMesh >
+class RigidMesh : public SimpleMesh< RMVertex, RMFace, &SMTD_RigidMesh, CoordTransModeLocal, 1, unsigned long, unsigned long, SimpleMeshStreamStorage< RMVertex > >
 {
 
 public:
@@ -89,7 +89,7 @@ public:
 
 	typedef unsigned long FaceVertexIndex; // Must match RMFace::Corners
 
-	typedef SimpleMesh< Vertex, Face, &SMTD_RigidMesh > BaseMesh;
+	typedef SimpleMesh< Vertex, Face, &SMTD_RigidMesh, CoordTransModeLocal, 1, unsigned long, unsigned long, SimpleMeshStreamStorage< Vertex > > BaseMesh;
 
 #include <pshpack1.h>
 
@@ -110,7 +110,7 @@ public:
 	inline
 	RigidMesh(
 		)
-	: SimpleMesh< RMVertex, RMFace, &SMTD_RigidMesh >( )
+	: SimpleMesh< RMVertex, RMFace, &SMTD_RigidMesh, CoordTransModeLocal, 1, unsigned long, unsigned long, SimpleMeshStreamStorage< RMVertex > >( )
 	{
 		ZeroMemory( &m_Header, sizeof( m_Header ) );
 	}
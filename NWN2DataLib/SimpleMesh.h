@@ -21,6 +21,7 @@ Abstract:
 #endif
 
 #include "MeshLinkage.h"
+#include "SimpleMeshStorage.h"
 
 class MeshManager;
 
@@ -56,6 +57,11 @@ enum CoordTransMode
 // Derived classes should include a 'BaseMesh' type that refers back to the
 // base template class with the template parameters used.
 //
+// Verticies are held by a storage policy (see SimpleMeshStorage.h).  By
+// default, verticies are stored interleaved as an array of vertex structures;
+// meshes whose position-only passes dominate may instead select stream
+// storage, in which case GetPoint returns a vertex by value.
+//
 
 template<
 	typename VertexT,                           // In-memory vertex type
@@ -64,15 +70,16 @@ template<
 	CoordTransMode TMode = CoordTransModeLocal, // Coordinates stored in local form?
 	size_t   NumWeights  = 1,                   // Number of vertex weights
 	typename PointIndexT = unsigned long,       // In-memory vertex index type
-	typename FaceIndexT  = unsigned long >      // In-memory face index type
+	typename FaceIndexT  = unsigned long,       // In-memory face index type
+	typename StorageT    = SimpleMeshInterleavedStorage< VertexT > > // Vertex storage policy
 class SimpleMesh
 {
 
 public:
 
-	typedef SimpleMesh< VertexT, FaceT, MeshType, TMode, NumWeights, PointIndexT, FaceIndexT > SimpleMeshT;
+	typedef SimpleMesh< VertexT, FaceT, MeshType, TMode, NumWeights, PointIndexT, FaceIndexT, StorageT > SimpleMeshT;
 
-	typedef std::vector< VertexT > VertexVec;
+	typedef StorageT VertexVec;
 	typedef std::vector< FaceT > FaceVec;
 
 	typedef PointIndexT PointIndex;
@@ -136,7 +143,7 @@ public:
 	}
 
 	inline
-	const VertexT &
+	typename VertexVec::const_reference
 	GetPoint(
 		nwn2dev__in PointIndexT PointId
 		) const
@@ -156,14 +163,7 @@ public:
 		nwn2dev__in PointIndexT PointId
 		) const
 	{
-		const VertexT & Point( GetPoint( PointId ) );
-		NWN::Vector3    v;
-
-		v.x = Point.LocalPos.x;
-		v.y = Point.LocalPos.y;
-		v.z = Point.LocalPos.z;
-
-		return v;
+		return m_Points.GetVector( offsetof( VertexT, LocalPos ), PointId );
 	}
 
 	//
@@ -177,14 +177,7 @@ public:
 		nwn2dev__in PointIndexT PointId
 		) const
 	{
-		const VertexT & Point( GetPoint( PointId ) );
-		NWN::Vector3    v;
-
-		v.x = Point.LocalPos.x;
-		v.y = Point.LocalPos.y;
-		v.z = Point.LocalPos.z;
-
-		return v;
+		return m_Points.GetVector( offsetof( VertexT, LocalPos ), PointId );
 	}
 
 	//
@@ -0,0 +1,455 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	SimpleMeshStorage.h
+
+Abstract:
+
+	This module defines the vertex storage policies for the SimpleMesh class.
+
+	The interleaved policy (the default) stores an array of vertex structures,
+	which suits meshes whose vertices are consumed a whole vertex at a time.
+
+	The stream policy stores each member of the vertex structure in its own
+	contiguous stream (structure of arrays).  Passes that touch only vertex
+	positions, such as world transformation, bounding box computation and BVH
+	construction, then walk a dense array of positions instead of striding
+	across normals, tangents and texture coordinates.
+
+	Both policies expose the vertex members as strided Vector3 arrays (via
+	GetVectorStream), so that batch math routines may run directly against
+	either layout.
+
+	Streams are 16 byte aligned and allocated in multiples of four vertices,
+	so that the packed batch math routines (e.g. Math::MultiplyPointsPacked)
+	may process four positions per step with aligned SSE loads and stores.
+
+--*/
+
+#ifndef _PROGRAMS_NWN2DATALIB_SIMPLEMESHSTORAGE_H
+#define _PROGRAMS_NWN2DATALIB_SIMPLEMESHSTORAGE_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <malloc.h>
+
+//
+// Define the allocator for vertex streams.  Allocations are 16 byte aligned
+// and rounded up to a multiple of four elements; the padding is not
+// constructed, so the element type must be a plain data type.
+//
+
+template< typename T >
+class SimpleMeshStreamAllocator
+{
+
+public:
+
+	enum
+	{
+		Alignment   = 16,
+		Granularity = 4
+	};
+
+	typedef T              value_type;
+	typedef T            * pointer;
+	typedef const T      * const_pointer;
+	typedef T            & reference;
+	typedef const T      & const_reference;
+	typedef size_t         size_type;
+	typedef ptrdiff_t      difference_type;
+
+	template< typename U >
+	struct rebind
+	{
+		typedef SimpleMeshStreamAllocator< U > other;
+	};
+
+	inline
+	SimpleMeshStreamAllocator(
+		)
+	{
+	}
+
+	template< typename U >
+	inline
+	SimpleMeshStreamAllocator(
+		nwn2dev__in const SimpleMeshStreamAllocator< U > &
+		)
+	{
+	}
+
+	inline
+	pointer
+	address(
+		nwn2dev__in reference Value
+		) const
+	{
+		return &Value;
+	}
+
+	inline
+	const_pointer
+	address(
+		nwn2dev__in const_reference Value
+		) const
+	{
+		return &Value;
+	}
+
+	inline
+	pointer
+	allocate(
+		nwn2dev__in size_type Count,
+		__in_opt const void * Hint = NULL
+		)
+	{
+		void * Memory;
+
+		UNREFERENCED_PARAMETER( Hint );
+
+		if (Count > max_size( ))
+			throw std::bad_alloc( );
+
+		Count = (Count + (Granularity - 1)) & ~((size_type) Granularity - 1);
+
+		if (Count == 0)
+			Count = Granularity;
+
+		Memory = _aligned_malloc( Count * sizeof( T ), Alignment );
+
+		if (Memory == NULL)
+			throw std::bad_alloc( );
+
+		return (pointer) Memory;
+	}
+
+	inline
+	void
+	deallocate(
+		nwn2dev__in pointer Memory,
+		nwn2dev__in size_type Count
+		)
+	{
+		UNREFERENCED_PARAMETER( Count );
+
+		_aligned_free( Memory );
+	}
+
+	inline
+	size_type
+	max_size(
+		) const
+	{
+		return ((size_type) -1 / sizeof( T )) & ~((size_type) Granularity - 1);
+	}
+
+	inline
+	void
+	construct(
+		nwn2dev__in pointer Memory,
+		nwn2dev__in const_reference Value
+		)
+	{
+		new ((void *) Memory) T( Value );
+	}
+
+	inline
+	void
+	destroy(
+		nwn2dev__in pointer Memory
+		)
+	{
+		UNREFERENCED_PARAMETER( Memory );
+
+		Memory->~T( );
+	}
+
+};
+
+template< typename T, typename U >
+inline
+bool
+operator==(
+	nwn2dev__in const SimpleMeshStreamAllocator< T > &,
+	nwn2dev__in const SimpleMeshStreamAllocator< U > &
+	)
+{
+	return true;
+}
+
+template< typename T, typename U >
+inline
+bool
+operator!=(
+	nwn2dev__in const SimpleMeshStreamAllocator< T > &,
+	nwn2dev__in const SimpleMeshStreamAllocator< U > &
+	)
+{
+	return false;
+}
+
+//
+// Define the interleaved (array of structures) vertex storage policy.  This is
+// a std::vector of vertices, so existing vertex array users are unaffected.
+//
+
+template< typename VertexT >
+class SimpleMeshInterleavedStorage : public std::vector< VertexT >
+{
+
+public:
+
+	typedef std::vector< VertexT > VertexArray;
+
+	//
+	// Return a strided array of a Vector3 member of each vertex, identified
+	// by its offset within the vertex structure.  NULL is returned if there
+	// are no vertices.
+	//
+
+	inline
+	const NWN::Vector3 *
+	GetVectorStream(
+		nwn2dev__in size_t MemberOffset,
+		nwn2dev__out size_t & Stride
+		) const
+	{
+		Stride = sizeof( VertexT );
+
+		if (VertexArray::empty( ))
+			return NULL;
+
+		return (const NWN::Vector3 *)
+			((const unsigned char *) &VertexArray::front( ) + MemberOffset);
+	}
+
+	//
+	// Return a writable strided array of a Vector3 member of each vertex.
+	// This is only to be used for members that are declared mutable in the
+	// vertex structure (i.e. derived data that is calculated on demand).
+	//
+
+	inline
+	NWN::Vector3 *
+	GetMutableVectorStream(
+		nwn2dev__in size_t MemberOffset,
+		nwn2dev__out size_t & Stride
+		) const
+	{
+		return const_cast< NWN::Vector3 * >(
+			GetVectorStream( MemberOffset, Stride ) );
+	}
+
+	//
+	// Return a Vector3 member of a single vertex.
+	//
+
+	inline
+	const NWN::Vector3 &
+	GetVector(
+		nwn2dev__in size_t MemberOffset,
+		nwn2dev__in size_t PointId
+		) const
+	{
+		return *(const NWN::Vector3 *)
+			((const unsigned char *) &(*this)[ PointId ] + MemberOffset);
+	}
+
+	//
+	// Return the count of bytes allocated to hold the vertices.
+	//
+
+	inline
+	size_t
+	GetAllocatedBytes(
+		) const
+	{
+		return VertexArray::capacity( ) * sizeof( VertexT );
+	}
+
+};
+
+//
+// Define the stream (structure of arrays) vertex storage policy.  The vertex
+// type must consist solely of NWN::Vector3 members; member N of each vertex is
+// stored in stream N.
+//
+// Vertices are returned by value (reassembled from the streams), so callers
+// that only need one member of a vertex should use GetVector instead of
+// operator[].
+//
+// Each stream is packed, 16 byte aligned and allocated in multiples of four
+// vertices (see SimpleMeshStreamAllocator), which makes the streams suitable
+// for the packed batch math routines.
+//
+
+template< typename VertexT >
+class SimpleMeshStreamStorage
+{
+
+public:
+
+	enum
+	{
+		NumStreams = sizeof( VertexT ) / sizeof( NWN::Vector3 )
+	};
+
+	static_assert( sizeof( VertexT ) == NumStreams * sizeof( NWN::Vector3 ) , "compile time assert failed" );
+
+	typedef std::vector< NWN::Vector3, SimpleMeshStreamAllocator< NWN::Vector3 > > Stream;
+
+	typedef VertexT       value_type;
+	typedef VertexT       const_reference;
+	typedef size_t        size_type;
+
+	inline
+	size_type
+	size(
+		) const
+	{
+		return m_Streams[ 0 ].size( );
+	}
+
+	inline
+	bool
+	empty(
+		) const
+	{
+		return m_Streams[ 0 ].empty( );
+	}
+
+	inline
+	void
+	clear(
+		)
+	{
+		for (size_t i = 0; i < NumStreams; i += 1)
+			m_Streams[ i ].clear( );
+	}
+
+	inline
+	void
+	reserve(
+		nwn2dev__in size_type Count
+		)
+	{
+		for (size_t i = 0; i < NumStreams; i += 1)
+			m_Streams[ i ].reserve( Count );
+	}
+
+	//
+	// Append a vertex, scattering its members across the streams.  The
+	// streams are left unchanged if an exception is raised.
+	//
+
+	inline
+	void
+	push_back(
+		nwn2dev__in const VertexT & Point
+		)
+	{
+		const NWN::Vector3 * Members = (const NWN::Vector3 *) &Point;
+		size_t               i;
+
+		try
+		{
+			for (i = 0; i < NumStreams; i += 1)
+				m_Streams[ i ].push_back( Members[ i ] );
+		}
+		catch (...)
+		{
+			while (i != 0)
+				m_Streams[ --i ].pop_back( );
+
+			throw;
+		}
+	}
+
+	//
+	// Reassemble a vertex from the streams.
+	//
+
+	inline
+	VertexT
+	operator[](
+		nwn2dev__in size_type PointId
+		) const
+	{
+		VertexT        Point;
+		NWN::Vector3 * Members = (NWN::Vector3 *) &Point;
+
+		for (size_t i = 0; i < NumStreams; i += 1)
+			Members[ i ] = m_Streams[ i ][ PointId ];
+
+		return Point;
+	}
+
+	inline
+	const NWN::Vector3 *
+	GetVectorStream(
+		nwn2dev__in size_t MemberOffset,
+		nwn2dev__out size_t & Stride
+		) const
+	{
+		const Stream & S = m_Streams[ MemberOffset / sizeof( NWN::Vector3 ) ];
+
+		Stride = sizeof( NWN::Vector3 );
+
+		if (S.empty( ))
+			return NULL;
+
+		return &S[ 0 ];
+	}
+
+	inline
+	NWN::Vector3 *
+	GetMutableVectorStream(
+		nwn2dev__in size_t MemberOffset,
+		nwn2dev__out size_t & Stride
+		) const
+	{
+		return const_cast< NWN::Vector3 * >(
+			GetVectorStream( MemberOffset, Stride ) );
+	}
+
+	inline
+	const NWN::Vector3 &
+	GetVector(
+		nwn2dev__in size_t MemberOffset,
+		nwn2dev__in size_t PointId
+		) const
+	{
+		return m_Streams[ MemberOffset / sizeof( NWN::Vector3 ) ][ PointId ];
+	}
+
+	inline
+	size_t
+	GetAllocatedBytes(
+		) const
+	{
+		size_t Bytes = 0;
+
+		for (size_t i = 0; i < NumStreams; i += 1)
+		{
+			size_t Capacity = m_Streams[ i ].capacity( );
+
+			Capacity  = (Capacity + (Stream::allocator_type::Granularity - 1)) & ~((size_t) Stream::allocator_type::Granularity - 1);
+			Bytes    += Capacity * sizeof( NWN::Vector3 );
+		}
+
+		return Bytes;
+	}
+
+private:
+
+	Stream m_Streams[ NumStreams ];
+
+};
+
+#endif
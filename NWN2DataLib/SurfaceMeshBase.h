@@ -138,6 +138,45 @@ public:
 		m_MinBound.z = +FLT_MAX;
 	}
 
+	//
+	// Preallocate storage for a mesh of known size, in advance of adding its
+	// points, edges and triangles.
+	//
+
+	inline
+	void
+	Reserve(
+		nwn2dev__in size_t NumPoints,
+		nwn2dev__in size_t NumEdges,
+		nwn2dev__in size_t NumTriangles
+		)
+	{
+		m_Points.reserve( NumPoints );
+		m_Edges.reserve( NumEdges );
+		m_Triangles.reserve( NumTriangles );
+	}
+
+	//
+	// Replace the point, edge and triangle arrays with copies of flat arrays,
+	// e.g. from a mapped cache file.
+	//
+
+	inline
+	void
+	Assign(
+		__in_ecount( NumPoints ) const NWN::Vector3 * Points,
+		nwn2dev__in size_t NumPoints,
+		__in_ecount( NumEdges ) const SurfaceMeshEdge * Edges,
+		nwn2dev__in size_t NumEdges,
+		__in_ecount( NumTriangles ) const SurfaceMeshTriangle * Triangles,
+		nwn2dev__in size_t NumTriangles
+		)
+	{
+		m_Points.assign( Points, Points + NumPoints );
+		m_Edges.assign( Edges, Edges + NumEdges );
+		m_Triangles.assign( Triangles, Triangles + NumTriangles );
+	}
+
 	inline
 	void
 	AddPoint(
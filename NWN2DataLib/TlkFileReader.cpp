@@ -15,6 +15,7 @@ Abstract:
 
 #include "Precomp.h"
 #include "TlkFileReader.h"
+#include "ParallelWorkQueue.h"
 
 #include <stdexcept>
 
@@ -73,6 +74,8 @@ Environment:
 			throw std::runtime_error( "Failed to read file size." );
 
 		ParseTlkFile( );
+
+		m_StringCache.resize( m_StringDir.size( ), NULL );
 	}
 	catch (...)
 	{
@@ -85,6 +88,14 @@ Environment:
 		throw;
 	}
 
+	for (size_t i = 0; i < INTERN_SHARD_COUNT; i += 1)
+	{
+		InitializeCriticalSection( &m_InternShards[ i ].Lock );
+
+		m_InternShards[ i ].CurrentBlock     = NULL;
+		m_InternShards[ i ].CurrentBlockUsed = 0;
+	}
+
 	static_assert( sizeof( TLK_HEADER ) == 5 * 4 , "compile time assert failed" );
 	static_assert( sizeof( TLK_STRING ) == 6 * 4 + sizeof( ResRefT ) , "compile time assert failed" );
 }
@@ -112,6 +123,8 @@ Environment:
 
 --*/
 {
+	ReleaseStringCache( );
+
 	if (m_File != INVALID_HANDLE_VALUE)
 	{
 		CloseHandle( m_File );
@@ -149,31 +162,437 @@ Environment:
 
 --*/
 {
-	PCTLK_STRING StringDesc;
+	TalkStringView View;
+
+	if (!GetTalkStringView( StringId, View ))
+	{
+		String.clear( );
+		return false;
+	}
+
+	String.assign( View.first, View.second );
+
+	return true;
+}
+
+template< typename ResRefT >
+bool
+TlkFileReader< ResRefT >::GetTalkStringView(
+	nwn2dev__in typename TlkFileReader< ResRefT >::StrRef StringId,
+	nwn2dev__out TalkStringView & View
+	) const
+/*++
+
+Routine Description:
 
-	String.clear( );
+	This routine returns a view of the text of a string from the talk file's
+	string directory.  The text is served from the string cache, and is
+	copied into the string cache first if this is the first request for the
+	string.
+
+Arguments:
+
+	StringId - Supplies the string ordinal to fetch.
+
+	View - Receives a view of the string text, which remains valid for the
+	       lifetime of the reader.
+
+Return Value:
+
+	The routine returns a Boolean value indicating true on success, else false
+	on failure (i.e. unknown string).  On catastrophic failure, the routine
+	raises an std::exception.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	PCTLK_STRING           StringDesc;
+	const InternedString * Cached;
 
 	StringDesc = LookupStringDescriptor( StringId );
 
 	if (StringDesc == NULL)
 		return false;
 
-	if (!(StringDesc->Flags & TEXT_PRESENT))
-		return true;
+	Cached = *(const InternedString * volatile *) &m_StringCache[ StringId ];
 
-	String.resize( StringDesc->StringSize );
+	if (Cached == NULL)
+		Cached = DecodeString( StringId, StringDesc );
 
-	if (StringDesc->StringSize == 0)
-		return true;
-
-	m_FileWrapper.SeekOffset(
-		m_StringsOffset + StringDesc->OffsetToString,
-		"Seek to String" );
-	m_FileWrapper.ReadFile( &String[ 0 ], String.size( ), "Read String" );
+	View.first  = Cached->Text;
+	View.second = Cached->Length;
 
 	return true;
 }
 
+template< typename ResRefT >
+void
+TlkFileReader< ResRefT >::DecodeAllStrings(
+	nwn2dev__in bool Parallel
+	) const
+/*++
+
+Routine Description:
+
+	This routine copies every string that is not yet cached into the string
+	cache, typically at startup so that later lookups never touch the file.
+
+	The string directory is split into one contiguous range per work item, a
+	few work items per processor.  Because the intern table is sharded by
+	string hash, the work items mostly proceed without contention.
+
+Arguments:
+
+	Parallel - Supplies a Boolean value indicating whether strings may be
+	           decoded on the system thread pool.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	DecodeWorkItemVec WorkItems;
+	size_t            WorkItemCount;
+	size_t            PerWorkItem;
+	size_t            StringCount;
+
+	StringCount = m_StringDir.size( );
+
+	if (StringCount == 0)
+		return;
+
+	if (Parallel)
+		WorkItemCount = 4 * ParallelWorkQueue::GetProcessorCount( );
+	else
+		WorkItemCount = 1;
+
+	if (WorkItemCount > StringCount)
+		WorkItemCount = StringCount;
+
+	PerWorkItem = (StringCount + WorkItemCount - 1) / WorkItemCount;
+
+	WorkItems.resize( WorkItemCount );
+
+	ParallelWorkQueue WorkQueue( WorkItemCount > 1 );
+
+	for (size_t i = 0; i < WorkItemCount; i += 1)
+	{
+		DecodeWorkItem & Item = WorkItems[ i ];
+
+		if (i * PerWorkItem >= StringCount)
+			break;
+
+		Item.Reader = this;
+		Item.First  = (StrRef) (i * PerWorkItem);
+		Item.Count  = (StrRef) PerWorkItem;
+
+		if (Item.Count > StringCount - Item.First)
+			Item.Count = (StrRef) (StringCount - Item.First);
+
+		WorkQueue.QueueWork( DecodeWorkItemRoutine, &Item );
+	}
+
+	WorkQueue.WaitForAll( );
+}
+
+template< typename ResRefT >
+const typename TlkFileReader< ResRefT >::InternedString *
+TlkFileReader< ResRefT >::DecodeString(
+	nwn2dev__in typename TlkFileReader< ResRefT >::StrRef StringId,
+	nwn2dev__in PCTLK_STRING StringDesc
+	) const
+/*++
+
+Routine Description:
+
+	This routine copies the text of a string out of the talk file into the
+	string cache.
+
+	NWN2 talk tables store their text as UTF-8 already, so the text is taken
+	verbatim; the cached copy is only null terminated and interned.
+
+	Several threads may decode the same string at once.  As identical text is
+	interned to the same cached string, they all publish the same value.
+
+Arguments:
+
+	StringId - Supplies the string ordinal to decode.
+
+	StringDesc - Supplies the string directory entry of the string.
+
+Return Value:
+
+	The routine returns the cached string.  On failure, an std::exception is
+	raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const InternedString * Cached;
+	const char           * Text;
+	std::string            Buffer;
+	ULONGLONG              Offset;
+	ULONG                  Length;
+
+	if (StringDesc->Flags & TEXT_PRESENT)
+		Length = StringDesc->StringSize;
+	else
+		Length = 0;
+
+	Text = "";
+
+	if (Length != 0)
+	{
+		Offset = (ULONGLONG) m_StringsOffset + StringDesc->OffsetToString;
+
+		if (m_FileWrapper.IsMapped( ))
+		{
+			//
+			// Copy straight from the mapped view.
+			//
+
+			if (Offset + Length > m_FileWrapper.GetFileSize( ))
+				throw std::runtime_error( "TLK string extends past end of file." );
+
+			Text = (const char *) m_FileWrapper.GetView( ) + Offset;
+		}
+		else
+		{
+			Buffer.resize( Length );
+
+			m_FileWrapper.ReadFileAtOffset(
+				&Buffer[ 0 ],
+				Buffer.size( ),
+				Offset,
+				"Read String");
+
+			Text = Buffer.data( );
+		}
+	}
+
+	Cached = InternString( Text, Length );
+
+	InterlockedExchangePointer(
+		(PVOID volatile *) &m_StringCache[ StringId ],
+		(PVOID) Cached);
+
+	return Cached;
+}
+
+template< typename ResRefT >
+const typename TlkFileReader< ResRefT >::InternedString *
+TlkFileReader< ResRefT >::InternString(
+	__in_ecount( Length ) const char * Text,
+	nwn2dev__in ULONG Length
+	) const
+/*++
+
+Routine Description:
+
+	This routine locates the interned copy of a string, creating it in the
+	string arena if the string has not been seen before.
+
+Arguments:
+
+	Text - Supplies the string text, which need not be null terminated.
+
+	Length - Supplies the length of the string text, in bytes.
+
+Return Value:
+
+	The routine returns the interned string.  On failure, an std::exception
+	is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	InternedString * Interned;
+	ULONG            Hash;
+	size_t           Size;
+
+	//
+	// Hash the text (FNV-1a) to select the shard and the intern table bucket.
+	//
+
+	Hash = 2166136261UL;
+
+	for (ULONG i = 0; i < Length; i += 1)
+	{
+		Hash ^= (unsigned char) Text[ i ];
+		Hash *= 16777619UL;
+	}
+
+	InternShard & Shard = m_InternShards[ Hash % INTERN_SHARD_COUNT ];
+
+	EnterCriticalSection( &Shard.Lock );
+
+	try
+	{
+		typedef typename InternMap::const_iterator InternIterator;
+
+		std::pair< InternIterator, InternIterator > Range;
+
+		Range = Shard.Strings.equal_range( Hash );
+
+		for (InternIterator it = Range.first; it != Range.second; ++it)
+		{
+			if ((it->second->Length == Length) &&
+			    (!memcmp( it->second->Text, Text, Length )))
+			{
+				LeaveCriticalSection( &Shard.Lock );
+
+				return it->second;
+			}
+		}
+
+		//
+		// Carve the new string out of the current arena block, keeping the
+		// string headers aligned.  Strings too large to share a block get a
+		// block of their own.
+		//
+
+		Size  = offsetof( InternedString, Text ) + Length + 1;
+		Size  = (Size + sizeof( ULONGLONG ) - 1) & ~(sizeof( ULONGLONG ) - 1);
+
+		if (Size > ARENA_BLOCK_SIZE / 4)
+		{
+			Shard.Blocks.reserve( Shard.Blocks.size( ) + 1 );
+			Interned = (InternedString *) new unsigned char[ Size ];
+			Shard.Blocks.push_back( (unsigned char *) Interned );
+		}
+		else
+		{
+			if ((Shard.CurrentBlock == NULL) ||
+			    (Shard.CurrentBlockUsed + Size > ARENA_BLOCK_SIZE))
+			{
+				Shard.Blocks.reserve( Shard.Blocks.size( ) + 1 );
+				Shard.CurrentBlock     = new unsigned char[ ARENA_BLOCK_SIZE ];
+				Shard.CurrentBlockUsed = 0;
+				Shard.Blocks.push_back( Shard.CurrentBlock );
+			}
+
+			Interned = (InternedString *) &Shard.CurrentBlock[ Shard.CurrentBlockUsed ];
+			Shard.CurrentBlockUsed += Size;
+		}
+
+		Interned->Length = Length;
+		Interned->Hash   = Hash;
+
+		memcpy( Interned->Text, Text, Length );
+		Interned->Text[ Length ] = '\0';
+
+		Shard.Strings.insert( typename InternMap::value_type( Hash, Interned ) );
+	}
+	catch (...)
+	{
+		LeaveCriticalSection( &Shard.Lock );
+		throw;
+	}
+
+	LeaveCriticalSection( &Shard.Lock );
+
+	return Interned;
+}
+
+template< typename ResRefT >
+void
+TlkFileReader< ResRefT >::ReleaseStringCache(
+	)
+/*++
+
+Routine Description:
+
+	This routine releases the string cache, the intern table and the string
+	arena.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	m_StringCache.clear( );
+
+	for (size_t i = 0; i < INTERN_SHARD_COUNT; i += 1)
+	{
+		InternShard & Shard = m_InternShards[ i ];
+
+		for (ArenaBlockVec::iterator it = Shard.Blocks.begin( );
+		     it != Shard.Blocks.end( );
+		     ++it)
+		{
+			delete [] *it;
+		}
+
+		Shard.Blocks.clear( );
+		Shard.Strings.clear( );
+
+		DeleteCriticalSection( &Shard.Lock );
+	}
+}
+
+template< typename ResRefT >
+void
+__stdcall
+TlkFileReader< ResRefT >::DecodeWorkItemRoutine(
+	nwn2dev__in void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine is the work routine for a parallel decode work item.  It
+	copies each string within its range of the string directory into the
+	string cache.
+
+Arguments:
+
+	Context - Supplies the DecodeWorkItem describing the work.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode, potentially thread pool thread.
+
+--*/
+{
+	DecodeWorkItem      * Item   = (DecodeWorkItem *) Context;
+	const TlkFileReader * Reader = Item->Reader;
+
+	for (StrRef i = Item->First; i < Item->First + Item->Count; i += 1)
+	{
+		if (Reader->m_StringCache[ i ] != NULL)
+			continue;
+
+		Reader->DecodeString( i, &Reader->m_StringDir[ i ] );
+	}
+}
+
 template< typename ResRefT >
 void
 TlkFileReader< ResRefT >::ParseTlkFile(
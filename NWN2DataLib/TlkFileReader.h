@@ -11,6 +11,13 @@ Abstract:
 	This module defines the interface to the Talk Table (TLK) file reader.  TLK
 	files are used to localize string resources in the game.
 
+	The TLK file is kept mapped for the lifetime of the reader.  The text of
+	each string is copied out of the mapping on first use into a string cache
+	which interns identical strings into a compact arena, so that repeated
+	lookups of the same STRREF (or of different STRREFs with the same text)
+	touch no file data and allocate no memory.  The cache may also be filled
+	up front, in parallel, with DecodeAllStrings.
+
 --*/
 
 #ifndef _PROGRAMS_NWN2DATALIB_TLKFILEREADER_H
@@ -34,6 +41,13 @@ public:
 
 	typedef unsigned long  StrRef;
 
+	//
+	// Define a view of the text of a string:  a pointer to the string text,
+	// which is null terminated, and the length of the string text in bytes.
+	//
+
+	typedef std::pair< const char *, size_t > TalkStringView;
+
 	//
 	// Constructor.  Raises an std::exception on parse failure.
 	//
@@ -61,6 +75,44 @@ public:
 		nwn2dev__out std::string & String
 		) const;
 
+	//
+	// Look up a string based on STRREF, returning a view of the string text
+	// that remains valid for the lifetime of the reader.  Returns false on
+	// failure, i.e. if the string could not be found.  No memory is allocated
+	// once a string has been cached.
+	//
+	// The routine may be called concurrently from multiple threads.
+	//
+
+	bool
+	GetTalkStringView(
+		nwn2dev__in StrRef StringId,
+		nwn2dev__out TalkStringView & View
+		) const;
+
+	//
+	// Copy every string into the string cache ahead of use.  If Parallel is
+	// true, the strings are split into ranges that are decoded on the system
+	// thread pool.  Raises an std::exception on failure.
+	//
+
+	void
+	DecodeAllStrings(
+		nwn2dev__in bool Parallel = true
+		) const;
+
+	//
+	// Return the count of strings in the string directory.
+	//
+
+	inline
+	StrRef
+	GetStringCount(
+		) const
+	{
+		return (StrRef) m_StringDir.size( );
+	}
+
 	//
 	// Define the TLK on-disk file structures.  This data is based on the
 	// BioWare Aurora engine documentation.
@@ -132,6 +184,88 @@ private:
 
 	typedef std::vector< TLK_STRING > TlkStringVec;
 
+	//
+	// Define an interned string, which is stored in the string arena.  The
+	// text is followed by a null terminator.
+	//
+
+	struct InternedString
+	{
+		ULONG Length;
+		ULONG Hash;
+		char  Text[ 1 ];
+	};
+
+	typedef std::vector< const InternedString * > StringCacheVec;
+	typedef std::unordered_multimap< ULONG, const InternedString * > InternMap;
+	typedef std::vector< unsigned char * > ArenaBlockVec;
+
+	//
+	// The intern table is split into shards by string hash, each with its
+	// own lock and arena, so that parallel decoding does not serialize on a
+	// single lock.
+	//
+
+	enum
+	{
+		INTERN_SHARD_COUNT = 16,
+		ARENA_BLOCK_SIZE   = 64 * 1024
+	};
+
+	struct InternShard
+	{
+		CRITICAL_SECTION   Lock;
+		InternMap          Strings;
+		ArenaBlockVec      Blocks;
+		unsigned char    * CurrentBlock;
+		size_t             CurrentBlockUsed;
+	};
+
+	struct DecodeWorkItem
+	{
+		const TlkFileReader * Reader;
+		StrRef                First;
+		StrRef                Count;
+	};
+
+	typedef std::vector< DecodeWorkItem > DecodeWorkItemVec;
+
+	//
+	// Copy the text of a string into the string cache, returning the cached
+	// string.  Raises an std::exception on failure.
+	//
+
+	const InternedString *
+	DecodeString(
+		nwn2dev__in StrRef StringId,
+		nwn2dev__in PCTLK_STRING StringDesc
+		) const;
+
+	//
+	// Locate or create the interned copy of a string.
+	//
+
+	const InternedString *
+	InternString(
+		__in_ecount( Length ) const char * Text,
+		nwn2dev__in ULONG Length
+		) const;
+
+	//
+	// Release the string cache and the intern table.
+	//
+
+	void
+	ReleaseStringCache(
+		);
+
+	static
+	void
+	__stdcall
+	DecodeWorkItemRoutine(
+		nwn2dev__in void * Context
+		);
+
 	//
 	// Locate a string descriptor by its reference id.
 	//
@@ -163,6 +297,16 @@ private:
 
 	TlkStringVec          m_StringDir;
 
+	//
+	// String cache data.  Each slot of the string cache is either NULL, or
+	// points to the interned text of the corresponding string directory
+	// entry.  Slots are filled without holding a lock and are never changed
+	// once set; the intern table is guarded by the lock of each shard.
+	//
+
+	mutable StringCacheVec m_StringCache;
+	mutable InternShard    m_InternShards[ INTERN_SHARD_COUNT ];
+
 };
 
 typedef TlkFileReader< NWN::ResRef32 > TlkFileReader32;
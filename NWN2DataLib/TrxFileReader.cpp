@@ -17,15 +17,58 @@ Abstract:
 --*/
 
 #include "Precomp.h"
+#include "TextOut.h"
 #include "TrxFileReader.h"
 
+static
+size_t
+CapElementCount(
+	nwn2dev__in unsigned long Count,
+	nwn2dev__in size_t Available,
+	nwn2dev__in size_t ElementSize
+	)
+/*++
+
+Routine Description:
+
+	This routine caps an element count read from a resource header to the
+	count of elements that could fit in the remaining resource data.  It is
+	used to size preallocations such that a corrupted header cannot cause an
+	excessive allocation.
+
+Arguments:
+
+	Count - Supplies the element count from the resource header.
+
+	Available - Supplies the count of bytes remaining in the resource.
+
+	ElementSize - Supplies the minimum size of an element, in bytes.
+
+Return Value:
+
+	The routine returns the capped element count.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if (Count > Available / ElementSize)
+		return Available / ElementSize;
+
+	return Count;
+}
+
 TrxFileReader::TrxFileReader(
 	nwn2dev__in MeshManager & MeshMgr,
 	nwn2dev__in const std::string & FileName,
 	nwn2dev__in bool LoadOnlyDimensions,
 	nwn2dev__in MODE Mode, /* = ModeTRX */
 	nwn2dev__in IDebugTextOut * TextWriter, /* = NULL */
-	nwn2dev__in bool RefuseDisplayOnlyModels /* = false */
+	nwn2dev__in bool RefuseDisplayOnlyModels, /* = false */
+	nwn2dev__in ULONG LoadFlags, /* = 0 */
+	__in_opt const char * WalkmeshCacheDirectory /* = NULL */
 	)
 /*++
 
@@ -56,6 +99,14 @@ Arguments:
 	                          any model data that is purely display-based is to
 	                          not be loaded.
 
+	LoadFlags - Supplies load flags (LoadFlag*) that control whether resources
+	            are decoded in parallel and whether meshes are registered with
+	            the mesh manager immediately.
+
+	WalkmeshCacheDirectory - Optionally supplies the directory that holds the
+	                         decoded walkmesh cache.  If NULL, the walkmesh is
+	                         always decoded from the TRX file.
+
 Return Value:
 
 	The newly constructed object.
@@ -72,9 +123,14 @@ Environment:
   m_LoadOnlyDimensions( LoadOnlyDimensions ),
   m_Walkmesh( TextWriter ),
   m_Mode( Mode ),
+  m_LoadFlags( LoadFlags ),
   m_TextWriter( TextWriter ),
-  m_RefuseDisplayOnlyModels( RefuseDisplayOnlyModels )
+  m_RefuseDisplayOnlyModels( RefuseDisplayOnlyModels ),
+  m_RegistrationPending( false )
 {
+	if (WalkmeshCacheDirectory != NULL)
+		m_WalkmeshCacheDirectory = WalkmeshCacheDirectory;
+
 	HANDLE File;
 //	DWORD  Read;
 //	DWORD  Pos;
@@ -192,6 +248,170 @@ Environment:
 	}
 }
 
+void
+TrxFileReader::LoadAreas(
+	nwn2dev__in MeshManager & MeshMgr,
+	nwn2dev__in const FileNameVec & FileNames,
+	nwn2dev__in bool LoadOnlyDimensions,
+	nwn2dev__out PtrVec & Areas,
+	__in_opt IDebugTextOut * TextWriter, /* = NULL */
+	nwn2dev__in bool RefuseDisplayOnlyModels, /* = false */
+	nwn2dev__in ULONG LoadFlags, /* = 0 */
+	__in_opt const char * WalkmeshCacheDirectory /* = NULL */
+	)
+/*++
+
+Routine Description:
+
+	This routine loads a batch of TRX files in parallel, one file per thread
+	pool work item.  Each file is decoded serially within its work item (so
+	that thread pool threads never block waiting on nested work), and with
+	mesh registration deferred, as the mesh manager is not thread safe.  Once
+	all files have been decoded, the meshes of each area are registered in
+	file order.
+
+Arguments:
+
+	MeshMgr - Supplies the mesh manager to which all child meshes are
+	          registered to.
+
+	FileNames - Supplies the paths to the TRX files to load.
+
+	LoadOnlyDimensions - Supplies a Boolean value indicating if only area size
+	                     parameters should be loaded, versus all area mesh
+	                     data.
+
+	Areas - Receives the loaded areas, in the same order as FileNames.
+
+	TextWriter - Optionally supplies the text output implementation that is
+	             used to indicate debug log messages upwards.  The text output
+	             implementation may be called concurrently.
+
+	RefuseDisplayOnlyModels - Supplies a Boolean value that indicates whether
+	                          any model data that is purely display-based is to
+	                          not be loaded.
+
+	LoadFlags - Supplies additional load flags for each file.  Serial decode
+	            and deferred mesh registration are always used.
+
+	WalkmeshCacheDirectory - Optionally supplies the directory that holds the
+	                         decoded walkmesh cache.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised, and no areas are
+	returned.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< AREA_LOAD_WORK_ITEM > WorkItems;
+
+	Areas.clear( );
+
+	if (FileNames.empty( ))
+		return;
+
+	WorkItems.resize( FileNames.size( ) );
+
+	{
+		ParallelWorkQueue WorkQueue(
+			(FileNames.size( ) > 1) &&
+			(ParallelWorkQueue::GetProcessorCount( ) > 1));
+
+		for (size_t i = 0; i < FileNames.size( ); i += 1)
+		{
+			AREA_LOAD_WORK_ITEM & WorkItem = WorkItems[ i ];
+
+			WorkItem.MeshMgr                 = &MeshMgr;
+			WorkItem.FileName                = &FileNames[ i ];
+			WorkItem.LoadOnlyDimensions      = LoadOnlyDimensions;
+			WorkItem.TextWriter              = TextWriter;
+			WorkItem.RefuseDisplayOnlyModels = RefuseDisplayOnlyModels;
+			WorkItem.LoadFlags               = LoadFlags |
+			                                   LoadFlagSerialDecode |
+			                                   LoadFlagDeferMeshRegistration;
+			WorkItem.WalkmeshCacheDirectory  = WalkmeshCacheDirectory;
+
+			WorkQueue.QueueWork( AreaLoadWorkItemRoutine, &WorkItem );
+		}
+
+		WorkQueue.WaitForAll( );
+	}
+
+	//
+	// Now that every area has been decoded, register all of the meshes with
+	// the mesh manager from this thread.
+	//
+
+	for (std::vector< AREA_LOAD_WORK_ITEM >::iterator it = WorkItems.begin( );
+	     it != WorkItems.end( );
+	     ++it)
+	{
+		it->Area->RegisterMeshes( MeshMgr );
+	}
+
+	Areas.reserve( WorkItems.size( ) );
+
+	for (std::vector< AREA_LOAD_WORK_ITEM >::iterator it = WorkItems.begin( );
+	     it != WorkItems.end( );
+	     ++it)
+	{
+		Areas.push_back( it->Area );
+	}
+}
+
+void
+TrxFileReader::RegisterMeshes(
+	nwn2dev__in MeshManager & MeshMgr
+	)
+/*++
+
+Routine Description:
+
+	This routine registers the decoded area meshes with the mesh manager, if
+	they have not yet been registered.
+
+Arguments:
+
+	MeshMgr - Supplies the mesh manager to which all child meshes are
+	          registered to.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode, not concurrent with any other user of the mesh manager.
+
+--*/
+{
+	if (!m_RegistrationPending)
+		return;
+
+	m_Walkmesh.RegisterMesh( MeshMgr );
+
+	for (AreaWaterMeshVec::iterator it = m_WaterMesh.begin( );
+	     it != m_WaterMesh.end( );
+	     ++it)
+	{
+		it->RegisterMesh( MeshMgr );
+	}
+
+	for (AreaTerrainMeshVec::iterator it = m_TerrainMesh.begin( );
+	     it != m_TerrainMesh.end( );
+	     ++it)
+	{
+		it->RegisterMesh( MeshMgr );
+	}
+
+	m_RegistrationPending = false;
+}
+
 void
 TrxFileReader::ParseTrxFile(
 	nwn2dev__in MeshManager & MeshMgr
@@ -218,8 +438,11 @@ Environment:
 
 --*/
 {
-	bool FoundAswm;
-	bool FoundTrwh;
+	bool              FoundAswm;
+	bool              FoundTrwh;
+	DecodeWorkItemVec WorkItems;
+	size_t            WaterCount;
+	size_t            TerrainCount;
 
 	//
 	// Read the file header first.
@@ -252,8 +475,10 @@ Environment:
 	// Process resource headers we are interested in.
 	//
 
-	FoundAswm = false;
-	FoundTrwh = false;
+	FoundAswm    = false;
+	FoundTrwh    = false;
+	WaterCount   = 0;
+	TerrainCount = 0;
 
 	//
 	// Create a new model instance if we're loading an MDB.
@@ -270,7 +495,8 @@ Environment:
 	     it != m_ResourceDirectory.end( );
 	     ++it)
 	{
-		RESOURCE_HEADER ResHeader;
+		RESOURCE_HEADER  ResHeader;
+		DECODE_WORK_ITEM WorkItem;
 
 		SeekOffset( it->Offset, "Seek to resource header" );
 
@@ -291,6 +517,16 @@ Environment:
 		// resource offsets, we've no need to parse each individual resource
 		// type unless we actually need a particular data item.
 		//
+		// The bulky area resources (walkmesh, water and terrain) are not
+		// decoded here, but are instead queued for decoding once the whole
+		// directory has been scanned, as they are independent of each other.
+		//
+
+		WorkItem.Reader         = this;
+		WorkItem.ResourceTypeId = ResHeader.ResourceTypeId;
+		WorkItem.ResourceLength = ResHeader.Length;
+		WorkItem.DataOffset     = it->Offset + sizeof( ResHeader );
+		WorkItem.TargetIndex    = 0;
 
 		switch (it->ResourceTypeId)
 		{
@@ -302,9 +538,15 @@ Environment:
 			if (FoundAswm)
 				throw std::runtime_error( "Duplicate area surface walkmesh." );
 
-			DecodeAreaSurfaceWalkmesh( &ResHeader, MeshMgr );
-
 			FoundAswm = true;
+
+			if (m_LoadOnlyDimensions)
+			{
+				DecodeAreaSurfaceWalkmesh( &ResHeader, m_FileWrapper );
+				break;
+			}
+
+			WorkItems.push_back( WorkItem );
 			break;
 
 		case TRX_WIDTH_HEIGHT_ID:
@@ -330,14 +572,22 @@ Environment:
 			if ((m_Mode != ModeTRX) || (m_RefuseDisplayOnlyModels))
 				continue;
 
-			DecodeWater( &ResHeader, MeshMgr );
+			if (m_LoadOnlyDimensions)
+				continue;
+
+			WorkItem.TargetIndex = WaterCount++;
+			WorkItems.push_back( WorkItem );
 			break;
 
 		case TRX_TERRAIN_ID:
 			if ((m_Mode != ModeTRX) || (m_RefuseDisplayOnlyModels))
 				continue;
 
-			DecodeTerrain( &ResHeader, MeshMgr );
+			if (m_LoadOnlyDimensions)
+				continue;
+
+			WorkItem.TargetIndex = TerrainCount++;
+			WorkItems.push_back( WorkItem );
 			break;
 
 		case TRX_COLLISION2_ID:
@@ -407,6 +657,20 @@ Environment:
 			throw std::runtime_error(
 				"Critical area walkmesh resources missing." );
 		}
+
+		if (m_LoadOnlyDimensions)
+			break;
+
+		//
+		// Preallocate the water and terrain mesh arrays so that each decode
+		// work item can fill in its own mesh without any synchronization, and
+		// then decode all queued area resources.
+		//
+
+		m_WaterMesh.resize( WaterCount );
+		m_TerrainMesh.resize( TerrainCount );
+
+		DecodeAreaResources( MeshMgr, WorkItems );
 		break;
 
 	default:
@@ -415,23 +679,348 @@ Environment:
 	}
 }
 
+void
+TrxFileReader::DecodeAreaResources(
+	nwn2dev__in MeshManager & MeshMgr,
+	nwn2dev__in DecodeWorkItemVec & WorkItems
+	)
+/*++
+
+Routine Description:
+
+	This routine decodes the area surface walkmesh, water and terrain
+	resources of a TRX file.  If the file is mapped as a section, each
+	resource is decoded by its own thread pool work item directly from the
+	mapped view; otherwise, the resources are decoded serially.
+
+	Once all resources are decoded, the height map is updated and the meshes
+	are registered (unless registration is deferred) in resource directory
+	order, exactly as for a serial load.
+
+Arguments:
+
+	MeshMgr - Supplies the mesh manager to which all child meshes are
+	          registered to.
+
+	WorkItems - Supplies the decode work items, in resource directory order.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	bool Parallel;
+
+	Parallel = (m_FileWrapper.IsMapped( )) &&
+	           (!(m_LoadFlags & LoadFlagSerialDecode)) &&
+	           (WorkItems.size( ) > 1) &&
+	           (ParallelWorkQueue::GetProcessorCount( ) > 1);
+
+	{
+		ParallelWorkQueue WorkQueue( Parallel );
+
+		for (DecodeWorkItemVec::iterator it = WorkItems.begin( );
+		     it != WorkItems.end( );
+		     ++it)
+		{
+			WorkQueue.QueueWork( DecodeWorkItemRoutine, &*it );
+		}
+
+		WorkQueue.WaitForAll( );
+	}
+
+	//
+	// Publish the decoded data.  The height map is order dependent, so it is
+	// updated in resource directory order.
+	//
+
+	for (DecodeWorkItemVec::const_iterator it = WorkItems.begin( );
+	     it != WorkItems.end( );
+	     ++it)
+	{
+		switch (it->ResourceTypeId)
+		{
+
+		case TRX_WATER_ID:
+			m_HeightMap.ComputeWaterHeights( m_WaterMesh[ it->TargetIndex ] );
+			break;
+
+		case TRX_TERRAIN_ID:
+			m_HeightMap.ComputeHeights( m_TerrainMesh[ it->TargetIndex ] );
+			break;
+
+		}
+	}
+
+	m_RegistrationPending = true;
+
+	if (!(m_LoadFlags & LoadFlagDeferMeshRegistration))
+		RegisterMeshes( MeshMgr );
+}
+
+void
+__stdcall
+TrxFileReader::DecodeWorkItemRoutine(
+	nwn2dev__in void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine decodes a single area resource on behalf of
+	DecodeAreaResources.
+
+Arguments:
+
+	Context - Supplies the DECODE_WORK_ITEM describing the resource.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode, potentially a thread pool thread.
+
+--*/
+{
+	PCDECODE_WORK_ITEM WorkItem = (PCDECODE_WORK_ITEM) Context;
+	TrxFileReader    * Reader   = WorkItem->Reader;
+	RESOURCE_HEADER    ResHeader;
+	FileWrapper        View;
+	FileWrapper      * File;
+
+	//
+	// If the file is mapped, read through a private cursor over the shared
+	// view so that concurrent work items do not disturb one another.  Else,
+	// decoding is serial and the reader's own file wrapper is used.
+	//
+
+	if (Reader->m_FileWrapper.IsMapped( ))
+	{
+		View.SetExternalView(
+			Reader->m_FileWrapper.GetView( ),
+			Reader->m_FileWrapper.GetFileSize( ));
+
+		File = &View;
+	}
+	else
+	{
+		File = &Reader->m_FileWrapper;
+	}
+
+	File->SeekOffset( WorkItem->DataOffset, "Seek to resource data" );
+
+	ResHeader.ResourceTypeId = WorkItem->ResourceTypeId;
+	ResHeader.Length         = WorkItem->ResourceLength;
+
+	switch (WorkItem->ResourceTypeId)
+	{
+
+	case TRX_AREA_SURFACE_MESH_ID:
+		Reader->DecodeAreaSurfaceWalkmesh( &ResHeader, *File );
+		break;
+
+	case TRX_WATER_ID:
+		Reader->DecodeWater(
+			&ResHeader,
+			*File,
+			Reader->m_WaterMesh[ WorkItem->TargetIndex ]);
+		break;
+
+	case TRX_TERRAIN_ID:
+		Reader->DecodeTerrain(
+			&ResHeader,
+			*File,
+			Reader->m_TerrainMesh[ WorkItem->TargetIndex ]);
+		break;
+
+	default:
+		throw std::runtime_error( "Unexpected area resource type." );
+
+	}
+}
+
+void
+__stdcall
+TrxFileReader::AreaLoadWorkItemRoutine(
+	nwn2dev__in void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine loads a single TRX file on behalf of LoadAreas.
+
+Arguments:
+
+	Context - Supplies the AREA_LOAD_WORK_ITEM describing the file.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode, potentially a thread pool thread.
+
+--*/
+{
+	PAREA_LOAD_WORK_ITEM WorkItem = (PAREA_LOAD_WORK_ITEM) Context;
+
+	WorkItem->Area = new TrxFileReader(
+		*WorkItem->MeshMgr,
+		*WorkItem->FileName,
+		WorkItem->LoadOnlyDimensions,
+		ModeTRX,
+		WorkItem->TextWriter,
+		WorkItem->RefuseDisplayOnlyModels,
+		WorkItem->LoadFlags,
+		WorkItem->WalkmeshCacheDirectory);
+}
+
 void
 TrxFileReader::DecodeAreaSurfaceWalkmesh(
 	nwn2dev__in PCRESOURCE_HEADER ResHeader,
-	nwn2dev__in MeshManager & MeshMgr
+	nwn2dev__in FileWrapper & File
 	)
 /*++
 
 Routine Description:
 
-	This routine decodes the area surface walkmesh.
+	This routine decodes the area surface walkmesh.  The mesh is registered
+	with the mesh manager by the caller.
+
+	If a walkmesh cache directory was supplied, the walkmesh is loaded from
+	the cache file matching the content hash of the resource data if there
+	is one, and otherwise, the decoded walkmesh is written to the cache.
 
 Arguments:
 
 	ResHeader - Supplies the current resource object header.
-	
-	MeshMgr - Supplies the mesh manager to which all child meshes are
-	          registered to.
+
+	File - Supplies the file to read from, which is positioned at the data
+	       of the resource.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode, seeked to the start of the resource in question.  The routine
+	may run concurrently with the decoding of other resources of the file.
+
+--*/
+{
+	bool        UseCache;
+	bool        FromCache;
+	std::string CacheFileName;
+	ULONGLONG   ContentHash;
+
+	if (ResHeader->Length < sizeof( COMPRESSION_HEADER ))
+		throw std::exception( "WalkmeshHeader length too small." );
+
+	if (m_LoadOnlyDimensions)
+		return;
+
+	//
+	// The cache is keyed by the raw resource data, which is hashed straight
+	// out of the mapped view.
+	//
+
+	UseCache    = (!m_WalkmeshCacheDirectory.empty( )) && (File.IsMapped( ));
+	FromCache   = false;
+	ContentHash = 0;
+
+	if (UseCache)
+	{
+		ULONGLONG DataOffset = File.GetFilePointer( );
+
+		ContentHash = AreaSurfaceMeshCache::ComputeContentHash(
+			File.ReadFileView( ResHeader->Length, "Walkmesh resource data" ),
+			ResHeader->Length);
+
+		File.SeekOffset( DataOffset, "Seek to walkmesh resource data" );
+
+		CacheFileName = AreaSurfaceMeshCache::GetCacheFileName(
+			m_WalkmeshCacheDirectory,
+			ContentHash);
+
+		FromCache = AreaSurfaceMeshCache::Load(
+			CacheFileName,
+			ContentHash,
+			m_Walkmesh);
+	}
+
+	if (!FromCache)
+		ParseAreaSurfaceWalkmesh( ResHeader, File );
+
+	//
+	// Validate walkmesh data now that we've read it all in.  Data from a
+	// trusted cache was already validated when the cache file was written.
+	//
+
+	if ((!FromCache) || (!(m_LoadFlags & LoadFlagTrustWalkmeshCache)))
+		m_Walkmesh.Validate( );
+
+	//
+	// Set up the face base pointers for each tile surface mesh.
+	//
+
+	for (AreaSurfaceMesh::TileSurfaceMeshVec::iterator it = m_Walkmesh.GetTileSurfaceMeshes( ).begin( );
+	     it != m_Walkmesh.GetTileSurfaceMeshes( ).end( );
+	     ++it)
+	{
+		if (it->m_NumFaces != 0)
+			it->m_Faces = &m_Walkmesh.GetTriangles( )[ it->m_FaceOffset ];
+	}
+
+	//
+	// Calculate bounding boxes.
+	//
+
+	m_Walkmesh.CalcBoundingBoxes( );
+
+	//
+	// Write the cache file for next time.  Failure to do so is not fatal.
+	//
+
+	if ((UseCache) && (!FromCache))
+	{
+		if ((!AreaSurfaceMeshCache::Save( CacheFileName, ContentHash, m_Walkmesh )) &&
+		    (m_TextWriter != NULL))
+		{
+			m_TextWriter->WriteText(
+				"WARNING: Failed to write walkmesh cache file '%s'.\n",
+				CacheFileName.c_str( ));
+		}
+	}
+}
+
+void
+TrxFileReader::ParseAreaSurfaceWalkmesh(
+	nwn2dev__in PCRESOURCE_HEADER ResHeader,
+	nwn2dev__in FileWrapper & File
+	)
+/*++
+
+Routine Description:
+
+	This routine parses the (possibly compressed) ASWM resource data into the
+	area surface walkmesh.  The walkmesh is not validated.
+
+Arguments:
+
+	ResHeader - Supplies the current resource object header.
+
+	File - Supplies the file to read from, which is positioned at the data
+	       of the resource.
 
 Return Value:
 
@@ -453,18 +1042,13 @@ Environment:
 	unsigned long                  IslandCount;
 	unsigned long                  FaceOffset;
 
-	if (ResHeader->Length < sizeof( CompressHeader ))
-		throw std::exception( "WalkmeshHeader length too small." );
-
-	if (m_LoadOnlyDimensions)
-		return;
-
-	ReadFile( &CompressHeader, sizeof( CompressHeader ), "Compress Header" );
+	ReadFile( File, &CompressHeader, sizeof( CompressHeader ), "Compress Header" );
 
 	if (CompressHeader.TypeId == TRX_COMPRESSION_HEADER_ID)
 	{
 		NWN::Compressor              CompressContext;
 		std::vector< unsigned char > Compressed;
+		const unsigned char        * CompressedData;
 
 		//
 		// Decompress into a staging buffer.
@@ -502,20 +1086,37 @@ Environment:
 		if (CompressHeader.CompressedSize >= 128 * 1024 * 1024)
 			throw std::exception( "Too large compressed walkmesh (>128MB)-2" );
 
-		Compressed.resize( CompressHeader.CompressedSize );
+		//
+		// Inflate directly out of the mapped view if we have one, else stage
+		// the compressed stream into memory first.
+		//
 
-		ReadFile(
-			&Compressed[ 0 ],
-			CompressHeader.CompressedSize,
-			"Compressed walkmesh stream");
+		if (File.IsMapped( ))
+		{
+			CompressedData = File.ReadFileView(
+				CompressHeader.CompressedSize,
+				"Compressed walkmesh stream");
+		}
+		else
+		{
+			Compressed.resize( CompressHeader.CompressedSize );
+
+			ReadFile(
+				File,
+				&Compressed[ 0 ],
+				CompressHeader.CompressedSize,
+				"Compressed walkmesh stream");
+
+			CompressedData = &Compressed[ 0 ];
+		}
 
 		//
 		// Decompress the compressed stream.
 		//
 
 		if (!CompressContext.Uncompress(
-			&Compressed[ 0 ],
-			Compressed.size( ),
+			CompressedData,
+			CompressHeader.CompressedSize,
 			Buffer))
 		{
 			throw std::exception( "Walkmesh decompression failed." );
@@ -527,6 +1128,7 @@ Environment:
 
 		BufferReader.Buffer = &Buffer[ 0 ];
 		BufferReader.Size   = Size;
+		BufferReader.File   = NULL;
 
 		//
 		// Read the actual ASWM header.
@@ -560,6 +1162,7 @@ Environment:
 
 		BufferReader.Buffer = NULL;
 		BufferReader.Size   = Size;
+		BufferReader.File   = &File;
 
 		//
 		// Read the remainder of the ASWM header.
@@ -584,6 +1187,24 @@ Environment:
 			"Unsupported AreaSurfaceWalkmesh resource version.");
 	}
 
+	//
+	// Preallocate the point, edge and triangle arrays.
+	//
+
+	m_Walkmesh.Reserve(
+		CapElementCount(
+			WalkmeshHeader.PointCount,
+			BufferReader.Size,
+			3 * sizeof( float )),
+		CapElementCount(
+			WalkmeshHeader.EdgeCount,
+			BufferReader.Size,
+			sizeof( AreaSurfaceMesh::SurfaceMeshEdge )),
+		CapElementCount(
+			WalkmeshHeader.TriangleCount,
+			BufferReader.Size,
+			sizeof( AreaSurfaceMesh::SurfaceMeshTriangle )));
+
 	//
 	// Read points.
 	//
@@ -684,6 +1305,16 @@ Environment:
 	// Tile data.  Only used to calculate pathing.
 	//
 
+	if (m_Walkmesh.GetTileGridHeight( ) != 0)
+	{
+		m_Walkmesh.ReserveTileSurfaceMeshes(
+			CapElementCount(
+				m_Walkmesh.GetTileGridWidth( ),
+				BufferReader.Size / m_Walkmesh.GetTileGridHeight( ),
+				sizeof( AreaSurfaceMesh::TileSurfaceMeshHeader )) *
+			m_Walkmesh.GetTileGridHeight( ));
+	}
+
 	FaceOffset = 0;
 
 	for (unsigned long i = 0; i < m_Walkmesh.GetTileGridHeight( ); i += 1)
@@ -959,37 +1590,6 @@ Environment:
 				sizeof( AreaSurfaceMesh::IslandPathNodeVec::value_type ),
 			"IslandPathTable");
 	}
-
-	//
-	// Validate walkmesh data now that we've read it all in.
-	//
-
-	m_Walkmesh.Validate( );
-
-	//
-	// Set up the face base pointers for each tile surface mesh.
-	//
-
-	for (AreaSurfaceMesh::TileSurfaceMeshVec::iterator it = m_Walkmesh.GetTileSurfaceMeshes( ).begin( );
-	     it != m_Walkmesh.GetTileSurfaceMeshes( ).end( );
-	     ++it)
-	{
-		if (it->m_NumFaces != 0)
-			it->m_Faces = &m_Walkmesh.GetTriangles( )[ it->m_FaceOffset ];
-	}
-
-	//
-	// Calculate bounding boxes.
-	//
-
-	m_Walkmesh.CalcBoundingBoxes( );
-
-	//
-	// Register the mesh with the mesh manager as we have initialized it
-	// proper.
-	//
-
-	m_Walkmesh.RegisterMesh( MeshMgr );
 }
 
 
@@ -1063,20 +1663,24 @@ Environment:
 void
 TrxFileReader::DecodeWater(
 	nwn2dev__in PCRESOURCE_HEADER ResHeader,
-	nwn2dev__in MeshManager & MeshMgr
+	nwn2dev__in FileWrapper & File,
+	__inout AreaWaterMesh & WaterMesh
 	)
 /*++
 
 Routine Description:
 
-	This routine decodes an area water mesh.
+	This routine decodes an area water mesh.  The height map update and mesh
+	registration are performed by the caller.
 
 Arguments:
 
 	ResHeader - Supplies the current resource object header.
-		
-	MeshMgr - Supplies the mesh manager to which all child meshes are
-	          registered to.
+
+	File - Supplies the file to read from, which is positioned at the data
+	       of the resource.
+
+	WaterMesh - Supplies the (empty) water mesh to fill in.
 
 Return Value:
 
@@ -1084,7 +1688,8 @@ Return Value:
 
 Environment:
 
-	User mode, seeked to the start of the resource in question.
+	User mode, seeked to the start of the resource in question.  The routine
+	may run concurrently with the decoding of other resources of the file.
 
 --*/
 {
@@ -1096,21 +1701,23 @@ Environment:
 	if (m_LoadOnlyDimensions)
 		return;
 
-	//
-	// Create a new water mesh object and begin filling it out.
-	//
-
-	m_WaterMesh.push_back( AreaWaterMesh( ) );
-
-	AreaWaterMesh & WaterMesh = m_WaterMesh.back( );
-
 	if (ResHeader->Length < sizeof( WaterHeader ))
 		throw std::runtime_error( "Water length too small." );
 
-	ReadFile( &WaterHeader, sizeof( WaterHeader ), "Area Water" );
+	ReadFile( File, &WaterHeader, sizeof( WaterHeader ), "Area Water" );
 
 	WaterMesh.SetWaterColor( WaterHeader.WaterColor );
 
+	WaterMesh.Reserve(
+		CapElementCount(
+			WaterHeader.VertexCount,
+			ResHeader->Length,
+			sizeof( AreaWaterMesh::WaterVertex )),
+		CapElementCount(
+			WaterHeader.TriangleCount,
+			ResHeader->Length,
+			sizeof( AreaWaterMesh::WaterFace )));
+
 	//
 	// Read verticies.
 	//
@@ -1119,7 +1726,7 @@ Environment:
 	{
 		AreaWaterMesh::WaterVertex Vertex;
 
-		ReadFile( &Vertex, sizeof( Vertex ), "Water Vertex" );
+		ReadFile( File, &Vertex, sizeof( Vertex ), "Water Vertex" );
 
 		WaterMesh.AddWaterVertex( Vertex );
 	}
@@ -1132,7 +1739,7 @@ Environment:
 	{
 		AreaWaterMesh::WaterFace Face;
 
-		ReadFile( &Face, sizeof( Face ), "Water Face" );
+		ReadFile( File, &Face, sizeof( Face ), "Water Face" );
 
 		WaterMesh.AddWaterFace( Face );
 	}
@@ -1141,7 +1748,7 @@ Environment:
 	// Bitmap.
 	//
 
-	ReadFile( &Bitmap, sizeof( Bitmap ), "Water Bitmap" );
+	ReadFile( File, &Bitmap, sizeof( Bitmap ), "Water Bitmap" );
 
 	WaterMesh.SetWaterBitmap( Bitmap );
 
@@ -1149,10 +1756,10 @@ Environment:
 	// Image.
 	//
 
-	ReadDdsImage( WaterMesh.GetImage( ) );
+	ReadDdsImage( File, WaterMesh.GetImage( ) );
 
-	ReadFile( &X, sizeof( X ), "Water X" );
-	ReadFile( &Y, sizeof( Y ), "Water Y" );
+	ReadFile( File, &X, sizeof( X ), "Water X" );
+	ReadFile( File, &Y, sizeof( Y ), "Water Y" );
 
 	WaterMesh.SetWaterX( X );
 	WaterMesh.SetWaterY( Y );
@@ -1162,33 +1769,29 @@ Environment:
 	//
 
 	WaterMesh.Validate( );
-
-	//
-	// Update the height map with new water information.
-	//
-
-	m_HeightMap.ComputeWaterHeights( WaterMesh );
-
-	WaterMesh.RegisterMesh( MeshMgr );
 }
 
 void
 TrxFileReader::DecodeTerrain(
 	nwn2dev__in PCRESOURCE_HEADER ResHeader,
-	nwn2dev__in MeshManager & MeshMgr
+	nwn2dev__in FileWrapper & File,
+	__inout AreaTerrainMesh & TerrainMesh
 	)
 /*++
 
 Routine Description:
 
-	This routine decodes an area terrain mesh.
+	This routine decodes an area terrain mesh.  The height map update and
+	mesh registration are performed by the caller.
 
 Arguments:
 
 	ResHeader - Supplies the current resource object header.
-		
-	MeshMgr - Supplies the mesh manager to which all child meshes are
-	          registered to.
+
+	File - Supplies the file to read from, which is positioned at the data
+	       of the resource.
+
+	TerrainMesh - Supplies the (empty) terrain mesh to fill in.
 
 Return Value:
 
@@ -1196,7 +1799,8 @@ Return Value:
 
 Environment:
 
-	User mode, seeked to the start of the resource in question.
+	User mode, seeked to the start of the resource in question.  The routine
+	may run concurrently with the decoding of other resources of the file.
 
 --*/
 {
@@ -1209,19 +1813,21 @@ Environment:
 	if (ResHeader->Length < sizeof( TerrainHeader ))
 		throw std::runtime_error( "Terrain length too small." );
 
-	ReadFile( &TerrainHeader, sizeof( TerrainHeader ), "Area Terrain" );
-
-	//
-	// Create a new terrain mesh object and begin filling it out.
-	//
-
-	m_TerrainMesh.push_back( AreaTerrainMesh( ) );
-
-	AreaTerrainMesh & TerrainMesh = m_TerrainMesh.back( );
+	ReadFile( File, &TerrainHeader, sizeof( TerrainHeader ), "Area Terrain" );
 
 	TerrainMesh.SetTextures( &TerrainHeader.Texture[ 0 ].Name );
 	TerrainMesh.SetTextureColor( &TerrainHeader.TextureColor[ 0 ] );
 
+	TerrainMesh.Reserve(
+		CapElementCount(
+			TerrainHeader.VertexCount,
+			ResHeader->Length,
+			sizeof( AreaTerrainMesh::TerrainVertex )),
+		CapElementCount(
+			TerrainHeader.TriangleCount,
+			ResHeader->Length,
+			sizeof( AreaTerrainMesh::TerrainFace )));
+
 	//
 	// Read verticies.
 	//
@@ -1230,7 +1836,7 @@ Environment:
 	{
 		AreaTerrainMesh::TerrainVertex Vertex;
 
-		ReadFile( &Vertex, sizeof( Vertex ), "Terrain Vertex" );
+		ReadFile( File, &Vertex, sizeof( Vertex ), "Terrain Vertex" );
 
 		TerrainMesh.AddTerrainVertex( Vertex );
 	}
@@ -1243,7 +1849,7 @@ Environment:
 	{
 		AreaTerrainMesh::TerrainFace Face;
 
-		ReadFile( &Face, sizeof( Face ), "Terrain Face" );
+		ReadFile( File, &Face, sizeof( Face ), "Terrain Face" );
 
 		TerrainMesh.AddTerrainFace( Face );
 	}
@@ -1252,22 +1858,22 @@ Environment:
 	// Images.
 	//
 
-	ReadDdsImage( TerrainMesh.GetImage( 0 ) );
-	ReadDdsImage( TerrainMesh.GetImage( 1 ) );
+	ReadDdsImage( File, TerrainMesh.GetImage( 0 ) );
+	ReadDdsImage( File, TerrainMesh.GetImage( 1 ) );
 
-	ReadFile( &GrassCount, sizeof( GrassCount ), "Terrain Grass Count" );
+	ReadFile( File, &GrassCount, sizeof( GrassCount ), "Terrain Grass Count" );
 
 	for (unsigned long i = 0; i < GrassCount; i += 1)
 	{
 		AreaTerrainMesh::TerrainGrass Grass;
 
-		ReadFile( &Grass.Header, sizeof( Grass.Header ), "Grass Header" );
+		ReadFile( File, &Grass.Header, sizeof( Grass.Header ), "Grass Header" );
 
 		for (unsigned long j = 0; j < Grass.Header.Blades; j += 1)
 		{
 			AreaTerrainMesh::TerrainGrassBlade Blade;
 
-			ReadFile( &Blade, sizeof( Blade ), "Grass Blade" );
+			ReadFile( File, &Blade, sizeof( Blade ), "Grass Blade" );
 
 			Grass.Blades.push_back( Blade );
 		}
@@ -1276,14 +1882,6 @@ Environment:
 	}
 
 	TerrainMesh.Validate( );
-
-	//
-	// Update the height map with new terrain information.
-	//
-
-	m_HeightMap.ComputeHeights( TerrainMesh );
-
-	TerrainMesh.RegisterMesh( MeshMgr );
 }
 
 void
@@ -46,6 +46,8 @@ Abstract:
 #include "WalkMesh.h"
 #include "ModelInstance.h"
 #include "ModelCollider.h"
+#include "ParallelWorkQueue.h"
+#include "AreaSurfaceMeshCache.h"
 
 class MeshManager;
 struct IDebugTextOut;
@@ -89,9 +91,42 @@ public:
 
 	typedef swutil::SharedPtr< TrxFileReader > Ptr;
 
+	typedef std::vector< Ptr > PtrVec;
+	typedef std::vector< std::string > FileNameVec;
+
+	//
+	// Define load flags that control how a Trx file is loaded.
+	//
+	// LoadFlagSerialDecode - Decode the resources of the file on the calling
+	//                        thread only, instead of on the thread pool.
+	//
+	// LoadFlagDeferMeshRegistration - Do not register the decoded meshes with
+	//                                 the mesh manager.  The caller must then
+	//                                 call RegisterMeshes before the meshes
+	//                                 are used.
+	//
+	// LoadFlagTrustWalkmeshCache - Skip validation of walkmeshes loaded from
+	//                              the walkmesh cache.  Only the structure of
+	//                              the cache file is checked.
+	//
+
+	enum
+	{
+		LoadFlagSerialDecode          = 0x00000001,
+		LoadFlagDeferMeshRegistration = 0x00000002,
+		LoadFlagTrustWalkmeshCache    = 0x00000004
+	};
+
 	//
 	// Load and parse a Trx file, raises an std::exception on failure.
 	//
+	// In TRX mode, the area surface walkmesh, terrain and water resources are
+	// decoded in parallel on the thread pool unless LoadFlagSerialDecode is
+	// set.
+	//
+	// If a walkmesh cache directory is supplied (TRX mode), decoded walkmeshes
+	// are stored in, and loaded from, AreaSurfaceMeshCache files there.
+	//
 
 	TrxFileReader(
 		nwn2dev__in MeshManager & MeshMgr,
@@ -99,12 +134,45 @@ public:
 		nwn2dev__in bool LoadOnlyDimensions,
 		nwn2dev__in MODE Mode = ModeTRX,
 		__in_opt IDebugTextOut * TextWriter = NULL,
-		nwn2dev__in bool RefuseDisplayOnlyModels = false
+		nwn2dev__in bool RefuseDisplayOnlyModels = false,
+		nwn2dev__in ULONG LoadFlags = 0,
+		__in_opt const char * WalkmeshCacheDirectory = NULL
 		);
 
 	~TrxFileReader(
 		);
 
+	//
+	// Load a batch of Trx files (in TRX mode), one file per thread pool work
+	// item, and return the readers in the same order as the file names.  Mesh
+	// registration is performed serially once all files have been decoded.
+	// An std::exception is raised if any file could not be loaded.
+	//
+
+	static
+	void
+	LoadAreas(
+		nwn2dev__in MeshManager & MeshMgr,
+		nwn2dev__in const FileNameVec & FileNames,
+		nwn2dev__in bool LoadOnlyDimensions,
+		nwn2dev__out PtrVec & Areas,
+		__in_opt IDebugTextOut * TextWriter = NULL,
+		nwn2dev__in bool RefuseDisplayOnlyModels = false,
+		nwn2dev__in ULONG LoadFlags = 0,
+		__in_opt const char * WalkmeshCacheDirectory = NULL
+		);
+
+	//
+	// Register meshes that were decoded with LoadFlagDeferMeshRegistration
+	// with the mesh manager.  The routine must not run concurrently with any
+	// other use of the mesh manager.
+	//
+
+	void
+	RegisterMeshes(
+		nwn2dev__in MeshManager & MeshMgr
+		);
+
 	//
 	// Width, in tiles.  (9 units per tile.)
 	//
@@ -421,12 +489,48 @@ private:
 
 	typedef struct _READER_CONTEXT
 	{
-		unsigned char * Buffer;
-		size_t          Size;
+		const unsigned char * Buffer;
+		size_t                Size;
+		FileWrapper         * File;
 	} READER_CONTEXT, * PREADER_CONTEXT;
 
 	typedef const struct _READER_CONTEXT * PCREADER_CONTEXT;
 
+	//
+	// Define a resource decode work item.  Each work item reads from its own
+	// FileWrapper so that work items may run concurrently against the mapped
+	// view of the file.
+	//
+
+	typedef struct _DECODE_WORK_ITEM
+	{
+		TrxFileReader * Reader;
+		ULONG           ResourceTypeId;
+		ULONG           ResourceLength;
+		ULONGLONG       DataOffset;
+		size_t          TargetIndex;
+	} DECODE_WORK_ITEM, * PDECODE_WORK_ITEM;
+
+	typedef const struct _DECODE_WORK_ITEM * PCDECODE_WORK_ITEM;
+
+	typedef std::vector< DECODE_WORK_ITEM > DecodeWorkItemVec;
+
+	//
+	// Define the area batch load work item.
+	//
+
+	typedef struct _AREA_LOAD_WORK_ITEM
+	{
+		MeshManager       * MeshMgr;
+		const std::string * FileName;
+		bool                LoadOnlyDimensions;
+		IDebugTextOut     * TextWriter;
+		bool                RefuseDisplayOnlyModels;
+		ULONG               LoadFlags;
+		const char        * WalkmeshCacheDirectory;
+		Ptr                 Area;
+	} AREA_LOAD_WORK_ITEM, * PAREA_LOAD_WORK_ITEM;
+
 	//
 	// Define the main parse entrypoint.
 	//
@@ -436,6 +540,36 @@ private:
 		nwn2dev__in MeshManager & MeshMgr
 		);
 
+	//
+	// Decode the queued TRX area resources, potentially in parallel, and then
+	// publish the results in resource directory order.
+	//
+
+	void
+	DecodeAreaResources(
+		nwn2dev__in MeshManager & MeshMgr,
+		nwn2dev__in DecodeWorkItemVec & WorkItems
+		);
+
+	//
+	// Define the thread pool callbacks for resource decoding and batch area
+	// loading.
+	//
+
+	static
+	void
+	__stdcall
+	DecodeWorkItemRoutine(
+		nwn2dev__in void * Context
+		);
+
+	static
+	void
+	__stdcall
+	AreaLoadWorkItemRoutine(
+		nwn2dev__in void * Context
+		);
+
 	//
 	// Define the area surface walkmesh reader.
 	//
@@ -443,7 +577,13 @@ private:
 	void
 	DecodeAreaSurfaceWalkmesh(
 		nwn2dev__in PCRESOURCE_HEADER ResHeader,
-		nwn2dev__in MeshManager & MeshMgr
+		nwn2dev__in FileWrapper & File
+		);
+
+	void
+	ParseAreaSurfaceWalkmesh(
+		nwn2dev__in PCRESOURCE_HEADER ResHeader,
+		nwn2dev__in FileWrapper & File
 		);
 
 	//
@@ -472,7 +612,8 @@ private:
 	void
 	DecodeWater(
 		nwn2dev__in PCRESOURCE_HEADER ResHeader,
-		nwn2dev__in MeshManager & MeshMgr
+		nwn2dev__in FileWrapper & File,
+		__inout AreaWaterMesh & WaterMesh
 		);
 
 	//
@@ -482,7 +623,8 @@ private:
 	void
 	DecodeTerrain(
 		nwn2dev__in PCRESOURCE_HEADER ResHeader,
-		nwn2dev__in MeshManager & MeshMgr
+		nwn2dev__in FileWrapper & File,
+		__inout AreaTerrainMesh & TerrainMesh
 		);
 
 	//
@@ -578,6 +720,19 @@ private:
 		return m_FileWrapper.ReadFile( Buffer, Length, Description );
 	}
 
+	inline
+	static
+	void
+	ReadFile(
+		nwn2dev__in FileWrapper & File,
+		__out_bcount( Length ) void * Buffer,
+		nwn2dev__in size_t Length,
+		nwn2dev__in const char * Description
+		)
+	{
+		return File.ReadFile( Buffer, Length, Description );
+	}
+
 	//
 	// ReadFile wrapper for DDS images.
 	//
@@ -587,17 +742,28 @@ private:
 	ReadDdsImage(
 		nwn2dev__out DdsImage & Image
 		)
+	{
+		ReadDdsImage( m_FileWrapper, Image );
+	}
+
+	inline
+	static
+	void
+	ReadDdsImage(
+		nwn2dev__in FileWrapper & File,
+		nwn2dev__out DdsImage & Image
+		)
 	{
 		Trx::DDS_FILE                Header;
 		unsigned long                Length;
 		std::vector< unsigned char > Data;
 
-		ReadFile( &Length, sizeof( Length ), "DDS Image Length" );
+		ReadFile( File, &Length, sizeof( Length ), "DDS Image Length" );
 
 		if (Length < sizeof( Header ))
 			throw std::exception( "DDS Image Length too short" );
 
-		ReadFile( &Header, sizeof( Header ), "DDS Header" );
+		ReadFile( File, &Header, sizeof( Header ), "DDS Header" );
 
 		Image.SetDdsHeader( Header );
 
@@ -610,10 +776,24 @@ private:
 			if (ImgLen > 64 * 1024 * 1024)
 				throw std::exception( "DDS Image too long" );
 
-			Data.resize( ImgLen );
-			ReadFile( &Data[ 0 ], ImgLen, "DDS Image Data" );
-
-			Image.SetImage( &Data[ 0 ], Data.size( ) );
+			//
+			// Copy straight out of the mapped view if we have one, instead of
+			// staging the image data through a temporary buffer.
+			//
+
+			if (File.IsMapped( ))
+			{
+				Image.SetImage(
+					File.ReadFileView( ImgLen, "DDS Image Data" ),
+					ImgLen);
+			}
+			else
+			{
+				Data.resize( ImgLen );
+				ReadFile( File, &Data[ 0 ], ImgLen, "DDS Image Data" );
+
+				Image.SetImage( &Data[ 0 ], Data.size( ) );
+			}
 		}
 
 		Image.Validate( );
@@ -638,6 +818,7 @@ private:
 	//
 
 	inline
+	static
 	void
 	ReadReaderContext(
 		__inout PREADER_CONTEXT ReaderContext,
@@ -671,7 +852,7 @@ private:
 		//
 
 		if (ReaderContext->Buffer == NULL)
-			ReadFile( Buffer, Length, Description );
+			ReadFile( *ReaderContext->File, Buffer, Length, Description );
 		else
 		{
 			memcpy( Buffer, ReaderContext->Buffer, Length );
@@ -739,10 +920,11 @@ private:
 	AreaHeightMap             m_HeightMap;
 
 	//
-	// Define the parse mode.
+	// Define the parse mode and load flags.
 	//
 
 	MODE                      m_Mode;
+	ULONG                     m_LoadFlags;
 
 	IDebugTextOut           * m_TextWriter;
 
@@ -759,6 +941,19 @@ private:
 
 	bool                      m_RefuseDisplayOnlyModels;
 
+	//
+	// Record whether the decoded meshes still need to be registered with the
+	// mesh manager.
+	//
+
+	bool                      m_RegistrationPending;
+
+	//
+	// Define the decoded walkmesh cache directory, if any.
+	//
+
+	std::string               m_WalkmeshCacheDirectory;
+
 };
 
 #endif
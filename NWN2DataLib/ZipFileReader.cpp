@@ -12,22 +12,33 @@ Abstract:
 	ZipFileReader allows resources to be demand-loaded from .zip archives as
 	opposed to ERF files.
 
+	The reader parses the central directory of the archive itself and reads
+	member data with positional reads, rather than driving the minizip
+	sequential state machine; this allows random access and concurrent reads
+	against a single archive.
+
 --*/
 
 #include "Precomp.h"
 #include "ZipFileReader.h"
-#include "FileWrapper.h"
+#include "ParallelWorkQueue.h"
+
+#include <algorithm>
 
-#define STRICTZIPUNZIP
 #include "../zlib/zlib.h"
-#define _ZLIB_H // unzip.h mistakenly assumes _ZLIB_H instead of ZLIB_H
-#include "../zlib/contrib/minizip/unzip.h"
 
-static void x_fill_fopen_filefunc (zlib_filefunc_def* pzlib_filefunc_def);
+//
+// Define the signatures of the zip structures that the reader consumes.
+//
+
+#define ZIP_END_OF_CENTRAL_DIRECTORY_SIGNATURE 0x06054B50
+#define ZIP_CENTRAL_FILE_HEADER_SIGNATURE      0x02014B50
+#define ZIP_LOCAL_FILE_HEADER_SIGNATURE        0x04034B50
 
 template< typename ResRefT >
 ZipFileReader< ResRefT >::ZipFileReader(
-	nwn2dev__in const std::string & ArchiveName
+	nwn2dev__in const std::string & ArchiveName,
+	nwn2dev__in size_t CacheLimit /* = DEFAULT_CACHE_LIMIT */
 	)
 /*++
 
@@ -40,6 +51,9 @@ Arguments:
 
 	ArchiveName - Supplies the name of the .zip archive to access.
 
+	CacheLimit - Supplies the maximum count of bytes of decompressed member
+	             data to retain in the member cache.
+
 Return Value:
 
 	The newly constructed object.
@@ -49,19 +63,25 @@ Environment:
 	User mode.
 
 --*/
-: m_Archive( NULL ),
-  m_FileOpened( false ),
-  m_OpenFileHandle( INVALID_FILE ),
-  m_CurrentOffset( 0 ),
-  m_FileName( ArchiveName )
+: m_File( INVALID_HANDLE_VALUE ),
+  m_FileSize( 0 ),
+  m_FileName( ArchiveName ),
+  m_NextFileHandle( 1 ),
+  m_CacheSize( 0 ),
+  m_CacheLimit( CacheLimit )
 {
-	//
-	// Create directory file entries as necessary.
-	//
+	LARGE_INTEGER FileSize;
 
-	m_Archive = OpenArchive( ArchiveName );
+	m_File = CreateFileA(
+		ArchiveName.c_str( ),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS,
+		NULL);
 
-	if (m_Archive == NULL)
+	if (m_File == INVALID_HANDLE_VALUE)
 	{
 		try
 		{
@@ -79,7 +99,34 @@ Environment:
 		}
 	}
 
-	ScanArchive( m_Archive );
+	if (!GetFileSizeEx( m_File, &FileSize ))
+	{
+		CloseHandle( m_File );
+		m_File = INVALID_HANDLE_VALUE;
+
+		throw std::runtime_error( "GetFileSizeEx failed" );
+	}
+
+	m_FileSize = (ULONGLONG) FileSize.QuadPart;
+
+	InitializeCriticalSection( &m_Lock );
+
+	//
+	// Create directory file entries as necessary.
+	//
+
+	try
+	{
+		ScanArchive( );
+	}
+	catch (...)
+	{
+		DeleteCriticalSection( &m_Lock );
+		CloseHandle( m_File );
+		m_File = INVALID_HANDLE_VALUE;
+
+		throw;
+	}
 }
 
 template< typename ResRefT >
@@ -105,11 +152,25 @@ Environment:
 
 --*/
 {
-	if (m_Archive != NULL)
+	for (typename InflateContextVec::iterator it = m_InflateContexts.begin( );
+	     it != m_InflateContexts.end( );
+	     ++it)
+	{
+		z_stream * Stream = (z_stream *) *it;
+
+		inflateEnd( Stream );
+		delete Stream;
+	}
+
+	m_InflateContexts.clear( );
+
+	DeleteCriticalSection( &m_Lock );
+
+	if (m_File != INVALID_HANDLE_VALUE)
 	{
-		CloseArchive( m_Archive );
+		CloseHandle( m_File );
 
-		m_Archive = NULL;
+		m_File = INVALID_HANDLE_VALUE;
 	}
 }
 
@@ -125,9 +186,6 @@ Routine Description:
 
 	This routine logically opens a file within the archive.
 
-	File handles are simply file identifiers for purposes of accessing the .zip
-	archive.
-
 Arguments:
 
 	FileName - Supplies the name of the resource file to open.
@@ -156,7 +214,7 @@ Environment:
 	//
 	// Just pass the request on to OpenFileByIndex, so that it may handle the
 	// request in a uniform fashion.
-	// 
+	//
 
 	return OpenFileByIndex( Entry - &m_DirectoryEntries[ 0 ] );
 }
@@ -172,10 +230,8 @@ Routine Description:
 
 	This routine logically opens a file within the archive.
 
-	File handles are simply file identifiers for purposes of accessing the .zip
-	archive.
-
-	Currently, the .zip file reader supports only one concurrent open file.
+	Any number of files may be open concurrently.  No member data is read
+	until the first call to ReadEncapsulatedFile.
 
 Arguments:
 
@@ -195,38 +251,50 @@ Environment:
 
 --*/
 {
-	FileHandle   Handle;
-	int          Error;
-	unz_file_pos Pos;
-
-	if (m_FileOpened)
-		return INVALID_FILE;
+	OpenFileContext Context;
+	FileHandle      Handle;
 
 	if ((size_t) FileIndex >= m_DirectoryEntries.size( ))
 		return INVALID_FILE;
 
+	const DirectoryEntry & Entry = m_DirectoryEntries[ (size_t) FileIndex ];
+
 	//
-	// Seek to the start of the file and open it.
+	// Only stored and deflated members that are not encrypted can be read.
 	//
 
-	Handle = m_DirectoryEntries[ (size_t) FileIndex ].FileHandleToReturn;
+	if (Entry.Flags & ZIP_FLAG_ENCRYPTED)
+		return INVALID_FILE;
 
-	Pos.pos_in_zip_directory = (uLong) (((Handle - 1) >>  0) & 0xFFFFFFFF);
-	Pos.num_of_file          = (uLong) (((Handle - 1) >> 32) & 0xFFFFFFFF);
+	if ((Entry.CompressionMethod != ZIP_METHOD_STORED) &&
+	    (Entry.CompressionMethod != ZIP_METHOD_DEFLATED))
+		return INVALID_FILE;
 
-	Error = unzGoToFilePos( (unzFile) m_Archive, &Pos );
+	try
+	{
+		Context.EntryIndex = (size_t) FileIndex;
+		Context.DataOffset = GetMemberDataOffset( Entry );
 
-	if (Error)
-		return INVALID_FILE;
+		EnterCriticalSection( &m_Lock );
 
-	Error = unzOpenCurrentFile( (unzFile) m_Archive );
+		try
+		{
+			Handle = m_NextFileHandle++;
 
-	if (Error)
-		return INVALID_FILE;
+			m_OpenFiles.insert( typename OpenFileMap::value_type( Handle, Context ) );
+		}
+		catch (...)
+		{
+			LeaveCriticalSection( &m_Lock );
+			throw;
+		}
 
-	m_FileOpened     = true;
-	m_OpenFileHandle = Handle;
-	m_CurrentOffset  = 0;
+		LeaveCriticalSection( &m_Lock );
+	}
+	catch (std::exception)
+	{
+		return INVALID_FILE;
+	}
 
 	return Handle;
 }
@@ -243,9 +311,6 @@ Routine Description:
 	This routine logically closes an encapsulated sub-file within the .zip
 	archive.
 
-	Currently, file handles are implemented as simply file offsets within the
-	.zip archive.
-
 Arguments:
 
 	File - Supplies the file handle to close.
@@ -262,24 +327,36 @@ Environment:
 
 --*/
 {
-	//
-	// Ensure that the file handle is legal before closing the current file.
-	//
+	ByteVecPtr Contents;
+	bool       Closed;
 
 	if (File == INVALID_FILE)
 		return false;
 
-	if (!m_FileOpened)
-		return false;
+	EnterCriticalSection( &m_Lock );
 
-	if (File != m_OpenFileHandle)
-		return false;
+	typename OpenFileMap::iterator it = m_OpenFiles.find( File );
 
-	unzCloseCurrentFile( (unzFile) m_Archive );
+	if (it != m_OpenFiles.end( ))
+	{
+		//
+		// Release the contents reference outside of the lock, as it may be
+		// the last reference to the decompressed data.
+		//
 
-	m_FileOpened = false;
+		Contents = it->second.Contents;
 
-	return true;
+		m_OpenFiles.erase( it );
+		Closed = true;
+	}
+	else
+	{
+		Closed = false;
+	}
+
+	LeaveCriticalSection( &m_Lock );
+
+	return Closed;
 }
 
 template< typename ResRefT >
@@ -297,7 +374,9 @@ Routine Description:
 
 	This routine logically reads an encapsulated sub-file within the .zip file.
 
-	Presently, only sequential scan is supported for .zip files.
+	Stored members are read directly from the archive.  Deflated members are
+	inflated in full on first read (or taken from the member cache), after
+	which reads at any offset are serviced from memory.
 
 Arguments:
 
@@ -324,34 +403,89 @@ Environment:
 
 --*/
 {
-	int Read;
-
-	if (BytesToRead > ULONG_MAX)
-		BytesToRead = ULONG_MAX;
+	OpenFileContext Context;
 
 	if (File == INVALID_FILE)
 		return false;
 
-	if (!m_FileOpened)
+	EnterCriticalSection( &m_Lock );
+
+	typename OpenFileMap::const_iterator it = m_OpenFiles.find( File );
+
+	if (it == m_OpenFiles.end( ))
+	{
+		LeaveCriticalSection( &m_Lock );
 		return false;
+	}
+
+	Context = it->second;
+
+	LeaveCriticalSection( &m_Lock );
 
-	if (File != m_OpenFileHandle)
+	const DirectoryEntry & Entry = m_DirectoryEntries[ Context.EntryIndex ];
+
+	if (Offset >= Entry.UncompressedSize)
 		return false;
 
-	if (m_CurrentOffset != Offset)
+	if (BytesToRead > Entry.UncompressedSize - Offset)
+		BytesToRead = Entry.UncompressedSize - Offset;
+
+	if (BytesToRead == 0)
 		return false;
 
-	Read = unzReadCurrentFile(
-		(unzFile) m_Archive,
-		Buffer,
-		(unsigned) BytesToRead);
+	ResourceStatistics::ScopedOperation StatOp(
+		m_Statistics,
+		m_StatSource,
+		ResourceStatistics::OpRead);
+
+	try
+	{
+		if (Entry.CompressionMethod == ZIP_METHOD_STORED)
+		{
+			ReadArchive(
+				Context.DataOffset + Offset,
+				Buffer,
+				BytesToRead,
+				"Stored member data");
+		}
+		else
+		{
+			if (Context.Contents.get( ) == NULL)
+			{
+				Context.Contents = GetMemberContents(
+					Context.EntryIndex,
+					Context.DataOffset);
+
+				//
+				// Attach the contents to the handle so that subsequent reads
+				// do not depend on the member remaining in the cache.
+				//
+
+				EnterCriticalSection( &m_Lock );
+
+				typename OpenFileMap::iterator it2 = m_OpenFiles.find( File );
 
-	if (Read <= 0)
+				if (it2 != m_OpenFiles.end( ))
+					it2->second.Contents = Context.Contents;
+
+				LeaveCriticalSection( &m_Lock );
+			}
+
+			memcpy(
+				Buffer,
+				&(*Context.Contents)[ Offset ],
+				BytesToRead);
+		}
+	}
+	catch (std::exception)
+	{
+		StatOp.Cancel( );
 		return false;
+	}
 
-	*BytesRead = (size_t) Read;
+	*BytesRead = BytesToRead;
 
-	m_CurrentOffset += *BytesRead;
+	StatOp.SetBytes( BytesToRead );
 
 	return true;
 }
@@ -387,32 +521,23 @@ Environment:
 
 --*/
 {
-	unz_file_info FileInfo;
-	int           Error;
+	size_t Size;
 
 	if (File == INVALID_FILE)
-		return false;
+		return 0;
 
-	if (!m_FileOpened)
-		return false;
+	EnterCriticalSection( &m_Lock );
 
-	if (File != m_OpenFileHandle)
-		return false;
+	typename OpenFileMap::const_iterator it = m_OpenFiles.find( File );
 
-	Error = unzGetCurrentFileInfo(
-		(unzFile) m_Archive,
-		&FileInfo,
-		NULL,
-		0,
-		NULL,
-		0,
-		NULL,
-		0);
+	if (it != m_OpenFiles.end( ))
+		Size = m_DirectoryEntries[ it->second.EntryIndex ].UncompressedSize;
+	else
+		Size = 0;
 
-	if (Error)
-		return false;
+	LeaveCriticalSection( &m_Lock );
 
-	return FileInfo.uncompressed_size;
+	return Size;
 }
 
 template< typename ResRefT >
@@ -481,54 +606,23 @@ Environment:
 
 --*/
 {
-	char   FileName[ 260 ];
-	char   Name[ MAX_PATH ];
-	char   Ext[ 32 ];
-	int    Error;
+	ResType Type;
 
 	if (File == INVALID_FILE)
 		return NWN::ResINVALID;
 
-	if (!m_FileOpened)
-		return NWN::ResINVALID;
-
-	if (File != m_OpenFileHandle)
-		return NWN::ResINVALID;
-
-	strcpy_s( FileName, "Z:\\" ); // Bogus, for splitpath.
-
-	Error = unzGetCurrentFileInfo(
-		(unzFile) m_Archive,
-		NULL,
-		FileName + 3,
-		sizeof( FileName ) - 3,
-		NULL,
-		0,
-		NULL,
-		0);
+	EnterCriticalSection( &m_Lock );
 
-	if (Error)
-		return NWN::ResINVALID;
-
-	FileName[ sizeof( FileName ) - sizeof( FileName[ 0 ] ) ] = '\0';
+	typename OpenFileMap::const_iterator it = m_OpenFiles.find( File );
 
-	_strlwr( FileName );
+	if (it != m_OpenFiles.end( ))
+		Type = m_DirectoryEntries[ it->second.EntryIndex ].Type;
+	else
+		Type = NWN::ResINVALID;
 
-	if (_splitpath_s(
-		FileName,
-		NULL,
-		0,
-		NULL,
-		0,
-		Name,
-		sizeof( Name ),
-		Ext,
-		sizeof( Ext )) || (Ext[ 0 ] == '\0'))
-	{
-		return NWN::ResINVALID;
-	}
+	LeaveCriticalSection( &m_Lock );
 
-	return ExtToResType( Ext + 1 );
+	return Type;
 }
 
 template< typename ResRefT >
@@ -545,9 +639,6 @@ Routine Description:
 	This routine reads an encapsulated file directory entry, returning the name
 	and type of a particular resource.  The enumeration is stable across calls.
 
-	Currently, no files may be opened at the time of this call as the call
-	requires opening a file handle.
-
 Arguments:
 
 	FileIndex - Supplies the index into the logical directory entry to reutrn.
@@ -610,23 +701,32 @@ Environment:
 }
 
 template< typename ResRefT >
-typename ZipFileReader< ResRefT >::ZipArchive
-ZipFileReader< ResRefT >::OpenArchive(
-	nwn2dev__in const std::string & ArchiveName
+void
+ZipFileReader< ResRefT >::ExtractAllFiles(
+	nwn2dev__in const std::string & DirectoryName,
+	nwn2dev__in bool Parallel /* = true */
 	)
 /*++
 
 Routine Description:
 
-	This routine opens a .zip archive and returns an archive handle for it.
+	This routine extracts every resource in the archive to a directory.
+
+	The extraction list is split into one contiguous range per work item, a
+	few work items per processor, and each work item reads, inflates and
+	writes its members independently.
 
 Arguments:
 
-	ArchiveName - Supplies the name of the .zip to open.
+	DirectoryName - Supplies the directory to extract files into, which must
+	                already exist.
+
+	Parallel - Supplies a Boolean value indicating whether members may be
+	           extracted on the system thread pool.
 
 Return Value:
 
-	The routine returns an archive handle on success, else NULL on failure.
+	None.  An std::exception is raised on failure.
 
 Environment:
 
@@ -634,69 +734,93 @@ Environment:
 
 --*/
 {
-	zlib_filefunc_def ZIoApis;
+	IndexVec           ExtractList;
+	ExtractWorkItemVec WorkItems;
+	size_t             WorkItemCount;
+	size_t             PerWorkItem;
 
-	x_fill_fopen_filefunc( &ZIoApis );
+	//
+	// Extract only the member selected by LocateFileByName for each resource
+	// name and type, which is the first member of each run of equal keys in
+	// the lookup index.
+	//
 
-	return (ZipArchive) unzOpen2( ArchiveName.c_str( ), &ZIoApis );
-}
+	ExtractList.reserve( m_LookupIndex.size( ) );
 
-template< typename ResRefT >
-void
-ZipFileReader< ResRefT >::CloseArchive(
-	nwn2dev__in ZipArchive Archive
-	)
-/*++
+	for (size_t i = 0; i < m_LookupIndex.size( ); i += 1)
+	{
+		const DirectoryEntry & Entry = m_DirectoryEntries[ m_LookupIndex[ i ] ];
 
-Routine Description:
+		if ((i != 0) &&
+		    (CompareEntryKey(
+				m_DirectoryEntries[ m_LookupIndex[ i - 1 ] ],
+				Entry.Name,
+				Entry.Type ) == 0))
+		{
+			continue;
+		}
 
-	This routine closes an opened .zip archive.
+		ExtractList.push_back( m_LookupIndex[ i ] );
+	}
 
-Arguments:
+	if (ExtractList.empty( ))
+		return;
 
-	Archive - Supplies the opened archive handle as returned from OpenArchive.
+	if (Parallel)
+		WorkItemCount = 4 * ParallelWorkQueue::GetProcessorCount( );
+	else
+		WorkItemCount = 1;
 
-Return Value:
+	if (WorkItemCount > ExtractList.size( ))
+		WorkItemCount = ExtractList.size( );
 
-	None.
+	PerWorkItem = (ExtractList.size( ) + WorkItemCount - 1) / WorkItemCount;
 
-Environment:
+	WorkItems.resize( WorkItemCount );
 
-	User mode.
+	ParallelWorkQueue WorkQueue( WorkItemCount > 1 );
 
---*/
-{
-	if (m_FileOpened)
+	for (size_t i = 0; i < WorkItemCount; i += 1)
 	{
-		unzCloseCurrentFile( (unzFile) Archive );
+		ExtractWorkItem & Item = WorkItems[ i ];
 
-		m_FileOpened = false;
+		Item.Reader        = this;
+		Item.DirectoryName = &DirectoryName;
+		Item.ExtractList   = &ExtractList;
+		Item.First         = i * PerWorkItem;
+		Item.Count         = PerWorkItem;
+
+		if (Item.First >= ExtractList.size( ))
+			break;
+
+		if (Item.Count > ExtractList.size( ) - Item.First)
+			Item.Count = ExtractList.size( ) - Item.First;
+
+		WorkQueue.QueueWork( ExtractWorkItemRoutine, &Item );
 	}
 
-	unzClose( (unzFile) Archive );
+	WorkQueue.WaitForAll( );
 }
 
-
 template< typename ResRefT >
 void
 ZipFileReader< ResRefT >::ScanArchive(
-	nwn2dev__in ZipArchive Archive
 	)
 /*++
 
 Routine Description:
 
-	This routine enumerates all files in a .zip archive, and adds them to the
-	master directory list.
+	This routine parses the central directory of the archive, and adds each
+	file to the master directory list.  The lookup index is then built.
 
 Arguments:
 
-	Archive - Supplies the .zip archive handle to scaN.
+	None.
 
 Return Value:
 
-	None.  The routine raises an std::exception on catastrophic failure, such as
-	if there was already an open file handle within the archive.
+	None.  The routine raises an std::exception on catastrophic failure, such
+	as if the archive is malformed.
 
 Environment:
 
@@ -704,22 +828,40 @@ Environment:
 
 --*/
 {
-	char            FileName[ 260 ];
-	int             Error;
-	unz_global_info ZInfo;
+	ZipEndOfCentralDirectory EndRecord;
+	ByteVec                  CentralDirectory;
+	size_t                   Offset;
+	char                     FileName[ 260 ];
 
-	if (m_FileOpened)
-		throw std::runtime_error( "Cannot scan an archive with a file opened." );
+	ReadEndOfCentralDirectory( EndRecord );
 
-	strcpy_s( FileName, "Z:\\" ); // Bogus, for splitpath.
+	if ((EndRecord.DiskNumber != 0) ||
+	    (EndRecord.CentralDirectoryDisk != 0) ||
+	    (EndRecord.DiskEntries != EndRecord.TotalEntries))
+	{
+		throw std::runtime_error( "Multi-volume .zip archives are not supported." );
+	}
 
-	Error = unzGoToFirstFile2(
-		(unzFile) Archive,
-		FileName + 3,
-		sizeof( FileName ) - 3 );
+	if (((ULONGLONG) EndRecord.CentralDirectoryOffset +
+	     (ULONGLONG) EndRecord.CentralDirectorySize) > m_FileSize)
+	{
+		throw std::runtime_error( "Central directory extends beyond end of archive." );
+	}
+
+	//
+	// Read the entire central directory in a single operation.
+	//
+
+	CentralDirectory.resize( EndRecord.CentralDirectorySize );
 
-	if (Error)
-		throw std::runtime_error( "unzGoToFirstFile failed" );
+	if (!CentralDirectory.empty( ))
+	{
+		ReadArchive(
+			EndRecord.CentralDirectoryOffset,
+			&CentralDirectory[ 0 ],
+			CentralDirectory.size( ),
+			"Central directory");
+	}
 
 	//
 	// Preallocate the directory entry array based on the count of files in
@@ -729,41 +871,55 @@ Environment:
 	//       need account for this as we're just reserving raw storage.
 	//
 
-	Error = unzGetGlobalInfo( (unzFile) Archive, &ZInfo );
+	m_DirectoryEntries.reserve( EndRecord.TotalEntries );
 
-	if (Error)
-		throw std::runtime_error( "unzGetGlobalInfo failed" );
+	strcpy_s( FileName, "Z:\\" ); // Bogus, for splitpath.
 
-	//
-	// Max size that we'll prereserve for.
-	//
+	Offset = 0;
+
+	for (unsigned long i = 0; i < EndRecord.TotalEntries; i += 1)
+	{
+		ZipCentralFileHeader Header;
+		DirectoryEntry       Entry;
+		size_t               Len;
+		char                 Name[ MAX_PATH ];
+		char                 Ext[ 32 ];
 
-	if (ZInfo.number_entry > 100 * 1024)
-		ZInfo.number_entry = 100 * 1024;
+		if (CentralDirectory.size( ) - Offset < sizeof( Header ))
+			throw std::runtime_error( "Truncated central directory." );
 
-	m_DirectoryEntries.reserve( ZInfo.number_entry );
+		memcpy( &Header, &CentralDirectory[ Offset ], sizeof( Header ) );
 
-	//
-	// Now iterate through each file, retrieving position and name data so that we
-	// may create directory entries as appropriate.
-	//
+		if (Header.Signature != ZIP_CENTRAL_FILE_HEADER_SIGNATURE)
+			throw std::runtime_error( "Illegal central directory file header." );
 
-	do
-	{
-		DirectoryEntry Entry;
-		size_t         Len;
-		unz_file_pos   FilePos;
-		char           Name[ MAX_PATH ];
-		char           Ext[ 32 ];
+		Offset += sizeof( Header );
+
+		Len = (size_t) Header.FileNameLength +
+		      (size_t) Header.ExtraFieldLength +
+		      (size_t) Header.FileCommentLength;
+
+		if (CentralDirectory.size( ) - Offset < Len)
+			throw std::runtime_error( "Truncated central directory." );
 
 		//
-		// Break the name up into its component forms and discern the resource type
-		// from the file extension.
+		// Break the name up into its component forms and discern the resource
+		// type from the file extension.
 		//
 
-		FileName[ sizeof( FileName ) - sizeof( FileName[ 0 ] ) ] = '\0';
+		Len = Header.FileNameLength;
+
+		if (Len > sizeof( FileName ) - 4)
+			Len = sizeof( FileName ) - 4;
+
+		memcpy( FileName + 3, &CentralDirectory[ Offset ], Len );
+		FileName[ 3 + Len ] = '\0';
 
-		if (!FileName[ 0 ])
+		Offset += (size_t) Header.FileNameLength +
+		          (size_t) Header.ExtraFieldLength +
+		          (size_t) Header.FileCommentLength;
+
+		if (!FileName[ 3 ])
 			continue;
 
 		_strlwr( FileName );
@@ -807,53 +963,54 @@ Environment:
 		ZeroMemory( &Entry.Name, sizeof( Entry.Name ) );
 		memcpy( &Entry.Name, Name, min( sizeof( Entry.Name ), Len ) );
 
-		Entry.Type = ExtToResType( Ext + 1 );
+		Entry.Type              = ExtToResType( Ext + 1 );
+		Entry.Flags             = Header.Flags;
+		Entry.CompressionMethod = Header.CompressionMethod;
+		Entry.Crc32             = Header.Crc32;
+		Entry.CompressedSize    = Header.CompressedSize;
+		Entry.UncompressedSize  = Header.UncompressedSize;
+		Entry.LocalHeaderOffset = Header.LocalHeaderOffset;
 
-		//
-		// Determine the offset in the zip file to use as a file handle.
-		//
+		m_DirectoryEntries.push_back( Entry );
+	}
 
-		Error = unzGetFilePos( (unzFile) Archive, &FilePos );
+	//
+	// Build the lookup index.  The sort is stable with respect to directory
+	// order, so the first member of a run of equal keys is the member that
+	// appears first in the archive.
+	//
 
-		if (Error)
-			throw std::runtime_error( "unzGetFilePos failed" );
+	LookupIndexLess Less;
 
-		Entry.FileHandleToReturn = ((((ULONG64) FilePos.pos_in_zip_directory)) |
-		                            (((ULONG64) FilePos.num_of_file) >> 32)) + 1;
+	Less.Entries = &m_DirectoryEntries;
 
-		m_DirectoryEntries.push_back( Entry );
-	} while ((Error = unzGoToNextFile2(
-		(unzFile) Archive,
-		FileName + 3,
-		sizeof( FileName ) - 3 )) == 0) ;
+	m_LookupIndex.resize( m_DirectoryEntries.size( ) );
 
-	if (Error != UNZ_END_OF_LIST_OF_FILE)
-		throw std::runtime_error( "unzGoToNextFile failed" );
+	for (size_t i = 0; i < m_LookupIndex.size( ); i += 1)
+		m_LookupIndex[ i ] = i;
+
+	std::sort( m_LookupIndex.begin( ), m_LookupIndex.end( ), Less );
 }
 
 template< typename ResRefT >
-const typename ZipFileReader< ResRefT >::DirectoryEntry *
-ZipFileReader< ResRefT >::LocateFileByName(
-	nwn2dev__in const ResRefT & FileName,
-	nwn2dev__in ResType Type
+void
+ZipFileReader< ResRefT >::ReadEndOfCentralDirectory(
+	nwn2dev__out ZipEndOfCentralDirectory & EndRecord
 	)
 /*++
 
 Routine Description:
 
-	This routine lookups up the directory entry for a file in the directory
-	listing of the zip file reader.
+	This routine locates and reads the end of central directory record, which
+	is the last record in the archive (followed only by the archive comment).
 
 Arguments:
 
-	FileName - Supplies the name of the resource file to open.
-
-	Type - Supplies the type of file to open (i.e. ResTRN, ResARE).
+	EndRecord - Receives the end of central directory record.
 
 Return Value:
 
-	The routine returns a pointer to the directory entry decriptor for the given
-	file on success, else NULL on failure.
+	None.  The routine raises an std::exception on failure.
 
 Environment:
 
@@ -861,453 +1018,853 @@ Environment:
 
 --*/
 {
-	for (DirectoryEntryVec::const_iterator it = m_DirectoryEntries.begin( );
-	     it != m_DirectoryEntries.end( );
-	     ++it)
-	{
-		if (it->Type != Type)
-			continue;
+	ByteVec   Tail;
+	ULONGLONG TailLength;
+	size_t    i;
 
-		if (memcmp( &FileName, &it->Name, sizeof( FileName ) ))
-			continue;
+	TailLength = sizeof( EndRecord ) + 0xFFFF;
 
-		return &*it;
-	}
+	if (TailLength > m_FileSize)
+		TailLength = m_FileSize;
 
-	return NULL;
-}
+	if (TailLength < sizeof( EndRecord ))
+		throw std::runtime_error( "File is too small to be a .zip archive." );
 
-template ZipFileReader< NWN::ResRef32 >;
+	Tail.resize( (size_t) TailLength );
 
-#ifdef USE_CRTIO_HACK
-#define _fread_nolock fread
-#define _fwrite_nolock fwrite
-#define _ftell_nolock ftell
-#define _fseek_nolock fseek
+	ReadArchive(
+		m_FileSize - TailLength,
+		&Tail[ 0 ],
+		Tail.size( ),
+		"End of central directory");
 
-#if 0
-size_t __cdecl crtfread_nolock(
-    void *buffer,
-    size_t elementSize,
-    size_t count,
-    FILE *stream);
+	//
+	// Scan backwards for the signature, as the record may be followed by a
+	// variable length comment.
+	//
 
-size_t __cdecl crtfwrite_nolock (
-        const void *buffer,
-        size_t size,
-        size_t num,
-        FILE *stream);
+	i = Tail.size( ) - sizeof( EndRecord ) + 1;
 
-long __cdecl crtftell_nolock (
+	while (i != 0)
+	{
+		i -= 1;
 
+		memcpy( &EndRecord, &Tail[ i ], sizeof( EndRecord ) );
 
-        FILE *str
-        );
+		if (EndRecord.Signature != ZIP_END_OF_CENTRAL_DIRECTORY_SIGNATURE)
+			continue;
 
-int __cdecl crtfseek_nolock (
+		if (i + sizeof( EndRecord ) + EndRecord.CommentLength > Tail.size( ))
+			continue;
 
+		return;
+	}
 
-        FILE *str,
-        long offset,
-        int whence
-        );
-#endif
+	throw std::runtime_error( "End of central directory record not found." );
+}
 
-#endif
+template< typename ResRefT >
+const typename ZipFileReader< ResRefT >::DirectoryEntry *
+ZipFileReader< ResRefT >::LocateFileByName(
+	nwn2dev__in const ResRefT & FileName,
+	nwn2dev__in ResType Type
+	)
+/*++
 
-//
-// Define file I/O wrappers for the unzip library.
-//
+Routine Description:
 
-static voidpf ZCALLBACK x_fopen_file_func OF((
-   voidpf opaque,
-   const char* filename,
-   int mode));
+	This routine lookups up the directory entry for a file in the directory
+	listing of the zip file reader.  The lookup index is binary searched for
+	the first member with the given name and type.
 
-static uLong ZCALLBACK x_fread_file_func OF((
-   voidpf opaque,
-   voidpf stream,
-   void* buf,
-   uLong size));
+Arguments:
 
-static uLong ZCALLBACK x_fwrite_file_func OF((
-   voidpf opaque,
-   voidpf stream,
-   const void* buf,
-   uLong size));
+	FileName - Supplies the name of the resource file to open.
 
-static long ZCALLBACK x_ftell_file_func OF((
-   voidpf opaque,
-   voidpf stream));
+	Type - Supplies the type of file to open (i.e. ResTRN, ResARE).
 
-static long ZCALLBACK x_fseek_file_func OF((
-   voidpf opaque,
-   voidpf stream,
-   uLong offset,
-   int origin));
+Return Value:
 
-static int ZCALLBACK x_fclose_file_func OF((
-   voidpf opaque,
-   voidpf stream));
+	The routine returns a pointer to the directory entry decriptor for the given
+	file on success, else NULL on failure.
 
-static int ZCALLBACK x_ferror_file_func OF((
-   voidpf opaque,
-   voidpf stream));
+Environment:
 
-#define BUFSIZE 1024
+	User mode.
 
-//
-// On 64-bit builds, use mapped file reader for the major performance gains
-// from avoiding all of the tiny read calls.  On 32-bit, we're stuck with the
-// CRT-like I/O calls due to address space pressure.
-//
+--*/
+{
+	size_t Low;
+	size_t High;
 
-#ifdef _WIN64
-#define ZLIBIO_USE_MAPPED_FILE_READER 1
-#else
-#define ZLIBIO_USE_MAPPED_FILE_READER 0
-#endif
+	Low  = 0;
+	High = m_LookupIndex.size( );
 
-struct FILE_CTX
-{
-    FILE          * stream;
-    size_t          offset;
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	FileWrapper   * MappedFileReader;
-	int             MFRError;
-	bool            MFRAtEof;
-	uLong           MFRFileSize;
-#endif
-};
-
-#define _XSTRM(o) ((FILE_CTX*)o)->stream
-#define _XOFFS(o) ((FILE_CTX*)o)->offset
-
-static voidpf ZCALLBACK x_fopen_file_func(
-   voidpf opaque,
-   const char* filename,
-   int mode)
-{
-    FILE* file = NULL;
-    FILE_CTX * ctx = NULL;
-    const char* mode_fopen = NULL;
-    UNREFERENCED_PARAMETER(opaque);
-    if ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER)==ZLIB_FILEFUNC_MODE_READ)
-        mode_fopen = "rbSN";
-    else
-    if (mode & ZLIB_FILEFUNC_MODE_EXISTING)
-        mode_fopen = "r+bSN";
-    else
-    if (mode & ZLIB_FILEFUNC_MODE_CREATE)
-        mode_fopen = "wbSN";
-
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	if ((mode_fopen != NULL) && (!(mode & ZLIB_FILEFUNC_MODE_CREATE)))
+	while (Low < High)
 	{
-		HANDLE hf;
-
-		hf = CreateFile(
-			filename,
-			GENERIC_READ,
-			FILE_SHARE_READ,
-			NULL,
-			OPEN_EXISTING,
-			FILE_ATTRIBUTE_NORMAL,
-			NULL);
+		size_t Mid = Low + (High - Low) / 2;
 
-		if (hf != INVALID_HANDLE_VALUE)
+		if (CompareEntryKey(
+			m_DirectoryEntries[ m_LookupIndex[ Mid ] ],
+			FileName,
+			Type ) < 0)
 		{
-			ctx = (FILE_CTX *) malloc( sizeof( FILE_CTX ) );
-
-			try
-			{
-				ctx->MappedFileReader = new FileWrapper( INVALID_HANDLE_VALUE );
-				ctx->MappedFileReader->SetFileHandle( hf, true );
-				ctx->stream = (FILE *) hf;
-				ctx->offset = 0;
-				ctx->MFRError = 0;
-				ctx->MFRAtEof = false;
-				ctx->MFRFileSize = (uLong) ctx->MappedFileReader->GetFileSize( );
-				return ctx;
-			}
-			catch (std::exception)
-			{
-				free( ctx );
-				ctx = NULL;
-				CloseHandle( hf );
-			}
+			Low = Mid + 1;
+		}
+		else
+		{
+			High = Mid;
 		}
 	}
-#endif
-
-    if ((filename!=NULL) && (mode_fopen != NULL))
-        file = fopen(filename, mode_fopen);
 
-    if (file != NULL)
-        setvbuf(file, NULL, _IOFBF, BUFSIZE);
-	else
+	if (Low == m_LookupIndex.size( ))
 		return NULL;
 
-    ctx = (FILE_CTX *)malloc(sizeof(FILE_CTX));
-    if (ctx == NULL)
+	if (CompareEntryKey(
+		m_DirectoryEntries[ m_LookupIndex[ Low ] ],
+		FileName,
+		Type ) != 0)
 	{
-        fclose(file);
-        return NULL;
+		return NULL;
 	}
-    ctx->stream = file;
-    ctx->offset = 0;
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	ctx->MappedFileReader = NULL;
-#endif
-    return ctx;
+
+	return &m_DirectoryEntries[ m_LookupIndex[ Low ] ];
 }
 
+template< typename ResRefT >
+int
+ZipFileReader< ResRefT >::CompareEntryKey(
+	nwn2dev__in const DirectoryEntry & Entry,
+	nwn2dev__in const ResRefT & ResRef,
+	nwn2dev__in ResType Type
+	)
+/*++
+
+Routine Description:
+
+	This routine compares the key (type and name) of a directory entry with a
+	resource type and name.
 
-static uLong ZCALLBACK x_fread_file_func(
-   voidpf opaque,
-   voidpf stream,
-   void* buf,
-   uLong size)
+Arguments:
+
+	Entry - Supplies the directory entry to compare.
+
+	ResRef - Supplies the resource name to compare against.
+
+	Type - Supplies the resource type to compare against.
+
+Return Value:
+
+	The routine returns a negative value if the entry orders before the key,
+	zero if the entry matches the key, else a positive value.
+
+Environment:
+
+	User mode.
+
+--*/
 {
-    uLong ret;
-	FILE_CTX *ctx;
-    UNREFERENCED_PARAMETER(opaque);
-	ctx = (FILE_CTX *)stream;
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	if (ctx->MappedFileReader != NULL)
+	if (Entry.Type != Type)
+		return (Entry.Type < Type) ? -1 : 1;
+
+	return memcmp( &Entry.Name, &ResRef, sizeof( ResRef ) );
+}
+
+template< typename ResRefT >
+bool
+ZipFileReader< ResRefT >::LookupIndexLess::operator()(
+	nwn2dev__in size_t Index1,
+	nwn2dev__in size_t Index2
+	) const
+/*++
+
+Routine Description:
+
+	This routine orders two directory entries for the lookup index.
+
+Arguments:
+
+	Index1 - Supplies the directory index of the first entry.
+
+	Index2 - Supplies the directory index of the second entry.
+
+Return Value:
+
+	The routine returns true if the first entry orders before the second.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const DirectoryEntry & Entry1 = (*Entries)[ Index1 ];
+	int                    Order;
+
+	Order = CompareEntryKey( Entry1, (*Entries)[ Index2 ].Name, (*Entries)[ Index2 ].Type );
+
+	if (Order != 0)
+		return Order < 0;
+
+	return Index1 < Index2;
+}
+
+template< typename ResRefT >
+void
+ZipFileReader< ResRefT >::ReadArchive(
+	nwn2dev__in ULONGLONG Offset,
+	__out_bcount( Length ) void * Buffer,
+	nwn2dev__in size_t Length,
+	nwn2dev__in const char * Description
+	) const
+/*++
+
+Routine Description:
+
+	This routine reads data at a given offset from the archive file.  The file
+	pointer is not used, so the routine may be called from several threads at
+	once.
+
+Arguments:
+
+	Offset - Supplies the archive offset to read from.
+
+	Buffer - Receives the data read.
+
+	Length - Supplies the count of bytes to read.
+
+	Description - Supplies a description of the data, for error reporting.
+
+Return Value:
+
+	None.  An std::exception is raised on failure, including a short read.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned char * Ptr = (unsigned char *) Buffer;
+	char            ExMsg[ 64 ];
+
+	while (Length != 0)
 	{
-		if (ctx->MFRAtEof)
-			return 0;
+		OVERLAPPED Overlapped;
+		DWORD      Chunk;
+		DWORD      Transferred;
 
-		try
+		Chunk = (Length > 0x10000000) ? 0x10000000 : (DWORD) Length;
+
+		ZeroMemory( &Overlapped, sizeof( Overlapped ) );
+
+		Overlapped.Offset     = (DWORD) ((Offset >>  0) & 0xFFFFFFFF);
+		Overlapped.OffsetHigh = (DWORD) ((Offset >> 32) & 0xFFFFFFFF);
+
+		if ((!::ReadFile(
+			m_File,
+			Ptr,
+			Chunk,
+			&Transferred,
+			&Overlapped)) || (Transferred == 0))
 		{
-			ctx->MappedFileReader->ReadFile(
-				buf,
-				size,
-				"zlib minizip file read" );
+			StringCbPrintfA(
+				ExMsg,
+				sizeof( ExMsg ),
+				"ReadArchive( %s ) failed.",
+				Description);
+
+			throw std::runtime_error( ExMsg );
 		}
-		catch (std::exception)
+
+		Ptr    += Transferred;
+		Offset += Transferred;
+		Length -= Transferred;
+	}
+}
+
+template< typename ResRefT >
+ULONGLONG
+ZipFileReader< ResRefT >::GetMemberDataOffset(
+	nwn2dev__in const DirectoryEntry & Entry
+	) const
+/*++
+
+Routine Description:
+
+	This routine reads the local file header of a member and returns the
+	archive offset of the member data, which follows the local header.  The
+	local header may carry a different extra field than the central directory
+	entry, so it must be consulted.
+
+Arguments:
+
+	Entry - Supplies the directory entry of the member.
+
+Return Value:
+
+	The routine returns the archive offset of the member data.  An
+	std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ZipLocalFileHeader Header;
+	ULONGLONG          DataOffset;
+
+	ReadArchive(
+		Entry.LocalHeaderOffset,
+		&Header,
+		sizeof( Header ),
+		"Local file header");
+
+	if (Header.Signature != ZIP_LOCAL_FILE_HEADER_SIGNATURE)
+		throw std::runtime_error( "Illegal local file header." );
+
+	DataOffset = (ULONGLONG) Entry.LocalHeaderOffset +
+	             sizeof( Header ) +
+	             Header.FileNameLength +
+	             Header.ExtraFieldLength;
+
+	if (DataOffset + Entry.CompressedSize > m_FileSize)
+		throw std::runtime_error( "Member data extends beyond end of archive." );
+
+	return DataOffset;
+}
+
+template< typename ResRefT >
+void
+ZipFileReader< ResRefT >::ReadMember(
+	nwn2dev__in const DirectoryEntry & Entry,
+	nwn2dev__in ULONGLONG DataOffset,
+	nwn2dev__out ByteVec & Contents
+	)
+/*++
+
+Routine Description:
+
+	This routine reads the entire contents of a member, inflating it if it is
+	deflated.  The checksum of the contents is verified.
+
+Arguments:
+
+	Entry - Supplies the directory entry of the member.
+
+	DataOffset - Supplies the archive offset of the member data.
+
+	Contents - Receives the member contents.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	Contents.resize( Entry.UncompressedSize );
+
+	if (Entry.CompressionMethod == ZIP_METHOD_STORED)
+	{
+		if (Entry.CompressedSize != Entry.UncompressedSize)
+			throw std::runtime_error( "Illegal stored member size." );
+
+		if (!Contents.empty( ))
 		{
-			((FILE_CTX *)stream)->MFRError = 1;
-			return 0;
+			ReadArchive(
+				DataOffset,
+				&Contents[ 0 ],
+				Contents.size( ),
+				"Stored member data");
 		}
-		return (uLong) size;
 	}
-#endif
+	else if (Entry.CompressionMethod == ZIP_METHOD_DEFLATED)
+	{
+		ByteVec        Compressed;
+		InflateContext Context;
+		z_stream     * Stream;
+		int            Error;
+
+		Compressed.resize( Entry.CompressedSize );
+
+		if (!Compressed.empty( ))
+		{
+			ReadArchive(
+				DataOffset,
+				&Compressed[ 0 ],
+				Compressed.size( ),
+				"Deflated member data");
+		}
+
+		ResourceStatistics::ScopedOperation StatOp(
+			m_Statistics,
+			m_StatSource,
+			ResourceStatistics::OpInflate);
+
+		Context = AcquireInflateContext( );
+		Stream  = (z_stream *) Context;
+
+		Stream->next_in   = Compressed.empty( ) ? NULL : &Compressed[ 0 ];
+		Stream->avail_in  = (uInt) Compressed.size( );
+		Stream->next_out  = Contents.empty( ) ? NULL : &Contents[ 0 ];
+		Stream->avail_out = (uInt) Contents.size( );
+
+		Error = inflate( Stream, Z_FINISH );
 
-    ret = (uLong)_fread_nolock(buf, 1, (size_t)size, _XSTRM(stream));
-    _XOFFS(stream) += ret;
-    return ret;
+		if ((Error != Z_STREAM_END) || (Stream->avail_out != 0))
+			Error = Z_DATA_ERROR;
+
+		ReleaseInflateContext( Context );
+
+		if (Error != Z_STREAM_END)
+		{
+			StatOp.Cancel( );
+			throw std::runtime_error( "Failed to inflate member data." );
+		}
+
+		StatOp.SetBytes( Contents.size( ) );
+	}
+	else
+	{
+		throw std::runtime_error( "Unsupported member compression method." );
+	}
+
+	if (crc32(
+		crc32( 0, Z_NULL, 0 ),
+		Contents.empty( ) ? Z_NULL : &Contents[ 0 ],
+		(uInt) Contents.size( ) ) != Entry.Crc32)
+	{
+		throw std::runtime_error( "Member data checksum mismatch." );
+	}
 }
 
+template< typename ResRefT >
+typename ZipFileReader< ResRefT >::ByteVecPtr
+ZipFileReader< ResRefT >::GetMemberContents(
+	nwn2dev__in size_t EntryIndex,
+	nwn2dev__in ULONGLONG DataOffset
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the decompressed contents of a member, either from
+	the member cache, or by inflating the member and then caching it.
+
+	Two threads that miss on the same member concurrently both inflate it;
+	the first to finish populates the cache.
+
+Arguments:
+
+	EntryIndex - Supplies the directory index of the member.
+
+	DataOffset - Supplies the archive offset of the member data.
+
+Return Value:
+
+	The routine returns a shared pointer to the member contents.  An
+	std::exception is raised on failure.
+
+Environment:
+
+	User mode.
 
-static uLong ZCALLBACK x_fwrite_file_func(
-   voidpf opaque,
-   voidpf stream,
-   const void* buf,
-   uLong size)
+--*/
 {
-    uLong ret;
-    UNREFERENCED_PARAMETER(opaque);
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	if (((FILE_CTX *)stream)->MappedFileReader != NULL)
-		return 0;
-#endif
-    ret = (uLong)_fwrite_nolock(buf, 1, (size_t)size, _XSTRM(stream));
-    _XOFFS(stream) += ret;
-    return ret;
+	ByteVecPtr Contents;
+
+	EnterCriticalSection( &m_Lock );
+
+	Contents = LookupCache( EntryIndex );
+
+	LeaveCriticalSection( &m_Lock );
+
+	if (Contents.get( ) != NULL)
+		return Contents;
+
+	Contents = new ByteVec;
+
+	ReadMember( m_DirectoryEntries[ EntryIndex ], DataOffset, *Contents );
+
+	EnterCriticalSection( &m_Lock );
+
+	try
+	{
+		InsertCache( EntryIndex, Contents );
+	}
+	catch (std::exception)
+	{
+		//
+		// Failing to cache the member is not fatal.
+		//
+	}
+
+	LeaveCriticalSection( &m_Lock );
+
+	return Contents;
 }
 
-inline static long ZCALLBACK x_ftell_file_func(
-   voidpf opaque,
-   voidpf stream)
+template< typename ResRefT >
+typename ZipFileReader< ResRefT >::ByteVecPtr
+ZipFileReader< ResRefT >::LookupCache(
+	nwn2dev__in size_t EntryIndex
+	)
+/*++
+
+Routine Description:
+
+	This routine looks up a member in the member cache, and marks it as the
+	most recently used member on a hit.
+
+	The cache lock must be held.
+
+Arguments:
+
+	EntryIndex - Supplies the directory index of the member.
+
+Return Value:
+
+	The routine returns the cached member contents, else a NULL shared
+	pointer if the member is not cached.
+
+Environment:
+
+	User mode.
+
+--*/
 {
-    long ret;
-	FILE_CTX *ctx;
-    UNREFERENCED_PARAMETER(opaque);
-	ctx = (FILE_CTX *)stream;
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	if (ctx->MappedFileReader != NULL)
+	typename CacheMap::iterator it = m_Cache.find( EntryIndex );
+
+	if (it == m_Cache.end( ))
+		return ByteVecPtr( );
+
+	m_CacheLru.splice( m_CacheLru.begin( ), m_CacheLru, it->second.LruPosition );
+
+	return it->second.Contents;
+}
+
+template< typename ResRefT >
+void
+ZipFileReader< ResRefT >::InsertCache(
+	nwn2dev__in size_t EntryIndex,
+	nwn2dev__in const ByteVecPtr & Contents
+	)
+/*++
+
+Routine Description:
+
+	This routine inserts a member into the member cache, evicting the least
+	recently used members as necessary to respect the cache size limit.
+	Members larger than the cache limit are not cached.
+
+	Evicted contents remain valid for any open file handle that references
+	them.
+
+	The cache lock must be held.
+
+Arguments:
+
+	EntryIndex - Supplies the directory index of the member.
+
+	Contents - Supplies the member contents.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	CacheRecord Record;
+	size_t      Size = Contents->size( );
+
+	if (Size > m_CacheLimit)
+		return;
+
+	if (m_Cache.find( EntryIndex ) != m_Cache.end( ))
+		return;
+
+	while ((!m_CacheLru.empty( )) && (m_CacheSize + Size > m_CacheLimit))
 	{
-		if (ctx->MFRAtEof)
-			return (long)ctx->MFRFileSize;
-		else
-			return (long)ctx->MappedFileReader->GetFilePointer();
+		typename CacheMap::iterator it = m_Cache.find( m_CacheLru.back( ) );
+
+		m_CacheSize -= it->second.Contents->size( );
+
+		m_Cache.erase( it );
+		m_CacheLru.pop_back( );
 	}
-#endif
-//  ret = _ftell_nolock(_XSTRM(stream));
-    ret = (long)_XOFFS(stream);
-    return ret;
+
+	m_CacheLru.push_front( EntryIndex );
+
+	try
+	{
+		Record.Contents    = Contents;
+		Record.LruPosition = m_CacheLru.begin( );
+
+		m_Cache.insert( typename CacheMap::value_type( EntryIndex, Record ) );
+	}
+	catch (...)
+	{
+		m_CacheLru.pop_front( );
+		throw;
+	}
+
+	m_CacheSize += Size;
 }
 
-static long ZCALLBACK x_fseek_file_func(
-   voidpf opaque,
-   voidpf stream,
-   uLong offset,
-   int origin)
+template< typename ResRefT >
+typename ZipFileReader< ResRefT >::InflateContext
+ZipFileReader< ResRefT >::AcquireInflateContext(
+	)
+/*++
+
+Routine Description:
+
+	This routine takes an inflate context from the reader's pool, creating a
+	new one if every context is in use.  The pool thus grows to the number of
+	threads concurrently inflating members of the archive.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns an inflate context, which must be returned to the pool
+	via ReleaseInflateContext.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
 {
-    long curpos;
-    uLong delta;
-    int tryread;
-    int fseek_origin=0;
-    long ret;
-    UNREFERENCED_PARAMETER(opaque);
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	if (((FILE_CTX*)stream)->MappedFileReader != NULL)
+	z_stream * Stream;
+
+	EnterCriticalSection( &m_Lock );
+
+	if (!m_InflateContexts.empty( ))
+	{
+		Stream = (z_stream *) m_InflateContexts.back( );
+		m_InflateContexts.pop_back( );
+	}
+	else
 	{
-		FILE_CTX *ctx = (FILE_CTX*)stream;
-		FileWrapper *wrapper = ctx->MappedFileReader;
-		long newoffs;
+		Stream = NULL;
+	}
 
-		try
-		{
-			switch (origin)
-			{
-			case ZLIB_FILEFUNC_SEEK_CUR:
-				newoffs = x_ftell_file_func(opaque, stream) + (long)offset;
-				break;
-			case ZLIB_FILEFUNC_SEEK_END:
-				newoffs = (long)ctx->MFRFileSize + (long)offset;
-				break;
-			case ZLIB_FILEFUNC_SEEK_SET:
-				newoffs = (long)offset;
-				break;
-			default:
-				return -1;
-			}
+	LeaveCriticalSection( &m_Lock );
 
-			if (newoffs == (long)ctx->MFRFileSize)
-			{
-				ctx->MFRAtEof = true;
-			}
-			else
-			{
-				ctx->MFRAtEof = false;
-				wrapper->SeekOffset((ULONGLONG)newoffs, "zlib minizip file seek");
-			}
+	if (Stream != NULL)
+		return Stream;
+
+	Stream = new z_stream;
+
+	ZeroMemory( Stream, sizeof( *Stream ) );
+
+	//
+	// Zip members are raw deflate streams, without a zlib header.
+	//
+
+	if (inflateInit2( Stream, -MAX_WBITS ) != Z_OK)
+	{
+		delete Stream;
+		throw std::runtime_error( "inflateInit2 failed" );
+	}
 
-			return 0;
+	return Stream;
+}
+
+template< typename ResRefT >
+void
+ZipFileReader< ResRefT >::ReleaseInflateContext(
+	nwn2dev__in InflateContext Context
+	)
+/*++
+
+Routine Description:
+
+	This routine resets an inflate context and returns it to the pool.
+
+Arguments:
+
+	Context - Supplies the inflate context to return.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	z_stream * Stream = (z_stream *) Context;
+
+	if (inflateReset( Stream ) == Z_OK)
+	{
+		EnterCriticalSection( &m_Lock );
+
+		try
+		{
+			m_InflateContexts.push_back( Stream );
+			Stream = NULL;
 		}
 		catch (std::exception)
 		{
-			((FILE_CTX *)stream)->MFRError = 1;
-			return -1;
 		}
+
+		LeaveCriticalSection( &m_Lock );
+	}
+
+	if (Stream != NULL)
+	{
+		inflateEnd( Stream );
+		delete Stream;
 	}
-#endif
-    switch (origin)
-    {
-    case ZLIB_FILEFUNC_SEEK_CUR :
-        fseek_origin = SEEK_CUR;
-        break;
-    case ZLIB_FILEFUNC_SEEK_END :
-        fseek_origin = SEEK_END;
-        break;
-    case ZLIB_FILEFUNC_SEEK_SET :
-        fseek_origin = SEEK_SET;
-        break;
-    default: return -1;
-    }
-    ret = 0;
-    tryread = 0;
-    delta = 0; // Compiler satisfaction
-    if ((fseek_origin == SEEK_CUR))
-    {
-        if (offset == 0) return 0;
-        if (offset < BUFSIZE)
-        {
-            curpos = (long)_XOFFS(stream);
-            delta = (uLong) offset;
-            tryread = 1;
-        }
-    }
-    else if ((fseek_origin == SEEK_SET))
-    {
-        curpos = (long)_XOFFS(stream);
-        if (offset == (uLong) curpos) return 0;
-        if (offset > (uLong) curpos)
-        {
-            delta = offset - (uLong) curpos;
-            if (delta <= BUFSIZE)
-                tryread = 1;
-//			else
-//                WriteText("Delta too large...%d\n", delta);
-        }// else WriteText("Seek back %d [%lu->%lu]\n", offset - curpos, curpos, offset);
-    }
-    if (tryread)
-    {
-        static char dummy[BUFSIZE];
-        size_t d;
-//        WriteText("Quick seek %lu (%lu)\n", offset, (size_t)delta);
-        d = _fread_nolock(dummy, 1, (size_t)delta, _XSTRM(stream));
-        _XOFFS(stream) += d;
-        if (d == delta) return 0;
-  //      WriteText("Quick seek failed\n", offset, fseek_origin);
-    }
-//	WriteText("Slow seek %d %d\n", offset, fseek_origin);
-    _fseek_nolock(_XSTRM(stream), offset, fseek_origin);
-    _XOFFS(stream) = _ftell_nolock(_XSTRM(stream));
-    return ret;
 }
 
-static int ZCALLBACK x_fclose_file_func(
-   voidpf opaque,
-   voidpf stream)
+template< typename ResRefT >
+void
+ZipFileReader< ResRefT >::ExtractFile(
+	nwn2dev__in const std::string & DirectoryName,
+	nwn2dev__in size_t EntryIndex
+	)
+/*++
+
+Routine Description:
+
+	This routine extracts a single member to a <resref>.<ext> file within a
+	directory.  The member cache is bypassed, as extracted members are not
+	expected to be read again.
+
+Arguments:
+
+	DirectoryName - Supplies the directory to extract the file into.
+
+	EntryIndex - Supplies the directory index of the member to extract.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
 {
-    int ret;
-	FILE_CTX *ctx;
-    UNREFERENCED_PARAMETER(opaque);
-	ctx = (FILE_CTX*)stream;
-	
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	if (ctx->MappedFileReader == NULL)
+	const DirectoryEntry & Entry = m_DirectoryEntries[ EntryIndex ];
+	ByteVec                Contents;
+	std::string            FileName;
+	char                   Name[ sizeof( ResRefT ) + 1 ];
+	HANDLE                 File;
+	DWORD                  Written;
+	bool                   Succeeded;
+
+	if ((Entry.Flags & ZIP_FLAG_ENCRYPTED) ||
+	    ((Entry.CompressionMethod != ZIP_METHOD_STORED) &&
+	     (Entry.CompressionMethod != ZIP_METHOD_DEFLATED)))
 	{
-#endif
-		ret = fclose(_XSTRM(stream));
-#if ZLIBIO_USE_MAPPED_FILE_READER
+		return;
 	}
-	else
+
+	ReadMember( Entry, GetMemberDataOffset( Entry ), Contents );
+
+	memcpy( Name, &Entry.Name, sizeof( ResRefT ) );
+	Name[ sizeof( ResRefT ) ] = '\0';
+
+	FileName  = DirectoryName;
+	FileName += "\\";
+	FileName += Name;
+	FileName += ".";
+	FileName += ResTypeToExt( Entry.Type );
+
+	File = CreateFileA(
+		FileName.c_str( ),
+		GENERIC_WRITE,
+		0,
+		NULL,
+		CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL);
+
+	if (File == INVALID_HANDLE_VALUE)
 	{
-		delete ctx->MappedFileReader;
-		CloseHandle( (HANDLE) ctx->stream );
-		ret = 0;
+		try
+		{
+			std::string ErrorStr;
+
+			ErrorStr  = "Failed to create extracted file '";
+			ErrorStr += FileName;
+			ErrorStr += "'.";
+
+			throw std::runtime_error( ErrorStr );
+		}
+		catch (std::bad_alloc)
+		{
+			throw std::runtime_error( "Failed to create extracted file." );
+		}
 	}
-#endif
 
-    free((FILE_CTX*)stream);
-    return ret;
-}
+	Succeeded = (Contents.empty( )) ||
+	            ((WriteFile(
+	                File,
+	                &Contents[ 0 ],
+	                (DWORD) Contents.size( ),
+	                &Written,
+	                NULL)) && (Written == (DWORD) Contents.size( )));
 
-static int ZCALLBACK x_ferror_file_func(
-   voidpf opaque,
-   voidpf stream)
-{
-    int ret;
-	FILE_CTX *ctx;
-    UNREFERENCED_PARAMETER(opaque);
-	ctx = (FILE_CTX*)stream;
-
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	if (ctx->MappedFileReader == NULL)
-#endif
-		ret = ferror(_XSTRM(stream));
-#if ZLIBIO_USE_MAPPED_FILE_READER
-	else
-		ret = ctx->MFRError;
-#endif
+	CloseHandle( File );
 
-    return ret;
+	if (!Succeeded)
+		throw std::runtime_error( "Failed to write extracted file." );
 }
 
-static void x_fill_fopen_filefunc(
-  zlib_filefunc_def* pzlib_filefunc_def)
+template< typename ResRefT >
+void
+__stdcall
+ZipFileReader< ResRefT >::ExtractWorkItemRoutine(
+	nwn2dev__in void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine is the work routine for a parallel extraction work item.  It
+	extracts each member within its range of the extraction list.
+
+Arguments:
+
+	Context - Supplies the ExtractWorkItem describing the work.
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode, potentially thread pool thread.
+
+--*/
 {
-    pzlib_filefunc_def->zopen_file = x_fopen_file_func;
-    pzlib_filefunc_def->zread_file = x_fread_file_func;
-    pzlib_filefunc_def->zwrite_file = x_fwrite_file_func;
-    pzlib_filefunc_def->ztell_file = x_ftell_file_func;
-    pzlib_filefunc_def->zseek_file = x_fseek_file_func;
-    pzlib_filefunc_def->zclose_file = x_fclose_file_func;
-    pzlib_filefunc_def->zerror_file = x_ferror_file_func;
-    pzlib_filefunc_def->opaque = NULL;
+	ExtractWorkItem * Item = (ExtractWorkItem *) Context;
+
+	for (size_t i = Item->First; i < Item->First + Item->Count; i += 1)
+	{
+		Item->Reader->ExtractFile(
+			*Item->DirectoryName,
+			(*Item->ExtractList)[ i ]);
+	}
 }
+
+template ZipFileReader< NWN::ResRef32 >;
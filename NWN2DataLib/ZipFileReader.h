@@ -12,6 +12,14 @@ Abstract:
 	resource load requests to be serviced against a .zip archive instead of an
 	ERF file.
 
+	The central directory of the archive is parsed once into a flat index.
+	Member data is then read with positional reads against the archive file,
+	so any number of files may be open at once, from any thread, and reads
+	may be issued at arbitrary offsets.  Deflated members are inflated whole
+	(with an inflate context taken from a per-reader pool, so that concurrent
+	readers do not serialize on one decompressor) and the decompressed data
+	is kept in a bounded, least recently used cache.
+
 --*/
 
 #ifndef _PROGRAMS_NWN2DATALIB_ZIPFILEREADER_H
@@ -22,23 +30,35 @@ Abstract:
 #endif
 
 #include "ResourceAccessor.h"
+#include "ResourceStatistics.h"
 
 //
 // Define the directory file reader object, used to access directory files.
 //
 
 template< typename ResRefT >
-class ZipFileReader : public IResourceAccessor< ResRefT >
+class ZipFileReader : public IResourceAccessor< ResRefT >,
+                      public ResourceStatisticsClient
 {
 
 public:
 
+	enum
+	{
+		//
+		// Default upper bound on the decompressed member cache, in bytes.
+		//
+
+		DEFAULT_CACHE_LIMIT = 32 * 1024 * 1024
+	};
+
 	//
 	// Constructor.  Raises an std::exception on catastrophic failure.
 	//
 
 	ZipFileReader(
-		nwn2dev__in const std::string & ArchiveName
+		nwn2dev__in const std::string & ArchiveName,
+		nwn2dev__in size_t CacheLimit = DEFAULT_CACHE_LIMIT
 		);
 
 	//
@@ -81,8 +101,8 @@ public:
 		);
 
 	//
-	// Read an encapsulated file by file handle.  The routine is optimized to
-	// operate for sequential file reads.
+	// Read an encapsulated file by file handle.  Reads may be issued at any
+	// offset and in any order.
 	//
 
 	virtual
@@ -148,44 +168,173 @@ public:
 		nwn2dev__out std::string & AccessorName
 		);
 
+	//
+	// Extract every resource in the archive to a directory, as <resref>.<ext>
+	// files.  Where several members share a resource name and type, only the
+	// one that OpenFile would select is extracted.  Members are read and
+	// inflated in parallel on the system thread pool unless Parallel is false.
+	// An std::exception is raised on failure.
+	//
+
+	void
+	ExtractAllFiles(
+		nwn2dev__in const std::string & DirectoryName,
+		nwn2dev__in bool Parallel = true
+		);
+
 private:
 
-	typedef void * ZipArchive;
+	typedef void * InflateContext;
+	typedef std::vector< InflateContext > InflateContextVec;
+
+	typedef std::vector< unsigned char > ByteVec;
+	typedef swutil::SharedPtr< ByteVec > ByteVecPtr;
+
+	enum
+	{
+		ZIP_METHOD_STORED   = 0,
+		ZIP_METHOD_DEFLATED = 8,
+
+		ZIP_FLAG_ENCRYPTED  = 0x0001
+	};
+
+#include <pshpack1.h>
+
+	//
+	// Define the on-disk zip structures that the reader consumes.
+	//
+
+	struct ZipEndOfCentralDirectory
+	{
+		unsigned long  Signature;
+		unsigned short DiskNumber;
+		unsigned short CentralDirectoryDisk;
+		unsigned short DiskEntries;
+		unsigned short TotalEntries;
+		unsigned long  CentralDirectorySize;
+		unsigned long  CentralDirectoryOffset;
+		unsigned short CommentLength;
+	};
+
+	static_assert( sizeof( ZipEndOfCentralDirectory ) == 22, "compile time assert failed" );
+
+	struct ZipCentralFileHeader
+	{
+		unsigned long  Signature;
+		unsigned short VersionMadeBy;
+		unsigned short VersionNeeded;
+		unsigned short Flags;
+		unsigned short CompressionMethod;
+		unsigned short ModTime;
+		unsigned short ModDate;
+		unsigned long  Crc32;
+		unsigned long  CompressedSize;
+		unsigned long  UncompressedSize;
+		unsigned short FileNameLength;
+		unsigned short ExtraFieldLength;
+		unsigned short FileCommentLength;
+		unsigned short DiskNumberStart;
+		unsigned short InternalAttributes;
+		unsigned long  ExternalAttributes;
+		unsigned long  LocalHeaderOffset;
+	};
+
+	static_assert( sizeof( ZipCentralFileHeader ) == 46, "compile time assert failed" );
+
+	struct ZipLocalFileHeader
+	{
+		unsigned long  Signature;
+		unsigned short VersionNeeded;
+		unsigned short Flags;
+		unsigned short CompressionMethod;
+		unsigned short ModTime;
+		unsigned short ModDate;
+		unsigned long  Crc32;
+		unsigned long  CompressedSize;
+		unsigned long  UncompressedSize;
+		unsigned short FileNameLength;
+		unsigned short ExtraFieldLength;
+	};
+
+	static_assert( sizeof( ZipLocalFileHeader ) == 30, "compile time assert failed" );
+
+#include <poppack.h>
 
 	struct DirectoryEntry
 	{
-		FileHandle  FileHandleToReturn;
-		ResRefT     Name;
-		ResType     Type;
+		ResRefT        Name;
+		ResType        Type;
+		unsigned short Flags;
+		unsigned short CompressionMethod;
+		unsigned long  Crc32;
+		unsigned long  CompressedSize;
+		unsigned long  UncompressedSize;
+		unsigned long  LocalHeaderOffset;
 	};
 
 	typedef std::vector< DirectoryEntry > DirectoryEntryVec;
+	typedef std::vector< size_t > IndexVec;
 
 	//
-	// Open a new zip archive.
+	// Define the state of an open file handle.  The decompressed contents of
+	// a deflated member are attached on first read.
 	//
 
-	ZipArchive
-	OpenArchive(
-		nwn2dev__in const std::string & ArchiveName
-		);
+	struct OpenFileContext
+	{
+		size_t         EntryIndex;
+		ULONGLONG      DataOffset;
+		ByteVecPtr     Contents;
+	};
+
+	typedef std::map< FileHandle, OpenFileContext > OpenFileMap;
+
+	//
+	// Define the decompressed member cache.  The LRU list holds directory
+	// entry indicies, most recently used first.
+	//
+
+	typedef std::list< size_t > CacheLruList;
+
+	struct CacheRecord
+	{
+		ByteVecPtr                      Contents;
+		typename CacheLruList::iterator LruPosition;
+	};
+
+	typedef std::map< size_t, CacheRecord > CacheMap;
 
 	//
-	// Close an opened archive.
+	// Define the context for a parallel extraction work item, which extracts
+	// a range of the extraction list.
+	//
+
+	struct ExtractWorkItem
+	{
+		ZipFileReader     * Reader;
+		const std::string * DirectoryName;
+		const IndexVec    * ExtractList;
+		size_t              First;
+		size_t              Count;
+	};
+
+	typedef std::vector< ExtractWorkItem > ExtractWorkItemVec;
+
+	//
+	// Parse the central directory to create directory file entries.
 	//
 
 	void
-	CloseArchive(
-		nwn2dev__in ZipArchive Archive
+	ScanArchive(
 		);
 
 	//
-	// Scan directories to create directory file entries.
+	// Locate the end of central directory record of the archive.
 	//
 
 	void
-	ScanArchive(
-		nwn2dev__in ZipArchive Archive
+	ReadEndOfCentralDirectory(
+		nwn2dev__out ZipEndOfCentralDirectory & EndRecord
 		);
 
 	//
@@ -198,13 +347,142 @@ private:
 		nwn2dev__in ResType Type
 		);
 
+	//
+	// Compare a directory entry against a resource name and type, returning
+	// a value less than, equal to or greater than zero (as per memcmp).
+	//
+
+	static
+	int
+	CompareEntryKey(
+		nwn2dev__in const DirectoryEntry & Entry,
+		nwn2dev__in const ResRefT & ResRef,
+		nwn2dev__in ResType Type
+		);
+
+	//
+	// Order directory entry indicies by (type, name, directory order), which
+	// is the ordering of the lookup index.
+	//
+
+	struct LookupIndexLess
+	{
+		const DirectoryEntryVec * Entries;
+
+		bool
+		operator()(
+			nwn2dev__in size_t Index1,
+			nwn2dev__in size_t Index2
+			) const;
+	};
+
+	//
+	// Positional read from the archive file.  Safe to call concurrently.
+	//
+
+	void
+	ReadArchive(
+		nwn2dev__in ULONGLONG Offset,
+		__out_bcount( Length ) void * Buffer,
+		nwn2dev__in size_t Length,
+		nwn2dev__in const char * Description
+		) const;
+
+	//
+	// Return the archive offset of the data of a member, after checking its
+	// local file header.
+	//
+
+	ULONGLONG
+	GetMemberDataOffset(
+		nwn2dev__in const DirectoryEntry & Entry
+		) const;
+
+	//
+	// Read the entire (decompressed) contents of a member.
+	//
+
+	void
+	ReadMember(
+		nwn2dev__in const DirectoryEntry & Entry,
+		nwn2dev__in ULONGLONG DataOffset,
+		nwn2dev__out ByteVec & Contents
+		);
+
+	//
+	// Return the decompressed contents of a deflated member, via the cache.
+	//
+
+	ByteVecPtr
+	GetMemberContents(
+		nwn2dev__in size_t EntryIndex,
+		nwn2dev__in ULONGLONG DataOffset
+		);
+
+	//
+	// Decompressed member cache management.  The cache lock must be held.
+	//
+
+	ByteVecPtr
+	LookupCache(
+		nwn2dev__in size_t EntryIndex
+		);
+
+	void
+	InsertCache(
+		nwn2dev__in size_t EntryIndex,
+		nwn2dev__in const ByteVecPtr & Contents
+		);
+
+	//
+	// Inflate context pool management.
+	//
+
+	InflateContext
+	AcquireInflateContext(
+		);
+
+	void
+	ReleaseInflateContext(
+		nwn2dev__in InflateContext Context
+		);
+
+	//
+	// Extract one member to a file.
+	//
+
+	void
+	ExtractFile(
+		nwn2dev__in const std::string & DirectoryName,
+		nwn2dev__in size_t EntryIndex
+		);
+
+	static
+	void
+	__stdcall
+	ExtractWorkItemRoutine(
+		nwn2dev__in void * Context
+		);
+
 	DirectoryEntryVec m_DirectoryEntries;
-	ZipArchive        m_Archive;
-	bool              m_FileOpened;     // Is m_OpenFileHandle valid?
-	FileHandle        m_OpenFileHandle; // Currently open file handle
-	unsigned __int64  m_CurrentOffset;  // Offset into currently opened file
+	IndexVec          m_LookupIndex;    // Entries sorted by LookupIndexLess
+	HANDLE            m_File;
+	ULONGLONG         m_FileSize;
 	std::string       m_FileName;
 
+	//
+	// The following state is protected by m_Lock.
+	//
+
+	CRITICAL_SECTION  m_Lock;
+	OpenFileMap       m_OpenFiles;
+	FileHandle        m_NextFileHandle;
+	CacheMap          m_Cache;
+	CacheLruList      m_CacheLru;
+	size_t            m_CacheSize;      // Bytes of decompressed data cached
+	size_t            m_CacheLimit;
+	InflateContextVec m_InflateContexts;
+
 };
 
 typedef ZipFileReader< NWN::ResRef32 > ZipFileReader32;
@@ -1,18 +1,78 @@
 #include <iostream>
+#include <chrono>
+#include <cstring>
 
 #include <Precomp.h>
 #include <TlkFileReader.h>
 
+using TlkFileReader16 = TlkFileReader<NWN::ResRef16>;
+
+//
+// Time lookups of every string in the talk table, first through the copying
+// GetTalkString interface and then through GetTalkStringView.  The first
+// pass over a table that was not decoded up front fills the string cache.
+//
+
+static void benchmark( const char* filepath, bool decodeAll )
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto micros = []( Clock::duration d ) {
+        return (long long) std::chrono::duration_cast< std::chrono::microseconds >( d ).count( );
+    };
+
+    const int passes = 5;
+
+    auto start = Clock::now( );
+    TlkFileReader16 tlk( filepath );
+    std::cout << "open: " << micros( Clock::now( ) - start ) << " us, "
+              << tlk.GetStringCount( ) << " strings" << std::endl;
+
+    if( decodeAll ) {
+        start = Clock::now( );
+        tlk.DecodeAllStrings( true );
+        std::cout << "decode all (parallel): " << micros( Clock::now( ) - start ) << " us" << std::endl;
+    }
+
+    std::string strVal;
+    TlkFileReader16::TalkStringView view;
+    size_t totalLength = 0;
+
+    for( int pass = 0; pass < passes; ++pass ) {
+        start = Clock::now( );
+        for( TlkFileReader16::StrRef ref = 0; ref < tlk.GetStringCount( ); ++ref ) {
+            if( tlk.GetTalkString( ref, strVal ) )
+                totalLength += strVal.size( );
+        }
+        std::cout << "GetTalkString pass " << pass << ": " << micros( Clock::now( ) - start ) << " us" << std::endl;
+    }
+
+    for( int pass = 0; pass < passes; ++pass ) {
+        start = Clock::now( );
+        for( TlkFileReader16::StrRef ref = 0; ref < tlk.GetStringCount( ); ++ref ) {
+            if( tlk.GetTalkStringView( ref, view ) )
+                totalLength += view.second;
+        }
+        std::cout << "GetTalkStringView pass " << pass << ": " << micros( Clock::now( ) - start ) << " us" << std::endl;
+    }
+
+    std::cout << "total length: " << totalLength << std::endl;
+}
+
 int main( int argc, char* argv[] )
 {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[ 0 ] << " <dialog.TLK file>" << std::endl;
+        std::cerr << "Usage: " << argv[ 0 ] << " <dialog.TLK file> [-bench [-decodeall]]" << std::endl;
         return 1;
     }
 
-    using TlkFileReader16 = TlkFileReader<NWN::ResRef16>;
-
     const auto filepath = argv[ 1 ];
+
+    if( argc > 2 && !strcmp( argv[ 2 ], "-bench" ) ) {
+        benchmark( filepath, argc > 3 && !strcmp( argv[ 3 ], "-decodeall" ) );
+        return 0;
+    }
+
     TlkFileReader16 tlk( filepath );
 
     std::string strVal;
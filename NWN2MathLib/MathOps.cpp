@@ -18,6 +18,13 @@ Abstract:
 #include "../NWNBaseLib/NWNBaseLib.h"
 #include "MathOps.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define NWN2MATH_SSE 1
+#include <xmmintrin.h>
+#else
+#define NWN2MATH_SSE 0
+#endif
+
 //
 // Polygon hit test from inpoly.cpp.
 //
@@ -568,6 +575,461 @@ Environment:
 	Rotation = Math::CreateRotationQuaternion( RotationMatrix );
 }
 
+void
+Math::MultiplyPoints(
+	nwn2dev__in const NWN::Matrix44 & M,
+	__in_bcount( Count * SrcStride ) const NWN::Vector3 * Src,
+	nwn2dev__in size_t SrcStride,
+	__out_bcount( Count * DstStride ) NWN::Vector3 * Dst,
+	nwn2dev__in size_t DstStride,
+	nwn2dev__in size_t Count
+	)
+/*++
+
+Routine Description:
+
+	This routine transforms a batch of points by a matrix, equivalent to
+	calling Math::Multiply for each point in turn.  The source and destination
+	arrays may be strided (for example, to operate on a field of each of an
+	array of vertex structures), and may overlap point for point.
+
+Arguments:
+
+	M - Supplies the transformation to apply.
+
+	Src - Supplies the first point to transform.
+
+	SrcStride - Supplies the distance, in bytes, between source points.
+
+	Dst - Receives the first transformed point.
+
+	DstStride - Supplies the distance, in bytes, between destination points.
+
+	Count - Supplies the count of points to transform.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const unsigned char * SrcPtr = (const unsigned char *) Src;
+	unsigned char       * DstPtr = (unsigned char *) Dst;
+
+#if NWN2MATH_SSE
+	//
+	// Keep the matrix rows resident in registers for the whole batch, so that
+	// each point costs three broadcasts and three multiply-add steps.
+	//
+
+	const __m128 Row0 = _mm_setr_ps( M._00, M._01, M._02, M._03 );
+	const __m128 Row1 = _mm_setr_ps( M._10, M._11, M._12, M._13 );
+	const __m128 Row2 = _mm_setr_ps( M._20, M._21, M._22, M._23 );
+	const __m128 Row3 = _mm_setr_ps( M._30, M._31, M._32, M._33 );
+
+	for (size_t i = 0; i < Count; i += 1)
+	{
+		const NWN::Vector3 * V1 = (const NWN::Vector3 *) SrcPtr;
+		NWN::Vector3       * V0 = (NWN::Vector3 *) DstPtr;
+		__m128               R;
+
+		R = _mm_add_ps(
+			_mm_add_ps(
+				_mm_mul_ps( _mm_set1_ps( V1->x ), Row0 ),
+				_mm_mul_ps( _mm_set1_ps( V1->y ), Row1 ) ),
+			_mm_add_ps(
+				_mm_mul_ps( _mm_set1_ps( V1->z ), Row2 ),
+				Row3 ) );
+
+		_mm_storel_pi( (__m64 *) &V0->x, R );
+		_mm_store_ss( &V0->z, _mm_movehl_ps( R, R ) );
+
+		SrcPtr += SrcStride;
+		DstPtr += DstStride;
+	}
+#else
+	for (size_t i = 0; i < Count; i += 1)
+	{
+		*(NWN::Vector3 *) DstPtr = Math::Multiply(
+			M,
+			*(const NWN::Vector3 *) SrcPtr );
+
+		SrcPtr += SrcStride;
+		DstPtr += DstStride;
+	}
+#endif
+}
+
+void
+Math::ExtendBoundsPoints(
+	__in_bcount( Count * SrcStride ) const NWN::Vector3 * Src,
+	nwn2dev__in size_t SrcStride,
+	nwn2dev__in size_t Count,
+	__inout NWN::Vector3 & MinBound,
+	__inout NWN::Vector3 & MaxBound
+	)
+/*++
+
+Routine Description:
+
+	This routine extends an axis aligned bounding box so that it contains each
+	of a batch of points.  The source array may be strided (for example, to
+	operate on a field of each of an array of vertex structures).
+
+Arguments:
+
+	Src - Supplies the first point to include.
+
+	SrcStride - Supplies the distance, in bytes, between source points.
+
+	Count - Supplies the count of points to include.
+
+	MinBound - Supplies the minimum bound of the box, and receives the updated
+	           minimum bound.
+
+	MaxBound - Supplies the maximum bound of the box, and receives the updated
+	           maximum bound.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const unsigned char * SrcPtr = (const unsigned char *) Src;
+
+#if NWN2MATH_SSE
+	__m128 Min = _mm_setr_ps( MinBound.x, MinBound.y, MinBound.z, 0.0f );
+	__m128 Max = _mm_setr_ps( MaxBound.x, MaxBound.y, MaxBound.z, 0.0f );
+
+	for (size_t i = 0; i < Count; i += 1)
+	{
+		const NWN::Vector3 * V1 = (const NWN::Vector3 *) SrcPtr;
+		__m128               P;
+
+		P = _mm_movelh_ps(
+			_mm_loadl_pi( _mm_setzero_ps( ), (const __m64 *) &V1->x ),
+			_mm_load_ss( &V1->z ) );
+
+		Min = _mm_min_ps( Min, P );
+		Max = _mm_max_ps( Max, P );
+
+		SrcPtr += SrcStride;
+	}
+
+	_mm_storel_pi( (__m64 *) &MinBound.x, Min );
+	_mm_store_ss( &MinBound.z, _mm_movehl_ps( Min, Min ) );
+	_mm_storel_pi( (__m64 *) &MaxBound.x, Max );
+	_mm_store_ss( &MaxBound.z, _mm_movehl_ps( Max, Max ) );
+#else
+	for (size_t i = 0; i < Count; i += 1)
+	{
+		const NWN::Vector3 * V1 = (const NWN::Vector3 *) SrcPtr;
+
+		if (V1->x < MinBound.x)
+			MinBound.x = V1->x;
+		if (V1->y < MinBound.y)
+			MinBound.y = V1->y;
+		if (V1->z < MinBound.z)
+			MinBound.z = V1->z;
+		if (V1->x > MaxBound.x)
+			MaxBound.x = V1->x;
+		if (V1->y > MaxBound.y)
+			MaxBound.y = V1->y;
+		if (V1->z > MaxBound.z)
+			MaxBound.z = V1->z;
+
+		SrcPtr += SrcStride;
+	}
+#endif
+}
+
+#if NWN2MATH_SSE
+
+//
+// Convert four packed points (x0 y0 z0 x1, y1 z1 x2 y2, z2 x3 y3 z3) to and from
+// one register per coordinate (x0 x1 x2 x3, y0 y1 y2 y3, z0 z1 z2 z3).
+//
+
+static
+inline
+void
+PackedPointsToSoA(
+	nwn2dev__in __m128 A,
+	nwn2dev__in __m128 B,
+	nwn2dev__in __m128 C,
+	nwn2dev__out __m128 & X,
+	nwn2dev__out __m128 & Y,
+	nwn2dev__out __m128 & Z
+	)
+{
+	__m128 X2Y2X3Y3 = _mm_shuffle_ps( B, C, _MM_SHUFFLE( 2, 1, 3, 2 ) );
+	__m128 Y0Z0Y1Z1 = _mm_shuffle_ps( A, B, _MM_SHUFFLE( 1, 0, 2, 1 ) );
+
+	X = _mm_shuffle_ps( A, X2Y2X3Y3, _MM_SHUFFLE( 2, 0, 3, 0 ) );
+	Y = _mm_shuffle_ps( Y0Z0Y1Z1, X2Y2X3Y3, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+	Z = _mm_shuffle_ps( Y0Z0Y1Z1, C, _MM_SHUFFLE( 3, 0, 3, 1 ) );
+}
+
+static
+inline
+void
+SoAToPackedPoints(
+	nwn2dev__in __m128 X,
+	nwn2dev__in __m128 Y,
+	nwn2dev__in __m128 Z,
+	nwn2dev__out __m128 & A,
+	nwn2dev__out __m128 & B,
+	nwn2dev__out __m128 & C
+	)
+{
+	__m128 X0X2Y0Y2 = _mm_shuffle_ps( X, Y, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+	__m128 Y1Y3Z1Z3 = _mm_shuffle_ps( Y, Z, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+	__m128 Z0Z2X1X3 = _mm_shuffle_ps( Z, X, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+	A = _mm_shuffle_ps( X0X2Y0Y2, Z0Z2X1X3, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+	B = _mm_shuffle_ps( Y1Y3Z1Z3, X0X2Y0Y2, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+	C = _mm_shuffle_ps( Z0Z2X1X3, Y1Y3Z1Z3, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+}
+
+#endif
+
+void
+Math::MultiplyPointsPacked(
+	nwn2dev__in const NWN::Matrix44 & M,
+	__in_ecount( Count ) const NWN::Vector3 * Src,
+	__out_ecount( Count ) NWN::Vector3 * Dst,
+	nwn2dev__in size_t Count
+	)
+/*++
+
+Routine Description:
+
+	This routine transforms a batch of points by a matrix, equivalent to
+	calling Math::Multiply for each point in turn.  The source and destination
+	arrays must be packed, 16 byte aligned, and allocated in multiples of four
+	points.  The arrays may be the same array.
+
+	With SSE, each step loads four points with three aligned loads, transposes
+	them so that each register holds one coordinate of all four points, and
+	transforms them together.  The last step may read and write the padding
+	past the end of the arrays rather than falling back to a scalar loop.
+
+Arguments:
+
+	M - Supplies the transformation to apply.
+
+	Src - Supplies the points to transform.
+
+	Dst - Receives the transformed points.
+
+	Count - Supplies the count of points to transform.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+#if NWN2MATH_SSE
+	const float * SrcPtr = (const float *) Src;
+	float       * DstPtr = (float *) Dst;
+
+	const __m128 M00 = _mm_set1_ps( M._00 );
+	const __m128 M01 = _mm_set1_ps( M._01 );
+	const __m128 M02 = _mm_set1_ps( M._02 );
+	const __m128 M10 = _mm_set1_ps( M._10 );
+	const __m128 M11 = _mm_set1_ps( M._11 );
+	const __m128 M12 = _mm_set1_ps( M._12 );
+	const __m128 M20 = _mm_set1_ps( M._20 );
+	const __m128 M21 = _mm_set1_ps( M._21 );
+	const __m128 M22 = _mm_set1_ps( M._22 );
+	const __m128 M30 = _mm_set1_ps( M._30 );
+	const __m128 M31 = _mm_set1_ps( M._31 );
+	const __m128 M32 = _mm_set1_ps( M._32 );
+
+	for (size_t i = 0; i < Count; i += 4)
+	{
+		__m128 A;
+		__m128 B;
+		__m128 C;
+		__m128 X;
+		__m128 Y;
+		__m128 Z;
+		__m128 RX;
+		__m128 RY;
+		__m128 RZ;
+
+		PackedPointsToSoA(
+			_mm_load_ps( SrcPtr + 0 ),
+			_mm_load_ps( SrcPtr + 4 ),
+			_mm_load_ps( SrcPtr + 8 ),
+			X,
+			Y,
+			Z);
+
+		RX = _mm_add_ps(
+			_mm_add_ps( _mm_mul_ps( X, M00 ), _mm_mul_ps( Y, M10 ) ),
+			_mm_add_ps( _mm_mul_ps( Z, M20 ), M30 ) );
+		RY = _mm_add_ps(
+			_mm_add_ps( _mm_mul_ps( X, M01 ), _mm_mul_ps( Y, M11 ) ),
+			_mm_add_ps( _mm_mul_ps( Z, M21 ), M31 ) );
+		RZ = _mm_add_ps(
+			_mm_add_ps( _mm_mul_ps( X, M02 ), _mm_mul_ps( Y, M12 ) ),
+			_mm_add_ps( _mm_mul_ps( Z, M22 ), M32 ) );
+
+		SoAToPackedPoints( RX, RY, RZ, A, B, C );
+
+		_mm_store_ps( DstPtr + 0, A );
+		_mm_store_ps( DstPtr + 4, B );
+		_mm_store_ps( DstPtr + 8, C );
+
+		SrcPtr += 12;
+		DstPtr += 12;
+	}
+#else
+	Math::MultiplyPoints(
+		M,
+		Src,
+		sizeof( NWN::Vector3 ),
+		Dst,
+		sizeof( NWN::Vector3 ),
+		Count);
+#endif
+}
+
+void
+Math::ExtendBoundsPointsPacked(
+	__in_ecount( Count ) const NWN::Vector3 * Src,
+	nwn2dev__in size_t Count,
+	__inout NWN::Vector3 & MinBound,
+	__inout NWN::Vector3 & MaxBound
+	)
+/*++
+
+Routine Description:
+
+	This routine extends an axis aligned bounding box so that it contains each
+	of a batch of points.  The source array must be packed, 16 byte aligned,
+	and allocated in multiples of four points.
+
+	With SSE, four points are processed per step with aligned loads.  In the
+	last step, lanes past the end of the array are replaced with the first
+	point of the step, so the padding never contributes to the bounds.
+
+Arguments:
+
+	Src - Supplies the points to include.
+
+	Count - Supplies the count of points to include.
+
+	MinBound - Supplies the minimum bound of the box, and receives the updated
+	           minimum bound.
+
+	MaxBound - Supplies the maximum bound of the box, and receives the updated
+	           maximum bound.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+#if NWN2MATH_SSE
+	const float * SrcPtr = (const float *) Src;
+	__m128        MinX   = _mm_set1_ps( MinBound.x );
+	__m128        MinY   = _mm_set1_ps( MinBound.y );
+	__m128        MinZ   = _mm_set1_ps( MinBound.z );
+	__m128        MaxX   = _mm_set1_ps( MaxBound.x );
+	__m128        MaxY   = _mm_set1_ps( MaxBound.y );
+	__m128        MaxZ   = _mm_set1_ps( MaxBound.z );
+	__m128        T;
+
+	for (size_t i = 0; i < Count; i += 4)
+	{
+		__m128 X;
+		__m128 Y;
+		__m128 Z;
+
+		PackedPointsToSoA(
+			_mm_load_ps( SrcPtr + 0 ),
+			_mm_load_ps( SrcPtr + 4 ),
+			_mm_load_ps( SrcPtr + 8 ),
+			X,
+			Y,
+			Z);
+
+		if (Count - i < 4)
+		{
+			__m128 Valid;
+
+			Valid = _mm_cmplt_ps(
+				_mm_setr_ps( 0.0f, 1.0f, 2.0f, 3.0f ),
+				_mm_set1_ps( (float) (Count - i) ) );
+
+			X = _mm_or_ps(
+				_mm_and_ps( Valid, X ),
+				_mm_andnot_ps( Valid, _mm_shuffle_ps( X, X, 0 ) ) );
+			Y = _mm_or_ps(
+				_mm_and_ps( Valid, Y ),
+				_mm_andnot_ps( Valid, _mm_shuffle_ps( Y, Y, 0 ) ) );
+			Z = _mm_or_ps(
+				_mm_and_ps( Valid, Z ),
+				_mm_andnot_ps( Valid, _mm_shuffle_ps( Z, Z, 0 ) ) );
+		}
+
+		MinX = _mm_min_ps( MinX, X );
+		MinY = _mm_min_ps( MinY, Y );
+		MinZ = _mm_min_ps( MinZ, Z );
+		MaxX = _mm_max_ps( MaxX, X );
+		MaxY = _mm_max_ps( MaxY, Y );
+		MaxZ = _mm_max_ps( MaxZ, Z );
+
+		SrcPtr += 12;
+	}
+
+	//
+	// Reduce the four lanes of each coordinate.
+	//
+
+	T = _mm_min_ps( MinX, _mm_movehl_ps( MinX, MinX ) );
+	MinBound.x = _mm_cvtss_f32( _mm_min_ss( T, _mm_shuffle_ps( T, T, 1 ) ) );
+	T = _mm_min_ps( MinY, _mm_movehl_ps( MinY, MinY ) );
+	MinBound.y = _mm_cvtss_f32( _mm_min_ss( T, _mm_shuffle_ps( T, T, 1 ) ) );
+	T = _mm_min_ps( MinZ, _mm_movehl_ps( MinZ, MinZ ) );
+	MinBound.z = _mm_cvtss_f32( _mm_min_ss( T, _mm_shuffle_ps( T, T, 1 ) ) );
+	T = _mm_max_ps( MaxX, _mm_movehl_ps( MaxX, MaxX ) );
+	MaxBound.x = _mm_cvtss_f32( _mm_max_ss( T, _mm_shuffle_ps( T, T, 1 ) ) );
+	T = _mm_max_ps( MaxY, _mm_movehl_ps( MaxY, MaxY ) );
+	MaxBound.y = _mm_cvtss_f32( _mm_max_ss( T, _mm_shuffle_ps( T, T, 1 ) ) );
+	T = _mm_max_ps( MaxZ, _mm_movehl_ps( MaxZ, MaxZ ) );
+	MaxBound.z = _mm_cvtss_f32( _mm_max_ss( T, _mm_shuffle_ps( T, T, 1 ) ) );
+#else
+	Math::ExtendBoundsPoints(
+		Src,
+		sizeof( NWN::Vector3 ),
+		Count,
+		MinBound,
+		MaxBound);
+#endif
+}
+
 NWN::Vector2
 Math::PolygonCentroid2(
 	nwn2dev__in const Vector2Vec & Polygon
@@ -620,6 +620,61 @@ namespace Math
 		return V0;
 	}
 
+	//
+	// Multiply a batch of points by a matrix.  Points are read from and
+	// written to strided arrays so that the routine may operate directly on
+	// vertex structures.  SSE is used where available.
+	//
+
+	void
+	MultiplyPoints(
+		nwn2dev__in const NWN::Matrix44 & M,
+		__in_bcount( Count * SrcStride ) const NWN::Vector3 * Src,
+		nwn2dev__in size_t SrcStride,
+		__out_bcount( Count * DstStride ) NWN::Vector3 * Dst,
+		nwn2dev__in size_t DstStride,
+		nwn2dev__in size_t Count
+		);
+
+	//
+	// Extend a bounding box to contain a batch of points, which are read from
+	// a strided array.  SSE is used where available.
+	//
+
+	void
+	ExtendBoundsPoints(
+		__in_bcount( Count * SrcStride ) const NWN::Vector3 * Src,
+		nwn2dev__in size_t SrcStride,
+		nwn2dev__in size_t Count,
+		__inout NWN::Vector3 & MinBound,
+		__inout NWN::Vector3 & MaxBound
+		);
+
+	//
+	// Packed variants of MultiplyPoints and ExtendBoundsPoints, for arrays of
+	// points that are contiguous, 16 byte aligned, and allocated in multiples
+	// of four points (such as SimpleMeshStreamStorage vertex streams).  With
+	// SSE, four points are processed per step using aligned loads and stores,
+	// without a scalar loop for the remainder.  The padding past Count points
+	// of the destination array may be overwritten.
+	//
+
+	void
+	MultiplyPointsPacked(
+		nwn2dev__in const NWN::Matrix44 & M,
+		__in_ecount( Count ) const NWN::Vector3 * Src,
+		__out_ecount( Count ) NWN::Vector3 * Dst,
+		nwn2dev__in size_t Count
+		);
+
+	void
+	ExtendBoundsPointsPacked(
+		__in_ecount( Count ) const NWN::Vector3 * Src,
+		nwn2dev__in size_t Count,
+		__inout NWN::Vector3 & MinBound,
+		__inout NWN::Vector3 & MaxBound
+		);
+
 	//
 	// Multiply a vector by a matrix.
 	//
@@ -0,0 +1,790 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	BuildDatabase.cpp
+
+Abstract:
+
+	This module houses the BuildDatabase class, which records the inputs and
+	outputs of each compiled script so that the compiler driver can skip
+	scripts that are already up to date.
+
+	The database is stored as a line oriented text file:
+
+	    NWNScriptCompiler build database <version>
+	    options <compiler options fingerprint>
+	    script <output base file name>
+	    source <hash> <size>
+	    dependency <hash> <size> <include file name>
+	    output <hash> <size> <output file extension>
+	    end
+
+--*/
+
+#include "Precomp.h"
+#include "BuildDatabase.h"
+
+//
+// Define the database file signature line, which carries the format version.
+//
+
+#define BUILD_DATABASE_SIGNATURE "NWNScriptCompiler build database 1"
+
+//
+// Define the maximum length of a database line.
+//
+
+#define BUILD_DATABASE_MAX_LINE 4096
+
+BuildDatabase::BuildDatabase(
+	nwn2dev__in ResourceManager & ResMan
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new, empty BuildDatabase.
+
+Arguments:
+
+	ResMan - Supplies the resource manager, which is used to map include file
+	         extensions to resource types.
+
+Return Value:
+
+	The newly constructed object.
+
+Environment:
+
+	User mode.
+
+--*/
+: m_ResourceManager( ResMan )
+{
+	ZeroMemory( &m_Statistics, sizeof( m_Statistics ) );
+}
+
+BuildDatabase::~BuildDatabase(
+	)
+/*++
+
+Routine Description:
+
+	This routine cleans up an already-existing BuildDatabase.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+}
+
+bool
+BuildDatabase::Load(
+	nwn2dev__in const std::string & FileName,
+	nwn2dev__in const std::string & Options
+	)
+/*++
+
+Routine Description:
+
+	This routine loads the build database from disk.  If the database was
+	written with different compiler options, its records are discarded.
+
+Arguments:
+
+	FileName - Supplies the path of the database file.
+
+	Options - Supplies the fingerprint of the compiler options in effect.
+
+Return Value:
+
+	The routine returns true if the database was loaded (or did not exist),
+	else false if the database file was malformed, in which case the database
+	is left empty.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FILE         * f;
+	char           Line[ BUILD_DATABASE_MAX_LINE ];
+	ScriptRecord * Record;
+	std::string    ScriptKey;
+	bool           Valid;
+	bool           OptionsMatch;
+
+	m_Scripts.clear( );
+	m_Options = Options;
+
+	f = fopen( FileName.c_str( ), "rt" );
+
+	if (f == NULL)
+		return true;
+
+	Record       = NULL;
+	Valid        = false;
+	OptionsMatch = false;
+
+	try
+	{
+		ScriptRecord NewRecord;
+
+		while (fgets( Line, sizeof( Line ), f ))
+		{
+			char      * Value;
+			ULONGLONG   Hash;
+			ULONGLONG   Size;
+			int         Chars;
+
+			Line[ strcspn( Line, "\r\n" ) ] = '\0';
+
+			//
+			// The first line must be the signature.
+			//
+
+			if (!Valid)
+			{
+				if (strcmp( Line, BUILD_DATABASE_SIGNATURE ) != 0)
+					break;
+
+				Valid = true;
+				continue;
+			}
+
+			Value = strchr( Line, ' ' );
+
+			if (Value != NULL)
+				*Value++ = '\0';
+			else
+				Value = Line + strlen( Line );
+
+			if (!strcmp( Line, "options" ))
+			{
+				OptionsMatch = (m_Options == Value);
+
+				//
+				// If the options differ, then nothing that was built with the
+				// old options is up to date.
+				//
+
+				if (!OptionsMatch)
+					break;
+			}
+			else if (!strcmp( Line, "script" ))
+			{
+				if ((!OptionsMatch) || (Record != NULL) || (*Value == '\0'))
+				{
+					Valid = false;
+					break;
+				}
+
+				ScriptKey = Value;
+				NewRecord = ScriptRecord( );
+				Record    = &NewRecord;
+			}
+			else if (!strcmp( Line, "end" ))
+			{
+				if (Record == NULL)
+				{
+					Valid = false;
+					break;
+				}
+
+				m_Scripts[ ScriptKey ] = NewRecord;
+				Record                 = NULL;
+			}
+			else
+			{
+				if ((Record == NULL) ||
+				    (sscanf( Value, "%I64x %I64u %n", &Hash, &Size, &Chars ) != 2))
+				{
+					Valid = false;
+					break;
+				}
+
+				ContentKey Key;
+
+				Key.Hash = Hash;
+				Key.Size = Size;
+
+				if (!strcmp( Line, "source" ))
+				{
+					Record->SourceKey = Key;
+				}
+				else if (!strcmp( Line, "dependency" ))
+				{
+					Dependency Dep;
+
+					Dep.FileName = Value + Chars;
+					Dep.Key      = Key;
+
+					Record->Dependencies.push_back( Dep );
+				}
+				else if (!strcmp( Line, "output" ))
+				{
+					OutputFile Output;
+
+					Output.Extension = Value + Chars;
+					Output.Key       = Key;
+
+					Record->Outputs.push_back( Output );
+				}
+				else
+				{
+					Valid = false;
+					break;
+				}
+			}
+		}
+
+		if ((Valid) && (OptionsMatch) && (Record != NULL))
+			Valid = false;
+	}
+	catch (std::exception)
+	{
+		Valid = false;
+	}
+
+	fclose( f );
+
+	if (!Valid)
+	{
+		m_Scripts.clear( );
+		return false;
+	}
+
+	if (!OptionsMatch)
+		m_Scripts.clear( );
+
+	return true;
+}
+
+void
+BuildDatabase::Save(
+	nwn2dev__in const std::string & FileName
+	) const
+/*++
+
+Routine Description:
+
+	This routine writes the build database to disk.
+
+Arguments:
+
+	FileName - Supplies the path of the database file.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FILE        * f;
+	std::string   TempFileName;
+	bool          Failed;
+
+	TempFileName  = FileName;
+	TempFileName += ".tmp";
+
+	f = fopen( TempFileName.c_str( ), "wt" );
+
+	if (f == NULL)
+		throw std::runtime_error( "Failed to create build database file." );
+
+	fprintf( f, "%s\n", BUILD_DATABASE_SIGNATURE );
+	fprintf( f, "options %s\n", m_Options.c_str( ) );
+
+	for (ScriptMap::const_iterator it = m_Scripts.begin( );
+	     it != m_Scripts.end( );
+	     ++it)
+	{
+		const ScriptRecord & Record = it->second;
+
+		fprintf( f, "script %s\n", it->first.c_str( ) );
+		fprintf(
+			f,
+			"source %016I64X %I64u\n",
+			Record.SourceKey.Hash,
+			Record.SourceKey.Size);
+
+		for (DependencyVec::const_iterator dit = Record.Dependencies.begin( );
+		     dit != Record.Dependencies.end( );
+		     ++dit)
+		{
+			fprintf(
+				f,
+				"dependency %016I64X %I64u %s\n",
+				dit->Key.Hash,
+				dit->Key.Size,
+				dit->FileName.c_str( ));
+		}
+
+		for (OutputFileVec::const_iterator oit = Record.Outputs.begin( );
+		     oit != Record.Outputs.end( );
+		     ++oit)
+		{
+			fprintf(
+				f,
+				"output %016I64X %I64u %s\n",
+				oit->Key.Hash,
+				oit->Key.Size,
+				oit->Extension.c_str( ));
+		}
+
+		fprintf( f, "end\n" );
+	}
+
+	Failed = (ferror( f ) != 0);
+
+	if (fclose( f ) != 0)
+		Failed = true;
+
+	if (Failed)
+	{
+		DeleteFileA( TempFileName.c_str( ) );
+		throw std::runtime_error( "Failed to write build database file." );
+	}
+
+	if (!MoveFileExA(
+		TempFileName.c_str( ),
+		FileName.c_str( ),
+		MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA( TempFileName.c_str( ) );
+		throw std::runtime_error( "Failed to rename build database file." );
+	}
+}
+
+bool
+BuildDatabase::IsScriptUpToDate(
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__in const std::string & OutBaseFile,
+	nwn2dev__in const ContentKey & SourceKey
+	)
+/*++
+
+Routine Description:
+
+	This routine determines whether the outputs of a script are up to date,
+	i.e. whether the script was last compiled, with the current compiler
+	options, from the same source text and include files, and its output files
+	have not since been altered.
+
+Arguments:
+
+	Compiler - Supplies the compiler, which is used to resolve include files.
+
+	OutBaseFile - Supplies the base name (potentially including path) of the
+	              output file.  No extension is present.
+
+	SourceKey - Supplies the content key of the script source text.
+
+Return Value:
+
+	The routine returns true if the script need not be recompiled.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ScriptMap::const_iterator it;
+	ULONG                     StartTime;
+	bool                      UpToDate;
+
+	StartTime = GetTickCount( );
+
+	m_Statistics.ScriptsChecked += 1;
+
+	it = m_Scripts.find( GetScriptKey( OutBaseFile ) );
+
+	if (it == m_Scripts.end( ))
+		UpToDate = false;
+	else
+		UpToDate = IsRecordCurrent( Compiler, OutBaseFile, it->second, SourceKey );
+
+	if (UpToDate)
+		m_Statistics.ScriptsUpToDate += 1;
+
+	m_Statistics.CheckTime += GetTickCount( ) - StartTime;
+
+	return UpToDate;
+}
+
+void
+BuildDatabase::RecordScript(
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__in const std::string & OutBaseFile,
+	nwn2dev__in const ContentKey & SourceKey,
+	nwn2dev__in const OutputFileVec & Outputs
+	)
+/*++
+
+Routine Description:
+
+	This routine records the result of a successful compilation of a script.
+
+Arguments:
+
+	Compiler - Supplies the compiler that compiled the script.  Its dependency
+	           list for the last compilation supplies the include closure.
+
+	OutBaseFile - Supplies the base name (potentially including path) of the
+	              output file.  No extension is present.
+
+	SourceKey - Supplies the content key of the script source text.
+
+	Outputs - Supplies the output files that were written.
+
+Return Value:
+
+	None.  On catastrophic failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< std::string > FileNames;
+	ScriptRecord               Record;
+
+	//
+	// Copy the dependency list, as resolving the include files below goes
+	// through the compiler's resource loader, which updates the list.
+	//
+
+	FileNames = Compiler.NscGetLastDependencies( );
+
+	if (std::find( FileNames.begin( ), FileNames.end( ), "nwscript.nss" ) == FileNames.end( ))
+		FileNames.push_back( "nwscript.nss" );
+
+	Record.SourceKey = SourceKey;
+	Record.Outputs   = Outputs;
+
+	for (std::vector< std::string >::const_iterator it = FileNames.begin( );
+	     it != FileNames.end( );
+	     ++it)
+	{
+		Dependency Dep;
+
+		Dep.FileName = *it;
+
+		//
+		// If an include file cannot be resolved now, the script cannot be
+		// reliably checked later, so just leave it out of the database.
+		//
+
+		if (!GetDependencyKey( Compiler, Dep.FileName, Dep.Key ))
+		{
+			ForgetScript( OutBaseFile );
+			return;
+		}
+
+		Record.Dependencies.push_back( Dep );
+	}
+
+	m_Scripts[ GetScriptKey( OutBaseFile ) ] = Record;
+	m_Statistics.ScriptsRecorded += 1;
+}
+
+void
+BuildDatabase::ForgetScript(
+	nwn2dev__in const std::string & OutBaseFile
+	)
+/*++
+
+Routine Description:
+
+	This routine removes the record of a script from the database.
+
+Arguments:
+
+	OutBaseFile - Supplies the base name (potentially including path) of the
+	              output file.  No extension is present.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	m_Scripts.erase( GetScriptKey( OutBaseFile ) );
+}
+
+std::string
+BuildDatabase::GetScriptKey(
+	nwn2dev__in const std::string & OutBaseFile
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the database key for a script, which is its output
+	base file name with path separators and case normalized.
+
+Arguments:
+
+	OutBaseFile - Supplies the base name (potentially including path) of the
+	              output file.  No extension is present.
+
+Return Value:
+
+	The routine returns the database key.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::string Key( OutBaseFile );
+
+	for (std::string::iterator it = Key.begin( ); it != Key.end( ); ++it)
+	{
+		if (*it == '\\')
+			*it = '/';
+		else
+			*it = (char) tolower( (int) (unsigned char) *it );
+	}
+
+	return Key;
+}
+
+bool
+BuildDatabase::IsRecordCurrent(
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__in const std::string & OutBaseFile,
+	nwn2dev__in const ScriptRecord & Record,
+	nwn2dev__in const ContentKey & SourceKey
+	)
+/*++
+
+Routine Description:
+
+	This routine compares a script record against the current source text,
+	include files and output files of the script.
+
+Arguments:
+
+	Compiler - Supplies the compiler, which is used to resolve include files.
+
+	OutBaseFile - Supplies the base name (potentially including path) of the
+	              output file.  No extension is present.
+
+	Record - Supplies the script record to check.
+
+	SourceKey - Supplies the content key of the script source text.
+
+Return Value:
+
+	The routine returns true if nothing that the record covers has changed.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ContentKey Key;
+
+	if (!(Record.SourceKey == SourceKey))
+		return false;
+
+	for (DependencyVec::const_iterator it = Record.Dependencies.begin( );
+	     it != Record.Dependencies.end( );
+	     ++it)
+	{
+		if (!GetDependencyKey( Compiler, it->FileName, Key ))
+			return false;
+
+		if (!(it->Key == Key))
+			return false;
+	}
+
+	for (OutputFileVec::const_iterator it = Record.Outputs.begin( );
+	     it != Record.Outputs.end( );
+	     ++it)
+	{
+		if (!GetFileKey( OutBaseFile + it->Extension, Key ))
+			return false;
+
+		if (!(it->Key == Key))
+			return false;
+	}
+
+	return true;
+}
+
+bool
+BuildDatabase::GetDependencyKey(
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__in const std::string & FileName,
+	nwn2dev__out ContentKey & Key
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the content key of an include file, resolving the
+	file through the compiler's resource loader (and thus with the same
+	search order as a compilation).  Each include file is only hashed once
+	per run.
+
+Arguments:
+
+	Compiler - Supplies the compiler, which is used to resolve include files.
+
+	FileName - Supplies the file name (resource name and extension) of the
+	           include file.
+
+	Key - Receives the content key of the include file.
+
+Return Value:
+
+	The routine returns true if the include file was resolved, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	DependencyKeyMap::const_iterator   it;
+	std::string::size_type             Offs;
+	std::string                        ResName;
+	NWN::ResType                       ResType;
+	unsigned char                    * Contents;
+	UINT32                             Size;
+	bool                               Allocated;
+
+	it = m_DependencyKeys.find( FileName );
+
+	if (it != m_DependencyKeys.end( ))
+	{
+		Key = it->second;
+		return true;
+	}
+
+	Offs = FileName.find_last_of( '.' );
+
+	if (Offs == std::string::npos)
+		return false;
+
+	ResName = FileName.substr( 0, Offs );
+	ResType = m_ResourceManager.ExtToResType( FileName.c_str( ) + Offs + 1 );
+
+	if (ResType == NWN::ResINVALID)
+		return false;
+
+	Contents = Compiler.LoadResource(
+		ResName.c_str( ),
+		ResType,
+		&Size,
+		&Allocated);
+
+	if (Contents == NULL)
+		return false;
+
+	Key = ResourceDedupStore::HashContents( Contents, Size );
+
+	if (Allocated)
+		free( Contents );
+
+	m_DependencyKeys.insert( DependencyKeyMap::value_type( FileName, Key ) );
+	m_Statistics.DependenciesHashed += 1;
+
+	return true;
+}
+
+bool
+BuildDatabase::GetFileKey(
+	nwn2dev__in const std::string & FileName,
+	nwn2dev__out ContentKey & Key
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the content key of a file on disk.
+
+Arguments:
+
+	FileName - Supplies the path of the file.
+
+	Key - Receives the content key of the file.
+
+Return Value:
+
+	The routine returns true if the file was read, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FILE                         * f;
+	std::vector< unsigned char >   Contents;
+	long                           Size;
+	bool                           Status;
+
+	f = fopen( FileName.c_str( ), "rb" );
+
+	if (f == NULL)
+		return false;
+
+	Status = false;
+
+	try
+	{
+		if ((fseek( f, 0, SEEK_END ) == 0) &&
+		    ((Size = ftell( f )) >= 0)      &&
+		    (fseek( f, 0, SEEK_SET ) == 0))
+		{
+			Contents.resize( (size_t) Size );
+
+			if ((Contents.empty( )) ||
+			    (fread( &Contents[ 0 ], Contents.size( ), 1, f ) == 1))
+			{
+				Key = ResourceDedupStore::HashContents(
+					(!Contents.empty( )) ? &Contents[ 0 ] : NULL,
+					Contents.size( ));
+
+				Status = true;
+			}
+		}
+	}
+	catch (std::exception)
+	{
+		Status = false;
+	}
+
+	fclose( f );
+
+	return Status;
+}
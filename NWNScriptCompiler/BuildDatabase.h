@@ -0,0 +1,221 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	BuildDatabase.h
+
+Abstract:
+
+	This module defines the BuildDatabase class, which supports incremental
+	rebuilds in the compiler driver.
+
+	For each script that was compiled, the build database records the content
+	key of the script source text, the content key of every file in the
+	script's include closure (as reported by the compiler, plus nwscript.nss),
+	and the content keys of the output files that were written.  The database
+	also records a fingerprint of the compiler options in effect.
+
+	On a subsequent run, a script is only recompiled if its source text, any
+	file in its include closure, any of its output files, or the compiler
+	options have changed.  Include files are resolved through the compiler's
+	own resource loader, so the check sees exactly the files that a compile
+	would, whether they are drawn from a directory, a module ERF or the base
+	game resources.
+
+--*/
+
+#ifndef _PROGRAMS_NWNSCRIPTCOMPILER_BUILDDATABASE_H
+#define _PROGRAMS_NWNSCRIPTCOMPILER_BUILDDATABASE_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+class BuildDatabase
+{
+
+public:
+
+	typedef ResourceDedupStore::ContentKey ContentKey;
+
+	//
+	// Define an output file of a script, with the extension that is appended
+	// to the output base file name (e.g. ".ncs") and its content key.
+	//
+
+	struct OutputFile
+	{
+		std::string Extension;
+		ContentKey  Key;
+	};
+
+	typedef std::vector< OutputFile > OutputFileVec;
+
+	//
+	// Define the counters that are reported for a run.  Times are in
+	// milliseconds.
+	//
+
+	struct BuildStatistics
+	{
+		unsigned long ScriptsChecked;
+		unsigned long ScriptsUpToDate;
+		unsigned long ScriptsRecorded;
+		unsigned long DependenciesHashed;
+		ULONG         CheckTime;
+	};
+
+	BuildDatabase(
+		nwn2dev__in ResourceManager & ResMan
+		);
+
+	~BuildDatabase(
+		);
+
+	//
+	// Load the build database from disk.  A missing database file is treated
+	// as an empty database.  If the database was written with different
+	// compiler options than those supplied, then all records are discarded so
+	// that every script is rebuilt.  The routine returns false if the file
+	// existed but could not be parsed (in which case the database is empty).
+	//
+
+	bool
+	Load(
+		nwn2dev__in const std::string & FileName,
+		nwn2dev__in const std::string & Options
+		);
+
+	//
+	// Write the build database to disk.  The database is written to a
+	// temporary file that then replaces the database file, so that an
+	// interrupted write does not leave a truncated database.  On failure, an
+	// std::exception is raised.
+	//
+
+	void
+	Save(
+		nwn2dev__in const std::string & FileName
+		) const;
+
+	//
+	// Determine whether the outputs of a script are up to date with respect
+	// to its source text and include closure.
+	//
+
+	bool
+	IsScriptUpToDate(
+		nwn2dev__in NscCompiler & Compiler,
+		nwn2dev__in const std::string & OutBaseFile,
+		nwn2dev__in const ContentKey & SourceKey
+		);
+
+	//
+	// Record the result of a successful compilation of a script.  The include
+	// closure is taken from the compiler's dependency list for the last
+	// compilation.  Include-only scripts are recorded with no output files.
+	//
+
+	void
+	RecordScript(
+		nwn2dev__in NscCompiler & Compiler,
+		nwn2dev__in const std::string & OutBaseFile,
+		nwn2dev__in const ContentKey & SourceKey,
+		nwn2dev__in const OutputFileVec & Outputs
+		);
+
+	//
+	// Forget a script, e.g. because its compilation failed, so that it is
+	// rebuilt on the next run.
+	//
+
+	void
+	ForgetScript(
+		nwn2dev__in const std::string & OutBaseFile
+		);
+
+	inline
+	const BuildStatistics &
+	GetStatistics(
+		) const
+	{
+		return m_Statistics;
+	}
+
+private:
+
+	struct Dependency
+	{
+		std::string FileName;
+		ContentKey  Key;
+	};
+
+	typedef std::vector< Dependency > DependencyVec;
+
+	struct ScriptRecord
+	{
+		ContentKey    SourceKey;
+		DependencyVec Dependencies;
+		OutputFileVec Outputs;
+	};
+
+	typedef std::map< std::string, ScriptRecord > ScriptMap;
+	typedef std::map< std::string, ContentKey > DependencyKeyMap;
+
+	//
+	// Return the database key for a script output base file name.
+	//
+
+	static
+	std::string
+	GetScriptKey(
+		nwn2dev__in const std::string & OutBaseFile
+		);
+
+	//
+	// Compare a script record against the current source text, include files
+	// and output files.
+	//
+
+	bool
+	IsRecordCurrent(
+		nwn2dev__in NscCompiler & Compiler,
+		nwn2dev__in const std::string & OutBaseFile,
+		nwn2dev__in const ScriptRecord & Record,
+		nwn2dev__in const ContentKey & SourceKey
+		);
+
+	//
+	// Compute the content key of an include file, as resolved by the
+	// compiler.  Keys are computed once per run.
+	//
+
+	bool
+	GetDependencyKey(
+		nwn2dev__in NscCompiler & Compiler,
+		nwn2dev__in const std::string & FileName,
+		nwn2dev__out ContentKey & Key
+		);
+
+	//
+	// Compute the content key of a file on disk.
+	//
+
+	static
+	bool
+	GetFileKey(
+		nwn2dev__in const std::string & FileName,
+		nwn2dev__out ContentKey & Key
+		);
+
+	ResourceManager  & m_ResourceManager;
+	std::string        m_Options;
+	ScriptMap          m_Scripts;
+	DependencyKeyMap   m_DependencyKeys;
+	BuildStatistics    m_Statistics;
+
+};
+
+#endif
@@ -19,7 +19,9 @@ Abstract:
 #include "../NWN2DataLib/ResourceManager.h"
 #include "../NWN2DataLib/GffFileWriter.h"
 #include "../NWN2DataLib/NWScriptReader.h"
+#include "../NWN2DataLib/ParallelWorkQueue.h"
 #include "../NWNScriptCompilerLib/Nsc.h"
+#include "BuildDatabase.h"
 
 typedef std::vector< std::wstring > WStringVec;
 typedef std::vector< const wchar_t * > WStringArgVec;
@@ -317,6 +319,113 @@ private:
 
 };
 
+class NullTextOut : public IDebugTextOut
+{
+
+public:
+
+	inline
+	NullTextOut(
+		)
+	{
+	}
+
+	inline
+	~NullTextOut(
+		)
+	{
+	}
+
+	enum { STD_COLOR = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE };
+
+	inline
+	virtual
+	void
+	WriteText(
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		...
+		)
+	{
+		va_list ap;
+
+		va_start( ap, fmt );
+		WriteTextV( STD_COLOR, fmt, ap );
+		va_end( ap );
+	}
+
+	inline
+	virtual
+	void
+	WriteText(
+		nwn2dev__in WORD Attributes,
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		...
+		)
+	{
+		va_list ap;
+
+		va_start( ap, fmt );
+		WriteTextV( Attributes, fmt, ap );
+		va_end( ap );
+
+		UNREFERENCED_PARAMETER( Attributes );
+	}
+
+	inline
+	virtual
+	void
+	WriteTextV(
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		nwn2dev__in va_list ap
+		)
+	{
+		WriteTextV( STD_COLOR, fmt, ap );
+	}
+
+	inline
+	virtual
+	void
+	WriteTextV(
+		nwn2dev__in WORD Attributes,
+		nwn2dev__in const char *fmt,
+		nwn2dev__in va_list argptr
+		)
+	/*++
+
+	Routine Description:
+
+		This routine discards text.  It is used to silence diagnostics that
+		have already been shown once, such as those of compilations repeated
+		on worker threads.
+
+	Arguments:
+
+		Attributes - Supplies color attributes for the text as per the standard
+					 SetConsoleTextAttribute API (e.g. FOREGROUND_RED).
+
+		fmt - Supplies the printf-style format string to use to display text.
+
+		argptr - Supplies format inserts.
+
+	Return Value:
+
+		None.
+
+	Environment:
+
+		User mode.
+
+	--*/
+	{
+		UNREFERENCED_PARAMETER( Attributes );
+		UNREFERENCED_PARAMETER( fmt );
+		UNREFERENCED_PARAMETER( argptr );
+	}
+
+private:
+
+};
+
 //
 // No reason these should be globals, except for ease of access to the debugger
 // right now.
@@ -324,12 +433,31 @@ private:
 
 PrintfTextOut               g_TextOut;
 ResourceManager           * g_ResMan;
+NullTextOut                 g_NullTextOut;
+
+//
+// Define the action table handed to the analyzer, built from the compiler's
+// nwscript.nss.  The definitions point into the prototype and type lists.
+//
+
+struct ActionTable
+{
+	std::vector< NWACTION_DEFINITION >          ActionDefs;
+	std::list< NscPrototypeDefinition >         ActionPrototypes;
+	std::list< std::vector< NWACTION_TYPE > >   ActionTypes;
+};
 
 NWACTION_TYPE
 ConvertNscType(
 	nwn2dev__in NscType Type
 	);
 
+void
+BuildActionTable(
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__out ActionTable & Actions
+	);
+
 BOOL
 WINAPI
 AppConsoleCtrlHandler(
@@ -1009,7 +1137,8 @@ CompileSourceFile(
 	nwn2dev__in UINT32 CompilerFlags,
 	nwn2dev__in const NWN::ResRef32 & InFile,
 	nwn2dev__in const std::vector< unsigned char > & InFileContents,
-	nwn2dev__in const std::string & OutBaseFile
+	nwn2dev__in const std::string & OutBaseFile,
+	__inout_opt BuildDatabase * BuildDb
 	)
 /*++
 
@@ -1054,6 +1183,10 @@ Arguments:
 	OutBaseFile - Supplies the base name (potentially including path) of the
 	              output file.  No extension is present.
 
+	BuildDb - Optionally supplies the build database for an incremental build.
+	          If supplied, the script is skipped if it is already up to date,
+	          and the outcome of the compilation is recorded in the database.
+
 Return Value:
 
 	The routine returns a Boolean value indicating true on success, else false
@@ -1072,6 +1205,34 @@ Environment:
 	NscResult                      Result;
 	std::string                    FileName;
 	FILE                         * f;
+	BuildDatabase::ContentKey      SourceKey;
+	BuildDatabase::OutputFileVec   Outputs;
+
+	if (BuildDb != NULL)
+	{
+		SourceKey = ResourceDedupStore::HashContents(
+			(!InFileContents.empty( )) ? &InFileContents[ 0 ] : NULL,
+			InFileContents.size( ));
+
+		if (BuildDb->IsScriptUpToDate( Compiler, OutBaseFile, SourceKey ))
+		{
+			if (!Quiet)
+			{
+				TextOut->WriteText(
+					"Up to date: %.32s.NSS\n",
+					InFile.RefStr);
+			}
+
+			return true;
+		}
+
+		//
+		// Forget the script up front, so that it is rebuilt next time unless
+		// it is recorded again below after a successful compilation.
+		//
+
+		BuildDb->ForgetScript( OutBaseFile );
+	}
 
 	if (!Quiet)
 	{
@@ -1113,6 +1274,15 @@ Environment:
 				InFile.RefStr);
 		}
 
+		if (BuildDb != NULL)
+		{
+			BuildDb->RecordScript(
+				Compiler,
+				OutBaseFile,
+				SourceKey,
+				Outputs);
+		}
+
 		return true;
 
 	case NscResult_Success:
@@ -1197,10 +1367,7 @@ Environment:
 	{
 		try
 		{
-			std::vector< NWACTION_DEFINITION >          ActionDefs;
-			std::list< NscPrototypeDefinition >         ActionPrototypes;
-			std::list< std::vector< NWACTION_TYPE > >   ActionTypes;
-			NWSCRIPT_ACTION                             ActionId;
+			ActionTable Actions;
 
 			//
 			// Build the action definition table for the static analysis phase.
@@ -1208,48 +1375,7 @@ Environment:
 			// nwscript.nss
 			//
 
-			for (ActionId = 0;
-				  ;
-				  ActionId += 1)
-			{
-				NWACTION_DEFINITION          ActionDef;
-				NscPrototypeDefinition       ActionPrototype;
-
-				if (!Compiler.NscGetActionPrototype( (int) ActionId, ActionPrototype ))
-					break;
-
-				ActionPrototypes.push_back( ActionPrototype );
-
-				ZeroMemory( &ActionDef, sizeof( ActionDef ) );
-
-				ActionDef.Name            = ActionPrototypes.back( ).Name.c_str( );
-				ActionDef.ActionId        = ActionId;
-				ActionDef.MinParameters   = ActionPrototype.MinParameters;
-				ActionDef.NumParameters   = ActionPrototype.NumParameters;
-				ActionDef.ReturnType      = ConvertNscType( ActionPrototype.ReturnType );
-
-				//
-				// Convert parameter types over.
-				//
-
-				ActionTypes.push_back( std::vector< NWACTION_TYPE >( ) );
-				std::vector< NWACTION_TYPE > & ReturnTypes = ActionTypes.back( );
-
-				ReturnTypes.resize( ActionPrototype.ParameterTypes.size( ) );
-
-				for (size_t i = 0; i < ActionPrototype.ParameterTypes.size( ); i += 1)
-				{
-					ReturnTypes[ i ] = ConvertNscType(
-						ActionPrototype.ParameterTypes[ i ] );
-				}
-
-				if (!ReturnTypes.empty( ))
-					ActionDef.ParameterTypes = &ReturnTypes[ 0 ];
-				else
-					ActionDef.ParameterTypes = NULL;
-			
-				ActionDefs.push_back( ActionDef );
-			}
+			BuildActionTable( Compiler, Actions );
 
 			FileName  = OutBaseFile;
 			FileName += ".ncs";
@@ -1275,8 +1401,8 @@ Environment:
 
 			NWScriptAnalyzer ScriptAnalyzer(
 				TextOut,
-				(!ActionDefs.empty( )) ? &ActionDefs[ 0 ] : NULL,
-				(NWSCRIPT_ACTION) ActionDefs.size( ));
+				(!Actions.ActionDefs.empty( )) ? &Actions.ActionDefs[ 0 ] : NULL,
+				(NWSCRIPT_ACTION) Actions.ActionDefs.size( ));
 
 			ScriptAnalyzer.Analyze(
 				&ScriptReader,
@@ -1305,6 +1431,34 @@ Environment:
 		}
 	}
 
+	if (BuildDb != NULL)
+	{
+		BuildDatabase::OutputFile Output;
+
+		Output.Extension = ".ncs";
+		Output.Key       = ResourceDedupStore::HashContents(
+			(!Code.empty( )) ? &Code[ 0 ] : NULL,
+			Code.size( ));
+
+		Outputs.push_back( Output );
+
+		if (!SuppressDebugSymbols)
+		{
+			Output.Extension = ".ndb";
+			Output.Key       = ResourceDedupStore::HashContents(
+				(!Symbols.empty( )) ? &Symbols[ 0 ] : NULL,
+				Symbols.size( ));
+
+			Outputs.push_back( Output );
+		}
+
+		BuildDb->RecordScript(
+			Compiler,
+			OutBaseFile,
+			SourceKey,
+			Outputs);
+	}
+
 	return true;
 }
 
@@ -1359,6 +1513,80 @@ Environment:
 	}
 }
 
+void
+BuildActionTable(
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__out ActionTable & Actions
+	)
+/*++
+
+Routine Description:
+
+	This routine builds the analyzer action definition table from the action
+	prototypes of the nwscript.nss that the compiler was initialized with.
+
+Arguments:
+
+	Compiler - Supplies the (initialized) compiler context.
+
+	Actions - Receives the action table.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	NWSCRIPT_ACTION ActionId;
+
+	for (ActionId = 0;
+		  ;
+		  ActionId += 1)
+	{
+		NWACTION_DEFINITION          ActionDef;
+		NscPrototypeDefinition       ActionPrototype;
+
+		if (!Compiler.NscGetActionPrototype( (int) ActionId, ActionPrototype ))
+			break;
+
+		Actions.ActionPrototypes.push_back( ActionPrototype );
+
+		ZeroMemory( &ActionDef, sizeof( ActionDef ) );
+
+		ActionDef.Name            = Actions.ActionPrototypes.back( ).Name.c_str( );
+		ActionDef.ActionId        = ActionId;
+		ActionDef.MinParameters   = ActionPrototype.MinParameters;
+		ActionDef.NumParameters   = ActionPrototype.NumParameters;
+		ActionDef.ReturnType      = ConvertNscType( ActionPrototype.ReturnType );
+
+		//
+		// Convert parameter types over.
+		//
+
+		Actions.ActionTypes.push_back( std::vector< NWACTION_TYPE >( ) );
+		std::vector< NWACTION_TYPE > & ReturnTypes = Actions.ActionTypes.back( );
+
+		ReturnTypes.resize( ActionPrototype.ParameterTypes.size( ) );
+
+		for (size_t i = 0; i < ActionPrototype.ParameterTypes.size( ); i += 1)
+		{
+			ReturnTypes[ i ] = ConvertNscType(
+				ActionPrototype.ParameterTypes[ i ] );
+		}
+
+		if (!ReturnTypes.empty( ))
+			ActionDef.ParameterTypes = &ReturnTypes[ 0 ];
+		else
+			ActionDef.ParameterTypes = NULL;
+	
+		Actions.ActionDefs.push_back( ActionDef );
+	}
+}
+
 bool
 DisassembleScriptFile(
 	nwn2dev__in ResourceManager & ResMan,
@@ -1783,7 +2011,8 @@ ProcessInputFile(
 	nwn2dev__in IDebugTextOut * TextOut,
 	nwn2dev__in UINT32 CompilerFlags,
 	nwn2dev__in const std::string & InFile,
-	nwn2dev__in const std::string & OutBaseFile
+	nwn2dev__in const std::string & OutBaseFile,
+	__inout_opt BuildDatabase * BuildDb
 	)
 /*++
 
@@ -1831,6 +2060,9 @@ Arguments:
 	OutBaseFile - Supplies the base name (potentially including path) of the
 	              output file.  No extension is present.
 
+	BuildDb - Optionally supplies the build database for an incremental build.
+	          The build database is only used when compiling.
+
 Return Value:
 
 	The routine returns a Boolean value indicating true on success, else false
@@ -1884,7 +2116,8 @@ Environment:
 			CompilerFlags,
 			FileResRef,
 			InFileContents,
-			OutBaseFile);
+			OutBaseFile,
+			BuildDb);
 			
 	}
 	else
@@ -1947,7 +2180,8 @@ ProcessWildcardInputFile(
 	nwn2dev__in IDebugTextOut * TextOut,
 	nwn2dev__in UINT32 CompilerFlags,
 	nwn2dev__in const std::string & InFile,
-	nwn2dev__in const std::string & BatchOutDir
+	nwn2dev__in const std::string & BatchOutDir,
+	__inout_opt BuildDatabase * BuildDb
 	)
 /*++
 
@@ -2000,6 +2234,9 @@ Arguments:
 	BatchOutDir - Supplies the batch compilation mode output directory.  This
 	              may be empty (or else it must end in a path separator).
 
+	BuildDb - Optionally supplies the build database for an incremental build.
+	          The build database is only used when compiling.
+
 Return Value:
 
 	The routine returns a Boolean value indicating true on success, else false
@@ -2099,7 +2336,8 @@ Environment:
 			&g_TextOut,
 			CompilerFlags,
 			MatchedFile,
-			OutFile);
+			OutFile,
+			BuildDb);
 
 		if (!ThisStatus)
 		{
@@ -2127,37 +2365,850 @@ Environment:
 	return Status;
 }
 
+//
+// Define the state of a script compiled by the multithreaded compilation
+// check.  The reference output is produced on the main thread, and each
+// script is then compiled again by exactly one worker, which records whether
+// its output differed.
+//
+
+struct ThreadCheckScript
+{
+	std::string                  FileName;
+	NWN::ResRef32                ResRef;
+	std::vector< unsigned char > Contents;
+	NscResult                    Result;
+	std::vector< unsigned char > Code;
+	std::vector< unsigned char > Symbols;
+	bool                         Mismatch;
+};
+
+typedef std::vector< ThreadCheckScript > ThreadCheckScriptVec;
+
+struct ThreadCheckWorker
+{
+	NscCompiler          * Compiler;
+	ThreadCheckScriptVec * Scripts;
+	size_t                 First;
+	size_t                 Stride;
+	int                    CompilerVersion;
+	bool                   Optimize;
+	UINT32                 CompilerFlags;
+};
+
+typedef swutil::SharedPtr< NscCompiler > NscCompilerPtr;
+
 bool
-LoadResponseFile(
-	nwn2dev__in int argc,
-	__in_ecount( argc ) wchar_t * * argv,
-	nwn2dev__in const wchar_t * ResponseFileName,
-	nwn2dev__out WStringVec & Args,
-	nwn2dev__out WStringArgVec & ArgVector
+ExpandInputFiles(
+	nwn2dev__in const std::vector< std::string > & InFiles,
+	nwn2dev__in IDebugTextOut * TextOut,
+	nwn2dev__out std::vector< std::string > & Files
 	)
 /*++
 
 Routine Description:
 
-	This routine loads command line arguments from a response file.  Each line
-	represents an argument.  The contents are read into a vector for later
-	processing.
+	This routine expands a list of input file names, which may contain
+	wildcards, into the list of matching files.
 
 Arguments:
 
-	argc - Supplies the original command line argument count.
-
-	argv - Supplies the original command line argument vector.
-
-	ResponseFileName - Supplies the file name of the response file.
+	InFiles - Supplies the input file names.
 
-	Args - Received the lines in the response file.
+	TextOut - Supplies the text out interface used to receive any diagnostics
+	          issued.
 
-	ArgVector - Receives an array of pointers to the each line in Args.
+	Files - Receives the matching file names.
 
 Return Value:
 
-	The routine returns a Boolean value indicating true if the response file was
+	The routine returns a Boolean value indicating true on success, else false
+	if a wildcard was malformed or matched no files.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	for (std::vector< std::string >::const_iterator it = InFiles.begin( );
+	     it != InFiles.end( );
+	     ++it)
+	{
+		struct _finddata_t FindData;
+		intptr_t           FindHandle;
+		char               Drive[ _MAX_DRIVE ];
+		char               Dir[ _MAX_DIR ];
+		std::string        WildcardRoot;
+
+		if (it->find_first_of( "*?" ) == std::string::npos)
+		{
+			Files.push_back( *it );
+			continue;
+		}
+
+		if (_splitpath_s(
+			it->c_str( ),
+			Drive,
+			_MAX_DRIVE,
+			Dir,
+			_MAX_DIR,
+			NULL,
+			0,
+			NULL,
+			0))
+		{
+			TextOut->WriteText(
+				"Error: Malformed input wildcard path \"%s\".\n", it->c_str( ));
+
+			return false;
+		}
+
+		WildcardRoot  = Drive;
+		WildcardRoot += Dir;
+
+		FindHandle = _findfirst( it->c_str( ), &FindData );
+
+		if (FindHandle == -1)
+		{
+			TextOut->WriteText(
+				"Error: No matching files for input wildcard path \"%s\".\n",
+				it->c_str( ));
+
+			return false;
+		}
+
+		do
+		{
+			if (FindData.attrib & _A_SUBDIR)
+				continue;
+
+			Files.push_back( WildcardRoot + FindData.name );
+		} while (!_findnext( FindHandle, &FindData )) ;
+
+		_findclose( FindHandle );
+	}
+
+	return true;
+}
+
+void
+__stdcall
+ThreadCheckWorkRoutine(
+	nwn2dev__in void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine is the work item of the multithreaded compilation check.  It
+	compiles its share of the scripts with its own compiler instance and
+	compares the output against the single threaded reference output.
+
+	Diagnostics are discarded, as they were shown by the reference pass.
+
+Arguments:
+
+	Context - Supplies the ThreadCheckWorker describing the work.
+
+Return Value:
+
+	None.  On catastrophic failure, an std::exception is raised, which is
+	reported by the work queue.
+
+Environment:
+
+	User mode, worker thread.
+
+--*/
+{
+	ThreadCheckWorker            * Worker = (ThreadCheckWorker *) Context;
+	std::vector< unsigned char >   Code;
+	std::vector< unsigned char >   Symbols;
+	NscResult                      Result;
+
+	for (size_t i = Worker->First;
+	     i < Worker->Scripts->size( );
+	     i += Worker->Stride)
+	{
+		ThreadCheckScript & Script = (*Worker->Scripts)[ i ];
+
+		Code.clear( );
+		Symbols.clear( );
+
+		Result = Worker->Compiler->NscCompileScript(
+			Script.ResRef,
+			(!Script.Contents.empty( )) ? &Script.Contents[ 0 ] : NULL,
+			Script.Contents.size( ),
+			Worker->CompilerVersion,
+			Worker->Optimize,
+			true,
+			&g_NullTextOut,
+			Worker->CompilerFlags,
+			Code,
+			Symbols);
+
+		Script.Mismatch = (Result != Script.Result)   ||
+		                  (Code != Script.Code)       ||
+		                  (Symbols != Script.Symbols);
+	}
+}
+
+bool
+CheckMultithreadedCompile(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__in unsigned long Threads,
+	nwn2dev__in int CompilerVersion,
+	nwn2dev__in bool Optimize,
+	nwn2dev__in bool EnableExtensions,
+	nwn2dev__in bool Quiet,
+	nwn2dev__in IDebugTextOut * TextOut,
+	nwn2dev__in UINT32 CompilerFlags,
+	nwn2dev__in const std::vector< std::string > & SearchPaths,
+	nwn2dev__in const std::string & ErrorPrefix,
+	nwn2dev__in const std::vector< std::string > & InFiles
+	)
+/*++
+
+Routine Description:
+
+	This routine verifies that the compiler produces the same output when
+	several compiler instances run concurrently as it does on a single thread.
+
+	Each input file is first compiled on the calling thread.  The files are
+	then divided among a set of worker threads, each with its own compiler
+	instance sharing the parsed nwscript.nss of the main compiler, and
+	compiled again.  The compiled code and debug symbols of every script must
+	be byte for byte identical to those of the single threaded compilation.
+
+	No output files are written.
+
+Arguments:
+
+	ResMan - Supplies the resource manager to use to service file load requests.
+
+	Compiler - Supplies the compiler context used for the single threaded
+	           compilation, whose nwscript.nss is shared with the workers.
+
+	Threads - Supplies the number of worker threads.
+
+	CompilerVersion - Supplies the BioWare-compatible compiler version number.
+
+	Optimize - Supplies a Boolean value indicating true if the scripts should
+	           be optimized.
+
+	EnableExtensions - Supplies a Boolean value indicating true if non-BioWare
+	                   extensions are enabled.
+
+	Quiet - Supplies a Boolean value that indicates true if non-critical
+	        messages should be silenced.
+
+	TextOut - Supplies the text out interface used to receive any diagnostics
+	          issued.
+
+	CompilerFlags - Supplies compiler control flags.  Legal values are drawn
+	                from the NscCompilerFlags enumeration.
+
+	SearchPaths - Supplies the include paths of the main compiler.
+
+	ErrorPrefix - Supplies the error prefix of the main compiler, if any.
+
+	InFiles - Supplies the input file names, which may contain wildcards.
+
+Return Value:
+
+	The routine returns a Boolean value indicating true if every script
+	compiled and produced identical output on all threads, else false.
+
+	On catastrophic failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< std::string >       Files;
+	ThreadCheckScriptVec             Scripts;
+	std::vector< NscCompilerPtr >    Compilers;
+	std::vector< ThreadCheckWorker > Workers;
+	unsigned long                    Failures;
+	unsigned long                    Mismatches;
+	ULONG                            SingleTime;
+	ULONG                            ParallelTime;
+	ULONG                            StartTime;
+
+	if (!ExpandInputFiles( InFiles, TextOut, Files ))
+		return false;
+
+	Scripts.resize( Files.size( ) );
+
+	for (size_t i = 0; i < Files.size( ); i += 1)
+	{
+		NWN::ResType FileResType;
+
+		Scripts[ i ].FileName = Files[ i ];
+		Scripts[ i ].Mismatch = false;
+
+		if (!LoadInputFile(
+			ResMan,
+			TextOut,
+			Files[ i ],
+			Scripts[ i ].ResRef,
+			FileResType,
+			Scripts[ i ].Contents))
+		{
+			TextOut->WriteText(
+				"Error: Unable to read input file '%s'.\n", Files[ i ].c_str( ) );
+
+			return false;
+		}
+	}
+
+	//
+	// Produce the reference output on this thread.  This also initializes the
+	// main compiler, so that its nwscript.nss can be shared below.
+	//
+
+	Failures  = 0;
+	StartTime = GetTickCount( );
+
+	for (ThreadCheckScriptVec::iterator it = Scripts.begin( );
+	     it != Scripts.end( );
+	     ++it)
+	{
+		it->Result = Compiler.NscCompileScript(
+			it->ResRef,
+			(!it->Contents.empty( )) ? &it->Contents[ 0 ] : NULL,
+			it->Contents.size( ),
+			CompilerVersion,
+			Optimize,
+			true,
+			TextOut,
+			CompilerFlags,
+			it->Code,
+			it->Symbols);
+
+		if (it->Result == NscResult_Failure)
+		{
+			TextOut->WriteText(
+				"Error: Failed to compile \"%s\".\n",
+				it->FileName.c_str( ));
+
+			Failures += 1;
+		}
+	}
+
+	SingleTime = GetTickCount( ) - StartTime;
+
+	//
+	// Create the worker compilers.  These are configured as the main compiler
+	// is, and adopt its nwscript.nss so that they do not parse it again.
+	//
+
+	if (Threads > Scripts.size( ))
+		Threads = (unsigned long) Scripts.size( );
+
+	for (unsigned long t = 0; t < Threads; t += 1)
+	{
+		NscCompilerPtr    WorkerCompiler( new NscCompiler( ResMan, EnableExtensions ) );
+		ThreadCheckWorker Worker;
+
+		if (!SearchPaths.empty( ))
+			WorkerCompiler->NscSetIncludePaths( SearchPaths );
+
+		if (!ErrorPrefix.empty( ))
+			WorkerCompiler->NscSetCompilerErrorPrefix( ErrorPrefix.c_str( ) );
+
+		WorkerCompiler->NscSetResourceCacheEnabled( true );
+
+		if (!WorkerCompiler->NscShareNWScript( Compiler, CompilerVersion ))
+		{
+			TextOut->WriteText(
+				"Error: Unable to share nwscript.nss with worker compiler %lu.\n",
+				t);
+
+			return false;
+		}
+
+		Compilers.push_back( WorkerCompiler );
+
+		Worker.Compiler        = WorkerCompiler.get( );
+		Worker.Scripts         = &Scripts;
+		Worker.First           = t;
+		Worker.Stride          = Threads;
+		Worker.CompilerVersion = CompilerVersion;
+		Worker.Optimize        = Optimize;
+		Worker.CompilerFlags   = CompilerFlags;
+
+		Workers.push_back( Worker );
+	}
+
+	//
+	// Compile the scripts again, concurrently, and compare the output.
+	//
+
+	StartTime = GetTickCount( );
+
+	{
+		ParallelWorkQueue WorkQueue( Threads > 1 );
+
+		for (std::vector< ThreadCheckWorker >::iterator it = Workers.begin( );
+		     it != Workers.end( );
+		     ++it)
+		{
+			WorkQueue.QueueWork( ThreadCheckWorkRoutine, &*it );
+		}
+
+		WorkQueue.WaitForAll( );
+	}
+
+	ParallelTime = GetTickCount( ) - StartTime;
+	Mismatches   = 0;
+
+	for (ThreadCheckScriptVec::const_iterator it = Scripts.begin( );
+	     it != Scripts.end( );
+	     ++it)
+	{
+		if (!it->Mismatch)
+			continue;
+
+		TextOut->WriteText(
+			"Error: \"%s\" compiled differently on %lu threads than on a single thread.\n",
+			it->FileName.c_str( ),
+			Threads);
+
+		Mismatches += 1;
+	}
+
+	if ((!Quiet) || (Mismatches != 0))
+	{
+		TextOut->WriteText(
+			"Multithreaded check: %lu script(s), %lu failed, %lu mismatched; 1 thread = %lums, %lu thread(s) = %lums\n",
+			(unsigned long) Scripts.size( ),
+			Failures,
+			Mismatches,
+			SingleTime,
+			Threads,
+			ParallelTime);
+	}
+
+	return (Failures == 0) && (Mismatches == 0);
+}
+
+//
+// Define the structural summary of a compiled script that is compared by the
+// in line expansion check.  In line expansion may remove subroutines and fold
+// away conditional code, but it must not change the signature of the entry
+// point or introduce calls to actions that the script did not already make.
+//
+
+struct ScriptShape
+{
+	NWNScriptLib::ParameterList  EntryParameters;
+	NWNScriptLib::ReturnTypeList EntryReturnTypes;
+	std::set< uintptr_t >        Actions;
+	size_t                       Subroutines;
+};
+
+bool
+AnalyzeCompiledScript(
+	nwn2dev__in const std::string & ScriptName,
+	nwn2dev__in const std::vector< unsigned char > & Code,
+	nwn2dev__in ActionTable & Actions,
+	nwn2dev__in IDebugTextOut * TextOut,
+	nwn2dev__out ScriptShape & Shape
+	)
+/*++
+
+Routine Description:
+
+	This routine verifies a compiled script with the analyzer, and summarizes
+	the structure of the resulting IR.
+
+Arguments:
+
+	ScriptName - Supplies the name of the script, for diagnostics.
+
+	Code - Supplies the compiled script, including its NCS header.
+
+	Actions - Supplies the action table of the compiler's nwscript.nss.
+
+	TextOut - Supplies the text out interface used to receive any diagnostics
+	          issued.
+
+	Shape - Receives the structural summary of the script.
+
+Return Value:
+
+	The routine returns a Boolean value indicating true if the script passed
+	verification, else false.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	//
+	// The NCS header ("NCS V1.0", the 'B' program type opcode and the big
+	// endian file size) precedes the instruction stream.
+	//
+
+	const size_t NcsHeaderSize = 8 + 1 + 4;
+
+	if (Code.size( ) <= NcsHeaderSize)
+	{
+		TextOut->WriteText(
+			"Error: (Verifier error): Truncated compiled script \"%s\".\n",
+			ScriptName.c_str( ));
+
+		return false;
+	}
+
+	try
+	{
+		NWScriptReader ScriptReader(
+			ScriptName.c_str( ),
+			&Code[ NcsHeaderSize ],
+			Code.size( ) - NcsHeaderSize,
+			NULL,
+			0);
+
+		NWScriptAnalyzer ScriptAnalyzer(
+			TextOut,
+			(!Actions.ActionDefs.empty( )) ? &Actions.ActionDefs[ 0 ] : NULL,
+			(NWSCRIPT_ACTION) Actions.ActionDefs.size( ));
+
+		ScriptAnalyzer.Analyze(
+			&ScriptReader,
+			0 );
+
+		const NWNScriptLib::SubroutinePtrVec & Subroutines = ScriptAnalyzer.GetSubroutines( );
+
+		if (Subroutines.empty( ))
+			throw std::runtime_error( "script has no entry point" );
+
+		Shape.EntryParameters  = Subroutines.front( )->GetParameters( );
+		Shape.EntryReturnTypes = Subroutines.front( )->GetReturnTypes( );
+		Shape.Subroutines      = Subroutines.size( );
+
+		Shape.Actions.clear( );
+
+		for (NWNScriptLib::SubroutinePtrVec::const_iterator it = Subroutines.begin( );
+		     it != Subroutines.end( );
+		     ++it)
+		{
+			const NWNScriptLib::ControlFlowSet & Flows = (*it)->GetControlFlows( );
+
+			for (NWNScriptLib::ControlFlowSet::const_iterator fit = Flows.begin( );
+			     fit != Flows.end( );
+			     ++fit)
+			{
+				const NWNScriptLib::InstructionList & IR = fit->second->GetIR( );
+
+				for (NWNScriptLib::InstructionList::const_iterator iit = IR.begin( );
+				     iit != IR.end( );
+				     ++iit)
+				{
+					if (iit->GetType( ) == NWScriptInstruction::I_ACTION)
+						Shape.Actions.insert( iit->GetActionIndex( ) );
+				}
+			}
+		}
+	}
+	catch (NWScriptAnalyzer::script_error &e)
+	{
+		TextOut->WriteText(
+			"Error: (Verifier error): Analyzer exception '%s' ('%s') at PC=%08X, SP=%08X analyzing script \"%s\".\n",
+			e.what( ),
+			e.specific( ),
+			(unsigned long) e.pc( ),
+			(unsigned long) e.stack_index( ),
+			ScriptName.c_str( ));
+
+		return false;
+	}
+	catch (std::exception &e)
+	{
+		TextOut->WriteText(
+			"Error: (Verifier error): Exception '%s' analyzing script \"%s\".\n",
+			e.what( ),
+			ScriptName.c_str( ));
+
+		return false;
+	}
+
+	return true;
+}
+
+bool
+CheckInlineCompile(
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__in int CompilerVersion,
+	nwn2dev__in bool Optimize,
+	nwn2dev__in bool Quiet,
+	nwn2dev__in IDebugTextOut * TextOut,
+	nwn2dev__in UINT32 CompilerFlags,
+	nwn2dev__in const std::vector< std::string > & InFiles
+	)
+/*++
+
+Routine Description:
+
+	This routine performs a differential check of in line function expansion
+	(the -f option).
+
+	Each input file is compiled without in line expansion, and then again
+	with it.  Both compilations must have the same outcome, both compiled
+	scripts must pass verification by the analyzer, the entry points must have
+	the same signature, and the in line expanded script must not call any
+	action that the script compiled without in line expansion does not call.
+
+	No output files are written.
+
+Arguments:
+
+	ResMan - Supplies the resource manager to use to service file load requests.
+
+	Compiler - Supplies the compiler context.
+
+	CompilerVersion - Supplies the BioWare-compatible compiler version number.
+
+	Optimize - Supplies a Boolean value indicating true if the scripts should
+	           be optimized when compiled without in line expansion.
+
+	Quiet - Supplies a Boolean value that indicates true if non-critical
+	        messages should be silenced.
+
+	TextOut - Supplies the text out interface used to receive any diagnostics
+	          issued.
+
+	CompilerFlags - Supplies compiler control flags.  Legal values are drawn
+	                from the NscCompilerFlags enumeration.
+
+	InFiles - Supplies the input file names, which may contain wildcards.
+
+Return Value:
+
+	The routine returns a Boolean value indicating true if every script
+	compiled and passed the check, else false.
+
+	On catastrophic failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	std::vector< std::string >   Files;
+	ActionTable                  Actions;
+	bool                         ActionsBuilt;
+	unsigned long                Scripts;
+	unsigned long                Failures;
+	unsigned long                Mismatches;
+	ULONGLONG                    BaseCodeSize;
+	ULONGLONG                    InlineCodeSize;
+
+	if (!ExpandInputFiles( InFiles, TextOut, Files ))
+		return false;
+
+	ActionsBuilt   = false;
+	Scripts        = 0;
+	Failures       = 0;
+	Mismatches     = 0;
+	BaseCodeSize   = 0;
+	InlineCodeSize = 0;
+
+	for (std::vector< std::string >::const_iterator it = Files.begin( );
+	     it != Files.end( );
+	     ++it)
+	{
+		NWN::ResRef32                FileResRef;
+		NWN::ResType                 FileResType;
+		std::vector< unsigned char > Contents;
+		std::vector< unsigned char > BaseCode;
+		std::vector< unsigned char > InlineCode;
+		std::vector< unsigned char > Symbols;
+		NscResult                    BaseResult;
+		NscResult                    InlineResult;
+		ScriptShape                  BaseShape;
+		ScriptShape                  InlineShape;
+
+		if (!LoadInputFile(
+			ResMan,
+			TextOut,
+			*it,
+			FileResRef,
+			FileResType,
+			Contents))
+		{
+			TextOut->WriteText(
+				"Error: Unable to read input file '%s'.\n", it->c_str( ) );
+
+			return false;
+		}
+
+		BaseResult = Compiler.NscCompileScript(
+			FileResRef,
+			(!Contents.empty( )) ? &Contents[ 0 ] : NULL,
+			Contents.size( ),
+			CompilerVersion,
+			Optimize,
+			true,
+			TextOut,
+			CompilerFlags & ~(NscCompilerFlag_OptimizeInline),
+			BaseCode,
+			Symbols);
+
+		if (BaseResult == NscResult_Failure)
+		{
+			TextOut->WriteText(
+				"Error: Failed to compile \"%s\".\n",
+				it->c_str( ));
+
+			Failures += 1;
+			continue;
+		}
+
+		Symbols.clear( );
+
+		InlineResult = Compiler.NscCompileScript(
+			FileResRef,
+			(!Contents.empty( )) ? &Contents[ 0 ] : NULL,
+			Contents.size( ),
+			CompilerVersion,
+			true,
+			true,
+			TextOut,
+			CompilerFlags | NscCompilerFlag_OptimizeInline,
+			InlineCode,
+			Symbols);
+
+		if (InlineResult != BaseResult)
+		{
+			TextOut->WriteText(
+				"Error: \"%s\" compiled with a different outcome with in line expansion.\n",
+				it->c_str( ));
+
+			Mismatches += 1;
+			continue;
+		}
+
+		if (BaseResult != NscResult_Success)
+			continue;
+
+		if (!ActionsBuilt)
+		{
+			BuildActionTable( Compiler, Actions );
+			ActionsBuilt = true;
+		}
+
+		Scripts        += 1;
+		BaseCodeSize   += BaseCode.size( );
+		InlineCodeSize += InlineCode.size( );
+
+		if (!AnalyzeCompiledScript( *it, BaseCode, Actions, TextOut, BaseShape ))
+		{
+			Failures += 1;
+			continue;
+		}
+
+		if (!AnalyzeCompiledScript( *it, InlineCode, Actions, TextOut, InlineShape ))
+		{
+			TextOut->WriteText(
+				"Error: \"%s\" failed verification only with in line expansion.\n",
+				it->c_str( ));
+
+			Mismatches += 1;
+			continue;
+		}
+
+		if ((InlineShape.EntryParameters != BaseShape.EntryParameters) ||
+		    (InlineShape.EntryReturnTypes != BaseShape.EntryReturnTypes))
+		{
+			TextOut->WriteText(
+				"Error: \"%s\" has a different entry point signature with in line expansion.\n",
+				it->c_str( ));
+
+			Mismatches += 1;
+			continue;
+		}
+
+		if (!std::includes(
+			BaseShape.Actions.begin( ),
+			BaseShape.Actions.end( ),
+			InlineShape.Actions.begin( ),
+			InlineShape.Actions.end( )))
+		{
+			TextOut->WriteText(
+				"Error: \"%s\" calls actions with in line expansion that it does not call without it.\n",
+				it->c_str( ));
+
+			Mismatches += 1;
+			continue;
+		}
+
+		if (!Quiet)
+		{
+			TextOut->WriteText(
+				"Checked: %s (%lu -> %lu bytes, %lu -> %lu subroutines)\n",
+				it->c_str( ),
+				(unsigned long) BaseCode.size( ),
+				(unsigned long) InlineCode.size( ),
+				(unsigned long) BaseShape.Subroutines,
+				(unsigned long) InlineShape.Subroutines);
+		}
+	}
+
+	if ((!Quiet) || (Failures != 0) || (Mismatches != 0))
+	{
+		TextOut->WriteText(
+			"In line expansion check: %lu script(s) compared, %lu failed, %lu mismatched; code size %I64u -> %I64u bytes\n",
+			Scripts,
+			Failures,
+			Mismatches,
+			BaseCodeSize,
+			InlineCodeSize);
+	}
+
+	return (Failures == 0) && (Mismatches == 0);
+}
+
+bool
+LoadResponseFile(
+	nwn2dev__in int argc,
+	__in_ecount( argc ) wchar_t * * argv,
+	nwn2dev__in const wchar_t * ResponseFileName,
+	nwn2dev__out WStringVec & Args,
+	nwn2dev__out WStringArgVec & ArgVector
+	)
+/*++
+
+Routine Description:
+
+	This routine loads command line arguments from a response file.  Each line
+	represents an argument.  The contents are read into a vector for later
+	processing.
+
+Arguments:
+
+	argc - Supplies the original command line argument count.
+
+	argv - Supplies the original command line argument vector.
+
+	ResponseFileName - Supplies the file name of the response file.
+
+	Args - Received the lines in the response file.
+
+	ArgVector - Receives an array of pointers to the each line in Args.
+
+Return Value:
+
+	The routine returns a Boolean value indicating true if the response file was
 	loaded, else false if an error occurred.
 
 Environment:
@@ -2270,6 +3321,7 @@ Environment:
 	std::string                ErrorPrefix;
 	std::string                BatchOutDir;
 	std::string                CustomModPath;
+	std::string                BuildDbFile;
 	WStringVec                 ResponseFileText;
 	WStringArgVec              ResponseFileArgs;
 	bool                       Compile            = true;
@@ -2287,6 +3339,8 @@ Environment:
 	unsigned long              Errors             = 0;
 	unsigned long              Flags              = NscDFlag_StopOnError;
 	UINT32                     CompilerFlags      = 0;
+	unsigned long              CheckThreads       = 0;
+	bool                       CheckInline        = false;
 	ULONG                      StartTime;
 
 	StartTime = GetTickCount( );
@@ -2366,6 +3420,11 @@ Environment:
 						EnableExtensions = true;
 						break;
 
+					case L'f':
+						Optimize = true;
+						CompilerFlags |= NscCompilerFlag_OptimizeInline;
+						break;
+
 					case L'g':
 						NoDebug = true;
 						break;
@@ -2532,6 +3591,32 @@ Environment:
 						}
 						break;
 
+					case L's':
+						CompilerFlags |= NscCompilerFlag_ShowCodeStatistics;
+						break;
+
+					case L't':
+						{
+							if (i + 1 >= argc)
+							{
+								wprintf( L"Error: Malformed arguments.\n" );
+								Error = true;
+								break;
+							}
+
+							if (!swutil::UnicodeToAnsi( argv[ i + 1 ], BuildDbFile ))
+							{
+								wprintf(
+									L"Error: Failed to convert build database path '%s' from wchar_t to char.\n",
+									argv[ i + 1 ]);
+								Error = true;
+								break;
+							}
+
+							i += 1;
+						}
+						break;
+
 					case L'v':
 						{
 							CompilerVersion = 0;
@@ -2583,10 +3668,38 @@ Environment:
 						}
 						break;
 
+					case L'w':
+						{
+							if (i + 1 >= argc)
+							{
+								wprintf( L"Error: Malformed arguments.\n" );
+								Error = true;
+								break;
+							}
+
+							CheckThreads = wcstoul( argv[ i + 1 ], NULL, 10 );
+
+							if (CheckThreads == 0)
+							{
+								wprintf(
+									L"Error: Invalid thread count '%s'.\n",
+									argv[ i + 1 ]);
+								Error = true;
+								break;
+							}
+
+							i += 1;
+						}
+						break;
+
 					case 'y':
 						Flags &= ~(NscDFlag_StopOnError);
 						break;
 
+					case L'z':
+						CheckInline = true;
+						break;
+
 					default:
 						{
 							wprintf( L"Error: Unrecognized option \"%c\".\n", Switch );
@@ -2703,13 +3816,26 @@ Environment:
 			__TIME__);
 	}
 
+	if ((CheckThreads != 0) && (!Compile))
+	{
+		wprintf( L"Error: The -w option requires compilation (-c).\n" );
+		Error = true;
+	}
+
+	if ((CheckInline) && ((!Compile) || (CheckThreads != 0)))
+	{
+		wprintf( L"Error: The -z option requires compilation (-c) and excludes -w.\n" );
+		Error = true;
+	}
+
 	if ((Error) || (InFiles.empty( )))
 	{
 		wprintf(
 			L"Usage:\n"
-			L"NWNScriptCompiler [-1acdegjkloq] [-b batchoutdir] [-h homedir]\n"
+			L"NWNScriptCompiler [-1acdefgjkloqs] [-b batchoutdir] [-h homedir]\n"
 			L"                  [[-i pathspec] ...] [-m resref] [-n installdir]\n"
-			L"                  [-r modpath] [-v#] [-x errprefix] [-y]\n"
+			L"                  [-r modpath] [-t builddb] [-v#] [-w threads]\n"
+			L"                  [-x errprefix] [-y] [-z]\n"
 			L"                  infile [outfile|infiles]\n"
 			L"  batchoutdir - Supplies the location at which batch mode places\n"
 			L"                output files and enables multiple input filenames.\n"
@@ -2722,6 +3848,14 @@ Environment:
 			L"  modpath - Supplies the full path to the .mod (or directory) that\n"
 			L"            contains the module.ifo for the module to load.  This\n"
 			L"            option overrides the [-r resref] option.\n"
+			L"  builddb - Build database file for incremental builds.  Scripts\n"
+			L"            whose source text, include files, outputs and compiler\n"
+			L"            options are unchanged since the last build recorded in\n"
+			L"            the database are not recompiled.\n"
+			L"  threads - Compile the input files on a single thread and then again\n"
+			L"            concurrently on this many threads, and verify that the\n"
+			L"            compiled output is identical.  No output files are\n"
+			L"            written.\n"
 			L"  errprefix - Prefix string to prepend to compiler errors (replacing\n"
 			L"              the default of \"Error\").\n"
 			L"  -1 - Assume NWN1-style module and KEY/BIF resources instead of\n"
@@ -2731,6 +3865,8 @@ Environment:
 			L"  -c - Compile the script (default, overrides -d).\n"
 			L"  -d - Disassemble the script (overrides -c).\n"
 			L"  -e - Enable non-BioWare extensions.\n"
+			L"  -f - Code small non-recursive functions in line at their call\n"
+			L"       sites and propagate constant arguments (implies -o).\n"
 			L"  -g - Suppress generation of .ndb debug symbols file.\n"
 			L"  -j - Show where include file are being sourced from.\n"
 			L"  -k - Show preprocessed source text to console output.\n"
@@ -2739,8 +3875,13 @@ Environment:
 			L"  -o - Optimize the compiled script.\n"
 			L"  -p - Dump internal PCode for compiled script contributions.\n"
 			L"  -q - Silence most messages.\n"
+			L"  -s - Show code size and instruction count statistics.\n"
 			L"  -vx.xx - Set the version of the compiler.\n"
 			L"  -y - Continue processing input files even on error.\n"
+			L"  -z - Compile the input files with and without -f, and check that\n"
+			L"       the in line expanded scripts verify, keep the same entry\n"
+			L"       point signature and call no new actions.  No output files\n"
+			L"       are written.\n"
 			);
 
 		return -1;
@@ -2825,6 +3966,42 @@ Environment:
 
 	Compiler.NscSetResourceCacheEnabled( true );
 
+	//
+	// If we are doing an incremental build, load the build database.  The
+	// options fingerprint covers everything that changes the compiled output
+	// (the compiler build itself included).
+	//
+
+	BuildDatabase   BuildDb( *g_ResMan );
+	BuildDatabase * BuildDbPtr = NULL;
+
+	if ((!BuildDbFile.empty( )) && (Compile) && (CheckThreads == 0) && (!CheckInline))
+	{
+		char Options[ 256 ];
+
+		StringCbPrintfA(
+			Options,
+			sizeof( Options ),
+			"version=%d optimize=%d inline=%d extensions=%d nodebug=%d verify=%d compiler=%s %s",
+			CompilerVersion,
+			Optimize ? 1 : 0,
+			(CompilerFlags & NscCompilerFlag_OptimizeInline) ? 1 : 0,
+			EnableExtensions ? 1 : 0,
+			NoDebug ? 1 : 0,
+			VerifyCode ? 1 : 0,
+			__DATE__,
+			__TIME__);
+
+		if (!BuildDb.Load( BuildDbFile, Options ))
+		{
+			g_TextOut.WriteText(
+				"Warning: Build database \"%s\" is malformed; rebuilding all scripts.\n",
+				BuildDbFile.c_str( ));
+		}
+
+		BuildDbPtr = &BuildDb;
+	}
+
 	//
 	// Install the ctrl-c handler.
 	//
@@ -2832,115 +4009,192 @@ Environment:
 	SetConsoleCtrlHandler( AppConsoleCtrlHandler, TRUE );
 
 	//
-	// Process each of the input files in turn.
+	// If we are checking multithreaded compilation or in line expansion,
+	// compile the input files for comparison only.  Otherwise, process each of
+	// the input files in turn.
 	//
 
-	for (std::vector< std::string >::const_iterator it = InFiles.begin( );
-	    it != InFiles.end( );
-	    ++it)
+	if (CheckInline)
 	{
-		std::string            ThisOutFile;
-		std::string::size_type Offs;
-		bool                   Status;
-
-		//
-		// Load the source text and compile the program.
-		//
-
-		if (it->find_first_of( "*?" ) != std::string::npos)
+		if (!CheckInlineCompile(
+			*g_ResMan,
+			Compiler,
+			CompilerVersion,
+			Optimize,
+			Quiet,
+			&g_TextOut,
+			CompilerFlags,
+			InFiles))
 		{
-			//
-			// We've a wildcard, process it appropriately.
-			//
-
-			Status = ProcessWildcardInputFile(
-				*g_ResMan,
-				Compiler,
-				Compile,
-				CompilerVersion,
-				Optimize,
-				true,
-				NoDebug,
-				Quiet,
-				VerifyCode,
-				Flags,
-				&g_TextOut,
-				CompilerFlags,
-				*it,
-				BatchOutDir);
+			ReturnCode = -1;
+			Errors    += 1;
 		}
-		else
+	}
+	else if (CheckThreads != 0)
+	{
+		if (!CheckMultithreadedCompile(
+			*g_ResMan,
+			Compiler,
+			CheckThreads,
+			CompilerVersion,
+			Optimize,
+			EnableExtensions,
+			Quiet,
+			&g_TextOut,
+			CompilerFlags,
+			SearchPaths,
+			ErrorPrefix,
+			InFiles))
 		{
-			if (BatchOutDir.empty( ))
-			{
-				ThisOutFile = OutFile;
+			ReturnCode = -1;
+			Errors    += 1;
+		}
+	}
+	else
+	{
+		for (std::vector< std::string >::const_iterator it = InFiles.begin( );
+		    it != InFiles.end( );
+		    ++it)
+		{
+			std::string            ThisOutFile;
+			std::string::size_type Offs;
+			bool                   Status;
 
-				if (ThisOutFile.empty( ))
-					ThisOutFile = *it;
+			//
+			// Load the source text and compile the program.
+			//
 
-				Offs = ThisOutFile.find_last_of( '.' );
+			if (it->find_first_of( "*?" ) != std::string::npos)
+			{
+				//
+				// We've a wildcard, process it appropriately.
+				//
 
-				if (Offs != std::string::npos)
-					ThisOutFile.erase( Offs );
+				Status = ProcessWildcardInputFile(
+					*g_ResMan,
+					Compiler,
+					Compile,
+					CompilerVersion,
+					Optimize,
+					true,
+					NoDebug,
+					Quiet,
+					VerifyCode,
+					Flags,
+					&g_TextOut,
+					CompilerFlags,
+					*it,
+					BatchOutDir,
+					BuildDbPtr);
 			}
 			else
 			{
-				char FileName[ _MAX_FNAME ];
-
-				if (_splitpath_s(
-					it->c_str( ),
-					NULL,
-					0,
-					NULL,
-					0,
-					FileName,
-					_MAX_FNAME,
-					NULL,
-					0))
+				if (BatchOutDir.empty( ))
 				{
-					g_TextOut.WriteText(
-						"Error: Invalid path: \"%s\".\n",
-						it->c_str( ));
+					ThisOutFile = OutFile;
 
-					ReturnCode = -1;
-					continue;
+					if (ThisOutFile.empty( ))
+						ThisOutFile = *it;
+
+					Offs = ThisOutFile.find_last_of( '.' );
+
+					if (Offs != std::string::npos)
+						ThisOutFile.erase( Offs );
 				}
+				else
+				{
+					char FileName[ _MAX_FNAME ];
+
+					if (_splitpath_s(
+						it->c_str( ),
+						NULL,
+						0,
+						NULL,
+						0,
+						FileName,
+						_MAX_FNAME,
+						NULL,
+						0))
+					{
+						g_TextOut.WriteText(
+							"Error: Invalid path: \"%s\".\n",
+							it->c_str( ));
+
+						ReturnCode = -1;
+						continue;
+					}
 					
-				ThisOutFile  = BatchOutDir;
-				ThisOutFile += FileName;
+					ThisOutFile  = BatchOutDir;
+					ThisOutFile += FileName;
+				}
+
+				//
+				// We've a regular (single) file name, process it.
+				//
+
+				Status = ProcessInputFile(
+					*g_ResMan,
+					Compiler,
+					Compile,
+					CompilerVersion,
+					Optimize,
+					true,
+					NoDebug,
+					Quiet,
+					VerifyCode,
+					&g_TextOut,
+					CompilerFlags,
+					*it,
+					ThisOutFile,
+					BuildDbPtr);
 			}
 
-			//
-			// We've a regular (single) file name, process it.
-			//
+			if (!Status)
+			{
+				ReturnCode = -1;
 
-			Status = ProcessInputFile(
-				*g_ResMan,
-				Compiler,
-				Compile,
-				CompilerVersion,
-				Optimize,
-				true,
-				NoDebug,
-				Quiet,
-				VerifyCode,
-				&g_TextOut,
-				CompilerFlags,
-				*it,
-				ThisOutFile);
+				Errors += 1;
+
+				if (Flags & NscDFlag_StopOnError)
+				{
+					g_TextOut.WriteText( "Processing aborted.\n" );
+					break;
+				}
+			}
 		}
+	}
+
+	//
+	// Write back the build database, if we are doing an incremental build.
+	//
 
-		if (!Status)
+	if (BuildDbPtr != NULL)
+	{
+		try
 		{
-			ReturnCode = -1;
+			BuildDb.Save( BuildDbFile );
+		}
+		catch (std::exception &e)
+		{
+			g_TextOut.WriteText(
+				"Error: Failed to save build database \"%s\": '%s'.\n",
+				BuildDbFile.c_str( ),
+				e.what( ));
 
-			Errors += 1;
+			ReturnCode = -1;
+		}
 
-			if (Flags & NscDFlag_StopOnError)
-			{
-				g_TextOut.WriteText( "Processing aborted.\n" );
-				break;
-			}
+		if (!Quiet)
+		{
+			const BuildDatabase::BuildStatistics & Stats = BuildDb.GetStatistics( );
+
+			g_TextOut.WriteText(
+				"Incremental build: %lu script(s) checked, %lu up to date, %lu recorded; %lu include file(s) hashed; check time = %lums\n",
+				Stats.ScriptsChecked,
+				Stats.ScriptsUpToDate,
+				Stats.ScriptsRecorded,
+				Stats.DependenciesHashed,
+				Stats.CheckTime);
 		}
 	}
 
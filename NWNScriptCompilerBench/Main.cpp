@@ -0,0 +1,2246 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	Main.cpp
+
+Abstract:
+
+	This module houses the script compiler throughput benchmark.  The
+	benchmark compiles a corpus of scripts, either generated in memory or
+	loaded from a directory, and reports per-phase compile times (preprocess,
+	lex, parse, code generation and NDB emission), heap allocations and peak
+	heap usage for each script.  Results are written as JSON so that they can
+	be compared across compiler releases.
+
+	The generated corpus consists of a deep chain of include files, scripts
+	with large switch statements, scripts that make heavy use of structures,
+	and general purpose scripts with loops, string and vector arithmetic.  It
+	is compiled against a minimal built-in nwscript.nss, unless a real one is
+	found on the include path.
+
+--*/
+
+#include "Precomp.h"
+#include "../NWN2DataLib/TextOut.h"
+#include "../NWN2DataLib/ResourceManager.h"
+
+//
+// Define the heap allocation counters.  These are maintained by the global
+// operator new and operator delete replacements below, and are sampled
+// around each compilation.  Allocations made directly with malloc (such as
+// resource file contents) are not counted.  The benchmark is single threaded.
+//
+
+struct HeapCounters
+{
+	ULONGLONG Allocations;
+	ULONGLONG AllocatedBytes;
+	ULONGLONG LiveBytes;
+	ULONGLONG PeakBytes;
+};
+
+static HeapCounters g_Heap;
+
+//
+// Each block carries a header recording its size, padded so that the block
+// retains the alignment guaranteed by malloc.
+//
+
+union HeapBlockHeader
+{
+	size_t Size;
+	double Align;
+	char   Pad[ 16 ];
+};
+
+static
+void *
+HeapCountedAlloc(
+	nwn2dev__in size_t Size
+	)
+/*++
+
+Routine Description:
+
+	This routine allocates a block of memory on behalf of operator new and
+	updates the heap allocation counters.
+
+Arguments:
+
+	Size - Supplies the requested size of the block.
+
+Return Value:
+
+	The routine returns a pointer to the block, else NULL on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	HeapBlockHeader * Header;
+
+	if (Size > (size_t) -1 - sizeof( HeapBlockHeader ))
+		return NULL;
+
+	Header = (HeapBlockHeader *) malloc( sizeof( HeapBlockHeader ) + Size );
+
+	if (Header == NULL)
+		return NULL;
+
+	Header->Size = Size;
+
+	g_Heap.Allocations    += 1;
+	g_Heap.AllocatedBytes += Size;
+	g_Heap.LiveBytes      += Size;
+
+	if (g_Heap.LiveBytes > g_Heap.PeakBytes)
+		g_Heap.PeakBytes = g_Heap.LiveBytes;
+
+	return Header + 1;
+}
+
+static
+void
+HeapCountedFree(
+	nwn2dev__in void * Block
+	)
+/*++
+
+Routine Description:
+
+	This routine releases a block of memory allocated by HeapCountedAlloc and
+	updates the heap allocation counters.
+
+Arguments:
+
+	Block - Supplies the block to release (which may be NULL).
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	HeapBlockHeader * Header;
+
+	if (Block == NULL)
+		return;
+
+	Header = (HeapBlockHeader *) Block - 1;
+
+	g_Heap.LiveBytes -= Header->Size;
+
+	free( Header );
+}
+
+void *
+__cdecl
+operator new(
+	nwn2dev__in size_t Size
+	)
+{
+	void * Block = HeapCountedAlloc( Size ? Size : 1 );
+
+	if (Block == NULL)
+		throw std::bad_alloc( );
+
+	return Block;
+}
+
+void *
+__cdecl
+operator new[](
+	nwn2dev__in size_t Size
+	)
+{
+	void * Block = HeapCountedAlloc( Size ? Size : 1 );
+
+	if (Block == NULL)
+		throw std::bad_alloc( );
+
+	return Block;
+}
+
+void *
+__cdecl
+operator new(
+	nwn2dev__in size_t Size,
+	nwn2dev__in const std::nothrow_t &
+	) throw( )
+{
+	return HeapCountedAlloc( Size ? Size : 1 );
+}
+
+void *
+__cdecl
+operator new[](
+	nwn2dev__in size_t Size,
+	nwn2dev__in const std::nothrow_t &
+	) throw( )
+{
+	return HeapCountedAlloc( Size ? Size : 1 );
+}
+
+void
+__cdecl
+operator delete(
+	nwn2dev__in void * Block
+	) throw( )
+{
+	HeapCountedFree( Block );
+}
+
+void
+__cdecl
+operator delete[](
+	nwn2dev__in void * Block
+	) throw( )
+{
+	HeapCountedFree( Block );
+}
+
+void
+__cdecl
+operator delete(
+	nwn2dev__in void * Block,
+	nwn2dev__in const std::nothrow_t &
+	) throw( )
+{
+	HeapCountedFree( Block );
+}
+
+void
+__cdecl
+operator delete[](
+	nwn2dev__in void * Block,
+	nwn2dev__in const std::nothrow_t &
+	) throw( )
+{
+	HeapCountedFree( Block );
+}
+
+//
+// Define the debug text output interface, used to write compiler diagnostics
+// to the user.  Diagnostics are suppressed while timed compilations are run,
+// as they would otherwise be repeated for every iteration.
+//
+
+class PrintfTextOut : public IDebugTextOut
+{
+
+public:
+
+	inline
+	PrintfTextOut(
+		)
+	: m_Quiet( false )
+	{
+	}
+
+	inline
+	void
+	SetQuiet(
+		nwn2dev__in bool Quiet
+		)
+	{
+		m_Quiet = Quiet;
+	}
+
+	inline
+	virtual
+	void
+	WriteText(
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		...
+		)
+	{
+		va_list ap;
+
+		va_start( ap, fmt );
+		WriteTextV( fmt, ap );
+		va_end( ap );
+	}
+
+	inline
+	virtual
+	void
+	WriteText(
+		nwn2dev__in WORD Attributes,
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		...
+		)
+	{
+		va_list ap;
+
+		va_start( ap, fmt );
+		WriteTextV( fmt, ap );
+		va_end( ap );
+
+		UNREFERENCED_PARAMETER( Attributes );
+	}
+
+	inline
+	virtual
+	void
+	WriteTextV(
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		nwn2dev__in va_list ap
+		)
+	{
+		if (m_Quiet)
+			return;
+
+		vfprintf( stderr, fmt, ap );
+	}
+
+	inline
+	virtual
+	void
+	WriteTextV(
+		nwn2dev__in WORD Attributes,
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		nwn2dev__in va_list ap
+		)
+	{
+		WriteTextV( fmt, ap );
+
+		UNREFERENCED_PARAMETER( Attributes );
+	}
+
+private:
+
+	bool m_Quiet;
+
+};
+
+//
+// Define a debug text output interface that captures the text written to it,
+// used to collect the compiler's token dump.
+//
+
+class StringTextOut : public IDebugTextOut
+{
+
+public:
+
+	inline
+	const std::string &
+	GetText(
+		) const
+	{
+		return m_Text;
+	}
+
+	inline
+	virtual
+	void
+	WriteText(
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		...
+		)
+	{
+		va_list ap;
+
+		va_start( ap, fmt );
+		WriteTextV( fmt, ap );
+		va_end( ap );
+	}
+
+	inline
+	virtual
+	void
+	WriteText(
+		nwn2dev__in WORD Attributes,
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		...
+		)
+	{
+		va_list ap;
+
+		va_start( ap, fmt );
+		WriteTextV( fmt, ap );
+		va_end( ap );
+
+		UNREFERENCED_PARAMETER( Attributes );
+	}
+
+	inline
+	virtual
+	void
+	WriteTextV(
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		nwn2dev__in va_list ap
+		)
+	{
+		std::vector< char > Buffer;
+		int                 Length;
+
+		Length = _vscprintf( fmt, ap );
+
+		if (Length <= 0)
+			return;
+
+		Buffer.resize( (size_t) Length + 1 );
+		_vsnprintf( &Buffer[ 0 ], Buffer.size( ), fmt, ap );
+
+		m_Text.append( &Buffer[ 0 ], (size_t) Length );
+	}
+
+	inline
+	virtual
+	void
+	WriteTextV(
+		nwn2dev__in WORD Attributes,
+		nwn2dev__in nwn2dev__format_string const char* fmt,
+		nwn2dev__in va_list ap
+		)
+	{
+		WriteTextV( fmt, ap );
+
+		UNREFERENCED_PARAMETER( Attributes );
+	}
+
+private:
+
+	std::string m_Text;
+
+};
+
+//
+// Define a script in the benchmark corpus.  Include scripts are served to the
+// compiler through the external resource loader and are not compiled on
+// their own.
+//
+
+struct BenchScript
+{
+	std::string Name;
+	std::string Text;
+	bool        Include;
+};
+
+typedef std::vector< BenchScript > BenchScriptVec;
+
+//
+// Define the context of the in-memory resource loader.
+//
+
+struct BenchResourceContext
+{
+	ResourceManager * ResMan;
+	BenchScriptVec  * Scripts;
+};
+
+//
+// Define the measurements taken for a script.  Times are in microseconds and
+// are the minimum observed over all iterations.
+//
+
+struct BenchResult
+{
+	NscResult            Result;
+	size_t               SourceBytes;
+	size_t               CodeBytes;
+	size_t               DebugSymbolsBytes;
+	NscCompileStatistics Statistics;
+	HeapCounters         Heap;
+};
+
+typedef std::vector< BenchResult > BenchResultVec;
+
+//
+// Define the minimal nwscript.nss used with the generated corpus.  Only the
+// actions that the generated scripts call are declared.
+//
+
+static const char g_BenchNWScript[] =
+	"#define ENGINE_NUM_STRUCTURES 3\n"
+	"#define ENGINE_STRUCTURE_0 effect\n"
+	"#define ENGINE_STRUCTURE_1 event\n"
+	"#define ENGINE_STRUCTURE_2 location\n"
+	"\n"
+	"int TRUE  = 1;\n"
+	"int FALSE = 0;\n"
+	"\n"
+	"int Random(int nMaxInteger);\n"
+	"void PrintString(string sString);\n"
+	"float IntToFloat(int nInteger);\n"
+	"int FloatToInt(float fFloat);\n"
+	"string IntToString(int nInteger);\n"
+	"int GetStringLength(string sString);\n"
+	"string GetSubString(string sString, int nStart, int nCount);\n"
+	"vector Vector(float x=0.0f, float y=0.0f, float z=0.0f);\n"
+	"float VectorMagnitude(vector vVector);\n";
+
+static
+void
+AppendFormat(
+	nwn2dev__out std::string & Text,
+	nwn2dev__in nwn2dev__format_string const char * Format,
+	...
+	)
+/*++
+
+Routine Description:
+
+	This routine appends formatted text to a string.
+
+Arguments:
+
+	Text - Supplies the string to append to.
+
+	Format - Supplies the printf-style format string.
+
+	... - Supplies format inserts.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	char    Buffer[ 1024 ];
+	va_list ap;
+
+	va_start( ap, Format );
+	StringCbVPrintfA( Buffer, sizeof( Buffer ), Format, ap );
+	va_end( ap );
+
+	Text += Buffer;
+}
+
+static
+void
+GenerateIncludeChain(
+	nwn2dev__in unsigned long Depth,
+	nwn2dev__out BenchScriptVec & Scripts
+	)
+/*++
+
+Routine Description:
+
+	This routine generates a chain of include files, each of which includes
+	the next, and defines a constant, a structure and a function that calls
+	into the next file of the chain.
+
+Arguments:
+
+	Depth - Supplies the number of include files in the chain.
+
+	Scripts - Receives the generated include files.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	for (unsigned long i = 0; i < Depth; i += 1)
+	{
+		BenchScript Script;
+		char        Name[ 32 ];
+
+		StringCbPrintfA( Name, sizeof( Name ), "inc_bch_%03lu", i );
+
+		Script.Name    = Name;
+		Script.Include = true;
+
+		if (i + 1 < Depth)
+			AppendFormat( Script.Text, "#include \"inc_bch_%03lu\"\n\n", i + 1 );
+
+		AppendFormat(
+			Script.Text,
+			"const int BENCH_CHAIN_%03lu = %lu;\n"
+			"\n"
+			"struct BenchChainData%03lu\n"
+			"{\n"
+			"    int    nValue;\n"
+			"    float  fScale;\n"
+			"    string sTag;\n"
+			"};\n"
+			"\n"
+			"int BenchChain%03lu(int nValue)\n"
+			"{\n"
+			"    struct BenchChainData%03lu sData;\n"
+			"\n"
+			"    sData.nValue = nValue + BENCH_CHAIN_%03lu;\n"
+			"    sData.fScale = IntToFloat(sData.nValue) * 0.5;\n"
+			"    sData.sTag   = \"chain\" + IntToString(sData.nValue);\n"
+			"\n",
+			i,
+			i,
+			i,
+			i,
+			i,
+			i);
+
+		if (i + 1 < Depth)
+		{
+			AppendFormat(
+				Script.Text,
+				"    sData.nValue = BenchChain%03lu(sData.nValue);\n",
+				i + 1);
+		}
+
+		AppendFormat(
+			Script.Text,
+			"    if (sData.nValue > 1000)\n"
+			"        sData.nValue = sData.nValue %% 1000;\n"
+			"\n"
+			"    return sData.nValue + FloatToInt(sData.fScale) + GetStringLength(sData.sTag);\n"
+			"}\n");
+
+		Scripts.push_back( Script );
+	}
+}
+
+static
+void
+GenerateChainScript(
+	nwn2dev__in unsigned long Index,
+	nwn2dev__out BenchScriptVec & Scripts
+	)
+/*++
+
+Routine Description:
+
+	This routine generates a script that pulls in the whole include chain.
+
+Arguments:
+
+	Index - Supplies the index of the script within its kind.
+
+	Scripts - Receives the generated script.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	BenchScript Script;
+	char        Name[ 32 ];
+
+	StringCbPrintfA( Name, sizeof( Name ), "bch_chain_%02lu", Index );
+
+	Script.Name    = Name;
+	Script.Include = false;
+
+	AppendFormat(
+		Script.Text,
+		"#include \"inc_bch_000\"\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		"    int i;\n"
+		"    int nTotal = %lu;\n"
+		"\n"
+		"    for (i = 0; i < 16; i++)\n"
+		"        nTotal += BenchChain000(i);\n"
+		"\n"
+		"    PrintString(IntToString(nTotal));\n"
+		"}\n",
+		Index);
+
+	Scripts.push_back( Script );
+}
+
+static
+void
+GenerateSwitchScript(
+	nwn2dev__in unsigned long Index,
+	nwn2dev__in unsigned long Cases,
+	nwn2dev__out BenchScriptVec & Scripts
+	)
+/*++
+
+Routine Description:
+
+	This routine generates a script built around a large switch statement.
+
+Arguments:
+
+	Index - Supplies the index of the script within its kind.
+
+	Cases - Supplies the number of case labels in the switch statement.
+
+	Scripts - Receives the generated script.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	BenchScript Script;
+	char        Name[ 32 ];
+
+	StringCbPrintfA( Name, sizeof( Name ), "bch_switch_%02lu", Index );
+
+	Script.Name    = Name;
+	Script.Include = false;
+
+	AppendFormat(
+		Script.Text,
+		"int BenchSwitch(int nValue)\n"
+		"{\n"
+		"    int    nResult = 0;\n"
+		"    string sResult = \"\";\n"
+		"\n"
+		"    switch (nValue)\n"
+		"    {\n");
+
+	for (unsigned long i = 0; i < Cases; i += 1)
+	{
+		switch (i % 3)
+		{
+
+		case 0:
+			AppendFormat(
+				Script.Text,
+				"    case %lu:\n"
+				"        nResult = nValue * 3 + %lu;\n"
+				"        break;\n",
+				i,
+				i);
+			break;
+
+		case 1:
+			AppendFormat(
+				Script.Text,
+				"    case %lu:\n"
+				"        if (Random(2) == 0)\n"
+				"            nResult = %lu;\n"
+				"        else\n"
+				"            nResult = nValue - %lu;\n"
+				"        break;\n",
+				i,
+				i,
+				i / 2);
+			break;
+
+		default:
+			AppendFormat(
+				Script.Text,
+				"    case %lu:\n"
+				"        sResult = \"case \" + IntToString(nValue);\n"
+				"        nResult = GetStringLength(sResult) + %lu;\n"
+				"        break;\n",
+				i,
+				i);
+			break;
+
+		}
+	}
+
+	AppendFormat(
+		Script.Text,
+		"    default:\n"
+		"        nResult = -1;\n"
+		"        break;\n"
+		"    }\n"
+		"\n"
+		"    return nResult;\n"
+		"}\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		"    int i;\n"
+		"    int nTotal = 0;\n"
+		"\n"
+		"    for (i = 0; i < %lu; i++)\n"
+		"        nTotal += BenchSwitch(i);\n"
+		"\n"
+		"    PrintString(IntToString(nTotal));\n"
+		"}\n",
+		Cases);
+
+	Scripts.push_back( Script );
+}
+
+static
+void
+GenerateStructScript(
+	nwn2dev__in unsigned long Index,
+	nwn2dev__in unsigned long Structs,
+	nwn2dev__in unsigned long Fields,
+	nwn2dev__out BenchScriptVec & Scripts
+	)
+/*++
+
+Routine Description:
+
+	This routine generates a script that declares many structures, and passes
+	and returns them by value.
+
+Arguments:
+
+	Index - Supplies the index of the script within its kind.
+
+	Structs - Supplies the number of structures to declare.
+
+	Fields - Supplies the number of fields in each structure.
+
+	Scripts - Receives the generated script.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	static const char * FieldTypes[ 4 ] = { "int", "float", "string", "vector" };
+	static const char * FieldPrefix[ 4 ] = { "n", "f", "s", "v" };
+
+	BenchScript Script;
+	char        Name[ 32 ];
+
+	StringCbPrintfA( Name, sizeof( Name ), "bch_struct_%02lu", Index );
+
+	Script.Name    = Name;
+	Script.Include = false;
+
+	for (unsigned long s = 0; s < Structs; s += 1)
+	{
+		AppendFormat( Script.Text, "struct BenchRecord%03lu\n{\n", s );
+
+		for (unsigned long f = 0; f < Fields; f += 1)
+		{
+			AppendFormat(
+				Script.Text,
+				"    %s %sField%03lu;\n",
+				FieldTypes[ f % 4 ],
+				FieldPrefix[ f % 4 ],
+				f);
+		}
+
+		AppendFormat(
+			Script.Text,
+			"};\n"
+			"\n"
+			"struct BenchRecord%03lu MakeBenchRecord%03lu(int nSeed)\n"
+			"{\n"
+			"    struct BenchRecord%03lu sRecord;\n"
+			"\n",
+			s,
+			s,
+			s);
+
+		for (unsigned long f = 0; f < Fields; f += 1)
+		{
+			switch (f % 4)
+			{
+
+			case 0:
+				AppendFormat( Script.Text, "    sRecord.nField%03lu = nSeed + %lu;\n", f, f );
+				break;
+
+			case 1:
+				AppendFormat( Script.Text, "    sRecord.fField%03lu = IntToFloat(nSeed) * 1.5;\n", f );
+				break;
+
+			case 2:
+				AppendFormat( Script.Text, "    sRecord.sField%03lu = IntToString(nSeed + %lu);\n", f, f );
+				break;
+
+			default:
+				AppendFormat( Script.Text, "    sRecord.vField%03lu = Vector(IntToFloat(nSeed), 1.0, 2.0);\n", f );
+				break;
+
+			}
+		}
+
+		AppendFormat(
+			Script.Text,
+			"\n"
+			"    return sRecord;\n"
+			"}\n"
+			"\n"
+			"int SumBenchRecord%03lu(struct BenchRecord%03lu sRecord)\n"
+			"{\n"
+			"    int nSum = 0;\n"
+			"\n",
+			s,
+			s);
+
+		for (unsigned long f = 0; f < Fields; f += 1)
+		{
+			switch (f % 4)
+			{
+
+			case 0:
+				AppendFormat( Script.Text, "    nSum += sRecord.nField%03lu;\n", f );
+				break;
+
+			case 1:
+				AppendFormat( Script.Text, "    nSum += FloatToInt(sRecord.fField%03lu);\n", f );
+				break;
+
+			case 2:
+				AppendFormat( Script.Text, "    nSum += GetStringLength(sRecord.sField%03lu);\n", f );
+				break;
+
+			default:
+				AppendFormat( Script.Text, "    nSum += FloatToInt(VectorMagnitude(sRecord.vField%03lu));\n", f );
+				break;
+
+			}
+		}
+
+		AppendFormat(
+			Script.Text,
+			"\n"
+			"    return nSum;\n"
+			"}\n"
+			"\n");
+	}
+
+	AppendFormat(
+		Script.Text,
+		"void main()\n"
+		"{\n"
+		"    int nTotal = 0;\n"
+		"\n");
+
+	for (unsigned long s = 0; s < Structs; s += 1)
+	{
+		AppendFormat(
+			Script.Text,
+			"    nTotal += SumBenchRecord%03lu(MakeBenchRecord%03lu(%lu));\n",
+			s,
+			s,
+			s);
+	}
+
+	AppendFormat(
+		Script.Text,
+		"\n"
+		"    PrintString(IntToString(nTotal));\n"
+		"}\n");
+
+	Scripts.push_back( Script );
+}
+
+static
+void
+GenerateMixedScript(
+	nwn2dev__in unsigned long Index,
+	nwn2dev__out BenchScriptVec & Scripts
+	)
+/*++
+
+Routine Description:
+
+	This routine generates a general purpose script with loops, string and
+	vector arithmetic that also pulls in the include chain.
+
+Arguments:
+
+	Index - Supplies the index of the script within its kind.
+
+	Scripts - Receives the generated script.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	BenchScript Script;
+	char        Name[ 32 ];
+
+	StringCbPrintfA( Name, sizeof( Name ), "bch_mixed_%02lu", Index );
+
+	Script.Name    = Name;
+	Script.Include = false;
+
+	AppendFormat(
+		Script.Text,
+		"#include \"inc_bch_000\"\n"
+		"\n"
+		"float BenchLength(vector vValue)\n"
+		"{\n"
+		"    return VectorMagnitude(vValue);\n"
+		"}\n"
+		"\n"
+		"string BenchLetters(int nStart, int nCount)\n"
+		"{\n"
+		"    return GetSubString(\"abcdefghijklmnopqrstuvwxyz\", nStart %% 26, nCount);\n"
+		"}\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		"    string s = \"\";\n"
+		"    float  f = 0.0;\n"
+		"    int    i;\n"
+		"    int    j;\n"
+		"\n"
+		"    for (i = 0; i < %lu; i++)\n"
+		"    {\n"
+		"        for (j = 0; j < 4; j++)\n"
+		"        {\n"
+		"            s = s + BenchLetters(i + j, 1);\n"
+		"            f += BenchLength(Vector(IntToFloat(i), IntToFloat(j), 2.0));\n"
+		"        }\n"
+		"\n"
+		"        if (GetStringLength(s) > 32)\n"
+		"            s = \"\";\n"
+		"    }\n"
+		"\n"
+		"    i = 0;\n"
+		"    while (i < 16)\n"
+		"    {\n"
+		"        f = f * 0.5;\n"
+		"        i++;\n"
+		"    }\n"
+		"\n"
+		"    do\n"
+		"    {\n"
+		"        i--;\n"
+		"    } while (i > 0);\n"
+		"\n"
+		"    PrintString(s + IntToString(BenchChain000(FloatToInt(f))));\n"
+		"}\n",
+		64 + Index);
+
+	Scripts.push_back( Script );
+}
+
+static
+void
+GenerateCorpus(
+	nwn2dev__in unsigned long Count,
+	nwn2dev__in unsigned long ChainDepth,
+	nwn2dev__out BenchScriptVec & Scripts
+	)
+/*++
+
+Routine Description:
+
+	This routine generates the benchmark corpus.
+
+Arguments:
+
+	Count - Supplies the number of scripts to generate of each kind.
+
+	ChainDepth - Supplies the depth of the include chain.
+
+	Scripts - Receives the generated scripts.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	BenchScript NWScript;
+
+	NWScript.Name    = "nwscript";
+	NWScript.Text    = g_BenchNWScript;
+	NWScript.Include = true;
+
+	Scripts.push_back( NWScript );
+
+	GenerateIncludeChain( ChainDepth, Scripts );
+
+	for (unsigned long i = 0; i < Count; i += 1)
+	{
+		GenerateChainScript( i, Scripts );
+		GenerateSwitchScript( i, 128 << (i % 4), Scripts );
+		GenerateStructScript( i, 8 + 4 * i, 24, Scripts );
+		GenerateMixedScript( i, Scripts );
+	}
+}
+
+static
+bool
+LoadCorpusDirectory(
+	nwn2dev__in const std::string & Directory,
+	nwn2dev__out BenchScriptVec & Scripts
+	)
+/*++
+
+Routine Description:
+
+	This routine loads every .nss file in a directory into the corpus.
+	Scripts without an entry point are compiled as well; the compiler reports
+	them as include files.
+
+Arguments:
+
+	Directory - Supplies the directory to load scripts from.
+
+	Scripts - Receives the loaded scripts.
+
+Return Value:
+
+	The routine returns true if the directory could be enumerated.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	WIN32_FIND_DATAA FindData;
+	HANDLE           FindHandle;
+	std::string      Pattern;
+
+	Pattern  = Directory;
+	Pattern += "\\*.nss";
+
+	FindHandle = FindFirstFileA( Pattern.c_str( ), &FindData );
+
+	if (FindHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	do
+	{
+		BenchScript   Script;
+		std::string   FileName;
+		FILE        * f;
+		long          Size;
+		const char  * Dot;
+
+		if (FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+
+		Dot = strrchr( FindData.cFileName, '.' );
+
+		if ((Dot == NULL) || ((size_t) (Dot - FindData.cFileName) > 32))
+			continue;
+
+		FileName  = Directory;
+		FileName += "\\";
+		FileName += FindData.cFileName;
+
+		f = fopen( FileName.c_str( ), "rb" );
+
+		if (f == NULL)
+			continue;
+
+		fseek( f, 0, SEEK_END );
+		Size = ftell( f );
+		fseek( f, 0, SEEK_SET );
+
+		if (Size > 0)
+		{
+			Script.Text.resize( (size_t) Size );
+
+			if (fread( &Script.Text[ 0 ], (size_t) Size, 1, f ) != 1)
+				Script.Text.clear( );
+		}
+
+		fclose( f );
+
+		Script.Name.assign( FindData.cFileName, Dot - FindData.cFileName );
+		Script.Include = false;
+
+		if (!_stricmp( Script.Name.c_str( ), "nwscript" ))
+			continue;
+
+		Scripts.push_back( Script );
+	} while (FindNextFileA( FindHandle, &FindData ));
+
+	FindClose( FindHandle );
+
+	return true;
+}
+
+static
+bool
+__stdcall
+BenchLoadResource(
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	nwn2dev__in NWN::ResType Type,
+	__deref_out_bcount( *FileSize ) void * * FileContents,
+	nwn2dev__out size_t * FileSize,
+	nwn2dev__in void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine is the external resource loader used by the compiler to
+	fetch include files (and nwscript.nss) from the in-memory corpus.
+
+Arguments:
+
+	ResRef - Supplies the resource name.
+
+	Type - Supplies the resource type.
+
+	FileContents - Receives a pointer to the resource contents.
+
+	FileSize - Receives the size of the resource contents.
+
+	Context - Supplies the BenchResourceContext.
+
+Return Value:
+
+	The routine returns true if the resource was found.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	BenchResourceContext * Ctx = (BenchResourceContext *) Context;
+	std::string            Name;
+
+	if (Type != NWN::ResNSS)
+		return false;
+
+	Name = Ctx->ResMan->StrFromResRef( ResRef );
+
+	for (BenchScriptVec::iterator it = Ctx->Scripts->begin( );
+	     it != Ctx->Scripts->end( );
+	     ++it)
+	{
+		if (_stricmp( it->Name.c_str( ), Name.c_str( ) ))
+			continue;
+
+		*FileContents = it->Text.empty( ) ? NULL : &it->Text[ 0 ];
+		*FileSize     = it->Text.size( );
+
+		return true;
+	}
+
+	return false;
+}
+
+static
+bool
+__stdcall
+BenchUnloadResource(
+	nwn2dev__in void * FileContents,
+	nwn2dev__in void * Context
+	)
+/*++
+
+Routine Description:
+
+	This routine releases a resource returned by BenchLoadResource.  As the
+	corpus remains resident, there is nothing to do.
+
+Arguments:
+
+	FileContents - Supplies the resource contents.
+
+	Context - Supplies the BenchResourceContext.
+
+Return Value:
+
+	The routine returns true.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	UNREFERENCED_PARAMETER( FileContents );
+	UNREFERENCED_PARAMETER( Context );
+
+	return true;
+}
+
+static
+void
+BenchmarkScript(
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in PrintfTextOut & TextOut,
+	nwn2dev__in const BenchScript & Script,
+	nwn2dev__in unsigned long Iterations,
+	nwn2dev__in int CompilerVersion,
+	nwn2dev__in bool Optimize,
+	nwn2dev__in UINT32 CompilerFlags,
+	nwn2dev__out BenchResult & Result
+	)
+/*++
+
+Routine Description:
+
+	This routine compiles a script repeatedly and records the best observed
+	compile statistics.  An untimed compilation is made first so that the
+	compiler is initialized, include files are cached and diagnostics are
+	shown once.
+
+	If a timed compilation fails, the benchmark of the script is abandoned
+	and the failure is returned, as the statistics of a failed compilation
+	do not describe a full compilation.
+
+Arguments:
+
+	Compiler - Supplies the compiler instance.
+
+	ResMan - Supplies the resource manager.
+
+	TextOut - Supplies the text output interface.
+
+	Script - Supplies the script to compile.
+
+	Iterations - Supplies the number of timed compilations.
+
+	CompilerVersion - Supplies the compiler version.
+
+	Optimize - Supplies true if optimizations are enabled.
+
+	CompilerFlags - Supplies additional compiler flags.
+
+	Result - Receives the measurements.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	NWN::ResRef32        ResRef;
+	std::vector< UINT8 > Code;
+	std::vector< UINT8 > DebugSymbols;
+
+	ResRef = ResMan.ResRef32FromStr( Script.Name );
+
+	ZeroMemory( &Result, sizeof( Result ) );
+
+	Result.SourceBytes = Script.Text.size( );
+	Result.Result      = Compiler.NscCompileScript(
+		ResRef,
+		Script.Text.data( ),
+		Script.Text.size( ),
+		CompilerVersion,
+		Optimize,
+		true,
+		&TextOut,
+		CompilerFlags,
+		Code,
+		DebugSymbols);
+
+	if (Result.Result == NscResult_Failure)
+		return;
+
+	TextOut.SetQuiet( true );
+
+	for (unsigned long i = 0; i < Iterations; i += 1)
+	{
+		const NscCompileStatistics * Stats;
+		ULONGLONG                    Base;
+
+		Code.clear( );
+		DebugSymbols.clear( );
+		std::vector< UINT8 >( ).swap( Code );
+		std::vector< UINT8 >( ).swap( DebugSymbols );
+
+		Base                  = g_Heap.LiveBytes;
+		g_Heap.Allocations    = 0;
+		g_Heap.AllocatedBytes = 0;
+		g_Heap.PeakBytes      = Base;
+
+		Result.Result = Compiler.NscCompileScript(
+			ResRef,
+			Script.Text.data( ),
+			Script.Text.size( ),
+			CompilerVersion,
+			Optimize,
+			true,
+			&TextOut,
+			CompilerFlags | NscCompilerFlag_CollectStatistics,
+			Code,
+			DebugSymbols);
+
+		if (Result.Result == NscResult_Failure)
+			break;
+
+		Stats = &Compiler.NscGetLastCompileStatistics( );
+
+		if ((i == 0) || (Stats->TotalTime < Result.Statistics.TotalTime))
+			Result.Statistics.TotalTime = Stats->TotalTime;
+		if ((i == 0) || (Stats->PreprocessTime < Result.Statistics.PreprocessTime))
+			Result.Statistics.PreprocessTime = Stats->PreprocessTime;
+		if ((i == 0) || (Stats->LexTime < Result.Statistics.LexTime))
+			Result.Statistics.LexTime = Stats->LexTime;
+		if ((i == 0) || (Stats->ParseTime < Result.Statistics.ParseTime))
+			Result.Statistics.ParseTime = Stats->ParseTime;
+		if ((i == 0) || (Stats->CodeGenTime < Result.Statistics.CodeGenTime))
+			Result.Statistics.CodeGenTime = Stats->CodeGenTime;
+		if ((i == 0) || (Stats->DebugSymbolsTime < Result.Statistics.DebugSymbolsTime))
+			Result.Statistics.DebugSymbolsTime = Stats->DebugSymbolsTime;
+
+		//
+		// The counts do not vary between iterations.
+		//
+
+		Result.Statistics.Tokens             = Stats->Tokens;
+		Result.Statistics.SourceLines        = Stats->SourceLines;
+		Result.Statistics.ParserEntries      = Stats->ParserEntries;
+		Result.Statistics.ArenaAllocations   = Stats->ArenaAllocations;
+		Result.Statistics.ArenaBytesReserved = Stats->ArenaBytesReserved;
+		Result.Statistics.CodeSize           = Stats->CodeSize;
+		Result.Statistics.Instructions       = Stats->Instructions;
+
+		Result.Heap.Allocations    = g_Heap.Allocations;
+		Result.Heap.AllocatedBytes = g_Heap.AllocatedBytes;
+		Result.Heap.PeakBytes      = g_Heap.PeakBytes - Base;
+	}
+
+	TextOut.SetQuiet( false );
+
+	Result.CodeBytes         = Code.size( );
+	Result.DebugSymbolsBytes = DebugSymbols.size( );
+}
+
+static
+bool
+CheckTokenStream(
+	nwn2dev__in NscCompiler & Compiler,
+	nwn2dev__in ResourceManager & ResMan,
+	nwn2dev__in const BenchScript & Script,
+	nwn2dev__in int CompilerVersion,
+	nwn2dev__in bool Optimize,
+	nwn2dev__in UINT32 CompilerFlags,
+	nwn2dev__out ULONGLONG & Tokens
+	)
+/*++
+
+Routine Description:
+
+	This routine compiles a script once with the lexer and once with the
+	reference lexer, with the token dump enabled, and checks that both
+	produce the same token stream (including the tokens of every include
+	file) and the same diagnostics.  The first difference is reported.
+
+Arguments:
+
+	Compiler - Supplies the compiler instance.
+
+	ResMan - Supplies the resource manager.
+
+	Script - Supplies the script to compile.
+
+	CompilerVersion - Supplies the compiler version.
+
+	Optimize - Supplies true if optimizations are enabled.
+
+	CompilerFlags - Supplies additional compiler flags.
+
+	Tokens - Receives the number of tokens compared.
+
+Return Value:
+
+	The routine returns true if the token streams are identical.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	NWN::ResRef32        ResRef;
+	std::vector< UINT8 > Code;
+	std::vector< UINT8 > DebugSymbols;
+	StringTextOut        Dump;
+	StringTextOut        ReferenceDump;
+	std::string          Line;
+	std::string          ReferenceLine;
+	size_t               Offset;
+	size_t               ReferenceOffset;
+	unsigned long        LineNumber;
+
+	ResRef = ResMan.ResRef32FromStr( Script.Name );
+	Tokens = 0;
+
+	Compiler.NscCompileScript(
+		ResRef,
+		Script.Text.data( ),
+		Script.Text.size( ),
+		CompilerVersion,
+		Optimize,
+		true,
+		&Dump,
+		CompilerFlags | NscCompilerFlag_DumpTokens,
+		Code,
+		DebugSymbols);
+
+	Code.clear( );
+	DebugSymbols.clear( );
+
+	Compiler.NscCompileScript(
+		ResRef,
+		Script.Text.data( ),
+		Script.Text.size( ),
+		CompilerVersion,
+		Optimize,
+		true,
+		&ReferenceDump,
+		CompilerFlags | NscCompilerFlag_DumpTokens | NscCompilerFlag_ReferenceLexer,
+		Code,
+		DebugSymbols);
+
+	//
+	// Walk both dumps a line at a time so that the first differing token can
+	// be shown.
+	//
+
+	Offset          = 0;
+	ReferenceOffset = 0;
+	LineNumber      = 0;
+
+	for (;;)
+	{
+		size_t End;
+		size_t ReferenceEnd;
+
+		if ((Offset >= Dump.GetText( ).size( )) &&
+		    (ReferenceOffset >= ReferenceDump.GetText( ).size( )))
+		{
+			return true;
+		}
+
+		End          = Dump.GetText( ).find( '\n', Offset );
+		ReferenceEnd = ReferenceDump.GetText( ).find( '\n', ReferenceOffset );
+
+		if (End == std::string::npos)
+			End = Dump.GetText( ).size( );
+		if (ReferenceEnd == std::string::npos)
+			ReferenceEnd = ReferenceDump.GetText( ).size( );
+
+		Line.assign( Dump.GetText( ), Offset, End - Offset );
+		ReferenceLine.assign( ReferenceDump.GetText( ), ReferenceOffset, ReferenceEnd - ReferenceOffset );
+
+		LineNumber += 1;
+
+		if (Line != ReferenceLine)
+		{
+			fprintf(
+				stderr,
+				"Token stream mismatch for \"%s\" at dump line %lu:\n"
+				"  lexer:     %s\n"
+				"  reference: %s\n",
+				Script.Name.c_str( ),
+				LineNumber,
+				(Offset < Dump.GetText( ).size( )) ? Line.c_str( ) : "<end>",
+				(ReferenceOffset < ReferenceDump.GetText( ).size( )) ? ReferenceLine.c_str( ) : "<end>");
+
+			return false;
+		}
+
+		if (!Line.compare( 0, 7, "Token: " ))
+			Tokens += 1;
+
+		Offset          = End + 1;
+		ReferenceOffset = ReferenceEnd + 1;
+	}
+}
+
+static
+const char *
+GetResultName(
+	nwn2dev__in NscResult Result
+	)
+/*++
+
+Routine Description:
+
+	This routine returns the JSON name of a compilation result.
+
+Arguments:
+
+	Result - Supplies the compilation result.
+
+Return Value:
+
+	The routine returns the name of the result.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	switch (Result)
+	{
+
+	case NscResult_Success:
+		return "success";
+
+	case NscResult_Include:
+		return "include";
+
+	default:
+		return "failure";
+
+	}
+}
+
+static
+void
+WriteJsonString(
+	nwn2dev__in FILE * f,
+	nwn2dev__in const std::string & Str
+	)
+/*++
+
+Routine Description:
+
+	This routine writes a quoted, escaped JSON string.
+
+Arguments:
+
+	f - Supplies the output file.
+
+	Str - Supplies the string to write.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	fputc( '"', f );
+
+	for (std::string::const_iterator it = Str.begin( ); it != Str.end( ); ++it)
+	{
+		unsigned char c = (unsigned char) *it;
+
+		if ((c == '"') || (c == '\\'))
+			fprintf( f, "\\%c", c );
+		else if (c < 0x20)
+			fprintf( f, "\\u%04x", c );
+		else
+			fputc( c, f );
+	}
+
+	fputc( '"', f );
+}
+
+static
+bool
+WriteJsonReport(
+	nwn2dev__in const char * FileName,
+	nwn2dev__in const BenchScriptVec & Scripts,
+	nwn2dev__in const BenchResultVec & Results,
+	__in_opt const BenchResultVec * ReferenceResults,
+	nwn2dev__in int CompilerVersion,
+	nwn2dev__in bool Optimize,
+	nwn2dev__in unsigned long Iterations
+	)
+/*++
+
+Routine Description:
+
+	This routine writes the benchmark results as a JSON document.  A file name
+	of "-" writes the document to standard output.
+
+	The summary gives the lexer throughput, in tokens per second of lexing
+	time (excluding preprocessing).  If the scripts were also measured with
+	the reference lexer, its throughput is given alongside for comparison.
+
+Arguments:
+
+	FileName - Supplies the file name to write to.
+
+	Scripts - Supplies the corpus.
+
+	Results - Supplies the measurements for each compiled script, in the
+	          order of the compiled scripts in the corpus.
+
+	ReferenceResults - Optionally supplies the measurements taken with the
+	                   reference lexer, in the same order as Results.
+
+	CompilerVersion - Supplies the compiler version.
+
+	Optimize - Supplies true if optimizations were enabled.
+
+	Iterations - Supplies the number of timed compilations per script.
+
+Return Value:
+
+	The routine returns true if the report was written.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	FILE                     * f;
+	ULONGLONG                  TotalTime;
+	ULONGLONG                  TotalTokens;
+	ULONGLONG                  TotalBytes;
+	ULONGLONG                  TotalLexTime;
+	ULONGLONG                  TotalPreprocessTime;
+	unsigned long              Compiled;
+	unsigned long              Failures;
+	BenchResultVec::size_type  r;
+
+	if (!strcmp( FileName, "-" ))
+		f = stdout;
+	else
+		f = fopen( FileName, "wt" );
+
+	if (f == NULL)
+		return false;
+
+	fprintf(
+		f,
+		"{\n"
+		"  \"compiler\": \"%s %s\",\n"
+		"  \"version\": %d,\n"
+		"  \"optimize\": %s,\n"
+		"  \"iterations\": %lu,\n"
+		"  \"scripts\": [\n",
+		__DATE__,
+		__TIME__,
+		CompilerVersion,
+		Optimize ? "true" : "false",
+		Iterations);
+
+	TotalTime   = 0;
+	TotalTokens = 0;
+	TotalBytes  = 0;
+	TotalLexTime        = 0;
+	TotalPreprocessTime = 0;
+	Compiled    = 0;
+	Failures    = 0;
+	r           = 0;
+
+	for (BenchScriptVec::const_iterator it = Scripts.begin( );
+	     it != Scripts.end( );
+	     ++it)
+	{
+		if (it->Include)
+			continue;
+
+		const BenchResult & Result = Results[ r++ ];
+
+		Compiled    += 1;
+
+		//
+		// A failed script has no complete measurements, so it is left out of
+		// the totals.
+		//
+
+		if (Result.Result == NscResult_Failure)
+		{
+			Failures += 1;
+		}
+		else
+		{
+			TotalTime           += Result.Statistics.TotalTime;
+			TotalTokens         += Result.Statistics.Tokens;
+			TotalBytes          += Result.SourceBytes;
+			TotalLexTime        += Result.Statistics.LexTime;
+			TotalPreprocessTime += Result.Statistics.PreprocessTime;
+		}
+
+		fprintf( f, "    {\n      \"name\": " );
+		WriteJsonString( f, it->Name );
+		fprintf(
+			f,
+			",\n"
+			"      \"result\": \"%s\",\n"
+			"      \"source_bytes\": %lu,\n"
+			"      \"source_lines\": %I64u,\n"
+			"      \"tokens\": %I64u,\n"
+			"      \"code_bytes\": %lu,\n"
+			"      \"ndb_bytes\": %lu,\n"
+			"      \"instructions\": %I64u,\n"
+			"      \"time_us\": {\n"
+			"        \"total\": %I64u,\n"
+			"        \"preprocess\": %I64u,\n"
+			"        \"lex\": %I64u,\n"
+			"        \"parse\": %I64u,\n"
+			"        \"codegen\": %I64u,\n"
+			"        \"ndb\": %I64u\n"
+			"      },\n"
+			"      \"heap\": {\n"
+			"        \"allocations\": %I64u,\n"
+			"        \"allocated_bytes\": %I64u,\n"
+			"        \"peak_bytes\": %I64u\n"
+			"      },\n"
+			"      \"parser\": {\n"
+			"        \"entries\": %I64u,\n"
+			"        \"arena_allocations\": %I64u,\n"
+			"        \"arena_bytes_reserved\": %I64u\n"
+			"      }\n"
+			"    }%s\n",
+			GetResultName( Result.Result ),
+			(unsigned long) Result.SourceBytes,
+			Result.Statistics.SourceLines,
+			Result.Statistics.Tokens,
+			(unsigned long) Result.CodeBytes,
+			(unsigned long) Result.DebugSymbolsBytes,
+			Result.Statistics.Instructions,
+			Result.Statistics.TotalTime,
+			Result.Statistics.PreprocessTime,
+			Result.Statistics.LexTime,
+			Result.Statistics.ParseTime,
+			Result.Statistics.CodeGenTime,
+			Result.Statistics.DebugSymbolsTime,
+			Result.Heap.Allocations,
+			Result.Heap.AllocatedBytes,
+			Result.Heap.PeakBytes,
+			Result.Statistics.ParserEntries,
+			Result.Statistics.ArenaAllocations,
+			Result.Statistics.ArenaBytesReserved,
+			(r == Results.size( )) ? "" : ",");
+	}
+
+	fprintf(
+		f,
+		"  ],\n"
+		"  \"summary\": {\n"
+		"    \"scripts\": %lu,\n"
+		"    \"failures\": %lu,\n"
+		"    \"total_time_us\": %I64u,\n"
+		"    \"scripts_per_second\": %.1f,\n"
+		"    \"tokens_per_second\": %.1f,\n"
+		"    \"source_bytes_per_second\": %.1f,\n"
+		"    \"lex_time_us\": %I64u,\n"
+		"    \"preprocess_time_us\": %I64u,\n"
+		"    \"lex_tokens_per_second\": %.1f",
+		Compiled,
+		Failures,
+		TotalTime,
+		TotalTime ? (double) (Compiled - Failures) * 1000000.0 / (double) TotalTime : 0.0,
+		TotalTime ? (double) TotalTokens * 1000000.0 / (double) TotalTime : 0.0,
+		TotalTime ? (double) TotalBytes * 1000000.0 / (double) TotalTime : 0.0,
+		TotalLexTime,
+		TotalPreprocessTime,
+		TotalLexTime ? (double) TotalTokens * 1000000.0 / (double) TotalLexTime : 0.0);
+
+	if (ReferenceResults != NULL)
+	{
+		ULONGLONG ReferenceLexTime;
+		ULONGLONG ReferencePreprocessTime;
+		ULONGLONG ReferenceTokens;
+		ULONGLONG PairedLexTime;
+
+		ReferenceLexTime        = 0;
+		ReferencePreprocessTime = 0;
+		ReferenceTokens         = 0;
+		PairedLexTime           = 0;
+
+		//
+		// Only the scripts that compiled with both lexers are counted, so
+		// that both lexers are compared over the same tokens.
+		//
+
+		for (BenchResultVec::size_type i = 0; i < ReferenceResults->size( ); i += 1)
+		{
+			const BenchResult & Result          = Results[ i ];
+			const BenchResult & ReferenceResult = (*ReferenceResults)[ i ];
+
+			if ((Result.Result == NscResult_Failure) ||
+			    (ReferenceResult.Result == NscResult_Failure))
+			{
+				continue;
+			}
+
+			ReferenceLexTime        += ReferenceResult.Statistics.LexTime;
+			ReferencePreprocessTime += ReferenceResult.Statistics.PreprocessTime;
+			ReferenceTokens         += ReferenceResult.Statistics.Tokens;
+			PairedLexTime           += Result.Statistics.LexTime;
+		}
+
+		fprintf(
+			f,
+			",\n"
+			"    \"reference_lexer\": {\n"
+			"      \"lex_time_us\": %I64u,\n"
+			"      \"preprocess_time_us\": %I64u,\n"
+			"      \"lex_tokens_per_second\": %.1f,\n"
+			"      \"lex_speedup\": %.2f\n"
+			"    }",
+			ReferenceLexTime,
+			ReferencePreprocessTime,
+			ReferenceLexTime ? (double) ReferenceTokens * 1000000.0 / (double) ReferenceLexTime : 0.0,
+			PairedLexTime ? (double) ReferenceLexTime / (double) PairedLexTime : 0.0);
+	}
+
+	fprintf(
+		f,
+		"\n"
+		"  }\n"
+		"}\n");
+
+	if (f != stdout)
+		fclose( f );
+
+	return true;
+}
+
+int
+__cdecl
+main(
+	nwn2dev__in int argc,
+	__in_ecount( argc ) const char * * argv
+	)
+/*++
+
+Routine Description:
+
+	This routine is the entry point symbol for the script compiler benchmark
+	program.
+
+Arguments:
+
+	argc - Supplies the count of command line arguments.
+
+	argv - Supplies the command line argument vector.
+
+Return Value:
+
+	The routine returns the process exit code, which is nonzero if any script
+	failed to compile.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned long              GenerateCount;
+	unsigned long              ChainDepth;
+	unsigned long              Iterations;
+	int                        CompilerVersion;
+	bool                       Optimize;
+	bool                       EnableExtensions;
+	bool                       CheckLexer;
+	UINT32                     CompilerFlags;
+	const char               * JsonFile;
+	std::vector< std::string > Directories;
+	std::vector< std::string > SearchPaths;
+	BenchScriptVec             Scripts;
+	BenchResultVec             Results;
+	BenchResultVec             ReferenceResults;
+	unsigned long              Failures;
+
+	GenerateCount    = 4;
+	ChainDepth       = 32;
+	Iterations       = 5;
+	CompilerVersion  = 999999;
+	Optimize         = false;
+	EnableExtensions = false;
+	CheckLexer       = false;
+	CompilerFlags    = 0;
+	JsonFile         = "-";
+
+	for (int i = 1; i < argc; i += 1)
+	{
+		if ((!_stricmp( argv[ i ], "-g" )) && (i + 1 < argc))
+		{
+			GenerateCount = strtoul( argv[ ++i ], NULL, 10 );
+		}
+		else if ((!_stricmp( argv[ i ], "-c" )) && (i + 1 < argc))
+		{
+			ChainDepth = strtoul( argv[ ++i ], NULL, 10 );
+		}
+		else if ((!_stricmp( argv[ i ], "-d" )) && (i + 1 < argc))
+		{
+			Directories.push_back( argv[ ++i ] );
+			SearchPaths.push_back( argv[ i ] );
+		}
+		else if ((!_stricmp( argv[ i ], "-i" )) && (i + 1 < argc))
+		{
+			SearchPaths.push_back( argv[ ++i ] );
+		}
+		else if ((!_stricmp( argv[ i ], "-n" )) && (i + 1 < argc))
+		{
+			Iterations = strtoul( argv[ ++i ], NULL, 10 );
+		}
+		else if ((!_stricmp( argv[ i ], "-j" )) && (i + 1 < argc))
+		{
+			JsonFile = argv[ ++i ];
+		}
+		else if (!_strnicmp( argv[ i ], "-v", 2 ))
+		{
+			CompilerVersion = 0;
+
+			for (const char * p = argv[ i ] + 2; *p != '\0'; p += 1)
+			{
+				if (isdigit( (unsigned char) *p ))
+				{
+					CompilerVersion = CompilerVersion * 10 + (*p - '0');
+				}
+				else if (*p != '.')
+				{
+					fprintf( stderr, "Invalid version \"%s\".\n", argv[ i ] + 2 );
+					return -1;
+				}
+			}
+		}
+		else if (!_stricmp( argv[ i ], "-o" ))
+		{
+			Optimize = true;
+		}
+		else if (!_stricmp( argv[ i ], "-f" ))
+		{
+			Optimize       = true;
+			CompilerFlags |= NscCompilerFlag_OptimizeInline;
+		}
+		else if (!_stricmp( argv[ i ], "-e" ))
+		{
+			EnableExtensions = true;
+		}
+		else if (!_stricmp( argv[ i ], "-t" ))
+		{
+			CheckLexer = true;
+		}
+		else
+		{
+			fprintf(
+				stderr,
+				"Usage: %s [options]\n"
+				"\n"
+				"Compiles a corpus of scripts and reports per-phase compile times, heap\n"
+				"allocations and peak heap usage for each script as JSON.  Times are the\n"
+				"minimum over all iterations.\n"
+				"\n"
+				"  -g <count> - Generate <count> scripts of each kind (default 4, or 0\n"
+				"               if -d is given).\n"
+				"  -c <depth> - Set the depth of the generated include chain (default 32).\n"
+				"  -d <dir> - Also compile every .nss file in <dir>, which is added to\n"
+				"             the include path.\n"
+				"  -i <path> - Add <path> to the include path.\n"
+				"  -n <iterations> - Set the number of timed compilations per script\n"
+				"                    (default 5).\n"
+				"  -j <file> - Write the JSON report to <file> (default standard output).\n"
+				"  -vx.xx - Set the version of the compiler (default latest).\n"
+				"  -o - Enable optimizations.\n"
+				"  -f - Enable optimizations and in line function expansion.\n"
+				"  -e - Enable non-BioWare extensions.\n"
+				"  -t - Check that the lexer produces the same token stream as the\n"
+				"       reference lexer for every script, and also measure the\n"
+				"       reference lexer.  The exit code is nonzero on a mismatch.\n",
+				argv[ 0 ]);
+
+			return -1;
+		}
+	}
+
+	if (Iterations == 0)
+		Iterations = 1;
+
+	//
+	// A directory corpus is measured on its own unless generated scripts are
+	// explicitly requested as well.
+	//
+
+	if (!Directories.empty( ))
+	{
+		bool GenerateRequested = false;
+
+		for (int i = 1; i < argc; i += 1)
+		{
+			if (!_stricmp( argv[ i ], "-g" ))
+				GenerateRequested = true;
+		}
+
+		if (!GenerateRequested)
+			GenerateCount = 0;
+	}
+
+	try
+	{
+		PrintfTextOut        TextOut;
+		ResourceManager      ResMan( &TextOut );
+		BenchResourceContext ResContext;
+
+		//
+		// Build the corpus.  The built-in nwscript.nss is always served as a
+		// last resort, so that a directory corpus that relies on the real
+		// nwscript.nss picks it up from the include path instead.
+		//
+
+		if (GenerateCount != 0)
+		{
+			GenerateCorpus( GenerateCount, ChainDepth, Scripts );
+		}
+		else
+		{
+			BenchScript NWScript;
+
+			NWScript.Name    = "nwscript";
+			NWScript.Text    = g_BenchNWScript;
+			NWScript.Include = true;
+
+			Scripts.push_back( NWScript );
+		}
+
+		for (std::vector< std::string >::const_iterator it = Directories.begin( );
+		     it != Directories.end( );
+		     ++it)
+		{
+			if (!LoadCorpusDirectory( *it, Scripts ))
+			{
+				fprintf( stderr, "Failed to load scripts from \"%s\".\n", it->c_str( ) );
+				return -1;
+			}
+		}
+
+		//
+		// Create the compiler.  The resource cache is enabled so that include
+		// files are only read once, as in a batch compile.
+		//
+
+		NscCompiler Compiler( ResMan, EnableExtensions );
+
+		ResContext.ResMan  = &ResMan;
+		ResContext.Scripts = &Scripts;
+
+		if (!SearchPaths.empty( ))
+			Compiler.NscSetIncludePaths( SearchPaths );
+
+		Compiler.NscSetExternalResourceLoader(
+			&ResContext,
+			BenchLoadResource,
+			BenchUnloadResource);
+
+		Compiler.NscSetResourceCacheEnabled( true );
+
+		//
+		// Compile each script of the corpus.
+		//
+
+		Failures = 0;
+
+		for (BenchScriptVec::const_iterator it = Scripts.begin( );
+		     it != Scripts.end( );
+		     ++it)
+		{
+			BenchResult Result;
+
+			if (it->Include)
+				continue;
+
+			BenchmarkScript(
+				Compiler,
+				ResMan,
+				TextOut,
+				*it,
+				Iterations,
+				CompilerVersion,
+				Optimize,
+				CompilerFlags,
+				Result);
+
+			if (Result.Result == NscResult_Failure)
+			{
+				fprintf( stderr, "Failed to compile \"%s\".\n", it->Name.c_str( ) );
+				Failures += 1;
+			}
+
+			Results.push_back( Result );
+
+			//
+			// Compare the token stream against the reference lexer, and then
+			// measure the reference lexer in the same way.
+			//
+
+			if (CheckLexer)
+			{
+				ULONGLONG Tokens;
+
+				if (!CheckTokenStream(
+					Compiler,
+					ResMan,
+					*it,
+					CompilerVersion,
+					Optimize,
+					CompilerFlags,
+					Tokens))
+				{
+					Failures += 1;
+				}
+
+				BenchmarkScript(
+					Compiler,
+					ResMan,
+					TextOut,
+					*it,
+					Iterations,
+					CompilerVersion,
+					Optimize,
+					CompilerFlags | NscCompilerFlag_ReferenceLexer,
+					Result);
+
+				if (Result.Result == NscResult_Failure)
+				{
+					fprintf( stderr, "Failed to compile \"%s\" with the reference lexer.\n", it->Name.c_str( ) );
+					Failures += 1;
+				}
+
+				ReferenceResults.push_back( Result );
+			}
+		}
+
+		if (!WriteJsonReport(
+			JsonFile,
+			Scripts,
+			Results,
+			CheckLexer ? &ReferenceResults : NULL,
+			CompilerVersion,
+			Optimize,
+			Iterations))
+		{
+			fprintf( stderr, "Failed to write \"%s\".\n", JsonFile );
+			return -1;
+		}
+	}
+	catch (std::exception &e)
+	{
+		fprintf( stderr, "Exception: '%s'\n", e.what( ) );
+		return -1;
+	}
+
+	return (Failures != 0) ? 1 : 0;
+}
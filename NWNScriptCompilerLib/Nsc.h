@@ -142,6 +142,11 @@ enum NscCompilerFlags
 	NscCompilerFlag_DumpPCode 			= 0x00000001,
 	NscCompilerFlag_ShowIncludes		= 0x00000002,
 	NscCompilerFlag_ShowPreprocessed	= 0x00000004,
+	NscCompilerFlag_OptimizeInline		= 0x00000008,
+	NscCompilerFlag_ShowCodeStatistics	= 0x00000010,
+	NscCompilerFlag_CollectStatistics	= 0x00000020,
+	NscCompilerFlag_ReferenceLexer		= 0x00000040,
+	NscCompilerFlag_DumpTokens			= 0x00000080,
 };
 
 //-----------------------------------------------------------------------------
@@ -899,6 +904,37 @@ struct NscPrototypeDefinition
 	NscTypeVec         ParameterTypes;
 };
 
+//
+// Define the statistics collected for a compilation made with the
+// NscCompilerFlag_CollectStatistics flag.  Times are in microseconds.
+//
+// The parser pulls tokens from the lexer, which in turn pulls source lines
+// from the preprocessor, so the phases are interleaved.  PreprocessTime is
+// the time spent reading source lines and processing directives (including
+// loading include files), LexTime is the time spent tokenizing, and
+// ParseTime is the rest of the time spent in the parser.  All three cover
+// both parser passes.  CodeGenTime excludes DebugSymbolsTime, which is the
+// time spent writing the NDB file.  Compiler initialization (the parsing of
+// nwscript.nss) is not included.
+//
+
+struct NscCompileStatistics
+{
+	ULONGLONG          TotalTime;
+	ULONGLONG          PreprocessTime;
+	ULONGLONG          LexTime;
+	ULONGLONG          ParseTime;
+	ULONGLONG          CodeGenTime;
+	ULONGLONG          DebugSymbolsTime;
+	ULONGLONG          Tokens;
+	ULONGLONG          SourceLines;
+	ULONGLONG          ParserEntries;
+	ULONGLONG          ArenaAllocations;
+	ULONGLONG          ArenaBytesReserved;
+	ULONGLONG          CodeSize;
+	ULONGLONG          Instructions;
+};
+
 //
 // Define the script compiler wrapper.  Note that only one concurrent usage is
 // permitted.
@@ -1065,6 +1101,28 @@ public:
 		m_Initialized = false;
 	}
 
+	// @cmember Adopt the parsed nwscript.nss of another compiler instance.
+
+	//
+	// Share the (immutable) nwscript.nss state of another compiler instance,
+	// so that this compiler need not parse nwscript.nss itself.  The source
+	// compiler must have already been initialized with the same extension
+	// setting and with CompilerVersion, as the reserved words depend on both,
+	// and must not be (re-)initializing concurrently with this call.
+	// Once shared, both compilers may compile concurrently on separate
+	// threads.
+	//
+	// Returns true if the state was shared, else false if the source compiler
+	// was not eligible (in which case this compiler initializes on demand as
+	// usual).
+	//
+
+	bool
+	NscShareNWScript (
+		nwn2dev__in NscCompiler & Source,
+		nwn2dev__in int CompilerVersion
+		);
+
 	// @cmember Set local include paths (searched before the resource system).
 
 	//
@@ -1119,6 +1177,36 @@ public:
 		nwn2dev__in bool EnableCache
 		);
 
+	// @cmember Return the resources loaded by the last compilation.
+
+	//
+	// Return the file names (resource name and extension) of the resources,
+	// i.e. the include files, that were loaded by the last compilation, in the
+	// order in which they were first loaded.  Includes of includes are listed
+	// as well, so the list is the transitive include closure of the script.
+	// The nwscript.nss file is not listed.
+	//
+
+	inline
+	const std::vector< std::string > &
+	NscGetLastDependencies (
+		) const
+	{
+		return m_Dependencies;
+	}
+
+	// @cmember Return the statistics of the last compilation.
+
+	//
+	// Return the statistics collected by the last compilation.  The
+	// statistics are only filled in if the compilation was made with the
+	// NscCompilerFlag_CollectStatistics flag, else they are all zero.
+	//
+
+	const NscCompileStatistics &
+	NscGetLastCompileStatistics (
+		) const;
+
 
 	//
 	// Note, remaining routines are for internal use only.
@@ -1273,6 +1361,19 @@ private:
 		nwn2dev__in NWN::ResType ResType
 		);
 
+	// @cmember Record a resource as a dependency of the current compilation.
+
+	//
+	// Add a resource to the dependency list of the current compilation, if
+	// it is not already present.
+	//
+
+	void
+	NscRecordDependency (
+		nwn2dev__in const NWN::ResRef32 & ResRef,
+		nwn2dev__in NWN::ResType ResType
+		);
+
 	// @cmember Flush the resource cache.
 
 	//
@@ -1298,6 +1399,7 @@ private:
 	bool                          m_CacheResources;
 	ResourceCache                 m_ResourceCache;
 	IDebugTextOut               * m_ErrorOutput;
+	std::vector< std::string >    m_Dependencies;
 
 };
 
@@ -57,12 +57,14 @@
 //
 // @parm bool | fEnableOptimizations | If true, enable optimizations
 //
+// @parm bool | fEnableInlining | If true, code small functions in line
+//
 // @rdesc None.
 //
 //-----------------------------------------------------------------------------
 
 CNscCodeGenerator::CNscCodeGenerator (CNscContext *pCtx, 
-	int nVersion, bool fEnableOptimizations)
+	int nVersion, bool fEnableOptimizations, bool fEnableInlining)
 {
 
 	//
@@ -71,6 +73,12 @@ CNscCodeGenerator::CNscCodeGenerator (CNscContext *pCtx,
 
 	m_pauchCode = NULL;
 	m_pCtx = pCtx;
+	m_nInlineDepth = 0;
+	m_pasInlineConstants = NULL;
+	m_nInlineConstants = 0;
+	m_nLastReturnJump = 0;
+	m_nLastLabel = 0;
+	memset (&m_sStatistics, 0, sizeof (m_sStatistics));
 
 	//
 	// Setup optimization flags
@@ -91,6 +99,7 @@ CNscCodeGenerator::CNscCodeGenerator (CNscContext *pCtx,
 	m_fOptFor = fEnableOptimizations;
 	m_fOptDeclaration = fEnableOptimizations;
 	m_fOptConditional = fEnableOptimizations;
+	m_fOptInline = fEnableInlining;
 
 	//
 	// If we need to turn declaration optimizations off, i.e. to support
@@ -598,6 +607,24 @@ bool CNscCodeGenerator::GenerateOutput (CNwnStream *pCodeOutput,
 	WriteINT32 (&m_pauchCode [9], ulSize);
 	pCodeOutput ->Write (m_pauchCode, m_pauchOut - m_pauchCode);
 
+	//
+	// Collect the code statistics
+	//
+
+	m_sStatistics .nCodeSize = ulSize;
+	m_sStatistics .nInstructions = CountInstructions (8 + 5, ulSize);
+	m_sStatistics .nFunctionsEmitted = m_anFunctions .GetCount ();
+	for (size_t i = 0; i < m_pCtx ->GetGlobalFunctionCount (); i++)
+	{
+		NscSymbol *pSymbol = m_pCtx ->GetGlobalFunction (i);
+		if (pSymbol ->nSymType != NscSymType_Function)
+			continue;
+		NscSymbolFunctionExtra *pExtra = (NscSymbolFunctionExtra *) 
+			m_pCtx ->GetSymbolData (pSymbol ->nExtra);
+		if ((pExtra ->ulFunctionFlags & NscFuncFlag_Defined) != 0)
+			m_sStatistics .nFunctionsDefined++;
+	}
+
 	//
 	// Generate the debug file if requested
 	//
@@ -605,6 +632,10 @@ bool CNscCodeGenerator::GenerateOutput (CNwnStream *pCodeOutput,
 	if (pDebugOutput)
 	{
         char szType [32];
+		LARGE_INTEGER liDebugStart;
+		LARGE_INTEGER liDebugEnd;
+
+		QueryPerformanceCounter (&liDebugStart);
 
 		//
 		// Count the number of global variables
@@ -826,6 +857,10 @@ bool CNscCodeGenerator::GenerateOutput (CNwnStream *pCodeOutput,
 				m_asLines [i] .nCompiledStart, m_asLines [i] .nCompiledEnd);
 			pDebugOutput ->WriteLine (m_pachCode);
 		}
+
+		QueryPerformanceCounter (&liDebugEnd);
+		m_sStatistics .ullDebugOutputTicks = (ULONGLONG) 
+			(liDebugEnd .QuadPart - liDebugStart .QuadPart);
 	}
 	return true;
 }
@@ -845,9 +880,18 @@ void CNscCodeGenerator::GatherUsed (NscSymbol *pSymbol)
 	NscSymbolFunctionExtra *pExtra = (NscSymbolFunctionExtra *) 
 		m_pCtx ->GetSymbolData (pSymbol ->nExtra);
 	unsigned char *pauchCode = m_pCtx ->GetSymbolData (pExtra ->nCodeOffset);
+
+	//
+	// The function is coded as a routine of its own, so scan it as such
+	// even if we got here from an in line function body
+	//
+
+	int nInlineDepthSave = m_nInlineDepth;
+	m_nInlineDepth = 0;
 	GatherUsedEnterFunction (pSymbol);
 	GatherUsed (pauchCode, pExtra ->nCodeSize);
 	GatherUsedLeaveFunction (pSymbol);
+	m_nInlineDepth = nInlineDepthSave;
 }
 
 //-----------------------------------------------------------------------------
@@ -1055,10 +1099,30 @@ void CNscCodeGenerator::GatherUsed (unsigned char *pauchData, size_t nDataSize)
 				pCall ->nDataSize);
 
 			//
-			// Add this function as being used
+			// If the function will be coded in line, then scan its body
+			// as part of the calling function.  The function itself is
+			// only emitted if some other call site needs it.
 			//
 
 			if ((pSymbol ->ulFlags & NscSymFlag_EngineFunc) == 0 &&
+				(pSymbol ->ulFlags & NscSymFlag_Intrinsic) == 0  &&
+				IsInlineCall (pCall ->nFnSymbol, 
+				GatherUsedGetCurrentFunction () == NULL))
+			{
+				NscSymbolFunctionExtra *pExtra = (NscSymbolFunctionExtra *)
+					m_pCtx ->GetSymbolData (pSymbol ->nExtra);
+
+				m_nInlineDepth++;
+				GatherUsed (m_pCtx ->GetSymbolData (pExtra ->nCodeOffset),
+					pExtra ->nCodeSize);
+				m_nInlineDepth--;
+			}
+
+			//
+			// Add this function as being used
+			//
+
+			else if ((pSymbol ->ulFlags & NscSymFlag_EngineFunc) == 0 &&
 				(pSymbol ->ulFlags & NscSymFlag_Intrinsic) == 0  &&
 				(pSymbol ->ulFlags & NscSymFlag_Referenced) == 0)
 			{
@@ -1149,6 +1213,103 @@ void CNscCodeGenerator::GatherUsed (unsigned char *pauchData, size_t nDataSize)
 	}
 }
 
+//-----------------------------------------------------------------------------
+//
+// @mfunc Get the inlining information of a function, scanning the function
+//		body the first time
+//
+// @parm size_t | nFnSymbol | Symbol offset of the function
+//
+// @rdesc Inlining information of the function.
+//
+//-----------------------------------------------------------------------------
+
+CNscCodeGenerator::InlineFunction &CNscCodeGenerator::GetInlineFunction (
+	size_t nFnSymbol)
+{
+	InlineFunction &sFunction = m_mapInlineFunctions [nFnSymbol];
+	if (sFunction .fScanned)
+		return sFunction;
+
+	//
+	// Only small functions with a body may be coded in line
+	//
+
+	NscSymbol *pSymbol = m_pCtx ->GetSymbol (nFnSymbol);
+	NscSymbolFunctionExtra *pExtra = (NscSymbolFunctionExtra *)
+		m_pCtx ->GetSymbolData (pSymbol ->nExtra);
+	sFunction .fScanned = true;
+	sFunction .nCandidate = -1;
+	sFunction .fInlinePermitted = 
+		(pExtra ->ulFunctionFlags & NscFuncFlag_Defined) != 0 &&
+		pExtra ->nCodeSize <= Max_Inline_PCode_Size;
+
+	//
+	// Scan the body for calls, frame dependencies and argument writes
+	//
+
+	if (pExtra ->nCodeSize != 0)
+	{
+		CNscPCodeInlineScanner sScanner (m_pCtx);
+
+		sScanner .ProcessPCodeBlock (m_pCtx ->GetSymbolData (
+			pExtra ->nCodeOffset), pExtra ->nCodeSize);
+		if (!sScanner .GetInlinePermitted ())
+			sFunction .fInlinePermitted = false;
+		sFunction .anCalledFunctions = sScanner .GetCalledFunctions ();
+		sFunction .anModifiedStackOffsets = sScanner .GetModifiedStackOffsets ();
+	}
+	return sFunction;
+}
+
+//-----------------------------------------------------------------------------
+//
+// @mfunc Test to see if a function may be coded in line
+//
+// @parm size_t | nFnSymbol | Symbol offset of the function
+//
+// @rdesc TRUE if the function may be coded in line.
+//
+//-----------------------------------------------------------------------------
+
+bool CNscCodeGenerator::IsInlineCandidate (size_t nFnSymbol)
+{
+	InlineFunction &sFunction = GetInlineFunction (nFnSymbol);
+	if (sFunction .nCandidate >= 0)
+		return sFunction .nCandidate != 0;
+
+	//
+	// A function that can reach itself through the call graph can't be
+	// coded in line, else the expansion would never end
+	//
+
+	bool fCandidate = sFunction .fInlinePermitted;
+	if (fCandidate)
+	{
+		std::vector <size_t> anPending (sFunction .anCalledFunctions);
+		std::map <size_t, bool> mapVisited;
+		while (!anPending .empty ())
+		{
+			size_t nCallee = anPending .back ();
+			anPending .pop_back ();
+			if (nCallee == nFnSymbol)
+			{
+				fCandidate = false;
+				break;
+			}
+			if (mapVisited .find (nCallee) != mapVisited .end ())
+				continue;
+			mapVisited [nCallee] = true;
+			InlineFunction &sCallee = GetInlineFunction (nCallee);
+			anPending .insert (anPending .end (), 
+				sCallee .anCalledFunctions .begin (),
+				sCallee .anCalledFunctions .end ());
+		}
+	}
+	sFunction .nCandidate = fCandidate ? 1 : 0;
+	return fCandidate;
+}
+
 //-----------------------------------------------------------------------------
 //
 // @mfunc Add a simple operator
@@ -2777,6 +2938,7 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 				{
 					NscPCodeVariable *pVar = (NscPCodeVariable *) pHeader;
 					NscSymbol *pSymbol = m_pCtx ->GetSymbol (pVar ->nSymbol);
+					NscPCodeHeader *pConstant;
 					if ((pVar ->ulFlags & NscSymFlag_Global) != 0 &&
 						(pSymbol ->ulFlags & NscSymFlag_TreatAsConstant) != 0)
 					{
@@ -2785,6 +2947,10 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 						pauchInit += sizeof (NscSymbolVariableExtra);
 						CodeData (pauchInit, pExtra ->nInitSize);
 					}
+					else if ((pConstant = GetInlineConstant (pVar)) != NULL)
+					{
+						CodeData ((unsigned char *) pConstant, pConstant ->nOpSize);
+					}
 					else
 					{
 						CodeCP (true, pSymbol, pVar ->nType, pVar ->nSourceType,
@@ -2989,6 +3155,10 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 						CodeInvokeIntrinsic (pExtra ->nIntrinsic, nArgCount,
 							nArgSize);
 					}
+					else if (IsInlineCall (pCall ->nFnSymbol, m_fGlobalScope))
+					{
+						CodeInlineCall (pCall ->nFnSymbol, papArgs);
+					}
 					else
 					{
 						if ((pExtra ->ulFunctionFlags & NscFuncFlag_UsesGlobalVars) != 0 &&
@@ -3062,6 +3232,7 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 					CodeMOVSP (m_nSPDepth + m_nExpDepth - m_nArgumentSize, NULL);
 					if (m_fOptReturn)
 						m_nExpDepth -= m_nReturnSize;
+					m_nLastReturnJump = m_pauchOut - m_pauchCode;
 					CodeJMP (m_pszReturnLabel);
 				}
 				break;
@@ -3185,12 +3356,12 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 					// code the conditional that is valid
 					//
 
-					if (m_fOptConditional && CNscPStackEntry::IsSimpleConstant (
-						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1]))
+					INT32 lCondValue;
+					if (m_fOptConditional && GetConstantCondition (
+						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1],
+						&lCondValue))
 					{
-						NscPCodeConstantInteger *pCI = (NscPCodeConstantInteger *)
-							&pauchData [pBlock ->anOffset [1]];
-						if (pCI ->lValue != 0)
+						if (lCondValue != 0)
 						{
 							CodeData (&pauchData [pBlock ->anOffset [3]], 
 								pBlock ->anSize [3]);
@@ -3301,13 +3472,13 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 					//
 
 					m_pauchLineStart = m_pauchOut;
-					if (m_fOptConditional && CNscPStackEntry::IsSimpleConstant (
-						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1]))
+					INT32 lCondValue;
+					if (m_fOptConditional && GetConstantCondition (
+						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1],
+						&lCondValue))
 					{
 						m_pauchLineStart = m_pauchOut;
-						NscPCodeConstantInteger *pCI = (NscPCodeConstantInteger *)
-							&pauchData [pBlock ->anOffset [1]];
-						if (pCI ->lValue != 0)
+						if (lCondValue != 0)
 							CodeJMP (szStart);
 					}
 					else
@@ -3357,12 +3528,12 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 					//
 
 					int nCondValue = -1;
-					if (m_fOptConditional && CNscPStackEntry::IsSimpleConstant (
-						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1]))
+					INT32 lCondValue;
+					if (m_fOptConditional && GetConstantCondition (
+						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1],
+						&lCondValue))
 					{
-						NscPCodeConstantInteger *pCI = (NscPCodeConstantInteger *)
-							&pauchData [pBlock ->anOffset [1]];
-						nCondValue = pCI ->lValue != 0;
+						nCondValue = lCondValue != 0;
 					}
 
 					//
@@ -3447,12 +3618,12 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 					//
 
 					int nCondValue = -1;
-					if (m_fOptConditional && CNscPStackEntry::IsSimpleConstant (
-						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1]))
+					INT32 lCondValue;
+					if (m_fOptConditional && GetConstantCondition (
+						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1],
+						&lCondValue))
 					{
-						NscPCodeConstantInteger *pCI = (NscPCodeConstantInteger *)
-							&pauchData [pBlock ->anOffset [1]];
-						nCondValue = pCI ->lValue != 0;
+						nCondValue = lCondValue != 0;
 					}
 
 					//
@@ -3574,12 +3745,12 @@ bool CNscCodeGenerator::CodeData (unsigned char *pauchData, size_t nDataSize)
 					// See if we have a constant conditional
 					//
 
-					if (m_fOptConditional && CNscPStackEntry::IsSimpleConstant (
-						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1]))
+					INT32 lCondValue;
+					if (m_fOptConditional && GetConstantCondition (
+						&pauchData [pBlock ->anOffset [1]], pBlock ->anSize [1],
+						&lCondValue))
 					{
-						NscPCodeConstantInteger *pCI = (NscPCodeConstantInteger *)
-							&pauchData [pBlock ->anOffset [1]];
-						if (pCI ->lValue != 0)
+						if (lCondValue != 0)
 						{
 							CodeData (&pauchData [pBlock ->anOffset [3]], pBlock ->anSize [3]);
 						}
@@ -3924,6 +4095,188 @@ do_binaryop:;
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+//
+// @mfunc Code a function body in line at a call site
+//
+// @parm size_t | nFnSymbol | Symbol offset of the called function
+//
+// @parm NscPCodeHeader ** | papArgs | Arguments of the call (including
+//		default argument declarations)
+//
+// @rdesc TRUE if output was generated.
+//
+//-----------------------------------------------------------------------------
+
+bool CNscCodeGenerator::CodeInlineCall (size_t nFnSymbol, 
+	NscPCodeHeader **papArgs)
+{
+	NscSymbol *pSymbol = m_pCtx ->GetSymbol (nFnSymbol);
+	NscSymbolFunctionExtra *pExtra = (NscSymbolFunctionExtra *)
+		m_pCtx ->GetSymbolData (pSymbol ->nExtra);
+	InlineFunction &sFunction = GetInlineFunction (nFnSymbol);
+	int nArgCount = pExtra ->nArgCount;
+	int nArgSize = pExtra ->nArgSize;
+
+	//
+	// Bind the arguments that are simple constants and that the function
+	// never writes.  Reads of such an argument are replaced with the
+	// constant, which lets constant conditionals fold in the body.
+	//
+	// NOTE: The arguments were pushed in reverse order, so the last
+	// argument is at stack offset 0 of the frame.
+	//
+
+	InlineConstant *pasConstants = (InlineConstant *)
+		alloca ((nArgCount + 1) * sizeof (InlineConstant));
+	int nConstants = 0;
+	int nOffset = nArgSize;
+	unsigned char *pauchFnData = &((unsigned char *) 
+		pExtra) [sizeof (NscSymbolFunctionExtra)];
+	for (int i = 0; i < nArgCount; i++)
+	{
+		NscPCodeHeader *pDecl = (NscPCodeHeader *) pauchFnData;
+		NscPCodeHeader *p = papArgs [i];
+		unsigned char *pauchArgData;
+		size_t nArgDataSize;
+
+		nOffset -= m_pCtx ->GetTypeSize (pDecl ->nType);
+		pauchFnData += pDecl ->nOpSize;
+		if (p ->nOpCode == NscPCode_Declaration)
+		{
+			NscPCodeDeclaration *pd = (NscPCodeDeclaration *) p;
+			pauchArgData = ((unsigned char *) p) + pd ->nDataOffset;
+			nArgDataSize = pd ->nDataSize;
+		}
+		else
+		{
+			NscPCodeArgument *pArg = (NscPCodeArgument *) p;
+			pauchArgData = ((unsigned char *) p) + pArg ->nDataOffset;
+			nArgDataSize = pArg ->nDataSize;
+		}
+		if (CNscPStackEntry::IsSimpleConstant (pauchArgData, nArgDataSize) &&
+			std::find (sFunction .anModifiedStackOffsets .begin (),
+			sFunction .anModifiedStackOffsets .end (), nOffset) ==
+			sFunction .anModifiedStackOffsets .end ())
+		{
+			pasConstants [nConstants] .nStackOffset = nOffset;
+			pasConstants [nConstants] .pConstant = 
+				(NscPCodeHeader *) pauchArgData;
+			nConstants++;
+		}
+	}
+
+	//
+	// Save the state of the calling function
+	//
+
+	char *pszReturnLabelSave = m_pszReturnLabel;
+	char *pszBreakLabelSave = m_pszBreakLabel;
+	char *pszContinueLabelSave = m_pszContinueLabel;
+	char *pszDefaultLabelSave = m_pszDefaultLabel;
+	int nReturnSizeSave = m_nReturnSize;
+	int nArgumentSizeSave = m_nArgumentSize;
+	int nSPDepthSave = m_nSPDepth;
+	int nExpDepthSave = m_nExpDepth;
+	int nBreakBlockDepthSave = m_nBreakBlockDepth;
+	int nContinueBlockDepthSave = m_nContinueBlockDepth;
+	bool fMakeDebugFileSave = m_fMakeDebugFile;
+	InlineConstant *pasInlineConstantsSave = m_pasInlineConstants;
+	int nInlineConstantsSave = m_nInlineConstants;
+
+	//
+	// Set up the frame just as CodeRoutine does.  The return value and the
+	// arguments are already on the stack exactly as they would be for the
+	// JSR, and JSR does not touch the value stack, so the body is coded
+	// unchanged.  The NDB has no way to describe the locals of an in line
+	// body, so they are not recorded.
+	//
+
+	char szReturn [NscMaxLabelSize];
+	ForwardLabel (szReturn);
+	m_pszReturnLabel = szReturn;
+	m_nReturnSize = m_pCtx ->GetTypeSize (pSymbol ->nType);
+	m_nArgumentSize = nArgSize;
+	m_nSPDepth = nArgSize;
+	m_nBreakBlockDepth = nArgSize;
+	m_nContinueBlockDepth = nArgSize;
+	m_nExpDepth = 0;
+	m_fMakeDebugFile = false;
+	m_pasInlineConstants = pasConstants;
+	m_nInlineConstants = nConstants;
+
+	//
+	// Code the body
+	//
+
+	m_nInlineDepth++;
+	CodeData (m_pCtx ->GetSymbolData (pExtra ->nCodeOffset), 
+		pExtra ->nCodeSize);
+	m_nInlineDepth--;
+
+	//
+	// If the body ends with a jump to the return label, then the jump is
+	// to the very next instruction and may be dropped.  This can't be done
+	// if some other label was resolved past the jump.
+	//
+
+	size_t nOut = m_pauchOut - m_pauchCode;
+	NscSymbol *pLabel = m_sLinker .Find (szReturn);
+	if (pLabel ->nFirstBackLink != 0 &&
+		m_nLastReturnJump + 6 == nOut &&
+		m_nLastLabel <= m_nLastReturnJump)
+	{
+		BackLink *pLink = (BackLink *) m_sLinker .GetData (
+			pLabel ->nFirstBackLink);
+		if (pLink ->nOffset == m_nLastReturnJump)
+		{
+			pLabel ->nFirstBackLink = pLink ->nNext;
+			m_pauchOut -= 6;
+			nOut -= 6;
+			if (m_pauchLineStart > m_pauchOut)
+				m_pauchLineStart = m_pauchOut;
+			size_t nLines = m_asLines .GetCount ();
+			if (nLines > 0 && m_asLines [nLines - 1] .nCompiledEnd > nOut)
+			{
+				m_asLines [nLines - 1] .nCompiledEnd = nOut;
+				if (m_asLines [nLines - 1] .nCompiledStart > nOut)
+					m_asLines [nLines - 1] .nCompiledStart = nOut;
+			}
+		}
+	}
+
+	//
+	// Resolve the return and remove the arguments
+	//
+
+	ForwardResolve (szReturn);
+	if (nArgSize)
+		CodeMOVSP (nArgSize, &m_nSPDepth);
+
+	//
+	// Restore the state of the calling function.  As with a JSR, the
+	// arguments are gone and the return value remains.
+	//
+
+	m_pszReturnLabel = pszReturnLabelSave;
+	m_pszBreakLabel = pszBreakLabelSave;
+	m_pszContinueLabel = pszContinueLabelSave;
+	m_pszDefaultLabel = pszDefaultLabelSave;
+	m_nReturnSize = nReturnSizeSave;
+	m_nArgumentSize = nArgumentSizeSave;
+	m_nSPDepth = nSPDepthSave;
+	m_nExpDepth = nExpDepthSave - nArgSize;
+	m_nBreakBlockDepth = nBreakBlockDepthSave;
+	m_nContinueBlockDepth = nContinueBlockDepthSave;
+	m_fMakeDebugFile = fMakeDebugFileSave;
+	m_pasInlineConstants = pasInlineConstantsSave;
+	m_nInlineConstants = nInlineConstantsSave;
+
+	m_sStatistics .nCallsInlined++;
+	m_sStatistics .nConstantArguments += nConstants;
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 //
 // @mfunc Scan for case and default labels
@@ -4062,6 +4415,7 @@ void CNscCodeGenerator::ForwardResolve (const char *pszRoutine)
 
 	assert (pSymbol ->nOffset == 0);
 	pSymbol ->nOffset = m_pauchOut - m_pauchCode;
+	m_nLastLabel = pSymbol ->nOffset;
 	size_t nLink = pSymbol ->nFirstBackLink;
 	while (nLink != 0)
 	{
@@ -4100,6 +4454,7 @@ void CNscCodeGenerator::DefineLabel (const char *pszRoutine)
 	{
 		assert (pSymbol ->nOffset == 0);
 		pSymbol ->nOffset = m_pauchOut - m_pauchCode;
+		m_nLastLabel = pSymbol ->nOffset;
 		size_t nLink = pSymbol ->nFirstBackLink;
 		while (nLink != 0)
 		{
@@ -4119,6 +4474,7 @@ void CNscCodeGenerator::DefineLabel (const char *pszRoutine)
 	{
 		pSymbol = m_sLinker .Add (pszRoutine, NscSymType_Linker);
 		pSymbol ->nOffset = m_pauchOut - m_pauchCode;
+		m_nLastLabel = pSymbol ->nOffset;
 		pSymbol ->nFirstBackLink = 0;
 		pSymbol ->nFile = -1;
 		pSymbol ->nLine = -1;
@@ -4383,3 +4739,149 @@ bool CNscCodeGenerator::GetInitializerHasSideEffects (
 
 	return fHasSideEffects;
 }
+
+//-----------------------------------------------------------------------------
+//
+// @mfunc Get the constant bound to an argument of the current in line
+//		function body
+//
+// @parm const NscPCodeVariable * | pVar | Variable reference
+//
+// @rdesc Pointer to the constant PCode or NULL if the variable isn't bound.
+//
+//-----------------------------------------------------------------------------
+
+NscPCodeHeader *CNscCodeGenerator::GetInlineConstant (
+	const NscPCodeVariable *pVar) const
+{
+	if ((pVar ->ulFlags & (NscSymFlag_Global | NscSymFlag_Increments)) != 0 ||
+		pVar ->nElement != -1)
+		return NULL;
+	for (int i = 0; i < m_nInlineConstants; i++)
+	{
+		if (m_pasInlineConstants [i] .nStackOffset == pVar ->nStackOffset &&
+			m_pasInlineConstants [i] .pConstant ->nType == pVar ->nType)
+			return m_pasInlineConstants [i] .pConstant;
+	}
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+//
+// @mfunc Test to see if a conditional is a known integer constant
+//
+// @parm unsigned char * | pauchData | Conditional PCode data
+//
+// @parm size_t | nDataSize | Length of conditional PCode data
+//
+// @parm INT32 * | plValue | Receives the value of the conditional
+//
+// @rdesc TRUE if the conditional is constant.
+//
+//-----------------------------------------------------------------------------
+
+bool CNscCodeGenerator::GetConstantCondition (unsigned char *pauchData, 
+	size_t nDataSize, INT32 *plValue) const
+{
+	NscPCodeHeader *pHeader = (NscPCodeHeader *) pauchData;
+
+	//
+	// If this is a simple constant
+	//
+
+	if (CNscPStackEntry::IsSimpleConstant (pauchData, nDataSize))
+	{
+		*plValue = ((NscPCodeConstantInteger *) pHeader) ->lValue;
+		return true;
+	}
+
+	//
+	// If this is an argument bound to an integer constant
+	//
+
+	if (nDataSize != 0 && pHeader ->nOpSize == nDataSize &&
+		pHeader ->nOpCode == NscPCode_Variable)
+	{
+		pHeader = GetInlineConstant ((NscPCodeVariable *) pHeader);
+		if (pHeader != NULL && pHeader ->nType == NscType_Integer)
+		{
+			*plValue = ((NscPCodeConstantInteger *) pHeader) ->lValue;
+			return true;
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+//
+// @mfunc Count the instructions in the generated code
+//
+// @parm size_t | nStart | Offset of the first instruction
+//
+// @parm size_t | nEnd | Offset of the end of the code
+//
+// @rdesc Number of instructions.
+//
+//-----------------------------------------------------------------------------
+
+size_t CNscCodeGenerator::CountInstructions (size_t nStart, size_t nEnd) const
+{
+	size_t nCount = 0;
+	size_t nOffset = nStart;
+	while (nOffset + 2 <= nEnd)
+	{
+		size_t nSize;
+		switch (m_pauchCode [nOffset])
+		{
+			case NscCode_CPDOWNSP:
+			case NscCode_CPTOPSP:
+			case NscCode_CPDOWNBP:
+			case NscCode_CPTOPBP:
+			case NscCode_DESTRUCT:
+				nSize = 8;
+				break;
+
+			case NscCode_CONST:
+				if (m_pauchCode [nOffset + 1] == 5 && nOffset + 4 <= nEnd)
+				{
+					nSize = 4 + ((m_pauchCode [nOffset + 2] << 8) |
+						m_pauchCode [nOffset + 3]);
+				}
+				else
+					nSize = 6;
+				break;
+
+			case NscCode_ACTION:
+				nSize = 5;
+				break;
+
+			case NscCode_EQUAL:
+			case NscCode_NEQUAL:
+				nSize = m_pauchCode [nOffset + 1] == 0x24 ? 4 : 2;
+				break;
+
+			case NscCode_MOVSP:
+			case NscCode_JMP:
+			case NscCode_JSR:
+			case NscCode_JZ:
+			case NscCode_JNZ:
+			case NscCode_DECISP:
+			case NscCode_INCISP:
+			case NscCode_DECIBP:
+			case NscCode_INCIBP:
+				nSize = 6;
+				break;
+
+			case NscCode_STORE_STATE:
+				nSize = 10;
+				break;
+
+			default:
+				nSize = 2;
+				break;
+		}
+		nOffset += nSize;
+		nCount++;
+	}
+	return nCount;
+}
@@ -78,13 +78,47 @@ class CNscCodeGenerator
 		size_t	nCompiledEnd;
 	};
 
+	struct InlineFunction
+	{
+		bool				fScanned;
+		bool				fInlinePermitted;
+		int					nCandidate;
+		std::vector <size_t> anCalledFunctions;
+		std::vector <int>	anModifiedStackOffsets;
+	};
+
+	struct InlineConstant
+	{
+		int					nStackOffset;
+		NscPCodeHeader		*pConstant;
+	};
+
+	typedef std::map <size_t, InlineFunction> CInlineFunctionMap;
+
 // @access Constructors and destructors
 public:
 
+	enum Constants
+	{
+		Max_Inline_PCode_Size	= 512,	// Largest function body (PCode bytes) coded in line
+		Max_Inline_Depth		= 4		// Deepest nesting of in line function bodies
+	};
+
+	struct CodeStatistics
+	{
+		size_t				nCodeSize;
+		size_t				nInstructions;
+		size_t				nFunctionsDefined;
+		size_t				nFunctionsEmitted;
+		size_t				nCallsInlined;
+		size_t				nConstantArguments;
+		ULONGLONG			ullDebugOutputTicks;
+	};
+
 	// @cmember General constructor
 
 	CNscCodeGenerator (CNscContext *pCtx, int nVersion, 
-		bool fEnableOptimizations);
+		bool fEnableOptimizations, bool fEnableInlining);
 
 	// @cmember Delete the streams
 	
@@ -100,6 +134,13 @@ public:
 // @access Public inline methods
 public:
 
+	// @cmember Get the statistics for the generated code
+
+	const CodeStatistics &GetCodeStatistics () const
+	{
+		return m_sStatistics;
+	}
+
 // @access Protected methods
 protected:
 
@@ -153,6 +194,10 @@ protected:
 
 	bool CodeData (unsigned char *pauchData, size_t nDataSize);
 
+	// @cmember Code a function body in line at a call site
+
+	bool CodeInlineCall (size_t nFnSymbol, NscPCodeHeader **papArgs);
+
 	// @cmember Scan for case statements
 
 	bool CodeScanCase (unsigned char *pauchData, size_t nDataSize);
@@ -219,6 +264,37 @@ protected:
 
 	void GatherUsed (unsigned char *pauchData, size_t nDataSize);
 
+	// @cmember Get (scanning if needed) the inlining information of a function
+
+	InlineFunction &GetInlineFunction (size_t nFnSymbol);
+
+	// @cmember Test to see if a function may be coded in line
+
+	bool IsInlineCandidate (size_t nFnSymbol);
+
+	// @cmember Test to see if a call should be coded in line
+
+	bool IsInlineCall (size_t nFnSymbol, bool fGlobalScope)
+	{
+		if (!m_fOptInline || fGlobalScope || 
+			m_nInlineDepth >= Max_Inline_Depth)
+			return false;
+		return IsInlineCandidate (nFnSymbol);
+	}
+
+	// @cmember Get the constant bound to an in line function argument
+
+	NscPCodeHeader *GetInlineConstant (const NscPCodeVariable *pVar) const;
+
+	// @cmember Test to see if a conditional is a known integer constant
+
+	bool GetConstantCondition (unsigned char *pauchData, 
+		size_t nDataSize, INT32 *plValue) const;
+
+	// @cmember Count the instructions in the generated code
+
+	size_t CountInstructions (size_t nStart, size_t nEnd) const;
+
 	// @cmember Write INT32 reversed...
 
 	void WriteINT32 (unsigned char *pauchData, INT32 l)
@@ -489,6 +565,34 @@ protected:
 
 	int						m_nVersion;
 
+	// @cmember Inlining information of the functions examined so far
+
+	CInlineFunctionMap		m_mapInlineFunctions;
+
+	// @cmember Current depth of in line function bodies
+
+	int						m_nInlineDepth;
+
+	// @cmember Constant arguments of the current in line function body
+
+	InlineConstant			*m_pasInlineConstants;
+
+	// @cmember Number of constant arguments
+
+	int						m_nInlineConstants;
+
+	// @cmember Offset of the last jump to the return label
+
+	size_t					m_nLastReturnJump;
+
+	// @cmember Offset of the last resolved label
+
+	size_t					m_nLastLabel;
+
+	// @cmember Statistics for the generated code
+
+	CodeStatistics			m_sStatistics;
+
 	//
 	// OPTIMIZATION FLAGS
 	//
@@ -536,6 +640,10 @@ protected:
 	// @cmember If true, optimize conditionals
 
 	bool					m_fOptConditional;
+
+	// @cmember If true, code small functions in line
+
+	bool					m_fOptInline;
 };
 
 #endif // ETS_NSCCODEGENERATOR_H
@@ -46,11 +46,23 @@
 #include "NscCodeGenerator.h"
 #include "NscIntrinsicDefs.h"
 
+//-----------------------------------------------------------------------------
+//
+// @func Convert performance counter ticks to microseconds
+//
+// @parm ULONGLONG | ullTicks | Tick count
 //
-// Globals
+// @rdesc Microseconds.
 //
+//-----------------------------------------------------------------------------
+
+static ULONGLONG NscTicksToMicroseconds (ULONGLONG ullTicks)
+{
+	LARGE_INTEGER liFrequency;
 
-CNscContext *g_pCtx;
+	QueryPerformanceFrequency (&liFrequency);
+	return (ullTicks * 1000000) / (ULONGLONG) liFrequency .QuadPart;
+}
 
 //-----------------------------------------------------------------------------
 //
@@ -68,7 +80,7 @@ CNscContext *g_pCtx;
 
 inline void NscAddToken (char *pszName, int nToken, NscCompiler *pCompiler)
 {
-	NscSymbol *pSymbol = pCompiler ->NscGetCompilerState () ->m_sNscReservedWords .Add (
+	NscSymbol *pSymbol = pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_sNscReservedWords .Add (
 		pszName, NscSymType_Token);
 	pSymbol ->nToken = nToken;
 	pSymbol ->nEngineObject = -1;
@@ -100,13 +112,12 @@ bool NscCompilerInitialize (CNwnLoader *pLoader, int nVersion,
 	fEnableExtensions; //4100
 
 	//
-	// Reset 
+	// Reset by starting over with new NWScript state.  The old state may
+	// still be shared with other compilers, so it must not be modified.
 	//
 
-	pCompiler ->NscGetCompilerState () ->m_nNscActionCount = 0;
-	pCompiler ->NscGetCompilerState () ->m_anNscActions .RemoveAll ();
-	pCompiler ->NscGetCompilerState () ->m_sNscReservedWords .Reset ();
-	pCompiler ->NscGetCompilerState () ->m_sNscNWScript .Reset ();
+	pCompiler ->NscGetCompilerState () ->m_pNWScript = 
+		NscNWScriptState::Ptr (new NscNWScriptState);
 
 	//
 	// Add the reserved words
@@ -138,7 +149,8 @@ bool NscCompilerInitialize (CNwnLoader *pLoader, int nVersion,
 	NscAddToken ("OBJECT_SELF",    OBJECT_SELF_CONST, pCompiler);
 	NscAddToken ("OBJECT_INVALID", OBJECT_INVALID_CONST, pCompiler);
 
-	pCompiler ->NscGetCompilerState () ->m_fEnableExtensions = fEnableExtensions;
+	pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_fEnableExtensions = fEnableExtensions;
+	pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_nCompilerVersion = nVersion;
 
 	//
 	// Read NWSCRIPT
@@ -211,8 +223,6 @@ bool NscCompilerInitialize (CNwnLoader *pLoader, int nVersion,
 
 	sCtx .SetupPreprocessor ();
 
-	g_pCtx = &sCtx;
-
 	if (sCtx .parse () != 0 || sCtx .GetErrors () > 0)
 	{
 		if (pTextOut)
@@ -224,7 +234,7 @@ bool NscCompilerInitialize (CNwnLoader *pLoader, int nVersion,
 	// Copy the symbol table
 	//
 
-	sCtx .SaveSymbolTable (&pCompiler ->NscGetCompilerState () ->m_sNscNWScript);
+	sCtx .SaveSymbolTable (&pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_sNscNWScript);
 	return true;
 }
 
@@ -274,6 +284,16 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 {
     //yydebug = 1;
 
+	NscCompileStatistics *psStatistics = &pCompiler ->NscGetCompilerState () ->m_sStatistics;
+	bool fCollectStatistics = (ulCompilerFlags & NscCompilerFlag_CollectStatistics) != 0;
+	LARGE_INTEGER liStart;
+	LARGE_INTEGER liEnd;
+	ULONGLONG ullParseTicks = 0;
+	ULONGLONG ullCodeGenTicks = 0;
+
+	memset (psStatistics, 0, sizeof (*psStatistics));
+	QueryPerformanceCounter (&liStart);
+
 	//
 	// Generate a full name from the partial
 	//
@@ -293,7 +313,7 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 
 	CNscContext sCtx (pCompiler);
 	sCtx .SetLoader (pLoader);
-	sCtx .LoadSymbolTable (&pCompiler ->NscGetCompilerState () ->m_sNscNWScript);
+	sCtx .LoadSymbolTable (&pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_sNscNWScript);
 	if (pErrorOutput)
 	{
 		sCtx. SetErrorOutputStream(pErrorOutput);
@@ -324,7 +344,7 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 		sCtx .SetIncludeTerminatesComment (true);
 	}
 
-	if (pCompiler ->NscGetCompilerState () ->m_fEnableExtensions)
+	if (pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_fEnableExtensions)
 	{
 		sCtx .SetPreprocessorEnabled (true);
 	}
@@ -332,7 +352,14 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 	if ((ulCompilerFlags & NscCompilerFlag_DumpPCode) != 0)
 		sCtx .SetDumpPCode (true);
 
-	g_pCtx = &sCtx;
+	if (fCollectStatistics)
+		sCtx .SetCollectStatistics (true);
+
+	if ((ulCompilerFlags & NscCompilerFlag_ReferenceLexer) != 0)
+		sCtx .SetReferenceLexer (true);
+
+	if ((ulCompilerFlags & NscCompilerFlag_DumpTokens) != 0)
+		sCtx .SetDumpTokens (true);
 
 	//
 	// PHASE 1
@@ -355,7 +382,11 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 	sCtx .AddStream (pStream);
         //sCtx.yydebug = 1;
 	sCtx .SetupPreprocessor ();
+	QueryPerformanceCounter (&liEnd);
+	ullParseTicks -= (ULONGLONG) liEnd .QuadPart;
 	sCtx .parse ();
+	QueryPerformanceCounter (&liEnd);
+	ullParseTicks += (ULONGLONG) liEnd .QuadPart;
 	if (sCtx .GetErrors () > 0)
 	{
 		if (fAllocated)
@@ -384,7 +415,11 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 	sCtx .AddStream (pStream);
 	sCtx .SetPhase2 (true);
 	sCtx .SetupPreprocessor ();
+	QueryPerformanceCounter (&liEnd);
+	ullParseTicks -= (ULONGLONG) liEnd .QuadPart;
 	sCtx .parse ();
+	QueryPerformanceCounter (&liEnd);
+	ullParseTicks += (ULONGLONG) liEnd .QuadPart;
 	if (sCtx .GetErrors () > 0) {
             return NscResult_Failure;
         }
@@ -393,18 +428,55 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 	// Generate the output
 	//
 
-	CNscCodeGenerator sGen (&sCtx, nVersion, fEnableOptimizations);
+	CNscCodeGenerator sGen (&sCtx, nVersion, fEnableOptimizations,
+		(ulCompilerFlags & NscCompilerFlag_OptimizeInline) != 0);
 
 	try
 	{
+		QueryPerformanceCounter (&liEnd);
+		ullCodeGenTicks -= (ULONGLONG) liEnd .QuadPart;
 		if (!sGen .GenerateOutput (pCodeOutput, pDebugOutput))
 			return NscResult_Failure;
+		QueryPerformanceCounter (&liEnd);
+		ullCodeGenTicks += (ULONGLONG) liEnd .QuadPart;
 	}
 	catch (std::exception)
 	{
 		return NscResult_Failure;
 	}
 
+	if ((ulCompilerFlags & NscCompilerFlag_ShowCodeStatistics) != 0)
+	{
+		const CNscCodeGenerator::CodeStatistics &sStats = 
+			sGen .GetCodeStatistics ();
+
+		sCtx .GenerateInternalDiagnostic (
+			"Code statistics for %s: %lu bytes, %lu instructions, "
+			"%lu of %lu functions emitted, %lu calls inlined, "
+			"%lu constant arguments propagated",
+			pszFullName,
+			(unsigned long) sStats .nCodeSize,
+			(unsigned long) sStats .nInstructions,
+			(unsigned long) sStats .nFunctionsEmitted,
+			(unsigned long) sStats .nFunctionsDefined,
+			(unsigned long) sStats .nCallsInlined,
+			(unsigned long) sStats .nConstantArguments);
+
+		const CNwnArena::Statistics &sArena = sCtx .GetArenaStatistics ();
+
+		sCtx .GenerateInternalDiagnostic (
+			"Compiler memory for %s: %lu parser entries, %lu arena "
+			"allocations (%lu extended in place), %lu bytes used of %lu "
+			"bytes in %lu chunks",
+			pszFullName,
+			(unsigned long) sCtx .GetPStackEntryCount (),
+			(unsigned long) sArena .nAllocations,
+			(unsigned long) sArena .nExtensions,
+			(unsigned long) sArena .nBytesAllocated,
+			(unsigned long) sArena .nBytesReserved,
+			(unsigned long) sArena .nChunks);
+	}
+
 	if (pCompiler ->NscGetCompilerState () ->m_fSaveSymbolTable)
 	{
 		//
@@ -414,6 +486,40 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 		sCtx .SaveSymbolTable (&pCompiler ->NscGetCompilerState () ->m_sNscLast);
 	}
 
+	//
+	// Record the statistics.  The parse time collected here includes the
+	// lexer and preprocessor, which are split back out.
+	//
+
+	if (fCollectStatistics)
+	{
+		const CNscCodeGenerator::CodeStatistics &sStats = 
+			sGen .GetCodeStatistics ();
+		const CNwnArena::Statistics &sArena = sCtx .GetArenaStatistics ();
+
+		QueryPerformanceCounter (&liEnd);
+
+		psStatistics ->TotalTime = NscTicksToMicroseconds (
+			(ULONGLONG) (liEnd .QuadPart - liStart .QuadPart));
+		psStatistics ->PreprocessTime = NscTicksToMicroseconds (
+			sCtx .GetPreprocessTicks ());
+		psStatistics ->LexTime = NscTicksToMicroseconds (
+			sCtx .GetLexTicks ());
+		psStatistics ->ParseTime = NscTicksToMicroseconds (ullParseTicks -
+			sCtx .GetPreprocessTicks () - sCtx .GetLexTicks ());
+		psStatistics ->CodeGenTime = NscTicksToMicroseconds (
+			ullCodeGenTicks - sStats .ullDebugOutputTicks);
+		psStatistics ->DebugSymbolsTime = NscTicksToMicroseconds (
+			sStats .ullDebugOutputTicks);
+		psStatistics ->Tokens = sCtx .GetTokenCount ();
+		psStatistics ->SourceLines = sCtx .GetLineCount ();
+		psStatistics ->ParserEntries = sCtx .GetPStackEntryCount ();
+		psStatistics ->ArenaAllocations = sArena .nAllocations;
+		psStatistics ->ArenaBytesReserved = sArena .nBytesReserved;
+		psStatistics ->CodeSize = sStats .nCodeSize;
+		psStatistics ->Instructions = sStats .nInstructions;
+	}
+
 	//
 	// Success
 	//
@@ -497,12 +603,12 @@ NscResult NscCompileScript (CNwnLoader *pLoader, const char *pszName,
 
 const char *NscGetActionName (int nAction, NscCompiler *pCompiler)
 {
-	if (nAction < 0 || nAction >= pCompiler ->NscGetCompilerState () ->m_nNscActionCount)
+	if (nAction < 0 || nAction >= pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_nNscActionCount)
 		return "UnknownAction";
 	else
 	{
-		NscSymbol *pSymbol = pCompiler ->NscGetCompilerState () ->m_sNscNWScript .GetSymbol (
-			pCompiler ->NscGetCompilerState () ->m_anNscActions [nAction]);
+		NscSymbol *pSymbol = pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_sNscNWScript .GetSymbol (
+			pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_anNscActions [nAction]);
 		return pSymbol ->szString;
 	}
 }
@@ -513,25 +619,16 @@ const char *NscGetActionName (int nAction, NscCompiler *pCompiler)
 //
 //----------------------------------------------------------------------------
 
-#if _NSCCONTEXT_USE_BISONPP
-void yyerror (char *s)
-{
-	g_pCtx->yyerror(s);
-}
-#else
+#if !_NSCCONTEXT_USE_BISONPP
 void yy::parser::error (const yy::parser::location_type& l,
 			const std::string& m) {
     context.yyerror(m.c_str());
 }
-#endif
 
 int yylex (YYSTYPE* yylval, CNscContext& context) {
     return context.yylex(yylval);
 }
-
-int yylex (YYSTYPE* yylval) {
-    return g_pCtx->yylex(yylval);
-}
+#endif
 
 //----------------------------------------------------------------------------
 //
@@ -808,6 +905,8 @@ NscCompiler::NscCompileScript (
 		ScriptNameStr  = m_ResourceManager .StrFromResRef (ScriptName);
 		ScriptNameStr += ".nss";
 
+		m_Dependencies .clear ();
+
 		assert (m_ErrorOutput == NULL);
 		m_ErrorOutput = ErrorOutput;
 		m_ShowIncludes = (CompilerFlags & NscCompilerFlag_ShowIncludes) != 0;
@@ -990,11 +1089,11 @@ NscCompiler::NscGetActionPrototype (
 	if (!m_NWScriptParsed)
 		return false;
 
-	if (Action < 0 || Action >= pCompilerState ->m_nNscActionCount)
+	if (Action < 0 || Action >= pCompilerState ->m_pNWScript ->m_nNscActionCount)
 		return false;
 
-	pSymbol = pCompilerState ->m_sNscNWScript .GetSymbol (
-		pCompilerState ->m_anNscActions [Action]);
+	pSymbol = pCompilerState ->m_pNWScript ->m_sNscNWScript .GetSymbol (
+		pCompilerState ->m_pNWScript ->m_anNscActions [Action]);
 
 	if (pSymbol == NULL)
 		return false;
@@ -1090,6 +1189,22 @@ NscCompiler::NscGetEntrypointSymbolName (
 	return NULL;
 }
 
+//-----------------------------------------------------------------------------
+//
+// @mfunc Return the statistics of the last compilation.
+//
+// @rdesc Returns the statistics, which are all zero unless the compilation
+//        was made with NscCompilerFlag_CollectStatistics.
+//
+//-----------------------------------------------------------------------------
+
+const NscCompileStatistics &
+NscCompiler::NscGetLastCompileStatistics (
+	) const
+{
+	return m_CompilerState ->m_sStatistics;
+}
+
 //-----------------------------------------------------------------------------
 //
 // @mfunc Change error prefix (for build system integration).
@@ -1215,6 +1330,8 @@ NscCompiler::LoadResource (
 
 		if (it != m_ResourceCache .end ())
 		{
+			NscRecordDependency (ResRef, (NWN::ResType) nResType);
+
 			*pulSize     = it ->second .Size;
 			*pfAllocated = false;
 			return it ->second .Contents;
@@ -1263,6 +1380,8 @@ NscCompiler::LoadResource (
 				*pfAllocated = false;
 			}
 
+			NscRecordDependency (ResRef, (NWN::ResType) nResType);
+
 			return FileContents;
 		}
 	}
@@ -1338,6 +1457,8 @@ NscCompiler::LoadResource (
 			*pfAllocated = false;
 		}
 
+		NscRecordDependency (ResRef, (NWN::ResType) nResType);
+
 		return FileContents;
 	}
 
@@ -1439,6 +1560,8 @@ NscCompiler::LoadResource (
 		*pfAllocated = false;
 	}
 
+	NscRecordDependency (ResRef, (NWN::ResType) nResType);
+
 	return FileContents;
 }
 
@@ -1480,6 +1603,48 @@ NscCompiler::NscCompilerInitialize (
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+//
+// @mfunc Adopt the parsed nwscript.nss state of another compiler.
+//
+// @parm NscCompiler & | Source | Initialized compiler to share state with
+//
+// @parm int | CompilerVersion | Bioware-compatible compiler version that
+//		this compiler will compile with
+//
+// @rdesc True if the state was shared.
+//
+//-----------------------------------------------------------------------------
+
+bool
+NscCompiler::NscShareNWScript (
+	nwn2dev__in NscCompiler & Source,
+	nwn2dev__in int CompilerVersion
+	)
+{
+	if (&Source == this)
+		return m_Initialized;
+
+	//
+	// The reserved words depend on both the extension setting and the
+	// compiler version ("const" is only a keyword from version 1.69 on), so
+	// both must match those that the source state was built with.
+	//
+
+	if (!Source .m_Initialized ||
+		Source .m_EnableExtensions != m_EnableExtensions ||
+		Source .m_CompilerState ->m_pNWScript .get () == NULL ||
+		Source .m_CompilerState ->m_pNWScript ->m_nCompilerVersion != CompilerVersion)
+	{
+		return false;
+	}
+
+	m_CompilerState ->m_pNWScript = Source .m_CompilerState ->m_pNWScript;
+	m_Initialized = true;
+	m_NWScriptParsed = true;
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 //
 // @mfunc Read the file into memory
@@ -1581,7 +1746,7 @@ NscCompiler::NscGatherPrototypeFromSymbol (
 
 		if (Prototype .IsActionServiceHandler)
 		{
-			pauchFnData = pCompilerState ->m_sNscNWScript .GetData (
+			pauchFnData = pCompilerState ->m_pNWScript ->m_sNscNWScript .GetData (
 				Symbol ->nExtra);
 		}
 		else
@@ -1693,6 +1858,39 @@ NscCompiler::NscCacheResource (
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+//
+// @mfunc Record a resource as a dependency of the current compilation.
+//
+// @parm const NWN::ResRef32 & | ResRef | ResRef for the resource
+//
+// @parm const NWN::ResType | ResType | ResType for the resource
+//
+// @rdesc None.
+//
+//-----------------------------------------------------------------------------
+
+void
+NscCompiler::NscRecordDependency (
+	nwn2dev__in const NWN::ResRef32 & ResRef,
+	nwn2dev__in NWN::ResType ResType
+	)
+{
+	std::string FileName;
+
+	FileName  = m_ResourceManager .StrFromResRef (ResRef);
+	FileName += ".";
+	FileName += m_ResourceManager .ResTypeToExt (ResType);
+
+	if (std::find (m_Dependencies .begin (), m_Dependencies .end (), FileName) !=
+		m_Dependencies .end ())
+	{
+		return;
+	}
+
+	m_Dependencies .push_back (FileName);
+}
+
 //-----------------------------------------------------------------------------
 //
 // @mfunc Flush the resource cache.
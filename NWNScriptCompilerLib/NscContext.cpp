@@ -44,6 +44,12 @@
 #include "NscPStackEntry.h"
 #include "NscSymbolTable.h"
 
+#if defined (_MSC_VER) && (defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+#define NSC_LEXER_USE_SSE2 1
+#include <emmintrin.h>
+#include <intrin.h>
+#endif
+
 //
 // Externals
 //
@@ -64,24 +70,233 @@ static const char *g_astrNscIntrinsicNames [NscIntrinsic__NumIntrinsics+1] =
 	NULL					// NscIntrinsic__NumIntrinsics
 };
 
+//
+// Lexer character classes.  Bytes that are control characters, DEL or
+// outside of 7-bit ASCII are white space, matching the historical test of
+// (c <= ' ' || c > 126) on a signed char.
+//
 
-#if _NSCCONTEXT_USE_BISONPP
-void yyerror (char *s);
+enum NscCharClass
+{
+	NscCharClass_Space		= 0x01,
+	NscCharClass_Digit		= 0x02,
+	NscCharClass_Alpha		= 0x04,
+};
+
+#define S NscCharClass_Space
+#define D NscCharClass_Digit
+#define I NscCharClass_Alpha
+
+static const unsigned char g_auchNscCharClass [256] =
+{
+	0, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0x00
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0x10
+	S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// 0x20
+	D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0,	// 0x30
+	0, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,	// 0x40
+	I, I, I, I, I, I, I, I, I, I, I, 0, 0, 0, 0, I,	// 0x50
+	0, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,	// 0x60
+	I, I, I, I, I, I, I, I, I, I, I, 0, 0, 0, 0, S,	// 0x70
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0x80
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0x90
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0xA0
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0xB0
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0xC0
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0xD0
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0xE0
+	S, S, S, S, S, S, S, S, S, S, S, S, S, S, S, S,	// 0xF0
+};
+
+#undef S
+#undef D
+#undef I
 
+//
+// Keyword table.  The table is indexed by a perfect hash of the keyword
+// length, first character and last character, chosen offline so that no
+// two keywords collide:
+//
+//		(nLength + psz [0] * 12 + psz [nLength - 1] * 3) & 63
+//
+// The reserved word table built by NscCompilerInitialize remains the
+// authority; this table only lets the lexer resolve keywords without a
+// symbol table search.  If the table is changed, the hash must be checked
+// for collisions again.
+//
+
+struct NscKeyword
+{
+	const char		*pszName;
+	size_t			nLength;
+	int				nToken;
+};
+
+static const NscKeyword g_asNscKeywords [64] =
+{
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "const", 5, NWCONST },
+	{ "struct", 6, STRUCT_TYPE },
+	{ NULL, 0, 0 },
+	{ "while", 5, WHILE },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "int", 3, INT_TYPE },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "OBJECT_INVALID", 14, OBJECT_INVALID_CONST },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "OBJECT_SELF", 11, OBJECT_SELF_CONST },
+	{ NULL, 0, 0 },
+	{ "default", 7, DEFAULT },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "object", 6, OBJECT_TYPE },
+	{ "case", 4, CASE },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "continue", 8, CONTINUE },
+	{ "action", 6, ACTION_TYPE },
+	{ NULL, 0, 0 },
+	{ "break", 5, BREAK },
+	{ "string", 6, STRING_TYPE },
+	{ "if", 2, IF },
+	{ "for", 3, FOR },
+	{ "switch", 6, SWITCH },
+	{ NULL, 0, 0 },
+	{ "vector", 6, VECTOR_TYPE },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "return", 6, RETURN },
+	{ "float", 5, FLOAT_TYPE },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "else", 4, ELSE },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "void", 4, VOID_TYPE },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "do", 2, DO },
+};
+
+//-----------------------------------------------------------------------------
+//
+// @func Look up a keyword
+//
+// @parm const char * | psz | Identifier text
+//
+// @parm size_t | nLength | Length of the identifier
+//
+// @rdesc Keyword entry, or NULL if the identifier is not a keyword.
+//
+//-----------------------------------------------------------------------------
+
+static inline const NscKeyword *NscFindKeyword (const char *psz, size_t nLength)
+{
+	const NscKeyword *pKeyword = &g_asNscKeywords [(nLength + 
+		(unsigned char) psz [0] * 12 + 
+		(unsigned char) psz [nLength - 1] * 3) & 63];
+
+	if (pKeyword ->nLength != nLength ||
+		memcmp (pKeyword ->pszName, psz, nLength) != 0)
+		return NULL;
+	return pKeyword;
+}
+
+//-----------------------------------------------------------------------------
+//
+// @func Scan to the end of an identifier
+//
+// @parm char * | psz | Pointer to the identifier text.  When SSE2 is used,
+//		the buffer must remain readable for 16 bytes past the terminator;
+//		the stream line buffers always are.
+//
+// @rdesc Pointer to the first character that is not part of the identifier.
+//
+//-----------------------------------------------------------------------------
+
+static inline char *NscScanIdentifier (char *psz)
+{
+#if NSC_LEXER_USE_SSE2
+	const __m128i vCase = _mm_set1_epi8 (0x20);
+	const __m128i vBeforeA = _mm_set1_epi8 ('a' - 1);
+	const __m128i vAfterZ = _mm_set1_epi8 ('z' + 1);
+	const __m128i vBefore0 = _mm_set1_epi8 ('0' - 1);
+	const __m128i vAfter9 = _mm_set1_epi8 ('9' + 1);
+	const __m128i vUnderscore = _mm_set1_epi8 ('_');
+
+	for (;;)
+	{
+
+		//
+		// Compare 16 characters at a time.  Folding in the case bit maps
+		// only 'A'-'Z' and 'a'-'z' into 'a'-'z'; bytes above 0x7F are
+		// negative and so fall outside of every (signed) range.
+		//
+
+		__m128i v = _mm_loadu_si128 ((const __m128i *) psz);
+		__m128i vFolded = _mm_or_si128 (v, vCase);
+		__m128i vAlpha = _mm_and_si128 (
+			_mm_cmpgt_epi8 (vFolded, vBeforeA),
+			_mm_cmplt_epi8 (vFolded, vAfterZ));
+		__m128i vDigit = _mm_and_si128 (
+			_mm_cmpgt_epi8 (v, vBefore0),
+			_mm_cmplt_epi8 (v, vAfter9));
+		__m128i vIdent = _mm_or_si128 (_mm_or_si128 (vAlpha, vDigit),
+			_mm_cmpeq_epi8 (v, vUnderscore));
+		unsigned long ulMask = (unsigned long) 
+			(~_mm_movemask_epi8 (vIdent) & 0xFFFF);
+
+		if (ulMask != 0)
+		{
+			unsigned long ulIndex;
+
+			_BitScanForward (&ulIndex, ulMask);
+			return psz + ulIndex;
+		}
+
+		psz += 16;
+	}
+#else
+	while ((g_auchNscCharClass [(unsigned char) *psz] & 
+		(NscCharClass_Alpha | NscCharClass_Digit)) != 0)
+		psz++;
+	return psz;
+#endif
+}
+
+
+#if _NSCCONTEXT_USE_BISONPP
 class Myyyparser : public yyparser
 {
 
 public:
 
-	Myyyparser (CNscContext & ctx) : m_ctx (ctx) {}
+	Myyyparser (CNscContext & ctx) : yyparser (ctx) {}
 	virtual ~Myyyparser () {}
 
-	virtual int yylex () { return m_ctx.yylex (&yylval); }
-	virtual void yyerror (const char *message) { m_ctx.yyerror (message); }
-
-private:
-
-	CNscContext & m_ctx;
+	virtual int yylex () { return context.yylex (&yylval); }
+	virtual void yyerror (const char *message) { context.yyerror (message); }
 
 };
 #endif
@@ -131,6 +346,16 @@ CNscContext::CNscContext (NscCompiler *pCompiler)
 	m_nMaxTokenLength = Max_Line_Length - 1;
 	m_nMaxFunctionParameterCount = INT_MAX;
 	m_nMaxIdentifierCount = INT_MAX;
+	m_pDeclType = NULL;
+	m_nLastDeclSymbol = 0xFFFFFFFF;
+	m_nPStackEntries = 0;
+	m_fCollectStatistics = false;
+	m_ullPreprocessTicks = 0;
+	m_ullLexTicks = 0;
+	m_ullTokens = 0;
+	m_ullLines = 0;
+	m_fReferenceLexer = false;
+	m_fDumpTokens = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -156,18 +381,19 @@ CNscContext::~CNscContext ()
 			pEntry ->m_pszFile, pEntry ->m_nLine);
 #endif
 		pEntry ->Free ();
-		delete pEntry;
+		pEntry ->~CNscPStackEntry ();
 	}
 
 	//
-	// Delete all the free entries
+	// Delete all the free entries.  Their storage belongs to the arena,
+	// which is released in bulk when the context goes away.
 	//
 
 	while (m_listEntryFree .GetNext () != &m_listEntryFree)
 	{
 		CNwnDoubleLinkList *pNext = m_listEntryFree .GetNext ();
 		CNscPStackEntry *pEntry = (CNscPStackEntry *) pNext;
-		delete pEntry;
+		pEntry ->~CNscPStackEntry ();
 	}
 
 	//
@@ -205,13 +431,129 @@ int CNscContext::parse ()
 
 //-----------------------------------------------------------------------------
 //
-// @mfunc Get the next token from the current line or NULL if out
+// @mfunc Get the next token, timing the lexer if statistics are collected
+//		and writing the token out if tokens are dumped
+//
+// @parm YYSTYPE * | yylval | Receives the token value
 //
 // @rdesc Token ID.
 //
 //-----------------------------------------------------------------------------
 
 int CNscContext::yylex (YYSTYPE* yylval)
+{
+	if (!m_fCollectStatistics && !m_fDumpTokens)
+		return yylexInt (yylval);
+
+	int nToken;
+
+	if (m_fCollectStatistics)
+	{
+
+		//
+		// Time the whole call, then take out the time that was spent in the
+		// preprocessor reading lines
+		//
+
+		LARGE_INTEGER liStart;
+		LARGE_INTEGER liEnd;
+		ULONGLONG ullPreprocessTicks = m_ullPreprocessTicks;
+
+		QueryPerformanceCounter (&liStart);
+		nToken = yylexInt (yylval);
+		QueryPerformanceCounter (&liEnd);
+
+		m_ullLexTicks += (ULONGLONG) (liEnd .QuadPart - liStart .QuadPart) -
+			(m_ullPreprocessTicks - ullPreprocessTicks);
+		if (nToken != EOF)
+			m_ullTokens++;
+	}
+	else
+		nToken = yylexInt (yylval);
+
+	//
+	// Both phases see the same tokens, so only dump the first
+	//
+
+	if (m_fDumpTokens && !IsPhase2 ())
+		DumpToken (nToken, *yylval);
+	return nToken;
+}
+
+//-----------------------------------------------------------------------------
+//
+// @mfunc Write a token to the error output.  The output is compared between
+//		the optimized and reference lexers, so it includes the value of
+//		every token that has one.
+//
+// @parm int | nToken | Token ID
+//
+// @parm const CNscPStackEntry * | pEntry | Token value, or NULL
+//
+// @rdesc None.
+//
+//-----------------------------------------------------------------------------
+
+void CNscContext::DumpToken (int nToken, const CNscPStackEntry *pEntry)
+{
+	if (m_pErrorStream == NULL)
+		return;
+
+	const char *pszFileName = "";
+	int nLine = 0;
+	if (m_pStreamTop != NULL)
+	{
+		pszFileName = m_pStreamTop ->pStream ->GetFileName ();
+		nLine = m_pStreamTop ->nLine;
+	}
+
+	switch (nToken)
+	{
+		case IDENTIFIER:
+			m_pErrorStream ->WriteText ("Token: %s(%d): %d %s\n",
+				pszFileName, nLine, nToken, pEntry ->GetIdentifier ());
+			break;
+
+		case INTEGER_CONST:
+			m_pErrorStream ->WriteText ("Token: %s(%d): %d %d\n",
+				pszFileName, nLine, nToken, pEntry ->GetInteger ());
+			break;
+
+		case FLOAT_CONST:
+			m_pErrorStream ->WriteText ("Token: %s(%d): %d %.9g\n",
+				pszFileName, nLine, nToken, (double) pEntry ->GetFloat ());
+			break;
+
+		case STRING_CONST:
+			{
+				size_t nLength;
+				const char *pszString = pEntry ->GetString (&nLength);
+				m_pErrorStream ->WriteText ("Token: %s(%d): %d \"%.*s\"\n",
+					pszFileName, nLine, nToken, (int) nLength, pszString);
+			}
+			break;
+
+		case ENGINE_TYPE:
+			m_pErrorStream ->WriteText ("Token: %s(%d): %d type %d\n",
+				pszFileName, nLine, nToken, (int) pEntry ->GetType ());
+			break;
+
+		default:
+			m_pErrorStream ->WriteText ("Token: %s(%d): %d\n",
+				pszFileName, nLine, nToken);
+			break;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// @mfunc Get the next token from the current line or NULL if out
+//
+// @rdesc Token ID.
+//
+//-----------------------------------------------------------------------------
+
+int CNscContext::yylexInt (YYSTYPE* yylval)
 {
 
 	//
@@ -257,7 +599,8 @@ get_next_token:;
 		c = *m_pStreamTop ->pszNextTokenPos;
 		if (c == 0)
 			goto read_another_line;
-		else if (c <= ' ' || c > 126)
+		else if (m_fReferenceLexer ? (c <= ' ' || c > 126) :
+			(g_auchNscCharClass [(unsigned char) c] & NscCharClass_Space) != 0)
 			m_pStreamTop ->pszNextTokenPos++;
 		else
 			break;
@@ -267,18 +610,24 @@ get_next_token:;
 	// If we have an identifier
 	//
 
-	if (isalpha (c) || c == '_')
+	if (m_fReferenceLexer ? (isalpha (c) || c == '_') :
+		(g_auchNscCharClass [(unsigned char) c] & NscCharClass_Alpha) != 0)
 	{
 		char *pszStart = m_pStreamTop ->pszNextTokenPos;
-		m_pStreamTop ->pszNextTokenPos++;
-		for (;;)
+		if (m_fReferenceLexer)
 		{
-			c = *m_pStreamTop ->pszNextTokenPos;
-			if (isalnum (c) || c == '_')
-				m_pStreamTop ->pszNextTokenPos++;
-			else
-				break;
+			m_pStreamTop ->pszNextTokenPos++;
+			for (;;)
+			{
+				c = *m_pStreamTop ->pszNextTokenPos;
+				if (isalnum (c) || c == '_')
+					m_pStreamTop ->pszNextTokenPos++;
+				else
+					break;
+			}
 		}
+		else
+			m_pStreamTop ->pszNextTokenPos = NscScanIdentifier (pszStart + 1);
 
 		int nCount = (int) (m_pStreamTop ->pszNextTokenPos - pszStart);
 
@@ -357,16 +706,41 @@ get_next_token:;
 		}
 
 		//
-		// Get the hash value for the ID
+		// See if it is a keyword.  The keyword table knows nothing of the
+		// version dependent keywords (i.e. const), so those are confirmed
+		// against the reserved words.  The reference lexer searches the
+		// reserved words for every identifier.
 		//
 
-		UINT32 ulHash = CNscSymbolTable::GetHash (pszStart, nCount);
-		
-		//
-		// See if it is a reserved word
-		//
+		NscNWScriptState *pNWScript = m_pCompiler ->NscGetCompilerState () ->m_pNWScript .get ();
+		NscSymbol *pSymbol = NULL;
+
+		if (m_fReferenceLexer)
+		{
+			UINT32 ulHash = CNscSymbolTable::GetHash (pszStart, nCount);
+
+			pSymbol = pNWScript ->m_sNscReservedWords .Find (pszStart, nCount, ulHash);
+		}
+		else
+		{
+			const NscKeyword *pKeyword = NscFindKeyword (pszStart, nCount);
+
+			if (pKeyword != NULL && pKeyword ->nToken != NWCONST)
+				return pKeyword ->nToken;
 
-		NscSymbol *pSymbol = m_pCompiler ->NscGetCompilerState () ->m_sNscReservedWords .Find (pszStart, nCount, ulHash);
+			//
+			// See if it is a reserved word.  Other than keywords, these are
+			// only the engine structure types, so the search can be skipped
+			// if the filter rules that out.
+			//
+
+			if (pKeyword != NULL || pNWScript ->MayBeEngineType (pszStart, nCount))
+			{
+				UINT32 ulHash = CNscSymbolTable::GetHash (pszStart, nCount);
+
+				pSymbol = pNWScript ->m_sNscReservedWords .Find (pszStart, nCount, ulHash);
+			}
+		}
 
 		//
 		// If so, return that word
@@ -402,7 +776,8 @@ get_next_token:;
 	// with a '.'
 	//
 
-	else if (isdigit (c))
+	else if (m_fReferenceLexer ? isdigit (c) != 0 :
+		(g_auchNscCharClass [(unsigned char) c] & NscCharClass_Digit) != 0)
 	{
 
 		// 
@@ -531,13 +906,32 @@ get_next_token:;
 					m_pStreamTop ->pszNextTokenPos++;
 					for (;;)
 					{
-						if (m_pStreamTop ->pszNextTokenPos [0] == '*' &&
-							m_pStreamTop ->pszNextTokenPos [1] == '/')
+
+						//
+						// Let the (vectorized) library search for the next
+						// star, or the end of the line.  The reference lexer
+						// steps a character at a time.
+						//
+
+						char *pszStar;
+
+						if (m_fReferenceLexer)
 						{
-							m_pStreamTop ->pszNextTokenPos += 2;
+							pszStar = m_pStreamTop ->pszNextTokenPos;
+							while (*pszStar != 0 && *pszStar != '*')
+								pszStar++;
+							if (*pszStar == 0)
+								pszStar = NULL;
+						}
+						else
+							pszStar = strchr (m_pStreamTop ->pszNextTokenPos, '*');
+
+						if (pszStar != NULL && pszStar [1] == '/')
+						{
+							m_pStreamTop ->pszNextTokenPos = pszStar + 2;
 							goto try_again;
 						}
-						else if (m_pStreamTop ->pszNextTokenPos [0] == 0)
+						else if (pszStar == NULL)
 						{
 							bool fForceTerminateComment;
 
@@ -553,7 +947,7 @@ get_next_token:;
 							}
 						}
 						else
-							m_pStreamTop ->pszNextTokenPos++;
+							m_pStreamTop ->pszNextTokenPos = pszStar + 1;
 					}
 				}
 				else if (c == '/')
@@ -1676,6 +2070,38 @@ void CNscContext::GenerateMessage (NscMessage nMessage, ...)
 }
 
 
+//-----------------------------------------------------------------------------
+//
+// @mfunc Read the next line, timing the preprocessor if statistics are
+//		collected
+//
+// @parm bool | fInComment | If true, we are in a comment
+//
+// @parm bool * | pfForceTerminateComment | Receives true if the comment
+//		should be forcibly terminated at the end of an include file
+//
+// @rdesc TRUE if a line was read
+//
+//-----------------------------------------------------------------------------
+
+bool CNscContext::ReadNextLine (bool fInComment, bool *pfForceTerminateComment)
+{
+	if (!m_fCollectStatistics)
+		return ReadNextLineInt (fInComment, pfForceTerminateComment);
+
+	LARGE_INTEGER liStart;
+	LARGE_INTEGER liEnd;
+
+	QueryPerformanceCounter (&liStart);
+	bool fRead = ReadNextLineInt (fInComment, pfForceTerminateComment);
+	QueryPerformanceCounter (&liEnd);
+
+	m_ullPreprocessTicks += (ULONGLONG) (liEnd .QuadPart - liStart .QuadPart);
+	if (fRead)
+		m_ullLines++;
+	return fRead;
+}
+
 //-----------------------------------------------------------------------------
 //
 // @mfunc Read the next line in the current script
@@ -1690,7 +2116,7 @@ void CNscContext::GenerateMessage (NscMessage nMessage, ...)
 //
 //-----------------------------------------------------------------------------
 
-bool CNscContext::ReadNextLine (bool fInComment, bool *pfForceTerminateComment)
+bool CNscContext::ReadNextLineInt (bool fInComment, bool *pfForceTerminateComment)
 {
 
 	bool fInPreprocIfSkip;
@@ -1706,8 +2132,18 @@ try_again:;
 	for (;;)
 	{
 		m_pStreamTop ->nLine++;
-		if (m_pStreamTop ->pStream ->ReadLine (
-			m_pStreamTop ->pszLine, Max_Line_Length) == NULL)
+		char *pszLine;
+		if (m_fReferenceLexer)
+		{
+			pszLine = m_pStreamTop ->pStream ->ReadLineByCharacter (
+				m_pStreamTop ->pszLine, Max_Line_Length);
+		}
+		else
+		{
+			pszLine = m_pStreamTop ->pStream ->ReadLine (
+				m_pStreamTop ->pszLine, Max_Line_Length);
+		}
+		if (pszLine == NULL)
 		{
 			if (fInComment || m_pStreamTop ->pNext == NULL)
 			{
@@ -2017,13 +2453,15 @@ try_again:;
 				{
 					p = &pszDTmp [17];
 					int nIndex = atol (p);
-					m_pCompiler ->NscGetCompilerState () ->m_astrNscEngineTypes [nIndex] = pszVTmp;
-					if (m_pCompiler ->NscGetCompilerState () ->m_sNscReservedWords .Find (pszVTmp) == NULL)
+					m_pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_astrNscEngineTypes [nIndex] = pszVTmp;
+					if (m_pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_sNscReservedWords .Find (pszVTmp) == NULL)
 					{
-						NscSymbol *pSymbol = m_pCompiler ->NscGetCompilerState () ->m_sNscReservedWords .Add (
+						NscSymbol *pSymbol = m_pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_sNscReservedWords .Add (
 							pszVTmp, NscSymType_Token);
 						pSymbol ->nToken = ENGINE_TYPE;
 						pSymbol ->nEngineObject = nIndex;
+						m_pCompiler ->NscGetCompilerState () ->m_pNWScript ->AddEngineTypeFilter (
+							pszVTmp, strlen (pszVTmp));
 					}
 				}
 
@@ -3389,7 +3827,7 @@ CNscPStackEntry *CNscContext::GetPStackEntryInt ()
 
 	//
 	// If we can get off the free stack, then do so.  Otherwise, 
-	// create a new one
+	// create a new one in the arena
 	//
 
 	CNscPStackEntry *pEntry;
@@ -3399,7 +3837,11 @@ CNscPStackEntry *CNscContext::GetPStackEntryInt ()
 		pEntry = (CNscPStackEntry *) pNext;
 	}
 	else
-		pEntry = new CNscPStackEntry;
+	{
+		pEntry = new (m_sArena .Alloc (sizeof (CNscPStackEntry))) 
+			CNscPStackEntry (&m_sArena);
+		m_nPStackEntries++;
+	}
 
 	//
 	// Add to the allocated list
@@ -3644,8 +4086,8 @@ NscSymbol *CNscContext::AddPrototype (const char *pszIdentifier,
 
 	if ((ulFlags & NscSymFlag_EngineFunc) != 0)
 	{
-		m_pCompiler ->NscGetCompilerState () ->m_anNscActions .Add (nSymbol);
-		sExtra .nAction = m_pCompiler ->NscGetCompilerState () ->m_nNscActionCount++;
+		m_pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_anNscActions .Add (nSymbol);
+		sExtra .nAction = m_pCompiler ->NscGetCompilerState () ->m_pNWScript ->m_nNscActionCount++;
 	}
 
 	//
@@ -3916,7 +4358,7 @@ const char *CNscContext::GetTypeName (NscType nType)
 			if (nType >= NscType_Engine_0 &&
 				nType < NscType_Struct_0)
 			{
-				return GetCompilerState () ->m_astrNscEngineTypes [nType - NscType_Engine_0] .c_str ();
+				return GetCompilerState () ->m_pNWScript ->m_astrNscEngineTypes [nType - NscType_Engine_0] .c_str ();
 			}
 
 			//
@@ -79,30 +79,114 @@ class NscCompiler;
 //
 //-----------------------------------------------------------------------------
 
-struct NscCompilerState
+//
+// The NWScript state holds everything that is derived from nwscript.nss: the
+// reserved words (including the engine structure types), the action table and
+// the nwscript.nss symbol table.  It is built once, when the compiler is
+// initialized, and is never modified afterwards, so one instance may be
+// shared by any number of compilers, including compilers that are running on
+// other threads.  A compiler that re-initializes builds a new instance rather
+// than resetting the one that it holds.
+//
+
+struct NscNWScriptState
 {
+	typedef swutil::SharedPtr< NscNWScriptState > Ptr;
+
 	CNscSymbolTable               m_sNscReservedWords;
 	int                           m_nNscActionCount;
 	CNwnArray <size_t>            m_anNscActions;
 	CNscSymbolTable               m_sNscNWScript;
-	CNscSymbolTable               m_sNscLast;
-	CNscContext                 * m_pCtx;
 	std::string                   m_astrNscEngineTypes [16];
-	const char                  * m_pszErrorPrefix;
 	bool                          m_fEnableExtensions;
-	bool                          m_fSaveSymbolTable;
+	int                           m_nCompilerVersion;
+
+	//
+	// The engine type filter is a 256-bit set keyed by a cheap function of
+	// an identifier's first and last characters and its length.  The lexer
+	// only searches the reserved words for an identifier that is not a
+	// keyword if its bit is set, which is almost never the case for an
+	// identifier that is not an engine structure type.
+	//
+
+	UINT32                        m_aulEngineTypeFilter [8];
 
 	inline
-	NscCompilerState(
+	NscNWScriptState(
 		)
 	: m_sNscReservedWords (0x400),
 	  m_nNscActionCount (0),
 	  m_anNscActions (),
+	  m_fEnableExtensions (false),
+	  m_nCompilerVersion (0)
+	{
+		memset (m_aulEngineTypeFilter, 0, sizeof (m_aulEngineTypeFilter));
+	}
+
+	static
+	inline
+	UINT32
+	GetEngineTypeFilterIndex(
+		const char *psz,
+		size_t nLength
+		)
+	{
+		return ((UINT32) (unsigned char) psz [0] * 7 +
+			(UINT32) (unsigned char) psz [nLength - 1] * 3 +
+			(UINT32) nLength) & 0xFF;
+	}
+
+	inline
+	void
+	AddEngineTypeFilter(
+		const char *psz,
+		size_t nLength
+		)
+	{
+		if (nLength == 0)
+			return;
+
+		UINT32 ulIndex = GetEngineTypeFilterIndex (psz, nLength);
+
+		m_aulEngineTypeFilter [ulIndex >> 5] |= (1UL << (ulIndex & 31));
+	}
+
+	inline
+	bool
+	MayBeEngineType(
+		const char *psz,
+		size_t nLength
+		) const
+	{
+		UINT32 ulIndex = GetEngineTypeFilterIndex (psz, nLength);
+
+		return (m_aulEngineTypeFilter [ulIndex >> 5] & (1UL << (ulIndex & 31))) != 0;
+	}
+};
+
+//
+// The compiler state holds the per-compiler state.  Nothing in it is shared
+// between compiler instances, except for the (immutable) NWScript state.
+//
+
+struct NscCompilerState
+{
+	NscNWScriptState::Ptr         m_pNWScript;
+	CNscSymbolTable               m_sNscLast;
+	CNscContext                 * m_pCtx;
+	const char                  * m_pszErrorPrefix;
+	bool                          m_fSaveSymbolTable;
+	NscCompileStatistics          m_sStatistics;
+
+	inline
+	NscCompilerState(
+		)
+	: m_pNWScript (new NscNWScriptState),
 	  m_pCtx (NULL),
 	  m_pszErrorPrefix ("Error"),
-	  m_fEnableExtensions (false),
 	  m_fSaveSymbolTable (false)
 	{
+		memset (&m_sStatistics, 0, sizeof (m_sStatistics));
 	}
 };
 
@@ -763,6 +847,69 @@ public:
 		return m_nErrors;
 	}
 
+	// @cmember Enable or disable collection of lexer statistics
+
+	void SetCollectStatistics (bool fCollectStatistics)
+	{
+		m_fCollectStatistics = fCollectStatistics;
+	}
+
+	// @cmember Select the reference (unoptimized) lexer
+
+	void SetReferenceLexer (bool fReferenceLexer)
+	{
+		m_fReferenceLexer = fReferenceLexer;
+	}
+
+	// @cmember Enable or disable writing each token to the error output
+
+	void SetDumpTokens (bool fDumpTokens)
+	{
+		m_fDumpTokens = fDumpTokens;
+	}
+
+	// @cmember Get the time spent reading lines and in directives
+
+	ULONGLONG GetPreprocessTicks () const
+	{
+		return m_ullPreprocessTicks;
+	}
+
+	// @cmember Get the time spent tokenizing (excluding preprocessing)
+
+	ULONGLONG GetLexTicks () const
+	{
+		return m_ullLexTicks;
+	}
+
+	// @cmember Get the number of tokens returned to the parser
+
+	ULONGLONG GetTokenCount () const
+	{
+		return m_ullTokens;
+	}
+
+	// @cmember Get the number of source lines handed to the lexer
+
+	ULONGLONG GetLineCount () const
+	{
+		return m_ullLines;
+	}
+
+	// @cmember Get the arena statistics
+
+	const CNwnArena::Statistics &GetArenaStatistics () const
+	{
+		return m_sArena .GetStatistics ();
+	}
+
+	// @cmember Get the number of PStack entries constructed
+
+	size_t GetPStackEntryCount () const
+	{
+		return m_nPStackEntries;
+	}
+
 	// @cmember Get the loader
 
 	CNwnLoader *GetLoader ()
@@ -840,6 +987,34 @@ public:
 		m_fPhase2 = fPhase2;
 	}
 
+	// @cmember Get the type of the declaration being parsed
+
+	CNscPStackEntry *GetDeclType () const
+	{
+		return m_pDeclType;
+	}
+
+	// @cmember Set the type of the declaration being parsed
+
+	void SetDeclType (CNscPStackEntry *pDeclType)
+	{
+		m_pDeclType = pDeclType;
+	}
+
+	// @cmember Get the symbol offset of the last declared symbol
+
+	size_t GetLastDeclSymbol () const
+	{
+		return m_nLastDeclSymbol;
+	}
+
+	// @cmember Set the symbol offset of the last declared symbol
+
+	void SetLastDeclSymbol (size_t nLastDeclSymbol)
+	{
+		m_nLastDeclSymbol = nLastDeclSymbol;
+	}
+
 	// @cmember Return TRUE if we are in global scope
 
 	bool IsGlobalScope () const
@@ -1584,6 +1759,18 @@ protected:
 
 	bool ReadNextLine (bool fInComment, bool *pfForceTerminateComment);
 
+	// @cmember Read the next line (untimed)
+
+	bool ReadNextLineInt (bool fInComment, bool *pfForceTerminateComment);
+
+	// @cmember Get the next token (untimed)
+
+	int yylexInt (YYSTYPE* yylval);
+
+	// @cmember Write a token to the error output
+
+	void DumpToken (int nToken, const CNscPStackEntry *pEntry);
+
 // @cmember Protected members
 protected:
 
@@ -1704,6 +1891,43 @@ protected:
 
 	CNwnLoader				*m_pLoader;
 
+	// @cmember If true, time the lexer and preprocessor
+
+	bool					m_fCollectStatistics;
+
+	// @cmember Time spent reading lines and in directives
+
+	ULONGLONG				m_ullPreprocessTicks;
+
+	// @cmember Time spent tokenizing
+
+	ULONGLONG				m_ullLexTicks;
+
+	// @cmember Tokens returned to the parser
+
+	ULONGLONG				m_ullTokens;
+
+	// @cmember Source lines handed to the lexer
+
+	ULONGLONG				m_ullLines;
+
+	// @cmember If true, use the reference lexer that the optimized lexer
+	//		is checked against
+
+	bool					m_fReferenceLexer;
+
+	// @cmember If true, write each token to the error output
+
+	bool					m_fDumpTokens;
+
+	// @cmember Arena for the PStack entries and their buffers
+
+	CNwnArena				m_sArena;
+
+	// @cmember Number of PStack entries constructed
+
+	size_t					m_nPStackEntries;
+
 	// @cmember Allocated entry list
 
 	CNwnDoubleLinkList		m_listEntryAllocated;
@@ -1883,6 +2107,14 @@ protected:
 	// @cmember Maximum number of identifiers allowed.
 
 	int						m_nMaxIdentifierCount;
+
+	// @cmember Type of the declaration being parsed
+
+	CNscPStackEntry			*m_pDeclType;
+
+	// @cmember Symbol offset of the last declared symbol
+
+	size_t					m_nLastDeclSymbol;
 };
 
 #endif // ETS_NSCCONTEXT_H
@@ -532,6 +532,66 @@ bool CNscPCodeSideEffectChecker::OnPCodeEntry (PCodeEntryParameters *pEntry)
 
 }
 
+//-----------------------------------------------------------------------------
+//
+// @mfunc Process a PCode block, recording the properties that decide
+//		whether a function body may be coded in line at its call sites
+//
+// @parm PCodeEntryParameters * | pEntry | PCode entry descriptor
+//
+// @rdesc True (the whole block is always scanned).
+//
+//-----------------------------------------------------------------------------
+
+bool CNscPCodeInlineScanner::OnPCodeEntry (PCodeEntryParameters *pEntry)
+{
+	NscPCode nOpCode = pEntry ->pHeader ->nOpCode;
+
+	//
+	// If this is a call, then record script functions as callees.  The
+	// intrinsics read and write BP and SP directly, so a function that
+	// uses them must keep its own frame.
+	//
+
+	if (nOpCode == NscPCode_Call)
+	{
+		const NscPCodeCall *pCall = (const NscPCodeCall *) pEntry ->pHeader;
+		NscSymbol *pSymbol = GetNscContext () ->GetSymbol (pCall ->nFnSymbol);
+
+		if ((pSymbol ->ulFlags & NscSymFlag_Intrinsic) != 0)
+			m_fInlinePermitted = false;
+		else if ((pSymbol ->ulFlags & NscSymFlag_EngineFunc) == 0)
+			m_anCalledFunctions .push_back (pCall ->nFnSymbol);
+	}
+
+	//
+	// If this is an action argument, then the function saves its frame
+	// with STORE_STATE and must keep its own frame
+	//
+
+	else if (nOpCode == NscPCode_Argument)
+	{
+		if (pEntry ->pHeader ->nType == NscType_Action)
+			m_fInlinePermitted = false;
+	}
+
+	//
+	// If this is an assignment or an increment of a local, then record
+	// the local as modified
+	//
+
+	else if ((nOpCode >= NscPCode__First_Assignment &&
+	          nOpCode <= NscPCode__Last_Assignment) ||
+	         (nOpCode == NscPCode_Variable &&
+	          (pEntry ->ulSymbolFlags [0] & NscSymFlag_Increments) != 0))
+	{
+		if ((pEntry ->ulSymbolFlags [0] & NscSymFlag_Global) == 0)
+			m_anModifiedStackOffsets .push_back (pEntry ->nStackOffsets [0]);
+	}
+
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 //
 // @mfunc Process a PCode block, printing the PCode to the console
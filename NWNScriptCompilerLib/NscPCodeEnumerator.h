@@ -291,5 +291,73 @@ private:
 	static const char * GetPCodeOpName (NscPCode nOpCode);
 
 };
+//-----------------------------------------------------------------------------
+// Class definition
+//-----------------------------------------------------------------------------
+
+class CNscPCodeInlineScanner : public CNscPCodeEnumerator
+{
+
+// @access Constructors and destructors
+public:
+
+	// @cmember General constructor
+
+	CNscPCodeInlineScanner (CNscContext *pCtx)
+	: CNscPCodeEnumerator (pCtx)
+	{
+		m_fInlinePermitted = true;
+	}
+
+	// @cmember Delete the object
+	
+	~CNscPCodeInlineScanner ()
+	{
+	}
+
+// @access Public inline methods
+public:
+
+	// @cmember Return true if the scanned function body may be coded in line
+
+	bool GetInlinePermitted () const
+	{
+		return m_fInlinePermitted;
+	}
+
+	// @cmember Get the script functions called by the scanned code
+
+	const std::vector <size_t> &GetCalledFunctions () const
+	{
+		return m_anCalledFunctions;
+	}
+
+	// @cmember Get the local stack offsets written by the scanned code
+
+	const std::vector <int> &GetModifiedStackOffsets () const
+	{
+		return m_anModifiedStackOffsets;
+	}
+
+// @access Private members
+private:
+
+	// @cmember Records calls, frame dependencies and local writes
+
+	virtual bool OnPCodeEntry (PCodeEntryParameters *pEntry);
+
+	// @cmember If true, the code does not depend on having its own frame
+
+	bool					m_fInlinePermitted;
+
+	// @cmember Symbol offsets of the called script functions
+
+	std::vector <size_t>	m_anCalledFunctions;
+
+	// @cmember Stack offsets of locals that are assigned or incremented
+
+	std::vector <int>		m_anModifiedStackOffsets;
+};
+
 #endif // ETS_NSCPCODEENUMERATOR_H
 
@@ -47,17 +47,20 @@
 //
 // @mfunc <c CNscPStackEntry> constructor.
 //
+// @parm CNwnArena * | pArena | Arena for buffers that outgrow the fast space
+//
 // @rdesc None.
 //
 //-----------------------------------------------------------------------------
 
-CNscPStackEntry::CNscPStackEntry ()
+CNscPStackEntry::CNscPStackEntry (CNwnArena *pArena)
 {
 
 	//
 	// Initialize our 1 time init variables
 	//
 
+	m_pArena = pArena;
 	m_pFence = NULL;
 	m_pauchData = m_auchDataFast;
 	m_nDataAlloc = _countof (m_auchDataFast);
@@ -77,7 +80,8 @@ CNscPStackEntry::~CNscPStackEntry ()
 {
 
 	//
-	// Delete any of our allocated variables
+	// Delete any of our allocated variables.  The data and identifier
+	// buffers belong to the arena.
 	//
 
 	if (m_pFence)
@@ -86,10 +90,6 @@ CNscPStackEntry::~CNscPStackEntry ()
 			delete m_pFence ->pSwitchCasesUsed;
 		delete m_pFence;
 	}
-	if (m_pauchData != m_auchDataFast)
-		delete [] m_pauchData;
-	if (m_pszId != m_achIdFast)
-		delete [] m_pszId;
 }
 
 //-----------------------------------------------------------------------------
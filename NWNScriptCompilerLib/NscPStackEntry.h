@@ -48,6 +48,7 @@
 //-----------------------------------------------------------------------------
 
 #include "NwnDoubleLinkList.h"
+#include "NwnArena.h"
 #include "NscSymbolTable.h"
 
 //-----------------------------------------------------------------------------
@@ -67,6 +68,11 @@ class CNscContext;
 //		sized at 64.  Thus, I have decided that it would infact be best to 
 //		allow these values to be set much larger.
 //
+// NOTE: Entries, and any PCode or identifier buffers that outgrow the fast
+//		allocation space, live in the arena of the owning context.  They are
+//		never freed individually; the arena releases them in bulk when the
+//		compilation ends.
+//
 //-----------------------------------------------------------------------------
 
 class CNscPStackEntry
@@ -82,7 +88,7 @@ public:
 
 	// @cmember General constructor
 
-	CNscPStackEntry ();
+	CNscPStackEntry (CNwnArena *pArena);
 
 	// @cmember Delete the streams
 	
@@ -259,9 +265,7 @@ public:
 			nLength = (int) strlen (pszValue);
 		if ((size_t) nLength >= m_nIdAlloc)
 		{
-			if (m_pszId != m_achIdFast)
-				delete [] m_pszId;
-			m_pszId = new char [nLength + 1];
+			m_pszId = (char *) m_pArena ->Alloc (nLength + 1);
 			m_nIdAlloc = nLength + 1;
 		}
 		memcpy (m_pszId, pszValue, nLength);
@@ -553,13 +557,26 @@ protected:
 	{
 		if (m_nDataSize + nSize > m_nDataAlloc)
 		{
-			while (m_nDataSize + nSize > m_nDataAlloc)
-				m_nDataAlloc <<= 1;
-			unsigned char *pauchNew = new unsigned char [m_nDataAlloc];
-			memmove (pauchNew, m_pauchData, m_nDataSize);
-			if (m_pauchData != m_auchDataFast)
-				delete [] m_pauchData;
-			m_pauchData = pauchNew;
+			size_t nAlloc = m_nDataAlloc;
+			while (m_nDataSize + nSize > nAlloc)
+				nAlloc <<= 1;
+
+			//
+			// If the buffer was the last thing carved out of the arena, then
+			// it can simply be extended.  Otherwise, copy it to a new buffer.
+			// The old buffer stays valid until the arena is released, so a
+			// caller appending from its own data is safe.
+			//
+
+			if (m_pauchData == m_auchDataFast ||
+				!m_pArena ->Extend (m_pauchData, m_nDataAlloc, nAlloc))
+			{
+				unsigned char *pauchNew = (unsigned char *) 
+					m_pArena ->Alloc (nAlloc);
+				memcpy (pauchNew, m_pauchData, m_nDataSize);
+				m_pauchData = pauchNew;
+			}
+			m_nDataAlloc = nAlloc;
 		}
 	}
 
@@ -578,6 +595,10 @@ protected:
 
 	UINT32					m_ulFlags;
 
+	// @cmember Arena holding buffers that outgrow the fast space
+
+	CNwnArena				*m_pArena;
+
 	// @cmember Pointer to the fence
 
 	NscSymbolFence			*m_pFence;
@@ -10,9 +10,6 @@
 
 #pragma warning (disable : 4244 4102 4127)
 
-int yylex ();
-void yyerror(char *s);
-
 #ifndef __cplusplus
 #error "Parser yacc output must be compiled as C++"
 #endif
@@ -20,46 +17,46 @@ void yyerror(char *s);
 class CNscPStackEntry;
 #define YYSTYPE CNscPStackEntry *
 
-YYSTYPE NscBuildIdentifier (YYSTYPE p);
-YYSTYPE NscBuildObjectConstant (int nOID);
-YYSTYPE NscBuildVectorConstant (YYSTYPE px, YYSTYPE py, YYSTYPE pz);
-YYSTYPE NscBuildCall (YYSTYPE pfn, YYSTYPE parglist);
-YYSTYPE NscBuildArgExpList (YYSTYPE parglist, YYSTYPE parg);
-YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement);
-YYSTYPE NscBuildPlusMinus (YYSTYPE pValue, int fPlus, int fPre);
-YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue);
-YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE plhs, YYSTYPE prhs);
-YYSTYPE NscBuildLogicalOp (int nToken, YYSTYPE plhs, YYSTYPE prhs);
-YYSTYPE NscBuildConditional (YYSTYPE pSelect, YYSTYPE p1, YYSTYPE p2);
-YYSTYPE NscBuildExpression (YYSTYPE pExpression, YYSTYPE pAssignment);
-YYSTYPE NscBuildStatement (YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence);
-YYSTYPE NscBuildStatementFence ();
-YYSTYPE NscBuildDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration);
-YYSTYPE NscBuildDeclaration (YYSTYPE pType, YYSTYPE pList);
-YYSTYPE NscBuildStructDeclaratorList (YYSTYPE pList, YYSTYPE pDeclarator);
-YYSTYPE NscBuildStructDeclaration (YYSTYPE pType, YYSTYPE pList);
-YYSTYPE NscBuildStructDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration);
-YYSTYPE NscBuildStruct (YYSTYPE pId, YYSTYPE pList);
-YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement);
-YYSTYPE NscBuildFunctionPrototype (YYSTYPE pPrototype);
-YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList);
-YYSTYPE NscBuildParameterList (YYSTYPE pList, YYSTYPE pParameter);
-YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit);
-YYSTYPE NscBuildTranslation (YYSTYPE pList, YYSTYPE pTranslation);
-YYSTYPE NscBuildType (int nType, YYSTYPE pId);
-YYSTYPE NscBuild5Block (int nType, YYSTYPE pPrev, int nAddFence, YYSTYPE pInit, 
+YYSTYPE NscBuildIdentifier (CNscContext *pCtx, YYSTYPE p);
+YYSTYPE NscBuildObjectConstant (CNscContext *pCtx, int nOID);
+YYSTYPE NscBuildVectorConstant (CNscContext *pCtx, YYSTYPE px, YYSTYPE py, YYSTYPE pz);
+YYSTYPE NscBuildCall (CNscContext *pCtx, YYSTYPE pfn, YYSTYPE parglist);
+YYSTYPE NscBuildArgExpList (CNscContext *pCtx, YYSTYPE parglist, YYSTYPE parg);
+YYSTYPE NscBuildElementAccess (CNscContext *pCtx, YYSTYPE pStruct, YYSTYPE pElement);
+YYSTYPE NscBuildPlusMinus (CNscContext *pCtx, YYSTYPE pValue, int fPlus, int fPre);
+YYSTYPE NscBuildUnaryOp (CNscContext *pCtx, int nToken, YYSTYPE pValue);
+YYSTYPE NscBuildBinaryOp (CNscContext *pCtx, int nToken, YYSTYPE plhs, YYSTYPE prhs);
+YYSTYPE NscBuildLogicalOp (CNscContext *pCtx, int nToken, YYSTYPE plhs, YYSTYPE prhs);
+YYSTYPE NscBuildConditional (CNscContext *pCtx, YYSTYPE pSelect, YYSTYPE p1, YYSTYPE p2);
+YYSTYPE NscBuildExpression (CNscContext *pCtx, YYSTYPE pExpression, YYSTYPE pAssignment);
+YYSTYPE NscBuildStatement (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence);
+YYSTYPE NscBuildStatementFence (CNscContext *pCtx);
+YYSTYPE NscBuildDeclarationList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pDeclaration);
+YYSTYPE NscBuildDeclaration (CNscContext *pCtx, YYSTYPE pType, YYSTYPE pList);
+YYSTYPE NscBuildStructDeclaratorList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pDeclarator);
+YYSTYPE NscBuildStructDeclaration (CNscContext *pCtx, YYSTYPE pType, YYSTYPE pList);
+YYSTYPE NscBuildStructDeclarationList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pDeclaration);
+YYSTYPE NscBuildStruct (CNscContext *pCtx, YYSTYPE pId, YYSTYPE pList);
+YYSTYPE NscBuildFunctionDef (CNscContext *pCtx, YYSTYPE pPrototype, YYSTYPE pStatement);
+YYSTYPE NscBuildFunctionPrototype (CNscContext *pCtx, YYSTYPE pPrototype);
+YYSTYPE NscBuildFunctionDeclarator (CNscContext *pCtx, YYSTYPE pType, YYSTYPE pId, YYSTYPE pList);
+YYSTYPE NscBuildParameterList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pParameter);
+YYSTYPE NscBuildParameter (CNscContext *pCtx, YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit);
+YYSTYPE NscBuildTranslation (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pTranslation);
+YYSTYPE NscBuildType (CNscContext *pCtx, int nType, YYSTYPE pId);
+YYSTYPE NscBuild5Block (CNscContext *pCtx, int nType, YYSTYPE pPrev, int nAddFence, YYSTYPE pInit, 
 	YYSTYPE pCond, YYSTYPE pInc, YYSTYPE pTrue, YYSTYPE pFalse);
-YYSTYPE NscBuildBreakContinue (int nToken);
-YYSTYPE NscBuildReturn (YYSTYPE pReturn);
-YYSTYPE NscBuildCase (int nToken, YYSTYPE pCase);
-YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId);
-YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit);
-YYSTYPE NscBuildMakeConstType (YYSTYPE pType);
-YYSTYPE NscBuildBlankStatement ();
-YYSTYPE NscBuildMarkLine (int nIndex, YYSTYPE pStatement);
-void NscBuildSaveLine (int nIndex);
-void NscBuildCopyLine (int nDest, int nSource);
-bool NscBuildSyntaxError (int nToken, YYSTYPE yylval);
+YYSTYPE NscBuildBreakContinue (CNscContext *pCtx, int nToken);
+YYSTYPE NscBuildReturn (CNscContext *pCtx, YYSTYPE pReturn);
+YYSTYPE NscBuildCase (CNscContext *pCtx, int nToken, YYSTYPE pCase);
+YYSTYPE NscBuildBeginDeclaration (CNscContext *pCtx, YYSTYPE pId);
+YYSTYPE NscBuildEndDeclaration (CNscContext *pCtx, YYSTYPE pId, YYSTYPE pInit);
+YYSTYPE NscBuildMakeConstType (CNscContext *pCtx, YYSTYPE pType);
+YYSTYPE NscBuildBlankStatement (CNscContext *pCtx);
+YYSTYPE NscBuildMarkLine (CNscContext *pCtx, int nIndex, YYSTYPE pStatement);
+void NscBuildSaveLine (CNscContext *pCtx, int nIndex);
+void NscBuildCopyLine (CNscContext *pCtx, int nDest, int nSource);
+bool NscBuildSyntaxError (CNscContext *pCtx, int nToken, YYSTYPE yylval);
 
 
 #line 65 "nscparser.cpp"
@@ -128,10 +125,12 @@ public:
 
   int yydebug;
 
+  CNscContext &context;
+
   virtual int yylex (void) = 0;
   virtual void yyerror (const char *message) = 0;
   int yyparse (void);
-  yyparser (void) {}
+  yyparser (CNscContext &ctx) : context (ctx) {}
   virtual ~yyparser (void)  {}
 };
 
@@ -2598,7 +2597,7 @@ yyerrlab:
 
 #line 513 "nscparser.y"
 { 
-			NscBuildSaveLine (0); 
+			NscBuildSaveLine (&context, 0); 
 		}
 
 #line 2600 "nscparser.cpp"
@@ -2610,7 +2609,7 @@ yyerrlab:
 #line 466 "nscparser.y"
 {
 			yyval = yyattributes_top [0]; 
-			NscBuildSaveLine (0); 
+			NscBuildSaveLine (&context, 0); 
 		}
 
 #line 2612 "nscparser.cpp"
@@ -2627,7 +2626,7 @@ yyerrlab:
 
 #line 474 "nscparser.y"
 {
-			yyval = NscBuildType (VOID_TYPE, NULL); 
+			yyval = NscBuildType (&context, VOID_TYPE, NULL); 
 		}
 
 #line 2629 "nscparser.cpp"
@@ -2642,7 +2641,7 @@ yyerrlab:
 
 #line 478 "nscparser.y"
 {
-			yyval = NscBuildType (INT_TYPE, NULL); 
+			yyval = NscBuildType (&context, INT_TYPE, NULL); 
 		}
 
 #line 2644 "nscparser.cpp"
@@ -2657,7 +2656,7 @@ yyerrlab:
 
 #line 482 "nscparser.y"
 {
-			yyval = NscBuildType (FLOAT_TYPE, NULL); 
+			yyval = NscBuildType (&context, FLOAT_TYPE, NULL); 
 		}
 
 #line 2659 "nscparser.cpp"
@@ -2672,7 +2671,7 @@ yyerrlab:
 
 #line 486 "nscparser.y"
 { 
-			yyval = NscBuildType (OBJECT_TYPE, NULL); 
+			yyval = NscBuildType (&context, OBJECT_TYPE, NULL); 
 		}
 
 #line 2674 "nscparser.cpp"
@@ -2687,7 +2686,7 @@ yyerrlab:
 
 #line 490 "nscparser.y"
 { 
-			yyval = NscBuildType (STRING_TYPE, NULL); 
+			yyval = NscBuildType (&context, STRING_TYPE, NULL); 
 		}
 
 #line 2689 "nscparser.cpp"
@@ -2702,7 +2701,7 @@ yyerrlab:
 
 #line 494 "nscparser.y"
 { 
-			yyval = NscBuildType (ACTION_TYPE, NULL); 
+			yyval = NscBuildType (&context, ACTION_TYPE, NULL); 
 		}
 
 #line 2704 "nscparser.cpp"
@@ -2717,7 +2716,7 @@ yyerrlab:
 
 #line 498 "nscparser.y"
 { 
-			yyval = NscBuildType (VECTOR_TYPE, NULL); 
+			yyval = NscBuildType (&context, VECTOR_TYPE, NULL); 
 		}
 
 #line 2719 "nscparser.cpp"
@@ -2732,7 +2731,7 @@ yyerrlab:
 
 #line 506 "nscparser.y"
 {
-			yyval = NscBuildType (ENGINE_TYPE, yyattributes_top [0]); 
+			yyval = NscBuildType (&context, ENGINE_TYPE, yyattributes_top [0]); 
 		}
 
 #line 2734 "nscparser.cpp"
@@ -2745,7 +2744,7 @@ yyerrlab:
 
 #line 868 "nscparser.y"
 {
-			yyval = NscBuildFunctionDef (yyattributes_top [-1], yyattributes_top [0]);
+			yyval = NscBuildFunctionDef (&context, yyattributes_top [-1], yyattributes_top [0]);
 		}
 
 #line 2747 "nscparser.cpp"
@@ -2759,7 +2758,7 @@ yyerrlab:
 
 #line 875 "nscparser.y"
 {
-			yyval = NscBuildFunctionPrototype (yyattributes_top [0]); 
+			yyval = NscBuildFunctionPrototype (&context, yyattributes_top [0]); 
 		}
 
 #line 2761 "nscparser.cpp"
@@ -2773,7 +2772,7 @@ yyerrlab:
 
 #line 622 "nscparser.y"
 {
-			yyval = NscBuildStatementFence (); 
+			yyval = NscBuildStatementFence (&context); 
 		}
 
 #line 2775 "nscparser.cpp"
@@ -2792,7 +2791,7 @@ yyerrlab:
 
 #line 611 "nscparser.y"
 {
-			yyval = NscBuildStatement (NULL, NULL, yyattributes_top [0]); 
+			yyval = NscBuildStatement (&context, NULL, NULL, yyattributes_top [0]); 
 		}
 
 #line 2794 "nscparser.cpp"
@@ -2819,8 +2818,8 @@ yyerrlab:
 
 #line 530 "nscparser.y"
 { 
-			NscBuildSaveLine (0); 
-			yyval = NscBuildMarkLine (0, NscBuildStatement (NULL, NULL, NULL)); 
+			NscBuildSaveLine (&context, 0); 
+			yyval = NscBuildMarkLine (&context, 0, NscBuildStatement (&context, NULL, NULL, NULL)); 
 		}
 
 #line 2822 "nscparser.cpp"
@@ -2835,7 +2834,7 @@ yyerrlab:
 
 #line 550 "nscparser.y"
 {
-			yyval = NscBuildStatement (NULL, yyattributes_top [0], NULL); 
+			yyval = NscBuildStatement (&context, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 2837 "nscparser.cpp"
@@ -2848,7 +2847,7 @@ yyerrlab:
 
 #line 554 "nscparser.y"
 {
-			yyval = NscBuildStatement (NULL, yyattributes_top [0], NULL); 
+			yyval = NscBuildStatement (&context, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 2850 "nscparser.cpp"
@@ -2861,7 +2860,7 @@ yyerrlab:
 
 #line 558 "nscparser.y"
 {
-			yyval = NscBuildMarkLine (0, NscBuildStatement (NULL, yyattributes_top [0], NULL));
+			yyval = NscBuildMarkLine (&context, 0, NscBuildStatement (&context, NULL, yyattributes_top [0], NULL));
 		}
 
 #line 2863 "nscparser.cpp"
@@ -2874,7 +2873,7 @@ yyerrlab:
 
 #line 562 "nscparser.y"
 {
-			yyval = NscBuildStatement (NULL, yyattributes_top [0], NULL);
+			yyval = NscBuildStatement (&context, NULL, yyattributes_top [0], NULL);
 		}
 
 #line 2876 "nscparser.cpp"
@@ -2887,7 +2886,7 @@ yyerrlab:
 
 #line 566 "nscparser.y"
 {
-			yyval = NscBuildStatement (NULL, yyattributes_top [0], NULL);
+			yyval = NscBuildStatement (&context, NULL, yyattributes_top [0], NULL);
 		}
 
 #line 2889 "nscparser.cpp"
@@ -2900,7 +2899,7 @@ yyerrlab:
 
 #line 570 "nscparser.y"
 {
-			yyval = NscBuildMarkLine (0, NscBuildStatement (NULL, yyattributes_top [0], NULL));
+			yyval = NscBuildMarkLine (&context, 0, NscBuildStatement (&context, NULL, yyattributes_top [0], NULL));
 		}
 
 #line 2902 "nscparser.cpp"
@@ -2913,7 +2912,7 @@ yyerrlab:
 
 #line 574 "nscparser.y"
 {
-			yyval = NscBuildMarkLine (0, NscBuildStatement (NULL, yyattributes_top [0], NULL)); 
+			yyval = NscBuildMarkLine (&context, 0, NscBuildStatement (&context, NULL, yyattributes_top [0], NULL)); 
 		}
 
 #line 2915 "nscparser.cpp"
@@ -2926,7 +2925,7 @@ yyerrlab:
 
 #line 813 "nscparser.y"
 { 
-			NscBuildSaveLine (0); 
+			NscBuildSaveLine (&context, 0); 
 		}
 
 #line 2928 "nscparser.cpp"
@@ -2941,7 +2940,7 @@ yyerrlab:
 
 #line 781 "nscparser.y"
 { 
-			yyval = NscBuild5Block (DO, NULL, 1, NULL, NULL, NULL, NULL, NULL); 
+			yyval = NscBuild5Block (&context, DO, NULL, 1, NULL, NULL, NULL, NULL, NULL); 
 		}
 
 #line 2943 "nscparser.cpp"
@@ -2961,7 +2960,7 @@ yyerrlab:
 #line 650 "nscparser.y"
 {
 			yyval = NULL;
-			if (NscBuildSyntaxError (yychar, yylval))
+			if (NscBuildSyntaxError (&context, yychar, yylval))
 				YYABORT;
 			while (yychar != EOF && yychar != ';' && yychar != '{' && yychar != '}')
 			{
@@ -2998,7 +2997,7 @@ yyerrlab:
 
 #line 598 "nscparser.y"
 {
-			yyval = NscBuildCase (DEFAULT, NULL); 
+			yyval = NscBuildCase (&context, DEFAULT, NULL); 
 		}
 
 #line 3000 "nscparser.cpp"
@@ -3182,7 +3181,7 @@ yyerrlab:
 
 #line 114 "nscparser.y"
 { 
-			yyval = NscBuildIdentifier (yyattributes_top [0]); 
+			yyval = NscBuildIdentifier (&context, yyattributes_top [0]); 
 		}
 
 #line 3184 "nscparser.cpp"
@@ -3234,7 +3233,7 @@ yyerrlab:
 
 #line 130 "nscparser.y"
 { 
-			yyval = NscBuildObjectConstant (0); 
+			yyval = NscBuildObjectConstant (&context, 0); 
 		}
 
 #line 3236 "nscparser.cpp"
@@ -3249,7 +3248,7 @@ yyerrlab:
 
 #line 134 "nscparser.y"
 { 
-			yyval = NscBuildObjectConstant (1); 
+			yyval = NscBuildObjectConstant (&context, 1); 
 		}
 
 #line 3251 "nscparser.cpp"
@@ -3264,7 +3263,7 @@ yyerrlab:
 
 #line 141 "nscparser.y"
 { 
-			yyval = NscBuildVectorConstant (NULL, NULL, NULL);
+			yyval = NscBuildVectorConstant (&context, NULL, NULL, NULL);
 		}
 
 #line 3266 "nscparser.cpp"
@@ -3279,7 +3278,7 @@ yyerrlab:
 
 #line 145 "nscparser.y"
 { 
-			yyval = NscBuildVectorConstant (yyattributes_top [0], NULL, NULL); 
+			yyval = NscBuildVectorConstant (&context, yyattributes_top [0], NULL, NULL); 
 		}
 
 #line 3281 "nscparser.cpp"
@@ -3292,7 +3291,7 @@ yyerrlab:
 
 #line 149 "nscparser.y"
 { 
-			yyval = NscBuildVectorConstant (yyattributes_top [-1], yyattributes_top [0], NULL); 
+			yyval = NscBuildVectorConstant (&context, yyattributes_top [-1], yyattributes_top [0], NULL); 
 		}
 
 #line 3294 "nscparser.cpp"
@@ -3305,7 +3304,7 @@ yyerrlab:
 
 #line 153 "nscparser.y"
 { 
-			yyval = NscBuildVectorConstant (yyattributes_top [-2], yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildVectorConstant (&context, yyattributes_top [-2], yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3307 "nscparser.cpp"
@@ -3318,7 +3317,7 @@ yyerrlab:
 
 #line 441 "nscparser.y"
 {
-			yyval = NscBuildExpression (NULL, yyattributes_top [0]); 
+			yyval = NscBuildExpression (&context, NULL, yyattributes_top [0]); 
 		}
 
 #line 3320 "nscparser.cpp"
@@ -3357,7 +3356,7 @@ yyerrlab:
 
 #line 434 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (OREQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, OREQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3359 "nscparser.cpp"
@@ -3371,7 +3370,7 @@ yyerrlab:
 
 #line 430 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (XOREQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, XOREQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3373 "nscparser.cpp"
@@ -3385,7 +3384,7 @@ yyerrlab:
 
 #line 426 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (ANDEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, ANDEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3387 "nscparser.cpp"
@@ -3399,7 +3398,7 @@ yyerrlab:
 
 #line 422 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (USREQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, USREQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3401 "nscparser.cpp"
@@ -3413,7 +3412,7 @@ yyerrlab:
 
 #line 418 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (SREQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, SREQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3415 "nscparser.cpp"
@@ -3427,7 +3426,7 @@ yyerrlab:
 
 #line 414 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (SLEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, SLEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3429 "nscparser.cpp"
@@ -3441,7 +3440,7 @@ yyerrlab:
 
 #line 410 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (SUBEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, SUBEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3443 "nscparser.cpp"
@@ -3455,7 +3454,7 @@ yyerrlab:
 
 #line 406 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (ADDEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, ADDEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3457 "nscparser.cpp"
@@ -3469,7 +3468,7 @@ yyerrlab:
 
 #line 402 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (MODEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, MODEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3471 "nscparser.cpp"
@@ -3483,7 +3482,7 @@ yyerrlab:
 
 #line 398 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (DIVEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, DIVEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3485 "nscparser.cpp"
@@ -3497,7 +3496,7 @@ yyerrlab:
 
 #line 394 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (MULEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, MULEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3499 "nscparser.cpp"
@@ -3511,7 +3510,7 @@ yyerrlab:
 
 #line 390 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('=', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '=', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3513 "nscparser.cpp"
@@ -3538,7 +3537,7 @@ yyerrlab:
 
 #line 168 "nscparser.y"
 { 
-			yyval = NscBuildCall (yyattributes_top [0], NULL); 
+			yyval = NscBuildCall (&context, yyattributes_top [0], NULL); 
 		}
 
 #line 3540 "nscparser.cpp"
@@ -3552,7 +3551,7 @@ yyerrlab:
 
 #line 164 "nscparser.y"
 { 
-			yyval = NscBuildCall (yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildCall (&context, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3554 "nscparser.cpp"
@@ -3566,7 +3565,7 @@ yyerrlab:
 
 #line 222 "nscparser.y"
 { 
-			yyval = NscBuildUnaryOp ('!', yyattributes_top [0]); 
+			yyval = NscBuildUnaryOp (&context, '!', yyattributes_top [0]); 
 		}
 
 #line 3568 "nscparser.cpp"
@@ -3580,7 +3579,7 @@ yyerrlab:
 
 #line 218 "nscparser.y"
 { 
-			yyval = NscBuildUnaryOp ('~', yyattributes_top [0]); 
+			yyval = NscBuildUnaryOp (&context, '~', yyattributes_top [0]); 
 		}
 
 #line 3582 "nscparser.cpp"
@@ -3594,7 +3593,7 @@ yyerrlab:
 
 #line 214 "nscparser.y"
 { 
-			yyval = NscBuildUnaryOp ('-', yyattributes_top [0]); 
+			yyval = NscBuildUnaryOp (&context, '-', yyattributes_top [0]); 
 		}
 
 #line 3596 "nscparser.cpp"
@@ -3608,7 +3607,7 @@ yyerrlab:
 
 #line 210 "nscparser.y"
 { 
-			yyval = NscBuildUnaryOp ('+', yyattributes_top [0]);
+			yyval = NscBuildUnaryOp (&context, '+', yyattributes_top [0]);
 		}
 
 #line 3610 "nscparser.cpp"
@@ -3622,7 +3621,7 @@ yyerrlab:
 
 #line 206 "nscparser.y"
 { 
-			yyval = NscBuildPlusMinus (yyattributes_top [0], 0, 1); 
+			yyval = NscBuildPlusMinus (&context, yyattributes_top [0], 0, 1); 
 		}
 
 #line 3624 "nscparser.cpp"
@@ -3636,7 +3635,7 @@ yyerrlab:
 
 #line 202 "nscparser.y"
 { 
-			yyval = NscBuildPlusMinus (yyattributes_top [0], 1, 1); 
+			yyval = NscBuildPlusMinus (&context, yyattributes_top [0], 1, 1); 
 		}
 
 #line 3638 "nscparser.cpp"
@@ -3650,7 +3649,7 @@ yyerrlab:
 
 #line 176 "nscparser.y"
 { 
-			yyval = NscBuildPlusMinus (yyattributes_top [0], 1, 0); 
+			yyval = NscBuildPlusMinus (&context, yyattributes_top [0], 1, 0); 
 		}
 
 #line 3652 "nscparser.cpp"
@@ -3663,7 +3662,7 @@ yyerrlab:
 
 #line 180 "nscparser.y"
 { 
-			yyval = NscBuildPlusMinus (yyattributes_top [0], 0, 0);
+			yyval = NscBuildPlusMinus (&context, yyattributes_top [0], 0, 0);
 		}
 
 #line 3665 "nscparser.cpp"
@@ -3676,7 +3675,7 @@ yyerrlab:
 
 #line 172 "nscparser.y"
 { 
-			yyval = NscBuildElementAccess (yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildElementAccess (&context, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3678 "nscparser.cpp"
@@ -3689,7 +3688,7 @@ yyerrlab:
 
 #line 241 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('%', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '%', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3691 "nscparser.cpp"
@@ -3703,7 +3702,7 @@ yyerrlab:
 
 #line 237 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('/', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '/', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3705 "nscparser.cpp"
@@ -3717,7 +3716,7 @@ yyerrlab:
 
 #line 233 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('*', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '*', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3719 "nscparser.cpp"
@@ -3731,7 +3730,7 @@ yyerrlab:
 
 #line 256 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('-', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '-', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3733 "nscparser.cpp"
@@ -3745,7 +3744,7 @@ yyerrlab:
 
 #line 252 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('+', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '+', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3747 "nscparser.cpp"
@@ -3759,7 +3758,7 @@ yyerrlab:
 
 #line 275 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (USR, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, USR, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3761 "nscparser.cpp"
@@ -3773,7 +3772,7 @@ yyerrlab:
 
 #line 271 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (SR, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, SR, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3775 "nscparser.cpp"
@@ -3787,7 +3786,7 @@ yyerrlab:
 
 #line 267 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (SL, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, SL, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3789 "nscparser.cpp"
@@ -3801,7 +3800,7 @@ yyerrlab:
 
 #line 298 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (GTEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, GTEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3803 "nscparser.cpp"
@@ -3815,7 +3814,7 @@ yyerrlab:
 
 #line 294 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (LTEQ, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, LTEQ, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3817 "nscparser.cpp"
@@ -3829,7 +3828,7 @@ yyerrlab:
 
 #line 290 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('>', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '>', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3831 "nscparser.cpp"
@@ -3843,7 +3842,7 @@ yyerrlab:
 
 #line 286 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('<', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '<', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3845 "nscparser.cpp"
@@ -3857,7 +3856,7 @@ yyerrlab:
 
 #line 313 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (NOTEQ, yyattributes_top [-1], yyattributes_top [0]);
+			yyval = NscBuildBinaryOp (&context, NOTEQ, yyattributes_top [-1], yyattributes_top [0]);
 		}
 
 #line 3859 "nscparser.cpp"
@@ -3871,7 +3870,7 @@ yyerrlab:
 
 #line 309 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp (EQ, yyattributes_top [-1], yyattributes_top [0]);
+			yyval = NscBuildBinaryOp (&context, EQ, yyattributes_top [-1], yyattributes_top [0]);
 		}
 
 #line 3873 "nscparser.cpp"
@@ -3885,7 +3884,7 @@ yyerrlab:
 
 #line 324 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('&', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '&', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3887 "nscparser.cpp"
@@ -3899,7 +3898,7 @@ yyerrlab:
 
 #line 335 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('^', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '^', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3901 "nscparser.cpp"
@@ -3913,7 +3912,7 @@ yyerrlab:
 
 #line 346 "nscparser.y"
 { 
-			yyval = NscBuildBinaryOp ('|', yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildBinaryOp (&context, '|', yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3915 "nscparser.cpp"
@@ -3927,7 +3926,7 @@ yyerrlab:
 
 #line 357 "nscparser.y"
 { 
-			yyval = NscBuildLogicalOp (ANDAND, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildLogicalOp (&context, ANDAND, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3929 "nscparser.cpp"
@@ -3941,7 +3940,7 @@ yyerrlab:
 
 #line 379 "nscparser.y"
 { 
-			yyval = NscBuildConditional (yyattributes_top [-2], yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildConditional (&context, yyattributes_top [-2], yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3943 "nscparser.cpp"
@@ -3955,7 +3954,7 @@ yyerrlab:
 
 #line 368 "nscparser.y"
 { 
-			yyval = NscBuildLogicalOp (OROR, yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildLogicalOp (&context, OROR, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 3957 "nscparser.cpp"
@@ -3969,7 +3968,7 @@ yyerrlab:
 
 #line 594 "nscparser.y"
 { 
-			yyval = NscBuildCase (CASE, yyattributes_top [0]); 
+			yyval = NscBuildCase (&context, CASE, yyattributes_top [0]); 
 		}
 
 #line 3971 "nscparser.cpp"
@@ -3983,7 +3982,7 @@ yyerrlab:
 
 #line 646 "nscparser.y"
 {
-			yyval = NscBuildStatement (NULL, yyattributes_top [0], NULL); 
+			yyval = NscBuildStatement (&context, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 3985 "nscparser.cpp"
@@ -3997,7 +3996,7 @@ yyerrlab:
 
 #line 697 "nscparser.y"
 { 
-			yyval = NscBuild5Block (IF, NULL, 1, NULL, yyattributes_top [0], NULL, NULL, NULL); 
+			yyval = NscBuild5Block (&context, IF, NULL, 1, NULL, yyattributes_top [0], NULL, NULL, NULL); 
 		}
 
 #line 3999 "nscparser.cpp"
@@ -4012,7 +4011,7 @@ yyerrlab:
 
 #line 704 "nscparser.y"
 {
-			yyval = NscBuild5Block (SWITCH, NULL, 1, NULL, yyattributes_top [0], NULL, NULL, NULL); 
+			yyval = NscBuild5Block (&context, SWITCH, NULL, 1, NULL, yyattributes_top [0], NULL, NULL, NULL); 
 		}
 
 #line 4014 "nscparser.cpp"
@@ -4027,7 +4026,7 @@ yyerrlab:
 
 #line 682 "nscparser.y"
 {
-			yyval = NscBuild5Block (SWITCH, yyattributes_top [-1], 0, NULL, NULL, NULL, yyattributes_top [0], NULL); 
+			yyval = NscBuild5Block (&context, SWITCH, yyattributes_top [-1], 0, NULL, NULL, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 4029 "nscparser.cpp"
@@ -4041,7 +4040,7 @@ yyerrlab:
 
 #line 678 "nscparser.y"
 {
-			yyval = NscBuild5Block (IF, yyattributes_top [-1], 0, NULL, NULL, NULL, NULL, yyattributes_top [0]);
+			yyval = NscBuild5Block (&context, IF, yyattributes_top [-1], 0, NULL, NULL, NULL, NULL, yyattributes_top [0]);
 		}
 
 #line 4043 "nscparser.cpp"
@@ -4068,8 +4067,8 @@ yyerrlab:
 
 #line 542 "nscparser.y"
 {
-			NscBuildSaveLine (0); 
-			yyval = NscBuildMarkLine (0, NscBuildBlankStatement ()); 
+			NscBuildSaveLine (&context, 0); 
+			yyval = NscBuildMarkLine (&context, 0, NscBuildBlankStatement (&context)); 
 		}
 
 #line 4071 "nscparser.cpp"
@@ -4084,7 +4083,7 @@ yyerrlab:
 
 #line 674 "nscparser.y"
 { 
-			yyval = NscBuild5Block (IF, yyattributes_top [-1], 0, NULL, NULL, NULL, yyattributes_top [0], NULL); 
+			yyval = NscBuild5Block (&context, IF, yyattributes_top [-1], 0, NULL, NULL, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 4086 "nscparser.cpp"
@@ -4098,8 +4097,8 @@ yyerrlab:
 
 #line 689 "nscparser.y"
 {
-			NscBuildSaveLine (0); 
-			yyval = NscBuild5Block (IF, yyattributes_top [-1], 1, NULL, NULL, NULL, yyattributes_top [0], NULL); 
+			NscBuildSaveLine (&context, 0); 
+			yyval = NscBuild5Block (&context, IF, yyattributes_top [-1], 1, NULL, NULL, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 4101 "nscparser.cpp"
@@ -4114,7 +4113,7 @@ yyerrlab:
 
 #line 774 "nscparser.y"
 { 
-			yyval = NscBuild5Block (WHILE, NULL, 1, NULL, yyattributes_top [0], NULL, NULL, NULL); 
+			yyval = NscBuild5Block (&context, WHILE, NULL, 1, NULL, yyattributes_top [0], NULL, NULL, NULL); 
 		}
 
 #line 4116 "nscparser.cpp"
@@ -4129,7 +4128,7 @@ yyerrlab:
 
 #line 767 "nscparser.y"
 {
-			NscBuildSaveLine (0); 
+			NscBuildSaveLine (&context, 0); 
 		}
 
 #line 4131 "nscparser.cpp"
@@ -4144,7 +4143,7 @@ yyerrlab:
 
 #line 744 "nscparser.y"
 {
-			yyval = NscBuild5Block (FOR, NULL, 1, yyattributes_top [-1], yyattributes_top [0], NULL, NULL, NULL); 
+			yyval = NscBuild5Block (&context, FOR, NULL, 1, yyattributes_top [-1], yyattributes_top [0], NULL, NULL, NULL); 
 		}
 
 #line 4146 "nscparser.cpp"
@@ -4159,7 +4158,7 @@ yyerrlab:
 
 #line 760 "nscparser.y"
 {
-			yyval = NscBuild5Block (FOR, NULL, 1, yyattributes_top [-2], yyattributes_top [-1], yyattributes_top [0], NULL, NULL); 
+			yyval = NscBuild5Block (&context, FOR, NULL, 1, yyattributes_top [-2], yyattributes_top [-1], yyattributes_top [0], NULL, NULL); 
 		}
 
 #line 4161 "nscparser.cpp"
@@ -4174,7 +4173,7 @@ yyerrlab:
 
 #line 736 "nscparser.y"
 { 
-			yyval = NscBuild5Block (FOR, NULL, 1, yyattributes_top [0], NULL, NULL, NULL, NULL); 
+			yyval = NscBuild5Block (&context, FOR, NULL, 1, yyattributes_top [0], NULL, NULL, NULL, NULL); 
 		}
 
 #line 4176 "nscparser.cpp"
@@ -4189,7 +4188,7 @@ yyerrlab:
 
 #line 752 "nscparser.y"
 {
-			yyval = NscBuild5Block (FOR, NULL, 1, yyattributes_top [-1], NULL, yyattributes_top [0], NULL, NULL); 
+			yyval = NscBuild5Block (&context, FOR, NULL, 1, yyattributes_top [-1], NULL, yyattributes_top [0], NULL, NULL); 
 		}
 
 #line 4191 "nscparser.cpp"
@@ -4204,7 +4203,7 @@ yyerrlab:
 
 #line 740 "nscparser.y"
 { 
-			yyval = NscBuild5Block (FOR, NULL, 1, NULL, yyattributes_top [0], NULL, NULL, NULL);
+			yyval = NscBuild5Block (&context, FOR, NULL, 1, NULL, yyattributes_top [0], NULL, NULL, NULL);
 		}
 
 #line 4206 "nscparser.cpp"
@@ -4219,7 +4218,7 @@ yyerrlab:
 
 #line 756 "nscparser.y"
 {
-			yyval = NscBuild5Block (FOR, NULL, 1, NULL, yyattributes_top [-1], yyattributes_top [0], NULL, NULL); 
+			yyval = NscBuild5Block (&context, FOR, NULL, 1, NULL, yyattributes_top [-1], yyattributes_top [0], NULL, NULL); 
 		}
 
 #line 4221 "nscparser.cpp"
@@ -4234,7 +4233,7 @@ yyerrlab:
 
 #line 732 "nscparser.y"
 {
-			yyval = NscBuild5Block (FOR, NULL, 1, NULL, NULL, NULL, NULL, NULL); 
+			yyval = NscBuild5Block (&context, FOR, NULL, 1, NULL, NULL, NULL, NULL, NULL); 
 		}
 
 #line 4236 "nscparser.cpp"
@@ -4251,7 +4250,7 @@ yyerrlab:
 
 #line 748 "nscparser.y"
 {
-			yyval = NscBuild5Block (FOR, NULL, 1, NULL, NULL, yyattributes_top [0], NULL, NULL); 
+			yyval = NscBuild5Block (&context, FOR, NULL, 1, NULL, NULL, yyattributes_top [0], NULL, NULL); 
 		}
 
 #line 4253 "nscparser.cpp"
@@ -4266,7 +4265,7 @@ yyerrlab:
 
 #line 725 "nscparser.y"
 {
-			yyval = NscBuild5Block (FOR, yyattributes_top [-1], 0, NULL, NULL, NULL, yyattributes_top [0], NULL); 
+			yyval = NscBuild5Block (&context, FOR, yyattributes_top [-1], 0, NULL, NULL, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 4268 "nscparser.cpp"
@@ -4280,7 +4279,7 @@ yyerrlab:
 
 #line 721 "nscparser.y"
 {
-			yyval = NscBuild5Block (DO, yyattributes_top [-2], 0, NULL, yyattributes_top [0], NULL, yyattributes_top [-1], NULL); 
+			yyval = NscBuild5Block (&context, DO, yyattributes_top [-2], 0, NULL, yyattributes_top [0], NULL, yyattributes_top [-1], NULL); 
 		}
 
 #line 4282 "nscparser.cpp"
@@ -4294,7 +4293,7 @@ yyerrlab:
 
 #line 717 "nscparser.y"
 {
-			yyval = NscBuild5Block (WHILE, yyattributes_top [-1], 0, NULL, NULL, NULL, yyattributes_top [0], NULL); 
+			yyval = NscBuild5Block (&context, WHILE, yyattributes_top [-1], 0, NULL, NULL, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 4296 "nscparser.cpp"
@@ -4308,7 +4307,7 @@ yyerrlab:
 
 #line 802 "nscparser.y"
 {
-			yyval = NscBuildReturn (NULL); 
+			yyval = NscBuildReturn (&context, NULL); 
 		}
 
 #line 4310 "nscparser.cpp"
@@ -4324,7 +4323,7 @@ yyerrlab:
 
 #line 806 "nscparser.y"
 {
-			yyval = NscBuildReturn (yyattributes_top [0]); 
+			yyval = NscBuildReturn (&context, yyattributes_top [0]); 
 		}
 
 #line 4326 "nscparser.cpp"
@@ -4338,7 +4337,7 @@ yyerrlab:
 
 #line 798 "nscparser.y"
 {
-			yyval = NscBuildBreakContinue (BREAK); 
+			yyval = NscBuildBreakContinue (&context, BREAK); 
 		}
 
 #line 4340 "nscparser.cpp"
@@ -4353,7 +4352,7 @@ yyerrlab:
 
 #line 794 "nscparser.y"
 {
-			yyval = NscBuildBreakContinue (CONTINUE);
+			yyval = NscBuildBreakContinue (&context, CONTINUE);
 		}
 
 #line 4355 "nscparser.cpp"
@@ -4368,7 +4367,7 @@ yyerrlab:
 
 #line 502 "nscparser.y"
 { 
-			yyval = NscBuildType (STRUCT_TYPE, yyattributes_top [0]); 
+			yyval = NscBuildType (&context, STRUCT_TYPE, yyattributes_top [0]); 
 		}
 
 #line 4370 "nscparser.cpp"
@@ -4381,7 +4380,7 @@ yyerrlab:
 
 #line 833 "nscparser.y"
 {
-			yyval = NscBuildDeclarationList (NULL, yyattributes_top [0]); 
+			yyval = NscBuildDeclarationList (&context, NULL, yyattributes_top [0]); 
 		}
 
 #line 4383 "nscparser.cpp"
@@ -4394,7 +4393,7 @@ yyerrlab:
 
 #line 844 "nscparser.y"
 {
-			yyval = NscBuildEndDeclaration (yyattributes_top [0], NULL);
+			yyval = NscBuildEndDeclaration (&context, yyattributes_top [0], NULL);
 		}
 
 #line 4396 "nscparser.cpp"
@@ -4407,7 +4406,7 @@ yyerrlab:
 
 #line 855 "nscparser.y"
 {
-			yyval = NscBuildBeginDeclaration (yyattributes_top [0]);
+			yyval = NscBuildBeginDeclaration (&context, yyattributes_top [0]);
 		}
 
 #line 4409 "nscparser.cpp"
@@ -4420,7 +4419,7 @@ yyerrlab:
 
 #line 848 "nscparser.y"
 {
-			yyval = NscBuildEndDeclaration (yyattributes_top [-1], yyattributes_top [0]);
+			yyval = NscBuildEndDeclaration (&context, yyattributes_top [-1], yyattributes_top [0]);
 		}
 
 #line 4422 "nscparser.cpp"
@@ -4434,7 +4433,7 @@ yyerrlab:
 
 #line 826 "nscparser.y"
 {
-			yyval = NscBuildDeclaration (yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildDeclaration (&context, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 4436 "nscparser.cpp"
@@ -4448,7 +4447,7 @@ yyerrlab:
 
 #line 837 "nscparser.y"
 {
-			yyval = NscBuildDeclarationList (yyattributes_top [-2], yyattributes_top [0]); 
+			yyval = NscBuildDeclarationList (&context, yyattributes_top [-2], yyattributes_top [0]); 
 		}
 
 #line 4450 "nscparser.cpp"
@@ -4462,7 +4461,7 @@ yyerrlab:
 
 #line 615 "nscparser.y"
 {
-			yyval = NscBuildStatement (NULL, yyattributes_top [0], yyattributes_top [-1]); 
+			yyval = NscBuildStatement (&context, NULL, yyattributes_top [0], yyattributes_top [-1]); 
 		}
 
 #line 4464 "nscparser.cpp"
@@ -4476,8 +4475,8 @@ yyerrlab:
 
 #line 461 "nscparser.y"
 { 
-			yyval = NscBuildMakeConstType (yyattributes_top [0]); 
-			NscBuildCopyLine (0, 1); 
+			yyval = NscBuildMakeConstType (&context, yyattributes_top [0]); 
+			NscBuildCopyLine (&context, 0, 1); 
 		}
 
 #line 4479 "nscparser.cpp"
@@ -4492,7 +4491,7 @@ yyerrlab:
 
 #line 886 "nscparser.y"
 {
-			yyval = NscBuildFunctionDeclarator (yyattributes_top [-2], yyattributes_top [-1], NULL); 
+			yyval = NscBuildFunctionDeclarator (&context, yyattributes_top [-2], yyattributes_top [-1], NULL); 
 		}
 
 #line 4494 "nscparser.cpp"
@@ -4507,7 +4506,7 @@ yyerrlab:
 
 #line 909 "nscparser.y"
 {
-			yyval = NscBuildParameter (yyattributes_top [-1], yyattributes_top [0], NULL);
+			yyval = NscBuildParameter (&context, yyattributes_top [-1], yyattributes_top [0], NULL);
 		}
 
 #line 4509 "nscparser.cpp"
@@ -4521,7 +4520,7 @@ yyerrlab:
 
 #line 913 "nscparser.y"
 {
-			yyval = NscBuildParameter (yyattributes_top [-2], yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildParameter (&context, yyattributes_top [-2], yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 4523 "nscparser.cpp"
@@ -4535,7 +4534,7 @@ yyerrlab:
 
 #line 882 "nscparser.y"
 {
-			yyval = NscBuildFunctionDeclarator (yyattributes_top [-3], yyattributes_top [-2], yyattributes_top [0]);
+			yyval = NscBuildFunctionDeclarator (&context, yyattributes_top [-3], yyattributes_top [-2], yyattributes_top [0]);
 		}
 
 #line 4537 "nscparser.cpp"
@@ -4550,7 +4549,7 @@ yyerrlab:
 
 #line 502 "nscparser.y"
 { 
-			yyval = NscBuildType (STRUCT_TYPE, yyattributes_top [0]); 
+			yyval = NscBuildType (&context, STRUCT_TYPE, yyattributes_top [0]); 
 		}
 
 #line 4552 "nscparser.cpp"
@@ -4563,7 +4562,7 @@ yyerrlab:
 
 #line 944 "nscparser.y"
 {
-			yyval = NscBuildStructDeclaration (yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildStructDeclaration (&context, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 4565 "nscparser.cpp"
@@ -4577,7 +4576,7 @@ yyerrlab:
 
 #line 926 "nscparser.y"
 {
-			yyval = NscBuildStruct (yyattributes_top [-2], yyattributes_top [0]);
+			yyval = NscBuildStruct (&context, yyattributes_top [-2], yyattributes_top [0]);
 		}
 
 #line 4579 "nscparser.cpp"
@@ -4613,7 +4612,7 @@ yyerrlab:
 
 #line 969 "nscparser.y"
 {
-			yyval = NscBuildTranslation (NULL, yyattributes_top [0]);
+			yyval = NscBuildTranslation (&context, NULL, yyattributes_top [0]);
 		}
 
 #line 4615 "nscparser.cpp"
@@ -4631,7 +4630,7 @@ yyerrlab:
 #line 977 "nscparser.y"
 {
 			yyval = NULL;
-			if (NscBuildSyntaxError (yychar, yylval))
+			if (NscBuildSyntaxError (&context, yychar, yylval))
 				YYABORT;
 			while (yychar != EOF && yychar != ';' && yychar != '{' && yychar != '}')
 			{
@@ -4661,7 +4660,7 @@ yyerrlab:
             YYABORT;
 
 #line 645 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4662 "nscparser.cpp"
           yystate = 52;
@@ -4678,7 +4677,7 @@ yyerrlab:
             YYABORT;
 
 #line 645 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4679 "nscparser.cpp"
           yystate = 52;
@@ -4695,7 +4694,7 @@ yyerrlab:
 
 #line 629 "nscparser.y"
 {
-			yyval = NscBuildStatement (NULL, yyattributes_top [0], NULL); 
+			yyval = NscBuildStatement (&context, NULL, yyattributes_top [0], NULL); 
 		}
 
 #line 4697 "nscparser.cpp"
@@ -4714,7 +4713,7 @@ yyerrlab:
             YYABORT;
 
 #line 645 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4715 "nscparser.cpp"
           yystate = 52;
@@ -4730,7 +4729,7 @@ yyerrlab:
             YYABORT;
 
 #line 645 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4731 "nscparser.cpp"
           yystate = 52;
@@ -4746,7 +4745,7 @@ yyerrlab:
             YYABORT;
 
 #line 645 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4747 "nscparser.cpp"
           yystate = 52;
@@ -4765,7 +4764,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 773 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4766 "nscparser.cpp"
           yystate = 200;
@@ -4782,7 +4781,7 @@ yyerrlab:
             YYABORT;
 
 #line 645 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4783 "nscparser.cpp"
           yystate = 52;
@@ -4798,7 +4797,7 @@ yyerrlab:
             YYABORT;
 
 #line 645 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4799 "nscparser.cpp"
           yystate = 52;
@@ -4838,7 +4837,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 793 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4839 "nscparser.cpp"
           yystate = 238;
@@ -4877,7 +4876,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 797 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4878 "nscparser.cpp"
           yystate = 236;
@@ -4916,7 +4915,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 703 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4917 "nscparser.cpp"
           yystate = 190;
@@ -4931,7 +4930,7 @@ yyerrlab:
             YYABORT;
 
 #line 645 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4932 "nscparser.cpp"
           yystate = 52;
@@ -4974,7 +4973,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 593 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 4975 "nscparser.cpp"
           yystate = 57;
@@ -5014,7 +5013,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 597 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 5015 "nscparser.cpp"
           yystate = 55;
@@ -5032,7 +5031,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 696 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 5033 "nscparser.cpp"
           yystate = 187;
@@ -5062,7 +5061,7 @@ yyerrlab:
 
 #line 187 "nscparser.y"
 { 
-			yyval = NscBuildArgExpList (NULL, yyattributes_top [0]); 
+			yyval = NscBuildArgExpList (&context, NULL, yyattributes_top [0]); 
 		}
 
 #line 5064 "nscparser.cpp"
@@ -5078,7 +5077,7 @@ yyerrlab:
 
 #line 191 "nscparser.y"
 { 
-			yyval = NscBuildArgExpList (yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildArgExpList (&context, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 5080 "nscparser.cpp"
@@ -5097,7 +5096,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 720 "nscparser.y"
-{ NscBuildSaveLine (0); }
+{ NscBuildSaveLine (&context, 0); }
 
 #line 5098 "nscparser.cpp"
           yystate = 227;
@@ -5110,7 +5109,7 @@ yyerrlab:
 
 #line 633 "nscparser.y"
 { 
-			yyval = NscBuildStatement (yyattributes_top [-1], yyattributes_top [0], NULL); 
+			yyval = NscBuildStatement (&context, yyattributes_top [-1], yyattributes_top [0], NULL); 
 		}
 
 #line 5112 "nscparser.cpp"
@@ -5130,7 +5129,7 @@ yyerrlab:
 
 #line 855 "nscparser.y"
 {
-			yyval = NscBuildBeginDeclaration (yyattributes_top [0]);
+			yyval = NscBuildBeginDeclaration (&context, yyattributes_top [0]);
 		}
 
 #line 5132 "nscparser.cpp"
@@ -5157,7 +5156,7 @@ yyerrlab:
 
 #line 898 "nscparser.y"
 {
-			yyval = NscBuildParameterList (NULL, yyattributes_top [0]);
+			yyval = NscBuildParameterList (&context, NULL, yyattributes_top [0]);
 		}
 
 #line 5159 "nscparser.cpp"
@@ -5184,7 +5183,7 @@ yyerrlab:
 
 #line 902 "nscparser.y"
 {
-			yyval = NscBuildParameterList (yyattributes_top [-2], yyattributes_top [0]);
+			yyval = NscBuildParameterList (&context, yyattributes_top [-2], yyattributes_top [0]);
 		}
 
 #line 5186 "nscparser.cpp"
@@ -5255,7 +5254,7 @@ yyerrlab:
           yyerr_status--;
 
 #line 460 "nscparser.y"
-{ NscBuildSaveLine (1); }
+{ NscBuildSaveLine (&context, 1); }
 
 #line 5256 "nscparser.cpp"
           yystate = 252;
@@ -5273,7 +5272,7 @@ yyerrlab:
 
 #line 933 "nscparser.y"
 {
-			yyval = NscBuildStructDeclarationList (NULL, yyattributes_top [0]);
+			yyval = NscBuildStructDeclarationList (&context, NULL, yyattributes_top [0]);
 		}
 
 #line 5275 "nscparser.cpp"
@@ -5297,7 +5296,7 @@ yyerrlab:
 
 #line 951 "nscparser.y"
 {
-			yyval = NscBuildStructDeclaratorList (NULL, yyattributes_top [0]); 
+			yyval = NscBuildStructDeclaratorList (&context, NULL, yyattributes_top [0]); 
 		}
 
 #line 5299 "nscparser.cpp"
@@ -5320,7 +5319,7 @@ yyerrlab:
 
 #line 955 "nscparser.y"
 {
-			yyval = NscBuildStructDeclaratorList (yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildStructDeclaratorList (&context, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 5322 "nscparser.cpp"
@@ -5336,7 +5335,7 @@ yyerrlab:
 
 #line 937 "nscparser.y"
 {
-			yyval = NscBuildStructDeclarationList (yyattributes_top [-1], yyattributes_top [0]); 
+			yyval = NscBuildStructDeclarationList (&context, yyattributes_top [-1], yyattributes_top [0]); 
 		}
 
 #line 5338 "nscparser.cpp"
@@ -5354,7 +5353,7 @@ yyerrlab:
 
 #line 973 "nscparser.y"
 {
-			yyval = NscBuildTranslation (yyattributes_top [-1], yyattributes_top [0]);
+			yyval = NscBuildTranslation (&context, yyattributes_top [-1], yyattributes_top [0]);
 		}
 
 #line 5356 "nscparser.cpp"
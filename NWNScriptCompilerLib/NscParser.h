@@ -63,10 +63,12 @@ public:
 
   int yydebug;
 
+  CNscContext &context;
+
   virtual int yylex (void) = 0;
   virtual void yyerror (const char *message) = 0;
   int yyparse (void);
-  yyparser (void) {}
+  yyparser (CNscContext &ctx) : context (ctx) {}
   virtual ~yyparser (void)  {}
 };
 
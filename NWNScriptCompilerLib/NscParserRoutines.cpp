@@ -44,23 +44,6 @@
 #include "NscPStackEntry.h"
 #include "NscSymbolTable.h"
 
-//
-// Externals
-//
-
-extern CNscContext *g_pCtx;
-
-//
-// Prototypes
-//
-
-//
-// Global type save... this stinks, I need to fix it
-//
-
-CNscPStackEntry *g_pNscDeclType;
-size_t g_nNscLastDeclSymbol = 0xFFFFFFFF;
-
 //-----------------------------------------------------------------------------
 //
 // Class definition
@@ -79,15 +62,15 @@ public:
 		m_fHasBlock = false;
 	}
 
-	CNsc5BlockHelper (CNscPStackEntry *pNew, 
+	CNsc5BlockHelper (CNscContext *pCtx, CNscPStackEntry *pNew, 
 		NscPCode5Block *pPrev, int nPrevIndex)
 	{
 		if (pNew)
 		{
 			m_pauchData = pNew ->GetData ();
 			m_ulSize = pNew ->GetDataSize ();
-			m_nFile = g_pCtx ->GetFile (0);
-			m_nLine = g_pCtx ->GetLine (0);
+			m_nFile = pCtx ->GetFile (0);
+			m_nLine = pCtx ->GetLine (0);
 		}
 		else if (pPrev)
 		{
@@ -140,6 +123,8 @@ void NscParserReferenceSymbol (NscSymbol *pSymbol)
 //
 // @func Push an appropriate default value for a simple type
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm CNscPStackEntry * | pOut | Output
 //
 // @parm NscSymType | nType | Type of variable to generate default value for
@@ -148,7 +133,7 @@ void NscParserReferenceSymbol (NscSymbol *pSymbol)
 //
 //-----------------------------------------------------------------------------
 
-bool NscPushDefaultValue (CNscPStackEntry *pOut, NscType nType)
+bool NscPushDefaultValue (CNscContext *pCtx, CNscPStackEntry *pOut, NscType nType)
 {
 	switch (nType)
 	{
@@ -184,7 +169,7 @@ bool NscPushDefaultValue (CNscPStackEntry *pOut, NscType nType)
 			// If this is a structure type
 			//
 
-			if (g_pCtx ->IsStructure (nType))
+			if (pCtx ->IsStructure (nType))
 			{
 				pOut ->PushConstantStructure (nType);
 				pOut ->SetType (nType);
@@ -272,6 +257,8 @@ void NscSimplifyConstant (unsigned char *pauchData, size_t &nDataSize)
 //
 // @func Push an assignment
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm CNscPStackEntry * | pOut | Output
 //
 // @parm NscPCode | nCode | Opcode
@@ -286,7 +273,7 @@ void NscSimplifyConstant (unsigned char *pauchData, size_t &nDataSize)
 //
 //-----------------------------------------------------------------------------
 
-void NscPushAssignment (CNscPStackEntry *pOut, NscPCode nCode,
+void NscPushAssignment (CNscContext *pCtx, CNscPStackEntry *pOut, NscPCode nCode,
 	NscType nType, CNscPStackEntry *pLhs, CNscPStackEntry *pRhs)
 {
 
@@ -296,7 +283,7 @@ void NscPushAssignment (CNscPStackEntry *pOut, NscPCode nCode,
 
 	if (!pLhs ->IsSimpleVariable ())
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorAssignLHSNotVariable);
+		pCtx ->GenerateMessage (NscMessage_ErrorAssignLHSNotVariable);
 		pOut ->SetType (NscType_Error);
 		return;
 	}
@@ -306,8 +293,8 @@ void NscPushAssignment (CNscPStackEntry *pOut, NscPCode nCode,
 	// nested assignments
 	//
 
-	if (g_pCtx ->GetWarnOnAssignRHSIsAssignment () && pRhs ->IsAssignment ())
-		g_pCtx ->GenerateMessage (NscMessage_WarningNestedRHSAssign);
+	if (pCtx ->GetWarnOnAssignRHSIsAssignment () && pRhs ->IsAssignment ())
+		pCtx ->GenerateMessage (NscMessage_WarningNestedRHSAssign);
 
 	//
 	// Create the pcode
@@ -325,6 +312,8 @@ void NscPushAssignment (CNscPStackEntry *pOut, NscPCode nCode,
 //
 // @func Push an element access
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm CNscPStackEntry * | pOut | Output
 //
 // @parm CNscPStackEntry * | pStruct | Structure being accessed
@@ -338,7 +327,7 @@ void NscPushAssignment (CNscPStackEntry *pOut, NscPCode nCode,
 //
 //-----------------------------------------------------------------------------
 
-void NscPushElementAccess (CNscPStackEntry *pOut, 
+void NscPushElementAccess (CNscContext *pCtx, CNscPStackEntry *pOut, 
 	CNscPStackEntry *pStruct, NscType nType, int nElement)
 {
 
@@ -352,7 +341,7 @@ void NscPushElementAccess (CNscPStackEntry *pOut,
 		pOut ->PushVariable (nType, pv ->nType, pv ->nSymbol, nElement, 
 			pv ->nStackOffset, pv ->ulFlags);
 
-		NscSymbol *pSymbol = g_pCtx ->GetSymbol (pv ->nSymbol);
+		NscSymbol *pSymbol = pCtx ->GetSymbol (pv ->nSymbol);
 		assert (pSymbol);
 
 		NscParserReferenceSymbol (pSymbol);
@@ -381,7 +370,7 @@ void NscPushElementAccess (CNscPStackEntry *pOut,
 
 	if (nType >= NscType_Struct_0)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_WarningNestedStructAccess);
+		pCtx ->GenerateMessage (NscMessage_WarningNestedStructAccess);
 	}
 }
 
@@ -389,6 +378,8 @@ void NscPushElementAccess (CNscPStackEntry *pOut,
 //
 // @func Push the current fence
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm CNscPStackEntry * | pOut | Output
 //
 // @parm NscSymbol * | pSymbol | Function symbol
@@ -401,28 +392,30 @@ void NscPushElementAccess (CNscPStackEntry *pOut,
 //
 //-----------------------------------------------------------------------------
 
-void NscPushFence (CNscPStackEntry *pOut, NscSymbol *pSymbol, 
+void NscPushFence (CNscContext *pCtx, CNscPStackEntry *pOut, NscSymbol *pSymbol, 
 	NscFenceType nFenceType, bool fEatScope)
 {
 	size_t nFnSymbol;
 	if (pSymbol)
-		nFnSymbol = g_pCtx ->GetSymbolOffset (pSymbol);
+		nFnSymbol = pCtx ->GetSymbolOffset (pSymbol);
 	else
 		nFnSymbol = 0;
-	g_pCtx ->GetFence (pOut, nFnSymbol, nFenceType, fEatScope);
+	pCtx ->GetFence (pOut, nFnSymbol, nFenceType, fEatScope);
 }
 
 //-----------------------------------------------------------------------------
 //
 // @func Set the fence return
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm bool | fReturns | Has a return
 //
 // @rdesc None.
 //
 //-----------------------------------------------------------------------------
 
-void NscSetFenceReturn (bool fReturns)
+void NscSetFenceReturn (CNscContext *pCtx, bool fReturns)
 {
 
 	//
@@ -430,7 +423,7 @@ void NscSetFenceReturn (bool fReturns)
 	// is a control type or the main function.
 	//
 
-	NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+	NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 	while (pFence && pFence ->nFenceType == NscFenceType_Scope)
 		pFence = pFence ->pNext;
 
@@ -456,6 +449,8 @@ void NscSetFenceReturn (bool fReturns)
 //
 // @func Generate a syntax error message
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nToken | Token that generated the error
 //
 // @parm YYSTYPE | yylval | Current l value
@@ -464,7 +459,7 @@ void NscSetFenceReturn (bool fReturns)
 //
 //-----------------------------------------------------------------------------
 
-bool NscBuildSyntaxError (int nToken, YYSTYPE yylval)
+bool NscBuildSyntaxError (CNscContext *pCtx, int nToken, YYSTYPE yylval)
 {
 
 	//
@@ -473,7 +468,7 @@ bool NscBuildSyntaxError (int nToken, YYSTYPE yylval)
 
 	if (nToken == 0)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorUnexpectedEOF);
+		pCtx ->GenerateMessage (NscMessage_ErrorUnexpectedEOF);
 	}
 
 	//
@@ -631,7 +626,7 @@ bool NscBuildSyntaxError (int nToken, YYSTYPE yylval)
 				if (yylval)
 				{
 					int nIndex = yylval ->GetType () - NscType_Engine_0;
-					pszToken = g_pCtx -> GetCompiler () -> NscGetCompilerState () ->m_astrNscEngineTypes [nIndex] .c_str ();
+					pszToken = pCtx -> GetCompiler () -> NscGetCompilerState () ->m_pNWScript ->m_astrNscEngineTypes [nIndex] .c_str ();
 				}
 				else
 					pszToken = "engine-type";
@@ -715,16 +710,16 @@ bool NscBuildSyntaxError (int nToken, YYSTYPE yylval)
 		// Generate the error
 		//
 
-		g_pCtx ->GenerateMessage (NscMessage_ErrorTokenSyntaxError, pszToken);
+		pCtx ->GenerateMessage (NscMessage_ErrorTokenSyntaxError, pszToken);
 	}
 
 	//
 	// Check for too many errors
 	//
 
-	if (g_pCtx ->GetErrors () >= 100)
+	if (pCtx ->GetErrors () >= 100)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorTooManyErrors, 100);
+		pCtx ->GenerateMessage (NscMessage_ErrorTooManyErrors, 100);
 		return true;
 	}
 	else
@@ -735,6 +730,8 @@ bool NscBuildSyntaxError (int nToken, YYSTYPE yylval)
 //
 // @func Build a type 
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nType | Type id
 //
 // @parm YYSTYPE | pId | Id of the structure
@@ -743,9 +740,9 @@ bool NscBuildSyntaxError (int nToken, YYSTYPE yylval)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildType (int nType, YYSTYPE pId)
+YYSTYPE NscBuildType (CNscContext *pCtx, int nType, YYSTYPE pId)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// Switch based on the type
@@ -778,10 +775,10 @@ YYSTYPE NscBuildType (int nType, YYSTYPE pId)
 			break;
 
 		case ACTION_TYPE:
-			if (!g_pCtx ->IsNWScript ())
+			if (!pCtx ->IsNWScript ())
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorInternalOnlyIdentifier,
-					g_pCtx ->GetTypeName (NscType_Action));
+				pCtx ->GenerateMessage (NscMessage_ErrorInternalOnlyIdentifier,
+					pCtx ->GetTypeName (NscType_Action));
 				pOut ->SetType (NscType_Error);
 			}
 			else
@@ -798,24 +795,24 @@ YYSTYPE NscBuildType (int nType, YYSTYPE pId)
 				// being added as structure declaration types.
 				//
 
-				NscSymbol *pSymbol = g_pCtx ->FindStructTagSymbol (pId ->GetIdentifier ());
+				NscSymbol *pSymbol = pCtx ->FindStructTagSymbol (pId ->GetIdentifier ());
 				if (pSymbol == NULL)
 				{
-					if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+					if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 					{
 						pOut ->SetIdentifier (pId ->GetIdentifier ());
 						pOut ->SetType (NscType_Unknown);
 					}
 					else
 					{
-						g_pCtx ->GenerateMessage (NscMessage_ErrorStructureUndefined,
+						pCtx ->GenerateMessage (NscMessage_ErrorStructureUndefined,
 							pId ->GetIdentifier ());
 						pOut ->SetType (NscType_Error);
 					}
 				}
 				else if (pSymbol ->nSymType != NscSymType_Structure)
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorIdentifierNotStructure,
 						pId ->GetIdentifier ());
 					pOut ->SetType (NscType_Error);
@@ -845,13 +842,13 @@ YYSTYPE NscBuildType (int nType, YYSTYPE pId)
 	//
 
 	if (pId)
-         g_pCtx ->FreePStackEntry (pId);
+         pCtx ->FreePStackEntry (pId);
 
 	//
 	// Return results
 	//
 
-	g_pNscDeclType = pOut;
+	pCtx ->SetDeclType (pOut);
 	return pOut;
 }
 
@@ -859,13 +856,15 @@ YYSTYPE NscBuildType (int nType, YYSTYPE pId)
 //
 // @func Change a type to a constant
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pType | Type
 //
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildMakeConstType (YYSTYPE pType)
+YYSTYPE NscBuildMakeConstType (CNscContext *pCtx, YYSTYPE pType)
 {
 	pType ->SetFlags (NscSymFlag_Constant);
 	return pType;
@@ -875,15 +874,17 @@ YYSTYPE NscBuildMakeConstType (YYSTYPE pType)
 //
 // @func Build an object constant
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nOID | Object ID
 //
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildObjectConstant (int nOID)
+YYSTYPE NscBuildObjectConstant (CNscContext *pCtx, int nOID)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 	pOut ->SetType (NscType_Object);
 	pOut ->PushConstantObject ((UINT32) nOID);
 	return pOut;
@@ -893,15 +894,17 @@ YYSTYPE NscBuildObjectConstant (int nOID)
 //
 // @func Build an integer constant
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nValue | Integer value
 //
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildIntegerConstant (int nValue)
+YYSTYPE NscBuildIntegerConstant (CNscContext *pCtx, int nValue)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 	pOut ->SetType (NscType_Integer);
 	pOut ->PushConstantInteger (nValue);
 	return pOut;
@@ -911,6 +914,8 @@ YYSTYPE NscBuildIntegerConstant (int nValue)
 //
 // @func Build a vector for floating point values
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | px | X component pstack pointer
 //
 // @parm YYSTYPE | py | Y component pstack pointer
@@ -921,9 +926,9 @@ YYSTYPE NscBuildIntegerConstant (int nValue)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildVectorConstant (YYSTYPE px, YYSTYPE py, YYSTYPE pz)
+YYSTYPE NscBuildVectorConstant (CNscContext *pCtx, YYSTYPE px, YYSTYPE py, YYSTYPE pz)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// Get the x value
@@ -933,7 +938,7 @@ YYSTYPE NscBuildVectorConstant (YYSTYPE px, YYSTYPE py, YYSTYPE pz)
 	if (px)
 	{
 		x = px ->GetFloat ();
-		g_pCtx ->FreePStackEntry (px);
+		pCtx ->FreePStackEntry (px);
 	}
 	else
 		x = 0;
@@ -946,7 +951,7 @@ YYSTYPE NscBuildVectorConstant (YYSTYPE px, YYSTYPE py, YYSTYPE pz)
 	if (py)
 	{
 		y = py ->GetFloat ();
-		g_pCtx ->FreePStackEntry (py);
+		pCtx ->FreePStackEntry (py);
 	}
 	else
 		y = 0;
@@ -959,7 +964,7 @@ YYSTYPE NscBuildVectorConstant (YYSTYPE px, YYSTYPE py, YYSTYPE pz)
 	if (pz)
 	{
 		z = pz ->GetFloat ();
-		g_pCtx ->FreePStackEntry (pz);
+		pCtx ->FreePStackEntry (pz);
 	}
 	else
 		z = 0;
@@ -977,21 +982,23 @@ YYSTYPE NscBuildVectorConstant (YYSTYPE px, YYSTYPE py, YYSTYPE pz)
 //
 // @func Build an begin of declaration
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pId | ID of the variable
 //
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
+YYSTYPE NscBuildBeginDeclaration (CNscContext *pCtx, YYSTYPE pId)
 {
 
 	//
 	// If we should check for multiple definitions
 	//
 
-	if ((g_pCtx ->IsGlobalScope () && !g_pCtx ->IsPhase2 ()) ||
-		(!g_pCtx ->IsGlobalScope () && g_pCtx ->IsPhase2 ()))
+	if ((pCtx ->IsGlobalScope () && !pCtx ->IsPhase2 ()) ||
+		(!pCtx ->IsGlobalScope () && pCtx ->IsPhase2 ()))
 	{
 
 		//
@@ -999,7 +1006,7 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 		//
 
 		size_t nSymbolFence = 0;
-		NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+		NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 		if (pFence)
 			nSymbolFence = pFence ->nSize;
 
@@ -1007,13 +1014,13 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 		// Verify that this isn't a duplicate
 		//
 
-		NscSymbol *pSymbol = g_pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
+		NscSymbol *pSymbol = pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
 		if (pSymbol)
 		{
-			size_t nSymbol = g_pCtx ->GetSymbolOffset (pSymbol);
+			size_t nSymbol = pCtx ->GetSymbolOffset (pSymbol);
 			if (nSymbol >= nSymbolFence)
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorVariableRedefined,
+				pCtx ->GenerateMessage (NscMessage_ErrorVariableRedefined,
 					pId ->GetIdentifier (), pSymbol);
 			}
 		}
@@ -1023,14 +1030,14 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 	// If we are in the global scope
 	//
 
-	if (g_pCtx ->IsGlobalScope ())
+	if (pCtx ->IsGlobalScope ())
 	{
 
 		//
 		// If this is phase 1
 		//
 
-		if (!g_pCtx ->IsPhase2 ())
+		if (!pCtx ->IsPhase2 ())
 		{
 
 			//
@@ -1038,24 +1045,24 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 			// that we couldn't handle in the BuildType routine
 			// 
 
-			if (g_pNscDeclType ->GetType () == NscType_Unknown)
+			if (pCtx ->GetDeclType () ->GetType () == NscType_Unknown)
 			{
-				NscSymbol *pSymbol = g_pCtx ->FindStructTagSymbol (
-					g_pNscDeclType ->GetIdentifier ());
+				NscSymbol *pSymbol = pCtx ->FindStructTagSymbol (
+					pCtx ->GetDeclType () ->GetIdentifier ());
 				if (pSymbol == NULL)
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorStructureUndefined,
-						g_pNscDeclType ->GetIdentifier ());
+					pCtx ->GenerateMessage (NscMessage_ErrorStructureUndefined,
+						pCtx ->GetDeclType () ->GetIdentifier ());
 				}
 				else if (pSymbol ->nSymType != NscSymType_Structure)
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorIdentifierNotStructure,
-						g_pNscDeclType ->GetIdentifier ());
+						pCtx ->GetDeclType () ->GetIdentifier ());
 				}
 				else
 				{
-					g_pNscDeclType ->SetType (pSymbol ->nType);
+					pCtx ->GetDeclType () ->SetType (pSymbol ->nType);
 				}
 			}
 
@@ -1063,16 +1070,16 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 			// Add the variable
 			//
 
-			if (g_pCtx ->FindDeclSymbol (pId ->GetIdentifier ()) != NULL)
+			if (pCtx ->FindDeclSymbol (pId ->GetIdentifier ()) != NULL)
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorIdentifierRedefined,
+				pCtx ->GenerateMessage (NscMessage_ErrorIdentifierRedefined,
 					pId ->GetIdentifier (),
-					g_pCtx ->FindDeclSymbol (pId ->GetIdentifier ()));
+					pCtx ->FindDeclSymbol (pId ->GetIdentifier ()));
 			}
 			else
 			{
-				g_pCtx ->AddVariable (pId ->GetIdentifier (), 
-					g_pNscDeclType ->GetType (), g_pNscDeclType ->GetFlags ());
+				pCtx ->AddVariable (pId ->GetIdentifier (), 
+					pCtx ->GetDeclType () ->GetType (), pCtx ->GetDeclType () ->GetFlags ());
 			}
 		}
 
@@ -1082,7 +1089,7 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 
 		else
 		{
-			NscSymbol *pSymbol = g_pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
+			NscSymbol *pSymbol = pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
 			pSymbol ->ulFlags |= NscSymFlag_BeingDefined;
 		}
 	}
@@ -1098,24 +1105,24 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 		// Define the variable if in phase2
 		//
 
-		if (g_pCtx ->IsPhase2 ())
+		if (pCtx ->IsPhase2 ())
 		{
 			//
 			// Check for constant type
 			//
 
-			if ((g_pNscDeclType ->GetFlags () & NscSymFlag_Constant) != 0)
+			if ((pCtx ->GetDeclType () ->GetFlags () & NscSymFlag_Constant) != 0)
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorConstNotAllowedOnLocals,
+				pCtx ->GenerateMessage (NscMessage_ErrorConstNotAllowedOnLocals,
 					pId ->GetIdentifier ());
 
-				g_pNscDeclType ->SetFlags (g_pNscDeclType ->GetFlags () &
+				pCtx ->GetDeclType () ->SetFlags (pCtx ->GetDeclType () ->GetFlags () &
 					~NscSymFlag_Constant);
 			}
 
-			g_pCtx ->AddVariable (pId ->GetIdentifier (), 
-				g_pNscDeclType ->GetType (), NscSymFlag_BeingDefined
-				| g_pNscDeclType ->GetFlags ());
+			pCtx ->AddVariable (pId ->GetIdentifier (), 
+				pCtx ->GetDeclType () ->GetType (), NscSymFlag_BeingDefined
+				| pCtx ->GetDeclType () ->GetFlags ());
 		}
 	}
 	return pId;
@@ -1125,6 +1132,8 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 //
 // @func Build an end of declaration
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pId | ID of the variable
 //
 // @parm YYSTYPE | pInit | Initialization expression
@@ -1133,7 +1142,7 @@ YYSTYPE NscBuildBeginDeclaration (YYSTYPE pId)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
+YYSTYPE NscBuildEndDeclaration (CNscContext *pCtx, YYSTYPE pId, YYSTYPE pInit)
 {
 	YYSTYPE pOut = NULL;
 
@@ -1161,17 +1170,17 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 	// If we really need to process this
 	//
 
-	if (g_pCtx ->IsPhase2 () || g_pCtx ->IsNWScript ())
+	if (pCtx ->IsPhase2 () || pCtx ->IsNWScript ())
 	{
 
 		//
 		// Locate the symbol
 		//
 
-		NscSymbol *pSymbol = g_pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
+		NscSymbol *pSymbol = pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
 		assert (pSymbol != NULL);
 		assert (pSymbol ->nSymType == NscSymType_Variable);
-		g_nNscLastDeclSymbol = g_pCtx ->GetSymbolOffset (pSymbol);
+		pCtx ->SetLastDeclSymbol (pCtx ->GetSymbolOffset (pSymbol));
 
 		//
 		// Clear the "begin defined" flag
@@ -1191,7 +1200,7 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 			// Add this symbol as a constant
 			//
 
-			g_pCtx ->AddGlobalFunction (g_nNscLastDeclSymbol);
+			pCtx ->AddGlobalFunction (pCtx ->GetLastDeclSymbol ());
 
 			//
 			// Simplify the constant
@@ -1207,21 +1216,21 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 
 			if (nInitSize == 0)
 			{
-				if (g_pCtx ->GetWarnAllowDefaultInitializedConstants ())
+				if (pCtx ->GetWarnAllowDefaultInitializedConstants ())
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_WarningConstantValueDefaulted,
 						pId ->GetIdentifier ());
 
 					assert (pOut == NULL);
 
-					pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+					pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
-					if (!NscPushDefaultValue (pOut, g_pNscDeclType ->GetType ()))
+					if (!NscPushDefaultValue (pCtx, pOut, pCtx ->GetDeclType () ->GetType ()))
 					{
-						g_pCtx ->GenerateMessage (
+						pCtx ->GenerateMessage (
 							NscMessage_ErrorDefaultInitNotPermitted,
-								g_pNscDeclType ->GetType (),
+								pCtx ->GetDeclType () ->GetType (),
 								pId ->GetIdentifier ());
 						fInError = true;
 					}
@@ -1232,7 +1241,7 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 				}
 				else
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorConstInitializerMissing,
 						pId ->GetIdentifier ());
 					fInError = true;
@@ -1245,7 +1254,7 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 
 			else if (!CNscPStackEntry::IsSimpleConstant (pauchInit, nInitSize))
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorConstInitializerNotConstExp,
 					pId ->GetIdentifier ());
 				fInError = true;
@@ -1260,16 +1269,16 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 			if ((!fInError) &&
 				((pSymbol ->ulFlags & NscSymFlag_ParserReferenced) != 0))
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorConstReferencedBeforeInit,
 					pId ->GetIdentifier ());
 				fInError = true;
 			}
 
 			if (!fInError &&
-				g_pCtx ->IsStructure (g_pNscDeclType ->GetType ()))
+				pCtx ->IsStructure (pCtx ->GetDeclType () ->GetType ()))
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorConstStructIllegal,
 					pId ->GetIdentifier ());
 				fInError = true;
@@ -1288,9 +1297,9 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 			//
 
 			//NscPCodeHeader *ph = (NscPCodeHeader *) pauchInit;
-			if (nInitSize > 0 && nInitType != g_pNscDeclType ->GetType ())
+			if (nInitSize > 0 && nInitType != pCtx ->GetDeclType () ->GetType ())
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorDeclInitTypeMismatch,
+				pCtx ->GenerateMessage (NscMessage_ErrorDeclInitTypeMismatch,
 					pId ->GetIdentifier ());
 			}
 
@@ -1301,7 +1310,7 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 			else if ((pSymbol ->ulFlags & (NscSymFlag_Global | 
 				NscSymFlag_Constant)) != 0)
 			{
-				g_pCtx ->AddVariableInit (pSymbol, 
+				pCtx ->AddVariableInit (pSymbol, 
 					pauchInit, nInitSize); 
 			}
 
@@ -1312,16 +1321,16 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 			else
 			{
 				if (pOut == NULL)
-					pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+					pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 				pOut ->PushDeclaration (pId ->GetIdentifier (), 
-					g_pNscDeclType ->GetType (), pauchInit, nInitSize, 
+					pCtx ->GetDeclType () ->GetType (), pauchInit, nInitSize, 
 					-1, -1, pSymbol ->ulFlags);
 			}
 		}
 		else
 		{
 			if (pOut)
-				g_pCtx ->FreePStackEntry (pOut);
+				pCtx ->FreePStackEntry (pOut);
 		}
 	}
 
@@ -1329,9 +1338,9 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 	// Rundown the values
 	//
 
-	g_pCtx ->FreePStackEntry (pId);
+	pCtx ->FreePStackEntry (pId);
 	if (pInit)
-		g_pCtx ->FreePStackEntry (pInit);
+		pCtx ->FreePStackEntry (pInit);
 
 	//
 	// Return results
@@ -1344,6 +1353,8 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 //
 // @func Build declaration list
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pList | Declaration list
 //
 // @parm YYSTYPE | pDeclaration | Declaration
@@ -1352,7 +1363,7 @@ YYSTYPE NscBuildEndDeclaration (YYSTYPE pId, YYSTYPE pInit)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
+YYSTYPE NscBuildDeclarationList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pDeclaration)
 {
 	CNscPStackEntry *pOut = pList;
 
@@ -1362,7 +1373,7 @@ YYSTYPE NscBuildDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
 
 	if (pOut == NULL)
 	{
-		pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+		pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 		pOut ->SetType (NscType_Unknown);
 	}
 
@@ -1384,7 +1395,7 @@ YYSTYPE NscBuildDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
 		}
 	}
 	if (pDeclaration)
-	    g_pCtx ->FreePStackEntry (pDeclaration);
+	    pCtx ->FreePStackEntry (pDeclaration);
 
 	//
 	// Return the new expression
@@ -1397,6 +1408,8 @@ YYSTYPE NscBuildDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
 //
 // @func Build declaration 
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pType | Declaration type
 //
 // @parm YYSTYPE | pList | List of declarations
@@ -1405,27 +1418,27 @@ YYSTYPE NscBuildDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildDeclaration (YYSTYPE pType, YYSTYPE pList)
+YYSTYPE NscBuildDeclaration (CNscContext *pCtx, YYSTYPE pType, YYSTYPE pList)
 {
 
 	//
 	// Free the type
 	//
 
-    g_pCtx ->FreePStackEntry (pType);
+    pCtx ->FreePStackEntry (pType);
 
 	//
 	// If we have a list, mark the last symbol as being the last
 	//
 
     if (pList != NULL && pList ->GetType () != NscType_Error && 
-		g_pCtx ->IsGlobalScope () && 
-		(g_pCtx ->IsPhase2 () || g_pCtx ->IsNWScript ()))
+		pCtx ->IsGlobalScope () && 
+		(pCtx ->IsPhase2 () || pCtx ->IsNWScript ()))
 	{
-		assert (g_nNscLastDeclSymbol != 0xffffffff);
-		NscSymbol *pSymbol = g_pCtx ->GetSymbol (g_nNscLastDeclSymbol);
+		assert (pCtx ->GetLastDeclSymbol () != 0xffffffff);
+		NscSymbol *pSymbol = pCtx ->GetSymbol (pCtx ->GetLastDeclSymbol ());
 		pSymbol ->ulFlags |= NscSymFlag_LastDecl;
-		g_nNscLastDeclSymbol = 0xffffffff;
+		pCtx ->SetLastDeclSymbol (0xffffffff);
 	}
 
 	//
@@ -1439,6 +1452,8 @@ YYSTYPE NscBuildDeclaration (YYSTYPE pType, YYSTYPE pList)
 //
 // @func Build parameter 
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pType | Type of the parameter
 //
 // @parm YYSTYPE | pId | Id of the parameter
@@ -1449,9 +1464,9 @@ YYSTYPE NscBuildDeclaration (YYSTYPE pType, YYSTYPE pList)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
+YYSTYPE NscBuildParameter (CNscContext *pCtx, YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// Validate what we should have
@@ -1475,7 +1490,7 @@ YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 	// Otherwise, we are ok
 	//
 
-	else if (g_pCtx ->IsPhase2 () || g_pCtx ->IsNWScript ())
+	else if (pCtx ->IsPhase2 () || pCtx ->IsNWScript ())
 	{
 
 		NscType nType = pType ->GetType ();
@@ -1486,7 +1501,7 @@ YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 
 		if ((pType ->GetFlags () & NscSymFlag_Constant) != 0)
 		{
-			g_pCtx ->GenerateMessage (NscMessage_ErrorConstIllegalOnParameter,
+			pCtx ->GenerateMessage (NscMessage_ErrorConstIllegalOnParameter,
 				pId ->GetIdentifier ());
 		}
 
@@ -1527,7 +1542,7 @@ YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 				ph ->nOpCode != NscPCode_Constant)
 			{
 				pOut ->SetType (NscType_Error);
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorParamDefaultInitNotConstExp,
 					pId ->GetIdentifier ());
 			}
@@ -1542,7 +1557,7 @@ YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 			//		really should be OBJECT_INVALID.
 			//
 
-			else if (g_pCtx ->IsNWScript () && 
+			else if (pCtx ->IsNWScript () && 
 				ph ->nType == NscType_Integer &&
 				nType == NscType_Object)
 			{
@@ -1557,7 +1572,7 @@ YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 			else if (ph ->nType != nType)
 			{
 				pOut ->SetType (NscType_Error);
-				g_pCtx ->GenerateMessage (NscMessage_ErrorParamDeclTypeMismatch,
+				pCtx ->GenerateMessage (NscMessage_ErrorParamDeclTypeMismatch,
 					pId ->GetIdentifier ());
 			}
 		}
@@ -1578,10 +1593,10 @@ YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 	// Rundown
 	//
 
-	g_pCtx ->FreePStackEntry (pType);
-    g_pCtx ->FreePStackEntry (pId);
+	pCtx ->FreePStackEntry (pType);
+    pCtx ->FreePStackEntry (pId);
 	if (pInit)
-         g_pCtx ->FreePStackEntry (pInit);
+         pCtx ->FreePStackEntry (pInit);
 
 	//
 	// Return results
@@ -1594,6 +1609,8 @@ YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 //
 // @func Build parameter list
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pList | Parameter list
 //
 // @parm YYSTYPE | pParameter | Parameter
@@ -1602,7 +1619,7 @@ YYSTYPE NscBuildParameter (YYSTYPE pType, YYSTYPE pId, YYSTYPE pInit)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildParameterList (YYSTYPE pList, YYSTYPE pParameter)
+YYSTYPE NscBuildParameterList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pParameter)
 {
 	CNscPStackEntry *pOut = pList;
 
@@ -1612,7 +1629,7 @@ YYSTYPE NscBuildParameterList (YYSTYPE pList, YYSTYPE pParameter)
 
 	if (pOut == NULL)
 	{
-		pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+		pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 		pOut ->SetType (NscType_Unknown);
 	}
 
@@ -1630,7 +1647,7 @@ YYSTYPE NscBuildParameterList (YYSTYPE pList, YYSTYPE pParameter)
 		else
 			pOut ->SetType (NscType_Error);
 	}
-	g_pCtx ->FreePStackEntry (pParameter);
+	pCtx ->FreePStackEntry (pParameter);
 
 
 	//
@@ -1644,6 +1661,8 @@ YYSTYPE NscBuildParameterList (YYSTYPE pList, YYSTYPE pParameter)
 //
 // @func Build a function declarator
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pType | Type of the function
 //
 // @parm YYSTYPE | pId | If of the function
@@ -1654,21 +1673,21 @@ YYSTYPE NscBuildParameterList (YYSTYPE pList, YYSTYPE pParameter)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
+YYSTYPE NscBuildFunctionDeclarator (CNscContext *pCtx, YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// Set global scope
 	//
 
-	g_pCtx ->SetGlobalScope (false);
+	pCtx ->SetGlobalScope (false);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 
 		//
@@ -1677,8 +1696,8 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 
 		if (pId ->GetType () != NscType_Error)
 		{
-			if (g_pCtx ->IsEntryPointSymbol (pId ->GetIdentifier ()))
-				g_pCtx ->SetMain (true);
+			if (pCtx ->IsEntryPointSymbol (pId ->GetIdentifier ()))
+				pCtx ->SetMain (true);
 		}
 
 		//
@@ -1686,11 +1705,11 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 		//
 
 		if (pType)
-			g_pCtx ->FreePStackEntry (pType);
+			pCtx ->FreePStackEntry (pType);
 		if (pId)
-			g_pCtx ->FreePStackEntry (pId);
+			pCtx ->FreePStackEntry (pId);
 		if (pList)
-			g_pCtx ->FreePStackEntry (pList);
+			pCtx ->FreePStackEntry (pList);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -1735,7 +1754,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 
 		if ((pType ->GetFlags () & NscSymFlag_Constant) != 0)
 		{
-			g_pCtx ->GenerateMessage (NscMessage_ErrorConstReturnTypeIllegal,
+			pCtx ->GenerateMessage (NscMessage_ErrorConstReturnTypeIllegal,
 				pId ->GetIdentifier ());
 		}
 
@@ -1755,7 +1774,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 		//
 
 		bool fHadDefault = false;
-		bool fIsEntryPoint = g_pCtx ->IsEntryPointSymbol (pId ->GetIdentifier ());
+		bool fIsEntryPoint = pCtx ->IsEntryPointSymbol (pId ->GetIdentifier ());
 		unsigned char *pauchData = pauchParameters;
 		unsigned char *pauchEnd = &pauchData [nParametersSize];
 		int nArgCount = 0;
@@ -1793,7 +1812,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 
 					if (fIsEntryPoint)
 					{
-						g_pCtx ->GenerateMessage (
+						pCtx ->GenerateMessage (
 							NscMessage_WarningEntrySymbolHasDefaultArgs,
 							pId ->GetIdentifier (),
 							pd ->szString);
@@ -1807,7 +1826,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 				else if (fHadDefault)
 				{
 					pOut ->SetType (NscType_Error);
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorNondefaultParamAfterDefault,
 						pId ->GetIdentifier (),
 						(const char *) pd ->szString);
@@ -1816,18 +1835,18 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 
 				nArgCount++;
 
-				if (nArgCount > g_pCtx ->GetMaxFunctionParameterCount ())
+				if (nArgCount > pCtx ->GetMaxFunctionParameterCount ())
 				{
 					pOut ->SetType (NscType_Error);
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorTooManyParameters,
 						pId ->GetIdentifier (),
-						g_pCtx ->GetMaxFunctionParameterCount ());
+						pCtx ->GetMaxFunctionParameterCount ());
 					break;
 				}
 				else if (nArgCount > CNscContext::Max_Compat_Function_Parameter_Count)
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_WarningCompatParamLimitExceeded,
 						pId ->GetIdentifier (),
 						CNscContext::Max_Compat_Function_Parameter_Count);
@@ -1852,7 +1871,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 		// Try to locate this symbol to make sure definition matches implementation
 		//
 
-		pSymbol = g_pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
+		pSymbol = pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
 		size_t nSymbol = 0;
 		if (pSymbol != NULL)
 		{
@@ -1861,7 +1880,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 			// Get the symbol offset
 			//
 
-			nSymbol = g_pCtx ->GetSymbolOffset (pSymbol);
+			nSymbol = pCtx ->GetSymbolOffset (pSymbol);
 
 			//
 			// Locate the function extra information and declaration for 
@@ -1869,7 +1888,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 			//
 
 			size_t nOffset = pSymbol ->nExtra;
-			unsigned char *pauchProtoData = g_pCtx ->GetSymbolData (nOffset);
+			unsigned char *pauchProtoData = pCtx ->GetSymbolData (nOffset);
 			int nArgCount = ((NscSymbolFunctionExtra *) pauchProtoData) ->nArgCount;
 			NscSymType nOtherSymType = pSymbol ->nSymType;
 			pauchProtoData += sizeof (NscSymbolFunctionExtra);
@@ -1917,7 +1936,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 
 				else if (strcmp (p1 ->szString, p2 ->szString) != 0)
 				{
-					size_t nAltString = g_pCtx ->AppendSymbolData (
+					size_t nAltString = pCtx ->AppendSymbolData (
 						(unsigned char *) p1 ->szString, 
 						strlen (p1 ->szString) + 1);
 
@@ -1926,8 +1945,8 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 					//      in OpenKnights.
 					//
 
-					pSymbol = g_pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
-					pauchProtoData = g_pCtx ->GetSymbolData (nOffset);
+					pSymbol = pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
+					pauchProtoData = pCtx ->GetSymbolData (nOffset);
 					p2 = (NscPCodeDeclaration *) pauchProtoData;
 					p2 ->nAltStringOffset = nAltString;
 				}
@@ -1942,7 +1961,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 						&pauchData [p1 ->nDataOffset], p1 ->nDataSize,
 						&pauchProtoData [p2 ->nDataOffset], p2 ->nDataSize))
 				{
-					g_pCtx ->GenerateMessage (NscMessage_WarningFnDefaultArgValueMismatch,
+					pCtx ->GenerateMessage (NscMessage_WarningFnDefaultArgValueMismatch,
 						pId ->GetIdentifier (),
 						p1 ->szString);
 				}
@@ -1972,7 +1991,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 
 			if (nOtherSymType != NscSymType_Function)
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorFunctionSymbolTypeMismatch,
 					pId ->GetIdentifier (), pSymbol);
 				fProblem = true;
@@ -1989,9 +2008,9 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 
 			if ((pSymbol ->nType != nType) &&
 			    ((pSymbol ->ulFlags & NscSymFlag_ParserReferenced) == 0) &&
-			    (g_pCtx ->GetWarnAllowMismatchedPrototypes ()))
+			    (pCtx ->GetWarnAllowMismatchedPrototypes ()))
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_WarningRepairedPrototypeRetType,
 					pId ->GetIdentifier (), pSymbol);
 
@@ -2005,7 +2024,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 			if ((fProblem || pSymbol ->nType != nType) &&
 				(pOut ->GetType () != NscType_Error))
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorFunctionPrototypeMismatch,
 					pId ->GetIdentifier (), pSymbol);
 				pOut ->SetType (NscType_Error);
@@ -2034,12 +2053,12 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 		{
 			UINT32 ulFlags = 0;
 
-			if (g_pCtx ->IsCompilingIntrinsic ())
+			if (pCtx ->IsCompilingIntrinsic ())
 				ulFlags |= NscSymFlag_Intrinsic;
-			else if (g_pCtx ->IsNWScript ())
+			else if (pCtx ->IsNWScript ())
 				ulFlags |= NscSymFlag_EngineFunc;
 
-			pSymbol = g_pCtx ->AddPrototype (pId ->GetIdentifier (), 
+			pSymbol = pCtx ->AddPrototype (pId ->GetIdentifier (), 
 				nType, ulFlags, pauchParameters, nParametersSize);
 
 			assert (pSymbol != NULL);
@@ -2049,13 +2068,13 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 		// Save the fence
 		//
 
-		NscPushFence (pOut, pSymbol, NscFenceType_Function, false);
+		NscPushFence (pCtx, pOut, pSymbol, NscFenceType_Function, false);
 
 		//
 		// Get the argument count
 		//
 
-		unsigned char *pauchProtoData = g_pCtx ->GetSymbolData (pSymbol ->nExtra);
+		unsigned char *pauchProtoData = pCtx ->GetSymbolData (pSymbol ->nExtra);
 		NscSymbolFunctionExtra *pExtra = (NscSymbolFunctionExtra *) pauchProtoData;
 		int nArgCount = pExtra ->nArgCount;
 
@@ -2082,7 +2101,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 
 		for (int i = 0; i < nArgCount; i++)
 		{
-			g_pCtx ->AddVariable (papDecls [i] ->szString, 
+			pCtx ->AddVariable (papDecls [i] ->szString, 
 				papDecls [i] ->nType, 0);
 		}
 	}
@@ -2093,7 +2112,7 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 		// Save the fence
 		//
 
-		NscPushFence (pOut, NULL, NscFenceType_Function, false);
+		NscPushFence (pCtx, pOut, NULL, NscFenceType_Function, false);
 	}
 
 
@@ -2101,10 +2120,10 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 	// Rundown
 	//
 
-	g_pCtx ->FreePStackEntry (pType);
-	g_pCtx ->FreePStackEntry (pId);
+	pCtx ->FreePStackEntry (pType);
+	pCtx ->FreePStackEntry (pId);
 	if (pList)
-         g_pCtx ->FreePStackEntry (pList);
+         pCtx ->FreePStackEntry (pList);
 	return pOut;
 }
 
@@ -2112,35 +2131,37 @@ YYSTYPE NscBuildFunctionDeclarator (YYSTYPE pType, YYSTYPE pId, YYSTYPE pList)
 //
 // @func Build a function prototype
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pPrototype | Function prototype
 //
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildFunctionPrototype (YYSTYPE pPrototype)
+YYSTYPE NscBuildFunctionPrototype (CNscContext *pCtx, YYSTYPE pPrototype)
 {
 
 	//
 	// Restore the fence
 	//
 
-	if (g_pCtx ->IsPhase2 () || g_pCtx ->IsNWScript ())
+	if (pCtx ->IsPhase2 () || pCtx ->IsNWScript ())
 	{
-		g_pCtx ->RestoreFence (pPrototype);
+		pCtx ->RestoreFence (pPrototype);
 	}
 
 	//
 	// Set global scope
 	//
 
-	g_pCtx ->SetGlobalScope (true);
+	pCtx ->SetGlobalScope (true);
 
 	//
 	// Rundown
 	//
 
-	g_pCtx ->FreePStackEntry (pPrototype);
+	pCtx ->FreePStackEntry (pPrototype);
 	return NULL;
 }
 
@@ -2148,6 +2169,8 @@ YYSTYPE NscBuildFunctionPrototype (YYSTYPE pPrototype)
 //
 // @func Build a function definition
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pPrototype | Function prototype
 //
 // @parm YYSTYPE | pStatement | Statement
@@ -2156,14 +2179,14 @@ YYSTYPE NscBuildFunctionPrototype (YYSTYPE pPrototype)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
+YYSTYPE NscBuildFunctionDef (CNscContext *pCtx, YYSTYPE pPrototype, YYSTYPE pStatement)
 {
 
 	//
 	// If we need to process the function
 	//
 
-	if (g_pCtx ->IsPhase2 () || g_pCtx ->IsNWScript ())
+	if (pCtx ->IsPhase2 () || pCtx ->IsNWScript ())
 	{
 
 		//
@@ -2173,12 +2196,12 @@ YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
 		NscSymbolFence *pFence = pPrototype ->GetFence ();
 		if (pFence ->nFnSymbol != 0)
 		{
-			NscSymbol *pSymbol = g_pCtx ->GetSymbol (pFence ->nFnSymbol);
+			NscSymbol *pSymbol = pCtx ->GetSymbol (pFence ->nFnSymbol);
 			if (pSymbol ->nType != NscType_Void)
 			{
 				if (pFence ->nFenceReturn != NscFenceReturn_Yes)
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorNotAllPathsReturnValue);
+					pCtx ->GenerateMessage (NscMessage_ErrorNotAllPathsReturnValue);
 				}
 			}
 		}
@@ -2187,7 +2210,7 @@ YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
 		// Restore the fence
 		//
 
-		g_pCtx ->RestoreFence (pPrototype);
+		pCtx ->RestoreFence (pPrototype);
 
 		//
 		// Get the statement data
@@ -2207,7 +2230,7 @@ YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
 
 		if (pFence ->nFnSymbol != 0)
 		{
-			NscSymbol *pSymbol = g_pCtx ->GetSymbol (pFence ->nFnSymbol);
+			NscSymbol *pSymbol = pCtx ->GetSymbol (pFence ->nFnSymbol);
 			size_t nExtra = pSymbol ->nExtra;
 			NscSymbolFunctionExtra *pExtra;
 			bool fInError = false;
@@ -2218,17 +2241,17 @@ YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
 
 			if (nDataSize != 0)
 			{
-				pExtra = (NscSymbolFunctionExtra *) g_pCtx ->GetSymbolData (nExtra);
+				pExtra = (NscSymbolFunctionExtra *) pCtx ->GetSymbolData (nExtra);
 				if (pExtra ->nCodeOffset != 0)
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorFunctionBodyRedefined,
+					pCtx ->GenerateMessage (NscMessage_ErrorFunctionBodyRedefined,
 						pSymbol ->szString, pSymbol);
 					fInError = true;
 				}
 				else
 				{
-					size_t nCodeOffset = g_pCtx ->AppendSymbolData (pauchData, nDataSize);
-					pExtra = (NscSymbolFunctionExtra *) g_pCtx ->GetSymbolData (nExtra);
+					size_t nCodeOffset = pCtx ->AppendSymbolData (pauchData, nDataSize);
+					pExtra = (NscSymbolFunctionExtra *) pCtx ->GetSymbolData (nExtra);
 					pExtra ->nCodeOffset = nCodeOffset;
 					pExtra ->nCodeSize = nDataSize;
 				}
@@ -2238,20 +2261,20 @@ YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
 			// Set the line and file information
 			//
 
-			pExtra = (NscSymbolFunctionExtra *) g_pCtx ->GetSymbolData (nExtra);
+			pExtra = (NscSymbolFunctionExtra *) pCtx ->GetSymbolData (nExtra);
 
 			if (((pExtra ->ulFunctionFlags & NscFuncFlag_Defined) != 0) &&
 				(!fInError))
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorFunctionBodyRedefined,
+				pCtx ->GenerateMessage (NscMessage_ErrorFunctionBodyRedefined,
 					pSymbol ->szString, pSymbol);
 				fInError = true;
 			}
 
-			pExtra ->nFile = g_pCtx ->GetCurrentFile ();
-			pExtra ->nLine = g_pCtx ->GetCurrentLine ();
+			pExtra ->nFile = pCtx ->GetCurrentFile ();
+			pExtra ->nLine = pCtx ->GetCurrentLine ();
 			pExtra ->ulFunctionFlags |= NscFuncFlag_Defined;
-			g_pCtx ->AddGlobalDefinition (pFence ->nFnSymbol);
+			pCtx ->AddGlobalDefinition (pFence ->nFnSymbol);
 		}
 	}
 
@@ -2259,16 +2282,16 @@ YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
 	// Set global scope
 	//
 
-	g_pCtx ->SetGlobalScope (true);
+	pCtx ->SetGlobalScope (true);
 
 	//
 	// Rundown
 	//
 
 	if (pPrototype)
-        g_pCtx ->FreePStackEntry (pPrototype);
+        pCtx ->FreePStackEntry (pPrototype);
 	if (pStatement)
-        g_pCtx ->FreePStackEntry (pStatement);
+        pCtx ->FreePStackEntry (pStatement);
 	return NULL;
 }
 
@@ -2276,6 +2299,8 @@ YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
 //
 // @func Build struct declarator list 
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pList | Declarator list
 //
 // @parm YYSTYPE | pDeclarator | Declarator
@@ -2284,7 +2309,7 @@ YYSTYPE NscBuildFunctionDef (YYSTYPE pPrototype, YYSTYPE pStatement)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildStructDeclaratorList (YYSTYPE pList, YYSTYPE pDeclarator)
+YYSTYPE NscBuildStructDeclaratorList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pDeclarator)
 {
 	CNscPStackEntry *pOut = pList;
 
@@ -2294,7 +2319,7 @@ YYSTYPE NscBuildStructDeclaratorList (YYSTYPE pList, YYSTYPE pDeclarator)
 
 	if (pOut == NULL)
 	{
-		pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+		pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 		pOut ->SetType (NscType_Unknown);
 	}
 
@@ -2305,10 +2330,10 @@ YYSTYPE NscBuildStructDeclaratorList (YYSTYPE pList, YYSTYPE pDeclarator)
 	if (pOut ->GetType () != NscType_Error)
 	{
 		pOut ->PushDeclaration (pDeclarator ->GetIdentifier (),
-			NscType_Unknown, NULL, 0, g_pCtx ->GetFile (0),
-			g_pCtx ->GetLine (0), 0);
+			NscType_Unknown, NULL, 0, pCtx ->GetFile (0),
+			pCtx ->GetLine (0), 0);
 	}
-	g_pCtx ->FreePStackEntry (pDeclarator);
+	pCtx ->FreePStackEntry (pDeclarator);
 
 
 	//
@@ -2322,6 +2347,8 @@ YYSTYPE NscBuildStructDeclaratorList (YYSTYPE pList, YYSTYPE pDeclarator)
 //
 // @func Build struct declaration 
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pType | Declaration type
 //
 // @parm YYSTYPE | pList | List of declarations
@@ -2330,7 +2357,7 @@ YYSTYPE NscBuildStructDeclaratorList (YYSTYPE pList, YYSTYPE pDeclarator)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildStructDeclaration (YYSTYPE pType, YYSTYPE pList)
+YYSTYPE NscBuildStructDeclaration (CNscContext *pCtx, YYSTYPE pType, YYSTYPE pList)
 {
 	//
 	// Check for constant type
@@ -2338,7 +2365,7 @@ YYSTYPE NscBuildStructDeclaration (YYSTYPE pType, YYSTYPE pList)
 
 	if ((pType ->GetFlags () & NscSymFlag_Constant) != 0)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorConstIllegalOnStructMember);
+		pCtx ->GenerateMessage (NscMessage_ErrorConstIllegalOnStructMember);
 	}
 
 	//
@@ -2348,7 +2375,7 @@ YYSTYPE NscBuildStructDeclaration (YYSTYPE pType, YYSTYPE pList)
 
 	if (pType ->GetType () == NscType_Unknown)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorStructureUndefined,
+		pCtx ->GenerateMessage (NscMessage_ErrorStructureUndefined,
 			pType ->GetIdentifier ());
 	}
 
@@ -2370,7 +2397,7 @@ YYSTYPE NscBuildStructDeclaration (YYSTYPE pType, YYSTYPE pList)
 	// Rundown
 	//
 
-	g_pCtx ->FreePStackEntry (pType);
+	pCtx ->FreePStackEntry (pType);
 	return pList;
 }
 
@@ -2378,6 +2405,8 @@ YYSTYPE NscBuildStructDeclaration (YYSTYPE pType, YYSTYPE pList)
 //
 // @func Build struct declaration list
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pList | Declaration list
 //
 // @parm YYSTYPE | pDeclaration | Declaration
@@ -2386,7 +2415,7 @@ YYSTYPE NscBuildStructDeclaration (YYSTYPE pType, YYSTYPE pList)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildStructDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
+YYSTYPE NscBuildStructDeclarationList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pDeclaration)
 {
 	CNscPStackEntry *pOut = pList;
 
@@ -2396,7 +2425,7 @@ YYSTYPE NscBuildStructDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
 
 	if (pOut == NULL)
 	{
-		pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+		pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 		pOut ->SetType (NscType_Unknown);
 	}
 
@@ -2415,7 +2444,7 @@ YYSTYPE NscBuildStructDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
 		else
 			pOut ->SetType (NscType_Error);
 	}
-	g_pCtx ->FreePStackEntry (pDeclarationEntry);
+	pCtx ->FreePStackEntry (pDeclarationEntry);
 
 
 	//
@@ -2429,6 +2458,8 @@ YYSTYPE NscBuildStructDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
 //
 // @func Build struct 
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pId | Structure id
 //
 // @parm YYSTYPE | pList | Declaration list
@@ -2437,7 +2468,7 @@ YYSTYPE NscBuildStructDeclarationList (YYSTYPE pList, YYSTYPE pDeclaration)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildStruct (YYSTYPE pId, YYSTYPE pList)
+YYSTYPE NscBuildStruct (CNscContext *pCtx, YYSTYPE pId, YYSTYPE pList)
 {
 	assert (pId);
 	assert (pList);
@@ -2457,12 +2488,12 @@ YYSTYPE NscBuildStruct (YYSTYPE pId, YYSTYPE pList)
 
 	else
 	{
-		if (!g_pCtx ->IsPhase2 ())
+		if (!pCtx ->IsPhase2 ())
 		{
 			NscSymbol *pSymbol;
 			bool fProblem;
 
-			pSymbol = g_pCtx ->FindStructTagSymbol (pId ->GetIdentifier ());
+			pSymbol = pCtx ->FindStructTagSymbol (pId ->GetIdentifier ());
 			fProblem = false;
 
 			//
@@ -2476,13 +2507,13 @@ YYSTYPE NscBuildStruct (YYSTYPE pId, YYSTYPE pList)
 			{
 				if (pSymbol ->nSymType == NscSymType_Structure)
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorStructureRedefined,
+					pCtx ->GenerateMessage (NscMessage_ErrorStructureRedefined,
 						pId ->GetIdentifier (), pSymbol);
 					fProblem = true;
 				}
 				else
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorStructSymbolTypeMismatch,
 						pId ->GetIdentifier (), pSymbol);
 					fProblem = true;
@@ -2491,7 +2522,7 @@ YYSTYPE NscBuildStruct (YYSTYPE pId, YYSTYPE pList)
 
 			if (!fProblem)
 			{
-				g_pCtx ->AddStructure (pId ->GetIdentifier (),
+				pCtx ->AddStructure (pId ->GetIdentifier (),
 					pList ->GetData (), pList ->GetDataSize ());
 			}
 		}
@@ -2501,8 +2532,8 @@ YYSTYPE NscBuildStruct (YYSTYPE pId, YYSTYPE pList)
 	// Rundown
 	//
 
-    g_pCtx ->FreePStackEntry (pId);
-    g_pCtx ->FreePStackEntry (pList);
+    pCtx ->FreePStackEntry (pId);
+    pCtx ->FreePStackEntry (pList);
 	return NULL;
 }
 
@@ -2510,6 +2541,8 @@ YYSTYPE NscBuildStruct (YYSTYPE pId, YYSTYPE pList)
 //
 // @func Build a post/pre increment/decrement
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pValue | Value
 //
 // @parm int | fPlus | If true, increment
@@ -2520,18 +2553,18 @@ YYSTYPE NscBuildStruct (YYSTYPE pId, YYSTYPE pList)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildPlusMinus (YYSTYPE pValue, int fPlus, int fPre)
+YYSTYPE NscBuildPlusMinus (CNscContext *pCtx, YYSTYPE pValue, int fPlus, int fPre)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pValue)
-			g_pCtx ->FreePStackEntry (pValue);
+			pCtx ->FreePStackEntry (pValue);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -2568,7 +2601,7 @@ YYSTYPE NscBuildPlusMinus (YYSTYPE pValue, int fPlus, int fPre)
 	}
 	else
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, fPlus ? "++" : "--");
+		pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, fPlus ? "++" : "--");
 		pOut ->SetType (NscType_Error);
 	}
 
@@ -2576,7 +2609,7 @@ YYSTYPE NscBuildPlusMinus (YYSTYPE pValue, int fPlus, int fPre)
 	// Rundown
 	//
 
-    g_pCtx ->FreePStackEntry (pValue);
+    pCtx ->FreePStackEntry (pValue);
 	return pOut;
 }
 
@@ -2584,6 +2617,8 @@ YYSTYPE NscBuildPlusMinus (YYSTYPE pValue, int fPlus, int fPre)
 //
 // @func Build a unary operator
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nToken | Operator token
 //
 // @parm YYSTYPE | pValue | Value
@@ -2592,18 +2627,18 @@ YYSTYPE NscBuildPlusMinus (YYSTYPE pValue, int fPlus, int fPre)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
+YYSTYPE NscBuildUnaryOp (CNscContext *pCtx, int nToken, YYSTYPE pValue)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pValue)
-			g_pCtx ->FreePStackEntry (pValue);
+			pCtx ->FreePStackEntry (pValue);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -2641,7 +2676,7 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 				}
 				else
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "+");
+					pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "+");
 					pOut ->SetType (NscType_Error);
 				}
 				break;
@@ -2649,7 +2684,7 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 			case '-':
 				if (nType == NscType_Integer)
 				{
-					if (g_pCtx ->GetOptExpression () &&
+					if (pCtx ->GetOptExpression () &&
 						pValue ->IsSimpleConstant ())
 					{
 						pOut ->PushConstantInteger (
@@ -2665,7 +2700,7 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 				}
 				else if (nType == NscType_Float)
 				{
-					if (g_pCtx ->GetOptExpression () &&
+					if (pCtx ->GetOptExpression () &&
 						pValue ->IsSimpleConstant ())
 					{
 						pOut ->PushConstantFloat (
@@ -2681,7 +2716,7 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 				}
 				else
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "-");
+					pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "-");
 					pOut ->SetType (NscType_Error);
 				}
 				break;
@@ -2689,7 +2724,7 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 			case '~':
 				if (nType == NscType_Integer)
 				{
-					if (g_pCtx ->GetOptExpression () &&
+					if (pCtx ->GetOptExpression () &&
 						pValue ->IsSimpleConstant ())
 					{
 						pOut ->PushConstantInteger (
@@ -2705,7 +2740,7 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 				}
 				else
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "~");
+					pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "~");
 					pOut ->SetType (NscType_Error);
 				}
 				break;
@@ -2713,7 +2748,7 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 			case '!':
 				if (nType == NscType_Integer)
 				{
-					if (g_pCtx ->GetOptExpression () &&
+					if (pCtx ->GetOptExpression () &&
 						pValue ->IsSimpleConstant ())
 					{
 						pOut ->PushConstantInteger (
@@ -2729,14 +2764,14 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 				}
 				else
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "!");
+					pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "!");
 					pOut ->SetType (NscType_Error);
 				}
 				break;
 
 			default:
 				assert (false);
-				g_pCtx ->GenerateMessage (NscMessage_ErrorInternalCompilerError,
+				pCtx ->GenerateMessage (NscMessage_ErrorInternalCompilerError,
 					"invalid unary operator");
 				pOut ->SetType (NscType_Error);
 				break;
@@ -2747,7 +2782,7 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 	// Rundown
 	//
 
-    g_pCtx ->FreePStackEntry (pValue);
+    pCtx ->FreePStackEntry (pValue);
 	return pOut;
 }
 
@@ -2755,6 +2790,8 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 //
 // @func Build a binary operator
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nToken | Operator token
 //
 // @parm YYSTYPE | pLhs | Left hand side
@@ -2765,21 +2802,21 @@ YYSTYPE NscBuildUnaryOp (int nToken, YYSTYPE pValue)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
+YYSTYPE NscBuildBinaryOp (CNscContext *pCtx, int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 	CNscPStackEntry *pTmp = NULL;
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pLhs)
-			g_pCtx ->FreePStackEntry (pLhs);
+			pCtx ->FreePStackEntry (pLhs);
 		if (pRhs)
-			g_pCtx ->FreePStackEntry (pRhs);
+			pCtx ->FreePStackEntry (pRhs);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -2795,8 +2832,8 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 	if (nLhsType == NscType_Error || nRhsType == NscType_Error)
 	{
 		pOut ->SetType (NscType_Error);
-		g_pCtx ->FreePStackEntry (pLhs);
-		g_pCtx ->FreePStackEntry (pRhs);
+		pCtx ->FreePStackEntry (pLhs);
+		pCtx ->FreePStackEntry (pRhs);
 		return pOut;
 	}
 
@@ -2811,7 +2848,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '*':
 			if (nLhsType == NscType_Float && nRhsType == NscType_Vector)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -2831,7 +2868,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Vector && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -2851,22 +2888,22 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
 					pOut ->PushConstantInteger (pLhs ->GetInteger () * pRhs ->GetInteger ());
 					pOut ->SetType (NscType_Integer);
 				}
-				else if (g_pCtx ->GetOptExpression () &&
+				else if (pCtx ->GetOptExpression () &&
 					pRhs ->IsSimpleConstant () &&
 					pRhs ->GetInteger () == 0 &&
-					pLhs ->GetHasSideEffects (g_pCtx) == false)
+					pLhs ->GetHasSideEffects (pCtx) == false)
 				{
 					pOut ->PushConstantInteger (0);
 					pOut ->SetType (NscType_Integer);
 				}
-				else if (g_pCtx ->GetOptExpression () &&
+				else if (pCtx ->GetOptExpression () &&
 					pRhs ->IsIntegerPowerOf2 () &&
 					pRhs ->GetInteger () != 0)
 				{
@@ -2887,15 +2924,15 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 					pOut ->PushBinaryOp (NscPCode_ShiftLeft, NscType_Integer, nLhsType, nRhsType);
 					pOut ->SetType (NscType_Integer);
 				}
-				else if (g_pCtx ->GetOptExpression () &&
+				else if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pLhs ->GetInteger () == 0 &&
-					pRhs ->GetHasSideEffects (g_pCtx) == false)
+					pRhs ->GetHasSideEffects (pCtx) == false)
 				{
 					pOut ->PushConstantInteger (0);
 					pOut ->SetType (NscType_Integer);
 				}
-				else if (g_pCtx ->GetOptExpression () &&
+				else if (pCtx ->GetOptExpression () &&
 					pLhs ->IsIntegerPowerOf2 () &&
 					pLhs ->GetInteger () != 0)
 				{
@@ -2926,7 +2963,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -2943,7 +2980,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -2960,7 +2997,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -2977,7 +3014,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "*");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "*");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -2985,7 +3022,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '/':
 			if (nLhsType == NscType_Vector && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant () &&
 					pRhs ->GetFloat () != 0.0f)
@@ -3006,7 +3043,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant () &&
 					pRhs ->GetInteger () != 0)
@@ -3024,7 +3061,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant () &&
 					pRhs ->GetFloat () != 0.0f)
@@ -3042,7 +3079,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant () &&
 					pRhs ->GetInteger () != 0)
@@ -3060,7 +3097,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant () &&
 					pRhs ->GetFloat () != 0.0f)
@@ -3078,7 +3115,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "/");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "/");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3086,7 +3123,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '%':
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant () &&
 					pRhs ->GetInteger () != 0)
@@ -3104,7 +3141,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "%");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "%");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3112,7 +3149,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '+':
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3129,7 +3166,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3146,7 +3183,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3163,7 +3200,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3180,7 +3217,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_String && nRhsType == NscType_String)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3204,7 +3241,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Vector && nRhsType == NscType_Vector)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3226,7 +3263,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "+");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "+");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3234,7 +3271,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '-':
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3251,7 +3288,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3268,7 +3305,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3285,7 +3322,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3302,7 +3339,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Vector && nRhsType == NscType_Vector)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3324,7 +3361,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "-");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "-");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3332,7 +3369,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case SL:
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3349,7 +3386,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "<<");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "<<");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3358,7 +3395,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
 #ifdef NOT_ENABLED_YET
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3376,7 +3413,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, ">>");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, ">>");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3385,7 +3422,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
 #ifdef NOT_ENABLED_YET
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3403,7 +3440,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, ">>>");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, ">>>");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3411,7 +3448,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '<':
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3428,7 +3465,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3445,7 +3482,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "<");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "<");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3453,7 +3490,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '>':
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3470,7 +3507,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3487,7 +3524,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, ">");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, ">");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3495,7 +3532,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case LTEQ:
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3512,7 +3549,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3529,7 +3566,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, ">=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, ">=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3537,7 +3574,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case GTEQ:
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3554,7 +3591,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3571,7 +3608,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "<=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "<=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3579,7 +3616,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case EQ:
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3596,7 +3633,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3613,7 +3650,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_String && nRhsType == NscType_String)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3630,7 +3667,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Vector && nRhsType == NscType_Vector)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3661,7 +3698,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "==");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "==");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3669,7 +3706,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case NOTEQ:
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3686,7 +3723,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3703,7 +3740,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_String && nRhsType == NscType_String)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3720,7 +3757,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else if (nLhsType == NscType_Vector && nRhsType == NscType_Vector)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3751,7 +3788,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "!=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "!=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3759,7 +3796,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '&':
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3776,7 +3813,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "&");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "&");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3784,7 +3821,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '^':
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3801,7 +3838,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "^");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "^");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3809,7 +3846,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case '|':
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pLhs ->IsSimpleConstant () &&
 					pRhs ->IsSimpleConstant ())
 				{
@@ -3826,7 +3863,7 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "|");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "|");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3836,12 +3873,12 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 				nRhsType >= NscType__First_Compare &&
 				nLhsType == nRhsType)
 			{
-				NscPushAssignment (pOut, NscPCode_Assignment, 
+				NscPushAssignment (pCtx, pOut, NscPCode_Assignment, 
 					nLhsType, pLhs, pRhs);
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3849,21 +3886,21 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case MULEQ:
 			if (nLhsType == NscType_Vector && nRhsType == NscType_Float)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnMultiply, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnMultiply, 
 					NscType_Vector, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pRhs -> IsSimpleConstant () &&
-					pLhs -> GetHasSideEffects (g_pCtx) == false &&
+					pLhs -> GetHasSideEffects (pCtx) == false &&
 					pRhs -> GetInteger () == 0)
 				{
-					pTmp = NscBuildIntegerConstant (0);
-					NscPushAssignment (pOut, NscPCode_Assignment,
+					pTmp = NscBuildIntegerConstant (pCtx, 0);
+					NscPushAssignment (pCtx, pOut, NscPCode_Assignment,
 						NscType_Integer, pLhs, pTmp);
 				}
-				else if (g_pCtx ->GetOptExpression () &&
+				else if (pCtx ->GetOptExpression () &&
 					pRhs ->IsIntegerPowerOf2 () &&
 					pRhs ->GetInteger () != 0)
 				{
@@ -3880,30 +3917,30 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 					}
 
 					pTmp = pRhs;
-					pRhs = NscBuildIntegerConstant (nShift);
+					pRhs = NscBuildIntegerConstant (pCtx, nShift);
 					pszOp = "*=";
 					nOp = NscPCode_AsnShiftLeft;
 					goto asn_shift_operator;
 				}
 				else
 				{
-					NscPushAssignment (pOut, NscPCode_AsnMultiply, 
+					NscPushAssignment (pCtx, pOut, NscPCode_AsnMultiply, 
 						NscType_Integer, pLhs, pRhs);
 				}
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnMultiply, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnMultiply, 
 					NscType_Float, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Integer)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnMultiply, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnMultiply, 
 					NscType_Float, pLhs, pRhs);
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "*=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "*=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3911,27 +3948,27 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case DIVEQ:
 			if (nLhsType == NscType_Vector && nRhsType == NscType_Float)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnDivide, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnDivide, 
 					NscType_Vector, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnDivide, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnDivide, 
 					NscType_Integer, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnDivide, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnDivide, 
 					NscType_Float, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Integer)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnDivide, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnDivide, 
 					NscType_Float, pLhs, pRhs);
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "/=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "/=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3939,12 +3976,12 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case MODEQ:
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnModulus, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnModulus, 
 					NscType_Integer, pLhs, pRhs);
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "%=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "%=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -3952,12 +3989,12 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case ADDEQ:
 			if (nLhsType == NscType_Vector && nRhsType == NscType_Vector)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnAdd, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnAdd, 
 					NscType_Vector, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pRhs -> IsSimpleConstant () &&
 					pRhs -> GetInteger () == 1)
 				{
@@ -3968,33 +4005,33 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 					//
 
 					pTmp = pOut;
-					pOut = NscBuildPlusMinus (pLhs, TRUE, TRUE);
+					pOut = NscBuildPlusMinus (pCtx, pLhs, TRUE, TRUE);
 					pLhs = NULL;
 				}
 				else
 				{
-					NscPushAssignment (pOut, NscPCode_AsnAdd, 
+					NscPushAssignment (pCtx, pOut, NscPCode_AsnAdd, 
 						NscType_Integer, pLhs, pRhs);
 				}
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnAdd, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnAdd, 
 					NscType_Float, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Integer)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnAdd, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnAdd, 
 					NscType_Float, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_String && nRhsType == NscType_String)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnAdd, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnAdd, 
 					NscType_String, pLhs, pRhs);
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "+=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "+=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -4002,12 +4039,12 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		case SUBEQ:
 			if (nLhsType == NscType_Vector && nRhsType == NscType_Vector)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnSubtract, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnSubtract, 
 					NscType_Vector, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				if (g_pCtx ->GetOptExpression () &&
+				if (pCtx ->GetOptExpression () &&
 					pRhs -> IsSimpleConstant () &&
 					pRhs -> GetInteger () == 1)
 				{
@@ -4018,28 +4055,28 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 					//
 
 					pTmp = pOut;
-					pOut = NscBuildPlusMinus (pLhs, FALSE, TRUE);
+					pOut = NscBuildPlusMinus (pCtx, pLhs, FALSE, TRUE);
 					pLhs = NULL;
 				}
 				else
 				{
-					NscPushAssignment (pOut, NscPCode_AsnSubtract, 
+					NscPushAssignment (pCtx, pOut, NscPCode_AsnSubtract, 
 						NscType_Integer, pLhs, pRhs);
 				}
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Float)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnSubtract, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnSubtract, 
 					NscType_Float, pLhs, pRhs);
 			}
 			else if (nLhsType == NscType_Float && nRhsType == NscType_Integer)
 			{
-				NscPushAssignment (pOut, NscPCode_AsnSubtract, 
+				NscPushAssignment (pCtx, pOut, NscPCode_AsnSubtract, 
 					NscType_Float, pLhs, pRhs);
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "-=");
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, "-=");
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -4050,12 +4087,12 @@ YYSTYPE NscBuildBinaryOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 asn_shift_operator:;
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				NscPushAssignment (pOut, nOp, 
+				NscPushAssignment (pCtx, pOut, nOp, 
 					NscType_Integer, pLhs, pRhs);
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, pszOp);
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, pszOp);
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -4076,12 +4113,12 @@ asn_shift_operator:;
 asn_bitwise_expression:;
 			if (nLhsType == NscType_Integer && nRhsType == NscType_Integer)
 			{
-				NscPushAssignment (pOut, nOp, 
+				NscPushAssignment (pCtx, pOut, nOp, 
 					NscType_Integer, pLhs, pRhs);
 			}
 			else
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, pszOp);
+				pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, pszOp);
 				pOut ->SetType (NscType_Error);
 			}
 			break;
@@ -4098,7 +4135,7 @@ asn_bitwise_expression:;
 
 		default:
 			assert (false);
-			g_pCtx ->GenerateMessage (NscMessage_ErrorInternalCompilerError,
+			pCtx ->GenerateMessage (NscMessage_ErrorInternalCompilerError,
 				"invalid binary operator");
 			pOut ->SetType (NscType_Error);
 			break;
@@ -4109,11 +4146,11 @@ asn_bitwise_expression:;
 	//
 
 	if (pLhs != NULL)
-		g_pCtx ->FreePStackEntry (pLhs);
+		pCtx ->FreePStackEntry (pLhs);
 	if (pRhs != NULL)
-		g_pCtx ->FreePStackEntry (pRhs);
+		pCtx ->FreePStackEntry (pRhs);
 	if (pTmp != NULL)
-		g_pCtx ->FreePStackEntry (pTmp);
+		pCtx ->FreePStackEntry (pTmp);
 
 	return pOut;
 }
@@ -4122,6 +4159,8 @@ asn_bitwise_expression:;
 //
 // @func Build a logical operator
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nToken | Operator token
 //
 // @parm YYSTYPE | pLhs | Left hand side
@@ -4132,20 +4171,20 @@ asn_bitwise_expression:;
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildLogicalOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
+YYSTYPE NscBuildLogicalOp (CNscContext *pCtx, int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pLhs)
-			g_pCtx ->FreePStackEntry (pLhs);
+			pCtx ->FreePStackEntry (pLhs);
 		if (pRhs)
-			g_pCtx ->FreePStackEntry (pRhs);
+			pCtx ->FreePStackEntry (pRhs);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -4206,7 +4245,7 @@ YYSTYPE NscBuildLogicalOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 
 			int nLhsConstant = -1;
 			int nRhsConstant = -1;
-			if (g_pCtx ->GetOptExpression ())
+			if (pCtx ->GetOptExpression ())
 			{
 				if (pLhs ->IsSimpleConstant ())
 					nLhsConstant = pLhs ->GetInteger () != 0 ? 1 : 0;
@@ -4263,7 +4302,7 @@ YYSTYPE NscBuildLogicalOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 		}
 		else
 		{
-			g_pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, pszOp);
+			pCtx ->GenerateMessage (NscMessage_ErrorOperatorTypeMismatch, pszOp);
 			pOut ->SetType (NscType_Error);
 		}
 	}
@@ -4272,8 +4311,8 @@ YYSTYPE NscBuildLogicalOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 	// Rundown
 	//
 
-    g_pCtx ->FreePStackEntry (pLhs);
-    g_pCtx ->FreePStackEntry (pRhs);
+    pCtx ->FreePStackEntry (pLhs);
+    pCtx ->FreePStackEntry (pRhs);
 	return pOut;
 }
 
@@ -4281,6 +4320,8 @@ YYSTYPE NscBuildLogicalOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 //
 // @func Build an expression
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pExpression | Expression
 //
 // @parm YYSTYPE | pAssignment | New assignment
@@ -4289,7 +4330,7 @@ YYSTYPE NscBuildLogicalOp (int nToken, YYSTYPE pLhs, YYSTYPE pRhs)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildExpression (YYSTYPE pExpression, YYSTYPE pAssignment)
+YYSTYPE NscBuildExpression (CNscContext *pCtx, YYSTYPE pExpression, YYSTYPE pAssignment)
 {
 
 	//
@@ -4305,7 +4346,7 @@ YYSTYPE NscBuildExpression (YYSTYPE pExpression, YYSTYPE pAssignment)
 
 	if (pOut == NULL)
 	{
-		pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+		pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 		pOut ->SetType (NscType_Unknown);
 	}
 
@@ -4313,10 +4354,10 @@ YYSTYPE NscBuildExpression (YYSTYPE pExpression, YYSTYPE pAssignment)
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pAssignment)
-			g_pCtx ->FreePStackEntry (pAssignment);
+			pCtx ->FreePStackEntry (pAssignment);
 		return pOut;
 	}
 	
@@ -4327,7 +4368,7 @@ YYSTYPE NscBuildExpression (YYSTYPE pExpression, YYSTYPE pAssignment)
 	pOut ->SetType (pAssignment ->GetType ());
 	pOut ->AppendData (pAssignment);
 	pOut ->SetFlags (pOut ->GetFlags () | NscSymFlag_InExpression);
-	g_pCtx ->FreePStackEntry (pAssignment);
+	pCtx ->FreePStackEntry (pAssignment);
 
 	//
 	// Return the new expression
@@ -4340,6 +4381,8 @@ YYSTYPE NscBuildExpression (YYSTYPE pExpression, YYSTYPE pAssignment)
 //
 // @func Build a structure element access
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pStruct | Structure 
 //
 // @parm YYSTYPE | pElement | Element (must be id of some type)
@@ -4348,20 +4391,20 @@ YYSTYPE NscBuildExpression (YYSTYPE pExpression, YYSTYPE pAssignment)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement)
+YYSTYPE NscBuildElementAccess (CNscContext *pCtx, YYSTYPE pStruct, YYSTYPE pElement)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pStruct)
-			g_pCtx ->FreePStackEntry (pStruct);
+			pCtx ->FreePStackEntry (pStruct);
 		if (pElement)
-			g_pCtx ->FreePStackEntry (pElement);
+			pCtx ->FreePStackEntry (pElement);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -4391,14 +4434,14 @@ YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement)
 		if (pStruct ->GetType () == NscType_Vector)
 		{
 			if (strcmp (pszName, "x") == 0)
-				NscPushElementAccess (pOut, pStruct, NscType_Float, 0);
+				NscPushElementAccess (pCtx, pOut, pStruct, NscType_Float, 0);
 			else if (strcmp (pszName, "y") == 0)
-				NscPushElementAccess (pOut, pStruct, NscType_Float, 1);
+				NscPushElementAccess (pCtx, pOut, pStruct, NscType_Float, 1);
 			else if (strcmp (pszName, "z") == 0)
-				NscPushElementAccess (pOut, pStruct, NscType_Float, 2);
+				NscPushElementAccess (pCtx, pOut, pStruct, NscType_Float, 2);
 			else
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorElementNotMemberOfStructure, pszName);
 				pOut ->SetType (NscType_Error);
 			}
@@ -4408,16 +4451,16 @@ YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement)
 		// If this is a structure
 		//
 
-		else if (g_pCtx ->IsStructure (pStruct ->GetType ()))
+		else if (pCtx ->IsStructure (pStruct ->GetType ()))
 		{
 
 			//
 			// Loop through the values in the structure
 			//
 
-			NscSymbol *pSymbol = g_pCtx ->GetStructSymbol (
+			NscSymbol *pSymbol = pCtx ->GetStructSymbol (
 				pStruct ->GetType ());
-			unsigned char *pauchData = g_pCtx ->GetSymbolData (pSymbol ->nExtra);
+			unsigned char *pauchData = pCtx ->GetSymbolData (pSymbol ->nExtra);
 			NscSymbolStructExtra *pExtra = (NscSymbolStructExtra *) pauchData;
 			pauchData += sizeof (NscSymbolStructExtra);
 			for (int nIndex = 0, nOffset = 0; 
@@ -4427,16 +4470,16 @@ YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement)
 				assert (p ->nOpCode == NscPCode_Declaration);
 				if (strcmp (p ->szString, pszName) == 0)
 				{
-					NscPushElementAccess (pOut, pStruct, 
+					NscPushElementAccess (pCtx, pOut, pStruct, 
 						p ->nType, nOffset);
 					break;
 				}	
-				nOffset += g_pCtx ->GetTypeSize (p ->nType);
+				nOffset += pCtx ->GetTypeSize (p ->nType);
 				pauchData += p ->nOpSize;
 			}
 			if (pOut ->GetType () == NscType_Unknown)
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorElementNotMemberOfStructure, pszName);
 				pOut ->SetType (NscType_Error);
 			}
@@ -4448,7 +4491,7 @@ YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement)
 
 		else
 		{
-			g_pCtx ->GenerateMessage (NscMessage_ErrorInvalidAccessOfValAsStruct);
+			pCtx ->GenerateMessage (NscMessage_ErrorInvalidAccessOfValAsStruct);
 			pOut ->SetType (NscType_Error);
 		}
 	}
@@ -4457,8 +4500,8 @@ YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement)
 	// Rundown
 	//
 
-    g_pCtx ->FreePStackEntry (pStruct);
-    g_pCtx ->FreePStackEntry (pElement);
+    pCtx ->FreePStackEntry (pStruct);
+    pCtx ->FreePStackEntry (pElement);
 	return pOut;
 }
 
@@ -4466,6 +4509,8 @@ YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement)
 //
 // @func Build a function call
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pFn | Function identifier pointer
 //
 // @parm YYSTYPE | pArgList | Argument list
@@ -4474,20 +4519,20 @@ YYSTYPE NscBuildElementAccess (YYSTYPE pStruct, YYSTYPE pElement)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
+YYSTYPE NscBuildCall (CNscContext *pCtx, YYSTYPE pFn, YYSTYPE pArgList)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 	
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pFn)
-			g_pCtx ->FreePStackEntry (pFn);
+			pCtx ->FreePStackEntry (pFn);
 		if (pArgList)
-			g_pCtx ->FreePStackEntry (pArgList);
+			pCtx ->FreePStackEntry (pArgList);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -4497,7 +4542,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 	//
 
 	assert (pFn);
-	NscSymbol *pSymbol = g_pCtx ->FindDeclSymbol (
+	NscSymbol *pSymbol = pCtx ->FindDeclSymbol (
 		pFn ->GetIdentifier ());
 	
 	//
@@ -4506,7 +4551,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 
 	if (pSymbol == NULL)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorUndeclaredIdentifier,
+		pCtx ->GenerateMessage (NscMessage_ErrorUndeclaredIdentifier,
 			pFn ->GetIdentifier ());
 		pOut ->SetType (NscType_Error);
 	}
@@ -4517,7 +4562,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 
 	else if (pSymbol ->nSymType != NscSymType_Function)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorCantInvokeIdentAsFunction,
+		pCtx ->GenerateMessage (NscMessage_ErrorCantInvokeIdentAsFunction,
 			pFn ->GetIdentifier ());
 		pOut ->SetType (NscType_Error);
 	}
@@ -4549,7 +4594,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 		//
 
 		int nArgCount = 0;
-		unsigned char *pauchFnData = g_pCtx ->GetSymbolData (pSymbol ->nExtra);
+		unsigned char *pauchFnData = pCtx ->GetSymbolData (pSymbol ->nExtra);
 		NscSymbolFunctionExtra *pfnExtra = (NscSymbolFunctionExtra *) pauchFnData;
 		int nFnArgCount = pfnExtra ->nArgCount;
 		pauchFnData += sizeof (NscSymbolFunctionExtra);
@@ -4615,7 +4660,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 
 				if (fIsBad)
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorFunctionArgTypeMismatch,
+					pCtx ->GenerateMessage (NscMessage_ErrorFunctionArgTypeMismatch,
 						pFn ->GetIdentifier (), p2 ->szString, nArgCount,
 						p2 ->nType, p1 ->nType);
 					pOut ->SetType (NscType_Error);
@@ -4645,7 +4690,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 
 			if (pauchData < pauchEnd)
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorTooManyFunctionArgs,
+				pCtx ->GenerateMessage (NscMessage_ErrorTooManyFunctionArgs,
 					pFn ->GetIdentifier ());
 				pOut ->SetType (NscType_Error);
 			}
@@ -4687,7 +4732,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 
 					if (p2 ->nDataSize == 0)
 					{
-						g_pCtx ->GenerateMessage (NscMessage_ErrorRequiredFunctionArgMissing,
+						pCtx ->GenerateMessage (NscMessage_ErrorRequiredFunctionArgMissing,
 							p2 ->szString,
 							pFn ->GetIdentifier ());
 						pOut ->SetType (NscType_Error);
@@ -4709,7 +4754,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 				if (nFnArgCount <= 0)
 				{
 					pOut ->PushCall (pSymbol ->nType, 
-						g_pCtx ->GetSymbolOffset (pSymbol), 
+						pCtx ->GetSymbolOffset (pSymbol), 
 						nArgCount, pauchStartData, nDataSize);
 					pOut ->SetType (pSymbol ->nType);
 				}
@@ -4728,9 +4773,9 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 	// Rundown
 	//
 
-	g_pCtx ->FreePStackEntry (pFn);
+	pCtx ->FreePStackEntry (pFn);
 	if (pArgList)
-		g_pCtx ->FreePStackEntry (pArgList);
+		pCtx ->FreePStackEntry (pArgList);
 	return pOut;
 }
 
@@ -4738,6 +4783,8 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 //
 // @func Build an argument list
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pList | Argument list
 //
 // @parm YYSTYPE | pArg | New argument
@@ -4746,7 +4793,7 @@ YYSTYPE NscBuildCall (YYSTYPE pFn, YYSTYPE pArgList)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildArgExpList (YYSTYPE pList, YYSTYPE pArg)
+YYSTYPE NscBuildArgExpList (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pArg)
 {
 	CNscPStackEntry *pOut = pList;
 
@@ -4756,7 +4803,7 @@ YYSTYPE NscBuildArgExpList (YYSTYPE pList, YYSTYPE pArg)
 
 	if (pOut == NULL)
 	{
-		pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+		pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 		pOut ->SetType (NscType_Unknown);
 	}
 
@@ -4764,10 +4811,10 @@ YYSTYPE NscBuildArgExpList (YYSTYPE pList, YYSTYPE pArg)
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pArg)
-			g_pCtx ->FreePStackEntry (pArg);
+			pCtx ->FreePStackEntry (pArg);
 		return pOut;
 	}
 	
@@ -4785,7 +4832,7 @@ YYSTYPE NscBuildArgExpList (YYSTYPE pList, YYSTYPE pArg)
 		else
 			pOut ->SetType (NscType_Error);
 	}
-    g_pCtx ->FreePStackEntry (pArg);
+    pCtx ->FreePStackEntry (pArg);
 
 	//
 	// Return the new argument list
@@ -4798,6 +4845,8 @@ YYSTYPE NscBuildArgExpList (YYSTYPE pList, YYSTYPE pArg)
 //
 // @func Build translation list 
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pList | Translation list
 //
 // @parm YYSTYPE | pTranslation | Translation
@@ -4806,7 +4855,7 @@ YYSTYPE NscBuildArgExpList (YYSTYPE pList, YYSTYPE pArg)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildTranslation (YYSTYPE pList, YYSTYPE pTranslation)
+YYSTYPE NscBuildTranslation (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pTranslation)
 {
 	pList;
 
@@ -4815,7 +4864,7 @@ YYSTYPE NscBuildTranslation (YYSTYPE pList, YYSTYPE pTranslation)
 	//
 
 	if (pTranslation)
-        g_pCtx ->FreePStackEntry (pTranslation);
+        pCtx ->FreePStackEntry (pTranslation);
 
 	//
 	// Return the new expression
@@ -4828,6 +4877,8 @@ YYSTYPE NscBuildTranslation (YYSTYPE pList, YYSTYPE pTranslation)
 //
 // @func Build a conditional expression
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pSelect | Selection expression
 //
 // @parm YYSTYPE | p1 | Expression #1
@@ -4838,22 +4889,22 @@ YYSTYPE NscBuildTranslation (YYSTYPE pList, YYSTYPE pTranslation)
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildConditional (YYSTYPE pSelect, YYSTYPE p1, YYSTYPE p2)
+YYSTYPE NscBuildConditional (CNscContext *pCtx, YYSTYPE pSelect, YYSTYPE p1, YYSTYPE p2)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pSelect)
-			g_pCtx ->FreePStackEntry (pSelect);
+			pCtx ->FreePStackEntry (pSelect);
 		if (p1)
-			g_pCtx ->FreePStackEntry (p1);
+			pCtx ->FreePStackEntry (p1);
 		if (p2)
-			g_pCtx ->FreePStackEntry (p2);
+			pCtx ->FreePStackEntry (p2);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -4875,12 +4926,12 @@ YYSTYPE NscBuildConditional (YYSTYPE pSelect, YYSTYPE p1, YYSTYPE p2)
 
 	else if (pSelect ->GetType () != NscType_Integer)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorConditionalRequiresInt);
+		pCtx ->GenerateMessage (NscMessage_ErrorConditionalRequiresInt);
 		pOut ->SetType (NscType_Error);
 	}
 	else if (p1 ->GetType () != p2 ->GetType ())
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorConditionalResultTypesBad);
+		pCtx ->GenerateMessage (NscMessage_ErrorConditionalResultTypesBad);
 		pOut ->SetType (NscType_Error);
 	}
 
@@ -4890,9 +4941,9 @@ YYSTYPE NscBuildConditional (YYSTYPE pSelect, YYSTYPE p1, YYSTYPE p2)
 
 	else
 	{
-		CNsc5BlockHelper sBlock2 (pSelect, NULL, 1);
-		CNsc5BlockHelper sBlock4 (p1, NULL, 3);
-		CNsc5BlockHelper sBlock5 (p2, NULL, 4);
+		CNsc5BlockHelper sBlock2 (pCtx, pSelect, NULL, 1);
+		CNsc5BlockHelper sBlock4 (pCtx, p1, NULL, 3);
+		CNsc5BlockHelper sBlock5 (pCtx, p2, NULL, 4);
 
 		pOut ->SetType (p1 ->GetType ());
 		pOut ->Push5Block (NscPCode_Conditional, p1 ->GetType (),
@@ -4907,9 +4958,9 @@ YYSTYPE NscBuildConditional (YYSTYPE pSelect, YYSTYPE p1, YYSTYPE p2)
 	// Return results
 	//
 
-	g_pCtx ->FreePStackEntry (pSelect);
-	g_pCtx ->FreePStackEntry (p1);
-	g_pCtx ->FreePStackEntry (p2);
+	pCtx ->FreePStackEntry (pSelect);
+	pCtx ->FreePStackEntry (p1);
+	pCtx ->FreePStackEntry (p2);
 	return pOut;
 }
 
@@ -4917,11 +4968,13 @@ YYSTYPE NscBuildConditional (YYSTYPE pSelect, YYSTYPE p1, YYSTYPE p2)
 //
 // @func Build a statement fence
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildStatementFence ()
+YYSTYPE NscBuildStatementFence (CNscContext *pCtx)
 {
 	CNscPStackEntry *pOut;
 
@@ -4929,7 +4982,7 @@ YYSTYPE NscBuildStatementFence ()
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		pOut = NULL;
 	}
@@ -4940,7 +4993,7 @@ YYSTYPE NscBuildStatementFence ()
 
 	else
 	{
-		pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+		pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 		pOut ->SetType (NscType_Unknown);
 
 		//
@@ -4950,15 +5003,15 @@ YYSTYPE NscBuildStatementFence ()
 		// own fence and need the '{}' to not create their's.
 		//
 
-		NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+		NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 		if (pFence == NULL)
-            NscPushFence (pOut, NULL, NscFenceType_Scope, false);
+            NscPushFence (pCtx, pOut, NULL, NscFenceType_Scope, false);
 		else
 		{
 			if (pFence ->fEatScope)
 				pFence ->fEatScope = false;
 			else
-	            NscPushFence (pOut, NULL, NscFenceType_Scope, false);
+	            NscPushFence (pCtx, pOut, NULL, NscFenceType_Scope, false);
 		}
 	}
 	return pOut;
@@ -4968,6 +5021,8 @@ YYSTYPE NscBuildStatementFence ()
 //
 // @func Build a statement
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pList | Current statement list (can be NULL)
 //
 // @parm YYSTYPE | pStatement | Statement to be added (can be NULL)
@@ -4978,7 +5033,7 @@ YYSTYPE NscBuildStatementFence ()
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildStatement (YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence)
+YYSTYPE NscBuildStatement (CNscContext *pCtx, YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence)
 {
 
 	//
@@ -4987,7 +5042,7 @@ YYSTYPE NscBuildStatement (YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence)
 
 	CNscPStackEntry *pOut = pList;
 	if (pOut == NULL)
-		pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+		pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 
 	//
@@ -4995,7 +5050,7 @@ YYSTYPE NscBuildStatement (YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence)
 	//
 
 	NscType nOutType;
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		nOutType = NscType_Unknown;
 	}
@@ -5037,7 +5092,7 @@ YYSTYPE NscBuildStatement (YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence)
 			int nLocals = 0;
 			if (pFence)
 			{
-				NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+				NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 				nLocals = pFence ->nLocals;
 			}
 
@@ -5089,8 +5144,8 @@ YYSTYPE NscBuildStatement (YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence)
 
 	if (pFence != NULL)
 	{
-		g_pCtx ->RestoreFence (pFence);
-		g_pCtx ->FreePStackEntry (pFence);
+		pCtx ->RestoreFence (pFence);
+		pCtx ->FreePStackEntry (pFence);
 	}
 
 	//
@@ -5098,7 +5153,7 @@ YYSTYPE NscBuildStatement (YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence)
 	//
 
 	if (pStatement)
-        g_pCtx ->FreePStackEntry (pStatement);
+        pCtx ->FreePStackEntry (pStatement);
 	return pOut;
 }
 
@@ -5106,33 +5161,37 @@ YYSTYPE NscBuildStatement (YYSTYPE pList, YYSTYPE pStatement, YYSTYPE pFence)
 //
 // @func Build a blank statement that might be an error
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildBlankStatement ()
+YYSTYPE NscBuildBlankStatement (CNscContext *pCtx)
 {
 
 	//
 	// Issue the warning in phase2
 	//
 
-	if (g_pCtx ->IsPhase2 ())
+	if (pCtx ->IsPhase2 ())
 	{
-		g_pCtx ->GenerateMessage (NscMessage_WarningEmptyControlStatement);
+		pCtx ->GenerateMessage (NscMessage_WarningEmptyControlStatement);
 	}
 
 	//
 	// Invoke the helper
 	//
 
-	return NscBuildStatement (NULL, NULL, NULL);
+	return NscBuildStatement (pCtx, NULL, NULL, NULL);
 }
 
 //-----------------------------------------------------------------------------
 //
 // @func Build a 5 block statement
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nToken | Token of the statement
 //
 // @parm YYSTYPE | pPrev | Pointer to 5 block used to start this block
@@ -5154,29 +5213,29 @@ YYSTYPE NscBuildBlankStatement ()
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
+YYSTYPE NscBuild5Block (CNscContext *pCtx, int nToken, YYSTYPE pPrev, int nAddFence,
 	YYSTYPE pInit, YYSTYPE pCond, YYSTYPE pInc, YYSTYPE pTrue, YYSTYPE pFalse)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pPrev)
-			g_pCtx ->FreePStackEntry (pPrev);
+			pCtx ->FreePStackEntry (pPrev);
 		if (pInit)
-			g_pCtx ->FreePStackEntry (pInit);
+			pCtx ->FreePStackEntry (pInit);
 		if (pCond)
-			g_pCtx ->FreePStackEntry (pCond);
+			pCtx ->FreePStackEntry (pCond);
 		if (pInc)
-			g_pCtx ->FreePStackEntry (pInc);
+			pCtx ->FreePStackEntry (pInc);
 		if (pTrue)
-			g_pCtx ->FreePStackEntry (pTrue);
+			pCtx ->FreePStackEntry (pTrue);
 		if (pFalse)
-			g_pCtx ->FreePStackEntry (pFalse);
+			pCtx ->FreePStackEntry (pFalse);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -5249,9 +5308,9 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 	bool fHadReturn = false;
 	if (pPrev)
 	{
-		NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+		NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 		fHadReturn = pFence ->nFenceReturn == NscFenceReturn_Yes;
-		g_pCtx ->RestoreFence (pPrev);
+		pCtx ->RestoreFence (pPrev);
 	}
 
 	//
@@ -5265,7 +5324,7 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 		// Create the new fence
 		//
 
-		NscPushFence (pOut, NULL, nFenceType, true);
+		NscPushFence (pCtx, pOut, NULL, nFenceType, true);
 
 		//
 		// Switches maintain the test value on the stack
@@ -5275,7 +5334,7 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 
 		if (nToken == SWITCH)
 		{
-			NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+			NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 			pFence ->nPrevLocals++;
 
 			//
@@ -5285,7 +5344,7 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 			// detect this condition then issue a warning about it.
 			//
 
-			if (g_pCtx ->GetWarnSwitchInDoWhileBug ())
+			if (pCtx ->GetWarnSwitchInDoWhileBug ())
 			{
 				pFence = pFence ->pNext;
 
@@ -5294,7 +5353,7 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 
 				if (pFence != NULL && pFence ->nFenceType == NscFenceType_Do)
 				{
-					g_pCtx ->GenerateMessage (NscMessage_WarningSwitchInDoWhile);
+					pCtx ->GenerateMessage (NscMessage_WarningSwitchInDoWhile);
 				}
 
 			}
@@ -5305,7 +5364,7 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 		//
 
 		if (pPrev && !fHadReturn)
-			NscSetFenceReturn (false);
+			NscSetFenceReturn (pCtx, false);
 	}
 
 	//
@@ -5316,23 +5375,23 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 	if (nToken == IF && pFalse)
 	{
 		if (fHadReturn)
-			NscSetFenceReturn (true);
+			NscSetFenceReturn (pCtx, true);
 	}
 
 	//
 	// If we are to check for non-integer types on for expressions
 	//
 
-	if (nToken == FOR && g_pCtx ->GetWarnOnNonIntForExpressions ())
+	if (nToken == FOR && pCtx ->GetWarnOnNonIntForExpressions ())
 	{
 		if (pInc != NULL && pInc ->GetType () != NscType_Integer)
 		{
-			g_pCtx ->GenerateMessage (NscMessage_WarningForIncNotIntegralType);
+			pCtx ->GenerateMessage (NscMessage_WarningForIncNotIntegralType);
 		}
 
 		if (pInit != NULL && pInit ->GetType () != NscType_Integer)
 		{
-			g_pCtx ->GenerateMessage (NscMessage_WarningForInitNotIntegralType);
+			pCtx ->GenerateMessage (NscMessage_WarningForInitNotIntegralType);
 		}
 	}
 
@@ -5373,11 +5432,11 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 		// Get the 5 blocks of data
 		//
 
-		CNsc5BlockHelper sBlock1 (pInit,  p5Block, 0);
-		CNsc5BlockHelper sBlock2 (pCond,  p5Block, 1);
-		CNsc5BlockHelper sBlock3 (pInc,   p5Block, 2);
-		CNsc5BlockHelper sBlock4 (pTrue,  p5Block, 3);
-		CNsc5BlockHelper sBlock5 (pFalse, p5Block, 4);
+		CNsc5BlockHelper sBlock1 (pCtx, pInit,  p5Block, 0);
+		CNsc5BlockHelper sBlock2 (pCtx, pCond,  p5Block, 1);
+		CNsc5BlockHelper sBlock3 (pCtx, pInc,   p5Block, 2);
+		CNsc5BlockHelper sBlock4 (pCtx, pTrue,  p5Block, 3);
+		CNsc5BlockHelper sBlock5 (pCtx, pFalse, p5Block, 4);
 
 		//
 		// If we should test the conditional
@@ -5394,7 +5453,7 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 			{
 				if (pCond == NULL || pCond ->GetType () != NscType_Integer)
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorConditionalTokenRequiresInt, pszToken);
 					pOut ->SetType (NscType_Error);
 				}
@@ -5414,8 +5473,8 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 
 			if (nPCode == NscPCode_For && pPrev == NULL)
 			{
-				sBlock1 .m_nFile = g_pCtx ->GetFile (0);
-				sBlock1 .m_nLine = g_pCtx ->GetLine (0);
+				sBlock1 .m_nFile = pCtx ->GetFile (0);
+				sBlock1 .m_nLine = pCtx ->GetLine (0);
 			}
 
 			//
@@ -5442,17 +5501,17 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 	//
 
 	if (pPrev)
-        g_pCtx ->FreePStackEntry (pPrev);
+        pCtx ->FreePStackEntry (pPrev);
 	if (pInit)
-        g_pCtx ->FreePStackEntry (pInit);
+        pCtx ->FreePStackEntry (pInit);
 	if (pCond)
-        g_pCtx ->FreePStackEntry (pCond);
+        pCtx ->FreePStackEntry (pCond);
 	if (pInc)
-        g_pCtx ->FreePStackEntry (pInc);
+        pCtx ->FreePStackEntry (pInc);
 	if (pTrue)
-        g_pCtx ->FreePStackEntry (pTrue);
+        pCtx ->FreePStackEntry (pTrue);
 	if (pFalse)
-        g_pCtx ->FreePStackEntry (pFalse);
+        pCtx ->FreePStackEntry (pFalse);
 	return pOut;
 }
 
@@ -5460,6 +5519,8 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 //
 // @func Build a case statement
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nToken | Token of the statement
 //
 // @parm YYSTYPE | pCond | Conditional statement
@@ -5468,18 +5529,18 @@ YYSTYPE NscBuild5Block (int nToken, YYSTYPE pPrev, int nAddFence,
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
+YYSTYPE NscBuildCase (CNscContext *pCtx, int nToken, YYSTYPE pCond)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pCond)
-			g_pCtx ->FreePStackEntry (pCond);
+			pCtx ->FreePStackEntry (pCond);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -5525,7 +5586,7 @@ YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
 
 			if (pCond == NULL || pCond ->GetType () != NscType_Integer)
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorConditionalTokenRequiresInt,
 					"case");
 				pOut ->SetType (NscType_Error);
@@ -5553,7 +5614,7 @@ YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
 
 				if (!CNscPStackEntry::IsSimpleConstant (pauchCond, nCondSize))
 				{
-					g_pCtx ->GenerateMessage (NscMessage_ErrorCaseValueNotConstant);
+					pCtx ->GenerateMessage (NscMessage_ErrorCaseValueNotConstant);
 					pOut ->SetType (NscType_Error);
 				}
 			}
@@ -5570,12 +5631,12 @@ YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
 			// Validate that the case or default is in a proper scope
 			//
 
-			NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+			NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 			while (pFence && pFence ->nFenceType == NscFenceType_Scope)
 				pFence = pFence ->pNext;
 			if (pFence == NULL || pFence ->nFenceType != NscFenceType_Switch)
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_WarningCaseDefaultOutsideSwitch);
 				goto no_switch_fence;
 				//pOut ->SetType (NscType_Error);
@@ -5584,7 +5645,7 @@ YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
 			{
 				if (pFence ->nLocals != 0)
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorDeclarationSkippedByToken,
 						(nToken == DEFAULT) ? "default" : "case");
 
@@ -5599,7 +5660,7 @@ YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
 			{
 				if (pFence ->fHasDefault)
 				{
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorMultipleDefaultLabels);
 					pOut ->SetType (NscType_Error);
 				}
@@ -5620,7 +5681,7 @@ YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
 					pFence ->pSwitchCasesUsed ->end (),
 					nCaseValue) != pFence ->pSwitchCasesUsed ->end ()) {
 
-					g_pCtx ->GenerateMessage (
+					pCtx ->GenerateMessage (
 						NscMessage_ErrorDuplicateCaseValue,
 						nCaseValue);
 				}
@@ -5651,7 +5712,7 @@ YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
 				assert (false);
 			}
 			pOut ->PushCase (nPCode, pauchCond, nCondSize,
-				g_pCtx ->GetFile (0), g_pCtx ->GetLine (0));
+				pCtx ->GetFile (0), pCtx ->GetLine (0));
 
 			//
 			// Set the return type
@@ -5667,7 +5728,7 @@ YYSTYPE NscBuildCase (int nToken, YYSTYPE pCond)
 
 no_switch_fence:
 	if (pCond)
-        g_pCtx ->FreePStackEntry (pCond);
+        pCtx ->FreePStackEntry (pCond);
 	return pOut;
 }
 
@@ -5675,24 +5736,26 @@ no_switch_fence:
 //
 // @func Build a return
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pReturn | Return value
 //
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildReturn (YYSTYPE pReturn)
+YYSTYPE NscBuildReturn (CNscContext *pCtx, YYSTYPE pReturn)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pReturn)
-			g_pCtx ->FreePStackEntry (pReturn);
+			pCtx ->FreePStackEntry (pReturn);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -5739,29 +5802,29 @@ YYSTYPE NscBuildReturn (YYSTYPE pReturn)
 		// Get the return type of the function
 		//
 
-		NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+		NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 		while (pFence && pFence ->nFnSymbol == 0)
 			pFence = pFence ->pNext;
 		if (pFence)
 		{
-			NscSymbol *pSymbol = g_pCtx ->GetSymbol (pFence ->nFnSymbol);
+			NscSymbol *pSymbol = pCtx ->GetSymbol (pFence ->nFnSymbol);
 			if (pSymbol ->nType != NscType_Void && nType == NscType_Unknown)
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorReturnValueExpected);
+				pCtx ->GenerateMessage (NscMessage_ErrorReturnValueExpected);
 			}
 			else if (pSymbol ->nType == NscType_Void && nType != NscType_Unknown)
 			{
-				g_pCtx ->GenerateMessage (
+				pCtx ->GenerateMessage (
 					NscMessage_ErrorReturnValueIllegalOnVoidFn);
 			}
 			else if (pSymbol ->nType != NscType_Void && nType != pSymbol ->nType)
 			{
-				g_pCtx ->GenerateMessage (NscMessage_ErrorTypeMismatchOnReturn);
+				pCtx ->GenerateMessage (NscMessage_ErrorTypeMismatchOnReturn);
 			}
 		}
 		else
 		{
-			g_pCtx ->GenerateMessage (NscMessage_ErrorReturnOutsideFunction);
+			pCtx ->GenerateMessage (NscMessage_ErrorReturnOutsideFunction);
 		}
 
 		//
@@ -5769,7 +5832,7 @@ YYSTYPE NscBuildReturn (YYSTYPE pReturn)
 		//
 
 		pOut ->PushReturn (nType, pauchData, nDataSize);
-		if (g_pCtx ->GetOptReturn ())
+		if (pCtx ->GetOptReturn ())
         	pOut ->SetType (NscType_Unknown);
 		else
         	pOut ->SetType (nType);
@@ -5778,7 +5841,7 @@ YYSTYPE NscBuildReturn (YYSTYPE pReturn)
 		// Set the fence
 		//
 
-		NscSetFenceReturn (true);
+		NscSetFenceReturn (pCtx, true);
 	}
 
 	//
@@ -5786,7 +5849,7 @@ YYSTYPE NscBuildReturn (YYSTYPE pReturn)
 	//
 
 	if (pReturn)
-        g_pCtx ->FreePStackEntry (pReturn);
+        pCtx ->FreePStackEntry (pReturn);
 	return pOut;
 }
 
@@ -5794,21 +5857,23 @@ YYSTYPE NscBuildReturn (YYSTYPE pReturn)
 //
 // @func Build a break/continue statement
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nToken | Token of the statement
 //
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildBreakContinue (int nToken)
+YYSTYPE NscBuildBreakContinue (CNscContext *pCtx, int nToken)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
@@ -5833,7 +5898,7 @@ YYSTYPE NscBuildBreakContinue (int nToken)
 	// Validate the scope
 	//
 
-	NscSymbolFence *pFence = g_pCtx ->GetCurrentFence ();
+	NscSymbolFence *pFence = pCtx ->GetCurrentFence ();
 	while (pFence)
 	{
 		if ((pFence ->nFenceType == NscFenceType_Switch && nToken == BREAK) ||
@@ -5847,11 +5912,11 @@ YYSTYPE NscBuildBreakContinue (int nToken)
 	{
 		if (nToken == BREAK)
 		{
-            g_pCtx ->GenerateMessage (NscMessage_ErrorInvalidUseOfBreak);
+            pCtx ->GenerateMessage (NscMessage_ErrorInvalidUseOfBreak);
 		}
 		else if (nToken == CONTINUE)
 		{
-            g_pCtx ->GenerateMessage (NscMessage_ErrorInvalidUseOfContinue);
+            pCtx ->GenerateMessage (NscMessage_ErrorInvalidUseOfContinue);
 		}
 		pOut ->SetType (NscType_Error);
 	}
@@ -5872,24 +5937,26 @@ YYSTYPE NscBuildBreakContinue (int nToken)
 //
 // @func Build an identifier
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm YYSTYPE | pId | Pointer to entry
 //
 // @rdesc Pointer to a new parser stack entry.
 //
 //-----------------------------------------------------------------------------
 
-YYSTYPE NscBuildIdentifier (YYSTYPE pId)
+YYSTYPE NscBuildIdentifier (CNscContext *pCtx, YYSTYPE pId)
 {
-	CNscPStackEntry *pOut = g_pCtx ->GetPStackEntry (__FILE__, __LINE__);
+	CNscPStackEntry *pOut = pCtx ->GetPStackEntry (__FILE__, __LINE__);
 
 	//
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		if (pId)
-			g_pCtx ->FreePStackEntry (pId);
+			pCtx ->FreePStackEntry (pId);
 		pOut ->SetType (NscType_Unknown);
 		return pOut;
 	}
@@ -5898,7 +5965,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 	// Search for the identifier
 	//
 
-	NscSymbol *pSymbol = g_pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
+	NscSymbol *pSymbol = pCtx ->FindDeclSymbol (pId ->GetIdentifier ());
 	
 	//
 	// If the identifier wasn't found
@@ -5906,7 +5973,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 
 	if (pSymbol == NULL)
 	{
-		g_pCtx ->GenerateMessage (NscMessage_ErrorUndeclaredIdentifier,
+		pCtx ->GenerateMessage (NscMessage_ErrorUndeclaredIdentifier,
 			pId ->GetIdentifier ());
 		pOut ->SetType (NscType_Error);
 	}
@@ -5927,7 +5994,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 		{
 			if ((pSymbol ->ulFlags & NscSymFlag_SelfReferenceDef) == 0)
 			{
-				g_pCtx ->GenerateMessage (NscMessage_WarningIdentUsedInInitializer,
+				pCtx ->GenerateMessage (NscMessage_WarningIdentUsedInInitializer,
 					pSymbol ->szString);
 				pSymbol ->ulFlags |= NscSymFlag_SelfReferenceDef;
 			}
@@ -5939,7 +6006,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 
 		if (pSymbol ->nSymType == NscSymType_Function)
 		{
-			g_pCtx ->GenerateMessage (NscMessage_ErrorInvalidUseOfFunction,
+			pCtx ->GenerateMessage (NscMessage_ErrorInvalidUseOfFunction,
 				pId ->GetIdentifier ());
 			pOut ->SetType (NscType_Error);
 		}
@@ -5950,7 +6017,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 
 		else if (pSymbol ->nSymType == NscSymType_Structure)
 		{
-			g_pCtx ->GenerateMessage (NscMessage_ErrorInvalidUseOfStructure,
+			pCtx ->GenerateMessage (NscMessage_ErrorInvalidUseOfStructure,
 				pId ->GetIdentifier ());
 			pOut ->SetType (NscType_Error);
 		}
@@ -5967,7 +6034,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 			// Get the symbol offset
 			//
 
-			size_t nSymbol = g_pCtx ->GetSymbolOffset (pSymbol);
+			size_t nSymbol = pCtx ->GetSymbolOffset (pSymbol);
 
 			//
 			// If the symbol is a constant, then copy the initialization
@@ -5976,7 +6043,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 
 			if ((pSymbol ->ulFlags & NscSymFlag_Constant) != 0)
 			{
-				unsigned char *pauchInit = g_pCtx ->GetSymbolData (pSymbol ->nExtra);
+				unsigned char *pauchInit = pCtx ->GetSymbolData (pSymbol ->nExtra);
 				NscSymbolVariableExtra *pExtra = (NscSymbolVariableExtra *) pauchInit;
 				pauchInit += sizeof (NscSymbolVariableExtra);
 				pOut ->AppendData (pauchInit, pExtra ->nInitSize);
@@ -6021,7 +6088,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 	// Delete the input entry
 	//
 
-	g_pCtx ->FreePStackEntry (pId);
+	pCtx ->FreePStackEntry (pId);
 	return pOut;
 }
 
@@ -6029,6 +6096,8 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 //
 // @func Build a line operator
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nIndex | Source index for the file/line information
 //
 // @parm YYSTYPE | pStatement | Current statement
@@ -6037,9 +6106,7 @@ YYSTYPE NscBuildIdentifier (YYSTYPE pId)
 //
 //-----------------------------------------------------------------------------
 
-static int g_nFile;
-static int g_nLine;
-YYSTYPE NscBuildMarkLine (int nIndex, YYSTYPE pStatement)
+YYSTYPE NscBuildMarkLine (CNscContext *pCtx, int nIndex, YYSTYPE pStatement)
 {
 	//
 	// If the statement is NULL, then do a simple return
@@ -6052,7 +6119,7 @@ YYSTYPE NscBuildMarkLine (int nIndex, YYSTYPE pStatement)
 	// If this is phase1 and we are in a function, do nothing
 	//
 
-	if (!g_pCtx ->IsPhase2 () && !g_pCtx ->IsNWScript ())
+	if (!pCtx ->IsPhase2 () && !pCtx ->IsNWScript ())
 	{
 		return pStatement;
 	}
@@ -6071,8 +6138,8 @@ YYSTYPE NscBuildMarkLine (int nIndex, YYSTYPE pStatement)
 
 	else
 	{
-		pStatement ->PushLine (g_pCtx ->GetFile (nIndex), 
-			g_pCtx ->GetLine (nIndex));
+		pStatement ->PushLine (pCtx ->GetFile (nIndex), 
+			pCtx ->GetLine (nIndex));
 	}
 
 	//
@@ -6086,21 +6153,25 @@ YYSTYPE NscBuildMarkLine (int nIndex, YYSTYPE pStatement)
 //
 // @func Save the current file/line information
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nIndex | Source index for the file/line information
 //
 // @rdesc None.
 //
 //-----------------------------------------------------------------------------
 
-void NscBuildSaveLine (int nIndex)
+void NscBuildSaveLine (CNscContext *pCtx, int nIndex)
 {
-	g_pCtx ->SaveFileAndLine (nIndex);
+	pCtx ->SaveFileAndLine (nIndex);
 }
 
 //-----------------------------------------------------------------------------
 //
 // @func Copy the file and line information
 //
+// @parm CNscContext * | pCtx | Compiler context
+//
 // @parm int | nDesc | Destination index
 //
 // @parm int | nSource | Source index
@@ -6109,7 +6180,7 @@ void NscBuildSaveLine (int nIndex)
 //
 //-----------------------------------------------------------------------------
 
-void NscBuildCopyLine (int nDest, int nSource)
+void NscBuildCopyLine (CNscContext *pCtx, int nDest, int nSource)
 {
-	g_pCtx ->CopyFileAndLine (nDest, nSource);
+	pCtx ->CopyFileAndLine (nDest, nSource);
 }
@@ -0,0 +1,271 @@
+#ifndef ETS_NWNARENA_H
+#define ETS_NWNARENA_H
+
+//-----------------------------------------------------------------------------
+//
+// @doc
+//
+// @module	NwnArena.h - Bulk release memory arena |
+//
+// This module contains the definition of the memory arena used to hold the
+// transient allocations of a single compilation (parser stack entries, their
+// PCode buffers and identifiers).  Memory is carved out of large chunks in
+// an append-only fashion and is never freed individually; all chunks are
+// released together when the arena is reset or destroyed.
+//
+// Copyright (c) 2008-2011 - Ken Johnson (Skywing)
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Neither the name of Edward T. Smith nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// @end
+//
+// $History: NwnArena.h $
+//
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+//
+// Required include files
+//
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+//
+// Forward definitions
+//
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+//
+// Class definition
+//
+//-----------------------------------------------------------------------------
+
+class CNwnArena
+{
+    enum Constants
+	{
+		Default_Chunk_Size	= 0x10000,
+		Alignment			= 16,
+	};
+
+// @access Public types
+public:
+
+	struct Statistics
+	{
+		size_t				nAllocations;		// Number of Alloc calls
+		size_t				nExtensions;		// Number of in place extends
+		size_t				nBytesAllocated;	// Bytes handed out
+		size_t				nBytesReserved;		// Bytes held in chunks
+		size_t				nChunks;			// Number of chunks
+	};
+
+// @access Constructors and destructors
+public:
+
+	// @cmember General constructor
+
+	CNwnArena (size_t nChunkSize = Default_Chunk_Size)
+	{
+		m_pChunks = NULL;
+		m_pauchNext = NULL;
+		m_pauchEnd = NULL;
+		m_pauchLast = NULL;
+		m_nChunkSize = nChunkSize;
+		memset (&m_sStatistics, 0, sizeof (m_sStatistics));
+	}
+
+	// @cmember Release all of the chunks
+
+	~CNwnArena ()
+	{
+		Reset ();
+	}
+
+// @access Public methods
+public:
+
+	// @cmember Allocate a block of memory
+
+	void *Alloc (size_t nSize)
+	{
+		size_t nAligned = Align (nSize);
+
+		m_sStatistics .nAllocations++;
+		m_sStatistics .nBytesAllocated += nSize;
+
+		//
+		// Carve the block out of the current chunk if it fits
+		//
+
+		if ((size_t) (m_pauchEnd - m_pauchNext) >= nAligned)
+		{
+			m_pauchLast = m_pauchNext;
+			m_pauchNext += nAligned;
+			return m_pauchLast;
+		}
+
+		//
+		// Large blocks get a chunk of their own, which is linked behind the
+		// current chunk so that the space left in the current chunk is not
+		// abandoned
+		//
+
+		if (nAligned > m_nChunkSize / 4 && m_pChunks != NULL)
+		{
+			Chunk *pChunk = NewChunk (nAligned);
+			pChunk ->pNext = m_pChunks ->pNext;
+			m_pChunks ->pNext = pChunk;
+			return pChunk ->GetData ();
+		}
+
+		//
+		// Otherwise start a new current chunk
+		//
+
+		Chunk *pChunk = NewChunk (nAligned > m_nChunkSize ?
+			nAligned : m_nChunkSize);
+		pChunk ->pNext = m_pChunks;
+		m_pChunks = pChunk;
+		m_pauchLast = pChunk ->GetData ();
+		m_pauchNext = m_pauchLast + nAligned;
+		m_pauchEnd = m_pauchLast + pChunk ->nSize;
+		return m_pauchLast;
+	}
+
+	// @cmember Try to grow the most recent block in place
+
+	bool Extend (void *pData, size_t nOldSize, size_t nNewSize)
+	{
+		if (pData != m_pauchLast || nNewSize < nOldSize)
+			return false;
+		if ((size_t) (m_pauchEnd - m_pauchLast) < Align (nNewSize))
+			return false;
+		m_pauchNext = m_pauchLast + Align (nNewSize);
+		m_sStatistics .nExtensions++;
+		m_sStatistics .nBytesAllocated += nNewSize - nOldSize;
+		return true;
+	}
+
+	// @cmember Copy a string into the arena
+
+	char *StrDup (const char *pszString, size_t nLength)
+	{
+		char *psz = (char *) Alloc (nLength + 1);
+		memcpy (psz, pszString, nLength);
+		psz [nLength] = 0;
+		return psz;
+	}
+
+	// @cmember Release all memory held by the arena
+
+	void Reset ()
+	{
+		while (m_pChunks != NULL)
+		{
+			Chunk *pChunk = m_pChunks;
+			m_pChunks = pChunk ->pNext;
+			delete [] (unsigned char *) pChunk;
+		}
+		m_pauchNext = NULL;
+		m_pauchEnd = NULL;
+		m_pauchLast = NULL;
+		memset (&m_sStatistics, 0, sizeof (m_sStatistics));
+	}
+
+	// @cmember Get the arena statistics
+
+	const Statistics &GetStatistics () const
+	{
+		return m_sStatistics;
+	}
+
+// @access Protected types
+protected:
+
+	struct Chunk
+	{
+		Chunk				*pNext;
+		size_t				nSize;
+
+		unsigned char *GetData ()
+		{
+			return (unsigned char *) this + Align (sizeof (Chunk));
+		}
+	};
+
+// @access Protected methods
+protected:
+
+	// @cmember Round a size up to the arena alignment
+
+	static size_t Align (size_t nSize)
+	{
+		return (nSize + (Alignment - 1)) & ~((size_t) Alignment - 1);
+	}
+
+	// @cmember Allocate a new chunk
+
+	Chunk *NewChunk (size_t nSize)
+	{
+		Chunk *pChunk = (Chunk *) new unsigned char
+			[Align (sizeof (Chunk)) + nSize];
+		pChunk ->pNext = NULL;
+		pChunk ->nSize = nSize;
+		m_sStatistics .nChunks++;
+		m_sStatistics .nBytesReserved += nSize;
+		return pChunk;
+	}
+
+// @access Protected members
+protected:
+
+	// @cmember List of chunks, current chunk first
+
+	Chunk					*m_pChunks;
+
+	// @cmember Next free byte in the current chunk
+
+	unsigned char			*m_pauchNext;
+
+	// @cmember End of the current chunk
+
+	unsigned char			*m_pauchEnd;
+
+	// @cmember Most recent block carved out of the current chunk
+
+	unsigned char			*m_pauchLast;
+
+	// @cmember Size of a standard chunk
+
+	size_t					m_nChunkSize;
+
+	// @cmember Statistics
+
+	Statistics				m_sStatistics;
+};
+
+#endif // ETS_NWNARENA_H
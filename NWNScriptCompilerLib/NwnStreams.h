@@ -96,6 +96,23 @@ public:
 
 	virtual char *ReadLine (char *pachBuffer, size_t nCount) = 0;
 
+	// @cmember Read a line from the input a character at a time.  This is
+	//		the reference for ReadLine, used to check the lexer.
+
+	virtual char *ReadLineByCharacter (char *pachBuffer, size_t nCount)
+	{
+		char *pachOut = pachBuffer;
+		unsigned char c;
+		while (--nCount > 0 && Read (&c, 1) == 1)
+		{
+			*pachOut++ = (char) c;
+			if (c == '\n')
+				break;
+		}
+		*pachOut = 0;
+		return pachOut == pachBuffer ? NULL : pachBuffer; 
+	}
+
 // @access Public output routines
 public:
 
@@ -227,6 +244,29 @@ public:
 	// @cmember Read a line from the input
 
 	virtual char *ReadLine (char *pachBuffer, size_t nCount) 
+	{
+
+		//
+		// Copy up to and including the next new line, or as much as fits,
+		// in one block rather than a character at a time
+		//
+
+		size_t nLength = m_pauchEnd - m_pauchPos;
+		if (nLength > nCount - 1)
+			nLength = nCount - 1;
+		unsigned char *pauchNewLine = (unsigned char *) 
+			memchr (m_pauchPos, '\n', nLength);
+		if (pauchNewLine != NULL)
+			nLength = (pauchNewLine - m_pauchPos) + 1;
+		memcpy (pachBuffer, m_pauchPos, nLength);
+		m_pauchPos += nLength;
+		pachBuffer [nLength] = 0;
+		return nLength == 0 ? NULL : pachBuffer; 
+	}
+
+	// @cmember Read a line from the input a character at a time
+
+	virtual char *ReadLineByCharacter (char *pachBuffer, size_t nCount) 
 	{
 		char *pachOut = pachBuffer;
 		while (--nCount > 0 && m_pauchPos < m_pauchEnd)
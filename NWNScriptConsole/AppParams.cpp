@@ -121,6 +121,10 @@ Environment:
 			SetTestMode( _wtoi( argv[ i += 1 ] ) );
 		else if ((!_wcsicmp( argv[ i ], L"-nologo" )))
 			SetIsNoLogo( true );
+		else if ((!_wcsicmp( argv[ i ], L"-situationstats" )))
+			SetSituationStats( true );
+		else if ((!_wcsicmp( argv[ i ], L"-copysituations" )))
+			SetCopySituations( true );
 		else if ((!_wcsicmp( argv[ i ], L"-allowmanagedscripts" )) && (i < argc - 1))
 			SetAllowManagedScripts( _wtoi( argv[ i += 1 ] ) != 0 );
 		else if (!_wcsicmp( argv[ i ], L"-debugwait" ))
@@ -50,7 +50,9 @@ public:
 	  m_NoLogo( false ),
 	  m_AllowManagedScripts( false ),
 	  m_ScriptDebug( 1 ), // NWScriptVM::EDL_Errors
-	  m_TestMode( 0 )
+	  m_TestMode( 0 ),
+	  m_SituationStats( false ),
+	  m_CopySituations( false )
 	{
 		FindCriticalDirectories( );
 		ParseArguments( m_argc, const_cast< const wchar_t * * >( m_argv ) );
@@ -93,6 +95,12 @@ public:
 	inline int GetTestMode( ) const { return m_TestMode; }
 	inline void SetTestMode( nwn2dev__in int TestMode ) { m_TestMode = TestMode; }
 
+	inline bool GetSituationStats( ) const { return m_SituationStats; }
+	inline void SetSituationStats( nwn2dev__in bool SituationStats ) { m_SituationStats = SituationStats; }
+
+	inline bool GetCopySituations( ) const { return m_CopySituations; }
+	inline void SetCopySituations( nwn2dev__in bool CopySituations ) { m_CopySituations = CopySituations; }
+
 private:
 
 	void
@@ -137,6 +145,8 @@ private:
 	bool                       m_AllowManagedScripts;
 	int                        m_ScriptDebug;
 	int                        m_TestMode;
+	bool                       m_SituationStats;
+	bool                       m_CopySituations;
 
 };
 
@@ -239,6 +239,425 @@ Environment:
 	}
 }
 
+bool
+__stdcall
+OnBenchmarkTimer(
+	nwn2dev__in void * Context1,
+	nwn2dev__in void * Context2,
+	nwn2dev__in swutil::TimerRegistration * Timer
+	)
+/*++
+
+Routine Description:
+
+	This routine is the timer callback for the timer benchmark.  It counts
+	the timer firing.
+
+Arguments:
+
+	Context1 - Supplies a pointer to the count of timer firings.
+
+	Context2 - Unused.
+
+	Timer - Supplies the timer object that fired.
+
+Return Value:
+
+	The routine always returns true, as the timer is not deleted.
+
+Environment:
+
+	User mode, timer callback.
+
+--*/
+{
+	UNREFERENCED_PARAMETER( Context2 );
+	UNREFERENCED_PARAMETER( Timer );
+
+	*(ULONGLONG *) Context1 += 1;
+
+	return true;
+}
+
+void
+RunTimerBenchmark(
+	nwn2dev__in AppParameters & Params
+	)
+/*++
+
+Routine Description:
+
+	This routine measures the cost of the timer manager with a large count of
+	registered timers:  arming them, rearming them all with new periods (as
+	under heavy churn), running them down for a few seconds, and canceling
+	them.
+
+Arguments:
+
+	Params - Supplies the application parameter block.
+
+Return Value:
+
+	None.  Raises an std::exception on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typedef std::vector< swutil::TimerRegistration::Ptr > TimerVec;
+
+	const size_t         TimerCount = 100000;
+	const ULONG          RunTime    = 3000;
+	swutil::TimerManager TimerMgr;
+	TimerVec             Timers;
+	ULONGLONG            Fired;
+	ULONG                Seed;
+	ULONG                Rundowns;
+	ULONG                Timeout;
+	ULONGLONG            Deadline;
+	LARGE_INTEGER        Frequency;
+	LARGE_INTEGER        Start;
+	LARGE_INTEGER        End;
+	LONGLONG             ArmTime;
+	LONGLONG             RearmTime;
+	LONGLONG             RundownTime;
+	LONGLONG             CancelTime;
+
+	QueryPerformanceFrequency( &Frequency );
+
+	Fired = 0;
+	Seed  = 1;
+
+	Timers.reserve( TimerCount );
+
+	for (size_t i = 0; i < TimerCount; i += 1)
+		Timers.push_back( TimerMgr.CreateTimer( &OnBenchmarkTimer, &Fired, NULL ) );
+
+	//
+	// Arm every timer with a period of up to a minute.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (TimerVec::iterator it = Timers.begin( ); it != Timers.end( ); ++it)
+	{
+		Seed = Seed * 1103515245 + 12345;
+
+		(*it)->SetPeriod( 1 + (Seed >> 8) % 60000 );
+	}
+
+	QueryPerformanceCounter( &End );
+	ArmTime = End.QuadPart - Start.QuadPart;
+
+	//
+	// Rearm every timer, this time with a period of up to a second so that a
+	// good portion of them fire during the rundown pass.
+	//
+
+	QueryPerformanceCounter( &Start );
+
+	for (TimerVec::iterator it = Timers.begin( ); it != Timers.end( ); ++it)
+	{
+		Seed = Seed * 1103515245 + 12345;
+
+		(*it)->SetPeriod( 1 + (Seed >> 8) % 1000 );
+	}
+
+	QueryPerformanceCounter( &End );
+	RearmTime = End.QuadPart - Start.QuadPart;
+
+	//
+	// Run the timers down as a dispatch loop would, timing only the rundown
+	// calls themselves.
+	//
+
+	Rundowns    = 0;
+	RundownTime = 0;
+	Deadline    = swutil::TimerManager::GetMonotonicTime( ) + RunTime;
+
+	while (swutil::TimerManager::GetMonotonicTime( ) < Deadline)
+	{
+		QueryPerformanceCounter( &Start );
+		Timeout = TimerMgr.RundownTimers( );
+		QueryPerformanceCounter( &End );
+
+		RundownTime += End.QuadPart - Start.QuadPart;
+		Rundowns    += 1;
+
+		Sleep( (Timeout > 10) ? 10 : Timeout );
+	}
+
+	//
+	// Finally, cancel every timer by releasing it.
+	//
+
+	QueryPerformanceCounter( &Start );
+	Timers.clear( );
+	QueryPerformanceCounter( &End );
+	CancelTime = End.QuadPart - Start.QuadPart;
+
+	Params.GetTextOut( )->WriteText(
+		"Timer benchmark (%lu timers): arm %I64d us, rearm %I64d us, cancel %I64d us.\n"
+		"%lu rundowns over %lu ms fired %I64u timers in %I64d us (%I64d us per rundown).\n",
+		(unsigned long) TimerCount,
+		ArmTime * 1000000 / Frequency.QuadPart,
+		RearmTime * 1000000 / Frequency.QuadPart,
+		CancelTime * 1000000 / Frequency.QuadPart,
+		Rundowns,
+		RunTime,
+		Fired,
+		RundownTime * 1000000 / Frequency.QuadPart,
+		(Rundowns != 0) ? (RundownTime * 1000000 / Frequency.QuadPart) / Rundowns : 0);
+}
+
+//
+// Define the objects used by the reference count benchmark, one per reference
+// counting scheme.
+//
+
+struct RefBenchObject
+{
+	int Value;
+};
+
+struct RefBenchObjectAtomic : public swutil::IntrusiveRefCount< swutil::RefCountPolicyAtomic >
+{
+	int Value;
+};
+
+struct RefBenchObjectLocal : public swutil::IntrusiveRefCount< swutil::RefCountPolicySingleThreaded >
+{
+	int Value;
+};
+
+template< class PtrT, class ObjT >
+void
+MeasureRefCountThroughput(
+	nwn2dev__in size_t ObjectCount,
+	nwn2dev__in ULONG Rounds,
+	nwn2dev__out LONGLONG & CreateTime,
+	nwn2dev__out LONGLONG & CopyTime,
+	nwn2dev__out LONGLONG & DestroyTime
+	)
+/*++
+
+Routine Description:
+
+	This routine measures the cost of creating, copying and destroying a set
+	of reference counted pointers of a given type.
+
+Arguments:
+
+	ObjectCount - Supplies the count of objects to create.
+
+	Rounds - Supplies the count of times that the pointer set is copied and
+	         then destroyed.
+
+	CreateTime - Receives the time taken to create the objects and their
+	             initial pointers, in performance counter ticks.
+
+	CopyTime - Receives the time taken to copy the pointer set, over all
+	           rounds.
+
+	DestroyTime - Receives the time taken to destroy the copies, over all
+	              rounds, and then the objects themselves.
+
+Return Value:
+
+	None.  Raises an std::exception on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	typedef std::vector< PtrT > PtrVec;
+
+	PtrVec        Ptrs;
+	PtrVec        Copies;
+	LARGE_INTEGER Start;
+	LARGE_INTEGER End;
+
+	Ptrs.reserve( ObjectCount );
+	Copies.reserve( ObjectCount );
+
+	QueryPerformanceCounter( &Start );
+
+	for (size_t i = 0; i < ObjectCount; i += 1)
+		Ptrs.push_back( PtrT( new ObjT ) );
+
+	QueryPerformanceCounter( &End );
+	CreateTime = End.QuadPart - Start.QuadPart;
+
+	CopyTime    = 0;
+	DestroyTime = 0;
+
+	for (ULONG Round = 0; Round < Rounds; Round += 1)
+	{
+		QueryPerformanceCounter( &Start );
+		Copies.assign( Ptrs.begin( ), Ptrs.end( ) );
+		QueryPerformanceCounter( &End );
+
+		CopyTime += End.QuadPart - Start.QuadPart;
+
+		QueryPerformanceCounter( &Start );
+		Copies.clear( );
+		QueryPerformanceCounter( &End );
+
+		DestroyTime += End.QuadPart - Start.QuadPart;
+	}
+
+	QueryPerformanceCounter( &Start );
+	Ptrs.clear( );
+	QueryPerformanceCounter( &End );
+
+	DestroyTime += End.QuadPart - Start.QuadPart;
+}
+
+void
+RunRefCountBenchmark(
+	nwn2dev__in AppParameters & Params
+	)
+/*++
+
+Routine Description:
+
+	This routine compares the cost of SharedPtr against intrusively reference
+	counted pointers (with both the atomic and the single threaded reference
+	count policy), and then measures engine structure traffic through the
+	script stack, as seen by scripts that make heavy use of effects:  pushes
+	and pops of engine structures, and stack copies such as those made when
+	saving a script situation for DelayCommand.
+
+Arguments:
+
+	Params - Supplies the application parameter block.
+
+Return Value:
+
+	None.  Raises an std::exception on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	const size_t       ObjectCount   = 100000;
+	const ULONG        Rounds        = 20;
+	const ULONG        StructCount   = 64;
+	const ULONG        StackRounds   = 20000;
+	LARGE_INTEGER      Frequency;
+	LARGE_INTEGER      Start;
+	LARGE_INTEGER      End;
+	LONGLONG           CreateTime;
+	LONGLONG           CopyTime;
+	LONGLONG           DestroyTime;
+	LONGLONG           PushPopTime;
+	LONGLONG           StackCopyTime;
+	NWScriptStack      VMStack;
+	EngineStructurePtr Effect;
+
+	QueryPerformanceFrequency( &Frequency );
+
+#define REPORT_REF_THROUGHPUT( Name )                                      \
+	Params.GetTextOut( )->WriteText(                                       \
+		"%-28s create %I64d us, copy %I64d us, destroy %I64d us.\n",       \
+		Name,                                                              \
+		CreateTime * 1000000 / Frequency.QuadPart,                         \
+		CopyTime * 1000000 / Frequency.QuadPart,                           \
+		DestroyTime * 1000000 / Frequency.QuadPart)
+
+	Params.GetTextOut( )->WriteText(
+		"Reference count benchmark (%lu objects, %lu copy rounds):\n",
+		(unsigned long) ObjectCount,
+		Rounds);
+
+	MeasureRefCountThroughput< swutil::SharedPtr< RefBenchObject >, RefBenchObject >(
+		ObjectCount,
+		Rounds,
+		CreateTime,
+		CopyTime,
+		DestroyTime);
+
+	REPORT_REF_THROUGHPUT( "SharedPtr:" );
+
+	MeasureRefCountThroughput< swutil::IntrusivePtr< RefBenchObjectAtomic >, RefBenchObjectAtomic >(
+		ObjectCount,
+		Rounds,
+		CreateTime,
+		CopyTime,
+		DestroyTime);
+
+	REPORT_REF_THROUGHPUT( "IntrusivePtr (atomic):" );
+
+	MeasureRefCountThroughput< swutil::IntrusivePtr< RefBenchObjectLocal >, RefBenchObjectLocal >(
+		ObjectCount,
+		Rounds,
+		CreateTime,
+		CopyTime,
+		DestroyTime);
+
+	REPORT_REF_THROUGHPUT( "IntrusivePtr (single thread):" );
+
+#undef REPORT_REF_THROUGHPUT
+
+	//
+	// Now exercise engine structures on the script stack.  Each round pushes
+	// and pops a run of effects, and then copies a stack holding the run of
+	// effects, as DelayCommand does when it saves the script situation.
+	//
+
+	Effect        = new EngEffect( );
+	PushPopTime   = 0;
+	StackCopyTime = 0;
+
+	for (ULONG Round = 0; Round < StackRounds; Round += 1)
+	{
+		QueryPerformanceCounter( &Start );
+
+		for (ULONG i = 0; i < StructCount; i += 1)
+			VMStack.StackPushEngineStructure( Effect );
+
+		for (ULONG i = 0; i < StructCount; i += 1)
+			VMStack.StackPopEngineStructure( NWScriptHost::EngTypeEffect );
+
+		QueryPerformanceCounter( &End );
+		PushPopTime += End.QuadPart - Start.QuadPart;
+	}
+
+	for (ULONG i = 0; i < StructCount; i += 1)
+		VMStack.StackPushEngineStructure( Effect );
+
+	for (ULONG Round = 0; Round < StackRounds; Round += 1)
+	{
+		QueryPerformanceCounter( &Start );
+
+		{
+			NWScriptStack SavedStack( VMStack );
+		}
+
+		QueryPerformanceCounter( &End );
+		StackCopyTime += End.QuadPart - Start.QuadPart;
+	}
+
+	Params.GetTextOut( )->WriteText(
+		"Engine structures (%s reference count, %lu effects x %lu rounds):\n"
+		"push/pop %I64d us, stack copy %I64d us.\n",
+#ifdef NWSCRIPT_THREAD_CONFINED_ENGINE_STRUCTURES
+		"single thread",
+#else
+		"atomic",
+#endif
+		StructCount,
+		StackRounds,
+		PushPopTime * 1000000 / Frequency.QuadPart,
+		StackCopyTime * 1000000 / Frequency.QuadPart);
+}
+
 void
 RunTests(
 	nwn2dev__in AppParameters & Params,
@@ -344,6 +763,27 @@ Environment:
 		}
 		break;
 
+	case 3:
+		{
+			//
+			// Benchmark the timer manager.
+			//
+
+			RunTimerBenchmark( Params );
+		}
+		break;
+
+	case 4:
+		{
+			//
+			// Benchmark reference counted pointers and engine structure
+			// traffic on the script stack.
+			//
+
+			RunRefCountBenchmark( Params );
+		}
+		break;
+
 	}
 
 }
@@ -402,6 +842,7 @@ Environment:
 			"\n"
 			"  NWNScriptConsole [-module <module>] [-home <homedir>]\n"
 			"                   [-installdir <installdir>] [-nologo]\n"
+			"                   [-situationstats] [-copysituations]\n"
 			"                   ScriptName [script arguments]\n"
 			"\n"
 			"The script name should not contain any extension.  If a module is\n"
@@ -787,6 +1228,9 @@ Environment:
 		Sleep( Timeout );
 	}
 
+	if (Params.GetSituationStats( ))
+		g_ScriptHost->WriteSituationStatistics( );
+
 	if (!Quiet)
 	{
 		Params.GetTextOut( )->WriteText(
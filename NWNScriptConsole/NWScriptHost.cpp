@@ -95,6 +95,10 @@ Environment:
 		m_VM->SetDebugLevel( (NWScriptVM::ExecDebugLevel) DebugLevel );
 	}
 
+	m_VM->SetSegmentedSavedStates( !Params->GetCopySituations( ) );
+
+	ZeroMemory( &m_SituationStats, sizeof( m_SituationStats ) );
+
 	m_JITStack = new NWScriptStack( NWN::INVALIDOBJID );
 
 	try
@@ -541,6 +545,77 @@ Environment:
 	}
 }
 
+void
+NWScriptHost::WriteSituationStatistics(
+	)
+/*++
+
+Routine Description:
+
+	This routine writes a summary of the deferred script situation statistics
+	to the text output interface.  The statistics cover situations created by
+	the script VM; situations created by JIT'd scripts are not counted.
+
+	The memory figure per situation includes the situation's share of any
+	globals segments, which are shared by all situations that were saved from
+	the same script execution while the globals were unchanged.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	LARGE_INTEGER Frequency;
+	double        TicksPerUs;
+
+	QueryPerformanceFrequency( &Frequency );
+
+	TicksPerUs = (double) Frequency.QuadPart / 1000000.0;
+
+	m_TextOut->WriteText(
+		"Deferred script situations (%s saved states):\n"
+		"  Created:           %I64u\n"
+		"  Resumed:           %I64u\n"
+		"  Private bytes:     %I64u\n"
+		"  Shared bytes:      %I64u (%lu globals segments)\n",
+		m_AppParams->GetCopySituations( ) ? "copied" : "segmented",
+		m_SituationStats.Created,
+		m_SituationStats.Resumed,
+		m_SituationStats.PrivateBytes,
+		m_SituationStats.SharedBytes,
+		(unsigned long) m_SituationGlobals.size( ));
+
+	if (m_SituationStats.Created != 0)
+	{
+		m_TextOut->WriteText(
+			"  Bytes/situation:   %.1f\n"
+			"  Save time (avg):   %.3f us\n",
+			(double) (m_SituationStats.PrivateBytes + m_SituationStats.SharedBytes) /
+				(double) m_SituationStats.Created,
+			((double) m_SituationStats.CreateTime / TicksPerUs) /
+				(double) m_SituationStats.Created);
+	}
+
+	if (m_SituationStats.Resumed != 0)
+	{
+		m_TextOut->WriteText(
+			"  Restore time (avg): %.3f us\n"
+			"  Restore time (max): %.3f us\n",
+			((double) m_SituationStats.RestoreTime / TicksPerUs) /
+				(double) m_SituationStats.Resumed,
+			(double) m_SituationStats.MaxRestoreTime / TicksPerUs);
+	}
+}
+
 void
 NWScriptHost::ClearScriptCache(
 	)
@@ -1296,6 +1371,28 @@ Environment:
 		Situation->ScriptSituationJIT      = m_CurrentJITProgram->CreateSavedStatePtr( );
 		Situation->ScriptSituation.Script  = m_CurrentScript;
 	}
+	else if (m_AppParams->GetSituationStats( ))
+	{
+		const NWScriptStack::StackSegment * Globals;
+		LARGE_INTEGER                       Start;
+		LARGE_INTEGER                       End;
+
+		QueryPerformanceCounter( &Start );
+		Situation->ScriptSituation = ScriptVM.GetSavedState( );
+		QueryPerformanceCounter( &End );
+
+		Globals = Situation->ScriptSituation.GlobalsSegment.get( );
+
+		m_SituationStats.Created      += 1;
+		m_SituationStats.CreateTime   += (ULONGLONG) (End.QuadPart - Start.QuadPart);
+		m_SituationStats.PrivateBytes += Situation->ScriptSituation.GetPrivateMemoryUsage( );
+
+		if ((Globals != NULL) &&
+		    (m_SituationGlobals.insert( Globals ).second))
+		{
+			m_SituationStats.SharedBytes += Globals->GetMemoryUsage( );
+		}
+	}
 	else
 	{
 		Situation->ScriptSituation = ScriptVM.GetSavedState( );
@@ -1348,6 +1445,39 @@ Environment:
 
 --*/
 {
+	//
+	// If statistics are enabled, rebuild the saved stack of a VM situation
+	// up front so that the time taken can be measured apart from the script
+	// itself.
+	//
+
+	if ((m_AppParams->GetSituationStats( )) &&
+	    (Situation->ScriptSituationJIT.get( ) == NULL))
+	{
+		LARGE_INTEGER Start;
+		LARGE_INTEGER End;
+		ULONGLONG     Elapsed;
+
+		try
+		{
+			QueryPerformanceCounter( &Start );
+			Situation->ScriptSituation.GetStack( );
+			QueryPerformanceCounter( &End );
+
+			Elapsed = (ULONGLONG) (End.QuadPart - Start.QuadPart);
+
+			m_SituationStats.Resumed        += 1;
+			m_SituationStats.RestoreTime    += Elapsed;
+			m_SituationStats.MaxRestoreTime  = max( m_SituationStats.MaxRestoreTime, Elapsed );
+		}
+		catch (std::exception)
+		{
+			//
+			// The failure is reported when the situation is executed.
+			//
+		}
+	}
+
 	RunScriptSituation(
 		&Situation->ScriptSituation,
 		Situation->ScriptSituationJIT,
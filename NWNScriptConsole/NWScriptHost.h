@@ -164,6 +164,15 @@ public:
 	InitiatePendingDeferredScriptSituations(
 		);
 
+	//
+	// Write a summary of the memory used by, and the time taken to create and
+	// resume, deferred script situations to the text output interface.
+	//
+
+	void
+	WriteSituationStatistics(
+		);
+
 	//
 	// Called by the NWScriptVM when an action must be serviced.  This routine
 	// acts as the action service dispatcher for all actions requested by the
@@ -290,6 +299,25 @@ private:
 
 	typedef std::list< DeferredScriptSituation::Ptr > DeferredScriptSitList;
 
+	//
+	// Define the deferred script situation statistics, collected if enabled
+	// by the application parameters.  Times are in performance counter ticks.
+	// Shared globals segments are counted once each.
+	//
+
+	struct SituationStatistics
+	{
+		ULONGLONG Created;
+		ULONGLONG PrivateBytes;
+		ULONGLONG SharedBytes;
+		ULONGLONG CreateTime;
+		ULONGLONG Resumed;
+		ULONGLONG RestoreTime;
+		ULONGLONG MaxRestoreTime;
+	};
+
+	typedef std::set< const NWScriptStack::StackSegment * > StackSegmentSet;
+
 	//
 	// Define the callback registration handler for each action type in the
 	// system.
@@ -494,6 +522,14 @@ private:
 
 	DeferredScriptSitList            m_PendingDeferredSituations;
 
+	//
+	// Define the deferred script situation statistics, and the set of shared
+	// globals segments that have been counted.
+	//
+
+	SituationStatistics              m_SituationStats;
+	StackSegmentSet                  m_SituationGlobals;
+
 	//
 	// Define the currently executing script, which may only be referenced from
 	// action handlers.
@@ -578,7 +614,7 @@ private:
 
 };
 
-typedef swutil::SharedPtr< EngEffect > EngEffectPtr;
+typedef swutil::IntrusivePtr< EngEffect > EngEffectPtr;
 
 #ifdef NWSCRIPTHOST_INTERNAL
 
@@ -21,6 +21,8 @@ Abstract:
 #include "NWScriptProgram.h"
 #include "NWScriptSavedState.h"
 #include "NWScriptManagedSupport.h"
+#include "NWScriptCodeCache.h"
+#include "NWScriptUtilities.h"
 
 using System::Runtime::InteropServices::GCHandle;
 
@@ -158,6 +160,7 @@ Environment:
 		bool                     ManagedScript;
 		NWScriptManagedSupport ^ ManagedSupport;
 		array< Byte >          ^ ManagedAssembly;
+		NWScriptCodeCache      ^ CodeCache;
 
 		//
 		// If the caller indicates that they have already patched #loader, then
@@ -211,6 +214,78 @@ Environment:
 			}
 		}
 
+		//
+		// If the code cache is in use, then look the script up in the cache.
+		// A cached program is loaded as-is, without analyzing the script or
+		// generating code.  If the cached program cannot be loaded, then code
+		// is generated as usual and replaces the cache entry.
+		//
+
+		CodeCache = nullptr;
+
+		if ((CodeGenParams != NULL)                            &&
+		    (CodeGenParams->CodeGenFlags & NWCGF_USE_CODE_CACHE) &&
+		    (!ManagedScript))
+		{
+			array< Byte >                    ^ CachedAssembly;
+			NWScriptCodeCache::ActionTypeArr ^ CachedParamTypes;
+
+			try
+			{
+				CodeCache = gcnew NWScriptCodeCache(
+					Script,
+					ActionDefs,
+					ActionCount,
+					AnalysisFlags,
+					ObjectInvalid,
+					CodeGenParams,
+					TextOut,
+					DebugLevel);
+
+				if (CodeCache->LoadEntry( CachedAssembly, CachedParamTypes ))
+				{
+					NWScriptProgram ^ Program;
+					GCHandle          RetHandle;
+
+					Program = gcnew NWScriptProgram(
+						Script->ScriptName,
+						ActionDefs,
+						ActionCount,
+						TextOut,
+						DebugLevel,
+						ActionHandler,
+						CachedAssembly,
+						CachedParamTypes,
+						ObjectInvalid,
+						CodeGenParams);
+
+					RetHandle = GCHandle::Alloc( Program );
+
+					*GeneratedProgram = (NWSCRIPT_JITPROGRAM) (IntPtr) RetHandle;
+
+					return TRUE;
+				}
+			}
+			catch (Exception ^ e)
+			{
+				if ((TextOut != NULL) && (DebugLevel >= NWScriptVM::EDL_Errors))
+				{
+					try
+					{
+						std::string ConvStr = NWScriptUtilities::ConvertString( e->Message );
+
+						TextOut->WriteText(
+							"NWScriptGenerateCode: Exception '%s' using the code cache for script '%s'.  Generating code instead.\n",
+							ConvStr.c_str( ),
+							Script->ScriptName);
+					}
+					catch (Exception ^)
+					{
+					}
+				}
+			}
+		}
+
 		//
 		// Next, generate the IR for the program.
 		//
@@ -249,6 +324,9 @@ Environment:
 					ActionHandler,
 					ObjectInvalid,
 					CodeGenParams);
+
+				if (CodeCache != nullptr)
+					Program->StoreInCodeCache( CodeCache );
 			}
 
 			RetHandle = GCHandle::Alloc( Program );
@@ -131,6 +131,17 @@ typedef enum _NWSCRIPT_CODE_GEN_FLAGS
 
 	NWCGF_NWN_COMPATIBLE_ACTIONS      = 0x00000020,
 
+	//
+	// Keep generated script programs in an on-disk code cache under the code
+	// generation output directory.  A script whose instruction stream, action
+	// table, and code generation options match a cache entry is loaded from
+	// the cache instead of being analyzed and compiled again.  Entries are
+	// keyed by content, so a changed script or action table simply misses the
+	// cache.
+	//
+
+	NWCGF_USE_CODE_CACHE              = 0x00000040,
+
 	LAST_NWCGF
 } NWSCRIPT_CODE_GEN_FLAGS, * PNWSCRIPT_CODE_GEN_FLAGS;
 
@@ -168,8 +179,8 @@ typedef struct _NWSCRIPT_JIT_PARAMS
 	//
 	// Define the directory to save code generation output to.  If not set, the
 	// current directory is assumed.  This value is only used if the 
-	// NWCGF_SAVE_OUTPUT flag is set.  The name should end in a path separator
-	// if the parameter is not NULL.
+	// NWCGF_SAVE_OUTPUT or NWCGF_USE_CODE_CACHE flag is set.  The name should
+	// end in a path separator if the parameter is not NULL.
 	//
 
 	const wchar_t              * CodeGenOutputDir;
@@ -0,0 +1,907 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	NWScriptCodeCache.cpp
+
+Abstract:
+
+	This module houses the on-disk code cache for generated script programs.
+
+	Each cache entry is a file named <script>.<config>.<key>.nwscache in the
+	code generation output directory, laid out as follows:
+
+	    UInt32   Signature ('NSJC')
+	    UInt32   Version
+	    Byte[32] JITModuleId
+	    Byte[32] Key
+	    Int32    EntryPointParamCount (-1 if the entry point takes none)
+	    UInt32   EntryPointParamTypes[ EntryPointParamCount ]
+	    Int32    AssemblySize
+	    Byte     Assembly[ AssemblySize ]
+
+	The key covers every input to code generation, including the identity of
+	the JIT modules themselves, so an entry never needs to be invalidated in
+	place; a changed script, action table or JIT simply looks up a different
+	entry.  The <config> part of the name covers the same inputs other than
+	the script, so that when an entry is stored, the entries of earlier
+	versions of the script under the same configuration can be told apart
+	from the entries of other configurations sharing the directory.
+
+--*/
+
+#include "Precomp.h"
+#include "NWNScriptJIT.h"
+#include "NWScriptCodeCache.h"
+#include "NWScriptUtilities.h"
+
+using System::Security::Cryptography::SHA256;
+
+NWScriptCodeCache::NWScriptCodeCache(
+	nwn2dev__in NWScriptReaderState * Script,
+	__in_ecount( ActionCount ) PCNWACTION_DEFINITION ActionDefs,
+	nwn2dev__in NWSCRIPT_ACTION ActionCount,
+	nwn2dev__in ULONG AnalysisFlags,
+	nwn2dev__in NWN::OBJECTID ObjectInvalid,
+	nwn2dev__in PCNWSCRIPT_JIT_PARAMS CodeGenParams,
+	__in_opt IDebugTextOut * TextOut,
+	nwn2dev__in ULONG DebugLevel
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new NWScriptCodeCache context for a script.  The
+	configuration and cache keys are computed and the cache entry file name
+	is formed.
+
+Arguments:
+
+	Script - Supplies the script that code is to be generated for.
+
+	ActionDefs - Supplies the action table to use when analyzing the script.
+
+	ActionCount - Supplies the count of entries in the action table.
+
+	AnalysisFlags - Supplies flags that control the program analysis.
+
+	ObjectInvalid - Supplies the object id to reference for the 'object
+	                invalid' manifest constant.
+
+	CodeGenParams - Supplies extension code generation parameters.  The code
+	                cache is located in the code generation output directory.
+
+	TextOut - Optionally supplies an IDebugTextOut interface that receives text
+	          debug output from the execution environment.
+
+	DebugLevel - Supplies the debug output level.  Legal values are drawn from
+	             the NWScriptVM::ExecDebugLevel family of enumerations.
+
+Return Value:
+
+	None.  Raises a System::Exception on failure.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+: m_TextOut( TextOut ),
+  m_DebugLevel( DebugLevel ),
+  m_ScriptName( nullptr ),
+  m_JITModuleId( nullptr ),
+  m_Key( nullptr ),
+  m_CacheDir( nullptr ),
+  m_EntryPrefix( nullptr ),
+  m_ConfigPrefix( nullptr ),
+  m_EntryFileName( nullptr ),
+  m_KeepAssemblyFile( (CodeGenParams->CodeGenFlags & NWCGF_SAVE_OUTPUT) != 0 )
+{
+	StringBuilder   ^ EntryName;
+	array< Char >   ^ InvalidChars;
+	array< Byte >   ^ ConfigKey;
+
+	m_ScriptName = gcnew String(
+		Script->ScriptName,
+		0,
+		(Int32) strlen( Script->ScriptName ),
+		NWScriptUtilities::NW8BitEncoding);
+
+	m_JITModuleId = ComputeJITModuleId( );
+
+	ConfigKey = ComputeConfigKey(
+		ActionDefs,
+		ActionCount,
+		AnalysisFlags,
+		ObjectInvalid,
+		CodeGenParams);
+
+	m_Key = ComputeKey( Script, ConfigKey );
+
+	//
+	// Place the cache in the same directory that the code generator saves
+	// assemblies to.
+	//
+
+	if (CodeGenParams->CodeGenOutputDir != NULL)
+		m_CacheDir = gcnew String( CodeGenParams->CodeGenOutputDir );
+	else
+		m_CacheDir = Directory::GetCurrentDirectory( );
+
+	//
+	// Form the entry file name from the script name, with characters that
+	// cannot appear in a file name replaced, the leading part of the
+	// configuration key and the leading half of the cache key.
+	//
+
+	EntryName    = gcnew StringBuilder(
+		m_ScriptName->Length + 1 + CONFIG_NAME_BYTES * 2 + 1 + KEY_NAME_BYTES * 2 + 9 );
+	InvalidChars = Path::GetInvalidFileNameChars( );
+
+	for (int i = 0; i < m_ScriptName->Length; i += 1)
+	{
+		if (Array::IndexOf( InvalidChars, m_ScriptName[ i ] ) >= 0)
+			EntryName->Append( '_' );
+		else
+			EntryName->Append( m_ScriptName[ i ] );
+	}
+
+	EntryName->Append( '.' );
+
+	m_EntryPrefix = EntryName->ToString( );
+
+	for (int i = 0; i < CONFIG_NAME_BYTES; i += 1)
+		EntryName->Append( ConfigKey[ i ].ToString( "x2" ) );
+
+	EntryName->Append( '.' );
+
+	m_ConfigPrefix = EntryName->ToString( );
+
+	for (int i = 0; i < KEY_NAME_BYTES; i += 1)
+		EntryName->Append( m_Key[ i ].ToString( "x2" ) );
+
+	EntryName->Append( ".nwscache" );
+
+	m_EntryFileName = Path::Combine( m_CacheDir, EntryName->ToString( ) );
+}
+
+bool
+NWScriptCodeCache::LoadEntry(
+	nwn2dev__out array< Byte > ^ % ProgramAssembly,
+	nwn2dev__out ActionTypeArr ^ % EntryPointParamTypes
+	)
+/*++
+
+Routine Description:
+
+	This routine loads the cache entry for the script, if one exists.  The
+	entry is validated against the cache key before it is accepted.
+
+Arguments:
+
+	ProgramAssembly - On success, receives the saved assembly image of the
+	                  generated script program.
+
+	EntryPointParamTypes - On success, receives the types of the parameters to
+	                       the script entry point, or nullptr if the entry
+	                       point takes no parameters.
+
+Return Value:
+
+	The routine returns true if a valid cache entry was loaded, else false.
+	No exceptions are raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	array< Byte > ^ EntryData;
+
+	ProgramAssembly      = nullptr;
+	EntryPointParamTypes = nullptr;
+
+	//
+	// A missing or unreadable entry is simply a cache miss.
+	//
+
+	try
+	{
+		if (!File::Exists( m_EntryFileName ))
+			return false;
+
+		EntryData = File::ReadAllBytes( m_EntryFileName );
+	}
+	catch (Exception ^)
+	{
+		return false;
+	}
+
+	//
+	// Parse and validate the entry.  An entry that fails validation is
+	// ignored, and is overwritten once code has been generated for the
+	// script.
+	//
+
+	try
+	{
+		BinaryReader  ^ Reader;
+		array< Byte > ^ JITModuleId;
+		array< Byte > ^ Key;
+		Int32           ParamCount;
+		Int32           AssemblySize;
+
+		Reader = gcnew BinaryReader( gcnew MemoryStream( EntryData, false ) );
+
+		if (Reader->ReadUInt32( ) != CACHE_FILE_SIGNATURE)
+			throw gcnew InvalidDataException( "Bad code cache entry signature." );
+		if (Reader->ReadUInt32( ) != CACHE_FILE_VERSION)
+			throw gcnew InvalidDataException( "Unsupported code cache entry version." );
+
+		JITModuleId = Reader->ReadBytes( m_JITModuleId->Length );
+
+		if (JITModuleId->Length != m_JITModuleId->Length)
+			throw gcnew InvalidDataException( "Truncated code cache entry." );
+
+		for (int i = 0; i < m_JITModuleId->Length; i += 1)
+		{
+			if (JITModuleId[ i ] != m_JITModuleId[ i ])
+				throw gcnew InvalidDataException( "Code cache entry was written by another JIT build." );
+		}
+
+		Key = Reader->ReadBytes( m_Key->Length );
+
+		if (Key->Length != m_Key->Length)
+			throw gcnew InvalidDataException( "Truncated code cache entry." );
+
+		for (int i = 0; i < m_Key->Length; i += 1)
+		{
+			if (Key[ i ] != m_Key[ i ])
+				throw gcnew InvalidDataException( "Code cache entry key mismatch." );
+		}
+
+		ParamCount = Reader->ReadInt32( );
+
+		if ((ParamCount < -1) || (ParamCount > MAX_ENTRY_POINT_PARAMS))
+			throw gcnew InvalidDataException( "Bad code cache entry parameter count." );
+
+		if (ParamCount != -1)
+		{
+			EntryPointParamTypes = gcnew ActionTypeArr( ParamCount );
+
+			for (int i = 0; i < ParamCount; i += 1)
+			{
+				UInt32 ParamType = Reader->ReadUInt32( );
+
+				if (ParamType >= (UInt32) LASTACTIONTYPE)
+					throw gcnew InvalidDataException( "Bad code cache entry parameter type." );
+
+				EntryPointParamTypes[ i ] = (NWACTION_TYPE) ParamType;
+			}
+		}
+
+		AssemblySize = Reader->ReadInt32( );
+
+		if ((AssemblySize <= 0) ||
+		    ((Int64) AssemblySize != Reader->BaseStream->Length - Reader->BaseStream->Position))
+		{
+			throw gcnew InvalidDataException( "Bad code cache entry assembly size." );
+		}
+
+		ProgramAssembly = Reader->ReadBytes( AssemblySize );
+	}
+	catch (Exception ^ e)
+	{
+		if (IsDebugLevel( NWScriptVM::EDL_Errors ))
+		{
+			try
+			{
+				std::string ConvStr = NWScriptUtilities::ConvertString( e->Message );
+
+				m_TextOut->WriteText(
+					"NWScriptCodeCache::LoadEntry: Ignoring code cache entry for script '%s': %s\n",
+					NWScriptUtilities::ConvertString( m_ScriptName ).c_str( ),
+					ConvStr.c_str( ));
+			}
+			catch (Exception ^)
+			{
+			}
+		}
+
+		ProgramAssembly      = nullptr;
+		EntryPointParamTypes = nullptr;
+
+		return false;
+	}
+
+	if (IsDebugLevel( NWScriptVM::EDL_Verbose ))
+	{
+		try
+		{
+			m_TextOut->WriteText(
+				"NWScriptCodeCache::LoadEntry: Loaded script '%s' from the code cache.\n",
+				NWScriptUtilities::ConvertString( m_ScriptName ).c_str( ));
+		}
+		catch (Exception ^)
+		{
+		}
+	}
+
+	return true;
+}
+
+void
+NWScriptCodeCache::StoreEntry(
+	nwn2dev__in String ^ AssemblyFileName,
+	__in_opt ActionTypeArr ^ EntryPointParamTypes
+	)
+/*++
+
+Routine Description:
+
+	This routine stores the cache entry for the script.  The entry is written
+	to a temporary file that then replaces any existing entry, so that a
+	concurrent reader never observes a partially written entry.  Entries that
+	can no longer be used are then removed (see RemoveStaleEntries).
+
+	Failing to store an entry does not affect the generated program, so
+	failures are logged and otherwise ignored.
+
+Arguments:
+
+	AssemblyFileName - Supplies the path of the assembly file that the code
+	                   generator saved for the script program.
+
+	EntryPointParamTypes - Optionally supplies the types of the parameters to
+	                       the script entry point.
+
+Return Value:
+
+	None.  No exceptions are raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	String ^ TempFileName;
+
+	TempFileName = nullptr;
+
+	try
+	{
+		array< Byte > ^ AssemblyImage;
+		MemoryStream  ^ EntryStream;
+		BinaryWriter  ^ Writer;
+
+		AssemblyImage = File::ReadAllBytes( AssemblyFileName );
+
+		EntryStream = gcnew MemoryStream( AssemblyImage->Length + 256 );
+		Writer      = gcnew BinaryWriter( EntryStream );
+
+		Writer->Write( CACHE_FILE_SIGNATURE );
+		Writer->Write( CACHE_FILE_VERSION );
+		Writer->Write( m_JITModuleId );
+		Writer->Write( m_Key );
+
+		if (EntryPointParamTypes == nullptr)
+		{
+			Writer->Write( (Int32) -1 );
+		}
+		else
+		{
+			Writer->Write( (Int32) EntryPointParamTypes->Length );
+
+			for (int i = 0; i < EntryPointParamTypes->Length; i += 1)
+				Writer->Write( (UInt32) EntryPointParamTypes[ i ] );
+		}
+
+		Writer->Write( (Int32) AssemblyImage->Length );
+		Writer->Write( AssemblyImage );
+		Writer->Flush( );
+
+		//
+		// Write the entry out under a name private to this thread, then move
+		// it into place.
+		//
+
+		TempFileName = String::Format(
+			"{0}.{1}.{2}.tmp",
+			m_EntryFileName,
+			(UInt32) GetCurrentProcessId( ),
+			(UInt32) GetCurrentThreadId( ));
+
+		File::WriteAllBytes( TempFileName, EntryStream->ToArray( ) );
+
+		{
+			pin_ptr< const wchar_t > TempPath  = PtrToStringChars( TempFileName );
+			pin_ptr< const wchar_t > EntryPath = PtrToStringChars( m_EntryFileName );
+
+			if (!MoveFileExW( TempPath, EntryPath, MOVEFILE_REPLACE_EXISTING ))
+				throw gcnew IOException( "Failed to move code cache entry into place." );
+		}
+
+		TempFileName = nullptr;
+
+		RemoveStaleEntries( );
+
+		if (IsDebugLevel( NWScriptVM::EDL_Verbose ))
+		{
+			m_TextOut->WriteText(
+				"NWScriptCodeCache::StoreEntry: Stored script '%s' in the code cache.\n",
+				NWScriptUtilities::ConvertString( m_ScriptName ).c_str( ));
+		}
+	}
+	catch (Exception ^ e)
+	{
+		if (IsDebugLevel( NWScriptVM::EDL_Errors ))
+		{
+			try
+			{
+				std::string ConvStr = NWScriptUtilities::ConvertString( e->Message );
+
+				m_TextOut->WriteText(
+					"NWScriptCodeCache::StoreEntry: Failed to store script '%s' in the code cache: %s\n",
+					NWScriptUtilities::ConvertString( m_ScriptName ).c_str( ),
+					ConvStr.c_str( ));
+			}
+			catch (Exception ^)
+			{
+			}
+		}
+	}
+
+	try
+	{
+		if (TempFileName != nullptr)
+			File::Delete( TempFileName );
+
+		//
+		// The assembly file was only saved for the benefit of the cache,
+		// unless the caller asked for code generation output to be saved.
+		//
+
+		if (!m_KeepAssemblyFile)
+			File::Delete( AssemblyFileName );
+	}
+	catch (Exception ^)
+	{
+	}
+}
+
+array< Byte > ^
+NWScriptCodeCache::ComputeJITModuleId(
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the identity of the JIT modules, which is the
+	module version id of the JIT module followed by that of the JIT
+	intrinsics module.  Module version ids change with every build.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The 32-byte module identity is returned.  On failure, a System::Exception
+	is raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	array< Byte > ^ JITModuleId;
+	array< Byte > ^ JITId;
+	array< Byte > ^ IntrinsicsId;
+
+	JITId        = NWScriptCodeCache::typeid->Module->ModuleVersionId.ToByteArray( );
+	IntrinsicsId = NWScriptJITIntrinsics::typeid->Module->ModuleVersionId.ToByteArray( );
+	JITModuleId  = gcnew array< Byte >( JITId->Length + IntrinsicsId->Length );
+
+	Array::Copy( JITId, 0, JITModuleId, 0, JITId->Length );
+	Array::Copy( IntrinsicsId, 0, JITModuleId, JITId->Length, IntrinsicsId->Length );
+
+	return JITModuleId;
+}
+
+array< Byte > ^
+NWScriptCodeCache::ComputeConfigKey(
+	__in_ecount( ActionCount ) PCNWACTION_DEFINITION ActionDefs,
+	nwn2dev__in NWSCRIPT_ACTION ActionCount,
+	nwn2dev__in ULONG AnalysisFlags,
+	nwn2dev__in NWN::OBJECTID ObjectInvalid,
+	nwn2dev__in PCNWSCRIPT_JIT_PARAMS CodeGenParams
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the configuration key, which is a SHA-256 hash over
+	every input that affects the generated program, other than the script:
+
+	- the identity of the JIT and JIT intrinsics modules (their module version
+	  ids change with every build),
+	- the pointer size of the process,
+	- the action table,
+	- the analysis flags, the object invalid constant, the code generation
+	  flags, and the execution guard limits.
+
+Arguments:
+
+	ActionDefs - Supplies the action table to use when analyzing the script.
+
+	ActionCount - Supplies the count of entries in the action table.
+
+	AnalysisFlags - Supplies flags that control the program analysis.
+
+	ObjectInvalid - Supplies the object id to reference for the 'object
+	                invalid' manifest constant.
+
+	CodeGenParams - Supplies extension code generation parameters.
+
+Return Value:
+
+	The configuration key is returned.  On failure, a System::Exception is
+	raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	MemoryStream   ^ KeyStream;
+	BinaryWriter   ^ Writer;
+	SHA256         ^ Hash;
+	ULONG            CodeGenFlags;
+	int              MaxLoopIterations;
+	int              MaxCallDepth;
+
+	KeyStream = gcnew MemoryStream( 4096 );
+	Writer    = gcnew BinaryWriter( KeyStream );
+
+	Writer->Write( CACHE_FILE_VERSION );
+	Writer->Write( ComputeJITModuleId( ) );
+	Writer->Write( (Int32) IntPtr::Size );
+
+	Writer->Write( (UInt32) ActionCount );
+
+	for (NWSCRIPT_ACTION i = 0; i < ActionCount; i += 1)
+	{
+		PCNWACTION_DEFINITION ActionDef = &ActionDefs[ i ];
+
+#if NWACTION_DEF_INCLUDE_NAME
+		{
+			const char * Name = (ActionDef->Name != NULL) ? ActionDef->Name : "";
+
+			Writer->Write( (Int32) strlen( Name ) );
+
+			for (const char * p = Name; *p != '\0'; p += 1)
+				Writer->Write( (Byte) *p );
+		}
+#endif
+
+		Writer->Write( (UInt32) ActionDef->ActionId );
+		Writer->Write( (UInt32) ActionDef->MinParameters );
+		Writer->Write( (UInt32) ActionDef->NumParameters );
+		Writer->Write( (UInt32) ActionDef->ReturnType );
+
+		for (unsigned long j = 0; j < ActionDef->NumParameters; j += 1)
+			Writer->Write( (UInt32) ActionDef->ParameterTypes[ j ] );
+	}
+
+	//
+	// Code generation flags that only select where output goes do not affect
+	// the generated program.
+	//
+
+	CodeGenFlags      = CodeGenParams->CodeGenFlags & ~(NWCGF_SAVE_OUTPUT | NWCGF_USE_CODE_CACHE);
+	MaxLoopIterations = 0;
+	MaxCallDepth      = 0;
+
+	if (CodeGenParams->Size >= NWSCRIPT_JIT_PARAMS_SIZE_V2)
+	{
+		MaxLoopIterations = CodeGenParams->MaxLoopIterations;
+		MaxCallDepth      = CodeGenParams->MaxCallDepth;
+	}
+
+	Writer->Write( (UInt32) AnalysisFlags );
+	Writer->Write( (UInt32) ObjectInvalid );
+	Writer->Write( (UInt32) CodeGenFlags );
+	Writer->Write( (Int32) MaxLoopIterations );
+	Writer->Write( (Int32) MaxCallDepth );
+	Writer->Flush( );
+
+	Hash = SHA256::Create( );
+
+	return Hash->ComputeHash( KeyStream->GetBuffer( ), 0, (int) KeyStream->Length );
+}
+
+array< Byte > ^
+NWScriptCodeCache::ComputeKey(
+	nwn2dev__in NWScriptReaderState * Script,
+	nwn2dev__in array< Byte > ^ ConfigKey
+	)
+/*++
+
+Routine Description:
+
+	This routine computes the cache key for a script, which is a SHA-256 hash
+	over the configuration key, the script name (which names the generated
+	program type) and the script instruction stream.
+
+	The debug symbol table is not part of the key, as it does not affect the
+	behavior of the generated program.
+
+Arguments:
+
+	Script - Supplies the script that code is to be generated for.
+
+	ConfigKey - Supplies the configuration key.
+
+Return Value:
+
+	The cache key is returned.  On failure, a System::Exception is raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	MemoryStream   ^ KeyStream;
+	BinaryWriter   ^ Writer;
+	array< Byte >  ^ InstructionStream;
+	SHA256         ^ Hash;
+
+	KeyStream = gcnew MemoryStream( (int) Script->InstructionStreamSize + 256 );
+	Writer    = gcnew BinaryWriter( KeyStream );
+
+	Writer->Write( ConfigKey );
+
+	Writer->Write( (Int32) strlen( Script->ScriptName ) );
+
+	for (const char * p = Script->ScriptName; *p != '\0'; p += 1)
+		Writer->Write( (Byte) *p );
+
+	InstructionStream = gcnew array< Byte >( (int) Script->InstructionStreamSize );
+
+	if (Script->InstructionStreamSize != 0)
+	{
+		Marshal::Copy(
+			IntPtr( (void *) Script->InstructionStream ),
+			InstructionStream,
+			0,
+			InstructionStream->Length);
+	}
+
+	Writer->Write( (Int32) InstructionStream->Length );
+	Writer->Write( InstructionStream );
+	Writer->Flush( );
+
+	Hash = SHA256::Create( );
+
+	return Hash->ComputeHash( KeyStream->GetBuffer( ), 0, (int) KeyStream->Length );
+}
+
+void
+NWScriptCodeCache::RemoveStaleEntries(
+	)
+/*++
+
+Routine Description:
+
+	This routine removes cache entries for the script that can no longer be
+	used, so that they do not accumulate:
+
+	- entries under the current configuration other than the current entry,
+	  which were generated from an earlier version of the script, and
+
+	- entries under other configurations that are unreadable or were written
+	  by another build of the JIT.
+
+	Entries of other configurations written by this build of the JIT are
+	left alone, as another server (or a server with other settings) that
+	shares the code generation output directory may still use them.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.  No exceptions are raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	String ^ CurrentEntry;
+
+	CurrentEntry = Path::GetFileName( m_EntryFileName );
+
+	try
+	{
+		for each (String ^ EntryFile in Directory::GetFiles( m_CacheDir, m_EntryPrefix + "*.nwscache" ))
+		{
+			String ^ EntryName = Path::GetFileName( EntryFile );
+			bool     Stale;
+
+			if (String::Compare( EntryName, CurrentEntry, StringComparison::OrdinalIgnoreCase ) == 0)
+				continue;
+
+			//
+			// Match only <script>.<config>.<key>.nwscache (or the earlier
+			// <script>.<key>.nwscache), so that a script whose name extends
+			// this one (e.g. "foo" and "foo.bar") is left alone.
+			//
+
+			if (!IsEntryNameSuffix( EntryName->Substring( m_EntryPrefix->Length ) ))
+				continue;
+
+			if ((EntryName->Length == CurrentEntry->Length) &&
+			    (EntryName->StartsWith( m_ConfigPrefix, StringComparison::OrdinalIgnoreCase )))
+			{
+				Stale = true;
+			}
+			else
+			{
+				Stale = IsForeignEntry( EntryFile );
+			}
+
+			if (!Stale)
+				continue;
+
+			try
+			{
+				File::Delete( EntryFile );
+			}
+			catch (Exception ^)
+			{
+			}
+		}
+	}
+	catch (Exception ^)
+	{
+	}
+}
+
+bool
+NWScriptCodeCache::IsForeignEntry(
+	nwn2dev__in String ^ EntryFile
+	)
+/*++
+
+Routine Description:
+
+	This routine determines whether a cache entry file is unreadable (i.e. it
+	is truncated or does not begin with a cache entry header of the current
+	format) or was written by another build of the JIT.  Only the header of
+	the file is read.
+
+	A file that cannot be opened (e.g. because another server is replacing
+	it) is not considered to be foreign.
+
+Arguments:
+
+	EntryFile - Supplies the path of the cache entry file.
+
+Return Value:
+
+	The routine returns true if the entry file is unreadable or was written
+	by another build of the JIT.  No exceptions are raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	array< Byte > ^ Header;
+	Int32           Offset;
+
+	try
+	{
+		FileStream Stream(
+			EntryFile,
+			FileMode::Open,
+			FileAccess::Read,
+			FileShare::ReadWrite | FileShare::Delete);
+
+		Header = gcnew array< Byte >( 8 + m_JITModuleId->Length );
+
+		for (Offset = 0; Offset < Header->Length; )
+		{
+			Int32 Read = Stream.Read( Header, Offset, Header->Length - Offset );
+
+			if (Read <= 0)
+				return true;
+
+			Offset += Read;
+		}
+	}
+	catch (Exception ^)
+	{
+		return false;
+	}
+
+	if (BitConverter::ToUInt32( Header, 0 ) != CACHE_FILE_SIGNATURE)
+		return true;
+	if (BitConverter::ToUInt32( Header, 4 ) != CACHE_FILE_VERSION)
+		return true;
+
+	for (int i = 0; i < m_JITModuleId->Length; i += 1)
+	{
+		if (Header[ 8 + i ] != m_JITModuleId[ i ])
+			return true;
+	}
+
+	return false;
+}
+
+bool
+NWScriptCodeCache::IsEntryNameSuffix(
+	nwn2dev__in String ^ Suffix
+	)
+/*++
+
+Routine Description:
+
+	This routine determines whether the part of a file name that follows the
+	script name prefix has the form of a cache entry file name, that is,
+	<config>.<key>.nwscache or (for entries written by earlier versions of the
+	code cache) <key>.nwscache, with each key given in hexadecimal.
+
+Arguments:
+
+	Suffix - Supplies the part of the file name after the script name prefix.
+
+Return Value:
+
+	The routine returns true if the suffix has the form of a cache entry file
+	name.  No exceptions are raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	String ^ Keys;
+
+	if (!Suffix->EndsWith( ".nwscache", StringComparison::OrdinalIgnoreCase ))
+		return false;
+
+	Keys = Suffix->Substring( 0, Suffix->Length - 9 );
+
+	if (Keys->Length == CONFIG_NAME_BYTES * 2 + 1 + KEY_NAME_BYTES * 2)
+	{
+		if (Keys[ CONFIG_NAME_BYTES * 2 ] != '.')
+			return false;
+
+		Keys = Keys->Remove( CONFIG_NAME_BYTES * 2, 1 );
+	}
+	else if (Keys->Length != KEY_NAME_BYTES * 2)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < Keys->Length; i += 1)
+	{
+		if (!Uri::IsHexDigit( Keys[ i ] ))
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,250 @@
+/*++
+
+Copyright (c) Ken Johnson (Skywing). All rights reserved.
+
+Module Name:
+
+	NWScriptCodeCache.h
+
+Abstract:
+
+	This module defines the on-disk code cache for generated script programs.
+	A cache entry holds the saved assembly of a generated script program along
+	with the types of its entry point parameters, and is keyed by a hash of
+	all of the inputs to code generation (the script instruction stream, the
+	action table, and the code generation options).  The name of an entry
+	file also carries a hash of the configuration (everything but the script
+	itself), so that differently configured servers can share a cache.
+
+--*/
+
+#ifndef _SOURCE_PROGRAMS_NWNSCRIPTJIT_NWSCRIPTCODECACHE_H
+#define _SOURCE_PROGRAMS_NWNSCRIPTJIT_NWSCRIPTCODECACHE_H
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+namespace NWScript
+{
+
+ref class NWScriptCodeCache
+{
+
+public:
+
+	typedef array< NWACTION_TYPE > ActionTypeArr;
+
+	//
+	// Construct a code cache context for a script.  The cache key and the
+	// name of the cache entry file are computed from the script and its code
+	// generation inputs.
+	//
+
+	NWScriptCodeCache(
+		nwn2dev__in NWScriptReaderState * Script,
+		__in_ecount( ActionCount ) PCNWACTION_DEFINITION ActionDefs,
+		nwn2dev__in NWSCRIPT_ACTION ActionCount,
+		nwn2dev__in ULONG AnalysisFlags,
+		nwn2dev__in NWN::OBJECTID ObjectInvalid,
+		nwn2dev__in PCNWSCRIPT_JIT_PARAMS CodeGenParams,
+		__in_opt IDebugTextOut * TextOut,
+		nwn2dev__in ULONG DebugLevel
+		);
+
+	//
+	// Load the cache entry for the script.  The routine returns false if
+	// there is no valid cache entry.
+	//
+
+	bool
+	LoadEntry(
+		nwn2dev__out array< Byte > ^ % ProgramAssembly,
+		nwn2dev__out ActionTypeArr ^ % EntryPointParamTypes
+		);
+
+	//
+	// Store the cache entry for the script, given the assembly file saved by
+	// the code generator.  Failures are logged and otherwise ignored.
+	//
+
+	void
+	StoreEntry(
+		nwn2dev__in String ^ AssemblyFileName,
+		__in_opt ActionTypeArr ^ EntryPointParamTypes
+		);
+
+private:
+
+	//
+	// Compute the identity of the JIT modules.
+	//
+
+	static
+	array< Byte > ^
+	ComputeJITModuleId(
+		);
+
+	//
+	// Compute the configuration key, which covers every code generation input
+	// other than the script itself.
+	//
+
+	static
+	array< Byte > ^
+	ComputeConfigKey(
+		__in_ecount( ActionCount ) PCNWACTION_DEFINITION ActionDefs,
+		nwn2dev__in NWSCRIPT_ACTION ActionCount,
+		nwn2dev__in ULONG AnalysisFlags,
+		nwn2dev__in NWN::OBJECTID ObjectInvalid,
+		nwn2dev__in PCNWSCRIPT_JIT_PARAMS CodeGenParams
+		);
+
+	//
+	// Compute the cache key for a script under a configuration.
+	//
+
+	static
+	array< Byte > ^
+	ComputeKey(
+		nwn2dev__in NWScriptReaderState * Script,
+		nwn2dev__in array< Byte > ^ ConfigKey
+		);
+
+	//
+	// Remove cache entries for the script that can no longer be used.
+	//
+
+	void
+	RemoveStaleEntries(
+		);
+
+	//
+	// Determine whether a cache entry file is unreadable or was written by
+	// another build of the JIT.
+	//
+
+	bool
+	IsForeignEntry(
+		nwn2dev__in String ^ EntryFile
+		);
+
+	//
+	// Determine whether the part of an entry file name after the script name
+	// has the form of a cache entry file name.
+	//
+
+	static
+	bool
+	IsEntryNameSuffix(
+		nwn2dev__in String ^ Suffix
+		);
+
+	//
+	// Determine whether a debug level is enabled.
+	//
+
+	inline
+	bool
+	IsDebugLevel(
+		nwn2dev__in ULONG DebugLevel
+		)
+	{
+		return ((m_TextOut != NULL) && (m_DebugLevel >= DebugLevel));
+	}
+
+	//
+	// Define the cache entry file signature and format version.  The version
+	// must be changed whenever the file format or the layout of the key
+	// changes.
+	//
+
+	static const UInt32 CACHE_FILE_SIGNATURE = 'NSJC';
+	static const UInt32 CACHE_FILE_VERSION   = 2;
+
+	//
+	// Define the number of key bytes that appear in an entry file name, for
+	// the configuration key and the cache key.
+	//
+
+	static const Int32  CONFIG_NAME_BYTES = 8;
+	static const Int32  KEY_NAME_BYTES    = 16;
+
+	//
+	// Define the largest entry point parameter count accepted from a cache
+	// entry file.
+	//
+
+	static const Int32  MAX_ENTRY_POINT_PARAMS = 0x1000;
+
+	//
+	// Define the optional text out interface, for debug prints.
+	//
+
+	IDebugTextOut            * m_TextOut;
+
+	//
+	// Define the debug level for debug output.  Legal values are drawn from
+	// the NWScriptVM::ExecDebugLevel family of enumerations.
+	//
+
+	ULONG                      m_DebugLevel;
+
+	//
+	// Define the name of the script.
+	//
+
+	String                   ^ m_ScriptName;
+
+	//
+	// Define the identity of the JIT modules (the module version ids of the
+	// JIT and JIT intrinsics modules).
+	//
+
+	array< Byte >            ^ m_JITModuleId;
+
+	//
+	// Define the cache key (a SHA-256 hash of the code generation inputs).
+	//
+
+	array< Byte >            ^ m_Key;
+
+	//
+	// Define the directory that holds the cache entry files.
+	//
+
+	String                   ^ m_CacheDir;
+
+	//
+	// Define the prefix shared by all cache entry file names for the script.
+	//
+
+	String                   ^ m_EntryPrefix;
+
+	//
+	// Define the prefix shared by all cache entry file names for the script
+	// under the current configuration.
+	//
+
+	String                   ^ m_ConfigPrefix;
+
+	//
+	// Define the full path of the cache entry file for the script.
+	//
+
+	String                   ^ m_EntryFileName;
+
+	//
+	// Define whether the assembly file saved by the code generator is to be
+	// kept after it has been copied into the cache (i.e. the caller asked for
+	// code generation output to be saved as well).
+	//
+
+	bool                       m_KeepAssemblyFile;
+
+};
+
+}
+
+#endif
+
@@ -283,8 +283,18 @@ Environment:
 	Program.Type = ProgramType->CreateType( );
 
 	if (SaveAsm)
+	{
 		Assembly->Save( GenerateAsmName( Name, false ) + ".dll" );
 
+		Program.FileName = Path::Combine(
+			m_ILGenCtx->OutputDir,
+			GenerateAsmName( Name, false ) + ".dll");
+	}
+	else
+	{
+		Program.FileName = nullptr;
+	}
+
 	Program.Assembly             = Assembly;
 	Program.EngineStructureTypes = m_EngineStructureTypes;
 
@@ -403,8 +413,18 @@ Environment:
 	Program.Type = ProgramType->CreateType( );
 
 	if (SaveAsm)
+	{
 		Assembly->Save( GenerateAsmName( Name, true ) + ".dll" );
 
+		Program.FileName = Path::Combine(
+			m_ILGenCtx->OutputDir,
+			GenerateAsmName( Name, true ) + ".dll");
+	}
+	else
+	{
+		Program.FileName = nullptr;
+	}
+
 	Program.Assembly             = Assembly;
 	Program.EngineStructureTypes = m_EngineStructureTypes;
 
@@ -420,6 +440,66 @@ Environment:
 }
 
 
+void
+NWScriptCodeGenerator::BindProgramType(
+	nwn2dev__in Type ^ ProgramType,
+	nwn2dev__in INWScriptActions * ActionHandler
+	)
+/*++
+
+Routine Description:
+
+	This routine binds a generated script program type to the action handler
+	that its code calls.  Script programs that were generated for the code
+	cache load the action handler and its direct action service call routine
+	from static fields of the program type, which are set here.  Other script
+	programs have the addresses embedded in their code and need no binding.
+
+	The routine must be called before the program type is instantiated.
+
+Arguments:
+
+	ProgramType - Supplies the generated script program type.
+
+	ActionHandler - Supplies the engine actions implementation handler.
+
+Return Value:
+
+	None.  On failure, a System::Exception is raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+#if NWSCRIPT_DIRECT_FAST_ACTION_CALLS
+	FieldInfo ^ FldActionHandler;
+	FieldInfo ^ FldPtrOnExecuteActionFromJITFast;
+
+	FldActionHandler                 = ProgramType->GetField(
+		"s_ActionHandler",
+		BindingFlags::Public | BindingFlags::Static);
+	FldPtrOnExecuteActionFromJITFast = ProgramType->GetField(
+		"s_PtrOnExecuteActionFromJITFast",
+		BindingFlags::Public | BindingFlags::Static);
+
+	if ((FldActionHandler == nullptr) || (FldPtrOnExecuteActionFromJITFast == nullptr))
+		return;
+
+	FldActionHandler->SetValue(
+		nullptr,
+		IntPtr( ActionHandler ));
+	FldPtrOnExecuteActionFromJITFast->SetValue(
+		nullptr,
+		IntPtr( ((INWScriptActions_Raw *) ActionHandler)->Vtbl->OnExecuteActionFromJITFast ));
+#else
+	UNREFERENCED_PARAMETER( ProgramType );
+	UNREFERENCED_PARAMETER( ActionHandler );
+#endif
+}
+
+
 void
 NWScriptCodeGenerator::SetupCodeGeneration(
 	nwn2dev__in const NWScriptAnalyzer * Analyzer,
@@ -509,9 +589,25 @@ Environment:
 		OutputDir = "";
 	}
 
+	//
+	// Script programs generated for the code cache are always saved to disk,
+	// as the code cache stores the saved assembly image.  The interface layer
+	// is never cached.
+	//
+
+	m_ILGenCtx->CodeCacheProgram = false;
+
+	if ((m_ILGenCtx->CodeGenParams != NULL) &&
+	    (m_ILGenCtx->CodeGenParams->CodeGenFlags & NWCGF_USE_CODE_CACHE) &&
+	    (!InterfaceLayer))
+	{
+		m_ILGenCtx->CodeCacheProgram = true;
+	}
+
 	if (m_ILGenCtx->CodeGenParams != NULL)
 	{
-		if (m_ILGenCtx->CodeGenParams->CodeGenFlags & NWCGF_SAVE_OUTPUT)
+		if ((m_ILGenCtx->CodeGenParams->CodeGenFlags & NWCGF_SAVE_OUTPUT) ||
+		    (m_ILGenCtx->CodeCacheProgram))
 		{
 			SaveAsm = true;
 
@@ -520,6 +616,8 @@ Environment:
 		}
 	}
 
+	m_ILGenCtx->OutputDir = OutputDir;
+
 	//
 	// First, generate the assembly for the target.
 	//
@@ -747,8 +845,9 @@ Environment:
 	AsmName       = Assembly->GetName( );
 
 #if NWSCRIPT_COLLECT_ASM_GC_BUG
-	if ((m_ILGenCtx->CodeGenParams != NULL) &&
-	    (m_ILGenCtx->CodeGenParams->CodeGenFlags & NWCGF_SAVE_OUTPUT))
+	if (((m_ILGenCtx->CodeGenParams != NULL) &&
+	     (m_ILGenCtx->CodeGenParams->CodeGenFlags & NWCGF_SAVE_OUTPUT)) ||
+	    (m_ILGenCtx->CodeCacheProgram))
 	{
 		ProgramModule = Assembly->DefineDynamicModule(
 			AsmName->Name,
@@ -865,6 +964,29 @@ Environment:
 		UInt32::typeid,
 		FieldAttributes::Private);
 
+#if NWSCRIPT_DIRECT_FAST_ACTION_CALLS
+
+	//
+	// If the program is destined for the code cache, then the action handler
+	// address and its direct call routine cannot be baked into the code, as
+	// the program may be loaded into a different process.  Instead, they are
+	// loaded from static fields that are set by BindProgramType.
+	//
+
+	if (m_ILGenCtx->CodeCacheProgram)
+	{
+		m_ILGenCtx->FldActionHandler = ProgramType->DefineField(
+			"s_ActionHandler",
+			IntPtr::typeid,
+			FieldAttributes::Public | FieldAttributes::Static);
+		m_ILGenCtx->FldPtrOnExecuteActionFromJITFast = ProgramType->DefineField(
+			"s_PtrOnExecuteActionFromJITFast",
+			IntPtr::typeid,
+			FieldAttributes::Public | FieldAttributes::Static);
+	}
+
+#endif
+
 	//
 	// Create the constructor, which takes two parameters (the NWScriptProgram
 	// instance and the INWScriptJITIntrinsics  interface).
@@ -6312,14 +6434,27 @@ Environment:
 	//
 	// Note that we can hardcode both 'this' and the call target because the
 	// INWScriptActions interface cannot change while the NWScriptProgram
-	// object is live.
+	// object is live.  Programs generated for the code cache load them from
+	// static fields that are bound when the program type is instantiated.
 	//
 
+	if (m_ILGenCtx->CodeCacheProgram)
+	{
+		ILGen->Emit( OpCodes::Ldsfld, m_ILGenCtx->FldActionHandler );    // this
+#ifdef _WIN64
+		ILGen->Emit( OpCodes::Conv_I8 );
+#else
+		ILGen->Emit( OpCodes::Conv_I4 );
+#endif
+	}
+	else
+	{
 #ifdef _WIN64
-	ILGen->Emit( OpCodes::Ldc_I8, (Int64) m_ActionHandler );             // this
+		ILGen->Emit( OpCodes::Ldc_I8, (Int64) m_ActionHandler );         // this
 #else
-	ILGen->Emit( OpCodes::Ldc_I4, (Int32) m_ActionHandler );    
+		ILGen->Emit( OpCodes::Ldc_I4, (Int32) m_ActionHandler );    
 #endif
+	}
 
 	ILGen->Emit( OpCodes::Ldc_I4, (Int32) CalledAction->ActionId );      // ActionId
 	ILGen->Emit( OpCodes::Conv_U4 );
@@ -6360,13 +6495,20 @@ Environment:
 	// Now load the (devirtualized) call site.
 	//
 
+	if (m_ILGenCtx->CodeCacheProgram)
+	{
+		ILGen->Emit( OpCodes::Ldsfld, m_ILGenCtx->FldPtrOnExecuteActionFromJITFast );
+	}
+	else
+	{
 #ifdef _WIN64
-	ILGen->Emit( OpCodes::Ldc_I8, (Int64) m_ILGenCtx->PtrOnExecuteActionFromJITFast );
-	ILGen->Emit( OpCodes::Conv_U8 );
+		ILGen->Emit( OpCodes::Ldc_I8, (Int64) m_ILGenCtx->PtrOnExecuteActionFromJITFast );
+		ILGen->Emit( OpCodes::Conv_U8 );
 #else
-	ILGen->Emit( OpCodes::Ldc_I4, (Int32) m_ILGenCtx->PtrOnExecuteActionFromJITFast );
-	ILGen->Emit( OpCodes::Conv_U4 );
+		ILGen->Emit( OpCodes::Ldc_I4, (Int32) m_ILGenCtx->PtrOnExecuteActionFromJITFast );
+		ILGen->Emit( OpCodes::Conv_U4 );
 #endif
+	}
 
 	//
 	// Finally, emit the call.  Note that the virtual interface is declared as
@@ -84,6 +84,13 @@ public:
 		//
 
 		Type            ^ Type;
+
+		//
+		// Define the path of the assembly file, if the assembly was saved to
+		// disk, else nullptr.
+		//
+
+		String          ^ FileName;
 	};
 
 	//
@@ -141,6 +148,18 @@ public:
 		nwn2dev__out ProgramInfo % Program
 		);
 
+	//
+	// Bind a generated program type to the action handler that it is to
+	// call.  This must be done before the type is instantiated.
+	//
+
+	static
+	void
+	BindProgramType(
+		nwn2dev__in Type ^ ProgramType,
+		nwn2dev__in INWScriptActions * ActionHandler
+		);
+
 private:
 
 	typedef array< NWACTION_TYPE > ActionTypeArr;
@@ -1515,6 +1534,17 @@ private:
 
 		void                   * PtrOnExecuteActionFromJITFast;
 
+		//
+		// Define the static fields that hold the action handler and its
+		// direct action service call routine, if the program is generated
+		// for the code cache.  Such programs may not have process-specific
+		// addresses baked into their code, so the addresses are loaded from
+		// these fields instead (see BindProgramType).
+		//
+
+		FieldInfo              ^ FldActionHandler;
+		FieldInfo              ^ FldPtrOnExecuteActionFromJITFast;
+
 #endif
 
 		//
@@ -1540,6 +1570,19 @@ private:
 		//
 
 		Encoding               ^ StringEncoding;
+
+		//
+		// Define the directory that the assembly is saved to, if it is to be
+		// saved to disk.
+		//
+
+		String                 ^ OutputDir;
+
+		//
+		// Define whether the program is being generated for the code cache.
+		//
+
+		bool                     CodeCacheProgram;
 	};
 
 	//
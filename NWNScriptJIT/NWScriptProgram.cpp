@@ -22,6 +22,7 @@ Abstract:
 #include "NWScriptSavedState.h"
 #include "NWScriptUtilities.h"
 #include "NWScriptManagedSupport.h"
+#include "NWScriptCodeCache.h"
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -105,7 +106,8 @@ Environment:
   m_CodeGenFlags( 0 ),
   m_ManagedScript( false ),
   m_ManagedSupport( nullptr ),
-  m_StringEncoding( NWScriptUtilities::NW8BitEncoding )
+  m_StringEncoding( NWScriptUtilities::NW8BitEncoding ),
+  m_ProgramFileName( nullptr )
 {
 	try
 	{
@@ -225,7 +227,8 @@ Environment:
   m_CodeGenFlags( 0 ),
   m_ManagedScript( true ),
   m_ManagedSupport( nullptr ),
-  m_StringEncoding( NWScriptUtilities::NWUTF8Encoding )
+  m_StringEncoding( NWScriptUtilities::NWUTF8Encoding ),
+  m_ProgramFileName( nullptr )
 {
 	try
 	{
@@ -267,6 +270,115 @@ Environment:
 	}
 }
 
+NWScriptProgram::NWScriptProgram(
+	nwn2dev__in const char * ScriptName,
+	__in_ecount( ActionCount ) PCNWACTION_DEFINITION ActionDefs,
+	nwn2dev__in NWSCRIPT_ACTION ActionCount,
+	__in_opt IDebugTextOut * TextOut,
+	nwn2dev__in ULONG DebugLevel,
+	nwn2dev__in INWScriptActions * ActionHandler,
+	nwn2dev__in array< Byte > ^ ProgramAssembly,
+	__in_opt array< NWACTION_TYPE > ^ EntryPointParamTypes,
+	nwn2dev__in NWN::OBJECTID ObjectInvalid,
+	__in_opt PCNWSCRIPT_JIT_PARAMS CodeGenParams
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new NWScriptProgram based off of a program
+	assembly that was generated for the same script by an earlier code
+	generation pass, and which was retrieved from the code cache.  The
+	assembly is loaded and bound to the action handler; no analysis or code
+	generation is performed.
+
+Arguments:
+
+	ScriptName - Supplies the name of the script.
+
+	ActionDefs - Supplies the action table in use.
+
+	ActionCount - Supplies the count of entries in the action table.
+
+	TextOut - Optionally supplies an IDebugTextOut interface that receives text
+	          debug output from the execution environment.
+
+	DebugLevel - Supplies the debug output level.  Legal values are drawn from
+	             the NWScriptVM::ExecDebugLevel family of enumerations.
+
+	ActionHandler - Supplies the engine actions implementation handler.
+
+	ProgramAssembly - Supplies the contents of the cached program assembly.
+
+	EntryPointParamTypes - Optionally supplies the types of the parameters to
+	                       the script entry point, as recorded in the code
+	                       cache.
+
+	ObjectInvalid - Supplies the object id to reference for the 'object
+	                invalid' manifest constant.
+
+	CodeGenParams - Optionally supplies extension code generation parameters.
+
+Return Value:
+
+	None.  Raises a System::Exception on failure.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+: m_TextOut( TextOut ),
+  m_DebugLevel( DebugLevel ),
+  m_ActionHandler( ActionHandler ),
+  m_ActionDefs( ActionDefs ),
+  m_ActionCount( ActionCount ),
+  m_ProgramObject( nullptr ),
+  m_JITIntrinsics( gcnew NWScriptJITIntrinsics( this ) ),
+  m_EntryPointReturnsValue( false ),
+  m_EntryPointParamTypes( EntryPointParamTypes ),
+  m_CurrentActionObjectSelf( NWN::INVALIDOBJID ),
+  m_InvalidObjId( ObjectInvalid ),
+  m_Stack( NULL ),
+  m_Aborted( false ),
+  m_NestingLevel( 0 ),
+  m_ScriptName( nullptr ),
+  m_EngineStructureTypes( nullptr ),
+  m_CodeGenFlags( 0 ),
+  m_ManagedScript( false ),
+  m_ManagedSupport( nullptr ),
+  m_StringEncoding( NWScriptUtilities::NW8BitEncoding ),
+  m_ProgramFileName( nullptr )
+{
+	try
+	{
+		if (sizeof( NWScript::NeutralStringStorage ) != sizeof( INWScriptStack::NeutralString ))
+			throw gcnew Exception( "Size mismatch between NWScriptStorage::NeutralString and INWScriptStack::NeutralString." );
+
+		m_ScriptName = gcnew String(
+			ScriptName,
+			0,
+			(Int32) strlen( ScriptName ),
+			m_StringEncoding);
+
+		if (CodeGenParams == NULL)
+			m_CodeGenFlags = 0;
+		else
+			m_CodeGenFlags = CodeGenParams->CodeGenFlags;
+
+		//
+		// Load the cached program assembly.
+		//
+
+		InstantiateCachedProgram( ProgramAssembly );
+	}
+	catch (Exception ^ e)
+	{
+		ErrorException( e );
+		throw;
+	}
+}
+
 
 #ifdef _MSC_VER
 #pragma warning(pop)
@@ -586,6 +698,45 @@ Environment:
 	}
 }
 
+void
+NWScriptProgram::StoreInCodeCache(
+	nwn2dev__in NWScriptCodeCache ^ CodeCache
+	)
+/*++
+
+Routine Description:
+
+	This routine stores the generated script program in the code cache, so
+	that a later load of the same script can skip analysis and code
+	generation.
+
+	N.B.  The program must have been generated with NWCGF_USE_CODE_CACHE set,
+	      so that its assembly was saved to disk and does not embed any
+	      process-specific addresses.
+
+Arguments:
+
+	CodeCache - Supplies the code cache context for the script.
+
+Return Value:
+
+	None.  Failures are logged by the code cache and are otherwise ignored.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	if ((m_ManagedScript) || (m_ProgramFileName == nullptr))
+		return;
+
+	if (!(m_CodeGenFlags & NWCGF_USE_CODE_CACHE))
+		return;
+
+	CodeCache->StoreEntry( m_ProgramFileName, m_EntryPointParamTypes );
+}
+
 void
 NWScriptProgram::AbortScript(
 	)
@@ -2770,11 +2921,15 @@ Environment:
 #endif
 
 	m_EngineStructureTypes = Program.EngineStructureTypes;
+	m_ProgramFileName      = Program.FileName;
 
 	//
-	// Now instantiate a copy of the compiled script program type.
+	// Now instantiate a copy of the compiled script program type, once it has
+	// been bound to the action handler.
 	//
 
+	NWScriptCodeGenerator::BindProgramType( Program.Type, m_ActionHandler );
+
 	m_ProgramObject = (IGeneratedScriptProgram ^) Program.Assembly->CreateInstance(
 		Program.Type->FullName,
 		false,
@@ -3313,6 +3468,167 @@ Environment:
 	return m_ManagedSupport->GetAssembly( );
 }
 
+void
+NWScriptProgram::InstantiateCachedProgram(
+	nwn2dev__in array< Byte > ^ ProgramAssembly
+	)
+/*++
+
+Routine Description:
+
+	This routine instantiates a script program from the assembly image of a
+	program that was generated for the code cache.  The program type is bound
+	to the action handler before it is instantiated.
+
+Arguments:
+
+	ProgramAssembly - Supplies a byte array describing the program assembly
+	                  image to instantiate.
+
+Return Value:
+
+	None.  On failure, a System::Exception is raised.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	AppDomain       ^ CurrentDomain;
+	Assembly        ^ ScriptAssembly;
+	Exception       ^ Ex;
+	Type            ^ ScriptType;
+	Module          ^ JITModule;
+
+	CurrentDomain = AppDomain::CurrentDomain;
+
+	//
+	// With the assembly resolve event lock held, temporarily hook the resolve
+	// assembly handler so that the program's references to the JIT
+	// assemblies are resolved against the copies already loaded.
+	//
+
+	{
+		swutil::ScopedLock AssemblyResolveLock( g_AssemblyResolveEventLock );
+
+		CurrentDomain->AssemblyResolve += gcnew ResolveEventHandler(
+			this,
+			&NWScriptProgram::InstantiateCachedProgramResolveAssembly);
+
+		try
+		{
+			ScriptAssembly = CurrentDomain->Load( ProgramAssembly );
+
+			for each (Type ^ T in ScriptAssembly->GetTypes( ))
+			{
+				if (!T->IsVisible)
+					continue;
+				if (T->GetInterface( "IGeneratedScriptProgram" ) == nullptr)
+					continue;
+
+				ScriptType = T;
+				break;
+			}
+
+			if (ScriptType == nullptr)
+				throw gcnew ApplicationException( "Cached program does not implement IGeneratedScriptProgram" );
+
+			//
+			// The engine structure types are those of the JIT intrinsics
+			// module, as for a program that is generated in process.
+			//
+
+			JITModule              = NWScriptJITIntrinsics::typeid->Module;
+			m_EngineStructureTypes = gcnew array< Type ^ >( NUM_ENGINE_STRUCTURE_TYPES );
+
+			for (int i = 0; i < NUM_ENGINE_STRUCTURE_TYPES; i += 1)
+			{
+				m_EngineStructureTypes[ i ] = JITModule->GetType(
+					"NWScript.NWScriptEngineStructure" + i,
+					true,
+					false);
+			}
+
+			//
+			// Bind the program to the action handler and instantiate a copy of
+			// the script program object.
+			//
+
+			NWScriptCodeGenerator::BindProgramType( ScriptType, m_ActionHandler );
+
+			m_ProgramObject = (IGeneratedScriptProgram ^) ScriptAssembly->CreateInstance(
+				ScriptType->FullName,
+				false,
+				BindingFlags::CreateInstance,
+				nullptr,
+				gcnew array< Object ^ >{ m_JITIntrinsics, this },
+				nullptr,
+				nullptr);
+		}
+		catch (Exception ^ e)
+		{
+			Ex = e;
+		}
+
+		CurrentDomain->AssemblyResolve -= gcnew ResolveEventHandler(
+			this,
+			&NWScriptProgram::InstantiateCachedProgramResolveAssembly);
+
+		if (Ex != nullptr)
+			throw Ex;
+	}
+}
+
+Assembly ^
+NWScriptProgram::InstantiateCachedProgramResolveAssembly(
+	nwn2dev__in Object ^ Sender,
+	nwn2dev__in ResolveEventArgs ^ Args
+	)
+/*++
+
+Routine Description:
+
+	This routine is invoked in the context of InstantiateCachedProgram when
+	assembly name resolution fails for an assembly referenced by a cached
+	program.  Its purpose is to link the program to the JIT and JIT
+	intrinsics assemblies that generated it, which are already loaded but
+	may not be visible to the default probing logic.
+
+Arguments:
+
+	Sender - Supplies the source object.
+
+	Args - Supplies the event arguments.
+
+Return Value:
+
+	The already-loaded assembly is returned, or nullptr if the request is not
+	for one of the JIT assemblies.
+
+Environment:
+
+	User mode, C++/CLI.
+
+--*/
+{
+	Assembly ^ JITAssembly;
+
+	UNREFERENCED_PARAMETER( Sender );
+
+	JITAssembly = NWScriptProgram::typeid->Assembly;
+
+	if (Args->Name == JITAssembly->FullName)
+		return JITAssembly;
+
+	JITAssembly = NWScriptJITIntrinsics::typeid->Assembly;
+
+	if (Args->Name == JITAssembly->FullName)
+		return JITAssembly;
+
+	return nullptr;
+}
+
 void
 NWScriptProgram::DiscoverEntryPointParameters(
 	nwn2dev__in const NWScriptAnalyzer * Analyzer
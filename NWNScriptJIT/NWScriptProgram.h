@@ -39,6 +39,7 @@ ref class NWScriptSavedState;
 ref class NWScriptEngineStructure;
 ref class NWScriptCodeGenerator;
 ref class NWScriptManagedSupport;
+ref class NWScriptCodeCache;
 
 
 
@@ -219,6 +220,25 @@ public:
 		nwn2dev__in NWN::OBJECTID ObjectInvalid,
 		__in_opt PCNWSCRIPT_JIT_PARAMS CodeGenParams
 		);
+
+	//
+	// Construct a script program based off of a program assembly that was
+	// previously generated for the same script and loaded from the code
+	// cache.  No analysis or code generation is performed.
+	//
+
+	NWScriptProgram(
+		nwn2dev__in const char * ScriptName,
+		__in_ecount( ActionCount ) PCNWACTION_DEFINITION ActionDefs,
+		nwn2dev__in NWSCRIPT_ACTION ActionCount,
+		__in_opt IDebugTextOut * TextOut,
+		nwn2dev__in ULONG DebugLevel,
+		nwn2dev__in INWScriptActions * ActionHandler,
+		nwn2dev__in array< Byte > ^ ProgramAssembly,
+		__in_opt array< NWACTION_TYPE > ^ EntryPointParamTypes,
+		nwn2dev__in NWN::OBJECTID ObjectInvalid,
+		__in_opt PCNWSCRIPT_JIT_PARAMS CodeGenParams
+		);
 	
 	//
 	// Destruct a NWScriptProgram instance.
@@ -259,6 +279,16 @@ public:
 		nwn2dev__in NWN::OBJECTID ObjectSelf
 		);
 
+	//
+	// Store the generated program in the code cache.  The program must have
+	// been generated (not loaded from the code cache or a managed script).
+	//
+
+	void
+	StoreInCodeCache(
+		nwn2dev__in NWScriptCodeCache ^ CodeCache
+		);
+
 	//
 	// Abort the currently running script.
 	//
@@ -759,6 +789,26 @@ private:
 		nwn2dev__in ResolveEventArgs ^ Args
 		);
 
+	//
+	// Instantiate a script program from a code cache assembly image.
+	//
+
+	void
+	InstantiateCachedProgram(
+		nwn2dev__in array< Byte > ^ ProgramAssembly
+		);
+
+	//
+	// Handle assembly resolution events for code cache assembly
+	// instantiation.
+	//
+
+	Assembly ^
+	InstantiateCachedProgramResolveAssembly(
+		nwn2dev__in Object ^ Sender,
+		nwn2dev__in ResolveEventArgs ^ Args
+		);
+
 	//
 	// Save the canonical NWScriptManagedInterface module to disk.
 	//
@@ -929,6 +979,13 @@ private:
 
 	System::Text::Encoding   ^ m_StringEncoding;
 
+	//
+	// Define the path of the assembly file saved by the code generator, if
+	// the program was generated and saved to disk, else nullptr.
+	//
+
+	String                   ^ m_ProgramFileName;
+
 };
 
 //
@@ -44,6 +44,22 @@ Abstract:
 
 #define STACK_SAVEBP_CONVERT_TO_INTEGER 1
 
+//
+// Define the stack segment cell buffer pool parameters.  Cell buffers are
+// allocated in power of two size classes starting at 64 bytes.  Up to
+// SEGMENT_POOL_DEPTH freed buffers of each of the SEGMENT_POOL_CLASSES
+// smallest size classes are retained for reuse, so that saving a script
+// situation does not usually need to allocate cell storage.
+//
+
+#define SEGMENT_POOL_MIN_SHIFT 6
+#define SEGMENT_POOL_CLASSES   8
+#define SEGMENT_POOL_DEPTH     64
+
+static SRWLOCK         g_SegmentPoolLock = SRWLOCK_INIT;
+static unsigned char * g_SegmentPool[ SEGMENT_POOL_CLASSES ][ SEGMENT_POOL_DEPTH ];
+static ULONG           g_SegmentPoolCount[ SEGMENT_POOL_CLASSES ];
+
 
 
 NWScriptStack::NWScriptStack(
@@ -70,7 +86,8 @@ Environment:
 
 --*/
 : m_BP( 0 ),
-  m_InvalidObjId( InvalidObjId )
+  m_InvalidObjId( InvalidObjId ),
+  m_SharedSegmentOffset( 0 )
 {
 }
 
@@ -1083,6 +1100,8 @@ Environment:
 	if (Offset >= m_Stack.size( ))
 		throw invalid_stack_exception( "illegal stack reference" );
 
+	InvalidateSharedSegment( Offset );
+
 #if STACK_SAVEBP_CONVERT_TO_INTEGER
 	if (m_StackTypes[ Offset ] == SET_STACK_POINTER)
 	{
@@ -1190,6 +1209,8 @@ Environment:
 	if (Offset >= m_Stack.size( ))
 		throw invalid_stack_exception( "illegal stack reference" );
 
+	InvalidateSharedSegment( Offset );
+
 	if (m_StackTypes[ Offset ] & SET_ENGINE_STRUCTURE)
 		throw type_mismatch_exception( "SetStackFloat type mismatch" );
 	else if (m_StackTypes[ Offset ] & SET_DYNAMIC)
@@ -1282,6 +1303,8 @@ Environment:
 	if (Offset >= m_Stack.size( ))
 		throw invalid_stack_exception( "illegal stack reference" );
 
+	InvalidateSharedSegment( Offset );
+
 	if (m_StackTypes[ Offset ] & SET_ENGINE_STRUCTURE)
 		throw type_mismatch_exception( "SetStackString type mismatch" );
 	else if (m_StackTypes[ Offset ] & SET_DYNAMIC)
@@ -1396,6 +1419,8 @@ Environment:
 	if (Offset >= m_Stack.size( ))
 		throw invalid_stack_exception( "illegal stack reference" );
 
+	InvalidateSharedSegment( Offset );
+
 	if (m_StackTypes[ Offset ] & SET_ENGINE_STRUCTURE)
 		throw type_mismatch_exception( "SetStackObjectId type mismatch" );
 	else if (m_StackTypes[ Offset ] & SET_DYNAMIC)
@@ -1488,6 +1513,8 @@ Environment:
 	if (Offset >= m_Stack.size( ))
 		throw invalid_stack_exception( "illegal stack reference" );
 
+	InvalidateSharedSegment( Offset );
+
 	if (m_StackTypes[ Offset ] & SET_ENGINE_STRUCTURE)
 		throw type_mismatch_exception( "SetStackVector type mismatch" );
 	else if (m_StackTypes[ Offset ] & (SET_FLOAT | SET_VECTOR))
@@ -1588,6 +1615,8 @@ Environment:
 	if (Offset >= m_Stack.size( ))
 		throw invalid_stack_exception( "illegal stack reference" );
 
+	InvalidateSharedSegment( Offset );
+
 	if ((m_StackTypes[ Offset ] & SET_ENGINE_STRUCTURE) && (m_StackTypes[ Offset ] != SET_STACK_POINTER))
 	{
 		if (m_Stack[ Offset ].String >= m_StackEngineStructures.size( ))
@@ -1744,6 +1773,8 @@ Environment:
 	if (SrcOffset == (size_t) Destination)
 		return;
 
+	InvalidateSharedSegment( (size_t) Destination );
+
 	//
 	// Now perform the copy, one cell at a time.  The destination cells are
 	// required to have the same type as the source cells as this is a bulk
@@ -2309,6 +2340,224 @@ Environment:
 }
 
 
+void
+NWScriptStack::SaveStackSegments(
+	nwn2dev__in STACK_POINTER BPSaveBytes,
+	nwn2dev__in STACK_POINTER SPSaveBytes,
+	nwn2dev__out StackSegmentPtr & BPSegment,
+	nwn2dev__out StackSegmentPtr & SPSegment,
+	nwn2dev__in STACK_POINTER SPSaveOffset /* = 0 */
+	)
+/*++
+
+Routine Description:
+
+	This routine saves a portion of the current stack's contents into a pair
+	of stack segments that are returned to the caller.  The saved stack may
+	later be reconstituted with the RestoreStackSegments routine.
+
+	The BP-relative cells are shared with any earlier save of the same cells
+	that was made since the cells were last modified.  Script situations that
+	are saved repeatedly by one script execution (e.g. for a series of
+	DelayCommand calls) thus hold a single copy of the script's globals.
+
+	Note that the BP restore and program counter restore stacks are not saved.
+
+Arguments:
+
+	BPSaveBytes - Supplies the count of bytes to save relative to the current
+	              BP.
+
+	SPSaveBytes - Supplies the count of bytes to save relative to the current
+	              SP.
+
+	BPSegment - Receives the segment holding the BP-relative cells.
+
+	SPSegment - Receives the segment holding the SP-relative cells.
+
+	SPSaveOffset - Supplies the offset relative to the current SP that the SP
+	               save bytes should be copied from.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	size_t        CellsToCopy;
+	size_t        SrcOffset;
+	STACK_POINTER CurSP;
+	STACK_POINTER CurBP;
+
+#if STACK_DEBUG
+	//
+	// Validate stack pointer arguments.
+	//
+
+	if ((BPSaveBytes & (STACK_ENTRY_SIZE - 1)) ||
+	    (SPSaveBytes & (STACK_ENTRY_SIZE - 1)) ||
+	    (SPSaveOffset & (STACK_ENTRY_SIZE - 1)))
+	{
+		throw invalid_stack_exception( "misaligned stack reference in SaveStackSegments" );
+	}
+#endif
+
+	if ((BPSaveBytes < 0) || (SPSaveBytes < 0))
+		throw invalid_stack_exception( "negative save count in SaveStackSegments" );
+
+	CurSP = GetCurrentSP( );
+	CurBP = GetCurrentBP( );
+
+	if (CurSP + SPSaveOffset < 0)
+		throw invalid_stack_exception( "stack save offset exceeds stack bounds in SaveStackSegments" );
+
+	if ((BPSaveBytes > CurBP) ||
+	    (SPSaveBytes > CurSP + SPSaveOffset))
+	{
+		throw invalid_stack_exception( "stack save range exceeds stack bounds in SaveStackSegments" );
+	}
+
+	//
+	// Capture the cells relative to BP first, unless the last capture of the
+	// same cells is still current (in which case it is simply shared).
+	//
+
+	SrcOffset   = (CurBP - BPSaveBytes) / STACK_ENTRY_SIZE;
+	CellsToCopy = BPSaveBytes / STACK_ENTRY_SIZE;
+
+	if ((m_SharedSegment.get( ) != NULL) &&
+	    (m_SharedSegmentOffset == SrcOffset) &&
+	    (m_SharedSegment->GetCellCount( ) == CellsToCopy))
+	{
+		BPSegment = m_SharedSegment;
+	}
+	else
+	{
+		BPSegment = CaptureStackSegment( SrcOffset, CellsToCopy );
+
+		m_SharedSegment       = BPSegment;
+		m_SharedSegmentOffset = SrcOffset;
+	}
+
+	//
+	// Now capture the SP-relative cells, which are always private to this
+	// save.
+	//
+
+	SrcOffset   = ((CurSP + SPSaveOffset) - SPSaveBytes) / STACK_ENTRY_SIZE;
+	CellsToCopy = SPSaveBytes / STACK_ENTRY_SIZE;
+
+	SPSegment = CaptureStackSegment( SrcOffset, CellsToCopy );
+}
+
+void
+NWScriptStack::RestoreStackSegments(
+	__inout StackSegmentPtr & BPSegment,
+	__inout StackSegmentPtr & SPSegment
+	)
+/*++
+
+Routine Description:
+
+	This routine replaces the contents of the stack with a stack saved by the
+	SaveStackSegments routine.  The stack is laid out exactly as the stack
+	that the SaveStack routine returns: the BP-relative cells, then a saved
+	BP value, then the SP-relative cells, with BP addressing the saved BP.
+
+	Cell values are block copied.  The strings and engine structures of a
+	segment that the caller held the only reference to are moved out of the
+	segment rather than copied.
+
+Arguments:
+
+	BPSegment - Supplies the segment holding the BP-relative cells.  The
+	            reference is released.
+
+	SPSegment - Supplies the segment holding the SP-relative cells.  The
+	            reference is released.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised, and the stack is left
+	empty.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ResetStack( );
+
+	try
+	{
+		if (BPSegment.get( ) != NULL)
+			AppendStackSegment( BPSegment.get( ), BPSegment.unique( ) );
+
+		SaveBP( );
+
+		if (SPSegment.get( ) != NULL)
+			AppendStackSegment( SPSegment.get( ), SPSegment.unique( ) );
+	}
+	catch (...)
+	{
+		BPSegment.release( );
+		SPSegment.release( );
+		ResetStack( );
+		throw;
+	}
+
+	BPSegment.release( );
+	SPSegment.release( );
+}
+
+size_t
+NWScriptStack::GetMemoryUsage(
+	) const
+/*++
+
+Routine Description:
+
+	This routine estimates the count of bytes of heap memory that the stack
+	holds.  The shared BP segment (if any) is not included.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the approximate memory usage of the stack, in bytes.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	size_t Bytes;
+
+	Bytes  = m_ReturnStack.capacity( ) * sizeof( PROGRAM_COUNTER );
+	Bytes += m_Stack.capacity( ) * sizeof( STACK_ENTRY );
+	Bytes += m_StackTypes.capacity( ) * sizeof( STACK_TYPE_CODE );
+	Bytes += m_StackStrings.capacity( ) * sizeof( std::string );
+	Bytes += m_StackEngineStructures.capacity( ) * sizeof( EngineStructurePtr );
+	Bytes += m_GuardZoneStack.capacity( ) * sizeof( STACK_POINTER );
+
+	for (StringStack::const_iterator it = m_StackStrings.begin( );
+	     it != m_StackStrings.end( );
+	     ++it)
+	{
+		Bytes += it->capacity( );
+	}
+
+	return Bytes;
+}
+
 void
 NWScriptStack::DestructElements(
 	nwn2dev__in STACK_POINTER BytesToRemove,
@@ -2439,6 +2688,8 @@ Environment:
 	if (Offset >= m_Stack.size( ))
 		throw invalid_stack_exception( "illegal stack reference" );
 
+	InvalidateSharedSegment( Offset );
+
 	if (m_StackTypes[ Offset ] == SET_DYNAMIC)
 	{
 		int Value = GetDynamicStackEntryInteger( Offset ) + 1;
@@ -2491,6 +2742,8 @@ Environment:
 	if (Offset >= m_Stack.size( ))
 		throw invalid_stack_exception( "illegal stack reference" );
 
+	InvalidateSharedSegment( Offset );
+
 	if (m_StackTypes[ Offset ] == SET_DYNAMIC)
 	{
 		int Value = GetDynamicStackEntryInteger( Offset ) - 1;
@@ -2786,6 +3039,7 @@ Environment:
 	m_StackStrings.clear( );
 	m_StackEngineStructures.clear( );
 	m_GuardZoneStack.clear( );
+	m_SharedSegment.release( );
 
 	m_BP = 0;
 }
@@ -3016,6 +3270,7 @@ Environment:
 		throw stack_underflow_exception( "attempted to pop entry from empty stack" );
 
 	CheckGuardZone( GetCurrentSP( ) - STACK_ENTRY_SIZE );
+	InvalidateSharedSegment( m_Stack.size( ) - 1 );
 
 	Type = m_StackTypes.back( );
 
@@ -3154,6 +3409,7 @@ Environment:
 		throw stack_underflow_exception( "attempted to pop entry from empty stack" );
 
 	CheckGuardZone( GetCurrentSP( ) - STACK_ENTRY_SIZE );
+	InvalidateSharedSegment( m_Stack.size( ) - 1 );
 
 	StackEntry     = m_Stack.back( );
 	StackEntryType = m_StackTypes.back( );
@@ -3756,3 +4012,424 @@ Environment:
 }
 
 
+
+NWScriptStack::StackSegmentPtr
+NWScriptStack::CaptureStackSegment(
+	nwn2dev__in size_t SrcOffset,
+	nwn2dev__in size_t CellsToCopy
+	) const
+/*++
+
+Routine Description:
+
+	This routine copies a portion of the current stack into a new stack
+	segment, including any handle references.  Handles in the captured cells
+	are rebased to index the segment's own string and engine structure
+	arrays.
+
+	Note that the caller guarantees that the offset and count are valid.
+
+Arguments:
+
+	SrcOffset - Supplies the offset into the local stack to copy from.
+
+	CellsToCopy - Supplies the count of stack cells to capture.
+
+Return Value:
+
+	The routine returns the new segment.  An std::exception is raised on
+	failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	StackSegmentPtr   Segment = new StackSegment( CellsToCopy );
+	PSTACK_ENTRY      Cells;
+	STACK_TYPE_CODE * Types;
+
+	Cells = Segment->GetCells( );
+	Types = Segment->GetTypes( );
+
+	for (size_t i = 0; i < CellsToCopy; i += 1)
+	{
+		STACK_TYPE_CODE SrcType = m_StackTypes[ SrcOffset + i ];
+
+		if ((!(SrcType & SET_ENGINE_STRUCTURE)) &&
+		    ((SrcType & SET_STRING) || (SrcType & SET_DYNAMIC)))
+		{
+			STRING_HANDLE StringSrc;
+
+			StringSrc = m_Stack[ SrcOffset + i ].String;
+
+#if STACK_DEBUG
+			if (StringSrc >= m_StackStrings.size( ))
+				throw invalid_handle_exception( "invalid source string handle in CaptureStackSegment" );
+#endif
+
+			Segment->m_Strings.push_back( m_StackStrings[ StringSrc ] );
+
+			Cells[ i ].String = (STRING_HANDLE) (Segment->m_Strings.size( ) - 1);
+		}
+		else if ((SrcType & SET_ENGINE_STRUCTURE) &&
+		         (SrcType != SET_STACK_POINTER))
+		{
+			ENGINE_HANDLE EngineSrc;
+
+			EngineSrc = m_Stack[ SrcOffset + i ].EngineStruct;
+
+#if STACK_DEBUG
+			if (EngineSrc >= m_StackEngineStructures.size( ))
+				throw invalid_handle_exception( "invalid source engine handle in CaptureStackSegment" );
+#endif
+
+			Segment->m_EngineStructures.push_back( m_StackEngineStructures[ EngineSrc ] );
+
+			Cells[ i ].EngineStruct = (ENGINE_HANDLE) (Segment->m_EngineStructures.size( ) - 1);
+		}
+		else
+		{
+			Cells[ i ].Raw = m_Stack[ SrcOffset + i ].Raw;
+		}
+
+		Types[ i ] = SrcType;
+	}
+
+	return Segment;
+}
+
+void
+NWScriptStack::AppendStackSegment(
+	nwn2dev__in StackSegment * Segment,
+	nwn2dev__in bool SegmentExclusive
+	)
+/*++
+
+Routine Description:
+
+	This routine appends the contents of a stack segment to the current
+	logical SP.  The segment's cells are block copied, and their handles are
+	then rebased to index the stack's string and engine structure stacks.
+
+Arguments:
+
+	Segment - Supplies the segment to append.
+
+	SegmentExclusive - Supplies a Boolean value indicating true if the caller
+	                   holds the only reference to the segment, in which case
+	                   the segment's strings are moved into the stack (leaving
+	                   the segment unusable).
+
+Return Value:
+
+	None.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	size_t                  CellCount;
+	size_t                  DstOffset;
+	size_t                  StringBase;
+	size_t                  EngineBase;
+	PCSTACK_ENTRY           Cells;
+	const STACK_TYPE_CODE * Types;
+
+	CellCount  = Segment->GetCellCount( );
+	DstOffset  = m_Stack.size( );
+	StringBase = m_StackStrings.size( );
+	EngineBase = m_StackEngineStructures.size( );
+	Cells      = Segment->GetCells( );
+	Types      = Segment->GetTypes( );
+
+	if (DstOffset + CellCount > STACK_MAXIMUM_SIZE)
+		throw stack_overflow_exception( "maximum stack size exceeded" );
+
+	if ((StringBase + Segment->m_Strings.size( ) >= ULONG_MAX) ||
+	    (EngineBase + Segment->m_EngineStructures.size( ) >= ULONG_MAX))
+	{
+		throw stack_overflow_exception( "out of handle stack space" );
+	}
+
+	//
+	// Transfer the referenced strings and engine structures.  The segment's
+	// handles are in cell order, so appending them in order preserves the
+	// handle destruction order that the stack relies on.
+	//
+
+	if (SegmentExclusive)
+	{
+		m_StackStrings.resize( StringBase + Segment->m_Strings.size( ) );
+
+		for (size_t i = 0; i < Segment->m_Strings.size( ); i += 1)
+			m_StackStrings[ StringBase + i ].swap( Segment->m_Strings[ i ] );
+	}
+	else
+	{
+		m_StackStrings.insert(
+			m_StackStrings.end( ),
+			Segment->m_Strings.begin( ),
+			Segment->m_Strings.end( ));
+	}
+
+	m_StackEngineStructures.insert(
+		m_StackEngineStructures.end( ),
+		Segment->m_EngineStructures.begin( ),
+		Segment->m_EngineStructures.end( ));
+
+	//
+	// Now block copy the cells and rebase any handles that they hold.
+	//
+
+	m_Stack.insert( m_Stack.end( ), Cells, Cells + CellCount );
+	m_StackTypes.insert( m_StackTypes.end( ), Types, Types + CellCount );
+
+	if ((StringBase == 0) && (EngineBase == 0))
+		return;
+
+	for (size_t i = 0; i < CellCount; i += 1)
+	{
+		STACK_TYPE_CODE Type = Types[ i ];
+
+		if ((!(Type & SET_ENGINE_STRUCTURE)) &&
+		    ((Type & SET_STRING) || (Type & SET_DYNAMIC)))
+		{
+			m_Stack[ DstOffset + i ].String += (STRING_HANDLE) StringBase;
+		}
+		else if ((Type & SET_ENGINE_STRUCTURE) &&
+		         (Type != SET_STACK_POINTER))
+		{
+			m_Stack[ DstOffset + i ].EngineStruct += (ENGINE_HANDLE) EngineBase;
+		}
+	}
+}
+
+NWScriptStack::StackSegment::StackSegment(
+	nwn2dev__in size_t CellCount
+	)
+/*++
+
+Routine Description:
+
+	This routine constructs a new stack segment with uninitialized storage
+	for a given count of cells.
+
+Arguments:
+
+	CellCount - Supplies the count of cells that the segment holds.
+
+Return Value:
+
+	None.  Raises an std::exception on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+: m_CellCount( CellCount ),
+  m_CellData( NULL ),
+  m_CellDataCapacity( 0 )
+{
+	if (CellCount != 0)
+	{
+		m_CellData = AllocateCellData(
+			CellCount * (STACK_ENTRY_SIZE + sizeof( STACK_TYPE_CODE )),
+			m_CellDataCapacity);
+	}
+}
+
+NWScriptStack::StackSegment::~StackSegment(
+	)
+/*++
+
+Routine Description:
+
+	This routine deletes the current stack segment, returning its cell
+	storage to the segment buffer pool.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if (m_CellData != NULL)
+		FreeCellData( m_CellData, m_CellDataCapacity );
+}
+
+size_t
+NWScriptStack::StackSegment::GetMemoryUsage(
+	) const
+/*++
+
+Routine Description:
+
+	This routine estimates the count of bytes of heap memory that the stack
+	segment holds (including the segment itself).
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the approximate memory usage of the segment, in
+	bytes.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	size_t Bytes;
+
+	Bytes  = sizeof( *this );
+	Bytes += m_CellDataCapacity;
+	Bytes += m_Strings.capacity( ) * sizeof( std::string );
+	Bytes += m_EngineStructures.capacity( ) * sizeof( EngineStructurePtr );
+
+	for (StringStack::const_iterator it = m_Strings.begin( );
+	     it != m_Strings.end( );
+	     ++it)
+	{
+		Bytes += it->capacity( );
+	}
+
+	return Bytes;
+}
+
+unsigned char *
+NWScriptStack::StackSegment::AllocateCellData(
+	nwn2dev__in size_t Length,
+	nwn2dev__out size_t & Capacity
+	)
+/*++
+
+Routine Description:
+
+	This routine allocates a cell buffer for a stack segment, reusing a
+	pooled buffer of the appropriate size class if one is available.
+
+Arguments:
+
+	Length - Supplies the minimum length of the buffer, in bytes.
+
+	Capacity - Receives the actual length of the buffer, in bytes.
+
+Return Value:
+
+	The routine returns the buffer.  An std::exception is raised on failure.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	unsigned char * CellData;
+	size_t          SizeClass;
+	size_t          ClassLength;
+
+	SizeClass   = 0;
+	ClassLength = (size_t) 1 << SEGMENT_POOL_MIN_SHIFT;
+
+	while (ClassLength < Length)
+	{
+		ClassLength <<= 1;
+		SizeClass    += 1;
+	}
+
+	CellData = NULL;
+
+	if (SizeClass < SEGMENT_POOL_CLASSES)
+	{
+		AcquireSRWLockExclusive( &g_SegmentPoolLock );
+
+		if (g_SegmentPoolCount[ SizeClass ] != 0)
+		{
+			g_SegmentPoolCount[ SizeClass ] -= 1;
+			CellData = g_SegmentPool[ SizeClass ][ g_SegmentPoolCount[ SizeClass ] ];
+		}
+
+		ReleaseSRWLockExclusive( &g_SegmentPoolLock );
+	}
+
+	if (CellData == NULL)
+		CellData = new unsigned char[ ClassLength ];
+
+	Capacity = ClassLength;
+
+	return CellData;
+}
+
+void
+NWScriptStack::StackSegment::FreeCellData(
+	nwn2dev__in unsigned char * CellData,
+	nwn2dev__in size_t Capacity
+	)
+/*++
+
+Routine Description:
+
+	This routine frees a cell buffer allocated by AllocateCellData, retaining
+	it in the segment buffer pool if there is room.
+
+Arguments:
+
+	CellData - Supplies the buffer to free.
+
+	Capacity - Supplies the length of the buffer, as returned by the
+	           AllocateCellData routine.
+
+Return Value:
+
+	None.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	size_t SizeClass;
+	size_t ClassLength;
+
+	SizeClass   = 0;
+	ClassLength = (size_t) 1 << SEGMENT_POOL_MIN_SHIFT;
+
+	while (ClassLength < Capacity)
+	{
+		ClassLength <<= 1;
+		SizeClass    += 1;
+	}
+
+	if (SizeClass < SEGMENT_POOL_CLASSES)
+	{
+		AcquireSRWLockExclusive( &g_SegmentPoolLock );
+
+		if (g_SegmentPoolCount[ SizeClass ] < SEGMENT_POOL_DEPTH)
+		{
+			g_SegmentPool[ SizeClass ][ g_SegmentPoolCount[ SizeClass ] ] = CellData;
+			g_SegmentPoolCount[ SizeClass ] += 1;
+			CellData                         = NULL;
+		}
+
+		ReleaseSRWLockExclusive( &g_SegmentPoolLock );
+	}
+
+	delete [] CellData;
+}
@@ -24,7 +24,23 @@ Abstract:
 
 class EngineStructure;
 
-typedef swutil::SharedPtr< EngineStructure > EngineStructurePtr;
+typedef swutil::IntrusivePtr< EngineStructure > EngineStructurePtr;
+
+//
+// Engine structures are reference counted intrusively.  By default, the
+// reference count is maintained atomically, as the NWScript JIT engine may
+// release engine structure references from the garbage collector finalizer
+// thread.  A script host that confines all engine structure references to a
+// single thread (and does not use the JIT engine) may define
+// NWSCRIPT_THREAD_CONFINED_ENGINE_STRUCTURES to select a non-atomic reference
+// count.
+//
+
+#ifdef NWSCRIPT_THREAD_CONFINED_ENGINE_STRUCTURES
+typedef swutil::RefCountPolicySingleThreaded EngineStructureRefCountPolicy;
+#else
+typedef swutil::RefCountPolicyAtomic EngineStructureRefCountPolicy;
+#endif
 
 
 
@@ -229,6 +245,14 @@ public:
 
 	typedef std::pair< char *, size_t > NeutralString;
 
+	//
+	// Define a captured range of stack cells (see SaveStackSegments).
+	//
+
+	class StackSegment;
+
+	typedef swutil::IntrusivePtr< StackSegment > StackSegmentPtr;
+
 	//
 	// Create a new script stack.
 	//
@@ -562,6 +586,48 @@ public:
 		nwn2dev__in STACK_POINTER SPSaveOffset = 0
 		);
 
+	//
+	// Save a section of the stack away for later restoration, as per
+	// SaveStack, but capture the saved cells into a pair of immutable stack
+	// segments instead of a new stack.
+	//
+	// The BP-relative cells (i.e. the script's globals) are shared copy on
+	// write: every save of the same cells that is made before any of them is
+	// next modified (or removed from the stack) receives the same segment.
+	// The SP-relative cells are captured into a compact segment of their own.
+	//
+
+	void
+	SaveStackSegments(
+		nwn2dev__in STACK_POINTER BPSaveBytes,
+		nwn2dev__in STACK_POINTER SPSaveBytes,
+		nwn2dev__out StackSegmentPtr & BPSegment,
+		nwn2dev__out StackSegmentPtr & SPSegment,
+		nwn2dev__in STACK_POINTER SPSaveOffset = 0
+		);
+
+	//
+	// Replace the contents of the stack with a stack saved by a call to the
+	// SaveStackSegments routine.  The resulting stack is identical to the
+	// stack that SaveStack would have returned.  The caller's segment
+	// references are consumed (released).
+	//
+
+	void
+	RestoreStackSegments(
+		__inout StackSegmentPtr & BPSegment,
+		__inout StackSegmentPtr & SPSegment
+		);
+
+	//
+	// Return the approximate count of bytes of memory that the stack holds,
+	// for statistics purposes.
+	//
+
+	size_t
+	GetMemoryUsage(
+		) const;
+
 	//
 	// Delete a series of elements on the stack, with a section of the deleted
 	// space that is preserved.  This allows a range of local varialbes to be
@@ -884,6 +950,104 @@ private:
 
 	typedef std::vector< PROGRAM_COUNTER > SavedPCStack;
 
+public:
+
+	//
+	// Define an immutable copy of a range of stack cells, together with the
+	// strings and engine structures that the cells reference.  The handles
+	// in the captured cells are rebased to index the segment's own string
+	// and engine structure arrays.
+	//
+	// The cell values and type codes are stored in a single buffer, which is
+	// recycled through a process-wide pool when the segment is deleted.
+	//
+
+	class StackSegment : public swutil::IntrusiveRefCount< swutil::RefCountPolicyAtomic >
+	{
+
+	public:
+
+		~StackSegment(
+			);
+
+		inline
+		size_t
+		GetCellCount(
+			) const
+		{
+			return m_CellCount;
+		}
+
+		//
+		// Return the approximate count of bytes of memory that the segment
+		// holds, for statistics purposes.
+		//
+
+		size_t
+		GetMemoryUsage(
+			) const;
+
+	private:
+
+		friend class NWScriptStack;
+
+		StackSegment(
+			nwn2dev__in size_t CellCount
+			);
+
+		inline
+		PSTACK_ENTRY
+		GetCells(
+			) const
+		{
+			return (PSTACK_ENTRY) m_CellData;
+		}
+
+		inline
+		STACK_TYPE_CODE *
+		GetTypes(
+			) const
+		{
+			return (STACK_TYPE_CODE *) (m_CellData + m_CellCount * STACK_ENTRY_SIZE);
+		}
+
+		//
+		// Allocate (or free) a cell buffer from the segment buffer pool.
+		//
+
+		static
+		unsigned char *
+		AllocateCellData(
+			nwn2dev__in size_t Length,
+			nwn2dev__out size_t & Capacity
+			);
+
+		static
+		void
+		FreeCellData(
+			nwn2dev__in unsigned char * CellData,
+			nwn2dev__in size_t Capacity
+			);
+
+		StackSegment(
+			nwn2dev__in const StackSegment & Other
+			);
+
+		StackSegment &
+		operator=(
+			nwn2dev__in const StackSegment & Other
+			);
+
+		size_t              m_CellCount;
+		unsigned char     * m_CellData;
+		size_t              m_CellDataCapacity;
+		StringStack         m_Strings;
+		EngineStructStack   m_EngineStructures;
+
+	};
+
+private:
+
 	//
 	// Push an entry onto the stack.
 	//
@@ -972,6 +1136,47 @@ private:
 		nwn2dev__in size_t NumSlots
 		);
 
+	//
+	// Capture a range of the stack into a new stack segment.
+	//
+
+	StackSegmentPtr
+	CaptureStackSegment(
+		nwn2dev__in size_t SrcOffset,
+		nwn2dev__in size_t CellsToCopy
+		) const;
+
+	//
+	// Append the contents of a stack segment to the stack.  If the caller
+	// holds the only reference to the segment, its strings and engine
+	// structures are moved instead of copied.
+	//
+
+	void
+	AppendStackSegment(
+		nwn2dev__in StackSegment * Segment,
+		nwn2dev__in bool SegmentExclusive
+		);
+
+	//
+	// Discard the shared BP segment if a stack cell that it captured is being
+	// modified or removed.  Every routine that alters an existing stack cell
+	// must call this routine first.
+	//
+
+	inline
+	void
+	InvalidateSharedSegment(
+		nwn2dev__in size_t Offset
+		)
+	{
+		if ((m_SharedSegment.get( ) != NULL) &&
+		    (Offset < m_SharedSegmentOffset + m_SharedSegment->GetCellCount( )))
+		{
+			m_SharedSegment.release( );
+		}
+	}
+
 	//
 	// Append a section of the stack into a new stack.
 	//
@@ -1054,6 +1259,15 @@ private:
 
 	NWN::OBJECTID     m_InvalidObjId;
 
+	//
+	// Define the BP segment most recently captured by SaveStackSegments, and
+	// the stack offset of its first cell.  The segment is handed out to later
+	// saves of the same cells until it is invalidated.
+	//
+
+	StackSegmentPtr   m_SharedSegment;
+	size_t            m_SharedSegmentOffset;
+
 };
 
 //
@@ -1061,12 +1275,12 @@ private:
 // defined structures that may be pushed onto the VM stack must be derived.
 //
 
-class EngineStructure
+class EngineStructure : public swutil::IntrusiveRefCount< EngineStructureRefCountPolicy >
 {
 
 public:
 
-	typedef swutil::SharedPtr< EngineStructure >  Ptr;
+	typedef swutil::IntrusivePtr< EngineStructure > Ptr;
 	typedef NWScriptStack::ENGINE_STRUCTURE_NUMBER ENGINE_STRUCTURE_NUMBER;
 
 	inline
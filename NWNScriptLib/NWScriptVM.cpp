@@ -93,6 +93,7 @@ Environment:
   m_DebugLevel( EDL_Errors ),
   m_InstructionsExecuted( 0 ),
   m_RecursionLevel( 0 ),
+  m_SegmentedSavedStates( true ),
   m_CurrentActionObjectSelf( NWN::INVALIDOBJID ),
   m_ActionDefs( ActionDefs ),
   m_ActionCount( ActionCount )
@@ -221,7 +222,7 @@ Environment:
 		ScriptState.Script,
 		ScriptState.ObjectSelf,
 		ScriptState.ObjectInvalid,
-		ScriptState.Stack,
+		ScriptState.GetStack( ),
 		ScriptState.ProgramCounter,
 		NULL,
 		0,
@@ -2802,7 +2803,8 @@ Environment:
 			break;
 
 		case OP_STORE_STATEALL: // Save a script situation state
-			m_SavedState.Stack = VMStack.SaveStack(
+			SaveSituationStack(
+				VMStack,
 				VMStack.GetCurrentBP( ),
 				VMStack.GetCurrentSP( ) - VMStack.GetCurrentBP( ));
 
@@ -3123,9 +3125,7 @@ Environment:
 				SaveBP = STACK_PTR( SaveBP );
 				SaveSP = STACK_PTR( SaveSP );
 
-				m_SavedState.Stack = VMStack.SaveStack(
-					SaveBP,
-					SaveSP);
+				SaveSituationStack( VMStack, SaveBP, SaveSP );
 
 				m_SavedState.Script         = Script;
 				m_SavedState.ProgramCounter = PC + (PROGRAM_COUNTER) TypeOpcode;
@@ -3309,6 +3309,64 @@ main_returned:
 	}
 }
 
+void
+NWScriptVM::SaveSituationStack(
+	nwn2dev__in NWScriptStack & VMStack,
+	nwn2dev__in STACK_POINTER BPSaveBytes,
+	nwn2dev__in STACK_POINTER SPSaveBytes
+	)
+/*++
+
+Routine Description:
+
+	This routine saves the stack of the current script situation into the
+	saved state, for a STORE_STATE or STORE_STATEALL instruction.
+
+	If segmented saved states are enabled, the globals and locals are saved as
+	stack segments.  The globals segment is cached by the VM stack and shared
+	by every saved state that is created before the globals are next modified,
+	so that a script that queues many continuations (e.g. DelayCommand in a
+	loop) copies its globals only once.  Otherwise, a conventional copy of the
+	stack is made.
+
+Arguments:
+
+	VMStack - Supplies the active VM stack.
+
+	BPSaveBytes - Supplies the count of bytes of the globals to save.
+
+	SPSaveBytes - Supplies the count of bytes of the locals to save.
+
+Return Value:
+
+	None.  On failure, an std::exception is raised.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	if (m_SegmentedSavedStates)
+	{
+		VMStack.SaveStackSegments(
+			BPSaveBytes,
+			SPSaveBytes,
+			m_SavedState.GlobalsSegment,
+			m_SavedState.LocalsSegment);
+
+		m_SavedState.Stack.ResetStack( );
+		m_SavedState.Stack.SetInvalidObjId( VMStack.GetInvalidObjId( ) );
+	}
+	else
+	{
+		m_SavedState.Stack = VMStack.SaveStack( BPSaveBytes, SPSaveBytes );
+
+		m_SavedState.GlobalsSegment.release( );
+		m_SavedState.LocalsSegment.release( );
+	}
+}
+
 void
 NWScriptVM::ExitVM(
 	__inout NWScriptStack & VMStack
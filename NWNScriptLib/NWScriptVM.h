@@ -83,17 +83,63 @@ public:
 	// Define the full state of the script VM, used to save and restore
 	// execution (such as for a delayed action).
 	//
+	// A state saved by the VM may hold its stack in segmented form, in which
+	// case Stack is empty and the saved stack is described by GlobalsSegment
+	// (the script's globals, shared with other states saved by the same
+	// script execution) and LocalsSegment (the saved locals).  Copying such a
+	// state copies only the segment references.  Use GetStack to access the
+	// saved stack, which converts the state to the conventional form first.
+	//
 
 	struct VMState
 	{
-		NWScriptStack     Stack;
-		NWScriptReaderPtr Script;
-		PROGRAM_COUNTER   ProgramCounter;
-		NWN::OBJECTID     ObjectSelf;
-		NWN::OBJECTID     ObjectInvalid;
-		bool              Aborted;
+		NWScriptStack                  Stack;
+		NWScriptStack::StackSegmentPtr GlobalsSegment;
+		NWScriptStack::StackSegmentPtr LocalsSegment;
+		NWScriptReaderPtr              Script;
+		PROGRAM_COUNTER                ProgramCounter;
+		NWN::OBJECTID                  ObjectSelf;
+		NWN::OBJECTID                  ObjectInvalid;
+		bool                           Aborted;
 
 		typedef swutil::SharedPtr< VMState > Ptr;
+
+		//
+		// Return the saved stack, first rebuilding it from the saved stack
+		// segments if the state is in segmented form.
+		//
+
+		inline
+		NWScriptStack &
+		GetStack(
+			)
+		{
+			if (LocalsSegment.get( ) != NULL)
+				Stack.RestoreStackSegments( GlobalsSegment, LocalsSegment );
+
+			return Stack;
+		}
+
+		//
+		// Return the approximate count of bytes of memory that the saved
+		// state holds privately, that is, excluding the shared globals
+		// segment.
+		//
+
+		inline
+		size_t
+		GetPrivateMemoryUsage(
+			) const
+		{
+			size_t Bytes;
+
+			Bytes = sizeof( *this ) + Stack.GetMemoryUsage( );
+
+			if (LocalsSegment.get( ) != NULL)
+				Bytes += LocalsSegment->GetMemoryUsage( );
+
+			return Bytes;
+		}
 	};
 
 
@@ -209,12 +255,30 @@ public:
 		nwn2dev__in ExecDebugLevel DebugLevel
 		);
 
+	//
+	// Select whether saved states (script situations) are saved in segmented
+	// form, sharing the script's globals copy on write across all states that
+	// are saved before the globals are next modified.  Segmented saving is
+	// enabled by default.
+	//
+
+	inline
+	void
+	SetSegmentedSavedStates(
+		nwn2dev__in bool Segmented
+		)
+	{
+		m_SegmentedSavedStates = Segmented;
+	}
+
 	//
 	// Retrieve the current saved state (which may be NULL).  This routine may
 	// only be called from an action handler that takes an action argument.
 	//
 	// The caller MUST duplicate the VMState object before passing it to a
-	// call to ExecuteScriptSituation.
+	// call to ExecuteScriptSituation.  Duplicating a saved state that is in
+	// segmented form is inexpensive, as only the segment references are
+	// copied.
 	//
 
 	inline
@@ -387,6 +451,17 @@ private:
 		nwn2dev__in ULONG Flags
 		);
 
+	//
+	// Save the stack of the current script situation into the saved state.
+	//
+
+	void
+	SaveSituationStack(
+		nwn2dev__in NWScriptStack & VMStack,
+		nwn2dev__in STACK_POINTER BPSaveBytes,
+		nwn2dev__in STACK_POINTER SPSaveBytes
+		);
+
 	//
 	// Exit the script VM after execution completed.
 	//
@@ -584,6 +659,12 @@ private:
 
 	VMState                    m_SavedState;
 
+	//
+	// Define whether saved states are saved in segmented form.
+	//
+
+	bool                       m_SegmentedSavedStates;
+
 	//
 	// Define the currently active self object for an action call.  Note that
 	// the self object must be captured before a recursive call is made.
@@ -655,7 +655,259 @@ namespace swutil
 	static_assert( offsetof( SharedPtr< int >, m_Ptr ) == sizeof( void * ) , "compile time assert failed" );
 
 
-	
+
+	//
+	// Reference count policies for intrusively reference counted objects.
+	//
+	// The atomic policy permits references to be created and deleted from any
+	// thread context.  The single threaded policy uses plain arithmetic and
+	// may only be selected for objects whose references are never touched by
+	// more than one thread.
+	//
+
+	struct RefCountPolicyAtomic
+	{
+		static
+		inline
+		LONG_PTR
+		Increment(
+			nwn2dev__in LONG_PTR volatile * RefCount
+			)
+		{
+			return InterlockedIncrementPtr( RefCount );
+		}
+
+		static
+		inline
+		LONG_PTR
+		Decrement(
+			nwn2dev__in LONG_PTR volatile * RefCount
+			)
+		{
+			return InterlockedDecrementPtr( RefCount );
+		}
+	};
+
+	struct RefCountPolicySingleThreaded
+	{
+		static
+		inline
+		LONG_PTR
+		Increment(
+			nwn2dev__in LONG_PTR volatile * RefCount
+			)
+		{
+			return ++*RefCount;
+		}
+
+		static
+		inline
+		LONG_PTR
+		Decrement(
+			nwn2dev__in LONG_PTR volatile * RefCount
+			)
+		{
+			return --*RefCount;
+		}
+	};
+
+	//
+	// Embedded reference count for objects managed by IntrusivePtr.  Unlike
+	// SharedPtr, whose reference count is a separate heap allocation, the
+	// reference count lives in (and is allocated with) the object itself, so
+	// taking ownership of a new object requires no further allocation and a
+	// copy touches only the object's own cache line.
+	//
+	// The reference count starts at zero; the first IntrusivePtr to take the
+	// object takes the first reference.  Copying an object does not copy its
+	// reference count.
+	//
+
+	template< class RefCountPolicy = RefCountPolicyAtomic >
+	class IntrusiveRefCount
+	{
+
+	public:
+
+		inline
+		void
+		AddIntrusiveRef(
+			) const
+		{
+			RefCountPolicy::Increment( &m_IntrusiveRefs );
+		}
+
+		//
+		// Removes a reference, returning true if the reference count has gone
+		// to zero (in which case the caller deletes the object).
+		//
+
+		inline
+		bool
+		ReleaseIntrusiveRef(
+			) const
+		{
+			return RefCountPolicy::Decrement( &m_IntrusiveRefs ) == 0;
+		}
+
+		inline
+		bool
+		IsIntrusiveRefUnique(
+			) const
+		{
+			return m_IntrusiveRefs == 1;
+		}
+
+	protected:
+
+		inline
+		IntrusiveRefCount(
+			)
+		: m_IntrusiveRefs( 0 )
+		{
+		}
+
+		inline
+		IntrusiveRefCount(
+			nwn2dev__in const IntrusiveRefCount & Other
+			)
+		: m_IntrusiveRefs( 0 )
+		{
+			UNREFERENCED_PARAMETER( Other );
+		}
+
+		inline
+		IntrusiveRefCount &
+		operator=(
+			nwn2dev__in const IntrusiveRefCount & Other
+			)
+		{
+			UNREFERENCED_PARAMETER( Other );
+
+			return *this;
+		}
+
+	private:
+
+		mutable LONG_PTR volatile m_IntrusiveRefs;
+
+	};
+
+	//
+	// Intrusively reference counted pointer.  The pointed-to type must derive
+	// from IntrusiveRefCount, and must be allocated via operator new.  The
+	// interface mirrors that of SharedPtr, so that IntrusivePtr may be used
+	// as a drop-in replacement for SharedPtr with such types.
+	//
+	// N.B.  Because the reference count is part of the object, a raw pointer
+	//       to an object that is already owned by an IntrusivePtr may safely
+	//       be wrapped in a further IntrusivePtr (which SharedPtr does not
+	//       permit).
+	//
+
+	template< class T >
+	class IntrusivePtr
+	{
+
+	public:
+
+		IntrusivePtr(
+			nwn2dev__in T *Ptr
+			)
+			: m_Ptr( Ptr )
+		{
+			if (m_Ptr)
+				m_Ptr->AddIntrusiveRef( );
+		}
+
+		IntrusivePtr()
+			: m_Ptr( NULL )
+		{
+		}
+
+		IntrusivePtr( nwn2dev__in const IntrusivePtr & Other )
+			: m_Ptr( Other.m_Ptr )
+		{
+			if (m_Ptr)
+				m_Ptr->AddIntrusiveRef( );
+		}
+
+		~IntrusivePtr()
+		{
+			if ((m_Ptr) && (m_Ptr->ReleaseIntrusiveRef( )))
+				SharedPtrDeleterDelete( m_Ptr );
+		}
+
+		IntrusivePtr& operator=(
+			nwn2dev__in const IntrusivePtr & Other
+			)
+		{
+			T * Prev;
+
+			if (m_Ptr == Other.m_Ptr)
+				return *this;
+
+			//
+			// Reference the new object before dropping the old one, as the
+			// old object may own the last reference to the new object.
+			//
+
+			if (Other.m_Ptr)
+				Other.m_Ptr->AddIntrusiveRef( );
+
+			Prev  = m_Ptr;
+			m_Ptr = Other.m_Ptr;
+
+			if ((Prev) && (Prev->ReleaseIntrusiveRef( )))
+				SharedPtrDeleterDelete( Prev );
+
+			return *this;
+		}
+
+		inline T * get() const { return m_Ptr; }
+		inline T & operator*() const { return *m_Ptr; }
+		inline T * operator->() const { return m_Ptr; }
+		inline bool operator==(nwn2dev__in const T * t) const { return m_Ptr == t; }
+		inline bool operator!=(nwn2dev__in const T * t) const { return m_Ptr != t; }
+
+		inline
+		void
+		release()
+		{
+			T * Prev;
+
+			Prev  = m_Ptr;
+			m_Ptr = NULL;
+
+			if ((Prev) && (Prev->ReleaseIntrusiveRef( )))
+				SharedPtrDeleterDelete( Prev );
+		}
+
+		inline
+		bool
+		unique() const
+		{
+			if (!m_Ptr)
+				return true;
+
+			return m_Ptr->IsIntrusiveRefUnique( );
+		}
+
+		template< typename T2 >
+		inline
+		swutil::IntrusivePtr< T2 >
+		cast_to()
+		{
+			return swutil::IntrusivePtr< T2 >( (T2 *) m_Ptr );
+		}
+
+	private:
+
+		T * m_Ptr;
+	};
+
+
+
 	//
 	// Define automatically managed buffer context.
 	//
@@ -41,14 +41,18 @@ Environment:
 	User mode.
 
 --*/
-: m_ListMutated( false ),
-  m_NextExpiration( 0 ),
-  m_NextExpirationEpoch( 0 ),
-  m_NextExpirationInvalid( true ),
-  m_NextExpirationTimer( NULL )
+: m_WheelTime( GetMonotonicTime( ) ),
+  m_ActiveTimerCount( 0 ),
+  m_NextExpiration( ~0ULL ),
+  m_NextExpirationInvalid( false )
 {
 	InitializeListHead( &m_TimerListHead );
-	InitializeListHead( &m_ActiveTimerListHead );
+
+	for (ULONG Level = 0; Level < WHEEL_LEVELS; Level += 1)
+	{
+		for (ULONG Slot = 0; Slot < WHEEL_SLOTS; Slot += 1)
+			InitializeListHead( &m_TimerWheel[ Level ][ Slot ] );
+	}
 }
 
 TimerManager::~TimerManager(
@@ -75,30 +79,36 @@ Environment:
 --*/
 {
 	//
-	// Forcibly clean up any lingering timers.
+	// Forcibly clean up any lingering timers.  Active timers are moved to the
+	// inactive list as they are canceled, so clear out the timer wheel first.
 	//
 
-	while (!IsListEmpty( &m_TimerListHead ))
+	for (ULONG Level = 0; Level < WHEEL_LEVELS; Level += 1)
 	{
-		PLIST_ENTRY         ListEntry;
-		TimerRegistration * Timer;
+		for (ULONG Slot = 0; Slot < WHEEL_SLOTS; Slot += 1)
+		{
+			PLIST_ENTRY SlotHead = &m_TimerWheel[ Level ][ Slot ];
 
-		ListEntry = m_TimerListHead.Flink;
+			while (!IsListEmpty( SlotHead ))
+			{
+				TimerRegistration * Timer;
 
-		Timer = CONTAINING_RECORD(
-			ListEntry,
-			TimerRegistration,
-			m_TimerLinks);
+				Timer = CONTAINING_RECORD(
+					SlotHead->Flink,
+					TimerRegistration,
+					m_TimerLinks);
 
-		CancelTimer( Timer );
+				CancelTimer( Timer );
+			}
+		}
 	}
 
-	while (!IsListEmpty( &m_ActiveTimerListHead ))
+	while (!IsListEmpty( &m_TimerListHead ))
 	{
 		PLIST_ENTRY         ListEntry;
 		TimerRegistration * Timer;
 
-		ListEntry = m_ActiveTimerListHead.Flink;
+		ListEntry = m_TimerListHead.Flink;
 
 		Timer = CONTAINING_RECORD(
 			ListEntry,
@@ -188,6 +198,12 @@ Environment:
 
 --*/
 {
+	//
+	// Deactivate the timer first so that it is accounted for as having left
+	// the timer wheel.
+	//
+
+	Timer->Deactivate( );
 	Timer->Cancel( );
 }
 
@@ -221,131 +237,85 @@ Environment:
 
 --*/
 {
-	PLIST_ENTRY         ListEntry;
-	bool                Rescan;
-	ULONG               NextExpiration;
-	ULONG               Now;
-	TimerRegistration * NextExpirationTimer;
+	ULONGLONG Now;
+	ULONGLONG Remaining;
 
-	Now = GetTickCount( );
+	Now = GetMonotonicTime( );
 
 	//
 	// First, check if our cached next expiration time is still valid.  If so,
 	// and we have not yet reached the next expiration time, then we do not
-	// need to run the timer list down.
+	// need to touch the timer wheel.
 	//
 
 	if (!m_NextExpirationInvalid)
 	{
-		if (m_NextExpiration == INFINITE)
+		if (m_NextExpiration == ~0ULL)
 			return INFINITE;
 
+		if (Now < m_NextExpiration)
+		{
+			Remaining = m_NextExpiration - Now;
+
+			return (Remaining >= INFINITE) ? INFINITE - 1 : (ULONG) Remaining;
+		}
+
 		//
-		// If we have not yet reached the expiration time, then just return the
-		// cached time.
+		// Nothing in the wheel requires attention before the cached time, so
+		// skip the wheel straight to it rather than stepping through each
+		// idle millisecond.
 		//
 
-		if ((Now - m_NextExpirationEpoch) < m_NextExpiration)
-			return m_NextExpiration - (Now - m_NextExpirationEpoch);
+		if (m_NextExpiration > m_WheelTime)
+			m_WheelTime = m_NextExpiration;
 	}
 
 	//
-	// Loop dispatching timers.  Normally, we take only one pass through the
-	// timer list, but if the user adds or deletes a timer while we are in the
-	// dispatch cycle, we will start over from the beginning.  This is a rare
-	// case and not something we optimize for, for simplicity.
+	// Dispatch all expired timers.  The cache is rebuilt afterwards, as timer
+	// callbacks may reschedule or cancel any timer.
 	//
 
-	do
-	{
-		m_ListMutated       = false;
-		Rescan              = false;
-		NextExpiration      = INFINITE;
-		NextExpirationTimer = NULL;
-		Now                 = GetTickCount( );
-
-		for (ListEntry =  m_ActiveTimerListHead.Flink;
-		     ListEntry != &m_ActiveTimerListHead;
-		     ListEntry = ListEntry->Flink)
-		{
-			TimerRegistration * Timer;
-			ULONG               TimerExpiration;
+	m_NextExpirationInvalid = true;
 
-			Timer = CONTAINING_RECORD(
-				ListEntry,
-				TimerRegistration,
-				m_TimerLinks);
+	AdvanceTimerWheel( Now );
 
-			if (!Timer->IsActive( ))
-				continue;
-
-			//
-			// Dispatch the timer.
-			//
-
-			TimerExpiration = Timer->Dispatch( Now );
-
-			if (TimerExpiration < NextExpiration)
-			{
-				NextExpiration      = TimerExpiration;
-				NextExpirationTimer = Timer;
-			}
-
-			//
-			// If the user added or removed a timer, which should be very rare
-			// during timer dispatching, then start over from the beginning.
-			//
+	m_NextExpiration        = ComputeNextExpiration( );
+	m_NextExpirationInvalid = false;
 
-			if (m_ListMutated)
-			{
-				m_ListMutated = false;
-				Rescan        = true;
-				break;
-			}
-		}
-	} while (Rescan == true);
+	if (m_NextExpiration == ~0ULL)
+		return INFINITE;
 
 	//
-	// Cache the next time until we need to run down expirations and return to
-	// the caller, having completed our dispatch run.
+	// The wheel has been advanced past the current time, so the next
+	// expiration is always in the future here.
 	//
 
-	m_NextExpiration        = NextExpiration;
-	m_NextExpirationEpoch   = Now;
-	m_NextExpirationInvalid = false;
-	m_NextExpirationTimer   = NextExpirationTimer;
+	Remaining = m_NextExpiration - Now;
 
-	return m_NextExpiration;
+	return (Remaining >= INFINITE) ? INFINITE - 1 : (ULONG) Remaining;
 }
 
 void
 TimerManager::InvalidateTimerExpiration(
-	nwn2dev__in TimerRegistration * Timer,
-	nwn2dev__in ULONG Period,
-	nwn2dev__in ULONG Epoch
+	nwn2dev__in TimerRegistration * Timer
 	)
 /*++
 
 Routine Description:
 
 	This internal only routine is called by timer registration objects when
-	they invalidate their expiration intervals.  It invalidates the cache of
-	the next timer to expire, but only if necessary.
+	they invalidate their expiration intervals.  An active timer is moved to
+	the timer wheel slot for its new expiration time.
 
-	A simple cache is used:  We store the timer object closest to expiration,
-	and when it will expire.  If the timer is the timer object closest to
-	expiration then we must invalidate the cache.  Additionally, if the timer
-	object expires sooner than the current expiration, then the cache is
-	updated accordingly.
+	The next expiration cache is lowered if the timer is now the next timer
+	to require attention.  It is never raised here; should the timer have
+	been the next to expire, the next rundown simply finds nothing to do and
+	recalculates the cache.
 
 Arguments:
 
 	Timer - Supplies the timer object that has changed its timer expiration.
 
-	Period - Supplies the period of the timer.
-
-	Epoch - Supplies the tick count from which the period is relative to.
-
 Return Value:
 
 	None.
@@ -356,78 +326,19 @@ Environment:
 
 --*/
 {
-	ULONG NextTimeLeft;
-
-	if (m_NextExpirationInvalid)
-		return;
-
-	//
-	// If we are transitioning from no timers to an active timer then we must
-	// throw away the cache.
-	//
+	ULONGLONG EventTime;
 
-	if (m_NextExpiration == INFINITE)
-	{
-		m_NextExpirationInvalid = true;
+	if ((!Timer->IsActive( )) || (Timer->IsCanceled( )))
 		return;
-	}
 
-	//
-	// If the next expiration is already immediate, then there is nothing to
-	// do.
-	//
+	Timer->UnlinkTimer( );
 
-	if ((Epoch - m_NextExpirationEpoch) >= m_NextExpiration)
-	{
-		m_NextExpirationInvalid = true;
-		return;
-	}
+	Timer->m_TimerExpiration = Timer->m_TimerEpoch + Timer->m_TimerPeriod;
 
-	NextTimeLeft = m_NextExpiration - (Epoch - m_NextExpirationEpoch);
+	EventTime = ScheduleTimer( Timer );
 
-	if (m_NextExpirationTimer == Timer)
-	{
-		if ((NextTimeLeft < Period)          ||
-		    (!Timer->IsActive( ))            ||
-		    (Timer->IsCanceled( )))
-		{
-			//
-			// We are extending the expiration of the next timer further into
-			// the future.  Our cache is only one level deep so we must
-			// recalculate and re-run the timer list next time.
-			//
-
-			m_NextExpirationInvalid = true;
-			return;
-		}
-	}
-	else
-	{
-		if ((NextTimeLeft > Period) &&
-		    (Timer->IsActive( )))
-		{
-			//
-			// We are changing the next expiration timer to this new timer.  It
-			// is not immediately expiring.
-			//
-
-			m_NextExpiration      = Period;
-			m_NextExpirationEpoch = Epoch;
-			m_NextExpirationTimer = Timer;
-		}
-		else
-		{
-			//
-			// This timer expires after the next expiration timer, and it is
-			// not the next expiration timer.  The cache can stay valid.
-			//
-			// Or, this timer has been disabled or canceled, but it was not the
-			// next expiration timer, so the cache can stay valid.
-			//
-
-			return;
-		}
-	}
+	if ((!m_NextExpirationInvalid) && (EventTime < m_NextExpiration))
+		m_NextExpiration = EventTime;
 }
 
 void
@@ -438,8 +349,15 @@ TimerManager::OnTimerRegistrationActivate(
 
 Routine Description:
 
-	This routine handles a timer being activated.  The timer is moved to the
-	active timer list.
+	This routine handles a timer being activated.  The timer is removed from
+	the inactive timer list; it is then placed into the timer wheel by
+	InvalidateTimerExpiration.
+
+	The wheel time is not advanced while no timers are active, so when the
+	first timer is activated after an idle period, the wheel time is brought
+	up to the current time first.  Otherwise, the timer would be placed
+	relative to a stale wheel time, and the next rundown would have to step
+	through every idle millisecond before reaching it.
 
 Arguments:
 
@@ -455,10 +373,19 @@ Environment:
 
 --*/
 {
-	RemoveEntryList( &Timer->m_TimerLinks );
-	InsertTailList( &m_ActiveTimerListHead, &Timer->m_TimerLinks );
+	ULONGLONG Now;
+
+	Timer->UnlinkTimer( );
+
+	if (m_ActiveTimerCount == 0)
+	{
+		Now = GetMonotonicTime( );
+
+		if (Now > m_WheelTime)
+			m_WheelTime = Now;
+	}
 
-	m_ListMutated = true;
+	m_ActiveTimerCount += 1;
 }
 
 void
@@ -469,8 +396,8 @@ TimerManager::OnTimerRegistrationInactivate(
 
 Routine Description:
 
-	This routine handles a timer being inactivated.  The timer is moved to the
-	inactive timer list.
+	This routine handles a timer being inactivated.  The timer is moved from
+	the timer wheel to the inactive timer list.
 
 Arguments:
 
@@ -486,10 +413,294 @@ Environment:
 
 --*/
 {
-	RemoveEntryList( &Timer->m_TimerLinks );
+	Timer->UnlinkTimer( );
 	InsertTailList( &m_TimerListHead, &Timer->m_TimerLinks );
 
-	m_ListMutated = true;
+	m_ActiveTimerCount -= 1;
+}
+
+ULONGLONG
+TimerManager::ScheduleTimer(
+	nwn2dev__in TimerRegistration * Timer
+	)
+/*++
+
+Routine Description:
+
+	This routine links an active, unlinked timer into the timer wheel.  The
+	timer is placed in the lowest wheel level whose span covers the time left
+	until the timer expires.
+
+	A timer that is already due is placed in the slot for the next wheel time
+	to be processed.  A timer that expires beyond the span of the highest
+	level (which can only occur when the timer epoch is ahead of the wheel
+	time) is placed in the last slot of the highest level, and is placed
+	again when that slot is cascaded.
+
+Arguments:
+
+	Timer - Supplies the timer to schedule.  The timer expiration time has
+	        already been set.
+
+Return Value:
+
+	The routine returns the time at which the timer's wheel slot requires
+	attention:  its expiration time for a level zero slot, else the time at
+	which the slot is cascaded down the wheel.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ULONGLONG Expiration;
+	ULONGLONG Delta;
+	ULONG     Level;
+	ULONG     Shift;
+
+	Expiration = Timer->m_TimerExpiration;
+
+	if (Expiration < m_WheelTime)
+		Expiration = m_WheelTime;
+
+	Delta = Expiration - m_WheelTime;
+
+	if (Delta >= (1ULL << (WHEEL_LEVELS * WHEEL_SLOT_BITS)))
+	{
+		Delta      = (1ULL << (WHEEL_LEVELS * WHEEL_SLOT_BITS)) - 1;
+		Expiration = m_WheelTime + Delta;
+	}
+
+	for (Level = 0; Level < WHEEL_LEVELS - 1; Level += 1)
+	{
+		if (Delta < (1ULL << ((Level + 1) * WHEEL_SLOT_BITS)))
+			break;
+	}
+
+	Shift = Level * WHEEL_SLOT_BITS;
+
+	InsertTailList(
+		&m_TimerWheel[ Level ][ (Expiration >> Shift) & WHEEL_SLOT_MASK ],
+		&Timer->m_TimerLinks);
+
+	return (Expiration >> Shift) << Shift;
+}
+
+void
+TimerManager::AdvanceTimerWheel(
+	nwn2dev__in ULONGLONG Now
+	)
+/*++
+
+Routine Description:
+
+	This routine advances the timer wheel, one millisecond at a time, up to
+	and including the current time.  At each wheel time, any higher level slot
+	whose span begins at that time is cascaded down into the lower levels, and
+	then every timer in the level zero slot for that time is dispatched.
+
+	A dispatched timer that remains active is rescheduled one period from the
+	dispatch time, unless its callback already rescheduled it.  Timer
+	callbacks may freely create, reschedule, deactivate or cancel timers.
+
+Arguments:
+
+	Now - Supplies the current time.
+
+Return Value:
+
+	None.  Should a timer callback raise an std::exception, the exception is
+	propagated with the wheel left consistent.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ULONGLONG           Tick;
+	ULONG               Shift;
+	PLIST_ENTRY         SlotHead;
+	TimerRegistration * Timer;
+
+	while (m_WheelTime <= Now)
+	{
+		//
+		// With no active timers, there is nothing to step through.
+		//
+
+		if (m_ActiveTimerCount == 0)
+		{
+			m_WheelTime = Now + 1;
+			break;
+		}
+
+		Tick = m_WheelTime;
+
+		//
+		// Cascade each higher level slot whose span begins now.  The timers
+		// within it all expire within the span, so they land in lower levels
+		// (or, for a due timer, in the level zero slot that is processed
+		// next).
+		//
+
+		for (ULONG Level = WHEEL_LEVELS - 1; Level != 0; Level -= 1)
+		{
+			Shift = Level * WHEEL_SLOT_BITS;
+
+			if ((Tick & ((1ULL << Shift) - 1)) != 0)
+				continue;
+
+			SlotHead = &m_TimerWheel[ Level ][ (Tick >> Shift) & WHEEL_SLOT_MASK ];
+
+			while (!IsListEmpty( SlotHead ))
+			{
+				Timer = CONTAINING_RECORD(
+					SlotHead->Flink,
+					TimerRegistration,
+					m_TimerLinks);
+
+				Timer->UnlinkTimer( );
+				ScheduleTimer( Timer );
+			}
+		}
+
+		//
+		// Dispatch each timer that expires now.  A rescheduled timer always
+		// expires after the current wheel time, so it never lands back in
+		// this slot.
+		//
+
+		SlotHead = &m_TimerWheel[ 0 ][ Tick & WHEEL_SLOT_MASK ];
+
+		while (!IsListEmpty( SlotHead ))
+		{
+			Timer = CONTAINING_RECORD(
+				SlotHead->Flink,
+				TimerRegistration,
+				m_TimerLinks);
+
+			Timer->UnlinkTimer( );
+
+			try
+			{
+				//
+				// N.B.  Returning false indicates that the user has deleted
+				//       the timer registration object.
+				//
+
+				if (!Timer->Dispatch( Now ))
+					continue;
+			}
+			catch (...)
+			{
+				if ((Timer->IsActive( )) &&
+				    (!Timer->IsCanceled( )) &&
+				    (!Timer->IsLinked( )))
+				{
+					Timer->m_TimerExpiration = Timer->m_TimerEpoch + Timer->m_TimerPeriod;
+					ScheduleTimer( Timer );
+				}
+
+				throw;
+			}
+
+			if ((Timer->IsActive( )) &&
+			    (!Timer->IsCanceled( )) &&
+			    (!Timer->IsLinked( )))
+			{
+				Timer->m_TimerExpiration = Timer->m_TimerEpoch + Timer->m_TimerPeriod;
+				ScheduleTimer( Timer );
+			}
+		}
+
+		//
+		// A timer activated by a callback once no timers were active may have
+		// already brought the wheel time forward.
+		//
+
+		if (m_WheelTime <= Tick)
+			m_WheelTime = Tick + 1;
+	}
+}
+
+ULONGLONG
+TimerManager::ComputeNextExpiration(
+	) const
+/*++
+
+Routine Description:
+
+	This routine scans the timer wheel for the earliest time at which it
+	requires attention:  the first occupied level zero slot, or the start of
+	the span of the first occupied slot of a higher level (at which time the
+	slot is cascaded and the wheel is scanned again).
+
+	At most one revolution of each level is scanned, so the cost does not
+	depend on the count of active timers.
+
+Arguments:
+
+	None.
+
+Return Value:
+
+	The routine returns the next time at which the timer wheel requires
+	attention, else ~0 if there are no active timers.
+
+Environment:
+
+	User mode.
+
+--*/
+{
+	ULONGLONG Next;
+	ULONGLONG Base;
+	ULONGLONG EventTime;
+	ULONG     Shift;
+
+	if (m_ActiveTimerCount == 0)
+		return ~0ULL;
+
+	Next = ~0ULL;
+
+	for (ULONG Offset = 0; Offset < WHEEL_SLOTS; Offset += 1)
+	{
+		if (!IsListEmpty( &m_TimerWheel[ 0 ][ (m_WheelTime + Offset) & WHEEL_SLOT_MASK ] ))
+		{
+			Next = m_WheelTime + Offset;
+			break;
+		}
+	}
+
+	//
+	// An occupied higher level slot always begins at or after the current
+	// wheel time, and within one revolution of its level, so scan from the
+	// first slot that begins at or after the current wheel time.
+	//
+
+	for (ULONG Level = 1; Level < WHEEL_LEVELS; Level += 1)
+	{
+		Shift = Level * WHEEL_SLOT_BITS;
+		Base  = (m_WheelTime + ((1ULL << Shift) - 1)) >> Shift;
+
+		for (ULONG Offset = 0; Offset < WHEEL_SLOTS; Offset += 1)
+		{
+			EventTime = (Base + Offset) << Shift;
+
+			if (EventTime >= Next)
+				break;
+
+			if (!IsListEmpty( &m_TimerWheel[ Level ][ (Base + Offset) & WHEEL_SLOT_MASK ] ))
+			{
+				Next = EventTime;
+				break;
+			}
+		}
+	}
+
+	return Next;
 }
 
 TimerRegistration::TimerRegistration(
@@ -525,10 +736,12 @@ Environment:
 : m_TimerManager( &TimerMgr ),
   m_TimerPeriod( INFINITE ),
   m_TimerEpoch( 0 ),
+  m_TimerExpiration( 0 ),
   m_TimerCallback( TimerCompletionRoutine ),
   m_TimerContext1( TimerContext1 ),
   m_TimerContext2( TimerContext2 )
 {
+	InitializeListHead( &m_TimerLinks );
 }
 
 TimerRegistration::~TimerRegistration(
@@ -570,27 +783,26 @@ Environment:
 	Cancel( );
 }
 
-ULONG
+bool
 TimerRegistration::Dispatch(
-	nwn2dev__in ULONG Now
+	nwn2dev__in ULONGLONG Now
 	)
 /*++
 
 Routine Description:
 
-	This routine dispatches the timer, checking for timer expiration.  Should
-	the timer have expired, the timer epoch is reset and the user callback is
-	invoked.
+	This routine dispatches an expired timer.  The timer epoch is reset and
+	the user callback is invoked.
 
 Arguments:
 
-	Now - Supplies the timer expiration epoch (i.e. current tick count).
+	Now - Supplies the timer expiration epoch (i.e. current time).
 
 Return Value:
 
-	The routine returns the count of milliseconds until the timer next expires.
-
-	If the routine returns INFINITE, then the timer has been deactivated.
+	The routine returns false if the user deleted the timer registration
+	object in the timer callback, in which case the timer must not be touched
+	again, else true.
 
 Environment:
 
@@ -599,33 +811,12 @@ Environment:
 --*/
 {
 	//
-	// If we have not expired, return the delta to the expiration time to the
-	// timer dispatcher.
-	//
-
-	if ((Now - m_TimerEpoch) < m_TimerPeriod)
-		return m_TimerPeriod - (Now - m_TimerEpoch);
-
-	//
-	// Otherwise, run user's timer callback after resetting the timer epoch.
+	// Run user's timer callback after resetting the timer epoch.  The timer
+	// dispatcher reschedules the timer (if it is still active) once the
+	// callback returns.
 	//
 
 	m_TimerEpoch = Now;
 
-	//
-	// N.B.  Returning false indicates that the user has deleted the timer
-	//       registration object and so we must return immediately in that
-	//       case.
-
-	if (!m_TimerCallback( m_TimerContext1, m_TimerContext2, this ))
-		return INFINITE;
-
-	//
-	// Return the new next time until expiration.
-	//
-
-	if ((!IsActive( )) || (IsCanceled( )))
-		return INFINITE;
-	else
-		return m_TimerPeriod;
+	return m_TimerCallback( m_TimerContext1, m_TimerContext2, this );
 }
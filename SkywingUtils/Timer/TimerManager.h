@@ -12,6 +12,11 @@ Abstract:
 	timers to fire periodically.  The TimerManager is designed for single
 	threaded operation in an I/O dispatch loop.
 
+	Active timers are kept in a hierarchical timing wheel, so that registering,
+	rearming and canceling a timer take constant time, and running down timers
+	only visits the timers that have expired.  Timer times are kept as 64-bit
+	millisecond counts, which do not wrap.
+
 --*/
 
 #ifndef _SOURCE_PROGRAMS_SKYWINGUTILS_TIMER_TIMERMANAGER_H
@@ -107,14 +112,12 @@ public:
 
 	//
 	// This internal only routine is called by a TimerRegistration when its
-	// timer period changes.  It invalidates the next expiration cache.
+	// timer period changes.  It reschedules the timer in the timer wheel.
 	//
 
 	void
 	InvalidateTimerExpiration(
-		nwn2dev__in TimerRegistration * Timer,
-		nwn2dev__in ULONG Period,
-		nwn2dev__in ULONG Epoch
+		nwn2dev__in TimerRegistration * Timer
 		);
 
 	//
@@ -137,43 +140,101 @@ public:
 		nwn2dev__in TimerRegistration * Timer
 		);
 
+	//
+	// Return the current time, as a count of milliseconds that does not wrap.
+	//
+
+	inline
+	static
+	ULONGLONG
+	GetMonotonicTime(
+		)
+	{
+		return GetTickCount64( );
+	}
+
 private:
 
 	//
-	// Define the inactive timer list, to which all TimerRegistration objects
-	// that are inactive are linked.
+	// Define the geometry of the timer wheel.  Each level has 256 slots; a
+	// slot in level zero spans one millisecond, and a slot in each further
+	// level spans a whole revolution of the level below it.  Four levels
+	// cover any timer period.
 	//
 
-	LIST_ENTRY           m_TimerListHead;
+	enum
+	{
+		WHEEL_SLOT_BITS = 8,
+		WHEEL_SLOTS     = 1 << WHEEL_SLOT_BITS,
+		WHEEL_SLOT_MASK = WHEEL_SLOTS - 1,
+		WHEEL_LEVELS    = 4,
+
+		LAST_WHEEL_CONSTANT
+	};
 
 	//
-	// Define the active timer list, to which all active TimerRegistration
-	// objects are linked.
+	// Link an active timer into the timer wheel slot for its expiration time.
+	// The routine returns the time at which the slot next requires attention
+	// (when it fires, or is cascaded down into a lower level).
 	//
 
-	LIST_ENTRY           m_ActiveTimerListHead;
+	ULONGLONG
+	ScheduleTimer(
+		nwn2dev__in TimerRegistration * Timer
+		);
 
 	//
-	// Define the mutated flag used to keep track of whether a timer was added
-	// or deleted during the dispatch cycle.
+	// Advance the timer wheel up to and including a time, cascading timers
+	// down the wheel levels and dispatching each timer that expires.
 	//
 
-	bool                 m_ListMutated;
+	void
+	AdvanceTimerWheel(
+		nwn2dev__in ULONGLONG Now
+		);
 
 	//
-	// Define the cached next timer expiration time.  This allows us to avoid
-	// re-running the list down each time an I/O completes unless we are sure
-	// that at least one timer will have expired.
+	// Return the earliest time at which the timer wheel requires attention,
+	// else ~0 if there are no active timers.
+	//
+
+	ULONGLONG
+	ComputeNextExpiration(
+		) const;
+
 	//
-	// m_NextExpiration represents a count of millisecond from
-	// m_NextExpirationEpoch at which the next timer in line to expire shall
-	// require dispatching.
+	// Define the inactive timer list, to which all TimerRegistration objects
+	// that are inactive are linked.
 	//
 
-	ULONG               m_NextExpiration;
-	ULONG               m_NextExpirationEpoch;
+	LIST_ENTRY           m_TimerListHead;
+
+	//
+	// Define the timer wheel, to whose slots all active TimerRegistration
+	// objects are linked.  A level zero slot holds timers that expire at a
+	// single millisecond within the next revolution; a slot in a higher level
+	// holds timers that are cascaded down once the wheel time reaches the
+	// start of the slot's span.
+	//
+	// m_WheelTime is the next millisecond that the wheel has yet to process.
+	//
+
+	LIST_ENTRY           m_TimerWheel[ WHEEL_LEVELS ][ WHEEL_SLOTS ];
+	ULONGLONG            m_WheelTime;
+	ULONG                m_ActiveTimerCount;
+
+	//
+	// Define the cached next timer wheel event time.  This allows us to avoid
+	// scanning the wheel each time an I/O completes unless we are sure that
+	// at least one timer will have expired.
+	//
+	// The cache is a lower bound:  it is lowered as timers are scheduled, but
+	// not raised as timers are canceled, in which case the next rundown simply
+	// finds nothing to do.
+	//
+
+	ULONGLONG           m_NextExpiration;
 	bool                m_NextExpirationInvalid;
-	TimerRegistration * m_NextExpirationTimer;
 
 };
 
@@ -250,7 +311,7 @@ public:
 
 		WasActive = (IsActive( ));
 
-		m_TimerEpoch  = GetTickCount( );
+		m_TimerEpoch  = TimerManager::GetMonotonicTime( );
 		m_TimerPeriod = Period;
 
 		if (WasActive != IsActive( ))
@@ -261,10 +322,7 @@ public:
 				m_TimerManager->OnTimerRegistrationActivate( this );
 		}
 
-		m_TimerManager->InvalidateTimerExpiration(
-			this,
-			Period,
-			m_TimerEpoch);
+		m_TimerManager->InvalidateTimerExpiration( this );
 	}
 
 	//
@@ -282,12 +340,12 @@ public:
 	StopTimer(
 		)
 	{
-		ULONG Now;
+		ULONGLONG Now;
 
 		if (!IsActive( ))
 			return INFINITE;
 
-		Now = GetTickCount( );
+		Now = TimerManager::GetMonotonicTime( );
 
 		//
 		// If we have not expired, return the delta to the expiration time to
@@ -296,7 +354,7 @@ public:
 
 		if ((Now - m_TimerEpoch) < m_TimerPeriod)
 		{
-			ULONG Remaining = m_TimerPeriod - (Now - m_TimerEpoch);
+			ULONG Remaining = m_TimerPeriod - (ULONG) (Now - m_TimerEpoch);
 
 			SetPeriod( 0 );
 
@@ -333,14 +391,13 @@ public:
 private:
 
 	//
-	// Attempt to dispatch an active timer.  The routine returns the count of
-	// milliseconds until the next dispatch is required, else INFINITE if the
-	// timer was deactivated.
+	// Dispatch an expired timer.  The routine returns false if the timer
+	// registration was deleted by the timer callback.
 	//
 
-	ULONG
+	bool
 	Dispatch(
-		nwn2dev__in ULONG Now
+		nwn2dev__in ULONGLONG Now
 		);
 
 	//
@@ -360,7 +417,7 @@ private:
 		// state.
 		//
 
-		RemoveEntryList( &m_TimerLinks );
+		UnlinkTimer( );
 
 		//
 		// Mark us as canceled by setting the timer period to INFINITE.
@@ -388,6 +445,33 @@ private:
 		m_TimerPeriod = 0;
 	}
 
+	//
+	// Unlink the timer from whichever timer manager list (or timer wheel
+	// slot) it is on.  The links are left self-referencing, so that an
+	// unlinked timer may be told apart from a linked one.
+	//
+
+	inline
+	void
+	UnlinkTimer(
+		)
+	{
+		RemoveEntryList( &m_TimerLinks );
+		InitializeListHead( &m_TimerLinks );
+	}
+
+	//
+	// Check if the timer is linked to a timer manager list.
+	//
+
+	inline
+	bool
+	IsLinked(
+		) const
+	{
+		return (m_TimerLinks.Flink != &m_TimerLinks);
+	}
+
 	//
 	// Check if the timer is canceled.
 	//
@@ -423,11 +507,18 @@ private:
 	ULONG                                 m_TimerPeriod;
 
 	//
-	// Define the tick count epoch at which the timer last issued a timer cycle
-	// or which the timer cycle otherwise begins from.
+	// Define the time at which the timer last issued a timer cycle or which
+	// the timer cycle otherwise begins from.
+	//
+
+	ULONGLONG                             m_TimerEpoch;
+
+	//
+	// Define the time at which the timer next expires.  This is maintained by
+	// the timer manager while the timer is active.
 	//
 
-	ULONG                                 m_TimerEpoch;
+	ULONGLONG                             m_TimerExpiration;
 
 	//
 	// Define the timer callback procedure to be invoked on timer completion.
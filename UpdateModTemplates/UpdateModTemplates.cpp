@@ -573,6 +573,11 @@ Environment:
 		"                          -objecttype <first object type to match>\n"
 		"                          [-objecttype <additional object type N...>]\n"
 		"                          [-excludefield <exclude field 1...>]\n"
+		"                          [-iostats] [-iotrace <trace file>]\n"
+		"\n"
+		"The -iostats option prints resource I/O statistics once processing is\n"
+		"complete, and the -iotrace option writes a Chrome trace event log of\n"
+		"individual resource loads.\n"
 		);
 
 	printf( "\n" );
@@ -768,12 +773,16 @@ Environment:
 	StringVec       ExcludeFields;
 	unsigned long   ObjectTypeMask;
 	bool            Erf16;
+	bool            IoStats;
+	const char    * IoTraceFile;
 
 	ModuleName     = NULL;
 	NWN2Home       = NULL;
 	InstallDir     = NULL;
 	ObjectTypeMask = 0;
 	Erf16          = false;
+	IoStats        = false;
+	IoTraceFile    = NULL;
 
 	//
 	// Parse out the command line arguments.
@@ -793,6 +802,10 @@ Environment:
 			ExcludeFields.push_back( argv[ ++i ] );
 		else if ((!_stricmp( argv[ i ], "-nwn1")))
 			Erf16 = true;
+		else if ((!_stricmp( argv[ i ], "-iostats" )))
+			IoStats = true;
+		else if ((!_stricmp( argv[ i ], "-iotrace" )) && (i + 1 < argc))
+			IoTraceFile = argv[ ++i ];
 		else if ((!_stricmp( argv[ i ], "-objecttype" )) && (i + 1 < argc))
 		{
 			bool FoundIt;
@@ -870,6 +883,12 @@ Environment:
 	PrintfTextOut   TextOut;
 	ResourceManager ResMan( &TextOut );
 
+	if ((IoStats) || (IoTraceFile != NULL))
+	{
+		ResMan.GetStatistics( ).SetEnabled( true );
+		ResMan.GetStatistics( ).SetTraceEnabled( IoTraceFile != NULL );
+	}
+
 	try
 	{
 		//
@@ -932,6 +951,34 @@ Environment:
 		TextOut.WriteText( "ERROR: Exception '%s'.\n", e.what( ) );
 	}
 
+	//
+	// Report resource I/O statistics if they were collected.
+	//
+
+	if (IoStats)
+	{
+		TextOut.WriteText( "Resource I/O statistics:\n" );
+		ResMan.GetStatistics( ).WriteReport( &TextOut );
+	}
+
+	if (IoTraceFile != NULL)
+	{
+		try
+		{
+			ResMan.GetStatistics( ).WriteChromeTrace( IoTraceFile );
+
+			TextOut.WriteText(
+				"Wrote resource I/O trace to %s.\n",
+				IoTraceFile);
+		}
+		catch (std::exception &e)
+		{
+			TextOut.WriteText(
+				"ERROR: Failed to write resource I/O trace: '%s'.\n",
+				e.what( ));
+		}
+	}
+
 	//
 	// All done.
 	//